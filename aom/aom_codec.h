@@ -480,6 +480,34 @@ aom_codec_err_t aom_codec_control_(aom_codec_ctx_t *ctx, int ctrl_id, ...);
 
 #endif
 
+/*!\brief Shared thread pool
+ *
+ * An opaque pool of threads that any number of encoder and decoder instances
+ * run their worker threads on, instead of each instance starting threads of
+ * its own. The pool shares its threads out fairly between the instances that
+ * have work waiting, and caps the number of threads they use besides the
+ * threads calling into the codec. An instance is given a pool with the
+ * AV1E_SET_THREAD_POOL or AV1_SET_THREAD_POOL control before its first frame.
+ */
+typedef struct aom_thread_pool aom_thread_pool_t;
+
+/*!\brief Create a shared thread pool
+ *
+ * \param[in] max_threads  Number of threads in the pool, at least 1.
+ *
+ * \retval NULL
+ *     The pool could not be created.
+ */
+aom_thread_pool_t *aom_thread_pool_create(unsigned int max_threads);
+
+/*!\brief Destroy a shared thread pool
+ *
+ * Every codec instance using the pool must have been destroyed first.
+ *
+ * \param[in] pool  Pool to destroy, which may be NULL.
+ */
+void aom_thread_pool_destroy(aom_thread_pool_t *pool);
+
 /*!@} - end defgroup codec*/
 #ifdef __cplusplus
 }
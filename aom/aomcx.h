@@ -560,6 +560,78 @@ enum aome_enc_control_id {
    * Supported in codecs: AV1
    */
   AV1E_SET_SUPERBLOCK_SIZE,
+
+  /*!\brief Codec control function to enable row based multi-threading.
+   *
+   * When enabled, the superblock rows of each tile are encoded as a
+   * wavefront, so that more threads than tile columns can be used. The
+   * output does not depend on the number of threads.
+   *
+   * By default, this feature is off.
+   *
+   * Supported in codecs: AV1
+   */
+  AV1E_SET_ROW_MT,
+
+  /*!\brief Codec control function to run the encoder's threads on a pool
+   * shared with other codec instances.
+   *
+   * The pool is created with aom_thread_pool_create() and must outlive the
+   * encoder. The encoder uses up to g_threads workers from the pool, which may
+   * run fewer of them at a time. The output does not depend on the pool.
+   *
+   * It must be set before the first frame is encoded. By default, the
+   * encoder starts threads of its own.
+   *
+   * Supported in codecs: AV1
+   */
+  AV1E_SET_THREAD_POOL,
+
+  /*!\brief Codec control function to get the time the encoder spent
+   * estimating global motion for the last frame, in microseconds.
+   *
+   * It is 0 for frames without global motion search, and when global motion
+   * is not enabled in the build.
+   *
+   * Supported in codecs: AV1
+   */
+  AV1E_GET_GLOBAL_MOTION_TIME,
+
+  /*!\brief Codec control function to get the total time the encoder has
+   * spent in the temporal filter that produces the alt-ref frames, in
+   * microseconds.
+   *
+   * Supported in codecs: AV1
+   */
+  AV1E_GET_TEMPORAL_FILTER_TIME,
+
+  /*!\brief Codec control function to cache the transform RD results of
+   * inter blocks during the mode search.
+   *
+   * The output does not depend on it. By default, this feature is on.
+   *
+   * Supported in codecs: AV1
+   */
+  AV1E_SET_TXFM_RD_CACHE,
+
+  /*!\brief Codec control function to get the lookups in the transform RD
+   * cache and their hits, over all the frames encoded so far.
+   *
+   * The argument points to 2 values, which are set to the number of lookups
+   * and the number of hits.
+   *
+   * Supported in codecs: AV1
+   */
+  AV1E_GET_TXFM_RD_CACHE_STATS,
+
+  /*!\brief Codec control function to get the number of workers the encoder
+   * has created, including the main thread.
+   *
+   * It is 0 until a stage of the encoding has run on the workers.
+   *
+   * Supported in codecs: AV1
+   */
+  AV1E_GET_NUM_WORKERS,
 };
 
 /*!\brief aom 1-D scaling mode
@@ -775,6 +847,27 @@ AOM_CTRL_USE_TYPE(AV1E_SET_RENDER_SIZE, int *)
 AOM_CTRL_USE_TYPE(AV1E_SET_SUPERBLOCK_SIZE, unsigned int)
 #define AOM_CTRL_AV1E_SET_SUPERBLOCK_SIZE
 
+AOM_CTRL_USE_TYPE(AV1E_SET_ROW_MT, unsigned int)
+#define AOM_CTRL_AV1E_SET_ROW_MT
+
+AOM_CTRL_USE_TYPE(AV1E_SET_THREAD_POOL, aom_thread_pool_t *)
+#define AOM_CTRL_AV1E_SET_THREAD_POOL
+
+AOM_CTRL_USE_TYPE(AV1E_GET_GLOBAL_MOTION_TIME, int64_t *)
+#define AOM_CTRL_AV1E_GET_GLOBAL_MOTION_TIME
+
+AOM_CTRL_USE_TYPE(AV1E_GET_TEMPORAL_FILTER_TIME, int64_t *)
+#define AOM_CTRL_AV1E_GET_TEMPORAL_FILTER_TIME
+
+AOM_CTRL_USE_TYPE(AV1E_SET_TXFM_RD_CACHE, unsigned int)
+#define AOM_CTRL_AV1E_SET_TXFM_RD_CACHE
+
+AOM_CTRL_USE_TYPE(AV1E_GET_TXFM_RD_CACHE_STATS, int64_t *)
+#define AOM_CTRL_AV1E_GET_TXFM_RD_CACHE_STATS
+
+AOM_CTRL_USE_TYPE(AV1E_GET_NUM_WORKERS, int *)
+#define AOM_CTRL_AV1E_GET_NUM_WORKERS
+
 AOM_CTRL_USE_TYPE(AV1E_SET_TARGET_LEVEL, unsigned int)
 #define AOM_CTRL_AV1E_SET_TARGET_LEVEL
 
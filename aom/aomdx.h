@@ -128,7 +128,33 @@ enum aom_dec_control_id {
    * decoded.
    */
   AV1_SET_DECODE_TILE_ROW,
-  AV1_SET_DECODE_TILE_COL
+  AV1_SET_DECODE_TILE_COL,
+
+  /** control function to set whether the in-loop filters run as a pipeline
+   * over superblock rows, each filter following the one before it down the
+   * frame, rather than as one pass over the whole frame per filter. The output
+   * is the same either way. Valid values are integers. The pipeline is used
+   * when its value is nonzero and the decoder is single-threaded. The default
+   * value is 1. This control has no effect in frame parallel decoding, which
+   * always uses the pipeline to report the rows of a frame as they are done.
+   */
+  AV1_SET_PIPELINED_FILTERS,
+
+  /** control function to set whether a multi-threaded decoder also decodes
+   * the tile rows of a frame in parallel and, for frames with a single tile,
+   * deblocks superblock rows in parallel with their decoding. The output is
+   * the same either way. Valid values are integers. Row multi-threading is
+   * used when its value is nonzero. The default value is 1.
+   */
+  AV1_SET_ROW_MT,
+
+  /** control function to run the decoder's threads on a pool shared with
+   * other codec instances, created with aom_thread_pool_create(). The pool
+   * must outlive the decoder. It must be set before the first frame is
+   * decoded. The decoder uses up to 'threads' workers from the pool, which
+   * may run fewer of them at a time.
+   */
+  AV1_SET_THREAD_POOL
 };
 
 /** Decrypt n bytes of data from input -> output, using the decrypt_state
@@ -187,6 +213,12 @@ AOM_CTRL_USE_TYPE(AV1_SET_DECODE_TILE_COL, int)
 #define AOM_CTRL_AV1_SET_DECODE_TILE_COL
 AOM_CTRL_USE_TYPE(ANALYZER_SET_DATA, AnalyzerData *)
 #define AOM_CTRL_ANALYZER_SET_DATA
+AOM_CTRL_USE_TYPE(AV1_SET_PIPELINED_FILTERS, int)
+#define AOM_CTRL_AV1_SET_PIPELINED_FILTERS
+AOM_CTRL_USE_TYPE(AV1_SET_ROW_MT, int)
+#define AOM_CTRL_AV1_SET_ROW_MT
+AOM_CTRL_USE_TYPE(AV1_SET_THREAD_POOL, aom_thread_pool_t *)
+#define AOM_CTRL_AV1_SET_THREAD_POOL
 /*!\endcond */
 /*! @} - end defgroup aom_decoder */
 
@@ -177,6 +177,11 @@ static int64_t highbd_get_sse(const uint8_t *a, int a_stride, const uint8_t *b,
 }
 #endif  // CONFIG_AOM_HIGHBITDEPTH
 
+int64_t aom_get_sse(const uint8_t *a, int a_stride, const uint8_t *b,
+                    int b_stride, int width, int height) {
+  return get_sse(a, a_stride, b, b_stride, width, height);
+}
+
 int64_t aom_get_y_sse_part(const YV12_BUFFER_CONFIG *a,
                            const YV12_BUFFER_CONFIG *b, int hstart, int width,
                            int vstart, int height) {
@@ -213,6 +218,11 @@ int64_t aom_get_v_sse(const YV12_BUFFER_CONFIG *a,
 }
 
 #if CONFIG_AOM_HIGHBITDEPTH
+int64_t aom_highbd_get_sse(const uint8_t *a, int a_stride, const uint8_t *b,
+                           int b_stride, int width, int height) {
+  return highbd_get_sse(a, a_stride, b, b_stride, width, height);
+}
+
 int64_t aom_highbd_get_y_sse_part(const YV12_BUFFER_CONFIG *a,
                                   const YV12_BUFFER_CONFIG *b, int hstart,
                                   int width, int vstart, int height) {
@@ -29,6 +29,9 @@ if (aom_config("CONFIG_AV1") eq "yes") {
     add_proto qw/void aom_extend_frame_inner_borders/, "struct yv12_buffer_config *ybf";
     specialize qw/aom_extend_frame_inner_borders dspr2/;
 
+    add_proto qw/void aom_extend_frame_inner_borders_rows/, "struct yv12_buffer_config *ybf, int y_start, int y_end";
+    specialize qw/aom_extend_frame_inner_borders_rows/;
+
     add_proto qw/void aom_extend_frame_borders_y/, "struct yv12_buffer_config *ybf";
     specialize qw/aom_extend_frame_borders_y/;
 }
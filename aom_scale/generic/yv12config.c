@@ -37,6 +37,11 @@ int aom_free_frame_buffer(YV12_BUFFER_CONFIG *ybf) {
 #if CONFIG_AOM_HIGHBITDEPTH && CONFIG_GLOBAL_MOTION
     if (ybf->y_buffer_8bit) free(ybf->y_buffer_8bit);
 #endif
+#if CONFIG_GLOBAL_MOTION
+    free(ybf->corners);
+    free(ybf->corner_stats);
+#endif
+    aom_free(ybf->pyramid_alloc);
 
     /* buffer_alloc isn't accessed by most functions.  Rather y_buffer,
       u_buffer and v_buffer point to buffer_alloc and are used.  Clear out
@@ -173,6 +178,7 @@ int aom_realloc_frame_buffer(YV12_BUFFER_CONFIG *ybf, int width, int height,
       ybf->y_buffer_8bit = NULL;
     }
 #endif
+    aom_invalidate_frame_buffer_cache(ybf);
 
     ybf->corrupted = 0; /* assume not corrupted by errors */
     return 0;
@@ -180,6 +186,16 @@ int aom_realloc_frame_buffer(YV12_BUFFER_CONFIG *ybf, int width, int height,
   return -2;
 }
 
+void aom_invalidate_frame_buffer_cache(YV12_BUFFER_CONFIG *ybf) {
+#if CONFIG_AOM_HIGHBITDEPTH && CONFIG_GLOBAL_MOTION
+  ybf->buf_8bit_valid = 0;
+#endif
+#if CONFIG_GLOBAL_MOTION
+  ybf->corners_valid = 0;
+#endif
+  ybf->pyramid_valid = 0;
+}
+
 int aom_alloc_frame_buffer(YV12_BUFFER_CONFIG *ybf, int width, int height,
                            int ss_x, int ss_y,
 #if CONFIG_AOM_HIGHBITDEPTH
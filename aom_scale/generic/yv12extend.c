@@ -194,6 +194,60 @@ void aom_extend_frame_inner_borders_c(YV12_BUFFER_CONFIG *ybf) {
   extend_frame(ybf, inner_bw);
 }
 
+// Extends the borders of luma rows [y_start, y_end) and of the chroma rows
+// they cover. The top border is extended with the first row, and the bottom
+// border once y_end reaches the bottom of the frame, so that extending a frame
+// in bands from the top gives the same result as extend_frame().
+static void extend_frame_rows(YV12_BUFFER_CONFIG *const ybf, int ext_size,
+                              int y_start, int y_end) {
+  const int ss_x = ybf->uv_width < ybf->y_width;
+  const int ss_y = ybf->uv_height < ybf->y_height;
+  const int is_bottom = y_end >= ybf->y_crop_height;
+  const int y_h = (is_bottom ? ybf->y_crop_height : y_end) - y_start;
+  const int y_et = y_start == 0 ? ext_size : 0;
+  const int y_eb =
+      is_bottom ? ext_size + ybf->y_height - ybf->y_crop_height : 0;
+  const int y_er = ext_size + ybf->y_width - ybf->y_crop_width;
+  const int c_start = y_start >> ss_y;
+  const int c_h = (is_bottom ? ybf->uv_crop_height : y_end >> ss_y) - c_start;
+  const int c_et = y_start == 0 ? ext_size >> ss_y : 0;
+  const int c_el = ext_size >> ss_x;
+  const int c_eb =
+      is_bottom ? (ext_size >> ss_y) + ybf->uv_height - ybf->uv_crop_height : 0;
+  const int c_er = c_el + ybf->uv_width - ybf->uv_crop_width;
+  const int y_offset = y_start * ybf->y_stride;
+  const int c_offset = c_start * ybf->uv_stride;
+
+  if (y_h <= 0) return;
+#if CONFIG_AOM_HIGHBITDEPTH
+  if (ybf->flags & YV12_FLAG_HIGHBITDEPTH) {
+    extend_plane_high(ybf->y_buffer + y_offset, ybf->y_stride,
+                      ybf->y_crop_width, y_h, y_et, ext_size, y_eb, y_er);
+    if (c_h <= 0) return;
+    extend_plane_high(ybf->u_buffer + c_offset, ybf->uv_stride,
+                      ybf->uv_crop_width, c_h, c_et, c_el, c_eb, c_er);
+    extend_plane_high(ybf->v_buffer + c_offset, ybf->uv_stride,
+                      ybf->uv_crop_width, c_h, c_et, c_el, c_eb, c_er);
+    return;
+  }
+#endif
+  extend_plane(ybf->y_buffer + y_offset, ybf->y_stride, ybf->y_crop_width,
+               y_h, y_et, ext_size, y_eb, y_er);
+  if (c_h <= 0) return;
+  extend_plane(ybf->u_buffer + c_offset, ybf->uv_stride, ybf->uv_crop_width,
+               c_h, c_et, c_el, c_eb, c_er);
+  extend_plane(ybf->v_buffer + c_offset, ybf->uv_stride, ybf->uv_crop_width,
+               c_h, c_et, c_el, c_eb, c_er);
+}
+
+void aom_extend_frame_inner_borders_rows_c(YV12_BUFFER_CONFIG *ybf,
+                                           int y_start, int y_end) {
+  const int inner_bw = (ybf->border > AOMINNERBORDERINPIXELS)
+                           ? AOMINNERBORDERINPIXELS
+                           : ybf->border;
+  extend_frame_rows(ybf, inner_bw, y_start, y_end);
+}
+
 void aom_extend_frame_borders_y_c(YV12_BUFFER_CONFIG *ybf) {
   int ext_size = ybf->border;
   assert(ybf->y_height - ybf->y_crop_height < 16);
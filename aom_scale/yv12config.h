@@ -28,6 +28,7 @@ extern "C" {
 #define AOMINNERBORDERINPIXELS 96
 #endif  // CONFIG_EXT_PARTITION
 #define AOM_INTERP_EXTEND 4
+#define YV12_MAX_PYRAMID_LEVELS 3
 
 // TODO(jingning): Use unified inter predictor for encoder and
 // decoder during the development process. Revisit the frame border
@@ -60,7 +61,28 @@ typedef struct yv12_buffer_config {
   // If the frame is stored in a 16-bit buffer, this stores an 8-bit version
   // for use in global motion detection. It is allocated on-demand.
   uint8_t *y_buffer_8bit;
+  int buf_8bit_valid;
 #endif
+#if CONFIG_GLOBAL_MOTION
+  // Interest points of the luma plane and the pixel sums of the patch around
+  // each of them, found by global motion estimation. They are kept with the
+  // frame so that its features are only computed once.
+  int *corners;
+  int *corner_stats;
+  int num_corners;
+  int corners_valid;
+#endif
+  // Downsampled 8-bit copies of the luma plane for the hierarchical motion
+  // search, each half the size of the one before, starting at level 1 (half
+  // resolution). They are made on first use and kept with the frame.
+  uint8_t *pyramid_alloc;
+  size_t pyramid_alloc_sz;
+  uint8_t *pyramid_buffer[YV12_MAX_PYRAMID_LEVELS + 1];
+  int pyramid_width[YV12_MAX_PYRAMID_LEVELS + 1];
+  int pyramid_height[YV12_MAX_PYRAMID_LEVELS + 1];
+  int pyramid_stride[YV12_MAX_PYRAMID_LEVELS + 1];
+  int pyramid_levels;
+  int pyramid_valid;
 
   uint8_t *buffer_alloc;
   size_t buffer_alloc_sz;
@@ -104,6 +126,12 @@ int aom_realloc_frame_buffer(YV12_BUFFER_CONFIG *ybf, int width, int height,
                              aom_get_frame_buffer_cb_fn_t cb, void *cb_priv);
 int aom_free_frame_buffer(YV12_BUFFER_CONFIG *ybf);
 
+// Marks the data cached alongside the frame (the 8-bit luma copy, the
+// global motion features and the motion search pyramid) as stale. Must be
+// called whenever the pixels of a buffer are overwritten without
+// reallocating it.
+void aom_invalidate_frame_buffer_cache(YV12_BUFFER_CONFIG *ybf);
+
 #ifdef __cplusplus
 }
 #endif
@@ -0,0 +1,173 @@
+/*
+ * Copyright (c) 2016, Alliance for Open Media. All rights reserved
+ *
+ * This source code is subject to the terms of the BSD 2 Clause License and
+ * the Alliance for Open Media Patent License 1.0. If the BSD 2 Clause License
+ * was not distributed with this source code in the LICENSE file, you can
+ * obtain it at www.aomedia.org/license/software. If the Alliance for Open
+ * Media Patent License 1.0 was not distributed with this source code in the
+ * PATENTS file, you can obtain it at www.aomedia.org/license/patent.
+ */
+
+#include <assert.h>
+#include <string.h>
+
+#include "aom_mem/aom_mem.h"
+#include "aom_util/aom_job_queue.h"
+
+int aom_job_queue_alloc(AOMJobQueue *q, int max_threads, int max_jobs) {
+  int i;
+
+  memset(q, 0, sizeof(*q));
+  q->lists = (AOMJobList *)aom_calloc(max_threads, sizeof(*q->lists));
+  q->idle_usec = (int64_t *)aom_calloc(max_threads, sizeof(*q->idle_usec));
+  if (q->lists == NULL || q->idle_usec == NULL) return 0;
+  q->max_threads = max_threads;
+  q->max_jobs = max_jobs;
+
+  for (i = 0; i < max_threads; ++i) {
+    AOMJobList *const list = &q->lists[i];
+    list->jobs = (int *)aom_malloc(max_jobs * sizeof(*list->jobs));
+    if (list->jobs == NULL) return 0;
+#if CONFIG_MULTITHREAD
+    pthread_mutex_init(&list->mutex_, NULL);
+#endif
+  }
+  return 1;
+}
+
+void aom_job_queue_dealloc(AOMJobQueue *q) {
+  int i;
+
+  if (q->lists != NULL) {
+    for (i = 0; i < q->max_threads; ++i) {
+      if (q->lists[i].jobs == NULL) break;
+#if CONFIG_MULTITHREAD
+      pthread_mutex_destroy(&q->lists[i].mutex_);
+#endif
+      aom_free(q->lists[i].jobs);
+    }
+    aom_free(q->lists);
+  }
+  aom_free(q->idle_usec);
+  memset(q, 0, sizeof(*q));
+}
+
+void aom_job_queue_reset(AOMJobQueue *q, int num_threads, int ordered) {
+  int i;
+
+  assert(num_threads > 0 && num_threads <= q->max_threads);
+  q->num_threads = num_threads;
+  q->ordered = ordered;
+  for (i = 0; i < num_threads; ++i) {
+    q->lists[i].start = 0;
+    q->lists[i].end = 0;
+    q->lists[i].finish_usec = -1;
+  }
+  aom_usec_timer_start(&q->timer);
+}
+
+void aom_job_queue_push(AOMJobQueue *q, int thread, int job) {
+  AOMJobList *const list = &q->lists[thread];
+
+  assert(thread < q->num_threads && list->end < q->max_jobs);
+  list->jobs[list->end++] = job;
+}
+
+void aom_job_queue_push_range(AOMJobQueue *q, int num_jobs) {
+  int job;
+
+  for (job = 0; job < num_jobs; ++job)
+    aom_job_queue_push(q, job % q->num_threads, job);
+}
+
+// Takes the job at the front of the list when |front| is set, or else the one
+// at the back.
+static int take_job(AOMJobList *const list, int front) {
+  int job = -1;
+
+#if CONFIG_MULTITHREAD
+  pthread_mutex_lock(&list->mutex_);
+#endif
+  if (list->start < list->end)
+    job = front ? list->jobs[list->start++] : list->jobs[--list->end];
+#if CONFIG_MULTITHREAD
+  pthread_mutex_unlock(&list->mutex_);
+#endif
+  return job;
+}
+
+// Takes the lowest job at the front of any of the lists, starting the search
+// from the list of |thread| so that it wins ties.
+static int take_lowest_job(AOMJobQueue *q, int thread) {
+  for (;;) {
+    AOMJobList *lowest = NULL;
+    int lowest_job = -1;
+    int i;
+
+    for (i = 0; i < q->num_threads; ++i) {
+      AOMJobList *const list = &q->lists[(thread + i) % q->num_threads];
+#if CONFIG_MULTITHREAD
+      pthread_mutex_lock(&list->mutex_);
+#endif
+      if (list->start < list->end &&
+          (lowest == NULL || list->jobs[list->start] < lowest_job)) {
+        lowest = list;
+        lowest_job = list->jobs[list->start];
+      }
+#if CONFIG_MULTITHREAD
+      pthread_mutex_unlock(&list->mutex_);
+#endif
+    }
+    if (lowest == NULL) return -1;
+
+    // Another thread may have taken the job in the meantime.
+#if CONFIG_MULTITHREAD
+    pthread_mutex_lock(&lowest->mutex_);
+#endif
+    if (lowest->start < lowest->end &&
+        lowest->jobs[lowest->start] == lowest_job) {
+      ++lowest->start;
+    } else {
+      lowest_job = -1;
+    }
+#if CONFIG_MULTITHREAD
+    pthread_mutex_unlock(&lowest->mutex_);
+#endif
+    if (lowest_job >= 0) return lowest_job;
+  }
+}
+
+int aom_job_queue_pop(AOMJobQueue *q, int thread) {
+  AOMJobList *const list = &q->lists[thread];
+  int job;
+  int i;
+
+  if (q->ordered) {
+    job = take_lowest_job(q, thread);
+  } else {
+    job = take_job(list, 1);
+    for (i = 1; job < 0 && i < q->num_threads; ++i)
+      job = take_job(&q->lists[(thread + i) % q->num_threads], 0);
+  }
+
+  if (job < 0 && list->finish_usec < 0) {
+    struct aom_usec_timer timer = q->timer;
+    aom_usec_timer_mark(&timer);
+    list->finish_usec = aom_usec_timer_elapsed(&timer);
+  }
+  return job;
+}
+
+void aom_job_queue_finish(AOMJobQueue *q) {
+  int64_t last = 0;
+  int i;
+
+  for (i = 0; i < q->num_threads; ++i)
+    if (q->lists[i].finish_usec > last) last = q->lists[i].finish_usec;
+
+  // A thread that never asked for a job was not taking part.
+  for (i = 0; i < q->num_threads; ++i)
+    if (q->lists[i].finish_usec >= 0)
+      q->idle_usec[i] += last - q->lists[i].finish_usec;
+}
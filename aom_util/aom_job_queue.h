@@ -0,0 +1,96 @@
+/*
+ * Copyright (c) 2016, Alliance for Open Media. All rights reserved
+ *
+ * This source code is subject to the terms of the BSD 2 Clause License and
+ * the Alliance for Open Media Patent License 1.0. If the BSD 2 Clause License
+ * was not distributed with this source code in the LICENSE file, you can
+ * obtain it at www.aomedia.org/license/software. If the Alliance for Open
+ * Media Patent License 1.0 was not distributed with this source code in the
+ * PATENTS file, you can obtain it at www.aomedia.org/license/patent.
+ */
+//
+// Work-stealing job queue
+//
+// The jobs, identified by a non-negative index, are dealt out to a fixed set
+// of threads before the threads are launched. Each thread then takes the jobs
+// from the front of its own list and, once that is empty, steals from the
+// back of the lists of the other threads, so that a thread which drew an
+// expensive job does not hold up the others.
+//
+// If a job may wait for jobs with a lower index, they must be pushed in
+// increasing order, and the run must be ordered: every thread then takes the
+// lowest job left, from whichever list holds it, so that the jobs a job waits
+// for have always been started. This holds however many of the threads are
+// actually running, as when the workers share the threads of a pool.
+
+#ifndef AOM_JOB_QUEUE_H_
+#define AOM_JOB_QUEUE_H_
+
+#include "./aom_config.h"
+#include "aom/aom_integer.h"
+#include "aom_ports/aom_timer.h"
+#include "aom_util/aom_thread.h"
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+typedef struct AOMJobList {
+#if CONFIG_MULTITHREAD
+  pthread_mutex_t mutex_;
+#endif
+  int *jobs;
+  // The jobs still to run are jobs[start] to jobs[end - 1].
+  int start;
+  int end;
+  // Microseconds from aom_job_queue_reset() to the moment the thread found no
+  // job left, or -1 while it is still running jobs.
+  int64_t finish_usec;
+} AOMJobList;
+
+typedef struct AOMJobQueue {
+  AOMJobList *lists;
+  // Number of threads the queue is allocated for, and taking part in the
+  // current run.
+  int max_threads;
+  int num_threads;
+  // Whether the current run takes the jobs in increasing order.
+  int ordered;
+  // Number of jobs each thread may be handed in a run.
+  int max_jobs;
+  struct aom_usec_timer timer;
+  // Total time each thread has spent without a job to run while the other
+  // threads were still busy, accumulated over all the runs.
+  int64_t *idle_usec;
+} AOMJobQueue;
+
+// Allocates a queue for up to |max_threads| threads with up to |max_jobs| jobs
+// each. Returns false if an allocation failed; the queue must still be passed
+// to aom_job_queue_dealloc().
+int aom_job_queue_alloc(AOMJobQueue *q, int max_threads, int max_jobs);
+void aom_job_queue_dealloc(AOMJobQueue *q);
+
+// Empties the lists for a new run by |num_threads| threads, and starts timing
+// it. Must not be called while any thread is taking jobs.
+void aom_job_queue_reset(AOMJobQueue *q, int num_threads, int ordered);
+
+// Hands |job| to |thread|. All the jobs of a run must be pushed before the
+// threads start taking them.
+void aom_job_queue_push(AOMJobQueue *q, int thread, int job);
+
+// Deals |num_jobs| jobs, numbered from 0, out to the threads in turn.
+void aom_job_queue_push_range(AOMJobQueue *q, int num_jobs);
+
+// Returns the next job for |thread| to run, or -1 once every job has been
+// taken.
+int aom_job_queue_pop(AOMJobQueue *q, int thread);
+
+// Adds the time each thread has been idle in the current run to idle_usec.
+// Must be called once all the threads have finished.
+void aom_job_queue_finish(AOMJobQueue *q);
+
+#ifdef __cplusplus
+}  // extern "C"
+#endif
+
+#endif  // AOM_JOB_QUEUE_H_
@@ -17,6 +17,7 @@
 #include <assert.h>
 #include <string.h>  // for memset()
 #include "./aom_thread.h"
+#include "./aom_thread_pool.h"
 #include "aom_mem/aom_mem.h"
 
 #if CONFIG_MULTITHREAD
@@ -85,7 +86,10 @@ static void init(AVxWorker *const worker) {
 
 static int sync(AVxWorker *const worker) {
 #if CONFIG_MULTITHREAD
-  change_state(worker, OK);
+  if (worker->pool != NULL)
+    aom_thread_pool_sync(worker);
+  else
+    change_state(worker, OK);
 #endif
   assert(worker->status_ <= OK);
   return !worker->had_error;
@@ -96,6 +100,11 @@ static int reset(AVxWorker *const worker) {
   worker->had_error = 0;
   if (worker->status_ < OK) {
 #if CONFIG_MULTITHREAD
+    if (worker->pool != NULL) {
+      // The hook is run on the threads of the pool.
+      worker->status_ = OK;
+      return 1;
+    }
     worker->impl_ = (AVxWorkerImpl *)aom_calloc(1, sizeof(*worker->impl_));
     if (worker->impl_ == NULL) {
       return 0;
@@ -137,7 +146,10 @@ static void execute(AVxWorker *const worker) {
 
 static void launch(AVxWorker *const worker) {
 #if CONFIG_MULTITHREAD
-  change_state(worker, WORK);
+  if (worker->pool != NULL)
+    aom_thread_pool_launch(worker);
+  else
+    change_state(worker, WORK);
 #else
   execute(worker);
 #endif
@@ -145,7 +157,10 @@ static void launch(AVxWorker *const worker) {
 
 static void end(AVxWorker *const worker) {
 #if CONFIG_MULTITHREAD
-  if (worker->impl_ != NULL) {
+  if (worker->pool != NULL && worker->status_ >= OK) {
+    aom_thread_pool_sync(worker);
+    worker->status_ = NOT_OK;
+  } else if (worker->impl_ != NULL) {
     change_state(worker, NOT_OK);
     pthread_join(worker->impl_->thread_, NULL);
     pthread_mutex_destroy(&worker->impl_->mutex_);
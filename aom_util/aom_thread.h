@@ -23,10 +23,16 @@
 extern "C" {
 #endif
 
-// Set maximum decode threads to be 8 due to the limit of frame buffers
-// and not enough semaphores in the emulation layer on windows.
+// Set maximum frame parallel decode threads to be 8 due to the limit of frame
+// buffers.
 #define MAX_DECODE_THREADS 8
 
+// Maximum number of threads that decode the tiles and superblock rows of a
+// frame and run its in-loop filters. This may be overridden at build time.
+#ifndef MAX_DECODE_TILE_THREADS
+#define MAX_DECODE_TILE_THREADS 64
+#endif
+
 #if CONFIG_MULTITHREAD
 
 #if defined(_WIN32) && !HAVE_PTHREAD_H
@@ -144,8 +150,11 @@ static INLINE int pthread_cond_init(pthread_cond_t *const condition,
 #ifdef USE_WINDOWS_CONDITION_VARIABLE
   InitializeConditionVariable(condition);
 #else
-  condition->waiting_sem_ = CreateSemaphore(NULL, 0, MAX_DECODE_THREADS, NULL);
-  condition->received_sem_ = CreateSemaphore(NULL, 0, MAX_DECODE_THREADS, NULL);
+  // Every thread of the decoder may be waiting on a condition.
+  condition->waiting_sem_ =
+      CreateSemaphore(NULL, 0, MAX_DECODE_TILE_THREADS, NULL);
+  condition->received_sem_ =
+      CreateSemaphore(NULL, 0, MAX_DECODE_TILE_THREADS, NULL);
   condition->signal_event_ = CreateEvent(NULL, FALSE, FALSE, NULL);
   if (condition->waiting_sem_ == NULL || condition->received_sem_ == NULL ||
       condition->signal_event_ == NULL) {
@@ -359,13 +368,20 @@ typedef int (*AVxWorkerHook)(void *, void *);
 typedef struct AVxWorkerImpl AVxWorkerImpl;
 
 // Synchronization object used to launch job in the worker thread
-typedef struct {
+typedef struct AVxWorker {
   AVxWorkerImpl *impl_;
   AVxWorkerStatus status_;
   AVxWorkerHook hook;  // hook to call
   void *data1;         // first argument passed to 'hook'
   void *data2;         // second argument passed to 'hook'
   int had_error;       // return value of the last call to 'hook'
+  // If set before reset(), the hook is run on a thread of this shared pool
+  // rather than on a thread of the worker's own. 'pool_owner' identifies the
+  // codec instance the worker belongs to, which the pool shares its threads
+  // out between.
+  struct aom_thread_pool *pool;
+  const void *pool_owner;
+  struct AVxWorker *pool_next_;  // next worker waiting for a pool thread
 } AVxWorker;
 
 // The interface for all thread-worker related functions. All these functions
@@ -0,0 +1,237 @@
+/*
+ * Copyright (c) 2016, Alliance for Open Media. All rights reserved
+ *
+ * This source code is subject to the terms of the BSD 2 Clause License and
+ * the Alliance for Open Media Patent License 1.0. If the BSD 2 Clause License
+ * was not distributed with this source code in the LICENSE file, you can
+ * obtain it at www.aomedia.org/license/software. If the Alliance for Open
+ * Media Patent License 1.0 was not distributed with this source code in the
+ * PATENTS file, you can obtain it at www.aomedia.org/license/patent.
+ */
+
+#include <assert.h>
+#include <limits.h>
+
+#include "aom_mem/aom_mem.h"
+#include "aom_util/aom_thread_pool.h"
+
+typedef struct AVxPoolThread {
+  AVxThreadPool *pool;
+#if CONFIG_MULTITHREAD
+  pthread_t thread;
+#endif
+  // Owner of the worker the thread is running, or NULL when it is idle.
+  const void *owner;
+} AVxPoolThread;
+
+struct aom_thread_pool {
+#if CONFIG_MULTITHREAD
+  pthread_mutex_t mutex_;
+  // Signalled when a worker is queued, and when the pool is shut down.
+  pthread_cond_t work_cond_;
+  // Broadcast when a worker has finished.
+  pthread_cond_t done_cond_;
+#endif
+  AVxPoolThread *threads;
+  int num_threads;
+  // The workers waiting for a thread, in the order they were launched.
+  AVxWorker *waiting;
+  int shutdown;
+};
+
+#if CONFIG_MULTITHREAD
+// Returns the number of threads of the pool running a worker of 'owner'.
+static int count_running(const AVxThreadPool *pool, const void *owner) {
+  int count = 0;
+  int i;
+  for (i = 0; i < pool->num_threads; ++i)
+    count += pool->threads[i].owner == owner;
+  return count;
+}
+
+// Returns whether a worker of 'owner' is waiting ahead of 'worker'.
+static int owner_waiting_before(const AVxThreadPool *pool,
+                                const AVxWorker *worker, const void *owner) {
+  const AVxWorker *w;
+  for (w = pool->waiting; w != worker; w = w->pool_next_)
+    if (w->pool_owner == owner) return 1;
+  return 0;
+}
+
+// Removes and returns the next waiting worker to run: the first one of the
+// owner with the fewest workers running. The pool must be locked.
+static AVxWorker *take_next_worker(AVxThreadPool *pool) {
+  AVxWorker **next = NULL;
+  AVxWorker **link;
+  AVxWorker *worker;
+  int fewest_running = INT_MAX;
+
+  for (link = &pool->waiting; *link != NULL; link = &(*link)->pool_next_) {
+    const void *const owner = (*link)->pool_owner;
+    int running;
+    if (owner_waiting_before(pool, *link, owner)) continue;
+    running = count_running(pool, owner);
+    if (running < fewest_running) {
+      fewest_running = running;
+      next = link;
+    }
+  }
+  if (next == NULL) return NULL;
+  worker = *next;
+  *next = worker->pool_next_;
+  worker->pool_next_ = NULL;
+  return worker;
+}
+
+// Removes 'worker' from the waiting list. Returns false if it is not there.
+// The pool must be locked.
+static int take_worker(AVxThreadPool *pool, AVxWorker *const worker) {
+  AVxWorker **link;
+  for (link = &pool->waiting; *link != NULL; link = &(*link)->pool_next_) {
+    if (*link == worker) {
+      *link = worker->pool_next_;
+      worker->pool_next_ = NULL;
+      return 1;
+    }
+  }
+  return 0;
+}
+
+static void run_worker(AVxWorker *const worker) {
+  if (worker->hook != NULL)
+    worker->had_error |= !worker->hook(worker->data1, worker->data2);
+}
+
+static THREADFN pool_thread_loop(void *ptr) {
+  AVxPoolThread *const thread = (AVxPoolThread *)ptr;
+  AVxThreadPool *const pool = thread->pool;
+
+  pthread_mutex_lock(&pool->mutex_);
+  for (;;) {
+    AVxWorker *worker;
+    while (pool->waiting == NULL && !pool->shutdown)
+      pthread_cond_wait(&pool->work_cond_, &pool->mutex_);
+    if (pool->waiting == NULL) break;
+
+    worker = take_next_worker(pool);
+    thread->owner = worker->pool_owner;
+    pthread_mutex_unlock(&pool->mutex_);
+
+    run_worker(worker);
+
+    pthread_mutex_lock(&pool->mutex_);
+    thread->owner = NULL;
+    worker->status_ = OK;
+    pthread_cond_broadcast(&pool->done_cond_);
+  }
+  pthread_mutex_unlock(&pool->mutex_);
+  return THREAD_RETURN(NULL);
+}
+
+void aom_thread_pool_launch(AVxWorker *const worker) {
+  AVxThreadPool *const pool = worker->pool;
+  AVxWorker **link;
+
+  pthread_mutex_lock(&pool->mutex_);
+  assert(worker->status_ == OK);
+  worker->status_ = WORK;
+  worker->pool_next_ = NULL;
+  for (link = &pool->waiting; *link != NULL; link = &(*link)->pool_next_) {
+  }
+  *link = worker;
+  pthread_cond_signal(&pool->work_cond_);
+  pthread_mutex_unlock(&pool->mutex_);
+}
+
+void aom_thread_pool_sync(AVxWorker *const worker) {
+  AVxThreadPool *const pool = worker->pool;
+
+  pthread_mutex_lock(&pool->mutex_);
+  if (take_worker(pool, worker)) {
+    // No thread of the pool has got to it yet.
+    pthread_mutex_unlock(&pool->mutex_);
+    run_worker(worker);
+    pthread_mutex_lock(&pool->mutex_);
+    worker->status_ = OK;
+  }
+  while (worker->status_ == WORK)
+    pthread_cond_wait(&pool->done_cond_, &pool->mutex_);
+  pthread_mutex_unlock(&pool->mutex_);
+}
+#else
+void aom_thread_pool_launch(AVxWorker *const worker) { (void)worker; }
+
+void aom_thread_pool_sync(AVxWorker *const worker) { (void)worker; }
+#endif  // CONFIG_MULTITHREAD
+
+aom_thread_pool_t *aom_thread_pool_create(unsigned int max_threads) {
+  AVxThreadPool *pool;
+  int i;
+
+  if (max_threads < 1 || max_threads > INT_MAX / sizeof(*pool->threads))
+    return NULL;
+  pool = (AVxThreadPool *)aom_calloc(1, sizeof(*pool));
+  if (pool == NULL) return NULL;
+  pool->threads =
+      (AVxPoolThread *)aom_calloc(max_threads, sizeof(*pool->threads));
+  if (pool->threads == NULL) {
+    aom_free(pool);
+    return NULL;
+  }
+
+#if CONFIG_MULTITHREAD
+  if (pthread_mutex_init(&pool->mutex_, NULL)) goto Error;
+  if (pthread_cond_init(&pool->work_cond_, NULL)) {
+    pthread_mutex_destroy(&pool->mutex_);
+    goto Error;
+  }
+  if (pthread_cond_init(&pool->done_cond_, NULL)) {
+    pthread_cond_destroy(&pool->work_cond_);
+    pthread_mutex_destroy(&pool->mutex_);
+    goto Error;
+  }
+  for (i = 0; i < (int)max_threads; ++i) {
+    AVxPoolThread *const thread = &pool->threads[i];
+    thread->pool = pool;
+    if (pthread_create(&thread->thread, NULL, pool_thread_loop, thread))
+      break;
+    ++pool->num_threads;
+  }
+  if (pool->num_threads == 0) {
+    aom_thread_pool_destroy(pool);
+    return NULL;
+  }
+  return pool;
+
+Error:
+  aom_free(pool->threads);
+  aom_free(pool);
+  return NULL;
+#else
+  // Without threads every worker runs on the thread that launches it.
+  for (i = 0; i < (int)max_threads; ++i) pool->threads[i].pool = pool;
+  return pool;
+#endif  // CONFIG_MULTITHREAD
+}
+
+void aom_thread_pool_destroy(aom_thread_pool_t *pool) {
+#if CONFIG_MULTITHREAD
+  int i;
+#endif
+
+  if (pool == NULL) return;
+#if CONFIG_MULTITHREAD
+  pthread_mutex_lock(&pool->mutex_);
+  assert(pool->waiting == NULL);
+  pool->shutdown = 1;
+  pthread_cond_broadcast(&pool->work_cond_);
+  pthread_mutex_unlock(&pool->mutex_);
+  for (i = 0; i < pool->num_threads; ++i)
+    pthread_join(pool->threads[i].thread, NULL);
+  pthread_cond_destroy(&pool->done_cond_);
+  pthread_cond_destroy(&pool->work_cond_);
+  pthread_mutex_destroy(&pool->mutex_);
+#endif  // CONFIG_MULTITHREAD
+  aom_free(pool->threads);
+  aom_free(pool);
+}
@@ -0,0 +1,53 @@
+/*
+ * Copyright (c) 2016, Alliance for Open Media. All rights reserved
+ *
+ * This source code is subject to the terms of the BSD 2 Clause License and
+ * the Alliance for Open Media Patent License 1.0. If the BSD 2 Clause License
+ * was not distributed with this source code in the LICENSE file, you can
+ * obtain it at www.aomedia.org/license/software. If the Alliance for Open
+ * Media Patent License 1.0 was not distributed with this source code in the
+ * PATENTS file, you can obtain it at www.aomedia.org/license/patent.
+ */
+//
+// Shared thread pool
+//
+// The workers of any number of codec instances can be run on the threads of
+// one pool, created with aom_thread_pool_create(). A worker uses the pool once
+// its 'pool' field is set: launch() then queues it for the next free thread of
+// the pool, and sync() waits for it to finish, or runs it on the calling
+// thread if no pool thread has taken it yet.
+//
+// A free thread takes the first waiting worker of the instance that has the
+// fewest workers running on the pool, so that a busy instance cannot starve
+// the others. The workers of one instance start in the order they were
+// launched.
+//
+// Nothing guarantees that the workers launched together run at the same time,
+// so a worker must not wait for another worker to start. The workers that
+// share out rows which wait on each other do so through an ordered
+// AOMJobQueue.
+
+#ifndef AOM_THREAD_POOL_H_
+#define AOM_THREAD_POOL_H_
+
+#include "./aom_config.h"
+#include "aom/aom_codec.h"
+#include "aom_util/aom_thread.h"
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+typedef aom_thread_pool_t AVxThreadPool;
+
+// Queues the worker for a thread of its pool.
+void aom_thread_pool_launch(AVxWorker *const worker);
+
+// Waits for a worker launched on its pool to finish.
+void aom_thread_pool_sync(AVxWorker *const worker);
+
+#ifdef __cplusplus
+}  // extern "C"
+#endif
+
+#endif  // AOM_THREAD_POOL_H_
@@ -77,9 +77,15 @@ AV1_COMMON_SRCS-yes += common/convolve.c
 AV1_COMMON_SRCS-yes += common/convolve.h
 AV1_COMMON_SRCS-$(CONFIG_LOOP_RESTORATION) += common/restoration.h
 AV1_COMMON_SRCS-$(CONFIG_LOOP_RESTORATION) += common/restoration.c
+ifeq ($(CONFIG_LOOP_RESTORATION),yes)
+AV1_COMMON_SRCS-$(HAVE_SSE4_1) += common/x86/restoration_sse4.c
+AV1_COMMON_SRCS-$(HAVE_AVX2) += common/x86/restoration_avx2.c
+endif
 ifeq (yes,$(filter $(CONFIG_GLOBAL_MOTION) $(CONFIG_WARPED_MOTION),yes))
 AV1_COMMON_SRCS-yes += common/warped_motion.h
 AV1_COMMON_SRCS-yes += common/warped_motion.c
+AV1_COMMON_SRCS-$(HAVE_SSE4_1) += common/x86/warped_motion_sse4.c
+AV1_COMMON_SRCS-$(HAVE_AVX2) += common/x86/warped_motion_avx2.c
 endif
 ifeq ($(CONFIG_CLPF),yes)
 AV1_COMMON_SRCS-yes += common/clpf.c
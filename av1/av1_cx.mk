@@ -102,6 +102,7 @@ AV1_CX_SRCS-yes += encoder/mbgraph.c
 AV1_CX_SRCS-yes += encoder/mbgraph.h
 ifeq ($(CONFIG_DERING),yes)
 AV1_CX_SRCS-yes += encoder/pickdering.c
+AV1_CX_SRCS-yes += encoder/pickdering.h
 endif
 ifeq ($(CONFIG_CLPF),yes)
 AV1_CX_SRCS-yes += encoder/clpf_rdo.c
@@ -122,7 +123,6 @@ AV1_CX_SRCS-yes += encoder/generic_encoder.c
 AV1_CX_SRCS-yes += encoder/laplace_encoder.c
 endif
 
-AV1_CX_SRCS-$(HAVE_SSE2) += encoder/x86/temporal_filter_apply_sse2.asm
 AV1_CX_SRCS-$(HAVE_SSE2) += encoder/x86/quantize_sse2.c
 ifeq ($(CONFIG_AOM_HIGHBITDEPTH),yes)
 AV1_CX_SRCS-$(HAVE_SSE2) += encoder/x86/highbd_block_error_intrin_sse2.c
@@ -142,6 +142,7 @@ ifeq ($(CONFIG_AOM_HIGHBITDEPTH),yes)
 AV1_CX_SRCS-$(HAVE_SSE4_1) += encoder/x86/highbd_fwd_txfm_sse4.c
 AV1_CX_SRCS-$(HAVE_SSE4_1) += common/x86/highbd_inv_txfm_sse4.c
 AV1_CX_SRCS-$(HAVE_SSE4_1) += encoder/x86/av1_highbd_quantize_sse4.c
+AV1_CX_SRCS-$(HAVE_SSE4_1) += encoder/x86/temporal_filter_sse4.c
 endif
 
 ifeq ($(CONFIG_EXT_INTER),yes)
@@ -149,7 +150,20 @@ AV1_CX_SRCS-yes += encoder/wedge_utils.c
 AV1_CX_SRCS-$(HAVE_SSE2) += encoder/x86/wedge_utils_sse2.c
 endif
 
+ifeq ($(CONFIG_DERING),yes)
+AV1_CX_SRCS-$(HAVE_SSE2) += encoder/x86/pickdering_sse2.c
+endif
+
+ifeq ($(CONFIG_LOOP_RESTORATION),yes)
+AV1_CX_SRCS-$(HAVE_SSE2) += encoder/x86/pickrst_sse2.c
+endif
+
+ifeq ($(CONFIG_GLOBAL_MOTION),yes)
+AV1_CX_SRCS-$(HAVE_SSE2) += encoder/x86/corner_match_sse2.c
+endif
+
 AV1_CX_SRCS-$(HAVE_AVX2) += encoder/x86/error_intrin_avx2.c
+AV1_CX_SRCS-$(HAVE_AVX2) += encoder/x86/temporal_filter_avx2.c
 
 ifneq ($(CONFIG_AOM_HIGHBITDEPTH),yes)
 AV1_CX_SRCS-$(HAVE_NEON) += encoder/arm/neon/dct_neon.c
@@ -162,6 +176,5 @@ AV1_CX_SRCS-$(HAVE_MSA) += encoder/mips/msa/fdct4x4_msa.c
 AV1_CX_SRCS-$(HAVE_MSA) += encoder/mips/msa/fdct8x8_msa.c
 AV1_CX_SRCS-$(HAVE_MSA) += encoder/mips/msa/fdct16x16_msa.c
 AV1_CX_SRCS-$(HAVE_MSA) += encoder/mips/msa/fdct_msa.h
-AV1_CX_SRCS-$(HAVE_MSA) += encoder/mips/msa/temporal_filter_msa.c
 
 AV1_CX_SRCS-yes := $(filter-out $(AV1_CX_SRCS_REMOVE-yes),$(AV1_CX_SRCS-yes))
@@ -19,6 +19,7 @@
 #include "aom/internal/aom_codec_internal.h"
 #include "./aom_version.h"
 #include "av1/encoder/encoder.h"
+#include "av1/encoder/ethread.h"
 #include "aom/aomcx.h"
 #include "av1/encoder/firstpass.h"
 #include "av1/av1_iface_common.h"
@@ -63,6 +64,9 @@ struct av1_extracfg {
   int render_width;
   int render_height;
   aom_superblock_size_t superblock_size;
+  unsigned int row_mt;
+  aom_thread_pool_t *thread_pool;
+  unsigned int txfm_rd_cache;
 };
 
 static struct av1_extracfg default_extra_cfg = {
@@ -100,16 +104,19 @@ static struct av1_extracfg default_extra_cfg = {
   1,  // max number of tile groups
   0,  // mtu_size
 #endif
-  1,                           // frame_parallel_decoding_mode
-  NO_AQ,                       // aq_mode
-  0,                           // frame_periodic_delta_q
-  AOM_BITS_8,                  // Bit depth
-  AOM_CONTENT_DEFAULT,         // content
-  AOM_CS_UNKNOWN,              // color space
-  0,                           // color range
-  0,                           // render width
-  0,                           // render height
-  AOM_SUPERBLOCK_SIZE_DYNAMIC  // superblock_size
+  1,                            // frame_parallel_decoding_mode
+  NO_AQ,                        // aq_mode
+  0,                            // frame_periodic_delta_q
+  AOM_BITS_8,                   // Bit depth
+  AOM_CONTENT_DEFAULT,          // content
+  AOM_CS_UNKNOWN,               // color space
+  0,                            // color range
+  0,                            // render width
+  0,                            // render height
+  AOM_SUPERBLOCK_SIZE_DYNAMIC,  // superblock_size
+  0,                            // row_mt
+  NULL,                         // thread_pool
+  1,                            // txfm_rd_cache
 };
 
 struct aom_codec_alg_priv {
@@ -183,6 +190,8 @@ static aom_codec_err_t validate_config(aom_codec_alg_priv_t *ctx,
   RANGE_CHECK_HI(cfg, rc_max_quantizer, 63);
   RANGE_CHECK_HI(cfg, rc_min_quantizer, cfg->rc_max_quantizer);
   RANGE_CHECK_BOOL(extra_cfg, lossless);
+  RANGE_CHECK_BOOL(extra_cfg, row_mt);
+  RANGE_CHECK_BOOL(extra_cfg, txfm_rd_cache);
   RANGE_CHECK(extra_cfg, aq_mode, 0, AQ_MODE_COUNT - 1);
   RANGE_CHECK_HI(extra_cfg, frame_periodic_boost, 1);
   RANGE_CHECK_HI(cfg, g_threads, 64);
@@ -364,6 +373,9 @@ static aom_codec_err_t set_encoder_config(
   const int is_vbr = cfg->rc_end_usage == AOM_VBR;
   oxcf->profile = cfg->g_profile;
   oxcf->max_threads = (int)cfg->g_threads;
+  oxcf->row_mt = extra_cfg->row_mt;
+  oxcf->txfm_rd_cache = extra_cfg->txfm_rd_cache;
+  oxcf->thread_pool = extra_cfg->thread_pool;
   oxcf->width = cfg->g_w;
   oxcf->height = cfg->g_h;
   oxcf->bit_depth = cfg->g_bit_depth;
@@ -1317,6 +1329,66 @@ static aom_codec_err_t ctrl_set_superblock_size(aom_codec_alg_priv_t *ctx,
   return update_extra_cfg(ctx, &extra_cfg);
 }
 
+static aom_codec_err_t ctrl_set_row_mt(aom_codec_alg_priv_t *ctx,
+                                       va_list args) {
+  struct av1_extracfg extra_cfg = ctx->extra_cfg;
+  extra_cfg.row_mt = CAST(AV1E_SET_ROW_MT, args);
+  return update_extra_cfg(ctx, &extra_cfg);
+}
+
+static aom_codec_err_t ctrl_set_txfm_rd_cache(aom_codec_alg_priv_t *ctx,
+                                              va_list args) {
+  struct av1_extracfg extra_cfg = ctx->extra_cfg;
+  extra_cfg.txfm_rd_cache = CAST(AV1E_SET_TXFM_RD_CACHE, args);
+  return update_extra_cfg(ctx, &extra_cfg);
+}
+
+static aom_codec_err_t ctrl_get_txfm_rd_cache_stats(aom_codec_alg_priv_t *ctx,
+                                                    va_list args) {
+  int64_t *const arg = va_arg(args, int64_t *);
+  if (arg == NULL) return AOM_CODEC_INVALID_PARAM;
+  av1_get_txfm_rd_cache_stats(ctx->cpi, &arg[0], &arg[1]);
+  return AOM_CODEC_OK;
+}
+
+static aom_codec_err_t ctrl_get_num_workers(aom_codec_alg_priv_t *ctx,
+                                            va_list args) {
+  int *const arg = va_arg(args, int *);
+  if (arg == NULL) return AOM_CODEC_INVALID_PARAM;
+  *arg = ctx->cpi->num_workers;
+  return AOM_CODEC_OK;
+}
+
+static aom_codec_err_t ctrl_get_global_motion_time(aom_codec_alg_priv_t *ctx,
+                                                   va_list args) {
+  int64_t *const arg = va_arg(args, int64_t *);
+  if (arg == NULL) return AOM_CODEC_INVALID_PARAM;
+#if CONFIG_GLOBAL_MOTION
+  *arg = (int64_t)ctx->cpi->frame_time_global_motion;
+#else
+  (void)ctx;
+  *arg = 0;
+#endif  // CONFIG_GLOBAL_MOTION
+  return AOM_CODEC_OK;
+}
+
+static aom_codec_err_t ctrl_get_temporal_filter_time(aom_codec_alg_priv_t *ctx,
+                                                     va_list args) {
+  int64_t *const arg = va_arg(args, int64_t *);
+  if (arg == NULL) return AOM_CODEC_INVALID_PARAM;
+  *arg = (int64_t)ctx->cpi->time_temporal_filter;
+  return AOM_CODEC_OK;
+}
+
+static aom_codec_err_t ctrl_set_thread_pool(aom_codec_alg_priv_t *ctx,
+                                            va_list args) {
+  struct av1_extracfg extra_cfg = ctx->extra_cfg;
+  // The workers are created with the first frame.
+  if (ctx->cpi != NULL && ctx->cpi->num_workers > 0) return AOM_CODEC_ERROR;
+  extra_cfg.thread_pool = CAST(AV1E_SET_THREAD_POOL, args);
+  return update_extra_cfg(ctx, &extra_cfg);
+}
+
 static aom_codec_ctrl_fn_map_t encoder_ctrl_maps[] = {
   { AOM_COPY_REFERENCE, ctrl_copy_reference },
   { AOME_USE_REFERENCE, ctrl_use_reference },
@@ -1365,6 +1437,9 @@ static aom_codec_ctrl_fn_map_t encoder_ctrl_maps[] = {
   { AV1E_SET_MAX_GF_INTERVAL, ctrl_set_max_gf_interval },
   { AV1E_SET_RENDER_SIZE, ctrl_set_render_size },
   { AV1E_SET_SUPERBLOCK_SIZE, ctrl_set_superblock_size },
+  { AV1E_SET_ROW_MT, ctrl_set_row_mt },
+  { AV1E_SET_TXFM_RD_CACHE, ctrl_set_txfm_rd_cache },
+  { AV1E_SET_THREAD_POOL, ctrl_set_thread_pool },
 
   // Getters
   { AOME_GET_LAST_QUANTIZER, ctrl_get_quantizer },
@@ -1372,6 +1447,10 @@ static aom_codec_ctrl_fn_map_t encoder_ctrl_maps[] = {
   { AV1_GET_REFERENCE, ctrl_get_reference },
   { AV1E_GET_ACTIVEMAP, ctrl_get_active_map },
   { AV1_GET_NEW_FRAME_IMAGE, ctrl_get_new_frame_image },
+  { AV1E_GET_GLOBAL_MOTION_TIME, ctrl_get_global_motion_time },
+  { AV1E_GET_TEMPORAL_FILTER_TIME, ctrl_get_temporal_filter_time },
+  { AV1E_GET_TXFM_RD_CACHE_STATS, ctrl_get_txfm_rd_cache_stats },
+  { AV1E_GET_NUM_WORKERS, ctrl_get_num_workers },
 
   { -1, NULL },
 };
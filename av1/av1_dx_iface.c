@@ -58,6 +58,9 @@ struct aom_codec_alg_priv {
   int last_show_frame;  // Index of last output frame.
   int byte_alignment;
   int skip_loop_filter;
+  int pipelined_filters;
+  int row_mt;
+  aom_thread_pool_t *thread_pool;
   int decode_tile_row;
   int decode_tile_col;
 
@@ -101,6 +104,8 @@ static aom_codec_err_t decoder_init(aom_codec_ctx_t *ctx,
     ctx->priv->init_flags = ctx->init_flags;
     priv->si.sz = sizeof(priv->si);
     priv->flushed = 0;
+    priv->pipelined_filters = 1;
+    priv->row_mt = 1;
     // Only do frame parallel decode when threads > 1.
     priv->frame_parallel_decode =
         (ctx->config.dec && (ctx->config.dec->threads > 1) &&
@@ -426,11 +431,20 @@ static aom_codec_err_t init_decoder(aom_codec_alg_priv_t *ctx) {
     // thread or loopfilter thread.
     frame_worker_data->pbi->max_threads =
         (ctx->frame_parallel_decode == 0) ? ctx->cfg.threads : 0;
+    // Threads beyond the frame workers run the in-loop filters of their
+    // frames.
+    frame_worker_data->pbi->use_filter_worker =
+        ctx->frame_parallel_decode &&
+        i < (int)ctx->cfg.threads - ctx->num_frame_workers;
 
     frame_worker_data->pbi->inv_tile_order = ctx->invert_tile_order;
     frame_worker_data->pbi->common.frame_parallel_decode =
         ctx->frame_parallel_decode;
+    frame_worker_data->pbi->thread_pool = ctx->thread_pool;
+    frame_worker_data->pbi->pool_owner = ctx;
     worker->hook = (AVxWorkerHook)frame_worker_hook;
+    worker->pool = ctx->thread_pool;
+    worker->pool_owner = ctx;
     if (!winterface->reset(worker)) {
       set_error_detail(ctx, "Frame Worker thread creation failed");
       return AOM_CODEC_MEM_ERROR;
@@ -487,6 +501,8 @@ static aom_codec_err_t decode_one(aom_codec_alg_priv_t *ctx,
     frame_worker_data->pbi->decrypt_cb = ctx->decrypt_cb;
     frame_worker_data->pbi->decrypt_state = ctx->decrypt_state;
     frame_worker_data->pbi->analyzer_data = ctx->analyzer_data;
+    frame_worker_data->pbi->pipelined_filters = ctx->pipelined_filters;
+    frame_worker_data->pbi->row_mt = ctx->row_mt;
 
 #if CONFIG_EXT_TILE
     frame_worker_data->pbi->dec_tile_row = ctx->decode_tile_row;
@@ -1128,6 +1144,26 @@ static aom_codec_err_t ctrl_set_decode_tile_col(aom_codec_alg_priv_t *ctx,
   return AOM_CODEC_OK;
 }
 
+static aom_codec_err_t ctrl_set_pipelined_filters(aom_codec_alg_priv_t *ctx,
+                                                  va_list args) {
+  ctx->pipelined_filters = va_arg(args, int);
+  return AOM_CODEC_OK;
+}
+
+static aom_codec_err_t ctrl_set_row_mt(aom_codec_alg_priv_t *ctx,
+                                       va_list args) {
+  ctx->row_mt = va_arg(args, int);
+  return AOM_CODEC_OK;
+}
+
+static aom_codec_err_t ctrl_set_thread_pool(aom_codec_alg_priv_t *ctx,
+                                            va_list args) {
+  // The workers are created with the first frame.
+  if (ctx->frame_workers != NULL) return AOM_CODEC_ERROR;
+  ctx->thread_pool = va_arg(args, aom_thread_pool_t *);
+  return AOM_CODEC_OK;
+}
+
 static aom_codec_err_t ctrl_analyzer_set_data(aom_codec_alg_priv_t *ctx,
                                               va_list args) {
   AnalyzerData *analyzer_data = va_arg(args, AnalyzerData *);
@@ -1151,6 +1187,9 @@ static aom_codec_ctrl_fn_map_t decoder_ctrl_maps[] = {
   { AV1_SET_SKIP_LOOP_FILTER, ctrl_set_skip_loop_filter },
   { AV1_SET_DECODE_TILE_ROW, ctrl_set_decode_tile_row },
   { AV1_SET_DECODE_TILE_COL, ctrl_set_decode_tile_col },
+  { AV1_SET_PIPELINED_FILTERS, ctrl_set_pipelined_filters },
+  { AV1_SET_ROW_MT, ctrl_set_row_mt },
+  { AV1_SET_THREAD_POOL, ctrl_set_thread_pool },
 
   { ANALYZER_SET_DATA, ctrl_analyzer_set_data },
 
@@ -512,7 +512,7 @@ add_proto qw/int av1_full_range_search/, "const struct macroblock *x, const stru
 specialize qw/av1_full_range_search/;
 
 add_proto qw/void av1_temporal_filter_apply/, "uint8_t *frame1, unsigned int stride, uint8_t *frame2, unsigned int block_width, unsigned int block_height, int strength, int filter_weight, unsigned int *accumulator, uint16_t *count";
-specialize qw/av1_temporal_filter_apply sse2 msa/;
+specialize qw/av1_temporal_filter_apply avx2/;
 
 if (aom_config("CONFIG_AOM_QM") eq "yes") {
   add_proto qw/void av1_quantize_b/, "const tran_low_t *coeff_ptr, intptr_t n_coeffs, int skip_block, const int16_t *zbin_ptr, const int16_t *round_ptr, const int16_t *quant_ptr, const int16_t *quant_shift_ptr, tran_low_t *qcoeff_ptr, tran_low_t *dqcoeff_ptr, const int16_t *dequant_ptr, uint16_t *eob_ptr, const int16_t *scan, const int16_t *iscan, const qm_val_t * qm_ptr, const qm_val_t * iqm_ptr, int log_scale";
@@ -612,7 +612,7 @@ if (aom_config("CONFIG_AOM_HIGHBITDEPTH") eq "yes") {
   specialize qw/av1_highbd_fwht4x4/;
 
   add_proto qw/void av1_highbd_temporal_filter_apply/, "uint8_t *frame1, unsigned int stride, uint8_t *frame2, unsigned int block_width, unsigned int block_height, int strength, int filter_weight, unsigned int *accumulator, uint16_t *count";
-  specialize qw/av1_highbd_temporal_filter_apply/;
+  specialize qw/av1_highbd_temporal_filter_apply sse4_1 avx2/;
 
 }
 # End av1_high encoder functions
@@ -626,6 +626,25 @@ if (aom_config("CONFIG_EXT_INTER") eq "yes") {
   specialize qw/av1_wedge_compute_delta_squares sse2/;
 }
 
+if (aom_config("CONFIG_DERING") eq "yes") {
+  add_proto qw/uint32_t av1_dering_sse_8x8/, "const int16_t *a, int a_stride, const int16_t *b, int b_stride";
+  specialize qw/av1_dering_sse_8x8 sse2/;
+}
+
+if (aom_config("CONFIG_LOOP_RESTORATION") eq "yes") {
+  add_proto qw/void av1_compute_stats/, "const uint8_t *dgd, int dgd_stride, const uint8_t *src, int src_stride, int width, int height, int64_t *sum_d, int64_t *sum_s, int64_t *M, int64_t *H, int16_t *tmpbuf";
+  specialize qw/av1_compute_stats sse2/;
+  if (aom_config("CONFIG_AOM_HIGHBITDEPTH") eq "yes") {
+    add_proto qw/void av1_highbd_compute_stats/, "const uint16_t *dgd, int dgd_stride, const uint16_t *src, int src_stride, int width, int height, int bd, int64_t *sum_d, int64_t *sum_s, int64_t *M, int64_t *H, int16_t *tmpbuf";
+    specialize qw/av1_highbd_compute_stats sse2/;
+  }
+}
+
+if (aom_config("CONFIG_GLOBAL_MOTION") eq "yes") {
+  add_proto qw/int av1_compute_cross_correlation/, "const unsigned char *im1, int stride1, const unsigned char *im2, int stride2";
+  specialize qw/av1_compute_cross_correlation sse2/;
+}
+
 }
 # end encoder functions
 
@@ -661,6 +680,39 @@ if (aom_config("CONFIG_AOM_HIGHBITDEPTH") eq "yes") {
 
 }
 
+# Warped motion functions
+
+if ((aom_config("CONFIG_GLOBAL_MOTION") eq "yes") || (aom_config("CONFIG_WARPED_MOTION") eq "yes")) {
+  add_proto qw/void av1_warp_filter_block/, "const uint8_t *ref, int stride, const int *pts, int n, uint8_t *pred";
+  specialize qw/av1_warp_filter_block sse4_1 avx2/;
+
+  if (aom_config("CONFIG_AOM_HIGHBITDEPTH") eq "yes") {
+    add_proto qw/void av1_highbd_warp_filter_block/, "const uint16_t *ref, int stride, const int *pts, int n, uint16_t *pred, int bd";
+    specialize qw/av1_highbd_warp_filter_block sse4_1 avx2/;
+  }
+}
+
+# Loop restoration functions
+
+if (aom_config("CONFIG_LOOP_RESTORATION") eq "yes") {
+  add_proto qw/void av1_wiener_filter_hor/, "const uint8_t *src, int src_stride, uint8_t *dst, int dst_stride, int w, int h, const int *hfilter";
+  specialize qw/av1_wiener_filter_hor sse4_1 avx2/;
+
+  add_proto qw/void av1_wiener_filter_ver/, "const uint8_t *src, int src_stride, uint8_t *dst, int dst_stride, int w, int h, const int *vfilter";
+  specialize qw/av1_wiener_filter_ver sse4_1 avx2/;
+
+  if (aom_config("CONFIG_AOM_HIGHBITDEPTH") eq "yes") {
+    add_proto qw/void av1_highbd_wiener_filter_hor/, "const uint16_t *src, int src_stride, uint16_t *dst, int dst_stride, int w, int h, const int *hfilter, int bd";
+    specialize qw/av1_highbd_wiener_filter_hor sse4_1 avx2/;
+
+    add_proto qw/void av1_highbd_wiener_filter_ver/, "const uint16_t *src, int src_stride, uint16_t *dst, int dst_stride, int w, int h, const int *vfilter, int bd";
+    specialize qw/av1_highbd_wiener_filter_ver sse4_1 avx2/;
+  }
+
+  add_proto qw/void av1_selfguided_restoration/, "const int32_t *dgd, int width, int height, int stride, int bit_depth, int r, int eps, const uint32_t *sum, const uint32_t *sumsq, int sum_stride, int32_t *dst, int dst_stride, int32_t *tmpbuf";
+  specialize qw/av1_selfguided_restoration sse4_1 avx2/;
+}
+
 # Deringing Functions
 
 if (aom_config("CONFIG_DERING") eq "yes") {
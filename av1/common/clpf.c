@@ -9,6 +9,8 @@
  * PATENTS file, you can obtain it at www.aomedia.org/license/patent.
  */
 
+#include <limits.h>
+
 #include "av1/common/clpf.h"
 #include "./aom_dsp_rtcd.h"
 #include "aom/aom_image.h"
@@ -64,17 +66,99 @@ void aom_clpf_block_hbd_c(const uint16_t *src, uint16_t *dst, int sstride,
 }
 #endif
 
-// Return number of filtered blocks
-void av1_clpf_frame(const YV12_BUFFER_CONFIG *frame,
-                    const YV12_BUFFER_CONFIG *org, AV1_COMMON *cm,
-                    int enable_fb_flag, unsigned int strength,
-                    unsigned int fb_size_log2, int plane,
-                    int (*decision)(int, int, const YV12_BUFFER_CONFIG *,
-                                    const YV12_BUFFER_CONFIG *,
-                                    const AV1_COMMON *cm, int, int, int,
-                                    unsigned int, unsigned int, int8_t *)) {
+void av1_clpf_plane_init(ClpfPlane *cp, const YV12_BUFFER_CONFIG *frame,
+                         const YV12_BUFFER_CONFIG *org, AV1_COMMON *cm,
+                         int enable_fb_flag, unsigned int strength,
+                         unsigned int fb_size_log2, int plane,
+                         int (*decision)(int, int, const YV12_BUFFER_CONFIG *,
+                                         const YV12_BUFFER_CONFIG *,
+                                         const AV1_COMMON *cm, int, int, int,
+                                         unsigned int, unsigned int,
+                                         int8_t *)) {
+  const int subx = plane != AOM_PLANE_Y && frame->subsampling_x;
+  const int suby = plane != AOM_PLANE_Y && frame->subsampling_y;
+  const int bs = (subx || suby) ? 4 : 8;
+  const int width =
+      plane != AOM_PLANE_Y ? frame->uv_crop_width : frame->y_crop_width;
+  const int num_fb_hor = (width + (1 << fb_size_log2) - 1) >> fb_size_log2;
+  const int cache_size = num_fb_hor << (2 * fb_size_log2);
+  const int cache_blocks = cache_size / (bs * bs);
+
+  cp->frame = frame;
+  cp->org = org;
+  cp->enable_fb_flag = enable_fb_flag;
+  cp->strength = strength;
+  cp->fb_size_log2 = fb_size_log2;
+  cp->plane = plane;
+  cp->decision = decision;
+  cp->next_fb_row = 0;
+  cp->cache_idx = 0;
+
+// Make buffer space for in-place filtering
+#if CONFIG_AOM_HIGHBITDEPTH
+  cp->strength <<= (cm->bit_depth - 8);
+  CHECK_MEM_ERROR(cm, cp->cache,
+                  aom_malloc(cache_size << !!cm->use_highbitdepth));
+#else
+  CHECK_MEM_ERROR(cm, cp->cache, aom_malloc(cache_size));
+#endif
+  CHECK_MEM_ERROR(cm, cp->cache_ptr,
+                  aom_malloc(cache_blocks * sizeof(*cp->cache_ptr)));
+  CHECK_MEM_ERROR(cm, cp->cache_dst,
+                  aom_malloc(cache_blocks * sizeof(*cp->cache_dst)));
+  CHECK_MEM_ERROR(cm, cp->cache_fb_row,
+                  aom_malloc(cache_blocks * sizeof(*cp->cache_fb_row)));
+  memset(cp->cache_ptr, 0, cache_blocks * sizeof(*cp->cache_dst));
+}
+
+// Copies a cached filtered block back into the frame, and frees its slot.
+static void copy_cached_block(ClpfPlane *cp, AV1_COMMON *cm, int cache_idx,
+                              int bs, int sstride) {
+  uint8_t **const cache_ptr = cp->cache_ptr;
+  uint8_t **const cache_dst = cp->cache_dst;
+  int c;
+  (void)cm;
+
+#if CONFIG_AOM_HIGHBITDEPTH
+  if (cm->use_highbitdepth) {
+    uint16_t *const d = CONVERT_TO_SHORTPTR(cache_dst[cache_idx]);
+    for (c = 0; c < bs; c++) {
+      *(uint64_t *)(d + c * sstride) =
+          *(uint64_t *)(cache_ptr[cache_idx] + c * bs * 2);
+      if (bs == 8)
+        *(uint64_t *)(d + c * sstride + 4) =
+            *(uint64_t *)(cache_ptr[cache_idx] + c * bs * 2 + 8);
+    }
+  } else {
+    for (c = 0; c < bs; c++)
+      if (bs == 4)
+        *(uint32_t *)(cache_dst[cache_idx] + c * sstride) =
+            *(uint32_t *)(cache_ptr[cache_idx] + c * bs);
+      else
+        *(uint64_t *)(cache_dst[cache_idx] + c * sstride) =
+            *(uint64_t *)(cache_ptr[cache_idx] + c * bs);
+  }
+#else
+  for (c = 0; c < bs; c++)
+    if (bs == 4)
+      *(uint32_t *)(cache_dst[cache_idx] + c * sstride) =
+          *(uint32_t *)(cache_ptr[cache_idx] + c * bs);
+    else
+      *(uint64_t *)(cache_dst[cache_idx] + c * sstride) =
+          *(uint64_t *)(cache_ptr[cache_idx] + c * bs);
+#endif
+  cache_ptr[cache_idx] = NULL;
+}
+
+int av1_clpf_plane_rows(ClpfPlane *cp, AV1_COMMON *cm, int ready_rows) {
   /* Constrained low-pass filter (CLPF) */
   int c, k, l, m, n;
+  const YV12_BUFFER_CONFIG *const frame = cp->frame;
+  const YV12_BUFFER_CONFIG *const org = cp->org;
+  const int enable_fb_flag = cp->enable_fb_flag;
+  const unsigned int strength = cp->strength;
+  const unsigned int fb_size_log2 = cp->fb_size_log2;
+  const int plane = cp->plane;
   const int subx = plane != AOM_PLANE_Y && frame->subsampling_x;
   const int suby = plane != AOM_PLANE_Y && frame->subsampling_y;
   const int bs = (subx || suby) ? 4 : 8;
@@ -87,10 +171,10 @@ void av1_clpf_frame(const YV12_BUFFER_CONFIG *frame,
   int dstride = bs;
   const int num_fb_hor = (width + (1 << fb_size_log2) - 1) >> fb_size_log2;
   const int num_fb_ver = (height + (1 << fb_size_log2) - 1) >> fb_size_log2;
-  uint8_t *cache = NULL;
-  uint8_t **cache_ptr = NULL;
-  uint8_t **cache_dst = NULL;
-  int cache_idx = 0;
+  uint8_t *const cache = cp->cache;
+  uint8_t **const cache_ptr = cp->cache_ptr;
+  uint8_t **const cache_dst = cp->cache_dst;
+  int cache_idx = cp->cache_idx;
   const int cache_size = num_fb_hor << (2 * fb_size_log2);
   const int cache_blocks = cache_size / (bs * bs);
   uint8_t *src_buffer =
@@ -99,21 +183,10 @@ void av1_clpf_frame(const YV12_BUFFER_CONFIG *frame,
           : frame->y_buffer;
   uint8_t *dst_buffer;
 
-// Make buffer space for in-place filtering
-#if CONFIG_AOM_HIGHBITDEPTH
-  strength <<= (cm->bit_depth - 8);
-  CHECK_MEM_ERROR(cm, cache, aom_malloc(cache_size << !!cm->use_highbitdepth));
-  dst_buffer = cm->use_highbitdepth ? CONVERT_TO_BYTEPTR(cache) : cache;
-#else
-  CHECK_MEM_ERROR(cm, cache, aom_malloc(cache_size));
-  dst_buffer = cache;
-#endif
-  CHECK_MEM_ERROR(cm, cache_ptr, aom_malloc(cache_blocks * sizeof(*cache_ptr)));
-  CHECK_MEM_ERROR(cm, cache_dst, aom_malloc(cache_blocks * sizeof(*cache_dst)));
-  memset(cache_ptr, 0, cache_blocks * sizeof(*cache_dst));
-
-  // Iterate over all filter blocks
-  for (k = 0; k < num_fb_ver; k++) {
+  // Iterate over the filter blocks whose rows, and the row below them, are
+  // ready
+  for (k = cp->next_fb_row; k < num_fb_ver; k++) {
+    if (ready_rows < AOMMIN(((k + 1) << fb_size_log2) + 1, height)) break;
     for (l = 0; l < num_fb_hor; l++) {
       int h, w;
       int allskip = !(enable_fb_flag && fb_size_log2 == MAX_FB_SIZE_LOG2);
@@ -140,10 +213,11 @@ void av1_clpf_frame(const YV12_BUFFER_CONFIG *frame,
       if (!allskip &&  // Do not filter the block if all is skip encoded
           (!enable_fb_flag ||
            // Only called if fb_flag enabled (luma only)
-           decision(k, l, frame, org, cm, bs, w / bs, h / bs, strength,
-                    fb_size_log2,
-                    cm->clpf_blocks + yoff / MIN_FB_SIZE * cm->clpf_stride +
-                        xoff / MIN_FB_SIZE))) {
+           cp->decision(
+               k, l, frame, org, cm, bs, w / bs, h / bs, strength,
+               fb_size_log2,
+               cm->clpf_blocks + yoff / MIN_FB_SIZE * cm->clpf_stride +
+                   xoff / MIN_FB_SIZE))) {
         // Iterate over all smaller blocks inside the filter block
         for (m = 0; m < ((h + bs - 1) >> bslog); m++) {
           for (n = 0; n < ((w + bs - 1) >> bslog); n++) {
@@ -221,6 +295,7 @@ void av1_clpf_frame(const YV12_BUFFER_CONFIG *frame,
               dst_buffer = cache_ptr[cache_idx] - ypos * bs - xpos;
 #endif
               cache_dst[cache_idx] = src_buffer + ypos * sstride + xpos;
+              cp->cache_fb_row[cache_idx] = k;
               if (++cache_idx >= cache_blocks) cache_idx = 0;
 
 // Apply the filter
@@ -244,41 +319,57 @@ void av1_clpf_frame(const YV12_BUFFER_CONFIG *frame,
       }
     }
   }
+  cp->next_fb_row = k;
+  cp->cache_idx = cache_idx;
+
+  // The blocks above the last row of filter blocks are no longer read by the
+  // filter, so they can be copied back into the frame.
+  for (c = 0; c < cache_blocks; c++) {
+    if (cache_ptr[c] && cp->cache_fb_row[c] < k - 1)
+      copy_cached_block(cp, cm, c, bs, sstride);
+  }
+  return AOMMAX(k - 1, 0) << fb_size_log2;
+}
+
+void av1_clpf_plane_finish(ClpfPlane *cp, AV1_COMMON *cm) {
+  const int plane = cp->plane;
+  const int bs =
+      plane != AOM_PLANE_Y && (cp->frame->subsampling_x ||
+                               cp->frame->subsampling_y)
+          ? 4
+          : 8;
+  const int sstride =
+      plane != AOM_PLANE_Y ? cp->frame->uv_stride : cp->frame->y_stride;
+  const int width =
+      plane != AOM_PLANE_Y ? cp->frame->uv_crop_width : cp->frame->y_crop_width;
+  const int num_fb_hor =
+      (width + (1 << cp->fb_size_log2) - 1) >> cp->fb_size_log2;
+  const int cache_blocks = (num_fb_hor << (2 * cp->fb_size_log2)) / (bs * bs);
+  int cache_idx;
 
   // Copy remaining blocks into the frame
-  for (cache_idx = 0; cache_idx < cache_blocks && cache_ptr[cache_idx];
-       cache_idx++) {
-#if CONFIG_AOM_HIGHBITDEPTH
-    if (cm->use_highbitdepth) {
-      uint16_t *const d = CONVERT_TO_SHORTPTR(cache_dst[cache_idx]);
-      for (c = 0; c < bs; c++) {
-        *(uint64_t *)(d + c * sstride) =
-            *(uint64_t *)(cache_ptr[cache_idx] + c * bs * 2);
-        if (bs == 8)
-          *(uint64_t *)(d + c * sstride + 4) =
-              *(uint64_t *)(cache_ptr[cache_idx] + c * bs * 2 + 8);
-      }
-    } else {
-      for (c = 0; c < bs; c++)
-        if (bs == 4)
-          *(uint32_t *)(cache_dst[cache_idx] + c * sstride) =
-              *(uint32_t *)(cache_ptr[cache_idx] + c * bs);
-        else
-          *(uint64_t *)(cache_dst[cache_idx] + c * sstride) =
-              *(uint64_t *)(cache_ptr[cache_idx] + c * bs);
-    }
-#else
-    for (c = 0; c < bs; c++)
-      if (bs == 4)
-        *(uint32_t *)(cache_dst[cache_idx] + c * sstride) =
-            *(uint32_t *)(cache_ptr[cache_idx] + c * bs);
-      else
-        *(uint64_t *)(cache_dst[cache_idx] + c * sstride) =
-            *(uint64_t *)(cache_ptr[cache_idx] + c * bs);
-#endif
+  for (cache_idx = 0; cache_idx < cache_blocks; cache_idx++) {
+    if (cp->cache_ptr[cache_idx])
+      copy_cached_block(cp, cm, cache_idx, bs, sstride);
   }
 
-  aom_free(cache);
-  aom_free(cache_ptr);
-  aom_free(cache_dst);
+  aom_free(cp->cache);
+  aom_free(cp->cache_ptr);
+  aom_free(cp->cache_dst);
+  aom_free(cp->cache_fb_row);
+}
+
+void av1_clpf_frame(const YV12_BUFFER_CONFIG *frame,
+                    const YV12_BUFFER_CONFIG *org, AV1_COMMON *cm,
+                    int enable_fb_flag, unsigned int strength,
+                    unsigned int fb_size_log2, int plane,
+                    int (*decision)(int, int, const YV12_BUFFER_CONFIG *,
+                                    const YV12_BUFFER_CONFIG *,
+                                    const AV1_COMMON *cm, int, int, int,
+                                    unsigned int, unsigned int, int8_t *)) {
+  ClpfPlane cp;
+  av1_clpf_plane_init(&cp, frame, org, cm, enable_fb_flag, strength,
+                      fb_size_log2, plane, decision);
+  av1_clpf_plane_rows(&cp, cm, INT_MAX);
+  av1_clpf_plane_finish(&cp, cm);
 }
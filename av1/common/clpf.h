@@ -18,7 +18,47 @@
 #define MAX_FB_SIZE (1 << MAX_FB_SIZE_LOG2)
 #define MIN_FB_SIZE (1 << MIN_FB_SIZE_LOG2)
 
+// A CLPF pass over one plane, which filters the plane a row of filter blocks
+// at a time.
+typedef struct {
+  const YV12_BUFFER_CONFIG *frame;
+  const YV12_BUFFER_CONFIG *org;
+  int enable_fb_flag;
+  unsigned int strength;
+  unsigned int fb_size_log2;
+  int plane;
+  int (*decision)(int, int, const YV12_BUFFER_CONFIG *,
+                  const YV12_BUFFER_CONFIG *, const AV1_COMMON *cm, int, int,
+                  int, unsigned int, unsigned int, int8_t *);
+  // Next row of filter blocks to be filtered.
+  int next_fb_row;
+  // Filtered blocks are kept here until the blocks next to them have been
+  // filtered, and then copied back into the frame.
+  uint8_t *cache;
+  uint8_t **cache_ptr;
+  uint8_t **cache_dst;
+  // The row of filter blocks of each cached block.
+  int *cache_fb_row;
+  int cache_idx;
+} ClpfPlane;
+
 int av1_clpf_sample(int X, int A, int B, int C, int D, int E, int F, int b);
+void av1_clpf_plane_init(ClpfPlane *cp, const YV12_BUFFER_CONFIG *frame,
+                         const YV12_BUFFER_CONFIG *org, AV1_COMMON *cm,
+                         int enable_fb_flag, unsigned int strength,
+                         unsigned int fb_size_log2, int plane,
+                         int (*decision)(int, int, const YV12_BUFFER_CONFIG *,
+                                         const YV12_BUFFER_CONFIG *,
+                                         const AV1_COMMON *cm, int, int, int,
+                                         unsigned int, unsigned int,
+                                         int8_t *));
+// Filters, in order, the rows of filter blocks whose pixels and the row below
+// them are among the first ready_rows rows of the plane, and returns how many
+// rows of the plane are now final. The last row of filter blocks is only
+// final after av1_clpf_plane_finish().
+int av1_clpf_plane_rows(ClpfPlane *cp, AV1_COMMON *cm, int ready_rows);
+// Copies the remaining filtered blocks into the frame and frees the cache.
+void av1_clpf_plane_finish(ClpfPlane *cp, AV1_COMMON *cm);
 void av1_clpf_frame(const YV12_BUFFER_CONFIG *frame,
                     const YV12_BUFFER_CONFIG *org, AV1_COMMON *cm,
                     int enable_fb_flag, unsigned int strength,
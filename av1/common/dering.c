@@ -146,243 +146,256 @@ static void copy_sb8_16(AV1_COMMON *cm, int16_t *dst, int dstride,
   }
 }
 
-void av1_dering_frame(YV12_BUFFER_CONFIG *frame, AV1_COMMON *cm,
-                      MACROBLOCKD *xd, int global_level) {
+// Returns the rows saved around the top of superblock row b: OD_FILT_VBORDER
+// rows of superblock row b - 1 followed by OD_FILT_VBORDER rows of row b.
+static INLINE int16_t *dering_lines(const DeringFrame *df, int pli, int b) {
+  return df->lines[pli] +
+         (b - 1) * 2 * OD_FILT_VBORDER * df->lines_stride[pli];
+}
+
+void av1_dering_frame_init(DeringFrame *df, YV12_BUFFER_CONFIG *frame,
+                           AV1_COMMON *cm, MACROBLOCKD *xd, int global_level) {
+  int pli;
+  if (xd->plane[1].subsampling_x == xd->plane[1].subsampling_y &&
+      xd->plane[2].subsampling_x == xd->plane[2].subsampling_y)
+    df->nplanes = 3;
+  else
+    df->nplanes = 1;
+  df->nvsb = (cm->mi_rows + MAX_MIB_SIZE - 1) / MAX_MIB_SIZE;
+  df->nhsb = (cm->mi_cols + MAX_MIB_SIZE - 1) / MAX_MIB_SIZE;
+  df->global_level = global_level;
+  df->next_sbr = 0;
+  av1_setup_dst_planes(xd->plane, frame, 0, 0);
+  for (pli = 0; pli < df->nplanes; pli++) {
+    df->dec[pli] = xd->plane[pli].subsampling_x;
+    df->bsize[pli] = OD_DERING_SIZE_LOG2 - df->dec[pli];
+    df->buf[pli] = xd->plane[pli].dst.buf;
+    df->buf_stride[pli] = xd->plane[pli].dst.stride;
+    df->height[pli] = pli ? frame->uv_crop_height : frame->y_crop_height;
+    df->lines_stride[pli] = cm->mi_cols << df->bsize[pli];
+    df->lines[pli] = NULL;
+    if (df->nvsb < 2) continue;
+    CHECK_MEM_ERROR(cm, df->lines[pli],
+                    aom_malloc(sizeof(*df->lines[pli]) * (df->nvsb - 1) * 2 *
+                               OD_FILT_VBORDER * df->lines_stride[pli]));
+  }
+}
+
+void av1_dering_save_lines(const DeringFrame *df, AV1_COMMON *cm, int sbr) {
+  int pli;
+  if (sbr <= 0 || sbr >= df->nvsb) return;
+  for (pli = 0; pli < df->nplanes; pli++) {
+    copy_sb8_16(cm, dering_lines(df, pli, sbr), df->lines_stride[pli],
+                df->buf[pli],
+                (MAX_MIB_SIZE << df->bsize[pli]) * sbr - OD_FILT_VBORDER, 0,
+                df->buf_stride[pli], 2 * OD_FILT_VBORDER,
+                df->lines_stride[pli]);
+  }
+}
+
+void av1_dering_frame_free(DeringFrame *df) {
+  int pli;
+  for (pli = 0; pli < df->nplanes; pli++) {
+    aom_free(df->lines[pli]);
+    df->lines[pli] = NULL;
+  }
+}
+
+/* Copies OD_FILT_VBORDER saved rows into the 16-bit block, or fills them with
+   OD_DERING_VERY_LARGE when there is no data. */
+static INLINE void copy_dering_lines(int16_t *dst, const int16_t *lines,
+                                     int lstride, int hsize) {
   int r, c;
-  int sbr, sbc;
-  int nhsb, nvsb;
+  for (r = 0; r < OD_FILT_VBORDER; r++) {
+    for (c = 0; c < hsize; c++) {
+      dst[r * OD_FILT_BSTRIDE + c] =
+          lines ? lines[r * lstride + c] : OD_DERING_VERY_LARGE;
+    }
+  }
+}
+
+void av1_dering_sb_row(const DeringFrame *df, AV1_COMMON *cm, int sbr) {
+  int r, c;
+  int sbc;
+  const int nhsb = df->nhsb, nvsb = df->nvsb;
   int16_t src[OD_DERING_INBUF_SIZE];
-  int16_t *linebuf[3];
   int16_t colbuf[3][OD_BSIZE_MAX + 2 * OD_FILT_VBORDER][OD_FILT_HBORDER];
   dering_list dlist[MAX_MIB_SIZE * MAX_MIB_SIZE];
-  unsigned char *row_dering, *prev_row_dering, *curr_row_dering;
   int dering_count;
   int dir[OD_DERING_NBLOCKS][OD_DERING_NBLOCKS] = { { 0 } };
-  int stride;
-  int bsize[3];
-  int dec[3];
   int pli;
   int dering_left;
   int coeff_shift = AOMMAX(cm->bit_depth - 8, 0);
-  int nplanes;
-  if (xd->plane[1].subsampling_x == xd->plane[1].subsampling_y &&
-      xd->plane[2].subsampling_x == xd->plane[2].subsampling_y)
-    nplanes = 3;
-  else
-    nplanes = 1;
-  nvsb = (cm->mi_rows + MAX_MIB_SIZE - 1) / MAX_MIB_SIZE;
-  nhsb = (cm->mi_cols + MAX_MIB_SIZE - 1) / MAX_MIB_SIZE;
-  av1_setup_dst_planes(xd->plane, frame, 0, 0);
-  row_dering = aom_malloc(sizeof(*row_dering) * nhsb * 2);
-  memset(row_dering, 1, sizeof(*row_dering) * (nhsb + 2) * 2);
-  prev_row_dering = row_dering + 1;
-  curr_row_dering = prev_row_dering + nhsb + 2;
-  for (pli = 0; pli < nplanes; pli++) {
-    dec[pli] = xd->plane[pli].subsampling_x;
-    bsize[pli] = OD_DERING_SIZE_LOG2 - dec[pli];
-  }
-  stride = (cm->mi_cols << bsize[0]) + 2 * OD_FILT_HBORDER;
-  for (pli = 0; pli < nplanes; pli++) {
-    linebuf[pli] = aom_malloc(sizeof(*linebuf) * OD_FILT_VBORDER * stride);
-  }
-  for (sbr = 0; sbr < nvsb; sbr++) {
-    for (pli = 0; pli < nplanes; pli++) {
-      for (r = 0; r < (MAX_MIB_SIZE << bsize[pli]) + 2 * OD_FILT_VBORDER; r++) {
-        for (c = 0; c < OD_FILT_HBORDER; c++) {
-          colbuf[pli][r][c] = OD_DERING_VERY_LARGE;
-        }
+  for (pli = 0; pli < df->nplanes; pli++) {
+    for (r = 0; r < (MAX_MIB_SIZE << df->bsize[pli]) + 2 * OD_FILT_VBORDER;
+         r++) {
+      for (c = 0; c < OD_FILT_HBORDER; c++) {
+        colbuf[pli][r][c] = OD_DERING_VERY_LARGE;
       }
     }
-    dering_left = 1;
-    for (sbc = 0; sbc < nhsb; sbc++) {
-      int level;
-      int nhb, nvb;
-      int cstart = 0;
-      if (!dering_left) cstart = -OD_FILT_HBORDER;
-      nhb = AOMMIN(MAX_MIB_SIZE, cm->mi_cols - MAX_MIB_SIZE * sbc);
-      nvb = AOMMIN(MAX_MIB_SIZE, cm->mi_rows - MAX_MIB_SIZE * sbr);
-      level = compute_level_from_index(
-          global_level, cm->mi_grid_visible[MAX_MIB_SIZE * sbr * cm->mi_stride +
-                                            MAX_MIB_SIZE * sbc]
-                            ->mbmi.dering_gain);
-      curr_row_dering[sbc] = 0;
-      if (level == 0 ||
-          (dering_count = sb_compute_dering_list(
-               cm, sbr * MAX_MIB_SIZE, sbc * MAX_MIB_SIZE, dlist)) == 0) {
-        dering_left = 0;
-        continue;
-      }
-      curr_row_dering[sbc] = 1;
-      for (pli = 0; pli < nplanes; pli++) {
-        int16_t dst[OD_BSIZE_MAX * OD_BSIZE_MAX];
-        int threshold;
-        int coffset;
-        int rend, cend;
-        if (sbc == nhsb - 1)
-          cend = (nhb << bsize[pli]);
-        else
-          cend = (nhb << bsize[pli]) + OD_FILT_HBORDER;
-        if (sbr == nvsb - 1)
-          rend = (nvb << bsize[pli]);
-        else
-          rend = (nvb << bsize[pli]) + OD_FILT_VBORDER;
-        coffset = sbc * MAX_MIB_SIZE << bsize[pli];
-        if (sbc == nhsb - 1) {
-          /* On the last superblock column, fill in the right border with
-             OD_DERING_VERY_LARGE to avoid filtering with the outside. */
-          for (r = 0; r < rend + OD_FILT_VBORDER; r++) {
-            for (c = cend; c < (nhb << bsize[pli]) + OD_FILT_HBORDER; ++c) {
-              src[r * OD_FILT_BSTRIDE + c + OD_FILT_HBORDER] =
-                  OD_DERING_VERY_LARGE;
-            }
-          }
-        }
-        if (sbr == nvsb - 1) {
-          /* On the last superblock row, fill in the bottom border with
-             OD_DERING_VERY_LARGE to avoid filtering with the outside. */
-          for (r = rend; r < rend + OD_FILT_VBORDER; r++) {
-            for (c = 0; c < (nhb << bsize[pli]) + 2 * OD_FILT_HBORDER; c++) {
-              src[(r + OD_FILT_VBORDER) * OD_FILT_BSTRIDE + c] =
-                  OD_DERING_VERY_LARGE;
-            }
-          }
-        }
-        /* Copy in the pixels we need from the current superblock for
-           deringing.*/
-        copy_sb8_16(
-            cm,
-            &src[OD_FILT_VBORDER * OD_FILT_BSTRIDE + OD_FILT_HBORDER + cstart],
-            OD_FILT_BSTRIDE, xd->plane[pli].dst.buf,
-            (MAX_MIB_SIZE << bsize[pli]) * sbr, coffset + cstart,
-            xd->plane[pli].dst.stride, rend, cend - cstart);
-        if (!prev_row_dering[sbc]) {
-          copy_sb8_16(cm, &src[OD_FILT_HBORDER], OD_FILT_BSTRIDE,
-                      xd->plane[pli].dst.buf,
-                      (MAX_MIB_SIZE << bsize[pli]) * sbr - OD_FILT_VBORDER,
-                      coffset, xd->plane[pli].dst.stride, OD_FILT_VBORDER,
-                      nhb << bsize[pli]);
-        } else if (sbr > 0) {
-          for (r = 0; r < OD_FILT_VBORDER; r++) {
-            for (c = 0; c < nhb << bsize[pli]; c++) {
-              src[r * OD_FILT_BSTRIDE + c + OD_FILT_HBORDER] =
-                  linebuf[pli][r * stride + coffset + c];
-            }
-          }
-        } else {
-          for (r = 0; r < OD_FILT_VBORDER; r++) {
-            for (c = 0; c < nhb << bsize[pli]; c++) {
-              src[r * OD_FILT_BSTRIDE + c + OD_FILT_HBORDER] =
-                  OD_DERING_VERY_LARGE;
-            }
-          }
-        }
-        if (!prev_row_dering[sbc - 1]) {
-          copy_sb8_16(cm, src, OD_FILT_BSTRIDE, xd->plane[pli].dst.buf,
-                      (MAX_MIB_SIZE << bsize[pli]) * sbr - OD_FILT_VBORDER,
-                      coffset - OD_FILT_HBORDER, xd->plane[pli].dst.stride,
-                      OD_FILT_VBORDER, OD_FILT_HBORDER);
-        } else if (sbr > 0 && sbc > 0) {
-          for (r = 0; r < OD_FILT_VBORDER; r++) {
-            for (c = -OD_FILT_HBORDER; c < 0; c++) {
-              src[r * OD_FILT_BSTRIDE + c + OD_FILT_HBORDER] =
-                  linebuf[pli][r * stride + coffset + c];
-            }
-          }
-        } else {
-          for (r = 0; r < OD_FILT_VBORDER; r++) {
-            for (c = -OD_FILT_HBORDER; c < 0; c++) {
-              src[r * OD_FILT_BSTRIDE + c + OD_FILT_HBORDER] =
-                  OD_DERING_VERY_LARGE;
-            }
-          }
-        }
-        if (!prev_row_dering[sbc + 1]) {
-          copy_sb8_16(cm, &src[OD_FILT_HBORDER + (nhb << bsize[pli])],
-                      OD_FILT_BSTRIDE, xd->plane[pli].dst.buf,
-                      (MAX_MIB_SIZE << bsize[pli]) * sbr - OD_FILT_VBORDER,
-                      coffset + (nhb << bsize[pli]), xd->plane[pli].dst.stride,
-                      OD_FILT_VBORDER, OD_FILT_HBORDER);
-        } else if (sbr > 0 && sbc < nhsb - 1) {
-          for (r = 0; r < OD_FILT_VBORDER; r++) {
-            for (c = nhb << bsize[pli];
-                 c < (nhb << bsize[pli]) + OD_FILT_HBORDER; c++) {
-              src[r * OD_FILT_BSTRIDE + c + OD_FILT_HBORDER] =
-                  linebuf[pli][r * stride + coffset + c];
-            }
-          }
-        } else {
-          for (r = 0; r < OD_FILT_VBORDER; r++) {
-            for (c = nhb << bsize[pli];
-                 c < (nhb << bsize[pli]) + OD_FILT_HBORDER; c++) {
-              src[r * OD_FILT_BSTRIDE + c + OD_FILT_HBORDER] =
-                  OD_DERING_VERY_LARGE;
-            }
-          }
-        }
-        if (dering_left) {
-          /* If we deringed the superblock on the left then we need to copy in
-             saved pixels. */
-          for (r = 0; r < rend + OD_FILT_VBORDER; r++) {
-            for (c = 0; c < OD_FILT_HBORDER; c++) {
-              src[r * OD_FILT_BSTRIDE + c] = colbuf[pli][r][c];
-            }
+  }
+  dering_left = 1;
+  for (sbc = 0; sbc < nhsb; sbc++) {
+    int level;
+    int nhb, nvb;
+    int cstart = 0;
+    if (!dering_left) cstart = -OD_FILT_HBORDER;
+    nhb = AOMMIN(MAX_MIB_SIZE, cm->mi_cols - MAX_MIB_SIZE * sbc);
+    nvb = AOMMIN(MAX_MIB_SIZE, cm->mi_rows - MAX_MIB_SIZE * sbr);
+    level = compute_level_from_index(
+        df->global_level,
+        cm->mi_grid_visible[MAX_MIB_SIZE * sbr * cm->mi_stride +
+                            MAX_MIB_SIZE * sbc]
+            ->mbmi.dering_gain);
+    if (level == 0 ||
+        (dering_count = sb_compute_dering_list(cm, sbr * MAX_MIB_SIZE,
+                                               sbc * MAX_MIB_SIZE, dlist)) ==
+            0) {
+      dering_left = 0;
+      continue;
+    }
+    for (pli = 0; pli < df->nplanes; pli++) {
+      int16_t dst[OD_BSIZE_MAX * OD_BSIZE_MAX];
+      const int bsize = df->bsize[pli];
+      const int16_t *above =
+          sbr > 0 ? dering_lines(df, pli, sbr) : NULL;
+      const int16_t *below =
+          sbr < nvsb - 1
+              ? dering_lines(df, pli, sbr + 1) +
+                    OD_FILT_VBORDER * df->lines_stride[pli]
+              : NULL;
+      int threshold;
+      int coffset;
+      int rend, cend;
+      if (sbc == nhsb - 1)
+        cend = (nhb << bsize);
+      else
+        cend = (nhb << bsize) + OD_FILT_HBORDER;
+      rend = (nvb << bsize);
+      coffset = sbc * MAX_MIB_SIZE << bsize;
+      if (sbc == nhsb - 1) {
+        /* On the last superblock column, fill in the right border with
+           OD_DERING_VERY_LARGE to avoid filtering with the outside. */
+        for (r = 0; r < rend + 2 * OD_FILT_VBORDER; r++) {
+          for (c = cend; c < (nhb << bsize) + OD_FILT_HBORDER; ++c) {
+            src[r * OD_FILT_BSTRIDE + c + OD_FILT_HBORDER] =
+                OD_DERING_VERY_LARGE;
           }
         }
-        for (r = 0; r < rend + OD_FILT_VBORDER; r++) {
+      }
+      /* Copy in the pixels we need from the current superblock for
+         deringing. The rows below it come from the saved lines, as the
+         superblock row below may already have been deringed. On the last
+         superblock row they are filled with OD_DERING_VERY_LARGE to avoid
+         filtering with the outside. */
+      copy_sb8_16(
+          cm,
+          &src[OD_FILT_VBORDER * OD_FILT_BSTRIDE + OD_FILT_HBORDER + cstart],
+          OD_FILT_BSTRIDE, df->buf[pli], (MAX_MIB_SIZE << bsize) * sbr,
+          coffset + cstart, df->buf_stride[pli], rend, cend - cstart);
+      if (below) {
+        copy_dering_lines(&src[(OD_FILT_VBORDER + rend) * OD_FILT_BSTRIDE +
+                               OD_FILT_HBORDER + cstart],
+                          below + coffset + cstart, df->lines_stride[pli],
+                          cend - cstart);
+      } else {
+        copy_dering_lines(
+            &src[(OD_FILT_VBORDER + rend) * OD_FILT_BSTRIDE],
+            NULL, 0, (nhb << bsize) + 2 * OD_FILT_HBORDER);
+      }
+      /* Rows above, with the corners. */
+      copy_dering_lines(&src[OD_FILT_HBORDER], above ? above + coffset : NULL,
+                        df->lines_stride[pli], nhb << bsize);
+      copy_dering_lines(
+          src, above && sbc > 0 ? above + coffset - OD_FILT_HBORDER : NULL,
+          df->lines_stride[pli], OD_FILT_HBORDER);
+      copy_dering_lines(
+          &src[OD_FILT_HBORDER + (nhb << bsize)],
+          above && sbc < nhsb - 1 ? above + coffset + (nhb << bsize) : NULL,
+          df->lines_stride[pli], OD_FILT_HBORDER);
+      if (dering_left) {
+        /* If we deringed the superblock on the left then we need to copy in
+           saved pixels. */
+        for (r = 0; r < rend + 2 * OD_FILT_VBORDER; r++) {
           for (c = 0; c < OD_FILT_HBORDER; c++) {
-            /* Saving pixels in case we need to dering the superblock on the
-               right. */
-            colbuf[pli][r][c] =
-                src[r * OD_FILT_BSTRIDE + c + (nhb << bsize[pli])];
+            src[r * OD_FILT_BSTRIDE + c] = colbuf[pli][r][c];
           }
         }
-        copy_sb8_16(cm, &linebuf[pli][coffset], stride, xd->plane[pli].dst.buf,
-                    (MAX_MIB_SIZE << bsize[pli]) * (sbr + 1) - OD_FILT_VBORDER,
-                    coffset, xd->plane[pli].dst.stride, OD_FILT_VBORDER,
-                    (nhb << bsize[pli]));
+      }
+      for (r = 0; r < rend + 2 * OD_FILT_VBORDER; r++) {
+        for (c = 0; c < OD_FILT_HBORDER; c++) {
+          /* Saving pixels in case we need to dering the superblock on the
+             right. */
+          colbuf[pli][r][c] = src[r * OD_FILT_BSTRIDE + c + (nhb << bsize)];
+        }
+      }
 
-        /* FIXME: This is a temporary hack that uses more conservative
-           deringing for chroma. */
-        if (pli)
-          threshold = (level * 5 + 4) >> 3 << coeff_shift;
-        else
-          threshold = level << coeff_shift;
-        if (threshold == 0) continue;
-        od_dering(
-            dst, &src[OD_FILT_VBORDER * OD_FILT_BSTRIDE + OD_FILT_HBORDER],
-            dec[pli], dir, pli, dlist, dering_count, threshold, coeff_shift);
+      /* FIXME: This is a temporary hack that uses more conservative
+         deringing for chroma. */
+      if (pli)
+        threshold = (level * 5 + 4) >> 3 << coeff_shift;
+      else
+        threshold = level << coeff_shift;
+      if (threshold == 0) continue;
+      od_dering(dst,
+                &src[OD_FILT_VBORDER * OD_FILT_BSTRIDE + OD_FILT_HBORDER],
+                df->dec[pli], dir, pli, dlist, dering_count, threshold,
+                coeff_shift);
 #if CONFIG_AOM_HIGHBITDEPTH
-        if (cm->use_highbitdepth) {
-          copy_dering_16bit_to_16bit(
-              (int16_t *)&CONVERT_TO_SHORTPTR(
-                  xd->plane[pli]
-                      .dst.buf)[xd->plane[pli].dst.stride *
-                                    (MAX_MIB_SIZE * sbr << bsize[pli]) +
-                                (sbc * MAX_MIB_SIZE << bsize[pli])],
-              xd->plane[pli].dst.stride, dst, dlist, dering_count,
-              3 - dec[pli]);
-        } else {
+      if (cm->use_highbitdepth) {
+        copy_dering_16bit_to_16bit(
+            (int16_t *)&CONVERT_TO_SHORTPTR(
+                df->buf[pli])[df->buf_stride[pli] *
+                                  (MAX_MIB_SIZE * sbr << bsize) +
+                              (sbc * MAX_MIB_SIZE << bsize)],
+            df->buf_stride[pli], dst, dlist, dering_count, 3 - df->dec[pli]);
+      } else {
 #endif
-          copy_dering_16bit_to_8bit(
-              &xd->plane[pli].dst.buf[xd->plane[pli].dst.stride *
-                                          (MAX_MIB_SIZE * sbr << bsize[pli]) +
-                                      (sbc * MAX_MIB_SIZE << bsize[pli])],
-              xd->plane[pli].dst.stride, dst, dlist, dering_count, bsize[pli]);
+        copy_dering_16bit_to_8bit(
+            &df->buf[pli][df->buf_stride[pli] * (MAX_MIB_SIZE * sbr << bsize) +
+                          (sbc * MAX_MIB_SIZE << bsize)],
+            df->buf_stride[pli], dst, dlist, dering_count, bsize);
 #if CONFIG_AOM_HIGHBITDEPTH
-        }
-#endif
       }
-      dering_left = 1;
+#endif
     }
-    {
-      unsigned char *tmp;
-      tmp = prev_row_dering;
-      prev_row_dering = curr_row_dering;
-      curr_row_dering = tmp;
+    dering_left = 1;
+  }
+}
+
+void av1_dering_rows(DeringFrame *df, AV1_COMMON *cm, const int *ready_rows,
+                     int *done_rows) {
+  int pli;
+  for (; df->next_sbr < df->nvsb; df->next_sbr++) {
+    for (pli = 0; pli < df->nplanes; pli++) {
+      const int end = (MAX_MIB_SIZE << df->bsize[pli]) * (df->next_sbr + 1);
+      if (ready_rows[pli] < AOMMIN(end + OD_FILT_VBORDER, df->height[pli]))
+        break;
     }
+    if (pli < df->nplanes) break;
+    /* The rows around the top of the superblock row below can only change
+       once this one has been deringed. */
+    av1_dering_save_lines(df, cm, df->next_sbr + 1);
+    av1_dering_sb_row(df, cm, df->next_sbr);
+  }
+  for (pli = 0; pli < MAX_MB_PLANE; pli++) {
+    if (pli >= df->nplanes)
+      done_rows[pli] = ready_rows[pli];
+    else if (df->next_sbr == df->nvsb)
+      done_rows[pli] = df->height[pli];
+    else
+      done_rows[pli] = (MAX_MIB_SIZE << df->bsize[pli]) * df->next_sbr;
   }
-  aom_free(row_dering);
-  for (pli = 0; pli < nplanes; pli++) {
-    aom_free(linebuf[pli]);
+}
+
+void av1_dering_frame(YV12_BUFFER_CONFIG *frame, AV1_COMMON *cm,
+                      MACROBLOCKD *xd, int global_level) {
+  DeringFrame df;
+  int sbr;
+  av1_dering_frame_init(&df, frame, cm, xd, global_level);
+  for (sbr = 0; sbr < df.nvsb; sbr++) {
+    av1_dering_save_lines(&df, cm, sbr + 1);
+    av1_dering_sb_row(&df, cm, sbr);
   }
+  av1_dering_frame_free(&df);
 }
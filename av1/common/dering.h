@@ -28,15 +28,46 @@ extern "C" {
 #define DERING_REFINEMENT_BITS 2
 #define DERING_REFINEMENT_LEVELS 4
 
+// State shared by the superblock rows of a deringing pass over a frame.
+typedef struct {
+  uint8_t *buf[3];
+  int buf_stride[3];
+  int dec[3];
+  int bsize[3];
+  int nplanes;
+  int nvsb;
+  int nhsb;
+  int global_level;
+  // Height of each plane in pixels.
+  int height[3];
+  // The OD_FILT_VBORDER rows on either side of each superblock row boundary,
+  // saved before any deringing so that the rows can be filtered in any order.
+  int16_t *lines[3];
+  int lines_stride[3];
+  // Next superblock row to be deringed by av1_dering_rows().
+  int next_sbr;
+} DeringFrame;
+
 int compute_level_from_index(int global_level, int gi);
 int sb_all_skip(const AV1_COMMON *const cm, int mi_row, int mi_col);
 int sb_compute_dering_list(const AV1_COMMON *const cm, int mi_row, int mi_col,
                            dering_list *dlist);
 void av1_dering_frame(YV12_BUFFER_CONFIG *frame, AV1_COMMON *cm,
                       MACROBLOCKD *xd, int global_level);
-
-int av1_dering_search(YV12_BUFFER_CONFIG *frame, const YV12_BUFFER_CONFIG *ref,
-                      AV1_COMMON *cm, MACROBLOCKD *xd);
+// Sets up deringing of the frame. Once the rows around the top of every
+// superblock row have been saved with av1_dering_save_lines(), the superblock
+// rows can be deringed by av1_dering_sb_row() in any order, or concurrently.
+void av1_dering_frame_init(DeringFrame *df, YV12_BUFFER_CONFIG *frame,
+                           AV1_COMMON *cm, MACROBLOCKD *xd, int global_level);
+void av1_dering_save_lines(const DeringFrame *df, AV1_COMMON *cm, int sbr);
+void av1_dering_sb_row(const DeringFrame *df, AV1_COMMON *cm, int sbr);
+// Deringes, in order, the superblock rows whose pixels and the
+// OD_FILT_VBORDER rows below them are among the first ready_rows[pli] rows of
+// each plane. Sets done_rows[pli] to the number of rows of each of the
+// MAX_MB_PLANE planes that are final.
+void av1_dering_rows(DeringFrame *df, AV1_COMMON *cm, const int *ready_rows,
+                     int *done_rows);
+void av1_dering_frame_free(DeringFrame *df);
 
 #ifdef __cplusplus
 }  // extern "C"
@@ -292,10 +292,26 @@ void copy_dering_16bit_to_16bit(int16_t *dst, int dstride, int16_t *src,
   }
 }
 
-void od_dering(int16_t *y, int16_t *in, int xdec,
-               int dir[OD_DERING_NBLOCKS][OD_DERING_NBLOCKS], int pli,
-               dering_list *dlist, int dering_count, int threshold,
-               int coeff_shift) {
+void od_dering_find_dirs(const int16_t *in,
+                         int dir[OD_DERING_NBLOCKS][OD_DERING_NBLOCKS],
+                         int32_t var[OD_DERING_NBLOCKS][OD_DERING_NBLOCKS],
+                         const dering_list *dlist, int dering_count,
+                         int coeff_shift) {
+  int bi;
+  int bx;
+  int by;
+  for (bi = 0; bi < dering_count; bi++) {
+    by = dlist[bi].by;
+    bx = dlist[bi].bx;
+    dir[by][bx] = od_dir_find8(&in[8 * by * OD_FILT_BSTRIDE + 8 * bx],
+                               OD_FILT_BSTRIDE, &var[by][bx], coeff_shift);
+  }
+}
+
+void od_dering_filter(int16_t *y, int16_t *in, int xdec,
+                      int dir[OD_DERING_NBLOCKS][OD_DERING_NBLOCKS],
+                      int32_t var[OD_DERING_NBLOCKS][OD_DERING_NBLOCKS],
+                      dering_list *dlist, int dering_count, int threshold) {
   int bi;
   int bx;
   int by;
@@ -308,35 +324,22 @@ void od_dering(int16_t *y, int16_t *in, int xdec,
     od_filter_dering_orthogonal_4x4, od_filter_dering_orthogonal_8x8
   };
   bsize = OD_DERING_SIZE_LOG2 - xdec;
-  if (pli == 0) {
-    for (bi = 0; bi < dering_count; bi++) {
-      int32_t var;
-      by = dlist[bi].by;
-      bx = dlist[bi].bx;
-      dir[by][bx] = od_dir_find8(&in[8 * by * OD_FILT_BSTRIDE + 8 * bx],
-                                 OD_FILT_BSTRIDE, &var, coeff_shift);
-      /* Deringing orthogonal to the direction uses a tighter threshold
-         because we want to be conservative. We've presumably already
-         achieved some deringing, so the amount of change is expected
-         to be low. Also, since we might be filtering across an edge, we
-         want to make sure not to blur it. That being said, we might want
-         to be a little bit more aggressive on pure horizontal/vertical
-         since the ringing there tends to be directional, so it doesn't
-         get removed by the directional filtering. */
-      filter2_thresh[by][bx] = (filter_dering_direction[bsize - OD_LOG_BSIZE0])(
-          &y[bi << 2 * bsize], 1 << bsize,
-          &in[(by * OD_FILT_BSTRIDE << bsize) + (bx << bsize)],
-          od_adjust_thresh(threshold, var), dir[by][bx]);
-    }
-  } else {
-    for (bi = 0; bi < dering_count; bi++) {
-      by = dlist[bi].by;
-      bx = dlist[bi].bx;
-      filter2_thresh[by][bx] = (filter_dering_direction[bsize - OD_LOG_BSIZE0])(
-          &y[bi << 2 * bsize], 1 << bsize,
-          &in[(by * OD_FILT_BSTRIDE << bsize) + (bx << bsize)], threshold,
-          dir[by][bx]);
-    }
+  for (bi = 0; bi < dering_count; bi++) {
+    by = dlist[bi].by;
+    bx = dlist[bi].bx;
+    /* Deringing orthogonal to the direction uses a tighter threshold
+       because we want to be conservative. We've presumably already
+       achieved some deringing, so the amount of change is expected
+       to be low. Also, since we might be filtering across an edge, we
+       want to make sure not to blur it. That being said, we might want
+       to be a little bit more aggressive on pure horizontal/vertical
+       since the ringing there tends to be directional, so it doesn't
+       get removed by the directional filtering. */
+    filter2_thresh[by][bx] = (filter_dering_direction[bsize - OD_LOG_BSIZE0])(
+        &y[bi << 2 * bsize], 1 << bsize,
+        &in[(by * OD_FILT_BSTRIDE << bsize) + (bx << bsize)],
+        var ? od_adjust_thresh(threshold, var[by][bx]) : threshold,
+        dir[by][bx]);
   }
   copy_dering_16bit_to_16bit(in, OD_FILT_BSTRIDE, y, dlist, dering_count,
                              bsize);
@@ -350,3 +353,16 @@ void od_dering(int16_t *y, int16_t *in, int xdec,
         filter2_thresh[by][bx], dir[by][bx]);
   }
 }
+
+void od_dering(int16_t *y, int16_t *in, int xdec,
+               int dir[OD_DERING_NBLOCKS][OD_DERING_NBLOCKS], int pli,
+               dering_list *dlist, int dering_count, int threshold,
+               int coeff_shift) {
+  int32_t var[OD_DERING_NBLOCKS][OD_DERING_NBLOCKS];
+  if (pli == 0) {
+    od_dering_find_dirs(in, dir, var, dlist, dering_count, coeff_shift);
+    od_dering_filter(y, in, xdec, dir, var, dlist, dering_count, threshold);
+  } else {
+    od_dering_filter(y, in, xdec, dir, NULL, dlist, dering_count, threshold);
+  }
+}
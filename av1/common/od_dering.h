@@ -52,6 +52,19 @@ void od_dering(int16_t *y, int16_t *in, int xdec,
                int dir[OD_DERING_NBLOCKS][OD_DERING_NBLOCKS], int pli,
                dering_list *dlist, int skip_stride, int threshold,
                int coeff_shift);
+/* The two halves of od_dering() on luma, so that the directions, which do
+   not depend on the threshold, can be found once for several thresholds.
+   With var NULL, the threshold is not adjusted to the variance, as for
+   chroma. */
+void od_dering_find_dirs(const int16_t *in,
+                         int dir[OD_DERING_NBLOCKS][OD_DERING_NBLOCKS],
+                         int32_t var[OD_DERING_NBLOCKS][OD_DERING_NBLOCKS],
+                         const dering_list *dlist, int dering_count,
+                         int coeff_shift);
+void od_dering_filter(int16_t *y, int16_t *in, int xdec,
+                      int dir[OD_DERING_NBLOCKS][OD_DERING_NBLOCKS],
+                      int32_t var[OD_DERING_NBLOCKS][OD_DERING_NBLOCKS],
+                      dering_list *dlist, int dering_count, int threshold);
 int od_filter_dering_direction_4x4_c(int16_t *y, int ystride, const int16_t *in,
                                      int threshold, int dir);
 int od_filter_dering_direction_8x8_c(int16_t *y, int ystride, const int16_t *in,
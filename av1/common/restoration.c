@@ -14,6 +14,7 @@
 
 #include "./aom_config.h"
 #include "./aom_dsp_rtcd.h"
+#include "./av1_rtcd.h"
 #include "av1/common/onyxc_int.h"
 #include "av1/common/restoration.h"
 #include "aom_dsp/aom_dsp_common.h"
@@ -70,16 +71,6 @@ const sgr_params_type sgr_params[SGRPROJ_PARAMS] = {
   { 2, 49, 1, 13 }, { 2, 54, 1, 14 }, { 2, 60, 1, 15 }, { 2, 68, 1, 15 },
 };
 
-typedef void (*restore_func_type)(uint8_t *data8, int width, int height,
-                                  int stride, RestorationInternal *rst,
-                                  uint8_t *tmpdata8, int tmpstride);
-#if CONFIG_AOM_HIGHBITDEPTH
-typedef void (*restore_func_highbd_type)(uint8_t *data8, int width, int height,
-                                         int stride, RestorationInternal *rst,
-                                         uint8_t *tmpdata8, int tmpstride,
-                                         int bit_depth);
-#endif  // CONFIG_AOM_HIGHBITDEPTH
-
 static INLINE BilateralParamsType av1_bilateral_level_to_params(int index,
                                                                 int kf) {
   return kf ? bilateral_level_to_params_arr_kf[index]
@@ -179,9 +170,21 @@ int av1_bilateral_level_bits(const AV1_COMMON *const cm) {
                                      : BILATERAL_LEVEL_BITS;
 }
 
+void av1_wiener_set_taps(WienerInfo *wiener_info) {
+  int i;
+  wiener_info->vfilter[RESTORATION_HALFWIN] =
+      wiener_info->hfilter[RESTORATION_HALFWIN] = RESTORATION_FILT_STEP;
+  for (i = 0; i < RESTORATION_HALFWIN; ++i) {
+    wiener_info->vfilter[RESTORATION_WIN - 1 - i] = wiener_info->vfilter[i];
+    wiener_info->hfilter[RESTORATION_WIN - 1 - i] = wiener_info->hfilter[i];
+    wiener_info->vfilter[RESTORATION_HALFWIN] -= 2 * wiener_info->vfilter[i];
+    wiener_info->hfilter[RESTORATION_HALFWIN] -= 2 * wiener_info->hfilter[i];
+  }
+}
+
 void av1_loop_restoration_init(RestorationInternal *rst, RestorationInfo *rsi,
                                int kf, int width, int height) {
-  int i, tile_idx;
+  int tile_idx;
   rst->rsi = rsi;
   rst->keyframe = kf;
   rst->subsampling_x = 0;
@@ -192,37 +195,13 @@ void av1_loop_restoration_init(RestorationInternal *rst, RestorationInfo *rsi,
   if (rsi->frame_restoration_type == RESTORE_WIENER) {
     for (tile_idx = 0; tile_idx < rst->ntiles; ++tile_idx) {
       if (rsi->wiener_info[tile_idx].level) {
-        rsi->wiener_info[tile_idx].vfilter[RESTORATION_HALFWIN] =
-            rsi->wiener_info[tile_idx].hfilter[RESTORATION_HALFWIN] =
-                RESTORATION_FILT_STEP;
-        for (i = 0; i < RESTORATION_HALFWIN; ++i) {
-          rsi->wiener_info[tile_idx].vfilter[RESTORATION_WIN - 1 - i] =
-              rsi->wiener_info[tile_idx].vfilter[i];
-          rsi->wiener_info[tile_idx].hfilter[RESTORATION_WIN - 1 - i] =
-              rsi->wiener_info[tile_idx].hfilter[i];
-          rsi->wiener_info[tile_idx].vfilter[RESTORATION_HALFWIN] -=
-              2 * rsi->wiener_info[tile_idx].vfilter[i];
-          rsi->wiener_info[tile_idx].hfilter[RESTORATION_HALFWIN] -=
-              2 * rsi->wiener_info[tile_idx].hfilter[i];
-        }
+        av1_wiener_set_taps(&rsi->wiener_info[tile_idx]);
       }
     }
   } else if (rsi->frame_restoration_type == RESTORE_SWITCHABLE) {
     for (tile_idx = 0; tile_idx < rst->ntiles; ++tile_idx) {
       if (rsi->restoration_type[tile_idx] == RESTORE_WIENER) {
-        rsi->wiener_info[tile_idx].vfilter[RESTORATION_HALFWIN] =
-            rsi->wiener_info[tile_idx].hfilter[RESTORATION_HALFWIN] =
-                RESTORATION_FILT_STEP;
-        for (i = 0; i < RESTORATION_HALFWIN; ++i) {
-          rsi->wiener_info[tile_idx].vfilter[RESTORATION_WIN - 1 - i] =
-              rsi->wiener_info[tile_idx].vfilter[i];
-          rsi->wiener_info[tile_idx].hfilter[RESTORATION_WIN - 1 - i] =
-              rsi->wiener_info[tile_idx].hfilter[i];
-          rsi->wiener_info[tile_idx].vfilter[RESTORATION_HALFWIN] -=
-              2 * rsi->wiener_info[tile_idx].vfilter[i];
-          rsi->wiener_info[tile_idx].hfilter[RESTORATION_HALFWIN] -=
-              2 * rsi->wiener_info[tile_idx].hfilter[i];
-        }
+        av1_wiener_set_taps(&rsi->wiener_info[tile_idx]);
       }
     }
   }
@@ -287,17 +266,7 @@ static void loop_bilateral_filter_tile(uint8_t *data, int tile_idx, int width,
   }
 }
 
-static void loop_bilateral_filter(uint8_t *data, int width, int height,
-                                  int stride, RestorationInternal *rst,
-                                  uint8_t *tmpdata, int tmpstride) {
-  int tile_idx;
-  for (tile_idx = 0; tile_idx < rst->ntiles; ++tile_idx) {
-    loop_bilateral_filter_tile(data, tile_idx, width, height, stride, rst,
-                               tmpdata, tmpstride);
-  }
-}
-
-uint8_t hor_sym_filter(uint8_t *d, int *hfilter) {
+static INLINE uint8_t hor_sym_filter(const uint8_t *d, const int *hfilter) {
   int32_t s =
       (1 << (RESTORATION_FILT_BITS - 1)) + d[0] * hfilter[RESTORATION_HALFWIN];
   int i;
@@ -306,7 +275,8 @@ uint8_t hor_sym_filter(uint8_t *d, int *hfilter) {
   return clip_pixel(s >> RESTORATION_FILT_BITS);
 }
 
-uint8_t ver_sym_filter(uint8_t *d, int stride, int *vfilter) {
+static INLINE uint8_t ver_sym_filter(const uint8_t *d, int stride,
+                                     const int *vfilter) {
   int32_t s =
       (1 << (RESTORATION_FILT_BITS - 1)) + d[0] * vfilter[RESTORATION_HALFWIN];
   int i;
@@ -315,146 +285,92 @@ uint8_t ver_sym_filter(uint8_t *d, int stride, int *vfilter) {
   return clip_pixel(s >> RESTORATION_FILT_BITS);
 }
 
+void av1_wiener_filter_hor_c(const uint8_t *src, int src_stride, uint8_t *dst,
+                             int dst_stride, int w, int h,
+                             const int *hfilter) {
+  int i, j;
+  for (i = 0; i < h; ++i) {
+    for (j = 0; j < w; ++j) dst[j] = hor_sym_filter(src + j, hfilter);
+    src += src_stride;
+    dst += dst_stride;
+  }
+}
+
+void av1_wiener_filter_ver_c(const uint8_t *src, int src_stride, uint8_t *dst,
+                             int dst_stride, int w, int h,
+                             const int *vfilter) {
+  int i, j;
+  for (i = 0; i < h; ++i) {
+    for (j = 0; j < w; ++j)
+      dst[j] = ver_sym_filter(src + j, src_stride, vfilter);
+    src += src_stride;
+    dst += dst_stride;
+  }
+}
+
 static void loop_wiener_filter_tile(uint8_t *data, int tile_idx, int width,
                                     int height, int stride,
                                     RestorationInternal *rst, uint8_t *tmpdata,
                                     int tmpstride) {
   const int tile_width = rst->tile_width >> rst->subsampling_x;
   const int tile_height = rst->tile_height >> rst->subsampling_y;
-  int i, j;
   int h_start, h_end, v_start, v_end;
-  uint8_t *data_p, *tmpdata_p;
 
   if (rst->rsi->wiener_info[tile_idx].level == 0) return;
   // Filter row-wise
   av1_get_rest_tile_limits(tile_idx, 0, 0, rst->nhtiles, rst->nvtiles,
                            tile_width, tile_height, width, height, 1, 0,
                            &h_start, &h_end, &v_start, &v_end);
-  data_p = data + h_start + v_start * stride;
-  tmpdata_p = tmpdata + h_start + v_start * tmpstride;
-  for (i = 0; i < (v_end - v_start); ++i) {
-    for (j = 0; j < (h_end - h_start); ++j) {
-      *tmpdata_p++ =
-          hor_sym_filter(data_p++, rst->rsi->wiener_info[tile_idx].hfilter);
-    }
-    data_p += stride - (h_end - h_start);
-    tmpdata_p += tmpstride - (h_end - h_start);
-  }
+  av1_wiener_filter_hor(data + h_start + v_start * stride, stride,
+                        tmpdata + h_start + v_start * tmpstride, tmpstride,
+                        h_end - h_start, v_end - v_start,
+                        rst->rsi->wiener_info[tile_idx].hfilter);
   // Filter col-wise
   av1_get_rest_tile_limits(tile_idx, 0, 0, rst->nhtiles, rst->nvtiles,
                            tile_width, tile_height, width, height, 0, 1,
                            &h_start, &h_end, &v_start, &v_end);
-  data_p = data + h_start + v_start * stride;
-  tmpdata_p = tmpdata + h_start + v_start * tmpstride;
-  for (i = 0; i < (v_end - v_start); ++i) {
-    for (j = 0; j < (h_end - h_start); ++j) {
-      *data_p++ = ver_sym_filter(tmpdata_p++, tmpstride,
-                                 rst->rsi->wiener_info[tile_idx].vfilter);
-    }
-    data_p += stride - (h_end - h_start);
-    tmpdata_p += tmpstride - (h_end - h_start);
-  }
-}
-
-static void loop_wiener_filter(uint8_t *data, int width, int height, int stride,
-                               RestorationInternal *rst, uint8_t *tmpdata,
-                               int tmpstride) {
-  int tile_idx;
-  int i;
-  uint8_t *data_p, *tmpdata_p;
-  // Initialize tmp buffer
-  data_p = data;
-  tmpdata_p = tmpdata;
-  for (i = 0; i < height; ++i) {
-    memcpy(tmpdata_p, data_p, sizeof(*data_p) * width);
-    data_p += stride;
-    tmpdata_p += tmpstride;
-  }
-  for (tile_idx = 0; tile_idx < rst->ntiles; ++tile_idx) {
-    loop_wiener_filter_tile(data, tile_idx, width, height, stride, rst, tmpdata,
-                            tmpstride);
-  }
+  av1_wiener_filter_ver(tmpdata + h_start + v_start * tmpstride, tmpstride,
+                        data + h_start + v_start * stride, stride,
+                        h_end - h_start, v_end - v_start,
+                        rst->rsi->wiener_info[tile_idx].vfilter);
 }
 
-static void boxsum(int64_t *src, int width, int height, int src_stride, int r,
-                   int sqr, int64_t *dst, int dst_stride, int64_t *tmp,
-                   int tmp_stride) {
+void av1_integral_images(const int32_t *src, int width, int height, int stride,
+                         uint32_t *sum, uint32_t *sumsq, int sum_stride) {
+  const int ii_width = width + 2 * SGRPROJ_BORDER + 1;
   int i, j;
 
-  if (sqr) {
-    for (j = 0; j < width; ++j) tmp[j] = src[j] * src[j];
-    for (j = 0; j < width; ++j)
-      for (i = 1; i < height; ++i)
-        tmp[i * tmp_stride + j] =
-            tmp[(i - 1) * tmp_stride + j] +
-            src[i * src_stride + j] * src[i * src_stride + j];
-  } else {
-    memcpy(tmp, src, sizeof(*tmp) * width);
-    for (j = 0; j < width; ++j)
-      for (i = 1; i < height; ++i)
-        tmp[i * tmp_stride + j] =
-            tmp[(i - 1) * tmp_stride + j] + src[i * src_stride + j];
-  }
-  for (i = 0; i <= r; ++i)
-    memcpy(&dst[i * dst_stride], &tmp[(i + r) * tmp_stride],
-           sizeof(*tmp) * width);
-  for (i = r + 1; i < height - r; ++i)
-    for (j = 0; j < width; ++j)
-      dst[i * dst_stride + j] =
-          tmp[(i + r) * tmp_stride + j] - tmp[(i - r - 1) * tmp_stride + j];
-  for (i = height - r; i < height; ++i)
-    for (j = 0; j < width; ++j)
-      dst[i * dst_stride + j] = tmp[(height - 1) * tmp_stride + j] -
-                                tmp[(i - r - 1) * tmp_stride + j];
-
-  for (i = 0; i < height; ++i) tmp[i * tmp_stride] = dst[i * dst_stride];
-  for (i = 0; i < height; ++i)
-    for (j = 1; j < width; ++j)
-      tmp[i * tmp_stride + j] =
-          tmp[i * tmp_stride + j - 1] + dst[i * src_stride + j];
-
-  for (j = 0; j <= r; ++j)
-    for (i = 0; i < height; ++i)
-      dst[i * dst_stride + j] = tmp[i * tmp_stride + j + r];
-  for (j = r + 1; j < width - r; ++j)
-    for (i = 0; i < height; ++i)
-      dst[i * dst_stride + j] =
-          tmp[i * tmp_stride + j + r] - tmp[i * tmp_stride + j - r - 1];
-  for (j = width - r; j < width; ++j)
-    for (i = 0; i < height; ++i)
-      dst[i * dst_stride + j] =
-          tmp[i * tmp_stride + width - 1] - tmp[i * tmp_stride + j - r - 1];
-}
-
-static void boxnum(int width, int height, int r, int8_t *num, int num_stride) {
-  int i, j;
-  for (i = 0; i <= r; ++i) {
-    for (j = 0; j <= r; ++j) {
-      num[i * num_stride + j] = (r + 1 + i) * (r + 1 + j);
-      num[i * num_stride + (width - 1 - j)] = num[i * num_stride + j];
-      num[(height - 1 - i) * num_stride + j] = num[i * num_stride + j];
-      num[(height - 1 - i) * num_stride + (width - 1 - j)] =
-          num[i * num_stride + j];
-    }
+  // Rows above the tile sum to zero
+  for (i = 0; i <= SGRPROJ_BORDER; ++i) {
+    memset(sum + i * sum_stride, 0, sizeof(*sum) * ii_width);
+    memset(sumsq + i * sum_stride, 0, sizeof(*sumsq) * ii_width);
   }
-  for (j = 0; j <= r; ++j) {
-    const int val = (2 * r + 1) * (r + 1 + j);
-    for (i = r + 1; i < height - r; ++i) {
-      num[i * num_stride + j] = val;
-      num[i * num_stride + (width - 1 - j)] = val;
+  for (i = 0; i < height; ++i) {
+    const int32_t *s = src + i * stride;
+    uint32_t *c = sum + (i + SGRPROJ_BORDER + 1) * sum_stride;
+    uint32_t *c2 = sumsq + (i + SGRPROJ_BORDER + 1) * sum_stride;
+    uint32_t row = 0, row2 = 0;
+    for (j = 0; j <= SGRPROJ_BORDER; ++j) c[j] = c2[j] = 0;
+    for (j = 0; j < width; ++j) {
+      row += s[j];
+      row2 += s[j] * s[j];
+      c[j + SGRPROJ_BORDER + 1] = c[j + SGRPROJ_BORDER + 1 - sum_stride] + row;
+      c2[j + SGRPROJ_BORDER + 1] =
+          c2[j + SGRPROJ_BORDER + 1 - sum_stride] + row2;
     }
-  }
-  for (i = 0; i <= r; ++i) {
-    const int val = (2 * r + 1) * (r + 1 + i);
-    for (j = r + 1; j < width - r; ++j) {
-      num[i * num_stride + j] = val;
-      num[(height - 1 - i) * num_stride + j] = val;
+    for (j = width + SGRPROJ_BORDER + 1; j < ii_width; ++j) {
+      c[j] = c[width + SGRPROJ_BORDER];
+      c2[j] = c2[width + SGRPROJ_BORDER];
     }
   }
-  for (i = r + 1; i < height - r; ++i) {
-    for (j = r + 1; j < width - r; ++j) {
-      num[i * num_stride + j] = (2 * r + 1) * (2 * r + 1);
-    }
+  // Rows below the tile repeat the last one
+  for (i = height + SGRPROJ_BORDER + 1; i < height + 2 * SGRPROJ_BORDER + 1;
+       ++i) {
+    memcpy(sum + i * sum_stride, sum + (height + SGRPROJ_BORDER) * sum_stride,
+           sizeof(*sum) * ii_width);
+    memcpy(sumsq + i * sum_stride,
+           sumsq + (height + SGRPROJ_BORDER) * sum_stride,
+           sizeof(*sumsq) * ii_width);
   }
 }
 
@@ -463,195 +379,132 @@ void decode_xq(int *xqd, int *xq) {
   xq[1] = (1 << SGRPROJ_PRJ_BITS) - xq[0] - xqd[1];
 }
 
-#define APPROXIMATE_SGR 1
-void av1_selfguided_restoration(int64_t *dgd, int width, int height, int stride,
-                                int bit_depth, int r, int eps, void *tmpbuf) {
-  int64_t *A = (int64_t *)tmpbuf;
-  int64_t *B = A + RESTORATION_TILEPELS_MAX;
-  int64_t *T = B + RESTORATION_TILEPELS_MAX;
-  int8_t num[RESTORATION_TILEPELS_MAX];
+// Weighted sums of the A or B coefficients around pixel k for the final step
+// of the self-guided filter. All intermediate values of that step fit in 32
+// bits for bit depths up to 12.
+static INLINE int32_t sgr_corner_sum(const int32_t *x, int k, int dx, int dy) {
+  return 3 * x[k] + 2 * x[k + dx] + 2 * x[k + dy] + x[k + dx + dy];
+}
+
+static INLINE int32_t sgr_edge_sum(const int32_t *x, int k, int along,
+                                   int across) {
+  return x[k] + 2 * (x[k - along] + x[k + along]) + x[k + across] +
+         x[k + across - along] + x[k + across + along];
+}
+
+static INLINE int32_t sgr_inner_sum(const int32_t *x, int k, int w) {
+  return (x[k] + x[k - 1] + x[k + 1] + x[k - w] + x[k + w]) * 4 +
+         (x[k - 1 - w] + x[k - 1 + w] + x[k + 1 - w] + x[k + 1 + w]) * 3;
+}
+
+static INLINE int32_t sgr_output(int32_t a, int32_t b, int32_t u, int nb) {
+  const int32_t v = (((a * u + b) << SGRPROJ_RST_BITS) + (1 << nb) / 2) >> nb;
+  return ROUND_POWER_OF_TWO(v, SGRPROJ_SGR_BITS);
+}
+
+void av1_selfguided_filter_border(const int32_t *dgd, int width, int height,
+                                  int stride, const int32_t *A,
+                                  const int32_t *B, int32_t *dst,
+                                  int dst_stride) {
+  const int w = width;
+  const int last = (height - 1) * w;
   int i, j;
+
+  dst[0] = sgr_output(sgr_corner_sum(A, 0, 1, w), sgr_corner_sum(B, 0, 1, w),
+                      dgd[0], 3);
+  dst[w - 1] = sgr_output(sgr_corner_sum(A, w - 1, -1, w),
+                          sgr_corner_sum(B, w - 1, -1, w), dgd[w - 1], 3);
+  dst[(height - 1) * dst_stride] =
+      sgr_output(sgr_corner_sum(A, last, 1, -w), sgr_corner_sum(B, last, 1, -w),
+                 dgd[(height - 1) * stride], 3);
+  dst[(height - 1) * dst_stride + w - 1] =
+      sgr_output(sgr_corner_sum(A, last + w - 1, -1, -w),
+                 sgr_corner_sum(B, last + w - 1, -1, -w),
+                 dgd[(height - 1) * stride + w - 1], 3);
+  for (j = 1; j < w - 1; ++j) {
+    dst[j] = sgr_output(sgr_edge_sum(A, j, 1, w), sgr_edge_sum(B, j, 1, w),
+                        dgd[j], 3);
+    dst[(height - 1) * dst_stride + j] =
+        sgr_output(sgr_edge_sum(A, last + j, 1, -w),
+                   sgr_edge_sum(B, last + j, 1, -w),
+                   dgd[(height - 1) * stride + j], 3);
+  }
+  for (i = 1; i < height - 1; ++i) {
+    const int k = i * w;
+    dst[i * dst_stride] = sgr_output(sgr_edge_sum(A, k, w, 1),
+                                     sgr_edge_sum(B, k, w, 1), dgd[i * stride],
+                                     3);
+    dst[i * dst_stride + w - 1] = sgr_output(
+        sgr_edge_sum(A, k + w - 1, w, -1), sgr_edge_sum(B, k + w - 1, w, -1),
+        dgd[i * stride + w - 1], 3);
+  }
+}
+
+void av1_selfguided_restoration_c(const int32_t *dgd, int width, int height,
+                                  int stride, int bit_depth, int r, int eps,
+                                  const uint32_t *sum, const uint32_t *sumsq,
+                                  int sum_stride, int32_t *dst, int dst_stride,
+                                  int32_t *tmpbuf) {
+  int32_t *A = tmpbuf;
+  int32_t *B = A + RESTORATION_TILEPELS_MAX;
+  int i, j;
+  assert(r <= SGRPROJ_BORDER);
   eps <<= 2 * (bit_depth - 8);
+  // Point at the integral image entry of the top-left pixel
+  sum += SGRPROJ_BORDER * sum_stride + SGRPROJ_BORDER;
+  sumsq += SGRPROJ_BORDER * sum_stride + SGRPROJ_BORDER;
 
-  boxsum(dgd, width, height, stride, r, 0, B, width, T, width);
-  boxsum(dgd, width, height, stride, r, 1, A, width, T, width);
-  boxnum(width, height, r, num, width);
   for (i = 0; i < height; ++i) {
+    const int ny = AOMMIN(i + r, height - 1) - AOMMAX(i - r, 0) + 1;
+    const uint32_t *top = sum + (i - r) * sum_stride;
+    const uint32_t *bot = sum + (i + r + 1) * sum_stride;
+    const uint32_t *top2 = sumsq + (i - r) * sum_stride;
+    const uint32_t *bot2 = sumsq + (i + r + 1) * sum_stride;
     for (j = 0; j < width; ++j) {
       const int k = i * width + j;
-      const int n = num[k];
-      int64_t den;
-      A[k] = A[k] * n - B[k] * B[k];
-      den = A[k] + n * n * eps;
-      A[k] = ((A[k] << SGRPROJ_SGR_BITS) + (den >> 1)) / den;
-      B[k] = ((SGRPROJ_SGR - A[k]) * B[k] + (n >> 1)) / n;
+      const int n = ny * (AOMMIN(j + r, width - 1) - AOMMAX(j - r, 0) + 1);
+      const uint32_t s =
+          bot[j + r + 1] - top[j + r + 1] - bot[j - r] + top[j - r];
+      const uint32_t s2 =
+          bot2[j + r + 1] - top2[j + r + 1] - bot2[j - r] + top2[j - r];
+      const int64_t p = (int64_t)s2 * n - (int64_t)s * s;
+      const int64_t den = p + (int64_t)n * n * eps;
+      A[k] = (int32_t)(((p << SGRPROJ_SGR_BITS) + (den >> 1)) / den);
+      B[k] = ((SGRPROJ_SGR - A[k]) * (int32_t)s + (n >> 1)) / n;
     }
   }
-#if APPROXIMATE_SGR
-  i = 0;
-  j = 0;
-  {
-    const int k = i * width + j;
-    const int l = i * stride + j;
-    const int nb = 3;
-    const int64_t a =
-        3 * A[k] + 2 * A[k + 1] + 2 * A[k + width] + A[k + width + 1];
-    const int64_t b =
-        3 * B[k] + 2 * B[k + 1] + 2 * B[k + width] + B[k + width + 1];
-    const int64_t v =
-        (((a * dgd[l] + b) << SGRPROJ_RST_BITS) + (1 << nb) / 2) >> nb;
-    dgd[l] = ROUND_POWER_OF_TWO(v, SGRPROJ_SGR_BITS);
-  }
-  i = 0;
-  j = width - 1;
-  {
-    const int k = i * width + j;
-    const int l = i * stride + j;
-    const int nb = 3;
-    const int64_t a =
-        3 * A[k] + 2 * A[k - 1] + 2 * A[k + width] + A[k + width - 1];
-    const int64_t b =
-        3 * B[k] + 2 * B[k - 1] + 2 * B[k + width] + B[k + width - 1];
-    const int64_t v =
-        (((a * dgd[l] + b) << SGRPROJ_RST_BITS) + (1 << nb) / 2) >> nb;
-    dgd[l] = ROUND_POWER_OF_TWO(v, SGRPROJ_SGR_BITS);
-  }
-  i = height - 1;
-  j = 0;
-  {
-    const int k = i * width + j;
-    const int l = i * stride + j;
-    const int nb = 3;
-    const int64_t a =
-        3 * A[k] + 2 * A[k + 1] + 2 * A[k - width] + A[k - width + 1];
-    const int64_t b =
-        3 * B[k] + 2 * B[k + 1] + 2 * B[k - width] + B[k - width + 1];
-    const int64_t v =
-        (((a * dgd[l] + b) << SGRPROJ_RST_BITS) + (1 << nb) / 2) >> nb;
-    dgd[l] = ROUND_POWER_OF_TWO(v, SGRPROJ_SGR_BITS);
-  }
-  i = height - 1;
-  j = width - 1;
-  {
-    const int k = i * width + j;
-    const int l = i * stride + j;
-    const int nb = 3;
-    const int64_t a =
-        3 * A[k] + 2 * A[k - 1] + 2 * A[k - width] + A[k - width - 1];
-    const int64_t b =
-        3 * B[k] + 2 * B[k - 1] + 2 * B[k - width] + B[k - width - 1];
-    const int64_t v =
-        (((a * dgd[l] + b) << SGRPROJ_RST_BITS) + (1 << nb) / 2) >> nb;
-    dgd[l] = ROUND_POWER_OF_TWO(v, SGRPROJ_SGR_BITS);
-  }
-  i = 0;
-  for (j = 1; j < width - 1; ++j) {
-    const int k = i * width + j;
-    const int l = i * stride + j;
-    const int nb = 3;
-    const int64_t a = A[k] + 2 * (A[k - 1] + A[k + 1]) + A[k + width] +
-                      A[k + width - 1] + A[k + width + 1];
-    const int64_t b = B[k] + 2 * (B[k - 1] + B[k + 1]) + B[k + width] +
-                      B[k + width - 1] + B[k + width + 1];
-    const int64_t v =
-        (((a * dgd[l] + b) << SGRPROJ_RST_BITS) + (1 << nb) / 2) >> nb;
-    dgd[l] = ROUND_POWER_OF_TWO(v, SGRPROJ_SGR_BITS);
-  }
-  i = height - 1;
-  for (j = 1; j < width - 1; ++j) {
-    const int k = i * width + j;
-    const int l = i * stride + j;
-    const int nb = 3;
-    const int64_t a = A[k] + 2 * (A[k - 1] + A[k + 1]) + A[k - width] +
-                      A[k - width - 1] + A[k - width + 1];
-    const int64_t b = B[k] + 2 * (B[k - 1] + B[k + 1]) + B[k - width] +
-                      B[k - width - 1] + B[k - width + 1];
-    const int64_t v =
-        (((a * dgd[l] + b) << SGRPROJ_RST_BITS) + (1 << nb) / 2) >> nb;
-    dgd[l] = ROUND_POWER_OF_TWO(v, SGRPROJ_SGR_BITS);
-  }
-  j = 0;
-  for (i = 1; i < height - 1; ++i) {
-    const int k = i * width + j;
-    const int l = i * stride + j;
-    const int nb = 3;
-    const int64_t a = A[k] + 2 * (A[k - width] + A[k + width]) + A[k + 1] +
-                      A[k - width + 1] + A[k + width + 1];
-    const int64_t b = B[k] + 2 * (B[k - width] + B[k + width]) + B[k + 1] +
-                      B[k - width + 1] + B[k + width + 1];
-    const int64_t v =
-        (((a * dgd[l] + b) << SGRPROJ_RST_BITS) + (1 << nb) / 2) >> nb;
-    dgd[l] = ROUND_POWER_OF_TWO(v, SGRPROJ_SGR_BITS);
-  }
-  j = width - 1;
-  for (i = 1; i < height - 1; ++i) {
-    const int k = i * width + j;
-    const int l = i * stride + j;
-    const int nb = 3;
-    const int64_t a = A[k] + 2 * (A[k - width] + A[k + width]) + A[k - 1] +
-                      A[k - width - 1] + A[k + width - 1];
-    const int64_t b = B[k] + 2 * (B[k - width] + B[k + width]) + B[k - 1] +
-                      B[k - width - 1] + B[k + width - 1];
-    const int64_t v =
-        (((a * dgd[l] + b) << SGRPROJ_RST_BITS) + (1 << nb) / 2) >> nb;
-    dgd[l] = ROUND_POWER_OF_TWO(v, SGRPROJ_SGR_BITS);
-  }
+
+  av1_selfguided_filter_border(dgd, width, height, stride, A, B, dst,
+                               dst_stride);
   for (i = 1; i < height - 1; ++i) {
     for (j = 1; j < width - 1; ++j) {
       const int k = i * width + j;
-      const int l = i * stride + j;
-      const int nb = 5;
-      const int64_t a =
-          (A[k] + A[k - 1] + A[k + 1] + A[k - width] + A[k + width]) * 4 +
-          (A[k - 1 - width] + A[k - 1 + width] + A[k + 1 - width] +
-           A[k + 1 + width]) *
-              3;
-      const int64_t b =
-          (B[k] + B[k - 1] + B[k + 1] + B[k - width] + B[k + width]) * 4 +
-          (B[k - 1 - width] + B[k - 1 + width] + B[k + 1 - width] +
-           B[k + 1 + width]) *
-              3;
-      const int64_t v =
-          (((a * dgd[l] + b) << SGRPROJ_RST_BITS) + (1 << nb) / 2) >> nb;
-      dgd[l] = ROUND_POWER_OF_TWO(v, SGRPROJ_SGR_BITS);
-    }
-  }
-#else
-  if (r > 1) boxnum(width, height, r = 1, num, width);
-  boxsum(A, width, height, width, r, 0, A, width, T, width);
-  boxsum(B, width, height, width, r, 0, B, width, T, width);
-  for (i = 0; i < height; ++i) {
-    for (j = 0; j < width; ++j) {
-      const int k = i * width + j;
-      const int l = i * stride + j;
-      const int n = num[k];
-      const int64_t v =
-          (((A[k] * dgd[l] + B[k]) << SGRPROJ_RST_BITS) + (n >> 1)) / n;
-      dgd[l] = ROUND_POWER_OF_TWO(v, SGRPROJ_SGR_BITS);
+      dst[i * dst_stride + j] =
+          sgr_output(sgr_inner_sum(A, k, width), sgr_inner_sum(B, k, width),
+                     dgd[i * stride + j], 5);
     }
   }
-#endif  // APPROXIMATE_SGR
 }
 
-static void apply_selfguided_restoration(int64_t *dat, int width, int height,
+static void apply_selfguided_restoration(int32_t *dat, int width, int height,
                                          int stride, int bit_depth, int eps,
                                          int *xqd, void *tmpbuf) {
   int xq[2];
-  int64_t *flt1 = (int64_t *)tmpbuf;
-  int64_t *flt2 = flt1 + RESTORATION_TILEPELS_MAX;
-  uint8_t *tmpbuf2 = (uint8_t *)(flt2 + RESTORATION_TILEPELS_MAX);
+  int32_t *flt1 = (int32_t *)tmpbuf;
+  int32_t *flt2 = flt1 + RESTORATION_TILEPELS_MAX;
+  uint32_t *sum = (uint32_t *)(flt2 + RESTORATION_TILEPELS_MAX);
+  uint32_t *sumsq = sum + SGRPROJ_INTIMG_SIZE;
+  int32_t *sgrbuf = (int32_t *)(sumsq + SGRPROJ_INTIMG_SIZE);
+  const int sum_stride = width + 2 * SGRPROJ_BORDER + 1;
   int i, j;
-  for (i = 0; i < height; ++i) {
-    for (j = 0; j < width; ++j) {
-      assert(i * width + j < RESTORATION_TILEPELS_MAX);
-      flt1[i * width + j] = dat[i * stride + j];
-      flt2[i * width + j] = dat[i * stride + j];
-    }
-  }
-  av1_selfguided_restoration(flt1, width, height, width, bit_depth,
-                             sgr_params[eps].r1, sgr_params[eps].e1, tmpbuf2);
-  av1_selfguided_restoration(flt2, width, height, width, bit_depth,
-                             sgr_params[eps].r2, sgr_params[eps].e2, tmpbuf2);
+  assert(width * height <= RESTORATION_TILEPELS_MAX);
+  av1_integral_images(dat, width, height, stride, sum, sumsq, sum_stride);
+  av1_selfguided_restoration(dat, width, height, stride, bit_depth,
+                             sgr_params[eps].r1, sgr_params[eps].e1, sum, sumsq,
+                             sum_stride, flt1, width, sgrbuf);
+  av1_selfguided_restoration(dat, width, height, stride, bit_depth,
+                             sgr_params[eps].r2, sgr_params[eps].e2, sum, sumsq,
+                             sum_stride, flt2, width, sgrbuf);
   decode_xq(xqd, xq);
   for (i = 0; i < height; ++i) {
     for (j = 0; j < width; ++j) {
@@ -676,7 +529,7 @@ static void loop_sgrproj_filter_tile(uint8_t *data, int tile_idx, int width,
   int i, j;
   int h_start, h_end, v_start, v_end;
   uint8_t *data_p;
-  int64_t *dat = (int64_t *)tmpbuf;
+  int32_t *dat = (int32_t *)tmpbuf;
   tmpbuf = (uint8_t *)tmpbuf + RESTORATION_TILEPELS_MAX * sizeof(*dat);
 
   if (rst->rsi->sgrproj_info[tile_idx].level == 0) return;
@@ -700,20 +553,6 @@ static void loop_sgrproj_filter_tile(uint8_t *data, int tile_idx, int width,
   }
 }
 
-static void loop_sgrproj_filter(uint8_t *data, int width, int height,
-                                int stride, RestorationInternal *rst,
-                                uint8_t *tmpdata, int tmpstride) {
-  int tile_idx;
-  uint8_t *tmpbuf = aom_malloc(SGRPROJ_TMPBUF_SIZE);
-  (void)tmpdata;
-  (void)tmpstride;
-  for (tile_idx = 0; tile_idx < rst->ntiles; ++tile_idx) {
-    loop_sgrproj_filter_tile(data, tile_idx, width, height, stride, rst,
-                             tmpbuf);
-  }
-  aom_free(tmpbuf);
-}
-
 static void apply_domaintxfmrf_hor(int iter, int param, uint8_t *img, int width,
                                    int height, int img_stride, int32_t *dat,
                                    int dat_stride) {
@@ -823,51 +662,6 @@ static void loop_domaintxfmrf_filter_tile(uint8_t *data, int tile_idx,
                                rst->rsi->domaintxfmrf_info[tile_idx].sigma_r);
 }
 
-static void loop_domaintxfmrf_filter(uint8_t *data, int width, int height,
-                                     int stride, RestorationInternal *rst,
-                                     uint8_t *tmpdata, int tmpstride) {
-  int tile_idx;
-  (void)tmpdata;
-  (void)tmpstride;
-  for (tile_idx = 0; tile_idx < rst->ntiles; ++tile_idx) {
-    loop_domaintxfmrf_filter_tile(data, tile_idx, width, height, stride, rst,
-                                  NULL);
-  }
-}
-
-static void loop_switchable_filter(uint8_t *data, int width, int height,
-                                   int stride, RestorationInternal *rst,
-                                   uint8_t *tmpdata, int tmpstride) {
-  int i, tile_idx;
-  uint8_t *data_p, *tmpdata_p;
-  uint8_t *tmpbuf = aom_malloc(SGRPROJ_TMPBUF_SIZE);
-
-  // Initialize tmp buffer
-  data_p = data;
-  tmpdata_p = tmpdata;
-  for (i = 0; i < height; ++i) {
-    memcpy(tmpdata_p, data_p, sizeof(*data_p) * width);
-    data_p += stride;
-    tmpdata_p += tmpstride;
-  }
-  for (tile_idx = 0; tile_idx < rst->ntiles; ++tile_idx) {
-    if (rst->rsi->restoration_type[tile_idx] == RESTORE_BILATERAL) {
-      loop_bilateral_filter_tile(data, tile_idx, width, height, stride, rst,
-                                 tmpdata, tmpstride);
-    } else if (rst->rsi->restoration_type[tile_idx] == RESTORE_WIENER) {
-      loop_wiener_filter_tile(data, tile_idx, width, height, stride, rst,
-                              tmpdata, tmpstride);
-    } else if (rst->rsi->restoration_type[tile_idx] == RESTORE_SGRPROJ) {
-      loop_sgrproj_filter_tile(data, tile_idx, width, height, stride, rst,
-                               tmpbuf);
-    } else if (rst->rsi->restoration_type[tile_idx] == RESTORE_DOMAINTXFMRF) {
-      loop_domaintxfmrf_filter_tile(data, tile_idx, width, height, stride, rst,
-                                    tmpbuf);
-    }
-  }
-  aom_free(tmpbuf);
-}
-
 #if CONFIG_AOM_HIGHBITDEPTH
 static void loop_bilateral_filter_tile_highbd(uint16_t *data, int tile_idx,
                                               int width, int height, int stride,
@@ -930,21 +724,8 @@ static void loop_bilateral_filter_tile_highbd(uint16_t *data, int tile_idx,
   }
 }
 
-static void loop_bilateral_filter_highbd(uint8_t *data8, int width, int height,
-                                         int stride, RestorationInternal *rst,
-                                         uint8_t *tmpdata8, int tmpstride,
-                                         int bit_depth) {
-  int tile_idx;
-  uint16_t *data = CONVERT_TO_SHORTPTR(data8);
-  uint16_t *tmpdata = CONVERT_TO_SHORTPTR(tmpdata8);
-
-  for (tile_idx = 0; tile_idx < rst->ntiles; ++tile_idx) {
-    loop_bilateral_filter_tile_highbd(data, tile_idx, width, height, stride,
-                                      rst, tmpdata, tmpstride, bit_depth);
-  }
-}
-
-uint16_t hor_sym_filter_highbd(uint16_t *d, int *hfilter, int bd) {
+static INLINE uint16_t hor_sym_filter_highbd(const uint16_t *d,
+                                             const int *hfilter, int bd) {
   int32_t s =
       (1 << (RESTORATION_FILT_BITS - 1)) + d[0] * hfilter[RESTORATION_HALFWIN];
   int i;
@@ -953,7 +734,8 @@ uint16_t hor_sym_filter_highbd(uint16_t *d, int *hfilter, int bd) {
   return clip_pixel_highbd(s >> RESTORATION_FILT_BITS, bd);
 }
 
-uint16_t ver_sym_filter_highbd(uint16_t *d, int stride, int *vfilter, int bd) {
+static INLINE uint16_t ver_sym_filter_highbd(const uint16_t *d, int stride,
+                                             const int *vfilter, int bd) {
   int32_t s =
       (1 << (RESTORATION_FILT_BITS - 1)) + d[0] * vfilter[RESTORATION_HALFWIN];
   int i;
@@ -962,6 +744,30 @@ uint16_t ver_sym_filter_highbd(uint16_t *d, int stride, int *vfilter, int bd) {
   return clip_pixel_highbd(s >> RESTORATION_FILT_BITS, bd);
 }
 
+void av1_highbd_wiener_filter_hor_c(const uint16_t *src, int src_stride,
+                                    uint16_t *dst, int dst_stride, int w,
+                                    int h, const int *hfilter, int bd) {
+  int i, j;
+  for (i = 0; i < h; ++i) {
+    for (j = 0; j < w; ++j)
+      dst[j] = hor_sym_filter_highbd(src + j, hfilter, bd);
+    src += src_stride;
+    dst += dst_stride;
+  }
+}
+
+void av1_highbd_wiener_filter_ver_c(const uint16_t *src, int src_stride,
+                                    uint16_t *dst, int dst_stride, int w,
+                                    int h, const int *vfilter, int bd) {
+  int i, j;
+  for (i = 0; i < h; ++i) {
+    for (j = 0; j < w; ++j)
+      dst[j] = ver_sym_filter_highbd(src + j, src_stride, vfilter, bd);
+    src += src_stride;
+    dst += dst_stride;
+  }
+}
+
 static void loop_wiener_filter_tile_highbd(uint16_t *data, int tile_idx,
                                            int width, int height, int stride,
                                            RestorationInternal *rst,
@@ -970,62 +776,26 @@ static void loop_wiener_filter_tile_highbd(uint16_t *data, int tile_idx,
   const int tile_width = rst->tile_width >> rst->subsampling_x;
   const int tile_height = rst->tile_height >> rst->subsampling_y;
   int h_start, h_end, v_start, v_end;
-  int i, j;
-  uint16_t *data_p, *tmpdata_p;
 
   if (rst->rsi->wiener_info[tile_idx].level == 0) return;
   // Filter row-wise
   av1_get_rest_tile_limits(tile_idx, 0, 0, rst->nhtiles, rst->nvtiles,
                            tile_width, tile_height, width, height, 1, 0,
                            &h_start, &h_end, &v_start, &v_end);
-  data_p = data + h_start + v_start * stride;
-  tmpdata_p = tmpdata + h_start + v_start * tmpstride;
-  for (i = 0; i < (v_end - v_start); ++i) {
-    for (j = 0; j < (h_end - h_start); ++j) {
-      *tmpdata_p++ = hor_sym_filter_highbd(
-          data_p++, rst->rsi->wiener_info[tile_idx].hfilter, bit_depth);
-    }
-    data_p += stride - (h_end - h_start);
-    tmpdata_p += tmpstride - (h_end - h_start);
-  }
+  av1_highbd_wiener_filter_hor(data + h_start + v_start * stride, stride,
+                               tmpdata + h_start + v_start * tmpstride,
+                               tmpstride, h_end - h_start, v_end - v_start,
+                               rst->rsi->wiener_info[tile_idx].hfilter,
+                               bit_depth);
   // Filter col-wise
   av1_get_rest_tile_limits(tile_idx, 0, 0, rst->nhtiles, rst->nvtiles,
                            tile_width, tile_height, width, height, 0, 1,
                            &h_start, &h_end, &v_start, &v_end);
-  data_p = data + h_start + v_start * stride;
-  tmpdata_p = tmpdata + h_start + v_start * tmpstride;
-  for (i = 0; i < (v_end - v_start); ++i) {
-    for (j = 0; j < (h_end - h_start); ++j) {
-      *data_p++ = ver_sym_filter_highbd(tmpdata_p++, tmpstride,
-                                        rst->rsi->wiener_info[tile_idx].vfilter,
-                                        bit_depth);
-    }
-    data_p += stride - (h_end - h_start);
-    tmpdata_p += tmpstride - (h_end - h_start);
-  }
-}
-
-static void loop_wiener_filter_highbd(uint8_t *data8, int width, int height,
-                                      int stride, RestorationInternal *rst,
-                                      uint8_t *tmpdata8, int tmpstride,
-                                      int bit_depth) {
-  uint16_t *data = CONVERT_TO_SHORTPTR(data8);
-  uint16_t *tmpdata = CONVERT_TO_SHORTPTR(tmpdata8);
-  int tile_idx, i;
-  uint16_t *data_p, *tmpdata_p;
-
-  // Initialize tmp buffer
-  data_p = data;
-  tmpdata_p = tmpdata;
-  for (i = 0; i < height; ++i) {
-    memcpy(tmpdata_p, data_p, sizeof(*data_p) * width);
-    data_p += stride;
-    tmpdata_p += tmpstride;
-  }
-  for (tile_idx = 0; tile_idx < rst->ntiles; ++tile_idx) {
-    loop_wiener_filter_tile_highbd(data, tile_idx, width, height, stride, rst,
-                                   tmpdata, tmpstride, bit_depth);
-  }
+  av1_highbd_wiener_filter_ver(tmpdata + h_start + v_start * tmpstride,
+                               tmpstride, data + h_start + v_start * stride,
+                               stride, h_end - h_start, v_end - v_start,
+                               rst->rsi->wiener_info[tile_idx].vfilter,
+                               bit_depth);
 }
 
 static void loop_sgrproj_filter_tile_highbd(uint16_t *data, int tile_idx,
@@ -1037,7 +807,7 @@ static void loop_sgrproj_filter_tile_highbd(uint16_t *data, int tile_idx,
   int i, j;
   int h_start, h_end, v_start, v_end;
   uint16_t *data_p;
-  int64_t *dat = (int64_t *)tmpbuf;
+  int32_t *dat = (int32_t *)tmpbuf;
   tmpbuf = (uint8_t *)tmpbuf + RESTORATION_TILEPELS_MAX * sizeof(*dat);
 
   if (rst->rsi->sgrproj_info[tile_idx].level == 0) return;
@@ -1062,22 +832,6 @@ static void loop_sgrproj_filter_tile_highbd(uint16_t *data, int tile_idx,
   }
 }
 
-static void loop_sgrproj_filter_highbd(uint8_t *data8, int width, int height,
-                                       int stride, RestorationInternal *rst,
-                                       uint8_t *tmpdata8, int tmpstride,
-                                       int bit_depth) {
-  int tile_idx;
-  uint16_t *data = CONVERT_TO_SHORTPTR(data8);
-  uint8_t *tmpbuf = aom_malloc(SGRPROJ_TMPBUF_SIZE);
-  (void)tmpdata8;
-  (void)tmpstride;
-  for (tile_idx = 0; tile_idx < rst->ntiles; ++tile_idx) {
-    loop_sgrproj_filter_tile_highbd(data, tile_idx, width, height, stride, rst,
-                                    bit_depth, tmpbuf);
-  }
-  aom_free(tmpbuf);
-}
-
 static void apply_domaintxfmrf_hor_highbd(int iter, int param, uint16_t *img,
                                           int width, int height, int img_stride,
                                           int32_t *dat, int dat_stride,
@@ -1186,148 +940,184 @@ static void loop_domaintxfmrf_filter_tile_highbd(uint16_t *data, int tile_idx,
       data + h_start + v_start * stride, h_end - h_start, v_end - v_start,
       stride, rst->rsi->domaintxfmrf_info[tile_idx].sigma_r, bit_depth);
 }
-
-static void loop_domaintxfmrf_filter_highbd(uint8_t *data8, int width,
-                                            int height, int stride,
-                                            RestorationInternal *rst,
-                                            uint8_t *tmpdata, int tmpstride,
-                                            int bit_depth) {
-  int tile_idx;
-  uint16_t *data = CONVERT_TO_SHORTPTR(data8);
-  (void)tmpdata;
-  (void)tmpstride;
-  for (tile_idx = 0; tile_idx < rst->ntiles; ++tile_idx) {
-    loop_domaintxfmrf_filter_tile_highbd(data, tile_idx, width, height, stride,
-                                         rst, bit_depth, NULL);
-  }
-}
-
-static void loop_switchable_filter_highbd(uint8_t *data8, int width, int height,
-                                          int stride, RestorationInternal *rst,
-                                          uint8_t *tmpdata8, int tmpstride,
-                                          int bit_depth) {
-  uint16_t *data = CONVERT_TO_SHORTPTR(data8);
-  uint16_t *tmpdata = CONVERT_TO_SHORTPTR(tmpdata8);
-  uint8_t *tmpbuf = aom_malloc(SGRPROJ_TMPBUF_SIZE);
-  int i, tile_idx;
-  uint16_t *data_p, *tmpdata_p;
-
-  // Initialize tmp buffer
-  data_p = data;
-  tmpdata_p = tmpdata;
-  for (i = 0; i < height; ++i) {
-    memcpy(tmpdata_p, data_p, sizeof(*data_p) * width);
-    data_p += stride;
-    tmpdata_p += tmpstride;
-  }
-  for (tile_idx = 0; tile_idx < rst->ntiles; ++tile_idx) {
-    if (rst->rsi->restoration_type[tile_idx] == RESTORE_BILATERAL) {
-      loop_bilateral_filter_tile_highbd(data, tile_idx, width, height, stride,
-                                        rst, tmpdata, tmpstride, bit_depth);
-    } else if (rst->rsi->restoration_type[tile_idx] == RESTORE_WIENER) {
-      loop_wiener_filter_tile_highbd(data, tile_idx, width, height, stride, rst,
-                                     tmpdata, tmpstride, bit_depth);
-    } else if (rst->rsi->restoration_type[tile_idx] == RESTORE_SGRPROJ) {
-      loop_sgrproj_filter_tile_highbd(data, tile_idx, width, height, stride,
-                                      rst, bit_depth, tmpbuf);
-    } else if (rst->rsi->restoration_type[tile_idx] == RESTORE_DOMAINTXFMRF) {
-      loop_domaintxfmrf_filter_tile_highbd(data, tile_idx, width, height,
-                                           stride, rst, bit_depth, tmpbuf);
-    }
-  }
-  aom_free(tmpbuf);
-}
-#endif  // CONFIG_AOM_HIGHBITDEPTH
-
-void av1_loop_restoration_rows(YV12_BUFFER_CONFIG *frame, AV1_COMMON *cm,
-                               int start_mi_row, int end_mi_row, int y_only) {
-  const int ywidth = frame->y_crop_width;
-  const int ystride = frame->y_stride;
-  const int uvwidth = frame->uv_crop_width;
-  const int uvstride = frame->uv_stride;
-  const int ystart = start_mi_row << MI_SIZE_LOG2;
-  const int uvstart = ystart >> cm->subsampling_y;
-  int yend = end_mi_row << MI_SIZE_LOG2;
-  int uvend = yend >> cm->subsampling_y;
-  restore_func_type restore_funcs[RESTORE_TYPES] = { NULL,
-                                                     loop_sgrproj_filter,
-                                                     loop_bilateral_filter,
-                                                     loop_wiener_filter,
-                                                     loop_domaintxfmrf_filter,
-                                                     loop_switchable_filter };
-#if CONFIG_AOM_HIGHBITDEPTH
-  restore_func_highbd_type restore_funcs_highbd[RESTORE_TYPES] = {
-    NULL,
-    loop_sgrproj_filter_highbd,
-    loop_bilateral_filter_highbd,
-    loop_wiener_filter_highbd,
-    loop_domaintxfmrf_filter_highbd,
-    loop_switchable_filter_highbd
-  };
-#endif  // CONFIG_AOM_HIGHBITDEPTH
-  restore_func_type restore_func =
-      restore_funcs[cm->rst_internal.rsi->frame_restoration_type];
-#if CONFIG_AOM_HIGHBITDEPTH
-  restore_func_highbd_type restore_func_highbd =
-      restore_funcs_highbd[cm->rst_internal.rsi->frame_restoration_type];
 #endif  // CONFIG_AOM_HIGHBITDEPTH
-  YV12_BUFFER_CONFIG tmp_buf;
-
-  if (cm->rst_internal.rsi->frame_restoration_type == RESTORE_NONE) return;
-
-  memset(&tmp_buf, 0, sizeof(YV12_BUFFER_CONFIG));
-
-  yend = AOMMIN(yend, cm->height);
-  uvend = AOMMIN(uvend, cm->subsampling_y ? (cm->height + 1) >> 1 : cm->height);
 
+void av1_alloc_restoration_tmp_frame(YV12_BUFFER_CONFIG *tmp_buf,
+                                     AV1_COMMON *cm) {
   if (aom_realloc_frame_buffer(
-          &tmp_buf, cm->width, cm->height, cm->subsampling_x, cm->subsampling_y,
+          tmp_buf, cm->width, cm->height, cm->subsampling_x, cm->subsampling_y,
 #if CONFIG_AOM_HIGHBITDEPTH
           cm->use_highbitdepth,
 #endif
           AOM_BORDER_IN_PIXELS, cm->byte_alignment, NULL, NULL, NULL) < 0)
     aom_internal_error(&cm->error, AOM_CODEC_MEM_ERROR,
                        "Failed to allocate tmp restoration buffer");
+}
 
+void av1_loop_restoration_plane_init(RestorationPlane *rp,
+                                     YV12_BUFFER_CONFIG *frame,
+                                     YV12_BUFFER_CONFIG *tmp_buf,
+                                     AV1_COMMON *cm, int plane,
+                                     int start_mi_row, int end_mi_row) {
+  const int ss_x = plane ? cm->subsampling_x : 0;
+  const int ss_y = plane ? cm->subsampling_y : 0;
+  const int start = (start_mi_row << MI_SIZE_LOG2) >> ss_y;
+  const int end = AOMMIN((end_mi_row << MI_SIZE_LOG2) >> ss_y,
+                         (cm->height + ss_y) >> ss_y);
+  uint8_t *const buf = plane == 0 ? frame->y_buffer
+                                  : plane == 1 ? frame->u_buffer
+                                               : frame->v_buffer;
+  uint8_t *const tmp = plane == 0 ? tmp_buf->y_buffer
+                                  : plane == 1 ? tmp_buf->u_buffer
+                                               : tmp_buf->v_buffer;
+
+  rp->subsampling_x = ss_x;
+  rp->subsampling_y = ss_y;
+  rp->width = plane ? frame->uv_crop_width : frame->y_crop_width;
+  rp->height = end - start;
+  rp->stride = plane ? frame->uv_stride : frame->y_stride;
+  rp->tmpstride = plane ? tmp_buf->uv_stride : tmp_buf->y_stride;
+  rp->data = buf + start * rp->stride;
+  rp->tmpdata = tmp + start * rp->tmpstride;
+  rp->copied_rows = 0;
+  rp->next_tile_row = 0;
+}
+
+void av1_loop_restoration_copy_rows(RestorationPlane *rp, const AV1_COMMON *cm,
+                                    int end) {
+  const RestorationType type = cm->rst_internal.rsi->frame_restoration_type;
+  int i;
+
+  end = AOMMIN(end, rp->height);
+  if (type != RESTORE_WIENER && type != RESTORE_SWITCHABLE) return;
 #if CONFIG_AOM_HIGHBITDEPTH
-  if (cm->use_highbitdepth)
-    restore_func_highbd(frame->y_buffer + ystart * ystride, ywidth,
-                        yend - ystart, ystride, &cm->rst_internal,
-                        tmp_buf.y_buffer + ystart * tmp_buf.y_stride,
-                        tmp_buf.y_stride, cm->bit_depth);
-  else
-#endif  // CONFIG_AOM_HIGHBITDEPTH
-    restore_func(frame->y_buffer + ystart * ystride, ywidth, yend - ystart,
-                 ystride, &cm->rst_internal,
-                 tmp_buf.y_buffer + ystart * tmp_buf.y_stride,
-                 tmp_buf.y_stride);
-  if (!y_only) {
-    cm->rst_internal.subsampling_x = cm->subsampling_x;
-    cm->rst_internal.subsampling_y = cm->subsampling_y;
-#if CONFIG_AOM_HIGHBITDEPTH
-    if (cm->use_highbitdepth) {
-      restore_func_highbd(frame->u_buffer + uvstart * uvstride, uvwidth,
-                          uvend - uvstart, uvstride, &cm->rst_internal,
-                          tmp_buf.u_buffer + uvstart * tmp_buf.uv_stride,
-                          tmp_buf.uv_stride, cm->bit_depth);
-      restore_func_highbd(frame->v_buffer + uvstart * uvstride, uvwidth,
-                          uvend - uvstart, uvstride, &cm->rst_internal,
-                          tmp_buf.v_buffer + uvstart * tmp_buf.uv_stride,
-                          tmp_buf.uv_stride, cm->bit_depth);
-    } else {
+  if (cm->use_highbitdepth) {
+    for (i = rp->copied_rows; i < end; ++i)
+      memcpy(CONVERT_TO_SHORTPTR(rp->tmpdata) + i * rp->tmpstride,
+             CONVERT_TO_SHORTPTR(rp->data) + i * rp->stride,
+             rp->width * sizeof(uint16_t));
+    rp->copied_rows = AOMMAX(rp->copied_rows, end);
+    return;
+  }
 #endif  // CONFIG_AOM_HIGHBITDEPTH
-      restore_func(frame->u_buffer + uvstart * uvstride, uvwidth,
-                   uvend - uvstart, uvstride, &cm->rst_internal,
-                   tmp_buf.u_buffer + uvstart * tmp_buf.uv_stride,
-                   tmp_buf.uv_stride);
-      restore_func(frame->v_buffer + uvstart * uvstride, uvwidth,
-                   uvend - uvstart, uvstride, &cm->rst_internal,
-                   tmp_buf.v_buffer + uvstart * tmp_buf.uv_stride,
-                   tmp_buf.uv_stride);
+  for (i = rp->copied_rows; i < end; ++i)
+    memcpy(rp->tmpdata + i * rp->tmpstride, rp->data + i * rp->stride,
+           rp->width);
+  rp->copied_rows = AOMMAX(rp->copied_rows, end);
+}
+
+void av1_loop_restoration_tile(const RestorationPlane *rp, AV1_COMMON *cm,
+                               int tile_idx, void *tmpbuf) {
+  RestorationInternal rst_plane = cm->rst_internal;
+  RestorationInternal *const rst = &rst_plane;
+  const RestorationType type =
+      rst->rsi->frame_restoration_type == RESTORE_SWITCHABLE
+          ? rst->rsi->restoration_type[tile_idx]
+          : rst->rsi->frame_restoration_type;
+  rst->subsampling_x = rp->subsampling_x;
+  rst->subsampling_y = rp->subsampling_y;
 #if CONFIG_AOM_HIGHBITDEPTH
+  if (cm->use_highbitdepth) {
+    uint16_t *const data = CONVERT_TO_SHORTPTR(rp->data);
+    uint16_t *const tmpdata = CONVERT_TO_SHORTPTR(rp->tmpdata);
+    switch (type) {
+      case RESTORE_BILATERAL:
+        loop_bilateral_filter_tile_highbd(data, tile_idx, rp->width,
+                                          rp->height, rp->stride, rst, tmpdata,
+                                          rp->tmpstride, cm->bit_depth);
+        break;
+      case RESTORE_WIENER:
+        loop_wiener_filter_tile_highbd(data, tile_idx, rp->width, rp->height,
+                                       rp->stride, rst, tmpdata, rp->tmpstride,
+                                       cm->bit_depth);
+        break;
+      case RESTORE_SGRPROJ:
+        loop_sgrproj_filter_tile_highbd(data, tile_idx, rp->width, rp->height,
+                                        rp->stride, rst, cm->bit_depth,
+                                        tmpbuf);
+        break;
+      case RESTORE_DOMAINTXFMRF:
+        loop_domaintxfmrf_filter_tile_highbd(data, tile_idx, rp->width,
+                                             rp->height, rp->stride, rst,
+                                             cm->bit_depth, tmpbuf);
+        break;
+      default: break;
     }
+    return;
+  }
 #endif  // CONFIG_AOM_HIGHBITDEPTH
+  switch (type) {
+    case RESTORE_BILATERAL:
+      loop_bilateral_filter_tile(rp->data, tile_idx, rp->width, rp->height,
+                                 rp->stride, rst, rp->tmpdata, rp->tmpstride);
+      break;
+    case RESTORE_WIENER:
+      loop_wiener_filter_tile(rp->data, tile_idx, rp->width, rp->height,
+                              rp->stride, rst, rp->tmpdata, rp->tmpstride);
+      break;
+    case RESTORE_SGRPROJ:
+      loop_sgrproj_filter_tile(rp->data, tile_idx, rp->width, rp->height,
+                               rp->stride, rst, tmpbuf);
+      break;
+    case RESTORE_DOMAINTXFMRF:
+      loop_domaintxfmrf_filter_tile(rp->data, tile_idx, rp->width, rp->height,
+                                    rp->stride, rst, tmpbuf);
+      break;
+    default: break;
+  }
+}
+
+int av1_loop_restoration_plane_rows(RestorationPlane *rp, AV1_COMMON *cm,
+                                    int ready_rows, void *tmpbuf) {
+  const RestorationInternal *const rst = &cm->rst_internal;
+  const int tile_width = rst->tile_width >> rp->subsampling_x;
+  const int tile_height = rst->tile_height >> rp->subsampling_y;
+  int h_start, h_end, v_start, v_end;
+  int tile_col;
+
+  while (rp->next_tile_row < rst->nvtiles) {
+    av1_get_rest_tile_limits(rp->next_tile_row * rst->nhtiles, 0, 0,
+                             rst->nhtiles, rst->nvtiles, tile_width,
+                             tile_height, rp->width, rp->height, 0, 0,
+                             &h_start, &h_end, &v_start, &v_end);
+    // The filters read up to RESTORATION_HALFWIN rows below the tile.
+    if (ready_rows < AOMMIN(v_end + RESTORATION_HALFWIN, rp->height)) break;
+    av1_loop_restoration_copy_rows(rp, cm, v_end + RESTORATION_HALFWIN);
+    for (tile_col = 0; tile_col < rst->nhtiles; ++tile_col)
+      av1_loop_restoration_tile(
+          rp, cm, rp->next_tile_row * rst->nhtiles + tile_col, tmpbuf);
+    ++rp->next_tile_row;
+  }
+  if (rp->next_tile_row == rst->nvtiles) return rp->height;
+  av1_get_rest_tile_limits(rp->next_tile_row * rst->nhtiles, 0, 0,
+                           rst->nhtiles, rst->nvtiles, tile_width, tile_height,
+                           rp->width, rp->height, 0, 0, &h_start, &h_end,
+                           &v_start, &v_end);
+  return AOMMIN(v_start, rp->height);
+}
+
+void av1_loop_restoration_rows(YV12_BUFFER_CONFIG *frame, AV1_COMMON *cm,
+                               int start_mi_row, int end_mi_row, int y_only) {
+  const RestorationType type = cm->rst_internal.rsi->frame_restoration_type;
+  const int num_planes = y_only ? 1 : MAX_MB_PLANE;
+  YV12_BUFFER_CONFIG tmp_buf;
+  uint8_t *tmpbuf = NULL;
+  int plane;
+
+  if (type == RESTORE_NONE) return;
+
+  memset(&tmp_buf, 0, sizeof(YV12_BUFFER_CONFIG));
+  av1_alloc_restoration_tmp_frame(&tmp_buf, cm);
+  if (av1_restoration_uses_tmpbuf(type))
+    tmpbuf = aom_malloc(SGRPROJ_TMPBUF_SIZE);
+
+  for (plane = 0; plane < num_planes; ++plane) {
+    RestorationPlane rp;
+    av1_loop_restoration_plane_init(&rp, frame, &tmp_buf, cm, plane,
+                                    start_mi_row, end_mi_row);
+    av1_loop_restoration_plane_rows(&rp, cm, rp.height, tmpbuf);
   }
+  aom_free(tmpbuf);
   aom_free_frame_buffer(&tmp_buf);
 }
 
@@ -41,10 +41,25 @@ extern "C" {
 #define DOMAINTXFMRF_TMPBUF_SIZE (RESTORATION_TILEPELS_MAX)
 #define DOMAINTXFMRF_BITS (DOMAINTXFMRF_PARAMS_BITS)
 
-#define SGRPROJ_TMPBUF_SIZE (RESTORATION_TILEPELS_MAX * 6 * 8)
 #define SGRPROJ_PARAMS_BITS 3
 #define SGRPROJ_PARAMS (1 << SGRPROJ_PARAMS_BITS)
 
+// Border around the integral images used by the self-guided filter. This must
+// be at least as large as the largest radius in sgr_params.
+#define SGRPROJ_BORDER 2
+// Number of rows and columns of an integral image for the largest tile, which
+// is at most 1.5 times RESTORATION_TILESIZE_BIG in each dimension.
+#define SGRPROJ_INTIMG_DIM \
+  (RESTORATION_TILESIZE_BIG * 3 / 2 + 2 * SGRPROJ_BORDER + 1)
+#define SGRPROJ_INTIMG_SIZE (SGRPROJ_INTIMG_DIM * SGRPROJ_INTIMG_DIM)
+// Scratch used by av1_selfguided_restoration() for the A and B planes
+#define SGRPROJ_SGRBUF_SIZE (RESTORATION_TILEPELS_MAX * 2 * sizeof(int32_t))
+// Scratch for one tile: up to four int32 planes, the two integral images and
+// the scratch of av1_selfguided_restoration()
+#define SGRPROJ_TMPBUF_SIZE                         \
+  (RESTORATION_TILEPELS_MAX * 4 * sizeof(int32_t) + \
+   SGRPROJ_INTIMG_SIZE * 2 * sizeof(uint32_t) + SGRPROJ_SGRBUF_SIZE)
+
 // Precision bits for projection
 #define SGRPROJ_PRJ_BITS 7
 // Restoration precision bits generated higher than source before projection
@@ -72,6 +87,11 @@ extern "C" {
 #define RESTORATION_HALFWIN1 (RESTORATION_HALFWIN + 1)
 #define RESTORATION_WIN (2 * RESTORATION_HALFWIN + 1)
 #define RESTORATION_WIN2 ((RESTORATION_WIN) * (RESTORATION_WIN))
+// Scratch of av1_compute_stats() for one tile, in int16_t: the tile and the
+// window around it, with their rows padded to a multiple of 8. A tile is at
+// most 1.5 times RESTORATION_TILESIZE_BIG in each dimension.
+#define WIENER_STATS_TMPBUF_SIZE \
+  (2 * RESTORATION_TILEPELS_MAX + 26 * (RESTORATION_TILESIZE_BIG * 3 / 2) + 78)
 
 #define RESTORATION_FILT_BITS 7
 #define RESTORATION_FILT_STEP (1 << RESTORATION_FILT_BITS)
@@ -201,8 +221,20 @@ static INLINE void av1_get_rest_tile_limits(
 
 extern const sgr_params_type sgr_params[SGRPROJ_PARAMS];
 
-void av1_selfguided_restoration(int64_t *dgd, int width, int height, int stride,
-                                int bit_depth, int r, int eps, void *tmpbuf);
+// Computes the integral images of src and of its square into sum and sumsq.
+// Both have SGRPROJ_BORDER extra rows and columns on each side plus a leading
+// row and column of zeros, so that a box of radius up to SGRPROJ_BORDER
+// around any pixel of the tile can be summed without clamping. The values are
+// only meaningful modulo 2^32, which is enough to recover every box sum.
+void av1_integral_images(const int32_t *src, int width, int height, int stride,
+                         uint32_t *sum, uint32_t *sumsq, int sum_stride);
+// Applies the final 3x3 step of the self-guided filter to the first and last
+// rows and columns, where the weights differ from the rest of the tile. A and
+// B are the coefficient planes with a stride of width.
+void av1_selfguided_filter_border(const int32_t *dgd, int width, int height,
+                                  int stride, const int32_t *A,
+                                  const int32_t *B, int32_t *dst,
+                                  int dst_stride);
 void av1_domaintxfmrf_restoration(uint8_t *dgd, int width, int height,
                                   int stride, int param);
 #if CONFIG_AOM_HIGHBITDEPTH
@@ -211,6 +243,9 @@ void av1_domaintxfmrf_restoration_highbd(uint16_t *dgd, int width, int height,
 #endif  // CONFIG_AOM_HIGHBITDEPTH
 void decode_xq(int *xqd, int *xq);
 int av1_bilateral_level_bits(const struct AV1Common *const cm);
+// Fills in the taps of the Wiener filters from their first
+// RESTORATION_HALFWIN taps, which are the ones that are coded.
+void av1_wiener_set_taps(WienerInfo *wiener_info);
 void av1_loop_restoration_init(RestorationInternal *rst, RestorationInfo *rsi,
                                int kf, int width, int height);
 void av1_loop_restoration_frame(YV12_BUFFER_CONFIG *frame, struct AV1Common *cm,
@@ -218,6 +253,56 @@ void av1_loop_restoration_frame(YV12_BUFFER_CONFIG *frame, struct AV1Common *cm,
                                 int partial_frame);
 void av1_loop_restoration_rows(YV12_BUFFER_CONFIG *frame, struct AV1Common *cm,
                                int start_mi_row, int end_mi_row, int y_only);
+
+// The rows of one plane covered by a restoration pass. tmpdata points to the
+// same rows of a scratch frame of the same size.
+typedef struct {
+  uint8_t *data;
+  uint8_t *tmpdata;
+  int width;
+  int height;
+  int stride;
+  int tmpstride;
+  int subsampling_x;
+  int subsampling_y;
+  // Rows copied into tmpdata so far.
+  int copied_rows;
+  // Next tile row to be restored by av1_loop_restoration_plane_rows().
+  int next_tile_row;
+} RestorationPlane;
+
+// Whether the tiles of a frame of the given type need SGRPROJ_TMPBUF_SIZE
+// bytes of scratch memory in av1_loop_restoration_tile().
+static INLINE int av1_restoration_uses_tmpbuf(RestorationType type) {
+  return type == RESTORE_SGRPROJ || type == RESTORE_SWITCHABLE;
+}
+
+// (Re)allocates the scratch frame used by av1_loop_restoration_plane_init().
+void av1_alloc_restoration_tmp_frame(YV12_BUFFER_CONFIG *tmp_buf,
+                                     struct AV1Common *cm);
+// Sets up the restoration of the given mi rows of a plane, after which its
+// tiles may be restored by av1_loop_restoration_tile(). The filters work in
+// place and read a few pixels into the neighbouring tiles, so tile (r, c) must
+// only be restored once tiles (r, c - 1), (r - 1, c) and (r - 1, c + 1) are
+// done, and before tiles (r, c + 1), (r + 1, c - 1) and (r + 1, c) start.
+void av1_loop_restoration_plane_init(RestorationPlane *rp,
+                                     YV12_BUFFER_CONFIG *frame,
+                                     YV12_BUFFER_CONFIG *tmp_buf,
+                                     struct AV1Common *cm, int plane,
+                                     int start_mi_row, int end_mi_row);
+// Copies the rows of the plane up to end into tmpdata, where the Wiener filter
+// reads the rows around each tile from. A row has to be copied after it has
+// been deblocked, and before any tile that reads it is restored.
+void av1_loop_restoration_copy_rows(RestorationPlane *rp,
+                                    const struct AV1Common *cm, int end);
+void av1_loop_restoration_tile(const RestorationPlane *rp,
+                               struct AV1Common *cm, int tile_idx,
+                               void *tmpbuf);
+// Restores, in order, the tile rows of the plane that only read the first
+// ready_rows rows, and returns how many rows of the plane are now restored.
+int av1_loop_restoration_plane_rows(RestorationPlane *rp,
+                                    struct AV1Common *cm, int ready_rows,
+                                    void *tmpbuf);
 void av1_loop_restoration_precal();
 #ifdef __cplusplus
 }  // extern "C"
@@ -9,6 +9,8 @@
  * PATENTS file, you can obtain it at www.aomedia.org/license/patent.
  */
 
+#include <assert.h>
+
 #include "./aom_config.h"
 #include "aom_dsp/aom_dsp_common.h"
 #include "aom_mem/aom_mem.h"
@@ -85,6 +87,22 @@ static INLINE void sync_write(AV1LfSync *const lf_sync, int r, int c,
 #endif  // CONFIG_MULTITHREAD
 }
 
+#if !CONFIG_PARALLEL_DEBLOCKING
+// Waits until the superblock row below row r has been decoded.
+static INLINE void sync_decoded(AV1LfSync *const lf_sync, int r) {
+  av1_loop_filter_wait_decoded_rows(lf_sync, AOMMIN(r + 2, lf_sync->rows));
+}
+#endif  // !CONFIG_PARALLEL_DEBLOCKING
+
+// Returns the first mi row of the next superblock row for a worker to filter,
+// or -1 once all of the rows have been taken.
+static INLINE int get_next_lf_row(AV1LfSync *const lf_sync,
+                                  LFWorkerData *const lf_data) {
+  const int job = aom_job_queue_pop(&lf_sync->job_queue,
+                                    (int)(lf_data - lf_sync->lfdata));
+  return job < 0 ? -1 : lf_data->start + job * lf_data->cm->mib_size;
+}
+
 #if !CONFIG_EXT_PARTITION_TYPES
 static INLINE enum lf_path get_loop_filter_path(
     int y_only, struct macroblockd_plane planes[MAX_MB_PLANE]) {
@@ -151,8 +169,7 @@ static int loop_filter_ver_row_worker(AV1LfSync *const lf_sync,
 #if !CONFIG_EXT_PARTITION_TYPES
   enum lf_path path = get_loop_filter_path(lf_data->y_only, lf_data->planes);
 #endif
-  for (mi_row = lf_data->start; mi_row < lf_data->stop;
-       mi_row += lf_sync->num_workers * lf_data->cm->mib_size) {
+  while ((mi_row = get_next_lf_row(lf_sync, lf_data)) >= 0) {
     MODE_INFO **const mi =
         lf_data->cm->mi_grid_visible + mi_row * lf_data->cm->mi_stride;
 
@@ -191,8 +208,7 @@ static int loop_filter_hor_row_worker(AV1LfSync *const lf_sync,
   enum lf_path path = get_loop_filter_path(lf_data->y_only, lf_data->planes);
 #endif
 
-  for (mi_row = lf_data->start; mi_row < lf_data->stop;
-       mi_row += lf_sync->num_workers * lf_data->cm->mib_size) {
+  while ((mi_row = get_next_lf_row(lf_sync, lf_data)) >= 0) {
     MODE_INFO **const mi =
         lf_data->cm->mi_grid_visible + mi_row * lf_data->cm->mi_stride;
 
@@ -243,11 +259,12 @@ static int loop_filter_row_worker(AV1LfSync *const lf_sync,
   exit(EXIT_FAILURE);
 #endif  // CONFIG_EXT_PARTITION
 
-  for (mi_row = lf_data->start; mi_row < lf_data->stop;
-       mi_row += lf_sync->num_workers * lf_data->cm->mib_size) {
+  while ((mi_row = get_next_lf_row(lf_sync, lf_data)) >= 0) {
     MODE_INFO **const mi =
         lf_data->cm->mi_grid_visible + mi_row * lf_data->cm->mi_stride;
 
+    sync_decoded(lf_sync, mi_row >> lf_data->cm->mib_size_log2);
+
     for (mi_col = 0; mi_col < lf_data->cm->mi_cols;
          mi_col += lf_data->cm->mib_size) {
       const int r = mi_row >> lf_data->cm->mib_size_log2;
@@ -290,14 +307,16 @@ static void loop_filter_rows_mt(YV12_BUFFER_CONFIG *frame, AV1_COMMON *cm,
                                 struct macroblockd_plane planes[MAX_MB_PLANE],
                                 int start, int stop, int y_only,
                                 AVxWorker *workers, int nworkers,
-                                AV1LfSync *lf_sync) {
+                                AV1LfSync *lf_sync, int decoding) {
   const AVxWorkerInterface *const winterface = aom_get_worker_interface();
   // Number of superblock rows and cols
   const int sb_rows = mi_rows_aligned_to_sb(cm) >> cm->mib_size_log2;
   // Decoder may allocate more threads than number of tiles based on user's
-  // input.
-  const int tile_cols = cm->tile_cols;
-  const int num_workers = AOMMIN(nworkers, tile_cols);
+  // input. While the frame is being decoded all of the given workers are
+  // used, as they would otherwise be idle.
+  const int num_tiles = cm->tile_cols * cm->tile_rows;
+  const int num_workers = decoding ? nworkers : AOMMIN(nworkers, num_tiles);
+  const int num_rows = (stop - start + cm->mib_size - 1) >> cm->mib_size_log2;
   int i;
 
 #if CONFIG_EXT_PARTITION
@@ -312,21 +331,26 @@ static void loop_filter_rows_mt(YV12_BUFFER_CONFIG *frame, AV1_COMMON *cm,
     av1_loop_filter_dealloc(lf_sync);
     av1_loop_filter_alloc(lf_sync, cm, sb_rows, cm->width, num_workers);
   }
+  // The workers share out the rows by this count.
+  lf_sync->num_workers = num_workers;
 
 // Set up loopfilter thread data.
 // The decoder is capping num_workers because it has been observed that using
 // more threads on the loopfilter than there are cores will hurt performance
 // on Android. This is because the system will only schedule the tile decode
-// workers on cores equal to the number of tile columns. Then if the decoder
-// tries to use more threads for the loopfilter, it will hurt performance
-// because of contention. If the multithreading code changes in the future
-// then the number of workers used by the loopfilter should be revisited.
+// workers on cores equal to the number of tiles. Then if the decoder tries
+// to use more threads for the loopfilter, it will hurt performance because
+// of contention. If the multithreading code changes in the future then the
+// number of workers used by the loopfilter should be revisited.
 
 #if CONFIG_PARALLEL_DEBLOCKING
+  (void)decoding;
   // Initialize cur_sb_col to -1 for all SB rows.
   memset(lf_sync->cur_sb_col, -1, sizeof(*lf_sync->cur_sb_col) * sb_rows);
 
   // Filter all the vertical edges in the whole frame
+  aom_job_queue_reset(&lf_sync->job_queue, num_workers, 1);
+  aom_job_queue_push_range(&lf_sync->job_queue, num_rows);
   for (i = 0; i < num_workers; ++i) {
     AVxWorker *const worker = &workers[i];
     LFWorkerData *const lf_data = &lf_sync->lfdata[i];
@@ -337,7 +361,7 @@ static void loop_filter_rows_mt(YV12_BUFFER_CONFIG *frame, AV1_COMMON *cm,
 
     // Loopfilter data
     av1_loop_filter_data_reset(lf_data, frame, cm, planes);
-    lf_data->start = start + i * cm->mib_size;
+    lf_data->start = start;
     lf_data->stop = stop;
     lf_data->y_only = y_only;
 
@@ -353,9 +377,12 @@ static void loop_filter_rows_mt(YV12_BUFFER_CONFIG *frame, AV1_COMMON *cm,
   for (i = 0; i < num_workers; ++i) {
     winterface->sync(&workers[i]);
   }
+  aom_job_queue_finish(&lf_sync->job_queue);
 
   memset(lf_sync->cur_sb_col, -1, sizeof(*lf_sync->cur_sb_col) * sb_rows);
   // Filter all the horizontal edges in the whole frame
+  aom_job_queue_reset(&lf_sync->job_queue, num_workers, 1);
+  aom_job_queue_push_range(&lf_sync->job_queue, num_rows);
   for (i = 0; i < num_workers; ++i) {
     AVxWorker *const worker = &workers[i];
     LFWorkerData *const lf_data = &lf_sync->lfdata[i];
@@ -366,7 +393,7 @@ static void loop_filter_rows_mt(YV12_BUFFER_CONFIG *frame, AV1_COMMON *cm,
 
     // Loopfilter data
     av1_loop_filter_data_reset(lf_data, frame, cm, planes);
-    lf_data->start = start + i * cm->mib_size;
+    lf_data->start = start;
     lf_data->stop = stop;
     lf_data->y_only = y_only;
 
@@ -382,9 +409,15 @@ static void loop_filter_rows_mt(YV12_BUFFER_CONFIG *frame, AV1_COMMON *cm,
   for (i = 0; i < num_workers; ++i) {
     winterface->sync(&workers[i]);
   }
+  aom_job_queue_finish(&lf_sync->job_queue);
 #else   // CONFIG_PARALLEL_DEBLOCKING
   // Initialize cur_sb_col to -1 for all SB rows.
   memset(lf_sync->cur_sb_col, -1, sizeof(*lf_sync->cur_sb_col) * sb_rows);
+  lf_sync->decoded_sb_rows = decoding ? 0 : sb_rows;
+  // The rows are taken in order, so the row above the one a worker waits
+  // for is always in progress.
+  aom_job_queue_reset(&lf_sync->job_queue, num_workers, 1);
+  aom_job_queue_push_range(&lf_sync->job_queue, num_rows);
 
   for (i = 0; i < num_workers; ++i) {
     AVxWorker *const worker = &workers[i];
@@ -396,12 +429,13 @@ static void loop_filter_rows_mt(YV12_BUFFER_CONFIG *frame, AV1_COMMON *cm,
 
     // Loopfilter data
     av1_loop_filter_data_reset(lf_data, frame, cm, planes);
-    lf_data->start = start + i * cm->mib_size;
+    lf_data->start = start;
     lf_data->stop = stop;
     lf_data->y_only = y_only;
 
-    // Start loopfiltering
-    if (i == num_workers - 1) {
+    // Start loopfiltering. The calling thread is busy decoding when the
+    // frame is filtered as it is decoded.
+    if (i == num_workers - 1 && !decoding) {
       winterface->execute(worker);
     } else {
       winterface->launch(worker);
@@ -409,8 +443,11 @@ static void loop_filter_rows_mt(YV12_BUFFER_CONFIG *frame, AV1_COMMON *cm,
   }
 
   // Wait till all rows are finished
-  for (i = 0; i < num_workers; ++i) {
-    winterface->sync(&workers[i]);
+  if (!decoding) {
+    for (i = 0; i < num_workers; ++i) {
+      winterface->sync(&workers[i]);
+    }
+    aom_job_queue_finish(&lf_sync->job_queue);
   }
 #endif  // CONFIG_PARALLEL_DEBLOCKING
 }
@@ -435,9 +472,73 @@ void av1_loop_filter_frame_mt(YV12_BUFFER_CONFIG *frame, AV1_COMMON *cm,
   av1_loop_filter_frame_init(cm, frame_filter_level);
 
   loop_filter_rows_mt(frame, cm, planes, start_mi_row, end_mi_row, y_only,
-                      workers, num_workers, lf_sync);
+                      workers, num_workers, lf_sync, 0);
+}
+
+#if !CONFIG_PARALLEL_DEBLOCKING
+void av1_loop_filter_frame_mt_start(
+    YV12_BUFFER_CONFIG *frame, AV1_COMMON *cm,
+    struct macroblockd_plane planes[MAX_MB_PLANE], int frame_filter_level,
+    AVxWorker *workers, int num_workers, AV1LfSync *lf_sync) {
+  assert(frame_filter_level && num_workers > 0);
+  av1_loop_filter_frame_init(cm, frame_filter_level);
+  loop_filter_rows_mt(frame, cm, planes, 0, cm->mi_rows, 0, workers,
+                      num_workers, lf_sync, 1);
 }
 
+void av1_loop_filter_decoded_rows(AV1LfSync *lf_sync, int sb_rows) {
+#if CONFIG_MULTITHREAD
+  // Nothing can be waiting before the sync data has been allocated.
+  if (lf_sync->decode_mutex_ == NULL) return;
+  mutex_lock(lf_sync->decode_mutex_);
+  lf_sync->decoded_sb_rows = sb_rows;
+  pthread_cond_broadcast(lf_sync->decode_cond_);
+  pthread_mutex_unlock(lf_sync->decode_mutex_);
+#else
+  lf_sync->decoded_sb_rows = sb_rows;
+#endif  // CONFIG_MULTITHREAD
+}
+
+void av1_loop_filter_decoding_start(AV1LfSync *lf_sync, AV1_COMMON *cm) {
+  const int sb_rows = mi_rows_aligned_to_sb(cm) >> cm->mib_size_log2;
+
+  if (!lf_sync->sync_range || sb_rows != lf_sync->rows) {
+    const int num_workers = AOMMAX(lf_sync->num_workers, 1);
+    av1_loop_filter_dealloc(lf_sync);
+    av1_loop_filter_alloc(lf_sync, cm, sb_rows, cm->width, num_workers);
+  }
+  lf_sync->decoded_sb_rows = 0;
+}
+
+int av1_loop_filter_wait_decoded_rows(AV1LfSync *lf_sync, int sb_rows) {
+  int decoded_sb_rows;
+#if CONFIG_MULTITHREAD
+  mutex_lock(lf_sync->decode_mutex_);
+  while (lf_sync->decoded_sb_rows < sb_rows) {
+    pthread_cond_wait(lf_sync->decode_cond_, lf_sync->decode_mutex_);
+  }
+  decoded_sb_rows = lf_sync->decoded_sb_rows;
+  pthread_mutex_unlock(lf_sync->decode_mutex_);
+#else
+  decoded_sb_rows = lf_sync->decoded_sb_rows;
+  (void)sb_rows;
+#endif  // CONFIG_MULTITHREAD
+  return decoded_sb_rows;
+}
+
+void av1_loop_filter_frame_mt_finish(AVxWorker *workers, int num_workers,
+                                     AV1LfSync *lf_sync) {
+  const AVxWorkerInterface *const winterface = aom_get_worker_interface();
+  int i;
+
+  av1_loop_filter_decoded_rows(lf_sync, lf_sync->rows);
+  for (i = 0; i < num_workers; ++i) {
+    winterface->sync(&workers[i]);
+  }
+  aom_job_queue_finish(&lf_sync->job_queue);
+}
+#endif  // !CONFIG_PARALLEL_DEBLOCKING
+
 // Set up nsync by width.
 static INLINE int get_sync_range(int width) {
   // nsync numbers are picked by testing. For example, for 4k
@@ -475,12 +576,23 @@ void av1_loop_filter_alloc(AV1LfSync *lf_sync, AV1_COMMON *cm, int rows,
         pthread_cond_init(&lf_sync->cond_[i], NULL);
       }
     }
+
+    CHECK_MEM_ERROR(cm, lf_sync->decode_mutex_,
+                    aom_malloc(sizeof(*lf_sync->decode_mutex_)));
+    if (lf_sync->decode_mutex_) pthread_mutex_init(lf_sync->decode_mutex_, NULL);
+
+    CHECK_MEM_ERROR(cm, lf_sync->decode_cond_,
+                    aom_malloc(sizeof(*lf_sync->decode_cond_)));
+    if (lf_sync->decode_cond_) pthread_cond_init(lf_sync->decode_cond_, NULL);
   }
 #endif  // CONFIG_MULTITHREAD
 
   CHECK_MEM_ERROR(cm, lf_sync->lfdata,
                   aom_malloc(num_workers * sizeof(*lf_sync->lfdata)));
   lf_sync->num_workers = num_workers;
+  if (!aom_job_queue_alloc(&lf_sync->job_queue, num_workers, rows))
+    aom_internal_error(&cm->error, AOM_CODEC_MEM_ERROR,
+                       "Failed to allocate lf_sync->job_queue");
 
   CHECK_MEM_ERROR(cm, lf_sync->cur_sb_col,
                   aom_malloc(sizeof(*lf_sync->cur_sb_col) * rows));
@@ -507,8 +619,17 @@ void av1_loop_filter_dealloc(AV1LfSync *lf_sync) {
       }
       aom_free(lf_sync->cond_);
     }
+    if (lf_sync->decode_mutex_ != NULL) {
+      pthread_mutex_destroy(lf_sync->decode_mutex_);
+      aom_free(lf_sync->decode_mutex_);
+    }
+    if (lf_sync->decode_cond_ != NULL) {
+      pthread_cond_destroy(lf_sync->decode_cond_);
+      aom_free(lf_sync->decode_cond_);
+    }
 #endif  // CONFIG_MULTITHREAD
     aom_free(lf_sync->lfdata);
+    aom_job_queue_dealloc(&lf_sync->job_queue);
     aom_free(lf_sync->cur_sb_col);
     // clear the structure as the source of this call may be a resize in which
     // case this call will be followed by an _alloc() which may fail.
@@ -516,6 +637,277 @@ void av1_loop_filter_dealloc(AV1LfSync *lf_sync) {
   }
 }
 
+#if CONFIG_DERING
+typedef struct DeringWorkerData {
+  const DeringFrame *df;
+  AV1_COMMON *cm;
+  // First superblock row handled by this worker.
+  int start;
+  int step;
+} DeringWorkerData;
+
+static int dering_row_worker(DeringWorkerData *const dw, void *unused) {
+  int sbr;
+  (void)unused;
+  for (sbr = dw->start; sbr < dw->df->nvsb; sbr += dw->step)
+    av1_dering_sb_row(dw->df, dw->cm, sbr);
+  return 1;
+}
+
+void av1_dering_frame_mt(YV12_BUFFER_CONFIG *frame, AV1_COMMON *cm,
+                         MACROBLOCKD *xd, int global_level, AVxWorker *workers,
+                         int nworkers) {
+  const AVxWorkerInterface *const winterface = aom_get_worker_interface();
+  DeringFrame df;
+  DeringWorkerData *dwd;
+  int num_workers;
+  int i;
+
+  av1_dering_frame_init(&df, frame, cm, xd, global_level);
+  for (i = 1; i < df.nvsb; ++i) av1_dering_save_lines(&df, cm, i);
+  num_workers = AOMMIN(nworkers, df.nvsb);
+  CHECK_MEM_ERROR(cm, dwd, aom_malloc(num_workers * sizeof(*dwd)));
+
+  for (i = 0; i < num_workers; ++i) {
+    AVxWorker *const worker = &workers[i];
+
+    worker->hook = (AVxWorkerHook)dering_row_worker;
+    worker->data1 = &dwd[i];
+    worker->data2 = NULL;
+
+    dwd[i].df = &df;
+    dwd[i].cm = cm;
+    dwd[i].start = i;
+    dwd[i].step = num_workers;
+
+    // Start deringing
+    if (i == num_workers - 1) {
+      winterface->execute(worker);
+    } else {
+      winterface->launch(worker);
+    }
+  }
+
+  // Wait till all rows are finished
+  for (i = 0; i < num_workers; ++i) {
+    winterface->sync(&workers[i]);
+  }
+
+  aom_free(dwd);
+  av1_dering_frame_free(&df);
+}
+#endif  // CONFIG_DERING
+
+#if CONFIG_LOOP_RESTORATION
+static INLINE void lr_sync_read(AV1LrSync *const lr_sync, int r, int c) {
+#if CONFIG_MULTITHREAD
+  if (r) {
+    pthread_mutex_t *const mutex = &lr_sync->mutex_[r - 1];
+    mutex_lock(mutex);
+
+    // Wait for tile (r - 1, c + 1), which tile (r, c) reads from.
+    while (c >= lr_sync->cur_tile_col[r - 1]) {
+      pthread_cond_wait(&lr_sync->cond_[r - 1], mutex);
+    }
+    pthread_mutex_unlock(mutex);
+  }
+#else
+  (void)lr_sync;
+  (void)r;
+  (void)c;
+#endif  // CONFIG_MULTITHREAD
+}
+
+static INLINE void lr_sync_write(AV1LrSync *const lr_sync, int r, int c,
+                                 const int tile_cols) {
+#if CONFIG_MULTITHREAD
+  mutex_lock(&lr_sync->mutex_[r]);
+
+  lr_sync->cur_tile_col[r] = c < tile_cols - 1 ? c : tile_cols;
+
+  pthread_cond_signal(&lr_sync->cond_[r]);
+  pthread_mutex_unlock(&lr_sync->mutex_[r]);
+#else
+  (void)lr_sync;
+  (void)r;
+  (void)c;
+  (void)tile_cols;
+#endif  // CONFIG_MULTITHREAD
+}
+
+static int loop_restoration_row_worker(AV1LrSync *const lr_sync,
+                                       LRWorkerData *const lr_data) {
+  const RestorationInternal *const rst = &lr_data->cm->rst_internal;
+  const int thread = (int)(lr_data - lr_sync->lrdata);
+  int r, c;
+
+  while ((r = aom_job_queue_pop(&lr_sync->job_queue, thread)) >= 0) {
+    for (c = 0; c < rst->nhtiles; ++c) {
+      lr_sync_read(lr_sync, r, c);
+      av1_loop_restoration_tile(lr_data->rp, lr_data->cm, r * rst->nhtiles + c,
+                                lr_data->tmpbuf);
+      lr_sync_write(lr_sync, r, c, rst->nhtiles);
+    }
+  }
+  return 1;
+}
+
+static void loop_restoration_rows_mt(YV12_BUFFER_CONFIG *frame, AV1_COMMON *cm,
+                                     int start, int stop, int y_only,
+                                     AVxWorker *workers, int nworkers,
+                                     AV1LrSync *lr_sync) {
+  const AVxWorkerInterface *const winterface = aom_get_worker_interface();
+  const RestorationInternal *const rst = &cm->rst_internal;
+  const int num_planes = y_only ? 1 : MAX_MB_PLANE;
+  const int num_workers = AOMMIN(nworkers, rst->nvtiles);
+  int plane, i;
+
+  if (rst->nvtiles != lr_sync->rows || num_workers != lr_sync->num_workers) {
+    av1_loop_restoration_dealloc(lr_sync);
+    av1_loop_restoration_alloc(lr_sync, cm, rst->nvtiles, num_workers);
+  }
+  if (av1_restoration_uses_tmpbuf(rst->rsi->frame_restoration_type)) {
+    for (i = 0; i < num_workers; ++i) {
+      if (lr_sync->lrdata[i].tmpbuf == NULL)
+        CHECK_MEM_ERROR(cm, lr_sync->lrdata[i].tmpbuf,
+                        aom_malloc(SGRPROJ_TMPBUF_SIZE));
+    }
+  }
+  av1_alloc_restoration_tmp_frame(&lr_sync->tmp_buf, cm);
+
+  for (plane = 0; plane < num_planes; ++plane) {
+    RestorationPlane rp;
+    av1_loop_restoration_plane_init(&rp, frame, &lr_sync->tmp_buf, cm, plane,
+                                    start, stop);
+    av1_loop_restoration_copy_rows(&rp, cm, rp.height);
+
+    // Initialize cur_tile_col to -1 for all tile rows.
+    memset(lr_sync->cur_tile_col, -1,
+           sizeof(*lr_sync->cur_tile_col) * lr_sync->rows);
+    // Each row waits for the row above, so the rows are taken in order.
+    aom_job_queue_reset(&lr_sync->job_queue, num_workers, 1);
+    aom_job_queue_push_range(&lr_sync->job_queue, rst->nvtiles);
+
+    for (i = 0; i < num_workers; ++i) {
+      AVxWorker *const worker = &workers[i];
+      LRWorkerData *const lr_data = &lr_sync->lrdata[i];
+
+      worker->hook = (AVxWorkerHook)loop_restoration_row_worker;
+      worker->data1 = lr_sync;
+      worker->data2 = lr_data;
+
+      lr_data->cm = cm;
+      lr_data->rp = &rp;
+
+      // Start loop restoration
+      if (i == num_workers - 1) {
+        winterface->execute(worker);
+      } else {
+        winterface->launch(worker);
+      }
+    }
+
+    // Wait till all rows are finished
+    for (i = 0; i < num_workers; ++i) {
+      winterface->sync(&workers[i]);
+    }
+    aom_job_queue_finish(&lr_sync->job_queue);
+  }
+}
+
+void av1_loop_restoration_frame_mt(YV12_BUFFER_CONFIG *frame, AV1_COMMON *cm,
+                                   RestorationInfo *rsi, int y_only,
+                                   int partial_frame, AVxWorker *workers,
+                                   int num_workers, AV1LrSync *lr_sync) {
+  int start_mi_row, end_mi_row, mi_rows_to_filter;
+
+  if (rsi->frame_restoration_type == RESTORE_NONE) return;
+
+  start_mi_row = 0;
+  mi_rows_to_filter = cm->mi_rows;
+  if (partial_frame && cm->mi_rows > 8) {
+    start_mi_row = cm->mi_rows >> 1;
+    start_mi_row &= 0xfffffff8;
+    mi_rows_to_filter = AOMMAX(cm->mi_rows / 8, 8);
+  }
+  end_mi_row = start_mi_row + mi_rows_to_filter;
+  av1_loop_restoration_init(&cm->rst_internal, rsi, cm->frame_type == KEY_FRAME,
+                            cm->width, cm->height);
+
+  loop_restoration_rows_mt(frame, cm, start_mi_row, end_mi_row, y_only,
+                           workers, num_workers, lr_sync);
+}
+
+// Allocate memory for loop restoration row synchronization
+void av1_loop_restoration_alloc(AV1LrSync *lr_sync, AV1_COMMON *cm, int rows,
+                                int num_workers) {
+  lr_sync->rows = rows;
+#if CONFIG_MULTITHREAD
+  {
+    int i;
+
+    CHECK_MEM_ERROR(cm, lr_sync->mutex_,
+                    aom_malloc(sizeof(*lr_sync->mutex_) * rows));
+    if (lr_sync->mutex_) {
+      for (i = 0; i < rows; ++i) {
+        pthread_mutex_init(&lr_sync->mutex_[i], NULL);
+      }
+    }
+
+    CHECK_MEM_ERROR(cm, lr_sync->cond_,
+                    aom_malloc(sizeof(*lr_sync->cond_) * rows));
+    if (lr_sync->cond_) {
+      for (i = 0; i < rows; ++i) {
+        pthread_cond_init(&lr_sync->cond_[i], NULL);
+      }
+    }
+  }
+#endif  // CONFIG_MULTITHREAD
+
+  CHECK_MEM_ERROR(cm, lr_sync->lrdata,
+                  aom_calloc(num_workers, sizeof(*lr_sync->lrdata)));
+  lr_sync->num_workers = num_workers;
+  if (!aom_job_queue_alloc(&lr_sync->job_queue, num_workers, rows))
+    aom_internal_error(&cm->error, AOM_CODEC_MEM_ERROR,
+                       "Failed to allocate lr_sync->job_queue");
+
+  CHECK_MEM_ERROR(cm, lr_sync->cur_tile_col,
+                  aom_malloc(sizeof(*lr_sync->cur_tile_col) * rows));
+}
+
+// Deallocate loop restoration synchronization related mutex and data
+void av1_loop_restoration_dealloc(AV1LrSync *lr_sync) {
+  if (lr_sync != NULL) {
+    int i;
+#if CONFIG_MULTITHREAD
+    if (lr_sync->mutex_ != NULL) {
+      for (i = 0; i < lr_sync->rows; ++i) {
+        pthread_mutex_destroy(&lr_sync->mutex_[i]);
+      }
+      aom_free(lr_sync->mutex_);
+    }
+    if (lr_sync->cond_ != NULL) {
+      for (i = 0; i < lr_sync->rows; ++i) {
+        pthread_cond_destroy(&lr_sync->cond_[i]);
+      }
+      aom_free(lr_sync->cond_);
+    }
+#endif  // CONFIG_MULTITHREAD
+    if (lr_sync->lrdata != NULL) {
+      for (i = 0; i < lr_sync->num_workers; ++i)
+        aom_free(lr_sync->lrdata[i].tmpbuf);
+      aom_free(lr_sync->lrdata);
+    }
+    aom_job_queue_dealloc(&lr_sync->job_queue);
+    aom_free(lr_sync->cur_tile_col);
+    aom_free_frame_buffer(&lr_sync->tmp_buf);
+    // clear the structure as the source of this call may be a resize in which
+    // case this call will be followed by an _alloc() which may fail.
+    av1_zero(*lr_sync);
+  }
+}
+#endif  // CONFIG_LOOP_RESTORATION
+
 // Accumulate frame counts. FRAME_COUNTS consist solely of 'unsigned int'
 // members, so we treat it as an array, and sum over the whole length.
 void av1_accumulate_frame_counts(AV1_COMMON *cm, FRAME_COUNTS *counts) {
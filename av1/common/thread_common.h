@@ -13,6 +13,13 @@
 #define AV1_COMMON_LOOPFILTER_THREAD_H_
 #include "./aom_config.h"
 #include "av1/common/loopfilter.h"
+#if CONFIG_DERING
+#include "av1/common/dering.h"
+#endif  // CONFIG_DERING
+#if CONFIG_LOOP_RESTORATION
+#include "av1/common/restoration.h"
+#endif  // CONFIG_LOOP_RESTORATION
+#include "aom_util/aom_job_queue.h"
 #include "aom_util/aom_thread.h"
 
 #ifdef __cplusplus
@@ -38,6 +45,16 @@ typedef struct AV1LfSyncData {
   // Row-based parallel loopfilter data
   LFWorkerData *lfdata;
   int num_workers;
+  // The superblock rows, dealt out to the workers in turn.
+  AOMJobQueue job_queue;
+
+  // The number of superblock rows that have been decoded. The loop filter
+  // stays a superblock row behind it when it runs alongside decoding.
+  int decoded_sb_rows;
+#if CONFIG_MULTITHREAD
+  pthread_mutex_t *decode_mutex_;
+  pthread_cond_t *decode_cond_;
+#endif
 } AV1LfSync;
 
 // Allocate memory for loopfilter row synchronization.
@@ -54,6 +71,86 @@ void av1_loop_filter_frame_mt(YV12_BUFFER_CONFIG *frame, struct AV1Common *cm,
                               int partial_frame, AVxWorker *workers,
                               int num_workers, AV1LfSync *lf_sync);
 
+#if !CONFIG_PARALLEL_DEBLOCKING
+// Starts the multi-threaded loopfilter on all of the given workers while the
+// frame is still being decoded. Each superblock row is filtered once the row
+// below it has been reported by av1_loop_filter_decoded_rows(), so that intra
+// prediction still sees the unfiltered pixels.
+void av1_loop_filter_frame_mt_start(
+    YV12_BUFFER_CONFIG *frame, struct AV1Common *cm,
+    struct macroblockd_plane planes[MAX_MB_PLANE], int frame_filter_level,
+    AVxWorker *workers, int num_workers, AV1LfSync *lf_sync);
+
+// Reports the number of superblock rows that have been decoded. Passing the
+// number of superblock rows in the frame, or more, releases all of the rows.
+void av1_loop_filter_decoded_rows(AV1LfSync *lf_sync, int sb_rows);
+
+// Prepares lf_sync to pass the decoding progress of a frame, with no rows
+// decoded yet, to a thread that is not one of the loopfilter workers.
+void av1_loop_filter_decoding_start(AV1LfSync *lf_sync, struct AV1Common *cm);
+
+// Waits until at least sb_rows superblock rows have been reported decoded, and
+// returns the number that have been.
+int av1_loop_filter_wait_decoded_rows(AV1LfSync *lf_sync, int sb_rows);
+
+// Waits for a loopfilter started by av1_loop_filter_frame_mt_start().
+void av1_loop_filter_frame_mt_finish(AVxWorker *workers, int num_workers,
+                                     AV1LfSync *lf_sync);
+#endif  // !CONFIG_PARALLEL_DEBLOCKING
+
+#if CONFIG_DERING
+// Multi-threaded deringing. The superblock rows are shared out between the
+// workers, each of which uses its own scratch buffers.
+void av1_dering_frame_mt(YV12_BUFFER_CONFIG *frame, struct AV1Common *cm,
+                         MACROBLOCKD *xd, int global_level, AVxWorker *workers,
+                         int num_workers);
+#endif  // CONFIG_DERING
+
+#if CONFIG_LOOP_RESTORATION
+typedef struct LRWorkerData {
+  struct AV1Common *cm;
+  const RestorationPlane *rp;
+  // SGRPROJ_TMPBUF_SIZE bytes of scratch memory, allocated on first use.
+  void *tmpbuf;
+} LRWorkerData;
+
+// Loop restoration tile row synchronization
+typedef struct AV1LrSyncData {
+#if CONFIG_MULTITHREAD
+  pthread_mutex_t *mutex_;
+  pthread_cond_t *cond_;
+#endif
+  // Allocate memory to store the restored tile index in each tile row.
+  int *cur_tile_col;
+  int rows;
+
+  // Row-based parallel loop restoration data
+  LRWorkerData *lrdata;
+  int num_workers;
+  // The restoration tile rows, taken by the workers in order.
+  AOMJobQueue job_queue;
+
+  // Scratch frame shared by the workers.
+  YV12_BUFFER_CONFIG tmp_buf;
+} AV1LrSync;
+
+// Allocate memory for loop restoration row synchronization.
+void av1_loop_restoration_alloc(AV1LrSync *lr_sync, struct AV1Common *cm,
+                                int rows, int num_workers);
+
+// Deallocate loop restoration synchronization related mutex and data.
+void av1_loop_restoration_dealloc(AV1LrSync *lr_sync);
+
+// Multi-threaded loop restoration. Each worker restores whole rows of
+// restoration tiles, staying one tile behind the row above, so that the
+// result matches av1_loop_restoration_frame().
+void av1_loop_restoration_frame_mt(YV12_BUFFER_CONFIG *frame,
+                                   struct AV1Common *cm, RestorationInfo *rsi,
+                                   int y_only, int partial_frame,
+                                   AVxWorker *workers, int num_workers,
+                                   AV1LrSync *lr_sync);
+#endif  // CONFIG_LOOP_RESTORATION
+
 void av1_accumulate_frame_counts(struct AV1Common *cm,
                                  struct FRAME_COUNTS *counts);
 
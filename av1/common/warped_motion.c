@@ -15,6 +15,7 @@
 #include <math.h>
 #include <assert.h>
 
+#include "./av1_rtcd.h"
 #include "av1/common/warped_motion.h"
 
 /* clang-format off */
@@ -87,16 +88,6 @@ static const int error_measure_lut[512] = {
 };
 /* clang-format on */
 
-static ProjectPointsFunc get_project_points_type(TransformationType type) {
-  switch (type) {
-    case HOMOGRAPHY: return project_points_homography;
-    case AFFINE: return project_points_affine;
-    case ROTZOOM: return project_points_rotzoom;
-    case TRANSLATION: return project_points_translation;
-    default: assert(0); return NULL;
-  }
-}
-
 void project_points_translation(int32_t *mat, int *points, int *proj,
                                 const int n, const int stride_points,
                                 const int stride_proj, const int subsampling_x,
@@ -233,8 +224,10 @@ void project_points(WarpedMotionParams *wm_params, int *points, int *proj,
   }
 }
 
-static const int16_t
-    filter_ntap[WARPEDPIXEL_PREC_SHIFTS][WARPEDPIXEL_FILTER_TAPS] = {
+// The rows are padded to 8 taps with zeros, so that SIMD versions of the
+// filter can load a whole row of coefficients at once.
+DECLARE_ALIGNED(16, const int16_t,
+                av1_warped_filter[WARPEDPIXEL_PREC_SHIFTS][8]) = {
       { 0, 0, 128, 0, 0, 0 },      { 0, -1, 128, 2, -1, 0 },
       { 1, -3, 127, 4, -1, 0 },    { 1, -4, 126, 6, -2, 1 },
       { 1, -5, 126, 8, -3, 1 },    { 1, -6, 125, 11, -4, 1 },
@@ -273,7 +266,7 @@ static int32_t do_ntap_filter(int32_t *p, int x) {
   int i;
   int32_t sum = 0;
   for (i = 0; i < WARPEDPIXEL_FILTER_TAPS; ++i) {
-    sum += p[i - WARPEDPIXEL_FILTER_TAPS / 2 + 1] * filter_ntap[x][i];
+    sum += p[i - WARPEDPIXEL_FILTER_TAPS / 2 + 1] * av1_warped_filter[x][i];
   }
   return sum;
 }
@@ -406,6 +399,162 @@ static uint8_t warp_interpolate(uint8_t *ref, int x, int y, int width,
   }
 }
 
+// The warp is evaluated over blocks of up to WARP_BLOCK_SIZE x WARP_BLOCK_SIZE
+// pixels. Blocks that project entirely inside the region where the ntap
+// filter applies are filtered with av1_warp_filter_block(); the others fall
+// back to the per-pixel interpolation, which handles the frame edges.
+#define WARP_BLOCK_SIZE 8
+
+typedef struct {
+  const WarpedMotionParams *wm;
+  int subsampling_x, subsampling_y;
+  int x_scale, y_scale;
+  // For the models other than homographies, the unrounded projection of
+  // each axis is coeff[0] * x + coeff[1] * y + coeff[2], rounded down by
+  // shift. It is stepped along the rows of a block instead of being
+  // recomputed for each pixel.
+  int64_t coeff[2][3];
+  int shift[2];
+} WarpProjection;
+
+// Returns 0 if the model type cannot be warped.
+static int init_warp_projection(WarpProjection *proj,
+                                const WarpedMotionParams *wm,
+                                int subsampling_x, int subsampling_y,
+                                int x_scale, int y_scale) {
+  const int32_t *mat = wm->wmmat;
+  const int32_t one = 1 << WARPEDMODEL_PREC_BITS;
+  int32_t a[2], b[2], c[2];
+  int axis;
+  proj->wm = wm;
+  proj->subsampling_x = subsampling_x;
+  proj->subsampling_y = subsampling_y;
+  proj->x_scale = x_scale;
+  proj->y_scale = y_scale;
+  switch (wm->wmtype) {
+    case TRANSLATION:
+      a[0] = one, b[0] = 0, a[1] = 0, b[1] = one;
+      break;
+    case ROTZOOM:
+      a[0] = mat[2], b[0] = mat[3], a[1] = -mat[3], b[1] = mat[2];
+      break;
+    case AFFINE:
+      a[0] = mat[2], b[0] = mat[3], a[1] = mat[4], b[1] = mat[5];
+      break;
+    case HOMOGRAPHY: return 1;
+    default: assert(0 && "Invalid warped motion type!"); return 0;
+  }
+  c[0] = mat[0];
+  c[1] = mat[1];
+  // Same arithmetic as the project_points_*() functions
+  for (axis = 0; axis < 2; ++axis) {
+    const int ss = axis ? subsampling_y : subsampling_x;
+    if (ss) {
+      proj->coeff[axis][0] = 2 * (int64_t)a[axis];
+      proj->coeff[axis][1] = 2 * (int64_t)b[axis];
+      proj->coeff[axis][2] = c[axis] + (a[axis] + b[axis] - one) / 2;
+      proj->shift[axis] = WARPEDDIFF_PREC_BITS + 1;
+    } else {
+      proj->coeff[axis][0] = a[axis];
+      proj->coeff[axis][1] = b[axis];
+      proj->coeff[axis][2] = c[axis];
+      proj->shift[axis] = WARPEDDIFF_PREC_BITS;
+    }
+  }
+  return 1;
+}
+
+// Writes the source positions of the bw x bh block at (col, row), scaled up
+// by 1 << WARPEDPIXEL_PREC_BITS, as (x, y) pairs in raster order.
+static void project_block(const WarpProjection *proj, int col, int row,
+                          int bw, int bh, int *pts) {
+  int i, j;
+  for (i = 0; i < bh; ++i) {
+    if (proj->wm->wmtype == HOMOGRAPHY) {
+      for (j = 0; j < bw; ++j) {
+        int in[2];
+        in[0] = col + j;
+        in[1] = row + i;
+        project_points_homography((int32_t *)proj->wm->wmmat, in, pts, 1, 2,
+                                  2, proj->subsampling_x,
+                                  proj->subsampling_y);
+        pts[0] = ROUND_POWER_OF_TWO_SIGNED(pts[0] * proj->x_scale, 4);
+        pts[1] = ROUND_POWER_OF_TWO_SIGNED(pts[1] * proj->y_scale, 4);
+        pts += 2;
+      }
+    } else {
+      int64_t vx = proj->coeff[0][0] * col + proj->coeff[0][1] * (row + i) +
+                   proj->coeff[0][2];
+      int64_t vy = proj->coeff[1][0] * col + proj->coeff[1][1] * (row + i) +
+                   proj->coeff[1][2];
+      for (j = 0; j < bw; ++j) {
+        const int x = (int)ROUND_POWER_OF_TWO_SIGNED(vx, proj->shift[0]);
+        const int y = (int)ROUND_POWER_OF_TWO_SIGNED(vy, proj->shift[1]);
+        pts[0] = ROUND_POWER_OF_TWO_SIGNED(x * proj->x_scale, 4);
+        pts[1] = ROUND_POWER_OF_TWO_SIGNED(y * proj->y_scale, 4);
+        vx += proj->coeff[0][0];
+        vy += proj->coeff[1][0];
+        pts += 2;
+      }
+    }
+  }
+}
+
+static int block_is_interior(const int *pts, int n, int width, int height) {
+  int i;
+  for (i = 0; i < n; ++i) {
+    const int ix = pts[2 * i] >> WARPEDPIXEL_PREC_BITS;
+    const int iy = pts[2 * i + 1] >> WARPEDPIXEL_PREC_BITS;
+    if (ix < WARPEDPIXEL_FILTER_TAPS / 2 - 1 ||
+        iy < WARPEDPIXEL_FILTER_TAPS / 2 - 1 ||
+        ix >= width - WARPEDPIXEL_FILTER_TAPS / 2 ||
+        iy >= height - WARPEDPIXEL_FILTER_TAPS / 2)
+      return 0;
+  }
+  return 1;
+}
+
+// Same result as bi_ntap_filter(), with the horizontal pass done first.
+// There is no rounding between the passes, so the order does not matter.
+void av1_warp_filter_block_c(const uint8_t *ref, int stride, const int *pts,
+                             int n, uint8_t *pred) {
+  int i, k, l;
+  for (i = 0; i < n; ++i) {
+    const int x = pts[2 * i], y = pts[2 * i + 1];
+    const int ix = x >> WARPEDPIXEL_PREC_BITS;
+    const int iy = y >> WARPEDPIXEL_PREC_BITS;
+    const int16_t *fx = av1_warped_filter[x - (ix << WARPEDPIXEL_PREC_BITS)];
+    const int16_t *fy = av1_warped_filter[y - (iy << WARPEDPIXEL_PREC_BITS)];
+    const uint8_t *p = ref + (iy - WARPEDPIXEL_FILTER_TAPS / 2 + 1) * stride +
+                       ix - WARPEDPIXEL_FILTER_TAPS / 2 + 1;
+    int32_t sum = 0;
+    for (k = 0; k < WARPEDPIXEL_FILTER_TAPS; ++k) {
+      int32_t row_sum = 0;
+      for (l = 0; l < WARPEDPIXEL_FILTER_TAPS; ++l) row_sum += p[l] * fx[l];
+      sum += row_sum * fy[k];
+      p += stride;
+    }
+    pred[i] = clip_pixel(
+        ROUND_POWER_OF_TWO_SIGNED(sum, WARPEDPIXEL_FILTER_BITS * 2));
+  }
+}
+
+static void warp_block(const WarpProjection *proj, uint8_t *ref, int width,
+                       int height, int stride, int col, int row, int bw,
+                       int bh, uint8_t *pred) {
+  int pts[2 * WARP_BLOCK_SIZE * WARP_BLOCK_SIZE];
+  const int n = bw * bh;
+  int i;
+  project_block(proj, col, row, bw, bh, pts);
+  if (block_is_interior(pts, n, width, height)) {
+    av1_warp_filter_block(ref, stride, pts, n, pred);
+  } else {
+    for (i = 0; i < n; ++i)
+      pred[i] = warp_interpolate(ref, pts[2 * i], pts[2 * i + 1], width,
+                                 height, stride);
+  }
+}
+
 #if CONFIG_AOM_HIGHBITDEPTH
 static INLINE void highbd_get_subcolumn(int taps, uint16_t *ref, int32_t *col,
                                         int stride, int x, int y_start) {
@@ -520,6 +669,47 @@ static uint16_t highbd_warp_interpolate(uint16_t *ref, int x, int y, int width,
   }
 }
 
+void av1_highbd_warp_filter_block_c(const uint16_t *ref, int stride,
+                                    const int *pts, int n, uint16_t *pred,
+                                    int bd) {
+  int i, k, l;
+  for (i = 0; i < n; ++i) {
+    const int x = pts[2 * i], y = pts[2 * i + 1];
+    const int ix = x >> WARPEDPIXEL_PREC_BITS;
+    const int iy = y >> WARPEDPIXEL_PREC_BITS;
+    const int16_t *fx = av1_warped_filter[x - (ix << WARPEDPIXEL_PREC_BITS)];
+    const int16_t *fy = av1_warped_filter[y - (iy << WARPEDPIXEL_PREC_BITS)];
+    const uint16_t *p = ref + (iy - WARPEDPIXEL_FILTER_TAPS / 2 + 1) * stride +
+                        ix - WARPEDPIXEL_FILTER_TAPS / 2 + 1;
+    int32_t sum = 0;
+    for (k = 0; k < WARPEDPIXEL_FILTER_TAPS; ++k) {
+      int32_t row_sum = 0;
+      for (l = 0; l < WARPEDPIXEL_FILTER_TAPS; ++l) row_sum += p[l] * fx[l];
+      sum += row_sum * fy[k];
+      p += stride;
+    }
+    pred[i] = clip_pixel_highbd(
+        ROUND_POWER_OF_TWO_SIGNED(sum, WARPEDPIXEL_FILTER_BITS * 2), bd);
+  }
+}
+
+static void highbd_warp_block(const WarpProjection *proj, uint16_t *ref,
+                              int width, int height, int stride, int col,
+                              int row, int bw, int bh, int bd,
+                              uint16_t *pred) {
+  int pts[2 * WARP_BLOCK_SIZE * WARP_BLOCK_SIZE];
+  const int n = bw * bh;
+  int i;
+  project_block(proj, col, row, bw, bh, pts);
+  if (block_is_interior(pts, n, width, height)) {
+    av1_highbd_warp_filter_block(ref, stride, pts, n, pred, bd);
+  } else {
+    for (i = 0; i < n; ++i)
+      pred[i] = highbd_warp_interpolate(ref, pts[2 * i], pts[2 * i + 1], width,
+                                        height, stride, bd);
+  }
+}
+
 static INLINE int highbd_error_measure(int err, int bd) {
   const int b = bd - 8;
   const int bmask = (1 << b) - 1;
@@ -532,36 +722,64 @@ static INLINE int highbd_error_measure(int err, int bd) {
          error_measure_lut[256 + e1] * e2;
 }
 
-static double highbd_warp_erroradv(WarpedMotionParams *wm, uint8_t *ref8,
-                                   int width, int height, int stride,
-                                   uint8_t *dst8, int p_col, int p_row,
-                                   int p_width, int p_height, int p_stride,
-                                   int subsampling_x, int subsampling_y,
-                                   int x_scale, int y_scale, int bd) {
-  int i, j;
-  ProjectPointsFunc projectpoints = get_project_points_type(wm->wmtype);
+static int64_t highbd_warp_error(WarpedMotionParams *wm, uint8_t *ref8,
+                                 int width, int height, int stride,
+                                 uint8_t *dst8, int p_col, int p_row,
+                                 int p_width, int p_height, int p_stride,
+                                 int subsampling_x, int subsampling_y,
+                                 int x_scale, int y_scale, int bd,
+                                 int64_t best_err) {
+  int i, j, k, l;
+  WarpProjection proj;
   uint16_t *dst = CONVERT_TO_SHORTPTR(dst8);
   uint16_t *ref = CONVERT_TO_SHORTPTR(ref8);
-  int gm_err = 0, no_gm_err = 0;
-  int64_t gm_sumerr = 0, no_gm_sumerr = 0;
-  for (i = p_row; i < p_row + p_height; ++i) {
-    for (j = p_col; j < p_col + p_width; ++j) {
-      int in[2], out[2];
-      in[0] = j;
-      in[1] = i;
-      projectpoints(wm->wmmat, in, out, 1, 2, 2, subsampling_x, subsampling_y);
-      out[0] = ROUND_POWER_OF_TWO_SIGNED(out[0] * x_scale, 4);
-      out[1] = ROUND_POWER_OF_TWO_SIGNED(out[1] * y_scale, 4);
-      gm_err = dst[(j - p_col) + (i - p_row) * p_stride] -
-               highbd_warp_interpolate(ref, out[0], out[1], width, height,
-                                       stride, bd);
-      no_gm_err =
-          dst[(j - p_col) + (i - p_row) * p_stride] - ref[j + i * stride];
-      gm_sumerr += highbd_error_measure(gm_err, bd);
-      no_gm_sumerr += highbd_error_measure(no_gm_err, bd);
+  uint16_t block[WARP_BLOCK_SIZE * WARP_BLOCK_SIZE];
+  int64_t gm_sumerr = 0;
+  if (!init_warp_projection(&proj, wm, subsampling_x, subsampling_y, x_scale,
+                            y_scale))
+    return 0;
+  for (i = p_row; i < p_row + p_height; i += WARP_BLOCK_SIZE) {
+    const int bh = AOMMIN(WARP_BLOCK_SIZE, p_row + p_height - i);
+    for (j = p_col; j < p_col + p_width; j += WARP_BLOCK_SIZE) {
+      const int bw = AOMMIN(WARP_BLOCK_SIZE, p_col + p_width - j);
+      const uint16_t *b = block;
+      const uint16_t *d = dst + (i - p_row) * p_stride + (j - p_col);
+      highbd_warp_block(&proj, ref, width, height, stride, j, i, bw, bh, bd,
+                        block);
+      for (k = 0; k < bh; ++k) {
+        for (l = 0; l < bw; ++l)
+          gm_sumerr += highbd_error_measure(d[l] - b[l], bd);
+        b += bw;
+        d += p_stride;
+      }
+      if (gm_sumerr >= best_err) return gm_sumerr;
     }
   }
-  return (double)gm_sumerr / no_gm_sumerr;
+  return gm_sumerr;
+}
+
+static int64_t highbd_frame_error(uint8_t *ref8, int stride, uint8_t *dst8,
+                                  int p_col, int p_row, int p_width,
+                                  int p_height, int p_stride, int bd) {
+  int i, j, k, l;
+  uint16_t *dst = CONVERT_TO_SHORTPTR(dst8);
+  uint16_t *ref = CONVERT_TO_SHORTPTR(ref8);
+  int64_t sum_error = 0;
+  for (i = p_row; i < p_row + p_height; i += WARP_BLOCK_SIZE) {
+    const int bh = AOMMIN(WARP_BLOCK_SIZE, p_row + p_height - i);
+    for (j = p_col; j < p_col + p_width; j += WARP_BLOCK_SIZE) {
+      const int bw = AOMMIN(WARP_BLOCK_SIZE, p_col + p_width - j);
+      const uint16_t *d = dst + (i - p_row) * p_stride + (j - p_col);
+      const uint16_t *r = ref + i * stride + j;
+      for (k = 0; k < bh; ++k) {
+        for (l = 0; l < bw; ++l)
+          sum_error += highbd_error_measure(d[l] - r[l], bd);
+        d += p_stride;
+        r += stride;
+      }
+    }
+  }
+  return sum_error;
 }
 
 static void highbd_warp_plane(WarpedMotionParams *wm, uint8_t *ref8, int width,
@@ -570,28 +788,28 @@ static void highbd_warp_plane(WarpedMotionParams *wm, uint8_t *ref8, int width,
                               int p_stride, int subsampling_x,
                               int subsampling_y, int x_scale, int y_scale,
                               int bd, int ref_frm) {
-  int i, j;
-  ProjectPointsFunc projectpoints = get_project_points_type(wm->wmtype);
+  int i, j, k, l;
+  WarpProjection proj;
   uint16_t *pred = CONVERT_TO_SHORTPTR(pred8);
   uint16_t *ref = CONVERT_TO_SHORTPTR(ref8);
-  if (projectpoints == NULL) return;
-  for (i = p_row; i < p_row + p_height; ++i) {
-    for (j = p_col; j < p_col + p_width; ++j) {
-      int in[2], out[2];
-      in[0] = j;
-      in[1] = i;
-      projectpoints(wm->wmmat, in, out, 1, 2, 2, subsampling_x, subsampling_y);
-      out[0] = ROUND_POWER_OF_TWO_SIGNED(out[0] * x_scale, 4);
-      out[1] = ROUND_POWER_OF_TWO_SIGNED(out[1] * y_scale, 4);
-      if (ref_frm)
-        pred[(j - p_col) + (i - p_row) * p_stride] = ROUND_POWER_OF_TWO(
-            pred[(j - p_col) + (i - p_row) * p_stride] +
-                highbd_warp_interpolate(ref, out[0], out[1], width, height,
-                                        stride, bd),
-            1);
-      else
-        pred[(j - p_col) + (i - p_row) * p_stride] = highbd_warp_interpolate(
-            ref, out[0], out[1], width, height, stride, bd);
+  uint16_t block[WARP_BLOCK_SIZE * WARP_BLOCK_SIZE];
+  if (!init_warp_projection(&proj, wm, subsampling_x, subsampling_y, x_scale,
+                            y_scale))
+    return;
+  for (i = p_row; i < p_row + p_height; i += WARP_BLOCK_SIZE) {
+    const int bh = AOMMIN(WARP_BLOCK_SIZE, p_row + p_height - i);
+    for (j = p_col; j < p_col + p_width; j += WARP_BLOCK_SIZE) {
+      const int bw = AOMMIN(WARP_BLOCK_SIZE, p_col + p_width - j);
+      const uint16_t *b = block;
+      uint16_t *p = pred + (i - p_row) * p_stride + (j - p_col);
+      highbd_warp_block(&proj, ref, width, height, stride, j, i, bw, bh, bd,
+                        block);
+      for (k = 0; k < bh; ++k) {
+        for (l = 0; l < bw; ++l)
+          p[l] = ref_frm ? ROUND_POWER_OF_TWO(p[l] + b[l], 1) : b[l];
+        b += bw;
+        p += p_stride;
+      }
     }
   }
 }
@@ -601,32 +819,55 @@ static INLINE int error_measure(int err) {
   return error_measure_lut[255 + err];
 }
 
-static double warp_erroradv(WarpedMotionParams *wm, uint8_t *ref, int width,
-                            int height, int stride, uint8_t *dst, int p_col,
-                            int p_row, int p_width, int p_height, int p_stride,
-                            int subsampling_x, int subsampling_y, int x_scale,
-                            int y_scale) {
-  int gm_err = 0, no_gm_err = 0;
-  int gm_sumerr = 0, no_gm_sumerr = 0;
-  int i, j;
-  ProjectPointsFunc projectpoints = get_project_points_type(wm->wmtype);
-  for (i = p_row; i < p_row + p_height; ++i) {
-    for (j = p_col; j < p_col + p_width; ++j) {
-      int in[2], out[2];
-      in[0] = j;
-      in[1] = i;
-      projectpoints(wm->wmmat, in, out, 1, 2, 2, subsampling_x, subsampling_y);
-      out[0] = ROUND_POWER_OF_TWO_SIGNED(out[0] * x_scale, 4);
-      out[1] = ROUND_POWER_OF_TWO_SIGNED(out[1] * y_scale, 4);
-      gm_err = dst[(j - p_col) + (i - p_row) * p_stride] -
-               warp_interpolate(ref, out[0], out[1], width, height, stride);
-      no_gm_err =
-          dst[(j - p_col) + (i - p_row) * p_stride] - ref[j + i * stride];
-      gm_sumerr += error_measure(gm_err);
-      no_gm_sumerr += error_measure(no_gm_err);
+static int64_t warp_error(WarpedMotionParams *wm, uint8_t *ref, int width,
+                          int height, int stride, uint8_t *dst, int p_col,
+                          int p_row, int p_width, int p_height, int p_stride,
+                          int subsampling_x, int subsampling_y, int x_scale,
+                          int y_scale, int64_t best_err) {
+  int i, j, k, l;
+  WarpProjection proj;
+  uint8_t block[WARP_BLOCK_SIZE * WARP_BLOCK_SIZE];
+  int64_t gm_sumerr = 0;
+  if (!init_warp_projection(&proj, wm, subsampling_x, subsampling_y, x_scale,
+                            y_scale))
+    return 0;
+  for (i = p_row; i < p_row + p_height; i += WARP_BLOCK_SIZE) {
+    const int bh = AOMMIN(WARP_BLOCK_SIZE, p_row + p_height - i);
+    for (j = p_col; j < p_col + p_width; j += WARP_BLOCK_SIZE) {
+      const int bw = AOMMIN(WARP_BLOCK_SIZE, p_col + p_width - j);
+      const uint8_t *b = block;
+      const uint8_t *d = dst + (i - p_row) * p_stride + (j - p_col);
+      warp_block(&proj, ref, width, height, stride, j, i, bw, bh, block);
+      for (k = 0; k < bh; ++k) {
+        for (l = 0; l < bw; ++l) gm_sumerr += error_measure(d[l] - b[l]);
+        b += bw;
+        d += p_stride;
+      }
+      if (gm_sumerr >= best_err) return gm_sumerr;
     }
   }
-  return (double)gm_sumerr / no_gm_sumerr;
+  return gm_sumerr;
+}
+
+static int64_t frame_error(uint8_t *ref, int stride, uint8_t *dst, int p_col,
+                           int p_row, int p_width, int p_height,
+                           int p_stride) {
+  int i, j, k, l;
+  int64_t sum_error = 0;
+  for (i = p_row; i < p_row + p_height; i += WARP_BLOCK_SIZE) {
+    const int bh = AOMMIN(WARP_BLOCK_SIZE, p_row + p_height - i);
+    for (j = p_col; j < p_col + p_width; j += WARP_BLOCK_SIZE) {
+      const int bw = AOMMIN(WARP_BLOCK_SIZE, p_col + p_width - j);
+      const uint8_t *d = dst + (i - p_row) * p_stride + (j - p_col);
+      const uint8_t *r = ref + i * stride + j;
+      for (k = 0; k < bh; ++k) {
+        for (l = 0; l < bw; ++l) sum_error += error_measure(d[l] - r[l]);
+        d += p_stride;
+        r += stride;
+      }
+    }
+  }
+  return sum_error;
 }
 
 static void warp_plane(WarpedMotionParams *wm, uint8_t *ref, int width,
@@ -634,29 +875,64 @@ static void warp_plane(WarpedMotionParams *wm, uint8_t *ref, int width,
                        int p_row, int p_width, int p_height, int p_stride,
                        int subsampling_x, int subsampling_y, int x_scale,
                        int y_scale, int ref_frm) {
-  int i, j;
-  ProjectPointsFunc projectpoints = get_project_points_type(wm->wmtype);
-  if (projectpoints == NULL) return;
-  for (i = p_row; i < p_row + p_height; ++i) {
-    for (j = p_col; j < p_col + p_width; ++j) {
-      int in[2], out[2];
-      in[0] = j;
-      in[1] = i;
-      projectpoints(wm->wmmat, in, out, 1, 2, 2, subsampling_x, subsampling_y);
-      out[0] = ROUND_POWER_OF_TWO_SIGNED(out[0] * x_scale, 4);
-      out[1] = ROUND_POWER_OF_TWO_SIGNED(out[1] * y_scale, 4);
-      if (ref_frm)
-        pred[(j - p_col) + (i - p_row) * p_stride] = ROUND_POWER_OF_TWO(
-            pred[(j - p_col) + (i - p_row) * p_stride] +
-                warp_interpolate(ref, out[0], out[1], width, height, stride),
-            1);
-      else
-        pred[(j - p_col) + (i - p_row) * p_stride] =
-            warp_interpolate(ref, out[0], out[1], width, height, stride);
+  int i, j, k, l;
+  WarpProjection proj;
+  uint8_t block[WARP_BLOCK_SIZE * WARP_BLOCK_SIZE];
+  if (!init_warp_projection(&proj, wm, subsampling_x, subsampling_y, x_scale,
+                            y_scale))
+    return;
+  for (i = p_row; i < p_row + p_height; i += WARP_BLOCK_SIZE) {
+    const int bh = AOMMIN(WARP_BLOCK_SIZE, p_row + p_height - i);
+    for (j = p_col; j < p_col + p_width; j += WARP_BLOCK_SIZE) {
+      const int bw = AOMMIN(WARP_BLOCK_SIZE, p_col + p_width - j);
+      const uint8_t *b = block;
+      uint8_t *p = pred + (i - p_row) * p_stride + (j - p_col);
+      warp_block(&proj, ref, width, height, stride, j, i, bw, bh, block);
+      for (k = 0; k < bh; ++k) {
+        for (l = 0; l < bw; ++l)
+          p[l] = ref_frm ? ROUND_POWER_OF_TWO(p[l] + b[l], 1) : b[l];
+        b += bw;
+        p += p_stride;
+      }
     }
   }
 }
 
+int64_t av1_warp_error(WarpedMotionParams *wm,
+#if CONFIG_AOM_HIGHBITDEPTH
+                       int use_hbd, int bd,
+#endif  // CONFIG_AOM_HIGHBITDEPTH
+                       uint8_t *ref, int width, int height, int stride,
+                       uint8_t *dst, int p_col, int p_row, int p_width,
+                       int p_height, int p_stride, int subsampling_x,
+                       int subsampling_y, int x_scale, int y_scale,
+                       int64_t best_err) {
+#if CONFIG_AOM_HIGHBITDEPTH
+  if (use_hbd)
+    return highbd_warp_error(wm, ref, width, height, stride, dst, p_col, p_row,
+                             p_width, p_height, p_stride, subsampling_x,
+                             subsampling_y, x_scale, y_scale, bd, best_err);
+#endif  // CONFIG_AOM_HIGHBITDEPTH
+  return warp_error(wm, ref, width, height, stride, dst, p_col, p_row, p_width,
+                    p_height, p_stride, subsampling_x, subsampling_y, x_scale,
+                    y_scale, best_err);
+}
+
+int64_t av1_frame_error(
+#if CONFIG_AOM_HIGHBITDEPTH
+    int use_hbd, int bd,
+#endif  // CONFIG_AOM_HIGHBITDEPTH
+    uint8_t *ref, int stride, uint8_t *dst, int p_col, int p_row, int p_width,
+    int p_height, int p_stride) {
+#if CONFIG_AOM_HIGHBITDEPTH
+  if (use_hbd)
+    return highbd_frame_error(ref, stride, dst, p_col, p_row, p_width,
+                              p_height, p_stride, bd);
+#endif  // CONFIG_AOM_HIGHBITDEPTH
+  return frame_error(ref, stride, dst, p_col, p_row, p_width, p_height,
+                     p_stride);
+}
+
 double av1_warp_erroradv(WarpedMotionParams *wm,
 #if CONFIG_AOM_HIGHBITDEPTH
                          int use_hbd, int bd,
@@ -665,15 +941,21 @@ double av1_warp_erroradv(WarpedMotionParams *wm,
                          uint8_t *dst, int p_col, int p_row, int p_width,
                          int p_height, int p_stride, int subsampling_x,
                          int subsampling_y, int x_scale, int y_scale) {
+  const int64_t gm_sumerr =
+      av1_warp_error(wm,
 #if CONFIG_AOM_HIGHBITDEPTH
-  if (use_hbd)
-    return highbd_warp_erroradv(
-        wm, ref, width, height, stride, dst, p_col, p_row, p_width, p_height,
-        p_stride, subsampling_x, subsampling_y, x_scale, y_scale, bd);
+                     use_hbd, bd,
 #endif  // CONFIG_AOM_HIGHBITDEPTH
-  return warp_erroradv(wm, ref, width, height, stride, dst, p_col, p_row,
-                       p_width, p_height, p_stride, subsampling_x,
-                       subsampling_y, x_scale, y_scale);
+                     ref, width, height, stride, dst, p_col, p_row, p_width,
+                     p_height, p_stride, subsampling_x, subsampling_y, x_scale,
+                     y_scale, INT64_MAX);
+  const int64_t no_gm_sumerr =
+      av1_frame_error(
+#if CONFIG_AOM_HIGHBITDEPTH
+          use_hbd, bd,
+#endif  // CONFIG_AOM_HIGHBITDEPTH
+          ref, stride, dst, p_col, p_row, p_width, p_height, p_stride);
+  return (double)gm_sumerr / no_gm_sumerr;
 }
 
 void av1_warp_plane(WarpedMotionParams *wm,
@@ -1086,8 +1368,8 @@ static void denormalize_homography(double *params, double *T1, double *T2) {
 static void denormalize_homography_reorder(double *params, double *T1,
                                            double *T2) {
   double params_denorm[MAX_PARAMDIM];
-  memcpy(params_denorm, params, sizeof(*params) * 8);
-  params_denorm[8] = 1.0;
+  // The bottom-right entry is kept, as the caller scales the matrix by it.
+  memcpy(params_denorm, params, sizeof(*params) * MAX_PARAMDIM);
   denormalize_homography(params_denorm, T1, T2);
   params[0] = params_denorm[2];
   params[1] = params_denorm[5];
@@ -1097,6 +1379,7 @@ static void denormalize_homography_reorder(double *params, double *T1,
   params[5] = params_denorm[4];
   params[6] = params_denorm[6];
   params[7] = params_denorm[7];
+  params[8] = params_denorm[8];
 }
 
 static void denormalize_affine_reorder(double *params, double *T1, double *T2) {
@@ -28,6 +28,10 @@
 #define DEFAULT_WMTYPE AFFINE
 #endif  // CONFIG_WARPED_MOTION
 
+// Coefficients of the ntap warp filter for each subpel position, padded to
+// 8 taps with zeros.
+extern const int16_t av1_warped_filter[WARPEDPIXEL_PREC_SHIFTS][8];
+
 typedef void (*ProjectPointsFunc)(int32_t *mat, int *points, int *proj,
                                   const int n, const int stride_points,
                                   const int stride_proj,
@@ -56,6 +60,27 @@ void project_points(WarpedMotionParams *wm_params, int *points, int *proj,
                     const int n, const int stride_points, const int stride_proj,
                     const int subsampling_x, const int subsampling_y);
 
+// Returns the error of the block predicted with |wm|. The sum stops early, at
+// a value of at least |best_err|, once it can no longer be below |best_err|.
+int64_t av1_warp_error(WarpedMotionParams *wm,
+#if CONFIG_AOM_HIGHBITDEPTH
+                       int use_hbd, int bd,
+#endif  // CONFIG_AOM_HIGHBITDEPTH
+                       uint8_t *ref, int width, int height, int stride,
+                       uint8_t *dst, int p_col, int p_row, int p_width,
+                       int p_height, int p_stride, int subsampling_x,
+                       int subsampling_y, int x_scale, int y_scale,
+                       int64_t best_err);
+
+// Returns the error of the co-located block of |ref|, to which the warp error
+// is compared.
+int64_t av1_frame_error(
+#if CONFIG_AOM_HIGHBITDEPTH
+    int use_hbd, int bd,
+#endif  // CONFIG_AOM_HIGHBITDEPTH
+    uint8_t *ref, int stride, uint8_t *dst, int p_col, int p_row, int p_width,
+    int p_height, int p_stride);
+
 double av1_warp_erroradv(WarpedMotionParams *wm,
 #if CONFIG_AOM_HIGHBITDEPTH
                          int use_hbd, int bd,
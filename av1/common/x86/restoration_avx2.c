@@ -0,0 +1,373 @@
+/*
+ * Copyright (c) 2016, Alliance for Open Media. All rights reserved
+ *
+ * This source code is subject to the terms of the BSD 2 Clause License and
+ * the Alliance for Open Media Patent License 1.0. If the BSD 2 Clause License
+ * was not distributed with this source code in the LICENSE file, you can
+ * obtain it at www.aomedia.org/license/software. If the Alliance for Open
+ * Media Patent License 1.0 was not distributed with this source code in the
+ * PATENTS file, you can obtain it at www.aomedia.org/license/patent.
+ */
+
+#include <immintrin.h>  // avx2
+#include <stdlib.h>
+
+#include "./aom_config.h"
+#include "./av1_rtcd.h"
+#include "av1/common/restoration.h"
+
+// See restoration_sse4.c for the layout of the filter taps and the
+// even/odd split used by the horizontal filter. The AVX2 versions process 16
+// outputs at a time, 8 in each 128-bit lane.
+static INLINE int wiener_tap(const int *filter, int k) {
+  if (k >= RESTORATION_WIN) return 0;
+  return filter[RESTORATION_HALFWIN + abs(k - RESTORATION_HALFWIN)];
+}
+
+static INLINE __m256i wiener_tap_pair(const int *filter, int a, int b) {
+  return _mm256_set1_epi32((int32_t)((uint16_t)wiener_tap(filter, a) |
+                                     ((uint32_t)wiener_tap(filter, b) << 16)));
+}
+
+static INLINE void wiener_hor_16(const __m256i *src_k, const __m256i *coeffs,
+                                 __m256i *res_lo, __m256i *res_hi) {
+  const __m256i even = _mm256_add_epi32(
+      _mm256_add_epi32(_mm256_madd_epi16(src_k[0], coeffs[0]),
+                       _mm256_madd_epi16(src_k[2], coeffs[1])),
+      _mm256_add_epi32(_mm256_madd_epi16(src_k[4], coeffs[2]),
+                       _mm256_madd_epi16(src_k[6], coeffs[3])));
+  const __m256i odd = _mm256_add_epi32(
+      _mm256_add_epi32(_mm256_madd_epi16(src_k[1], coeffs[0]),
+                       _mm256_madd_epi16(src_k[3], coeffs[1])),
+      _mm256_add_epi32(_mm256_madd_epi16(src_k[5], coeffs[2]),
+                       _mm256_madd_epi16(src_k[7], coeffs[3])));
+  *res_lo = _mm256_unpacklo_epi32(even, odd);
+  *res_hi = _mm256_unpackhi_epi32(even, odd);
+}
+
+static INLINE void wiener_ver_16(const __m256i *rows, const __m256i *coeffs,
+                                 __m256i *res_lo, __m256i *res_hi) {
+  const __m256i s06 = _mm256_add_epi16(rows[0], rows[6]);
+  const __m256i s15 = _mm256_add_epi16(rows[1], rows[5]);
+  const __m256i s24 = _mm256_add_epi16(rows[2], rows[4]);
+  *res_lo = _mm256_add_epi32(
+      _mm256_madd_epi16(_mm256_unpacklo_epi16(s06, s15), coeffs[0]),
+      _mm256_madd_epi16(_mm256_unpacklo_epi16(s24, rows[3]), coeffs[1]));
+  *res_hi = _mm256_add_epi32(
+      _mm256_madd_epi16(_mm256_unpackhi_epi16(s06, s15), coeffs[0]),
+      _mm256_madd_epi16(_mm256_unpackhi_epi16(s24, rows[3]), coeffs[1]));
+}
+
+// Loads the 14 pixels s[0..13] that the taps of 8 outputs read, without
+// reading past them, as in restoration_sse4.c.
+static INLINE __m128i wiener_load_hor_8(const uint8_t *s) {
+  return _mm_or_si128(
+      _mm_loadl_epi64((const __m128i *)s),
+      _mm_slli_si128(_mm_loadl_epi64((const __m128i *)(s + 6)), 6));
+}
+
+// Packs 16 32-bit results, 8 per lane, to 8-bit and stores them in order.
+static INLINE void store_16_u8(uint8_t *dst, __m256i lo, __m256i hi) {
+  const __m256i res = _mm256_packs_epi32(lo, hi);
+  const __m256i res8 =
+      _mm256_permute4x64_epi64(_mm256_packus_epi16(res, res), 0xd8);
+  _mm_storeu_si128((__m128i *)dst, _mm256_castsi256_si128(res8));
+}
+
+void av1_wiener_filter_hor_avx2(const uint8_t *src, int src_stride,
+                                uint8_t *dst, int dst_stride, int w, int h,
+                                const int *hfilter) {
+  const __m256i coeffs[4] = { wiener_tap_pair(hfilter, 0, 1),
+                              wiener_tap_pair(hfilter, 2, 3),
+                              wiener_tap_pair(hfilter, 4, 5),
+                              wiener_tap_pair(hfilter, 6, 7) };
+  const __m256i round = _mm256_set1_epi32(1 << (RESTORATION_FILT_BITS - 1));
+  const __m256i zero = _mm256_setzero_si256();
+  const int w16 = w & ~15;
+  int i, j;
+
+  for (i = 0; i < h; ++i) {
+    for (j = 0; j < w16; j += 16) {
+      const uint8_t *s = src + i * src_stride + j - RESTORATION_HALFWIN;
+      // The full 16 bytes of the first lane are within the pixels read by
+      // the second one.
+      const __m256i data = _mm256_inserti128_si256(
+          _mm256_castsi128_si256(_mm_loadu_si128((const __m128i *)s)),
+          wiener_load_hor_8(s + 8), 1);
+      __m256i src_k[8], lo, hi;
+      src_k[0] = _mm256_unpacklo_epi8(data, zero);
+      src_k[1] = _mm256_unpacklo_epi8(_mm256_srli_si256(data, 1), zero);
+      src_k[2] = _mm256_unpacklo_epi8(_mm256_srli_si256(data, 2), zero);
+      src_k[3] = _mm256_unpacklo_epi8(_mm256_srli_si256(data, 3), zero);
+      src_k[4] = _mm256_unpacklo_epi8(_mm256_srli_si256(data, 4), zero);
+      src_k[5] = _mm256_unpacklo_epi8(_mm256_srli_si256(data, 5), zero);
+      src_k[6] = _mm256_unpacklo_epi8(_mm256_srli_si256(data, 6), zero);
+      src_k[7] = _mm256_unpacklo_epi8(_mm256_srli_si256(data, 7), zero);
+      wiener_hor_16(src_k, coeffs, &lo, &hi);
+      lo = _mm256_srai_epi32(_mm256_add_epi32(lo, round),
+                             RESTORATION_FILT_BITS);
+      hi = _mm256_srai_epi32(_mm256_add_epi32(hi, round),
+                             RESTORATION_FILT_BITS);
+      store_16_u8(dst + i * dst_stride + j, lo, hi);
+    }
+  }
+  if (w16 < w)
+    av1_wiener_filter_hor_c(src + w16, src_stride, dst + w16, dst_stride,
+                            w - w16, h, hfilter);
+}
+
+void av1_wiener_filter_ver_avx2(const uint8_t *src, int src_stride,
+                                uint8_t *dst, int dst_stride, int w, int h,
+                                const int *vfilter) {
+  const __m256i coeffs[2] = { wiener_tap_pair(vfilter, 0, 1),
+                              wiener_tap_pair(vfilter, 2, 3) };
+  const __m256i round = _mm256_set1_epi32(1 << (RESTORATION_FILT_BITS - 1));
+  const int w16 = w & ~15;
+  int i, j, k;
+
+  for (i = 0; i < h; ++i) {
+    const uint8_t *s = src + (i - RESTORATION_HALFWIN) * src_stride;
+    for (j = 0; j < w16; j += 16) {
+      __m256i rows[RESTORATION_WIN], lo, hi;
+      for (k = 0; k < RESTORATION_WIN; ++k)
+        rows[k] = _mm256_cvtepu8_epi16(
+            _mm_loadu_si128((const __m128i *)(s + k * src_stride + j)));
+      wiener_ver_16(rows, coeffs, &lo, &hi);
+      lo = _mm256_srai_epi32(_mm256_add_epi32(lo, round),
+                             RESTORATION_FILT_BITS);
+      hi = _mm256_srai_epi32(_mm256_add_epi32(hi, round),
+                             RESTORATION_FILT_BITS);
+      store_16_u8(dst + i * dst_stride + j, lo, hi);
+    }
+  }
+  if (w16 < w)
+    av1_wiener_filter_ver_c(src + w16, src_stride, dst + w16, dst_stride,
+                            w - w16, h, vfilter);
+}
+
+#if CONFIG_AOM_HIGHBITDEPTH
+// Clamps 16 32-bit results, 8 per lane, to [0, max] and stores them in order.
+static INLINE void store_16_u16(uint16_t *dst, __m256i lo, __m256i hi,
+                                __m256i max) {
+  const __m256i zero = _mm256_setzero_si256();
+  lo = _mm256_min_epi32(_mm256_max_epi32(lo, zero), max);
+  hi = _mm256_min_epi32(_mm256_max_epi32(hi, zero), max);
+  _mm256_storeu_si256((__m256i *)dst, _mm256_packus_epi32(lo, hi));
+}
+
+void av1_highbd_wiener_filter_hor_avx2(const uint16_t *src, int src_stride,
+                                       uint16_t *dst, int dst_stride, int w,
+                                       int h, const int *hfilter, int bd) {
+  const __m256i coeffs[4] = { wiener_tap_pair(hfilter, 0, 1),
+                              wiener_tap_pair(hfilter, 2, 3),
+                              wiener_tap_pair(hfilter, 4, 5),
+                              wiener_tap_pair(hfilter, 6, 7) };
+  const __m256i round = _mm256_set1_epi32(1 << (RESTORATION_FILT_BITS - 1));
+  const __m256i max = _mm256_set1_epi32((1 << bd) - 1);
+  const int w16 = w & ~15;
+  int i, j;
+
+  for (i = 0; i < h; ++i) {
+    for (j = 0; j < w16; j += 16) {
+      const uint16_t *s = src + i * src_stride + j - RESTORATION_HALFWIN;
+      // The upper lane of data1 holds s[16..21], loaded from s + 14 so as
+      // not to read past the pixels the taps need.
+      const __m256i data0 = _mm256_loadu_si256((const __m256i *)s);
+      const __m256i data1 = _mm256_inserti128_si256(
+          _mm256_castsi128_si256(_mm_loadu_si128((const __m128i *)(s + 8))),
+          _mm_srli_si128(_mm_loadu_si128((const __m128i *)(s + 14)), 4), 1);
+      __m256i src_k[8], lo, hi;
+      src_k[0] = data0;
+      src_k[1] = _mm256_alignr_epi8(data1, data0, 2);
+      src_k[2] = _mm256_alignr_epi8(data1, data0, 4);
+      src_k[3] = _mm256_alignr_epi8(data1, data0, 6);
+      src_k[4] = _mm256_alignr_epi8(data1, data0, 8);
+      src_k[5] = _mm256_alignr_epi8(data1, data0, 10);
+      src_k[6] = _mm256_alignr_epi8(data1, data0, 12);
+      src_k[7] = _mm256_alignr_epi8(data1, data0, 14);
+      wiener_hor_16(src_k, coeffs, &lo, &hi);
+      lo = _mm256_srai_epi32(_mm256_add_epi32(lo, round),
+                             RESTORATION_FILT_BITS);
+      hi = _mm256_srai_epi32(_mm256_add_epi32(hi, round),
+                             RESTORATION_FILT_BITS);
+      store_16_u16(dst + i * dst_stride + j, lo, hi, max);
+    }
+  }
+  if (w16 < w)
+    av1_highbd_wiener_filter_hor_c(src + w16, src_stride, dst + w16,
+                                   dst_stride, w - w16, h, hfilter, bd);
+}
+
+void av1_highbd_wiener_filter_ver_avx2(const uint16_t *src, int src_stride,
+                                       uint16_t *dst, int dst_stride, int w,
+                                       int h, const int *vfilter, int bd) {
+  const __m256i coeffs[2] = { wiener_tap_pair(vfilter, 0, 1),
+                              wiener_tap_pair(vfilter, 2, 3) };
+  const __m256i round = _mm256_set1_epi32(1 << (RESTORATION_FILT_BITS - 1));
+  const __m256i max = _mm256_set1_epi32((1 << bd) - 1);
+  const int w16 = w & ~15;
+  int i, j, k;
+
+  for (i = 0; i < h; ++i) {
+    const uint16_t *s = src + (i - RESTORATION_HALFWIN) * src_stride;
+    for (j = 0; j < w16; j += 16) {
+      __m256i rows[RESTORATION_WIN], lo, hi;
+      for (k = 0; k < RESTORATION_WIN; ++k)
+        rows[k] =
+            _mm256_loadu_si256((const __m256i *)(s + k * src_stride + j));
+      wiener_ver_16(rows, coeffs, &lo, &hi);
+      lo = _mm256_srai_epi32(_mm256_add_epi32(lo, round),
+                             RESTORATION_FILT_BITS);
+      hi = _mm256_srai_epi32(_mm256_add_epi32(hi, round),
+                             RESTORATION_FILT_BITS);
+      store_16_u16(dst + i * dst_stride + j, lo, hi, max);
+    }
+  }
+  if (w16 < w)
+    av1_highbd_wiener_filter_ver_c(src + w16, src_stride, dst + w16,
+                                   dst_stride, w - w16, h, vfilter, bd);
+}
+#endif  // CONFIG_AOM_HIGHBITDEPTH
+
+// Self-guided filter. See restoration_sse4.c for why the divisions can be
+// done in double precision without changing the result.
+static INLINE __m256i sgr_cvtt_8(__m256d lo, __m256d hi) {
+  return _mm256_inserti128_si256(
+      _mm256_castsi128_si256(_mm256_cvttpd_epi32(lo)), _mm256_cvttpd_epi32(hi),
+      1);
+}
+
+static INLINE __m256d sgr_cvt_lo(__m256i x) {
+  return _mm256_cvtepi32_pd(_mm256_castsi256_si128(x));
+}
+
+static INLINE __m256d sgr_cvt_hi(__m256i x) {
+  return _mm256_cvtepi32_pd(_mm256_extracti128_si256(x, 1));
+}
+
+static INLINE __m256d sgr_calc_a(__m256d s, __m256d s2, __m256d n,
+                                 __m256d eps) {
+  const __m256d p = _mm256_sub_pd(_mm256_mul_pd(s2, n), _mm256_mul_pd(s, s));
+  const __m256d den =
+      _mm256_add_pd(p, _mm256_mul_pd(_mm256_mul_pd(n, n), eps));
+  const __m256d num =
+      _mm256_add_pd(_mm256_mul_pd(p, _mm256_set1_pd(1 << SGRPROJ_SGR_BITS)),
+                    _mm256_floor_pd(_mm256_mul_pd(den, _mm256_set1_pd(0.5))));
+  return _mm256_div_pd(num, den);
+}
+
+// Sums a box of radius r around 8 consecutive pixels at j from the rows of an
+// integral image above and below it.
+static INLINE __m256i sgr_box_8(const uint32_t *top, const uint32_t *bot,
+                                int j, int r) {
+  return _mm256_add_epi32(
+      _mm256_sub_epi32(_mm256_loadu_si256((const __m256i *)(bot + j + r + 1)),
+                       _mm256_loadu_si256((const __m256i *)(top + j + r + 1))),
+      _mm256_sub_epi32(_mm256_loadu_si256((const __m256i *)(top + j - r)),
+                       _mm256_loadu_si256((const __m256i *)(bot + j - r))));
+}
+
+// Computes the A and B coefficients of 8 consecutive pixels of a row.
+static INLINE void sgr_calc_ab_8(const uint32_t *top, const uint32_t *bot,
+                                 const uint32_t *top2, const uint32_t *bot2,
+                                 int j, int r, int width, __m256i ny,
+                                 __m256d eps, int32_t *A, int32_t *B) {
+  const __m256i jv = _mm256_add_epi32(
+      _mm256_set1_epi32(j), _mm256_setr_epi32(0, 1, 2, 3, 4, 5, 6, 7));
+  const __m256i nx = _mm256_add_epi32(
+      _mm256_sub_epi32(
+          _mm256_min_epi32(_mm256_add_epi32(jv, _mm256_set1_epi32(r)),
+                           _mm256_set1_epi32(width - 1)),
+          _mm256_max_epi32(_mm256_sub_epi32(jv, _mm256_set1_epi32(r)),
+                           _mm256_setzero_si256())),
+      _mm256_set1_epi32(1));
+  const __m256i n = _mm256_mullo_epi32(nx, ny);
+  const __m256i s = sgr_box_8(top, bot, j, r);
+  const __m256i s2 = sgr_box_8(top2, bot2, j, r);
+  const __m256d n_lo = sgr_cvt_lo(n);
+  const __m256d n_hi = sgr_cvt_hi(n);
+  const __m256i a =
+      sgr_cvtt_8(sgr_calc_a(sgr_cvt_lo(s), sgr_cvt_lo(s2), n_lo, eps),
+                 sgr_calc_a(sgr_cvt_hi(s), sgr_cvt_hi(s2), n_hi, eps));
+  const __m256i b_num = _mm256_add_epi32(
+      _mm256_mullo_epi32(_mm256_sub_epi32(_mm256_set1_epi32(SGRPROJ_SGR), a),
+                         s),
+      _mm256_srai_epi32(n, 1));
+  _mm256_storeu_si256((__m256i *)(A + j), a);
+  _mm256_storeu_si256(
+      (__m256i *)(B + j),
+      sgr_cvtt_8(_mm256_div_pd(sgr_cvt_lo(b_num), n_lo),
+                 _mm256_div_pd(sgr_cvt_hi(b_num), n_hi)));
+}
+
+// Weighted 3x3 sum of the A or B coefficients for 8 inner pixels at x.
+static INLINE __m256i sgr_inner_sum_8(const int32_t *x, int w) {
+  const __m256i cross = _mm256_add_epi32(
+      _mm256_add_epi32(
+          _mm256_loadu_si256((const __m256i *)x),
+          _mm256_add_epi32(_mm256_loadu_si256((const __m256i *)(x - 1)),
+                           _mm256_loadu_si256((const __m256i *)(x + 1)))),
+      _mm256_add_epi32(_mm256_loadu_si256((const __m256i *)(x - w)),
+                       _mm256_loadu_si256((const __m256i *)(x + w))));
+  const __m256i diag = _mm256_add_epi32(
+      _mm256_add_epi32(_mm256_loadu_si256((const __m256i *)(x - 1 - w)),
+                       _mm256_loadu_si256((const __m256i *)(x - 1 + w))),
+      _mm256_add_epi32(_mm256_loadu_si256((const __m256i *)(x + 1 - w)),
+                       _mm256_loadu_si256((const __m256i *)(x + 1 + w))));
+  return _mm256_add_epi32(_mm256_slli_epi32(cross, 2),
+                          _mm256_add_epi32(diag, _mm256_slli_epi32(diag, 1)));
+}
+
+void av1_selfguided_restoration_avx2(const int32_t *dgd, int width, int height,
+                                     int stride, int bit_depth, int r, int eps,
+                                     const uint32_t *sum, const uint32_t *sumsq,
+                                     int sum_stride, int32_t *dst,
+                                     int dst_stride, int32_t *tmpbuf) {
+  int32_t *A = tmpbuf;
+  int32_t *B = A + RESTORATION_TILEPELS_MAX;
+  const __m256d epsv = _mm256_set1_pd(eps << 2 * (bit_depth - 8));
+  const __m256i rnd_nb = _mm256_set1_epi32((1 << 5) / 2);
+  const __m256i rnd_sgr = _mm256_set1_epi32(1 << (SGRPROJ_SGR_BITS - 1));
+  int i, j;
+
+  // The last vector of each row overlaps the previous one rather than running
+  // past the end, so narrow tiles are left to the C code.
+  if (width < 10 || height < 3) {
+    av1_selfguided_restoration_c(dgd, width, height, stride, bit_depth, r, eps,
+                                 sum, sumsq, sum_stride, dst, dst_stride,
+                                 tmpbuf);
+    return;
+  }
+  sum += SGRPROJ_BORDER * sum_stride + SGRPROJ_BORDER;
+  sumsq += SGRPROJ_BORDER * sum_stride + SGRPROJ_BORDER;
+
+  for (i = 0; i < height; ++i) {
+    const __m256i ny =
+        _mm256_set1_epi32(AOMMIN(i + r, height - 1) - AOMMAX(i - r, 0) + 1);
+    const uint32_t *top = sum + (i - r) * sum_stride;
+    const uint32_t *bot = sum + (i + r + 1) * sum_stride;
+    const uint32_t *top2 = sumsq + (i - r) * sum_stride;
+    const uint32_t *bot2 = sumsq + (i + r + 1) * sum_stride;
+    for (j = 0; j < width; j += 8)
+      sgr_calc_ab_8(top, bot, top2, bot2, AOMMIN(j, width - 8), r, width, ny,
+                    epsv, A + i * width, B + i * width);
+  }
+
+  av1_selfguided_filter_border(dgd, width, height, stride, A, B, dst,
+                               dst_stride);
+  for (i = 1; i < height - 1; ++i) {
+    for (j = 1; j < width - 1; j += 8) {
+      const int jj = AOMMIN(j, width - 9);
+      const int k = i * width + jj;
+      const __m256i a = sgr_inner_sum_8(A + k, width);
+      const __m256i b = sgr_inner_sum_8(B + k, width);
+      const __m256i u =
+          _mm256_loadu_si256((const __m256i *)(dgd + i * stride + jj));
+      __m256i v = _mm256_add_epi32(_mm256_mullo_epi32(a, u), b);
+      v = _mm256_srai_epi32(
+          _mm256_add_epi32(_mm256_slli_epi32(v, SGRPROJ_RST_BITS), rnd_nb), 5);
+      v = _mm256_srai_epi32(_mm256_add_epi32(v, rnd_sgr), SGRPROJ_SGR_BITS);
+      _mm256_storeu_si256((__m256i *)(dst + i * dst_stride + jj), v);
+    }
+  }
+}
@@ -0,0 +1,354 @@
+/*
+ * Copyright (c) 2016, Alliance for Open Media. All rights reserved
+ *
+ * This source code is subject to the terms of the BSD 2 Clause License and
+ * the Alliance for Open Media Patent License 1.0. If the BSD 2 Clause License
+ * was not distributed with this source code in the LICENSE file, you can
+ * obtain it at www.aomedia.org/license/software. If the Alliance for Open
+ * Media Patent License 1.0 was not distributed with this source code in the
+ * PATENTS file, you can obtain it at www.aomedia.org/license/patent.
+ */
+
+#include <smmintrin.h>
+#include <stdlib.h>
+
+#include "./aom_config.h"
+#include "./av1_rtcd.h"
+#include "av1/common/restoration.h"
+
+// Returns the pair (f[a], f[b]) of a symmetric Wiener filter replicated
+// across the register, suitable for _mm_madd_epi16(). Only the upper half of
+// the filter is read, as in the C code, and an index of RESTORATION_WIN maps
+// to a zero tap.
+static INLINE int wiener_tap(const int *filter, int k) {
+  if (k >= RESTORATION_WIN) return 0;
+  return filter[RESTORATION_HALFWIN + abs(k - RESTORATION_HALFWIN)];
+}
+
+static INLINE __m128i wiener_tap_pair(const int *filter, int a, int b) {
+  return _mm_set1_epi32((int32_t)((uint16_t)wiener_tap(filter, a) |
+                                  ((uint32_t)wiener_tap(filter, b) << 16)));
+}
+
+// Loads the 14 pixels s[0..13] that the taps of 8 outputs read, without
+// reading past them. The two 8-byte loads overlap on s[6..7], which hold the
+// same bytes in both, and the top 2 bytes are left zero.
+static INLINE __m128i wiener_load_hor_8(const uint8_t *s) {
+  return _mm_or_si128(
+      _mm_loadl_epi64((const __m128i *)s),
+      _mm_slli_si128(_mm_loadl_epi64((const __m128i *)(s + 6)), 6));
+}
+
+// Applies the 7-tap filter to 8 consecutive pixels. src_k must hold the 16-bit
+// pixels s[k..k+7], where s points 3 pixels to the left of the first output.
+// Returns the 8 unrounded sums in two registers, in output order.
+static INLINE void wiener_hor_8(const __m128i *src_k, const __m128i *coeffs,
+                                __m128i *res_lo, __m128i *res_hi) {
+  const __m128i even =
+      _mm_add_epi32(_mm_add_epi32(_mm_madd_epi16(src_k[0], coeffs[0]),
+                                  _mm_madd_epi16(src_k[2], coeffs[1])),
+                    _mm_add_epi32(_mm_madd_epi16(src_k[4], coeffs[2]),
+                                  _mm_madd_epi16(src_k[6], coeffs[3])));
+  const __m128i odd =
+      _mm_add_epi32(_mm_add_epi32(_mm_madd_epi16(src_k[1], coeffs[0]),
+                                  _mm_madd_epi16(src_k[3], coeffs[1])),
+                    _mm_add_epi32(_mm_madd_epi16(src_k[5], coeffs[2]),
+                                  _mm_madd_epi16(src_k[7], coeffs[3])));
+  *res_lo = _mm_unpacklo_epi32(even, odd);
+  *res_hi = _mm_unpackhi_epi32(even, odd);
+}
+
+// Applies the vertical filter to 8 columns. rows[k] holds the 16-bit pixels of
+// row k - 3 relative to the output row. The symmetric taps are folded so that
+// only two multiply-adds are needed per group of 4 outputs.
+static INLINE void wiener_ver_8(const __m128i *rows, const __m128i *coeffs,
+                                __m128i *res_lo, __m128i *res_hi) {
+  const __m128i s06 = _mm_add_epi16(rows[0], rows[6]);
+  const __m128i s15 = _mm_add_epi16(rows[1], rows[5]);
+  const __m128i s24 = _mm_add_epi16(rows[2], rows[4]);
+  *res_lo = _mm_add_epi32(
+      _mm_madd_epi16(_mm_unpacklo_epi16(s06, s15), coeffs[0]),
+      _mm_madd_epi16(_mm_unpacklo_epi16(s24, rows[3]), coeffs[1]));
+  *res_hi = _mm_add_epi32(
+      _mm_madd_epi16(_mm_unpackhi_epi16(s06, s15), coeffs[0]),
+      _mm_madd_epi16(_mm_unpackhi_epi16(s24, rows[3]), coeffs[1]));
+}
+
+void av1_wiener_filter_hor_sse4_1(const uint8_t *src, int src_stride,
+                                  uint8_t *dst, int dst_stride, int w, int h,
+                                  const int *hfilter) {
+  const __m128i coeffs[4] = { wiener_tap_pair(hfilter, 0, 1),
+                              wiener_tap_pair(hfilter, 2, 3),
+                              wiener_tap_pair(hfilter, 4, 5),
+                              wiener_tap_pair(hfilter, 6, 7) };
+  const __m128i round = _mm_set1_epi32(1 << (RESTORATION_FILT_BITS - 1));
+  const int w8 = w & ~7;
+  int i, j;
+
+  for (i = 0; i < h; ++i) {
+    for (j = 0; j < w8; j += 8) {
+      const __m128i data =
+          wiener_load_hor_8(src + i * src_stride + j - RESTORATION_HALFWIN);
+      __m128i src_k[8], lo, hi, res;
+      src_k[0] = _mm_cvtepu8_epi16(data);
+      src_k[1] = _mm_cvtepu8_epi16(_mm_srli_si128(data, 1));
+      src_k[2] = _mm_cvtepu8_epi16(_mm_srli_si128(data, 2));
+      src_k[3] = _mm_cvtepu8_epi16(_mm_srli_si128(data, 3));
+      src_k[4] = _mm_cvtepu8_epi16(_mm_srli_si128(data, 4));
+      src_k[5] = _mm_cvtepu8_epi16(_mm_srli_si128(data, 5));
+      src_k[6] = _mm_cvtepu8_epi16(_mm_srli_si128(data, 6));
+      src_k[7] = _mm_cvtepu8_epi16(_mm_srli_si128(data, 7));
+      wiener_hor_8(src_k, coeffs, &lo, &hi);
+      lo = _mm_srai_epi32(_mm_add_epi32(lo, round), RESTORATION_FILT_BITS);
+      hi = _mm_srai_epi32(_mm_add_epi32(hi, round), RESTORATION_FILT_BITS);
+      res = _mm_packs_epi32(lo, hi);
+      _mm_storel_epi64((__m128i *)(dst + i * dst_stride + j),
+                       _mm_packus_epi16(res, res));
+    }
+  }
+  if (w8 < w)
+    av1_wiener_filter_hor_c(src + w8, src_stride, dst + w8, dst_stride, w - w8,
+                            h, hfilter);
+}
+
+void av1_wiener_filter_ver_sse4_1(const uint8_t *src, int src_stride,
+                                  uint8_t *dst, int dst_stride, int w, int h,
+                                  const int *vfilter) {
+  const __m128i coeffs[2] = { wiener_tap_pair(vfilter, 0, 1),
+                              wiener_tap_pair(vfilter, 2, 3) };
+  const __m128i round = _mm_set1_epi32(1 << (RESTORATION_FILT_BITS - 1));
+  const int w8 = w & ~7;
+  int i, j, k;
+
+  for (i = 0; i < h; ++i) {
+    const uint8_t *s = src + (i - RESTORATION_HALFWIN) * src_stride;
+    for (j = 0; j < w8; j += 8) {
+      __m128i rows[RESTORATION_WIN], lo, hi, res;
+      for (k = 0; k < RESTORATION_WIN; ++k)
+        rows[k] = _mm_cvtepu8_epi16(
+            _mm_loadl_epi64((const __m128i *)(s + k * src_stride + j)));
+      wiener_ver_8(rows, coeffs, &lo, &hi);
+      lo = _mm_srai_epi32(_mm_add_epi32(lo, round), RESTORATION_FILT_BITS);
+      hi = _mm_srai_epi32(_mm_add_epi32(hi, round), RESTORATION_FILT_BITS);
+      res = _mm_packs_epi32(lo, hi);
+      _mm_storel_epi64((__m128i *)(dst + i * dst_stride + j),
+                       _mm_packus_epi16(res, res));
+    }
+  }
+  if (w8 < w)
+    av1_wiener_filter_ver_c(src + w8, src_stride, dst + w8, dst_stride, w - w8,
+                            h, vfilter);
+}
+
+#if CONFIG_AOM_HIGHBITDEPTH
+static INLINE __m128i highbd_clamp_epi32(__m128i x, __m128i max) {
+  return _mm_min_epi32(_mm_max_epi32(x, _mm_setzero_si128()), max);
+}
+
+void av1_highbd_wiener_filter_hor_sse4_1(const uint16_t *src, int src_stride,
+                                         uint16_t *dst, int dst_stride, int w,
+                                         int h, const int *hfilter, int bd) {
+  const __m128i coeffs[4] = { wiener_tap_pair(hfilter, 0, 1),
+                              wiener_tap_pair(hfilter, 2, 3),
+                              wiener_tap_pair(hfilter, 4, 5),
+                              wiener_tap_pair(hfilter, 6, 7) };
+  const __m128i round = _mm_set1_epi32(1 << (RESTORATION_FILT_BITS - 1));
+  const __m128i max = _mm_set1_epi32((1 << bd) - 1);
+  const int w8 = w & ~7;
+  int i, j;
+
+  for (i = 0; i < h; ++i) {
+    for (j = 0; j < w8; j += 8) {
+      const uint16_t *s = src + i * src_stride + j - RESTORATION_HALFWIN;
+      // data1 holds s[8..13], loaded from s + 6 so as not to read past
+      // the pixels the taps need.
+      const __m128i data0 = _mm_loadu_si128((const __m128i *)s);
+      const __m128i data1 =
+          _mm_srli_si128(_mm_loadu_si128((const __m128i *)(s + 6)), 4);
+      __m128i src_k[8], lo, hi;
+      src_k[0] = data0;
+      src_k[1] = _mm_alignr_epi8(data1, data0, 2);
+      src_k[2] = _mm_alignr_epi8(data1, data0, 4);
+      src_k[3] = _mm_alignr_epi8(data1, data0, 6);
+      src_k[4] = _mm_alignr_epi8(data1, data0, 8);
+      src_k[5] = _mm_alignr_epi8(data1, data0, 10);
+      src_k[6] = _mm_alignr_epi8(data1, data0, 12);
+      src_k[7] = _mm_alignr_epi8(data1, data0, 14);
+      wiener_hor_8(src_k, coeffs, &lo, &hi);
+      lo = _mm_srai_epi32(_mm_add_epi32(lo, round), RESTORATION_FILT_BITS);
+      hi = _mm_srai_epi32(_mm_add_epi32(hi, round), RESTORATION_FILT_BITS);
+      _mm_storeu_si128((__m128i *)(dst + i * dst_stride + j),
+                       _mm_packus_epi32(highbd_clamp_epi32(lo, max),
+                                        highbd_clamp_epi32(hi, max)));
+    }
+  }
+  if (w8 < w)
+    av1_highbd_wiener_filter_hor_c(src + w8, src_stride, dst + w8, dst_stride,
+                                   w - w8, h, hfilter, bd);
+}
+
+void av1_highbd_wiener_filter_ver_sse4_1(const uint16_t *src, int src_stride,
+                                         uint16_t *dst, int dst_stride, int w,
+                                         int h, const int *vfilter, int bd) {
+  const __m128i coeffs[2] = { wiener_tap_pair(vfilter, 0, 1),
+                              wiener_tap_pair(vfilter, 2, 3) };
+  const __m128i round = _mm_set1_epi32(1 << (RESTORATION_FILT_BITS - 1));
+  const __m128i max = _mm_set1_epi32((1 << bd) - 1);
+  const int w8 = w & ~7;
+  int i, j, k;
+
+  for (i = 0; i < h; ++i) {
+    const uint16_t *s = src + (i - RESTORATION_HALFWIN) * src_stride;
+    for (j = 0; j < w8; j += 8) {
+      __m128i rows[RESTORATION_WIN], lo, hi;
+      for (k = 0; k < RESTORATION_WIN; ++k)
+        rows[k] = _mm_loadu_si128((const __m128i *)(s + k * src_stride + j));
+      wiener_ver_8(rows, coeffs, &lo, &hi);
+      lo = _mm_srai_epi32(_mm_add_epi32(lo, round), RESTORATION_FILT_BITS);
+      hi = _mm_srai_epi32(_mm_add_epi32(hi, round), RESTORATION_FILT_BITS);
+      _mm_storeu_si128((__m128i *)(dst + i * dst_stride + j),
+                       _mm_packus_epi32(highbd_clamp_epi32(lo, max),
+                                        highbd_clamp_epi32(hi, max)));
+    }
+  }
+  if (w8 < w)
+    av1_highbd_wiener_filter_ver_c(src + w8, src_stride, dst + w8, dst_stride,
+                                   w - w8, h, vfilter, bd);
+}
+#endif  // CONFIG_AOM_HIGHBITDEPTH
+
+// Self-guided filter. The divisions of the C code are done in double
+// precision: every operand is an integer below 2^53, so truncating the
+// quotient gives exactly the same result as the 64-bit integer division.
+static INLINE __m128i sgr_cvtt_4(__m128d lo, __m128d hi) {
+  return _mm_unpacklo_epi64(_mm_cvttpd_epi32(lo), _mm_cvttpd_epi32(hi));
+}
+
+static INLINE __m128d sgr_cvt_lo(__m128i x) { return _mm_cvtepi32_pd(x); }
+
+static INLINE __m128d sgr_cvt_hi(__m128i x) {
+  return _mm_cvtepi32_pd(_mm_srli_si128(x, 8));
+}
+
+static INLINE __m128d sgr_calc_a(__m128d s, __m128d s2, __m128d n,
+                                 __m128d eps) {
+  const __m128d p = _mm_sub_pd(_mm_mul_pd(s2, n), _mm_mul_pd(s, s));
+  const __m128d den = _mm_add_pd(p, _mm_mul_pd(_mm_mul_pd(n, n), eps));
+  const __m128d num =
+      _mm_add_pd(_mm_mul_pd(p, _mm_set1_pd(1 << SGRPROJ_SGR_BITS)),
+                 _mm_floor_pd(_mm_mul_pd(den, _mm_set1_pd(0.5))));
+  return _mm_div_pd(num, den);
+}
+
+// Sums a box of radius r around 4 consecutive pixels at j from the rows of an
+// integral image above and below it.
+static INLINE __m128i sgr_box_4(const uint32_t *top, const uint32_t *bot,
+                                int j, int r) {
+  return _mm_add_epi32(
+      _mm_sub_epi32(_mm_loadu_si128((const __m128i *)(bot + j + r + 1)),
+                    _mm_loadu_si128((const __m128i *)(top + j + r + 1))),
+      _mm_sub_epi32(_mm_loadu_si128((const __m128i *)(top + j - r)),
+                    _mm_loadu_si128((const __m128i *)(bot + j - r))));
+}
+
+// Computes the A and B coefficients of 4 consecutive pixels of a row.
+static INLINE void sgr_calc_ab_4(const uint32_t *top, const uint32_t *bot,
+                                 const uint32_t *top2, const uint32_t *bot2,
+                                 int j, int r, int width, __m128i ny,
+                                 __m128d eps, int32_t *A, int32_t *B) {
+  const __m128i jv =
+      _mm_add_epi32(_mm_set1_epi32(j), _mm_setr_epi32(0, 1, 2, 3));
+  const __m128i nx = _mm_add_epi32(
+      _mm_sub_epi32(_mm_min_epi32(_mm_add_epi32(jv, _mm_set1_epi32(r)),
+                                  _mm_set1_epi32(width - 1)),
+                    _mm_max_epi32(_mm_sub_epi32(jv, _mm_set1_epi32(r)),
+                                  _mm_setzero_si128())),
+      _mm_set1_epi32(1));
+  const __m128i n = _mm_mullo_epi32(nx, ny);
+  const __m128i s = sgr_box_4(top, bot, j, r);
+  const __m128i s2 = sgr_box_4(top2, bot2, j, r);
+  const __m128d n_lo = sgr_cvt_lo(n);
+  const __m128d n_hi = sgr_cvt_hi(n);
+  const __m128i a =
+      sgr_cvtt_4(sgr_calc_a(sgr_cvt_lo(s), sgr_cvt_lo(s2), n_lo, eps),
+                 sgr_calc_a(sgr_cvt_hi(s), sgr_cvt_hi(s2), n_hi, eps));
+  const __m128i b_num = _mm_add_epi32(
+      _mm_mullo_epi32(_mm_sub_epi32(_mm_set1_epi32(SGRPROJ_SGR), a), s),
+      _mm_srai_epi32(n, 1));
+  _mm_storeu_si128((__m128i *)(A + j), a);
+  _mm_storeu_si128((__m128i *)(B + j),
+                   sgr_cvtt_4(_mm_div_pd(sgr_cvt_lo(b_num), n_lo),
+                              _mm_div_pd(sgr_cvt_hi(b_num), n_hi)));
+}
+
+// Weighted 3x3 sum of the A or B coefficients for 4 inner pixels at x.
+static INLINE __m128i sgr_inner_sum_4(const int32_t *x, int w) {
+  const __m128i cross = _mm_add_epi32(
+      _mm_add_epi32(_mm_loadu_si128((const __m128i *)x),
+                    _mm_add_epi32(_mm_loadu_si128((const __m128i *)(x - 1)),
+                                  _mm_loadu_si128((const __m128i *)(x + 1)))),
+      _mm_add_epi32(_mm_loadu_si128((const __m128i *)(x - w)),
+                    _mm_loadu_si128((const __m128i *)(x + w))));
+  const __m128i diag = _mm_add_epi32(
+      _mm_add_epi32(_mm_loadu_si128((const __m128i *)(x - 1 - w)),
+                    _mm_loadu_si128((const __m128i *)(x - 1 + w))),
+      _mm_add_epi32(_mm_loadu_si128((const __m128i *)(x + 1 - w)),
+                    _mm_loadu_si128((const __m128i *)(x + 1 + w))));
+  return _mm_add_epi32(_mm_slli_epi32(cross, 2),
+                       _mm_add_epi32(diag, _mm_slli_epi32(diag, 1)));
+}
+
+void av1_selfguided_restoration_sse4_1(const int32_t *dgd, int width,
+                                       int height, int stride, int bit_depth,
+                                       int r, int eps, const uint32_t *sum,
+                                       const uint32_t *sumsq, int sum_stride,
+                                       int32_t *dst, int dst_stride,
+                                       int32_t *tmpbuf) {
+  int32_t *A = tmpbuf;
+  int32_t *B = A + RESTORATION_TILEPELS_MAX;
+  const __m128d epsv = _mm_set1_pd(eps << 2 * (bit_depth - 8));
+  const __m128i rnd_nb = _mm_set1_epi32((1 << 5) / 2);
+  const __m128i rnd_sgr = _mm_set1_epi32(1 << (SGRPROJ_SGR_BITS - 1));
+  int i, j;
+
+  // The last vector of each row overlaps the previous one rather than running
+  // past the end, so narrow tiles are left to the C code.
+  if (width < 6 || height < 3) {
+    av1_selfguided_restoration_c(dgd, width, height, stride, bit_depth, r, eps,
+                                 sum, sumsq, sum_stride, dst, dst_stride,
+                                 tmpbuf);
+    return;
+  }
+  sum += SGRPROJ_BORDER * sum_stride + SGRPROJ_BORDER;
+  sumsq += SGRPROJ_BORDER * sum_stride + SGRPROJ_BORDER;
+
+  for (i = 0; i < height; ++i) {
+    const __m128i ny =
+        _mm_set1_epi32(AOMMIN(i + r, height - 1) - AOMMAX(i - r, 0) + 1);
+    const uint32_t *top = sum + (i - r) * sum_stride;
+    const uint32_t *bot = sum + (i + r + 1) * sum_stride;
+    const uint32_t *top2 = sumsq + (i - r) * sum_stride;
+    const uint32_t *bot2 = sumsq + (i + r + 1) * sum_stride;
+    for (j = 0; j < width; j += 4)
+      sgr_calc_ab_4(top, bot, top2, bot2, AOMMIN(j, width - 4), r, width, ny,
+                    epsv, A + i * width, B + i * width);
+  }
+
+  av1_selfguided_filter_border(dgd, width, height, stride, A, B, dst,
+                               dst_stride);
+  for (i = 1; i < height - 1; ++i) {
+    for (j = 1; j < width - 1; j += 4) {
+      const int jj = AOMMIN(j, width - 5);
+      const int k = i * width + jj;
+      const __m128i a = sgr_inner_sum_4(A + k, width);
+      const __m128i b = sgr_inner_sum_4(B + k, width);
+      const __m128i u =
+          _mm_loadu_si128((const __m128i *)(dgd + i * stride + jj));
+      __m128i v = _mm_add_epi32(_mm_mullo_epi32(a, u), b);
+      v = _mm_srai_epi32(
+          _mm_add_epi32(_mm_slli_epi32(v, SGRPROJ_RST_BITS), rnd_nb), 5);
+      v = _mm_srai_epi32(_mm_add_epi32(v, rnd_sgr), SGRPROJ_SGR_BITS);
+      _mm_storeu_si128((__m128i *)(dst + i * dst_stride + jj), v);
+    }
+  }
+}
@@ -0,0 +1,112 @@
+/*
+ * Copyright (c) 2016, Alliance for Open Media. All rights reserved
+ *
+ * This source code is subject to the terms of the BSD 2 Clause License and
+ * the Alliance for Open Media Patent License 1.0. If the BSD 2 Clause License
+ * was not distributed with this source code in the LICENSE file, you can
+ * obtain it at www.aomedia.org/license/software. If the Alliance for Open
+ * Media Patent License 1.0 was not distributed with this source code in the
+ * PATENTS file, you can obtain it at www.aomedia.org/license/patent.
+ */
+
+#include <immintrin.h>  // avx2
+
+#include "./aom_config.h"
+#include "./av1_rtcd.h"
+#include "av1/common/warped_motion.h"
+
+// See warped_motion_sse4.c for how the window is weighted. The AVX2 versions
+// filter two output pixels at a time, one in each 128-bit lane.
+
+static INLINE const int16_t *warp_filter_taps(int pos) {
+  return av1_warped_filter[pos & (WARPEDPIXEL_PREC_SHIFTS - 1)];
+}
+
+static INLINE __m256i load_taps_x2(int pos0, int pos1) {
+  return _mm256_inserti128_si256(
+      _mm256_castsi128_si256(
+          _mm_load_si128((const __m128i *)warp_filter_taps(pos0))),
+      _mm_load_si128((const __m128i *)warp_filter_taps(pos1)), 1);
+}
+
+static INLINE __m256i set_taps_x2(int16_t t0, int16_t t1) {
+  return _mm256_inserti128_si256(
+      _mm256_castsi128_si256(_mm_set1_epi16(t0)), _mm_set1_epi16(t1), 1);
+}
+
+static INLINE void hsum_epi32_x2(__m256i v, int32_t *sum0, int32_t *sum1) {
+  v = _mm256_add_epi32(v, _mm256_srli_si256(v, 8));
+  v = _mm256_add_epi32(v, _mm256_srli_si256(v, 4));
+  *sum0 = _mm_cvtsi128_si32(_mm256_castsi256_si128(v));
+  *sum1 = _mm_cvtsi128_si32(_mm256_extracti128_si256(v, 1));
+}
+
+static INLINE int window_offset(const int *pt, int stride) {
+  return ((pt[1] >> WARPEDPIXEL_PREC_BITS) - WARPEDPIXEL_FILTER_TAPS / 2 + 1) *
+             stride +
+         (pt[0] >> WARPEDPIXEL_PREC_BITS) - WARPEDPIXEL_FILTER_TAPS / 2 + 1;
+}
+
+static INLINE int32_t round_sum(int32_t sum) {
+  return ROUND_POWER_OF_TWO_SIGNED(sum, WARPEDPIXEL_FILTER_BITS * 2);
+}
+
+void av1_warp_filter_block_avx2(const uint8_t *ref, int stride,
+                                const int *pts, int n, uint8_t *pred) {
+  int i, k;
+  for (i = 0; i + 1 < n; i += 2) {
+    const int *pt0 = pts + 2 * i, *pt1 = pts + 2 * i + 2;
+    const __m256i fx = load_taps_x2(pt0[0], pt1[0]);
+    const int16_t *fy0 = warp_filter_taps(pt0[1]);
+    const int16_t *fy1 = warp_filter_taps(pt1[1]);
+    const uint8_t *p0 = ref + window_offset(pt0, stride);
+    const uint8_t *p1 = ref + window_offset(pt1, stride);
+    __m256i acc = _mm256_setzero_si256();
+    int32_t sum0, sum1;
+    for (k = 0; k < WARPEDPIXEL_FILTER_TAPS; ++k) {
+      const __m256i w = _mm256_mullo_epi16(fx, set_taps_x2(fy0[k], fy1[k]));
+      const __m128i row0 = _mm_loadl_epi64((const __m128i *)p0);
+      const __m128i row1 = _mm_loadl_epi64((const __m128i *)p1);
+      const __m256i rows = _mm256_cvtepu8_epi16(_mm_unpacklo_epi64(row0, row1));
+      acc = _mm256_add_epi32(acc, _mm256_madd_epi16(rows, w));
+      p0 += stride;
+      p1 += stride;
+    }
+    hsum_epi32_x2(acc, &sum0, &sum1);
+    pred[i] = clip_pixel(round_sum(sum0));
+    pred[i + 1] = clip_pixel(round_sum(sum1));
+  }
+  if (i < n) av1_warp_filter_block_c(ref, stride, pts + 2 * i, 1, pred + i);
+}
+
+#if CONFIG_AOM_HIGHBITDEPTH
+void av1_highbd_warp_filter_block_avx2(const uint16_t *ref, int stride,
+                                       const int *pts, int n, uint16_t *pred,
+                                       int bd) {
+  int i, k;
+  for (i = 0; i + 1 < n; i += 2) {
+    const int *pt0 = pts + 2 * i, *pt1 = pts + 2 * i + 2;
+    const __m256i fx = load_taps_x2(pt0[0], pt1[0]);
+    const int16_t *fy0 = warp_filter_taps(pt0[1]);
+    const int16_t *fy1 = warp_filter_taps(pt1[1]);
+    const uint16_t *p0 = ref + window_offset(pt0, stride);
+    const uint16_t *p1 = ref + window_offset(pt1, stride);
+    __m256i acc = _mm256_setzero_si256();
+    int32_t sum0, sum1;
+    for (k = 0; k < WARPEDPIXEL_FILTER_TAPS; ++k) {
+      const __m256i w = _mm256_mullo_epi16(fx, set_taps_x2(fy0[k], fy1[k]));
+      const __m256i rows = _mm256_inserti128_si256(
+          _mm256_castsi128_si256(_mm_loadu_si128((const __m128i *)p0)),
+          _mm_loadu_si128((const __m128i *)p1), 1);
+      acc = _mm256_add_epi32(acc, _mm256_madd_epi16(rows, w));
+      p0 += stride;
+      p1 += stride;
+    }
+    hsum_epi32_x2(acc, &sum0, &sum1);
+    pred[i] = clip_pixel_highbd(round_sum(sum0), bd);
+    pred[i + 1] = clip_pixel_highbd(round_sum(sum1), bd);
+  }
+  if (i < n)
+    av1_highbd_warp_filter_block_c(ref, stride, pts + 2 * i, 1, pred + i, bd);
+}
+#endif  // CONFIG_AOM_HIGHBITDEPTH
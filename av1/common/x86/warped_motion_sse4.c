@@ -0,0 +1,85 @@
+/*
+ * Copyright (c) 2016, Alliance for Open Media. All rights reserved
+ *
+ * This source code is subject to the terms of the BSD 2 Clause License and
+ * the Alliance for Open Media Patent License 1.0. If the BSD 2 Clause License
+ * was not distributed with this source code in the LICENSE file, you can
+ * obtain it at www.aomedia.org/license/software. If the Alliance for Open
+ * Media Patent License 1.0 was not distributed with this source code in the
+ * PATENTS file, you can obtain it at www.aomedia.org/license/patent.
+ */
+
+#include <smmintrin.h>
+
+#include "./aom_config.h"
+#include "./av1_rtcd.h"
+#include "av1/common/warped_motion.h"
+
+// Each output pixel is the sum over the 6x6 source window of
+// fy[k] * fx[l] * p[k][l]. The products of two taps fit in 16 bits, so the
+// window is weighted one row at a time with pmaddwd, with the rows loaded
+// 8 pixels wide against the zero padding of the filter table. The sums are
+// the same as in av1_warp_filter_block_c(), which filters horizontally and
+// then vertically without intermediate rounding.
+
+static INLINE const int16_t *warp_filter_taps(int pos) {
+  return av1_warped_filter[pos & (WARPEDPIXEL_PREC_SHIFTS - 1)];
+}
+
+static INLINE int32_t hsum_epi32(__m128i v) {
+  v = _mm_add_epi32(v, _mm_srli_si128(v, 8));
+  v = _mm_add_epi32(v, _mm_srli_si128(v, 4));
+  return _mm_cvtsi128_si32(v);
+}
+
+static INLINE int32_t round_sum(int32_t sum) {
+  return ROUND_POWER_OF_TWO_SIGNED(sum, WARPEDPIXEL_FILTER_BITS * 2);
+}
+
+void av1_warp_filter_block_sse4_1(const uint8_t *ref, int stride,
+                                  const int *pts, int n, uint8_t *pred) {
+  int i, k;
+  for (i = 0; i < n; ++i) {
+    const int x = pts[2 * i], y = pts[2 * i + 1];
+    const __m128i fx = _mm_load_si128((const __m128i *)warp_filter_taps(x));
+    const int16_t *fy = warp_filter_taps(y);
+    const uint8_t *p =
+        ref + ((y >> WARPEDPIXEL_PREC_BITS) - WARPEDPIXEL_FILTER_TAPS / 2 + 1) *
+                  stride +
+        (x >> WARPEDPIXEL_PREC_BITS) - WARPEDPIXEL_FILTER_TAPS / 2 + 1;
+    __m128i acc = _mm_setzero_si128();
+    for (k = 0; k < WARPEDPIXEL_FILTER_TAPS; ++k) {
+      const __m128i w = _mm_mullo_epi16(fx, _mm_set1_epi16(fy[k]));
+      const __m128i row =
+          _mm_cvtepu8_epi16(_mm_loadl_epi64((const __m128i *)p));
+      acc = _mm_add_epi32(acc, _mm_madd_epi16(row, w));
+      p += stride;
+    }
+    pred[i] = clip_pixel(round_sum(hsum_epi32(acc)));
+  }
+}
+
+#if CONFIG_AOM_HIGHBITDEPTH
+void av1_highbd_warp_filter_block_sse4_1(const uint16_t *ref, int stride,
+                                         const int *pts, int n,
+                                         uint16_t *pred, int bd) {
+  int i, k;
+  for (i = 0; i < n; ++i) {
+    const int x = pts[2 * i], y = pts[2 * i + 1];
+    const __m128i fx = _mm_load_si128((const __m128i *)warp_filter_taps(x));
+    const int16_t *fy = warp_filter_taps(y);
+    const uint16_t *p =
+        ref + ((y >> WARPEDPIXEL_PREC_BITS) - WARPEDPIXEL_FILTER_TAPS / 2 + 1) *
+                  stride +
+        (x >> WARPEDPIXEL_PREC_BITS) - WARPEDPIXEL_FILTER_TAPS / 2 + 1;
+    __m128i acc = _mm_setzero_si128();
+    for (k = 0; k < WARPEDPIXEL_FILTER_TAPS; ++k) {
+      const __m128i w = _mm_mullo_epi16(fx, _mm_set1_epi16(fy[k]));
+      const __m128i row = _mm_loadu_si128((const __m128i *)p);
+      acc = _mm_add_epi32(acc, _mm_madd_epi16(row, w));
+      p += stride;
+    }
+    pred[i] = clip_pixel_highbd(round_sum(hsum_epi32(acc)), bd);
+  }
+}
+#endif  // CONFIG_AOM_HIGHBITDEPTH
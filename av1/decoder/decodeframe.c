@@ -1358,6 +1358,83 @@ static void set_segment_id_supertx(const AV1_COMMON *const cm, const int mi_row,
 }
 #endif  // CONFIG_SUPERTX
 
+// The number of rows below the bottom of a block, displaced by its motion
+// vector, that the longest (12-tap) interpolation filter reads in the luma and
+// chroma planes, in luma rows.
+#define FRAME_PARALLEL_MV_BORDER 14
+
+#if CONFIG_MOTION_VAR || CONFIG_SUPERTX
+// In frame parallel decoding, waits until all of the reference frames of the
+// current frame have been decoded.
+static void frame_parallel_wait_for_all_refs(AV1Decoder *const pbi) {
+  AV1_COMMON *const cm = &pbi->common;
+  RefCntBuffer *const frame_bufs = cm->buffer_pool->frame_bufs;
+  int ref;
+
+  for (ref = 0; ref < INTER_REFS_PER_FRAME; ++ref) {
+    if (cm->frame_refs[ref].idx != INVALID_IDX)
+      av1_frameworker_wait(pbi->frame_worker_owner,
+                           &frame_bufs[cm->frame_refs[ref].idx], INT_MAX);
+  }
+}
+#endif  // CONFIG_MOTION_VAR || CONFIG_SUPERTX
+
+// In frame parallel decoding, waits until the reference frames are final down
+// to the rows the inter prediction of the block reads. A reference that is
+// scaled or warped, or the neighbouring blocks' references for OBMC, are
+// waited for in full.
+static void frame_parallel_wait_for_refs(AV1Decoder *const pbi,
+                                         MACROBLOCKD *const xd, int mi_row) {
+  AV1_COMMON *const cm = &pbi->common;
+  RefCntBuffer *const frame_bufs = cm->buffer_pool->frame_bufs;
+  const MB_MODE_INFO *const mbmi = &xd->mi[0]->mbmi;
+  const int bottom = (mi_row + xd->n8_h) * MI_SIZE;
+  int ref;
+
+#if CONFIG_MOTION_VAR
+  if (mbmi->motion_mode == OBMC_CAUSAL) {
+    frame_parallel_wait_for_all_refs(pbi);
+    return;
+  }
+#endif  // CONFIG_MOTION_VAR
+
+  for (ref = 0; ref < 1 + has_second_ref(mbmi); ++ref) {
+    const RefBuffer *const ref_buf = xd->block_refs[ref];
+    int mv_row = mbmi->mv[ref].as_mv.row;
+    int row;
+    int is_global = 0;
+
+    if (mbmi->sb_type < BLOCK_8X8) {
+      int i;
+      for (i = 0; i < 4; ++i) {
+        mv_row = AOMMAX(mv_row, xd->mi[0]->bmi[i].as_mv[ref].as_mv.row);
+#if CONFIG_GLOBAL_MOTION
+        is_global |= xd->mi[0]->bmi[i].as_mode == ZEROMV;
+#endif  // CONFIG_GLOBAL_MOTION
+      }
+    } else {
+#if CONFIG_GLOBAL_MOTION
+      is_global = mbmi->mode == ZEROMV;
+#endif  // CONFIG_GLOBAL_MOTION
+    }
+#if CONFIG_GLOBAL_MOTION
+    is_global &= cm->global_motion[mbmi->ref_frame[ref]].wmtype > TRANSLATION;
+#endif  // CONFIG_GLOBAL_MOTION
+
+    if (av1_is_scaled(&ref_buf->sf) || is_global
+#if CONFIG_WARPED_MOTION
+        || mbmi->motion_mode == WARPED_CAUSAL
+#endif  // CONFIG_WARPED_MOTION
+        ) {
+      row = INT_MAX;
+    } else {
+      row = bottom + AOMMAX(0, (mv_row + 7) >> 3) + FRAME_PARALLEL_MV_BORDER;
+    }
+    av1_frameworker_wait(pbi->frame_worker_owner, &frame_bufs[ref_buf->idx],
+                         row);
+  }
+}
+
 static void decode_block(AV1Decoder *const pbi, MACROBLOCKD *const xd,
 #if CONFIG_SUPERTX
                          int supertx_enabled,
@@ -1414,6 +1491,9 @@ static void decode_block(AV1Decoder *const pbi, MACROBLOCKD *const xd,
   }
 #endif  // CONFIG_SUPERTX
 
+  if (cm->frame_parallel_decode && is_inter_block(mbmi))
+    frame_parallel_wait_for_refs(pbi, xd, mi_row);
+
 #if CONFIG_DELTA_Q
   if (cm->delta_q_present_flag) {
     int i;
@@ -2050,6 +2130,7 @@ static void decode_partition(AV1Decoder *const pbi, MACROBLOCKD *const xd,
       dst_buf[i] = xd->plane[i].dst.buf;
       dst_stride[i] = xd->plane[i].dst.stride;
     }
+    if (cm->frame_parallel_decode) frame_parallel_wait_for_all_refs(pbi);
     dec_predict_sb_complex(pbi, xd, tile, mi_row, mi_col, mi_row, mi_col, bsize,
                            bsize, dst_buf, dst_stride);
 
@@ -3068,6 +3149,7 @@ static void get_tile_buffers(
 
       // Get the whole of the last column, otherwise stop at the required tile.
       for (r = 0; r < (is_last ? tile_rows : tile_rows_end); ++r) {
+        tile_buffers[r][c].row = r;
         tile_buffers[r][c].col = c;
 
         get_tile_buffer(tile_col_data_end[c], &pbi->common.error, &data,
@@ -3083,6 +3165,7 @@ static void get_tile_buffers(
       data = tile_col_data_end[c - 1];
 
       for (r = 0; r < tile_rows; ++r) {
+        tile_buffers[r][c].row = r;
         tile_buffers[r][c].col = c;
 
         get_tile_buffer(tile_col_data_end[c], &pbi->common.error, &data,
@@ -3152,6 +3235,7 @@ static void get_tile_buffers(
       TileBufferDec *const buf = &tile_buffers[r][c];
       hdr_offset = (tc && tc == first_tile_in_tg) ? hdr_size : 0;
 
+      buf->row = r;
       buf->col = c;
       if (hdr_offset) {
         init_read_bit_buffer(pbi, &rb_tg_hdr, data, data_end, clear_data);
@@ -3176,6 +3260,7 @@ static void get_tile_buffers(
     for (c = 0; c < tile_cols; ++c) {
       const int is_last = (r == tile_rows - 1) && (c == tile_cols - 1);
       TileBufferDec *const buf = &tile_buffers[r][c];
+      buf->row = r;
       buf->col = c;
       get_tile_buffer(data_end, pbi->tile_size_bytes, is_last, &cm->error,
                       &data, pbi->decrypt_cb, pbi->decrypt_state, buf);
@@ -3197,6 +3282,354 @@ static void daala_dec_init(daala_dec_ctx *daala_dec, od_ec_dec *ec) {
 }
 #endif
 
+// Runs the in-loop filters over the decoded frame a superblock row at a time,
+// instead of making a pass over the whole frame per filter, so that each
+// filter finds the rows it works on still in cache. Each filter lags the one
+// before it by the rows it reads beyond the ones it writes, which keeps the
+// output identical to that of the whole-frame passes.
+//
+// In frame parallel decoding the rows are filtered as the frame is decoded,
+// each superblock row once the row below it has been, since intra prediction
+// reads the unfiltered pixels above. The rows that no filter will change again
+// have their borders extended and are reported to the frame workers decoding
+// the frames that reference this one.
+
+// Sets up the filters for the frame.
+static void filter_rows_init(AV1Decoder *pbi, YV12_BUFFER_CONFIG *frame) {
+  AV1_COMMON *const cm = &pbi->common;
+  FilterRows *const fr = &pbi->filter_rows;
+#if CONFIG_LOOP_RESTORATION || CONFIG_CLPF
+  int plane;
+#endif  // CONFIG_LOOP_RESTORATION || CONFIG_CLPF
+
+  fr->frame = frame;
+  fr->on_worker = 0;
+  fr->next_mi_row = 0;
+  fr->published_rows = 0;
+  fr->publish = cm->frame_parallel_decode;
+#if CONFIG_EXT_TILE
+  // The borders are only extended once the whole frame is decoded.
+  fr->publish &= pbi->dec_tile_row < 0 && pbi->dec_tile_col < 0;
+#endif  // CONFIG_EXT_TILE
+  fr->do_loop_filter = cm->lf.filter_level && !cm->skip_loop_filter;
+
+#if CONFIG_VAR_TX
+  // Loopfilter the whole frame.
+  av1_loop_filter_frame(frame, cm, &pbi->mb, cm->lf.filter_level, 0, 0);
+#elif CONFIG_PARALLEL_DEBLOCKING
+  // Loopfilter all rows in the frame in the frame.
+  if (fr->do_loop_filter)
+    av1_loop_filter_rows(frame, cm, pbi->mb.plane, 0, cm->mi_rows, 0);
+#endif  // CONFIG_VAR_TX
+
+#if CONFIG_LOOP_RESTORATION
+  fr->do_restoration = cm->rst_info.restoration_type != RESTORE_NONE &&
+                       cm->rst_info.frame_restoration_type != RESTORE_NONE;
+  fr->lr_tmpbuf = NULL;
+  if (cm->rst_info.restoration_type != RESTORE_NONE)
+    av1_loop_restoration_init(&cm->rst_internal, &cm->rst_info,
+                              cm->frame_type == KEY_FRAME, cm->width,
+                              cm->height);
+  if (fr->do_restoration) {
+    memset(&fr->lr_tmp_buf, 0, sizeof(fr->lr_tmp_buf));
+    av1_alloc_restoration_tmp_frame(&fr->lr_tmp_buf, cm);
+    if (av1_restoration_uses_tmpbuf(cm->rst_info.frame_restoration_type))
+      CHECK_MEM_ERROR(cm, fr->lr_tmpbuf, aom_malloc(SGRPROJ_TMPBUF_SIZE));
+    for (plane = 0; plane < MAX_MB_PLANE; ++plane)
+      av1_loop_restoration_plane_init(&fr->rp[plane], frame, &fr->lr_tmp_buf,
+                                      cm, plane, 0, cm->mi_rows);
+  }
+#endif  // CONFIG_LOOP_RESTORATION
+#if CONFIG_DERING
+  fr->do_dering = cm->dering_level && !cm->skip_loop_filter;
+  if (fr->do_dering)
+    av1_dering_frame_init(&fr->df, frame, cm, &pbi->mb, cm->dering_level);
+#endif  // CONFIG_DERING
+#if CONFIG_CLPF
+  fr->clpf_strength[AOM_PLANE_Y] =
+      cm->skip_loop_filter ? 0 : cm->clpf_strength_y;
+  fr->clpf_strength[AOM_PLANE_U] =
+      cm->skip_loop_filter ? 0 : cm->clpf_strength_u;
+  fr->clpf_strength[AOM_PLANE_V] =
+      cm->skip_loop_filter ? 0 : cm->clpf_strength_v;
+  for (plane = 0; plane < MAX_MB_PLANE; ++plane) {
+    const unsigned int strength = fr->clpf_strength[plane];
+    if (!strength) continue;
+    if (plane == AOM_PLANE_Y)
+      av1_clpf_plane_init(&fr->cp[plane], frame, NULL, cm,
+                          cm->clpf_size != CLPF_NOSIZE,
+                          strength + (strength == 3), 4 + cm->clpf_size,
+                          AOM_PLANE_Y, clpf_bit);
+    else
+      av1_clpf_plane_init(&fr->cp[plane], frame, NULL, cm,
+                          0,  // No block signals for chroma
+                          strength + (strength == 3), 4, plane, NULL);
+  }
+#endif  // CONFIG_CLPF
+  fr->active = 1;
+}
+
+// Extends the borders of the luma rows up to rows, and of the chroma rows
+// they cover, and reports them to the other frame workers.
+static void filter_rows_publish(AV1Decoder *pbi, int rows) {
+  FilterRows *const fr = &pbi->filter_rows;
+
+  // The bottom border is only extended once the frame is done.
+  rows = AOMMIN(rows, fr->frame->y_crop_height - 1);
+  if (!fr->publish || rows <= fr->published_rows) return;
+  aom_extend_frame_inner_borders_rows(fr->frame, fr->published_rows, rows);
+  fr->published_rows = rows;
+  av1_frameworker_broadcast(pbi->cur_buf, rows);
+}
+
+// Filters the superblock rows that can be filtered once the first
+// decoded_mi_rows mi rows of the frame have been decoded.
+static void filter_rows_run(AV1Decoder *pbi, int decoded_mi_rows) {
+  AV1_COMMON *const cm = &pbi->common;
+  FilterRows *const fr = &pbi->filter_rows;
+  YV12_BUFFER_CONFIG *const frame = fr->frame;
+  // The number of rows of each plane that are final after each filter.
+  int lf_rows[MAX_MB_PLANE], lr_rows[MAX_MB_PLANE], dering_rows[MAX_MB_PLANE];
+  int done_rows[MAX_MB_PLANE];
+  int plane;
+
+  for (; fr->next_mi_row < cm->mi_rows; fr->next_mi_row += cm->mib_size) {
+    const int mi_row = fr->next_mi_row;
+    const int mi_end = AOMMIN(mi_row + cm->mib_size, cm->mi_rows);
+    int final_rows = INT_MAX;
+    // Intra prediction of the superblock row below reads the unfiltered
+    // pixels of this one.
+    if (decoded_mi_rows < AOMMIN(mi_end + cm->mib_size, cm->mi_rows)) break;
+#if !CONFIG_VAR_TX && !CONFIG_PARALLEL_DEBLOCKING
+    if (fr->do_loop_filter)
+      av1_loop_filter_rows(frame, cm, pbi->mb.plane, mi_row, mi_end, 0);
+#endif  // !CONFIG_VAR_TX && !CONFIG_PARALLEL_DEBLOCKING
+    for (plane = 0; plane < MAX_MB_PLANE; ++plane) {
+      // The longest loopfilter of the next superblock row may still change
+      // the last 7 rows of this one.
+      const int ss_y = plane ? cm->subsampling_y : 0;
+      lf_rows[plane] = mi_end == cm->mi_rows
+                           ? INT_MAX
+                           : ((mi_end * MI_SIZE) >> ss_y) - MI_SIZE;
+      lr_rows[plane] = lf_rows[plane];
+    }
+
+#if CONFIG_LOOP_RESTORATION
+    if (fr->do_restoration) {
+      for (plane = 0; plane < MAX_MB_PLANE; ++plane)
+        lr_rows[plane] = av1_loop_restoration_plane_rows(
+            &fr->rp[plane], cm, lf_rows[plane], fr->lr_tmpbuf);
+    }
+#endif  // CONFIG_LOOP_RESTORATION
+    memcpy(dering_rows, lr_rows, sizeof(dering_rows));
+#if CONFIG_DERING
+    if (fr->do_dering) av1_dering_rows(&fr->df, cm, lr_rows, dering_rows);
+#endif  // CONFIG_DERING
+    memcpy(done_rows, dering_rows, sizeof(done_rows));
+#if CONFIG_CLPF
+    for (plane = 0; plane < MAX_MB_PLANE; ++plane) {
+      if (fr->clpf_strength[plane])
+        done_rows[plane] =
+            av1_clpf_plane_rows(&fr->cp[plane], cm, dering_rows[plane]);
+    }
+#endif  // CONFIG_CLPF
+
+    for (plane = 0; plane < MAX_MB_PLANE; ++plane) {
+      const int ss_y = plane ? cm->subsampling_y : 0;
+      final_rows = AOMMIN(final_rows, done_rows[plane] == INT_MAX
+                                          ? INT_MAX
+                                          : done_rows[plane] << ss_y);
+    }
+    filter_rows_publish(pbi, final_rows);
+  }
+}
+
+// Frees the state of the filters.
+static void filter_rows_free(AV1Decoder *pbi) {
+  FilterRows *const fr = &pbi->filter_rows;
+#if CONFIG_CLPF
+  int plane;
+#endif  // CONFIG_CLPF
+
+  if (!fr->active) return;
+  fr->active = 0;
+#if CONFIG_LOOP_RESTORATION
+  if (fr->do_restoration) {
+    aom_free(fr->lr_tmpbuf);
+    aom_free_frame_buffer(&fr->lr_tmp_buf);
+  }
+#endif  // CONFIG_LOOP_RESTORATION
+#if CONFIG_DERING
+  if (fr->do_dering) av1_dering_frame_free(&fr->df);
+#endif  // CONFIG_DERING
+#if CONFIG_CLPF
+  for (plane = 0; plane < MAX_MB_PLANE; ++plane) {
+    if (fr->clpf_strength[plane])
+      av1_clpf_plane_finish(&fr->cp[plane], &pbi->common);
+  }
+#endif  // CONFIG_CLPF
+}
+
+// Filters the rest of the frame, and in frame parallel decoding extends the
+// rest of its borders and reports it done.
+static void filter_rows_finish(AV1Decoder *pbi) {
+  FilterRows *const fr = &pbi->filter_rows;
+
+  if (fr->on_worker) {
+    aom_get_worker_interface()->sync(&pbi->filter_worker);
+    fr->on_worker = 0;
+  }
+  filter_rows_run(pbi, pbi->common.mi_rows);
+  filter_rows_free(pbi);
+  if (fr->publish)
+    aom_extend_frame_inner_borders_rows(fr->frame, fr->published_rows, INT_MAX);
+  if (pbi->common.frame_parallel_decode)
+    av1_frameworker_broadcast(pbi->cur_buf, INT_MAX);
+}
+
+static int filter_rows_worker_hook(AV1Decoder *pbi, void *unused) {
+  AV1LfSync *const lf_sync = &pbi->lf_row_sync;
+  int decoded_sb_rows = 0;
+  (void)unused;
+
+  while (decoded_sb_rows < lf_sync->rows) {
+    decoded_sb_rows =
+        av1_loop_filter_wait_decoded_rows(lf_sync, decoded_sb_rows + 1);
+    // More rows than the frame has are reported when decoding fails.
+    if (decoded_sb_rows > lf_sync->rows) break;
+    filter_rows_run(pbi, AOMMIN(decoded_sb_rows << pbi->common.mib_size_log2,
+                                pbi->common.mi_rows));
+  }
+  return 1;
+}
+
+// Whether the in-loop filters follow the decoding of the frame, which they can
+// when the superblock rows are decoded from the top.
+static int filter_rows_follow_decoding(const AV1Decoder *pbi) {
+#if CONFIG_VAR_TX || CONFIG_PARALLEL_DEBLOCKING
+  (void)pbi;
+  return 0;
+#else
+#if CONFIG_EXT_TILE
+  if (pbi->dec_tile_row >= 0 || pbi->dec_tile_col >= 0) return 0;
+#endif  // CONFIG_EXT_TILE
+  return pbi->common.frame_parallel_decode && !pbi->inv_tile_order;
+#endif  // CONFIG_VAR_TX || CONFIG_PARALLEL_DEBLOCKING
+}
+
+// Sets up the filters to follow the decoding of the frame, on the filter
+// worker if there is one.
+static void filter_rows_start(AV1Decoder *pbi, YV12_BUFFER_CONFIG *frame) {
+  AV1_COMMON *const cm = &pbi->common;
+  const AVxWorkerInterface *const winterface = aom_get_worker_interface();
+
+  filter_rows_init(pbi, frame);
+  if (!pbi->use_filter_worker) return;
+  if (pbi->filter_worker.hook == NULL) {
+    pbi->filter_worker.hook = (AVxWorkerHook)filter_rows_worker_hook;
+    pbi->filter_worker.data1 = pbi;
+    pbi->filter_worker.pool = pbi->thread_pool;
+    pbi->filter_worker.pool_owner = pbi->pool_owner;
+    if (!winterface->reset(&pbi->filter_worker)) {
+      aom_internal_error(&cm->error, AOM_CODEC_ERROR,
+                         "Filter thread creation failed");
+    }
+  }
+#if !CONFIG_PARALLEL_DEBLOCKING
+  av1_loop_filter_decoding_start(&pbi->lf_row_sync, cm);
+#endif  // !CONFIG_PARALLEL_DEBLOCKING
+  pbi->filter_rows.on_worker = 1;
+  winterface->launch(&pbi->filter_worker);
+}
+
+// Reports that the first decoded_mi_rows mi rows of the frame are decoded.
+static void filter_rows_decoded(AV1Decoder *pbi, int decoded_mi_rows) {
+#if !CONFIG_PARALLEL_DEBLOCKING
+  if (pbi->filter_rows.on_worker) {
+    av1_loop_filter_decoded_rows(
+        &pbi->lf_row_sync,
+        (decoded_mi_rows + pbi->common.mib_size - 1) >>
+            pbi->common.mib_size_log2);
+    return;
+  }
+#endif  // !CONFIG_PARALLEL_DEBLOCKING
+  filter_rows_run(pbi, decoded_mi_rows);
+}
+
+void av1_abort_filter_rows(AV1Decoder *pbi) {
+  const AVxWorkerInterface *const winterface = aom_get_worker_interface();
+  if (pbi->filter_rows.on_worker) {
+#if !CONFIG_PARALLEL_DEBLOCKING
+    // Release the filter worker waiting for rows to be decoded.
+    av1_loop_filter_decoded_rows(&pbi->lf_row_sync, INT_MAX);
+#endif  // !CONFIG_PARALLEL_DEBLOCKING
+    winterface->sync(&pbi->filter_worker);
+    pbi->filter_rows.on_worker = 0;
+  }
+  filter_rows_free(pbi);
+}
+
+// Whether the in-loop filters are run a superblock row at a time by
+// filter_rows_run(), rather than deblocking being interleaved with decoding.
+static int use_filter_pipeline(const AV1Decoder *pbi) {
+  // Frame parallel decoding reports the rows as the last filter is done, so
+  // it ignores pipelined_filters.
+  return (pbi->pipelined_filters && pbi->max_threads <= 1) ||
+         pbi->common.frame_parallel_decode;
+}
+
+// Creates the worker threads shared by the tile decoder, the loop filter and
+// the loop restoration filter.
+static void create_tile_workers(AV1Decoder *pbi) {
+  AV1_COMMON *const cm = &pbi->common;
+  const AVxWorkerInterface *const winterface = aom_get_worker_interface();
+  int i;
+
+  // TODO(jzern): See if we can remove the restriction of passing in max
+  // threads to the decoder.
+  if (pbi->num_tile_workers == 0) {
+    const int num_threads = AOMMIN(pbi->max_threads, MAX_DECODE_TILE_THREADS);
+    CHECK_MEM_ERROR(cm, pbi->tile_workers,
+                    aom_malloc(num_threads * sizeof(*pbi->tile_workers)));
+    // Ensure tile data offsets will be properly aligned. This may fail on
+    // platforms without DECLARE_ALIGNED().
+    assert((sizeof(*pbi->tile_worker_data) % 16) == 0);
+    CHECK_MEM_ERROR(
+        cm, pbi->tile_worker_data,
+        aom_memalign(32, num_threads * sizeof(*pbi->tile_worker_data)));
+    memset(pbi->tile_worker_data, 0,
+           num_threads * sizeof(*pbi->tile_worker_data));
+    CHECK_MEM_ERROR(cm, pbi->tile_worker_info,
+                    aom_malloc(num_threads * sizeof(*pbi->tile_worker_info)));
+    for (i = 0; i < num_threads; ++i) {
+      AVxWorker *const worker = &pbi->tile_workers[i];
+      ++pbi->num_tile_workers;
+
+      winterface->init(worker);
+      worker->pool = pbi->thread_pool;
+      worker->pool_owner = pbi->pool_owner;
+      if (i < num_threads - 1 && !winterface->reset(worker)) {
+        aom_internal_error(&cm->error, AOM_CODEC_ERROR,
+                           "Tile decoder thread creation failed");
+      }
+    }
+  }
+}
+
+// Whether a frame with a single tile is deblocked on the tile workers as it is
+// decoded, each superblock row once the row below it has been decoded.
+static int use_lf_wavefront(const AV1Decoder *pbi) {
+#if CONFIG_VAR_TX || CONFIG_PARALLEL_DEBLOCKING
+  (void)pbi;
+  return 0;
+#else
+  const AV1_COMMON *const cm = &pbi->common;
+  // Frame parallel decoding reports decoded rows as they are deblocked.
+  return pbi->row_mt && pbi->max_threads > 1 && !cm->frame_parallel_decode &&
+         cm->tile_rows * cm->tile_cols == 1;
+#endif  // CONFIG_VAR_TX || CONFIG_PARALLEL_DEBLOCKING
+}
+
 static const uint8_t *decode_tiles(AV1Decoder *pbi, const uint8_t *data,
                                    const uint8_t *data_end) {
   AV1_COMMON *const cm = &pbi->common;
@@ -3224,24 +3657,33 @@ static const uint8_t *decode_tiles(AV1Decoder *pbi, const uint8_t *data,
   const int inv_col_order = pbi->inv_tile_order;
   const int inv_row_order = pbi->inv_tile_order;
 #endif  // CONFIG_EXT_TILE
+  const int lf_wavefront = cm->lf.filter_level && !cm->skip_loop_filter &&
+                           use_lf_wavefront(pbi);
+  // With the filter pipeline the frame is deblocked after it has been decoded,
+  // or as it is in frame parallel decoding.
+  const int do_loop_filter = cm->lf.filter_level && !cm->skip_loop_filter &&
+                             !use_filter_pipeline(pbi) && !lf_wavefront;
+  const int follow_rows = filter_rows_follow_decoding(pbi);
   int tile_row, tile_col;
 
 #if CONFIG_ENTROPY
   cm->do_subframe_update = n_tiles == 1;
 #endif  // CONFIG_ENTROPY
 
-  if (cm->lf.filter_level && !cm->skip_loop_filter &&
+  if (do_loop_filter &&
       pbi->lf_worker.data1 == NULL) {
     CHECK_MEM_ERROR(cm, pbi->lf_worker.data1,
                     aom_memalign(32, sizeof(LFWorkerData)));
     pbi->lf_worker.hook = (AVxWorkerHook)av1_loop_filter_worker;
+    pbi->lf_worker.pool = pbi->thread_pool;
+    pbi->lf_worker.pool_owner = pbi->pool_owner;
     if (pbi->max_threads > 1 && !winterface->reset(&pbi->lf_worker)) {
       aom_internal_error(&cm->error, AOM_CODEC_ERROR,
                          "Loop filter thread creation failed");
     }
   }
 
-  if (cm->lf.filter_level && !cm->skip_loop_filter) {
+  if (do_loop_filter) {
     LFWorkerData *const lf_data = (LFWorkerData *)pbi->lf_worker.data1;
     // Be sure to sync as we might be resuming after a failed frame decode.
     winterface->sync(&pbi->lf_worker);
@@ -3312,6 +3754,18 @@ static const uint8_t *decode_tiles(AV1Decoder *pbi, const uint8_t *data,
     }
   }
 
+#if !CONFIG_VAR_TX && !CONFIG_PARALLEL_DEBLOCKING
+  if (lf_wavefront) {
+    create_tile_workers(pbi);
+    // The last worker runs on this thread, which is busy decoding.
+    av1_loop_filter_frame_mt_start(get_frame_new_buffer(cm), cm, pbi->mb.plane,
+                                   cm->lf.filter_level, pbi->tile_workers,
+                                   pbi->num_tile_workers - 1,
+                                   &pbi->lf_row_sync);
+  }
+#endif  // !CONFIG_VAR_TX && !CONFIG_PARALLEL_DEBLOCKING
+  if (follow_rows) filter_rows_start(pbi, get_frame_new_buffer(cm));
+
   for (tile_row = tile_rows_start; tile_row < tile_rows_end; ++tile_row) {
     const int row = inv_row_order ? tile_rows - 1 - tile_row : tile_row;
     int mi_row = 0;
@@ -3352,6 +3806,15 @@ static const uint8_t *decode_tiles(AV1Decoder *pbi, const uint8_t *data,
         if (pbi->mb.corrupted)
           aom_internal_error(&cm->error, AOM_CODEC_CORRUPT_FRAME,
                              "Failed to decode tile data");
+#if !CONFIG_VAR_TX && !CONFIG_PARALLEL_DEBLOCKING
+        if (lf_wavefront)
+          av1_loop_filter_decoded_rows(&pbi->lf_row_sync,
+                                       (mi_row >> cm->mib_size_log2) + 1);
+#endif  // !CONFIG_VAR_TX && !CONFIG_PARALLEL_DEBLOCKING
+        // The superblock row is decoded once the last tile column is.
+        if (follow_rows && tile_col == tile_cols_end - 1)
+          filter_rows_decoded(
+              pbi, AOMMIN(mi_row + cm->mib_size, tile_info.mi_row_end));
 #if CONFIG_ENTROPY
         if (cm->do_subframe_update &&
             cm->refresh_frame_context == REFRESH_FRAME_CONTEXT_BACKWARD) {
@@ -3376,7 +3839,7 @@ static const uint8_t *decode_tiles(AV1Decoder *pbi, const uint8_t *data,
 // after the entire frame is decoded.
 #if !CONFIG_VAR_TX && !CONFIG_PARALLEL_DEBLOCKING
     // Loopfilter one tile row.
-    if (cm->lf.filter_level && !cm->skip_loop_filter) {
+    if (do_loop_filter) {
       LFWorkerData *const lf_data = (LFWorkerData *)pbi->lf_worker.data1;
       const int lf_start = AOMMAX(0, tile_info.mi_row_start - cm->mib_size);
       const int lf_end = tile_info.mi_row_end - cm->mib_size;
@@ -3398,21 +3861,24 @@ static const uint8_t *decode_tiles(AV1Decoder *pbi, const uint8_t *data,
       }
     }
 #endif  // !CONFIG_VAR_TX && !CONFIG_PARALLEL_DEBLOCKING
-
-    // After loopfiltering, the last 7 row pixels in each superblock row may
-    // still be changed by the longest loopfilter of the next superblock row.
-    if (cm->frame_parallel_decode)
-      av1_frameworker_broadcast(pbi->cur_buf, mi_row << cm->mib_size_log2);
   }
 
+#if !CONFIG_VAR_TX && !CONFIG_PARALLEL_DEBLOCKING
+  if (lf_wavefront)
+    av1_loop_filter_frame_mt_finish(pbi->tile_workers,
+                                    pbi->num_tile_workers - 1,
+                                    &pbi->lf_row_sync);
+#endif  // !CONFIG_VAR_TX && !CONFIG_PARALLEL_DEBLOCKING
+
 #if CONFIG_VAR_TX
   // Loopfilter the whole frame.
-  av1_loop_filter_frame(get_frame_new_buffer(cm), cm, &pbi->mb,
-                        cm->lf.filter_level, 0, 0);
+  if (!use_filter_pipeline(pbi))
+    av1_loop_filter_frame(get_frame_new_buffer(cm), cm, &pbi->mb,
+                          cm->lf.filter_level, 0, 0);
 #else
 #if CONFIG_PARALLEL_DEBLOCKING
   // Loopfilter all rows in the frame in the frame.
-  if (cm->lf.filter_level && !cm->skip_loop_filter) {
+  if (do_loop_filter) {
     LFWorkerData *const lf_data = (LFWorkerData *)pbi->lf_worker.data1;
     winterface->sync(&pbi->lf_worker);
     lf_data->start = 0;
@@ -3421,7 +3887,7 @@ static const uint8_t *decode_tiles(AV1Decoder *pbi, const uint8_t *data,
   }
 #else
   // Loopfilter remaining rows in the frame.
-  if (cm->lf.filter_level && !cm->skip_loop_filter) {
+  if (do_loop_filter) {
     LFWorkerData *const lf_data = (LFWorkerData *)pbi->lf_worker.data1;
     winterface->sync(&pbi->lf_worker);
     lf_data->start = lf_data->stop;
@@ -3430,8 +3896,6 @@ static const uint8_t *decode_tiles(AV1Decoder *pbi, const uint8_t *data,
   }
 #endif  // CONFIG_PARALLEL_DEBLOCKING
 #endif  // CONFIG_VAR_TX
-  if (cm->frame_parallel_decode)
-    av1_frameworker_broadcast(pbi->cur_buf, INT_MAX);
 
 #if CONFIG_EXT_TILE
   if (n_tiles == 1) {
@@ -3458,10 +3922,95 @@ static const uint8_t *decode_tiles(AV1Decoder *pbi, const uint8_t *data,
 #endif  // CONFIG_EXT_TILE
 }
 
+// Whether tiles from different tile rows may be decoded at the same time.
+static int tile_rows_mt(const AV1Decoder *pbi) {
+#if CONFIG_VAR_TX
+  // The transform size context is read from AV1_COMMON directly, so all of
+  // the tile rows have to share it.
+  (void)pbi;
+  return 0;
+#else
+  return pbi->row_mt;
+#endif  // CONFIG_VAR_TX
+}
+
+// Takes the next tile for a tile worker to decode. Returns NULL once all of
+// the tiles have been taken.
+static const TileBufferDec *get_next_tile_job(AV1Decoder *pbi,
+                                              const TileWorkerData *twd) {
+  const int job = aom_job_queue_pop(&pbi->tile_job_queue,
+                                    (int)(twd - pbi->tile_worker_data));
+  return job < 0 ? NULL : pbi->tile_jobs[job];
+}
+
+static void zero_tile_worker_above_context(const AV1_COMMON *cm,
+                                           TileWorkerData *const twd,
+                                           const TileInfo *const tile) {
+  const int width = tile->mi_col_end - tile->mi_col_start;
+  const int offset_y = 2 * tile->mi_col_start;
+  const int width_y = 2 * width;
+  const int offset_uv = offset_y >> cm->subsampling_x;
+  const int width_uv = width_y >> cm->subsampling_x;
+
+  av1_zero_array(twd->above_context[0] + offset_y, width_y);
+  av1_zero_array(twd->above_context[1] + offset_uv, width_uv);
+  av1_zero_array(twd->above_context[2] + offset_uv, width_uv);
+
+  av1_zero_array(twd->above_seg_context + tile->mi_col_start, width);
+}
+
+// Sets up a tile worker to decode the tile in 'buf'.
+static void init_tile_worker_data(AV1Decoder *pbi, TileWorkerData *const twd,
+                                  TileInfo *const tile_info,
+                                  const TileBufferDec *const buf) {
+  AV1_COMMON *const cm = &pbi->common;
+  int i;
+
+  twd->xd = pbi->mb;
+  twd->xd.corrupted = 0;
+  twd->xd.counts = cm->refresh_frame_context == REFRESH_FRAME_CONTEXT_BACKWARD
+                       ? &twd->counts
+                       : NULL;
+  av1_zero(twd->dqcoeff);
+  av1_tile_init(tile_info, cm, buf->row, buf->col);
+  av1_tile_init(&twd->xd.tile, cm, buf->row, buf->col);
+#if !CONFIG_ANS
+  setup_bool_decoder(buf->data, twd->data_end, buf->size, &twd->error_info,
+                     &twd->bit_reader, pbi->decrypt_cb, pbi->decrypt_state);
+#else
+  setup_token_decoder(buf->data, twd->data_end, buf->size, &twd->error_info,
+                      &twd->bit_reader, pbi->decrypt_cb, pbi->decrypt_state);
+#endif  // CONFIG_ANS
+  av1_init_macroblockd(cm, &twd->xd,
+#if CONFIG_PVQ
+                       twd->pvq_ref_coeff,
+#endif
+                       twd->dqcoeff);
+  twd->xd.error_info = &twd->error_info;
+#if CONFIG_PVQ
+  daala_dec_init(&twd->xd.daala_dec, &twd->bit_reader.ec);
+#endif
+#if CONFIG_PALETTE
+  twd->xd.plane[0].color_index_map = twd->color_index_map[0];
+  twd->xd.plane[1].color_index_map = twd->color_index_map[1];
+#endif  // CONFIG_PALETTE
+
+  if (tile_rows_mt(pbi)) {
+    for (i = 0; i < MAX_MB_PLANE; ++i)
+      twd->xd.above_context[i] = twd->above_context[i];
+    twd->xd.above_seg_context = twd->above_seg_context;
+    zero_tile_worker_above_context(cm, twd, tile_info);
+  } else {
+    av1_zero_above_context(cm, tile_info->mi_col_start, tile_info->mi_col_end);
+  }
+}
+
+// Decodes tiles until there are none left to take.
 static int tile_worker_hook(TileWorkerData *const tile_data,
-                            const TileInfo *const tile) {
+                            TileInfo *const tile) {
   AV1Decoder *const pbi = tile_data->pbi;
-  const AV1_COMMON *const cm = &pbi->common;
+  AV1_COMMON *const cm = &pbi->common;
+  const TileBufferDec *buf;
   int mi_row, mi_col;
 
   if (setjmp(tile_data->error_info.jmp)) {
@@ -3471,41 +4020,79 @@ static int tile_worker_hook(TileWorkerData *const tile_data,
   }
 
   tile_data->error_info.setjmp = 1;
-  tile_data->xd.error_info = &tile_data->error_info;
 
-  av1_zero_above_context(&pbi->common, tile->mi_col_start, tile->mi_col_end);
+  while ((buf = get_next_tile_job(pbi, tile_data)) != NULL) {
+    init_tile_worker_data(pbi, tile_data, tile, buf);
 
-  for (mi_row = tile->mi_row_start; mi_row < tile->mi_row_end;
-       mi_row += cm->mib_size) {
-    av1_zero_left_context(&tile_data->xd);
+    for (mi_row = tile->mi_row_start; mi_row < tile->mi_row_end;
+         mi_row += cm->mib_size) {
+      av1_zero_left_context(&tile_data->xd);
 
-    for (mi_col = tile->mi_col_start; mi_col < tile->mi_col_end;
-         mi_col += cm->mib_size) {
-      decode_partition(pbi, &tile_data->xd,
+      for (mi_col = tile->mi_col_start; mi_col < tile->mi_col_end;
+           mi_col += cm->mib_size) {
+        decode_partition(pbi, &tile_data->xd,
 #if CONFIG_SUPERTX
-                       0,
+                         0,
 #endif
-                       mi_row, mi_col, &tile_data->bit_reader, cm->sb_size,
-                       b_width_log2_lookup[cm->sb_size]);
+                         mi_row, mi_col, &tile_data->bit_reader, cm->sb_size,
+                         b_width_log2_lookup[cm->sb_size]);
+      }
     }
+    if (tile_data->xd.corrupted) return 0;
+
+#if !(CONFIG_ANS || CONFIG_EXT_TILE)
+    if (buf->row == cm->tile_rows - 1 && buf->col == cm->tile_cols - 1)
+      pbi->tile_mt_data_end = aom_reader_find_end(&tile_data->bit_reader);
+#endif  // !(CONFIG_ANS || CONFIG_EXT_TILE)
   }
-  return !tile_data->xd.corrupted;
+  return 1;
 }
 
-// sorts in descending order
-static int compare_tile_buffers(const void *a, const void *b) {
-  const TileBufferDec *const buf1 = (const TileBufferDec *)a;
-  const TileBufferDec *const buf2 = (const TileBufferDec *)b;
-  return (int)(buf2->size - buf1->size);
+// Sorts in descending order of size, keeping tiles of the same size in raster
+// order.
+static int compare_tile_jobs(const void *a, const void *b) {
+  const TileBufferDec *const buf1 = *(const TileBufferDec *const *)a;
+  const TileBufferDec *const buf2 = *(const TileBufferDec *const *)b;
+  if (buf1->size != buf2->size) return buf1->size < buf2->size ? 1 : -1;
+  if (buf1->row != buf2->row) return buf1->row - buf2->row;
+  return buf1->col - buf2->col;
 }
 
+// Allocates the above contexts that let the tile workers decode tiles from
+// different tile rows at the same time.
+static void alloc_tile_worker_contexts(AV1Decoder *pbi) {
+  AV1_COMMON *const cm = &pbi->common;
+  const int aligned_mi_cols =
+      ALIGN_POWER_OF_TWO(cm->mi_cols, MAX_MIB_SIZE_LOG2);
+  int i, plane;
+
+  if (pbi->tile_worker_context_cols >= aligned_mi_cols) return;
+
+  for (i = 0; i < pbi->num_tile_workers; ++i) {
+    TileWorkerData *const twd = &pbi->tile_worker_data[i];
+    for (plane = 0; plane < MAX_MB_PLANE; ++plane) {
+      aom_free(twd->above_context[plane]);
+      CHECK_MEM_ERROR(cm, twd->above_context[plane],
+                      (ENTROPY_CONTEXT *)aom_calloc(
+                          2 * aligned_mi_cols, sizeof(*twd->above_context[0])));
+    }
+    aom_free(twd->above_seg_context);
+    CHECK_MEM_ERROR(cm, twd->above_seg_context,
+                    (PARTITION_CONTEXT *)aom_calloc(
+                        aligned_mi_cols, sizeof(*twd->above_seg_context)));
+  }
+  pbi->tile_worker_context_cols = aligned_mi_cols;
+}
+
+// Decodes the tiles on the tile workers, through a work-stealing queue of
+// tiles dealt out largest first. The tile rows are decoded in parallel too
+// with row multi-threading, and otherwise one after another.
 static const uint8_t *decode_tiles_mt(AV1Decoder *pbi, const uint8_t *data,
                                       const uint8_t *data_end) {
   AV1_COMMON *const cm = &pbi->common;
   const AVxWorkerInterface *const winterface = aom_get_worker_interface();
   const int tile_cols = cm->tile_cols;
   const int tile_rows = cm->tile_rows;
-  const int num_workers = AOMMIN(pbi->max_threads & ~1, tile_cols);
   TileBufferDec(*const tile_buffers)[MAX_TILE_COLS] = pbi->tile_buffers;
 #if CONFIG_EXT_TILE
   const int dec_tile_row = AOMMIN(pbi->dec_tile_row, tile_rows);
@@ -3522,51 +4109,45 @@ static const uint8_t *decode_tiles_mt(AV1Decoder *pbi, const uint8_t *data,
   const int tile_cols_start = 0;
   const int tile_cols_end = tile_cols;
 #endif  // CONFIG_EXT_TILE
+  // The number of tile rows decoded at the same time.
+  const int batch_rows =
+      tile_rows_mt(pbi) ? tile_rows_end - tile_rows_start : 1;
+  const int max_jobs = batch_rows * (tile_cols_end - tile_cols_start);
+  int num_workers;
   int tile_row, tile_col;
   int i;
 
-#if !(CONFIG_ANS || CONFIG_EXT_TILE)
-  int final_worker = -1;
-#endif  // !(CONFIG_ANS || CONFIG_EXT_TILE)
-
   assert(tile_rows <= MAX_TILE_ROWS);
   assert(tile_cols <= MAX_TILE_COLS);
 
   assert(tile_cols * tile_rows > 1);
 
-  // TODO(jzern): See if we can remove the restriction of passing in max
-  // threads to the decoder.
-  if (pbi->num_tile_workers == 0) {
-    const int num_threads = pbi->max_threads & ~1;
-    CHECK_MEM_ERROR(cm, pbi->tile_workers,
-                    aom_malloc(num_threads * sizeof(*pbi->tile_workers)));
-    // Ensure tile data offsets will be properly aligned. This may fail on
-    // platforms without DECLARE_ALIGNED().
-    assert((sizeof(*pbi->tile_worker_data) % 16) == 0);
-    CHECK_MEM_ERROR(
-        cm, pbi->tile_worker_data,
-        aom_memalign(32, num_threads * sizeof(*pbi->tile_worker_data)));
-    CHECK_MEM_ERROR(cm, pbi->tile_worker_info,
-                    aom_malloc(num_threads * sizeof(*pbi->tile_worker_info)));
-    for (i = 0; i < num_threads; ++i) {
-      AVxWorker *const worker = &pbi->tile_workers[i];
-      ++pbi->num_tile_workers;
-
-      winterface->init(worker);
-      if (i < num_threads - 1 && !winterface->reset(worker)) {
-        aom_internal_error(&cm->error, AOM_CODEC_ERROR,
-                           "Tile decoder thread creation failed");
-      }
-    }
+  create_tile_workers(pbi);
+  num_workers = AOMMIN(pbi->num_tile_workers, max_jobs);
+  if (tile_rows_mt(pbi)) alloc_tile_worker_contexts(pbi);
+
+  if (pbi->allocated_tile_jobs < max_jobs) {
+    aom_free(pbi->tile_jobs);
+    CHECK_MEM_ERROR(cm, pbi->tile_jobs,
+                    aom_malloc(max_jobs * sizeof(*pbi->tile_jobs)));
+    aom_job_queue_dealloc(&pbi->tile_job_queue);
+    if (!aom_job_queue_alloc(&pbi->tile_job_queue, pbi->num_tile_workers,
+                             max_jobs))
+      aom_internal_error(&cm->error, AOM_CODEC_MEM_ERROR,
+                         "Failed to allocate pbi->tile_job_queue");
+    pbi->allocated_tile_jobs = max_jobs;
   }
 
   // Reset tile decoding hook
   for (i = 0; i < num_workers; ++i) {
     AVxWorker *const worker = &pbi->tile_workers[i];
+    TileWorkerData *const twd = &pbi->tile_worker_data[i];
     winterface->sync(worker);
     worker->hook = (AVxWorkerHook)tile_worker_hook;
-    worker->data1 = &pbi->tile_worker_data[i];
+    worker->data1 = twd;
     worker->data2 = &pbi->tile_worker_info[i];
+    twd->pbi = pbi;
+    twd->data_end = data_end;
   }
 
   // Initialize thread frame counts.
@@ -3580,94 +4161,48 @@ static const uint8_t *decode_tiles_mt(AV1Decoder *pbi, const uint8_t *data,
   // Load tile data into tile_buffers
   get_tile_buffers(pbi, data, data_end, tile_buffers);
 
-  for (tile_row = tile_rows_start; tile_row < tile_rows_end; ++tile_row) {
-    // Sort the buffers in this tile row based on size in descending order.
-    qsort(&tile_buffers[tile_row][tile_cols_start],
-          tile_cols_end - tile_cols_start, sizeof(tile_buffers[0][0]),
-          compare_tile_buffers);
-
-    // Rearrange the tile buffers in this tile row such that per-tile group
-    // the largest, and presumably the most difficult tile will be decoded in
-    // the main thread. This should help minimize the number of instances
-    // where the main thread is waiting for a worker to complete.
-    {
-      int group_start;
-      for (group_start = tile_cols_start; group_start < tile_cols_end;
-           group_start += num_workers) {
-        const int group_end = AOMMIN(group_start + num_workers, tile_cols);
-        const TileBufferDec largest = tile_buffers[tile_row][group_start];
-        memmove(&tile_buffers[tile_row][group_start],
-                &tile_buffers[tile_row][group_start + 1],
-                (group_end - group_start - 1) * sizeof(tile_buffers[0][0]));
-        tile_buffers[tile_row][group_end - 1] = largest;
-      }
-    }
-
-    for (tile_col = tile_cols_start; tile_col < tile_cols_end;) {
-      // Launch workers for individual columns
-      for (i = 0; i < num_workers && tile_col < tile_cols_end;
-           ++i, ++tile_col) {
-        TileBufferDec *const buf = &tile_buffers[tile_row][tile_col];
-        AVxWorker *const worker = &pbi->tile_workers[i];
-        TileWorkerData *const twd = (TileWorkerData *)worker->data1;
-        TileInfo *const tile_info = (TileInfo *)worker->data2;
-
-        twd->pbi = pbi;
-        twd->xd = pbi->mb;
-        twd->xd.corrupted = 0;
-        twd->xd.counts =
-            cm->refresh_frame_context == REFRESH_FRAME_CONTEXT_BACKWARD
-                ? &twd->counts
-                : NULL;
-        av1_zero(twd->dqcoeff);
-        av1_tile_init(tile_info, cm, tile_row, buf->col);
-        av1_tile_init(&twd->xd.tile, cm, tile_row, buf->col);
-#if !CONFIG_ANS
-        setup_bool_decoder(buf->data, data_end, buf->size, &cm->error,
-                           &twd->bit_reader, pbi->decrypt_cb,
-                           pbi->decrypt_state);
-#else
-        setup_token_decoder(buf->data, data_end, buf->size, &cm->error,
-                            &twd->bit_reader, pbi->decrypt_cb,
-                            pbi->decrypt_state);
-#endif  // CONFIG_ANS
-        av1_init_macroblockd(cm, &twd->xd,
-#if CONFIG_PVQ
-                             twd->pvq_ref_coeff,
-#endif
-                             twd->dqcoeff);
-#if CONFIG_PVQ
-        daala_dec_init(&twd->xd.daala_dec, &twd->bit_reader.ec);
-#endif
-#if CONFIG_PALETTE
-        twd->xd.plane[0].color_index_map = twd->color_index_map[0];
-        twd->xd.plane[1].color_index_map = twd->color_index_map[1];
-#endif  // CONFIG_PALETTE
-
-        worker->had_error = 0;
-        if (i == num_workers - 1 || tile_col == tile_cols_end - 1) {
-          winterface->execute(worker);
-        } else {
-          winterface->launch(worker);
-        }
-
 #if !(CONFIG_ANS || CONFIG_EXT_TILE)
-        if (tile_row == tile_rows - 1 && buf->col == tile_cols - 1) {
-          final_worker = i;
-        }
+  pbi->tile_mt_data_end = NULL;
 #endif  // !(CONFIG_ANS || CONFIG_EXT_TILE)
-      }
 
-      // Sync all workers
-      for (; i > 0; --i) {
-        AVxWorker *const worker = &pbi->tile_workers[i - 1];
-        // TODO(jzern): The tile may have specific error data associated with
-        // its aom_internal_error_info which could be propagated to the main
-        // info in cm. Additionally once the threads have been synced and an
-        // error is detected, there's no point in continuing to decode tiles.
-        pbi->mb.corrupted |= !winterface->sync(worker);
+  for (tile_row = tile_rows_start; tile_row < tile_rows_end;
+       tile_row += batch_rows) {
+    const int batch_end = AOMMIN(tile_row + batch_rows, tile_rows_end);
+    int row;
+
+    // Deal the tiles out largest first, as the largest tiles are presumably
+    // the slowest to decode. A worker that runs out of tiles steals the
+    // smallest remaining ones from the others.
+    pbi->num_tile_jobs = 0;
+    for (row = tile_row; row < batch_end; ++row) {
+      for (tile_col = tile_cols_start; tile_col < tile_cols_end; ++tile_col)
+        pbi->tile_jobs[pbi->num_tile_jobs++] = &tile_buffers[row][tile_col];
+    }
+    qsort(pbi->tile_jobs, pbi->num_tile_jobs, sizeof(*pbi->tile_jobs),
+          compare_tile_jobs);
+    aom_job_queue_reset(&pbi->tile_job_queue, num_workers, 0);
+    aom_job_queue_push_range(&pbi->tile_job_queue, pbi->num_tile_jobs);
+
+    for (i = 0; i < num_workers; ++i) {
+      AVxWorker *const worker = &pbi->tile_workers[i];
+      worker->had_error = 0;
+      if (i == num_workers - 1) {
+        winterface->execute(worker);
+      } else {
+        winterface->launch(worker);
       }
     }
+
+    // Sync all workers
+    for (i = 0; i < num_workers; ++i) {
+      AVxWorker *const worker = &pbi->tile_workers[i];
+      // TODO(jzern): The tile may have specific error data associated with
+      // its aom_internal_error_info which could be propagated to the main
+      // info in cm. Additionally once the threads have been synced and an
+      // error is detected, there's no point in continuing to decode tiles.
+      pbi->mb.corrupted |= !winterface->sync(worker);
+    }
+    aom_job_queue_finish(&pbi->tile_job_queue);
   }
 
   // Accumulate thread frame counts.
@@ -3685,12 +4220,9 @@ static const uint8_t *decode_tiles_mt(AV1Decoder *pbi, const uint8_t *data,
 #if CONFIG_ANS
   return data_end;
 #else
-  assert(final_worker != -1);
-  {
-    TileWorkerData *const twd =
-        (TileWorkerData *)pbi->tile_workers[final_worker].data1;
-    return aom_reader_find_end(&twd->bit_reader);
-  }
+  // This is only unset if the frame is corrupt.
+  assert(pbi->tile_mt_data_end != NULL || pbi->mb.corrupted);
+  return pbi->tile_mt_data_end;
 #endif  // CONFIG_ANS
 #endif  // CONFIG_EXT_TILE
 }
@@ -4533,6 +5065,62 @@ BITSTREAM_PROFILE av1_read_profile(struct aom_read_bit_buffer *rb) {
   return (BITSTREAM_PROFILE)profile;
 }
 
+// Runs the in-loop filters that follow deblocking over the whole frame, one
+// filter after the other.
+static void filter_frame(AV1Decoder *pbi, YV12_BUFFER_CONFIG *new_fb) {
+  AV1_COMMON *const cm = &pbi->common;
+  (void)cm;
+  (void)new_fb;
+#if CONFIG_LOOP_RESTORATION
+  if (cm->rst_info.restoration_type != RESTORE_NONE) {
+    if (pbi->max_threads > 1) {
+      create_tile_workers(pbi);
+      av1_loop_restoration_frame_mt(new_fb, cm, &cm->rst_info, 0, 0,
+                                    pbi->tile_workers, pbi->num_tile_workers,
+                                    &pbi->lr_row_sync);
+    } else {
+      av1_loop_restoration_init(&cm->rst_internal, &cm->rst_info,
+                                cm->frame_type == KEY_FRAME, cm->width,
+                                cm->height);
+      av1_loop_restoration_rows(new_fb, cm, 0, cm->mi_rows, 0);
+    }
+  }
+#endif  // CONFIG_LOOP_RESTORATION
+
+#if CONFIG_DERING
+  if (cm->dering_level && !cm->skip_loop_filter) {
+    if (pbi->max_threads > 1) {
+      create_tile_workers(pbi);
+      av1_dering_frame_mt(new_fb, cm, &pbi->mb, cm->dering_level,
+                          pbi->tile_workers, pbi->num_tile_workers);
+    } else {
+      av1_dering_frame(new_fb, cm, &pbi->mb, cm->dering_level);
+    }
+  }
+#endif  // CONFIG_DERING
+
+#if CONFIG_CLPF
+  if (!cm->skip_loop_filter) {
+    const YV12_BUFFER_CONFIG *const frame = new_fb;
+    if (cm->clpf_strength_y) {
+      av1_clpf_frame(frame, NULL, cm, cm->clpf_size != CLPF_NOSIZE,
+                     cm->clpf_strength_y + (cm->clpf_strength_y == 3),
+                     4 + cm->clpf_size, AOM_PLANE_Y, clpf_bit);
+    }
+    if (cm->clpf_strength_u) {
+      av1_clpf_frame(frame, NULL, cm, 0,  // No block signals for chroma
+                     cm->clpf_strength_u + (cm->clpf_strength_u == 3), 4,
+                     AOM_PLANE_U, NULL);
+    }
+    if (cm->clpf_strength_v) {
+      av1_clpf_frame(frame, NULL, cm, 0,  // No block signals for chroma
+                     cm->clpf_strength_v + (cm->clpf_strength_v == 3), 4,
+                     AOM_PLANE_V, NULL);
+    }
+  }
+#endif  // CONFIG_CLPF
+}
+
 void av1_decode_frame(AV1Decoder *pbi, const uint8_t *data,
                       const uint8_t *data_end, const uint8_t **p_data_end) {
   AV1_COMMON *const cm = &pbi->common;
@@ -4649,7 +5237,7 @@ void av1_decode_frame(AV1Decoder *pbi, const uint8_t *data,
 #if CONFIG_EXT_TILE
       && pbi->dec_tile_col < 0  // Decoding all columns
 #endif                          // CONFIG_EXT_TILE
-      && cm->tile_cols > 1) {
+      && (cm->tile_cols > 1 || (tile_rows_mt(pbi) && cm->tile_rows > 1))) {
     // Multi-threaded tile decoder
     *p_data_end = decode_tiles_mt(pbi, data + first_partition_size, data_end);
     if (!xd->corrupted) {
@@ -4667,41 +5255,16 @@ void av1_decode_frame(AV1Decoder *pbi, const uint8_t *data,
   } else {
     *p_data_end = decode_tiles(pbi, data + first_partition_size, data_end);
   }
-#if CONFIG_LOOP_RESTORATION
-  if (cm->rst_info.restoration_type != RESTORE_NONE) {
-    av1_loop_restoration_init(&cm->rst_internal, &cm->rst_info,
-                              cm->frame_type == KEY_FRAME, cm->width,
-                              cm->height);
-    av1_loop_restoration_rows(new_fb, cm, 0, cm->mi_rows, 0);
-  }
-#endif  // CONFIG_LOOP_RESTORATION
-
-#if CONFIG_DERING
-  if (cm->dering_level && !cm->skip_loop_filter) {
-    av1_dering_frame(&pbi->cur_buf->buf, cm, &pbi->mb, cm->dering_level);
-  }
-#endif  // CONFIG_DERING
+  // The analyzer records the mode info and the filter parameters, not the
+  // pixels, so it is done once the tiles are decoded, ahead of CLPF.
   analyzer_record_frame(pbi);
-
-#if CONFIG_CLPF
-  if (!cm->skip_loop_filter) {
-    const YV12_BUFFER_CONFIG *const frame = &pbi->cur_buf->buf;
-    if (cm->clpf_strength_y) {
-      av1_clpf_frame(frame, NULL, cm, cm->clpf_size != CLPF_NOSIZE,
-                     cm->clpf_strength_y + (cm->clpf_strength_y == 3),
-                     4 + cm->clpf_size, AOM_PLANE_Y, clpf_bit);
-    }
-    if (cm->clpf_strength_u) {
-      av1_clpf_frame(frame, NULL, cm, 0,  // No block signals for chroma
-                     cm->clpf_strength_u + (cm->clpf_strength_u == 3), 4,
-                     AOM_PLANE_U, NULL);
-    }
-    if (cm->clpf_strength_v) {
-      av1_clpf_frame(frame, NULL, cm, 0,  // No block signals for chroma
-                     cm->clpf_strength_v + (cm->clpf_strength_v == 3), 4,
-                     AOM_PLANE_V, NULL);
-    }
+  if (use_filter_pipeline(pbi)) {
+    if (!pbi->filter_rows.active) filter_rows_init(pbi, new_fb);
+    filter_rows_finish(pbi);
+  } else {
+    filter_frame(pbi, new_fb);
   }
+#if CONFIG_CLPF
   if (cm->clpf_blocks) aom_free(cm->clpf_blocks);
 #endif
 
@@ -32,6 +32,10 @@ BITSTREAM_PROFILE av1_read_profile(struct aom_read_bit_buffer *rb);
 void av1_decode_frame(struct AV1Decoder *pbi, const uint8_t *data,
                       const uint8_t *data_end, const uint8_t **p_data_end);
 
+// Stops the in-loop filters of a frame whose decoding has failed, and frees
+// their state.
+void av1_abort_filter_rows(struct AV1Decoder *pbi);
+
 #ifdef __cplusplus
 }  // extern "C"
 #endif
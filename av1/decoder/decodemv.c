@@ -1405,10 +1405,12 @@ static int read_is_inter_block(AV1_COMMON *const cm, MACROBLOCKD *const xd,
   }
 }
 
+// Waits until the motion vectors of the previous frame are decoded down to
+// mi_row, which they are once its pixels are final below the row.
 static void fpm_sync(void *const data, int mi_row) {
   AV1Decoder *const pbi = (AV1Decoder *)data;
   av1_frameworker_wait(pbi->frame_worker_owner, pbi->common.prev_frame,
-                       mi_row << pbi->common.mib_size_log2);
+                       (mi_row + 1) * MI_SIZE);
 }
 
 static void read_inter_block_mode_info(AV1Decoder *const pbi,
@@ -1448,6 +1450,11 @@ static void read_inter_block_mode_info(AV1Decoder *const pbi,
   read_ref_frames(cm, xd, r, mbmi->segment_id, mbmi->ref_frame);
   is_compound = has_second_ref(mbmi);
 
+  // The motion vector candidates read the previous frame's motion vectors down
+  // to the row below the block.
+  if (cm->frame_parallel_decode && cm->use_prev_frame_mvs)
+    fpm_sync(pbi, AOMMIN(mi_row + xd->n8_h, cm->mi_rows - 1));
+
   for (ref = 0; ref < 1 + is_compound; ++ref) {
     MV_REFERENCE_FRAME frame = mbmi->ref_frame[ref];
     RefBuffer *ref_buf = &cm->frame_refs[frame - LAST_FRAME];
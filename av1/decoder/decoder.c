@@ -146,6 +146,7 @@ AV1Decoder *av1_decoder_create(BufferPool *const pool) {
   cm->error.setjmp = 0;
 
   aom_get_worker_interface()->init(&pbi->lf_worker);
+  aom_get_worker_interface()->init(&pbi->filter_worker);
 
   return pbi;
 }
@@ -157,17 +158,29 @@ void av1_decoder_remove(AV1Decoder *pbi) {
 
   aom_get_worker_interface()->end(&pbi->lf_worker);
   aom_free(pbi->lf_worker.data1);
+  aom_get_worker_interface()->end(&pbi->filter_worker);
   aom_free(pbi->tile_data);
   for (i = 0; i < pbi->num_tile_workers; ++i) {
     AVxWorker *const worker = &pbi->tile_workers[i];
+    TileWorkerData *const twd = &pbi->tile_worker_data[i];
+    int plane;
     aom_get_worker_interface()->end(worker);
+    for (plane = 0; plane < MAX_MB_PLANE; ++plane)
+      aom_free(twd->above_context[plane]);
+    aom_free(twd->above_seg_context);
   }
   aom_free(pbi->tile_worker_data);
   aom_free(pbi->tile_worker_info);
   aom_free(pbi->tile_workers);
 
-  if (pbi->num_tile_workers > 0) {
+  aom_free(pbi->tile_jobs);
+  aom_job_queue_dealloc(&pbi->tile_job_queue);
+
+  if (pbi->num_tile_workers > 0 || pbi->use_filter_worker) {
     av1_loop_filter_dealloc(&pbi->lf_row_sync);
+#if CONFIG_LOOP_RESTORATION
+    av1_loop_restoration_dealloc(&pbi->lr_row_sync);
+#endif  // CONFIG_LOOP_RESTORATION
   }
 
 #if CONFIG_ACCOUNTING
@@ -396,9 +409,14 @@ int av1_receive_compressed_data(AV1Decoder *pbi, size_t size,
     // Synchronize all threads immediately as a subsequent decode call may
     // cause a resize invalidating some allocations.
     winterface->sync(&pbi->lf_worker);
+#if !CONFIG_PARALLEL_DEBLOCKING
+    // Release the loop filter workers waiting for rows to be decoded.
+    av1_loop_filter_decoded_rows(&pbi->lf_row_sync, INT_MAX);
+#endif  // !CONFIG_PARALLEL_DEBLOCKING
     for (i = 0; i < pbi->num_tile_workers; ++i) {
       winterface->sync(&pbi->tile_workers[i]);
     }
+    av1_abort_filter_rows(pbi);
 
     lock_buffer_pool(pool);
     // Release all the reference buffers if worker thread is holding them.
@@ -435,12 +453,16 @@ int av1_receive_compressed_data(AV1Decoder *pbi, size_t size,
 
   swap_frame_buffers(pbi);
 
+  // In frame parallel decoding the borders are extended as the rows are
+  // filtered, before they are reported to the other frame workers.
+  if (!cm->frame_parallel_decode
 #if CONFIG_EXT_TILE
-  // For now, we only extend the frame borders when the whole frame is decoded.
-  // Later, if needed, extend the border for the decoded tile on the frame
-  // border.
-  if (pbi->dec_tile_row == -1 && pbi->dec_tile_col == -1)
+      // For now, we only extend the frame borders when the whole frame is
+      // decoded. Later, if needed, extend the border for the decoded tile on
+      // the frame border.
+      && pbi->dec_tile_row == -1 && pbi->dec_tile_col == -1
 #endif  // CONFIG_EXT_TILE
+      )
     aom_extend_frame_inner_borders(cm->frame_to_show);
 
   aom_clear_system_state();
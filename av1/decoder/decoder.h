@@ -17,10 +17,17 @@
 #include "aom/aom_codec.h"
 #include "aom_dsp/bitreader.h"
 #include "aom_scale/yv12config.h"
+#include "aom_util/aom_job_queue.h"
 #include "aom_util/aom_thread.h"
 
 #include "av1/common/thread_common.h"
 #include "av1/common/onyxc_int.h"
+#if CONFIG_CLPF
+#include "av1/common/clpf.h"
+#endif
+#if CONFIG_DERING
+#include "av1/common/dering.h"
+#endif
 #include "av1/decoder/dthread.h"
 #if CONFIG_ACCOUNTING
 #include "av1/common/accounting.h"
@@ -54,6 +61,8 @@ typedef struct TileData {
 
 typedef struct TileWorkerData {
   struct AV1Decoder *pbi;
+  // The end of the frame data.
+  const uint8_t *data_end;
   aom_reader bit_reader;
   FRAME_COUNTS counts;
   DECLARE_ALIGNED(16, MACROBLOCKD, xd);
@@ -67,6 +76,10 @@ typedef struct TileWorkerData {
   DECLARE_ALIGNED(16, uint8_t, color_index_map[2][MAX_SB_SQUARE]);
 #endif  // CONFIG_PALETTE
   struct aom_internal_error_info error_info;
+  // Above context used in place of the one in AV1_COMMON, so that tiles from
+  // different tile rows can be decoded at the same time.
+  ENTROPY_CONTEXT *above_context[MAX_MB_PLANE];
+  PARTITION_CONTEXT *above_seg_context;
 } TileWorkerData;
 
 typedef struct TileBufferDec {
@@ -74,9 +87,41 @@ typedef struct TileBufferDec {
   size_t size;
   const uint8_t *raw_data_end;  // The end of the raw tile buffer in the
                                 // bit stream.
+  int row;                      // only used with multi-threaded decoding
   int col;                      // only used with multi-threaded decoding
 } TileBufferDec;
 
+// The in-loop filters of a frame run a superblock row at a time, from the top.
+typedef struct FilterRows {
+  YV12_BUFFER_CONFIG *frame;
+  // Whether the filters have been set up for the current frame.
+  int active;
+  // Whether the rows are filtered on the filter worker as they are decoded.
+  int on_worker;
+  // The first mi row not yet deblocked.
+  int next_mi_row;
+  // In frame parallel decoding, whether the final rows have their borders
+  // extended and are reported to the other frame workers as they are done,
+  // and how many luma rows have been.
+  int publish;
+  int published_rows;
+  int do_loop_filter;
+#if CONFIG_LOOP_RESTORATION
+  int do_restoration;
+  RestorationPlane rp[MAX_MB_PLANE];
+  YV12_BUFFER_CONFIG lr_tmp_buf;
+  uint8_t *lr_tmpbuf;
+#endif  // CONFIG_LOOP_RESTORATION
+#if CONFIG_DERING
+  int do_dering;
+  DeringFrame df;
+#endif  // CONFIG_DERING
+#if CONFIG_CLPF
+  unsigned int clpf_strength[MAX_MB_PLANE];
+  ClpfPlane cp[MAX_MB_PLANE];
+#endif  // CONFIG_CLPF
+} FilterRows;
+
 typedef struct AV1Decoder {
   DECLARE_ALIGNED(16, MACROBLOCKD, mb);
 
@@ -102,13 +147,46 @@ typedef struct AV1Decoder {
 
   TileBufferDec tile_buffers[MAX_TILE_ROWS][MAX_TILE_COLS];
 
+  // The tiles for the tile workers to decode, largest first, and the queue
+  // through which the workers take them, by index into tile_jobs.
+  TileBufferDec **tile_jobs;
+  int allocated_tile_jobs;
+  int num_tile_jobs;
+  AOMJobQueue tile_job_queue;
+  // The number of columns the tile workers' above contexts are allocated for.
+  int tile_worker_context_cols;
+#if !(CONFIG_ANS || CONFIG_EXT_TILE)
+  // The end of the last tile in the frame, set by the worker that decodes it.
+  const uint8_t *tile_mt_data_end;
+#endif  // !(CONFIG_ANS || CONFIG_EXT_TILE)
+
   AV1LfSync lf_row_sync;
+#if CONFIG_LOOP_RESTORATION
+  AV1LrSync lr_row_sync;
+#endif  // CONFIG_LOOP_RESTORATION
+
+  FilterRows filter_rows;
+  // In frame parallel decoding, run the in-loop filters on a thread of their
+  // own, following the decoding of the frame through lf_row_sync.
+  int use_filter_worker;
+  AVxWorker filter_worker;
 
   aom_decrypt_cb decrypt_cb;
   void *decrypt_state;
 
   int max_threads;
+  // The shared pool the worker threads run on, if any. All the workers of a
+  // decoder instance, its frame workers included, are queued under the same
+  // pool_owner, so that the pool shares its threads out fairly between
+  // instances.
+  aom_thread_pool_t *thread_pool;
+  const void *pool_owner;
   int inv_tile_order;
+  // Run the in-loop filters as a pipeline over superblock rows.
+  int pipelined_filters;
+  // Decode tile rows in parallel, and deblock superblock rows in parallel
+  // with decoding.
+  int row_mt;
   int need_resync;   // wait for key/intra-only frame.
   int hold_ref_buf;  // hold the reference buffer.
 
@@ -4120,7 +4120,7 @@ static void write_global_motion(AV1_COMP *cpi, aom_writer *w) {
     // With ref-mv, clearing unused global motion models here is
     // unsafe, and we need to rely on the recode loop to do it
     // instead. See av1_find_mv_refs for details.
-    if (!cpi->global_motion_used[frame]) {
+    if (!cpi->td.rd_counts.global_motion_used[frame]) {
       set_default_gmparams(&cm->global_motion[frame]);
     }
 #endif
@@ -4129,8 +4129,10 @@ static void write_global_motion(AV1_COMP *cpi, aom_writer *w) {
     /*
     printf("Frame %d/%d: Enc Ref %d (used %d): %d %d %d %d\n",
            cm->current_video_frame, cm->show_frame, frame,
-           cpi->global_motion_used[frame], cm->global_motion[frame].wmmat[0],
-           cm->global_motion[frame].wmmat[1], cm->global_motion[frame].wmmat[2],
+           cpi->td.rd_counts.global_motion_used[frame],
+           cm->global_motion[frame].wmmat[0],
+           cm->global_motion[frame].wmmat[1],
+           cm->global_motion[frame].wmmat[2],
            cm->global_motion[frame].wmmat[3]);
            */
   }
@@ -83,6 +83,32 @@ typedef struct {
 } PALETTE_BUFFER;
 #endif  // CONFIG_PALETTE
 
+// The transform RD results of a residual block, found by the hash of the
+// residual together with the coding parameters that also decide them. The
+// entries of older generations are stale.
+typedef struct {
+  uint64_t hash;
+  uint64_t params;
+  int rdmult;
+  unsigned int generation;
+  int rate;
+  uint16_t eob;
+  int64_t dist;
+  int64_t sse;
+} TXFM_RD_RESULT;
+
+#define TXFM_RD_CACHE_BITS 12
+#define TXFM_RD_CACHE_SIZE (1 << TXFM_RD_CACHE_BITS)
+
+typedef struct {
+  TXFM_RD_RESULT results[TXFM_RD_CACHE_SIZE];
+  unsigned int generation;
+  // Hit-rate counters over the life of the cache, see
+  // av1_get_txfm_rd_cache_stats().
+  int64_t lookups;
+  int64_t hits;
+} TXFM_RD_CACHE;
+
 typedef struct macroblock MACROBLOCK;
 struct macroblock {
   struct macroblock_plane plane[MAX_MB_PLANE];
@@ -106,6 +132,11 @@ struct macroblock {
   int mb_energy;
   int *m_search_count_ptr;
   int *ex_search_count_ptr;
+#if CONFIG_GLOBAL_MOTION
+  // Running count of the blocks coded with each global motion model, used to
+  // amortize the cost of signalling the models.
+  int *global_motion_used;
+#endif  // CONFIG_GLOBAL_MOTION
 
 #if CONFIG_VAR_TX
   unsigned int txb_split_count;
@@ -149,6 +180,9 @@ struct macroblock {
 #if CONFIG_PALETTE
   PALETTE_BUFFER *palette_buffer;
 #endif  // CONFIG_PALETTE
+  // The transform RD results of the tile being encoded, see
+  // av1_reset_txfm_rd_cache().
+  TXFM_RD_CACHE *txfm_rd_cache;
 
   // These define limits to motion vector components to prevent them
   // from extending outside the UMV borders
@@ -13,7 +13,11 @@
 #include "./aom_dsp_rtcd.h"
 #include "aom/aom_image.h"
 #include "aom/aom_integer.h"
+#include "aom_mem/aom_mem.h"
 #include "av1/common/quant_common.h"
+#include "av1/encoder/clpf_rdo.h"
+#include "av1/encoder/encoder.h"
+#include "av1/encoder/ethread.h"
 
 // Calculate the error of a filtered and unfiltered block
 void aom_clpf_detect_c(const uint8_t *rec, const uint8_t *org, int rstride,
@@ -162,6 +166,74 @@ int av1_clpf_decision(int k, int l, const YV12_BUFFER_CONFIG *rec,
   return *res;
 }
 
+// The square errors of the MI_SIZE x MI_SIZE blocks of a plane, found once
+// for all the filter block sizes.
+typedef struct {
+  AV1_COMP *cpi;
+  const YV12_BUFFER_CONFIG *rec;
+  const YV12_BUFFER_CONFIG *org;
+  int plane;
+  // Blocks per row and column of the plane.
+  int cols;
+  int rows;
+  // sse[0]: unfiltered, sse[1-3]: strength=1,2,4, for each block in raster
+  // order.
+  int (*sse)[4];
+} ClpfSearch;
+
+// Fills in the square errors of the blocks of row |row| of superblocks.
+static void clpf_detect_sb_row(const ClpfSearch *s, int row) {
+  const YV12_BUFFER_CONFIG *const rec = s->rec;
+  const YV12_BUFFER_CONFIG *const org = s->org;
+  const int plane = s->plane;
+  const uint8_t *rec_buffer =
+      plane != AOM_PLANE_Y
+          ? (plane == AOM_PLANE_U ? rec->u_buffer : rec->v_buffer)
+          : rec->y_buffer;
+  const uint8_t *org_buffer =
+      plane != AOM_PLANE_Y
+          ? (plane == AOM_PLANE_U ? org->u_buffer : org->v_buffer)
+          : org->y_buffer;
+  int rec_width = plane != AOM_PLANE_Y ? rec->uv_crop_width : rec->y_crop_width;
+  int rec_height =
+      plane != AOM_PLANE_Y ? rec->uv_crop_height : rec->y_crop_height;
+  int rec_stride = plane != AOM_PLANE_Y ? rec->uv_stride : rec->y_stride;
+  int org_stride = plane != AOM_PLANE_Y ? org->uv_stride : org->y_stride;
+  const int end = AOMMIN((row + 1) * MAX_MIB_SIZE, s->rows);
+  int m, n;
+  for (m = row * MAX_MIB_SIZE; m < end; m++) {
+    for (n = 0; n < s->cols; n++) {
+      int *const sum = s->sse[m * s->cols + n];
+      sum[0] = sum[1] = sum[2] = sum[3] = 0;
+#if CONFIG_AOM_HIGHBITDEPTH
+      if (s->cpi->common.use_highbitdepth) {
+        aom_clpf_detect_multi_hbd(
+            CONVERT_TO_SHORTPTR(rec_buffer), CONVERT_TO_SHORTPTR(org_buffer),
+            rec_stride, org_stride, n * MI_SIZE, m * MI_SIZE, rec_width,
+            rec_height, sum, s->cpi->common.bit_depth - 8, MI_SIZE);
+      } else {
+        aom_clpf_detect_multi(rec_buffer, org_buffer, rec_stride, org_stride,
+                              n * MI_SIZE, m * MI_SIZE, rec_width, rec_height,
+                              sum, MI_SIZE);
+      }
+#else
+      aom_clpf_detect_multi(rec_buffer, org_buffer, rec_stride, org_stride,
+                            n * MI_SIZE, m * MI_SIZE, rec_width, rec_height,
+                            sum, MI_SIZE);
+#endif
+    }
+  }
+}
+
+static int clpf_detect_worker_hook(EncWorkerData *const thread_data,
+                                   ClpfSearch *s) {
+  int row;
+  while ((row = aom_job_queue_pop(&s->cpi->enc_job_queue,
+                                  thread_data->thread_id)) >= 0)
+    clpf_detect_sb_row(s, row);
+  return 1;
+}
+
 // Calculate the square error of all filter settings.  Result:
 // res[0][0]   : unfiltered
 // res[0][1-3] : strength=1,2,4, no signals
@@ -174,28 +246,16 @@ int av1_clpf_decision(int k, int l, const YV12_BUFFER_CONFIG *rec,
 // res[2][1-3] : strength=1,2,4, fb size = 64
 // res[3][0]   : (bit count, fb size = 32)
 // res[3][1-3] : strength=1,2,4, fb size = 32
-static int clpf_rdo(int y, int x, const YV12_BUFFER_CONFIG *rec,
-                    const YV12_BUFFER_CONFIG *org, const AV1_COMMON *cm,
+static int clpf_rdo(const ClpfSearch *s, int y, int x,
                     unsigned int block_size, unsigned int fb_size_log2, int w,
-                    int h, int64_t res[4][8], int plane) {
+                    int h, int64_t res[4][8]) {
+  const AV1_COMMON *const cm = &s->cpi->common;
+  const int plane = s->plane;
   int c, m, n, filtered = 0;
   int sum[8];
-  const int subx = plane != AOM_PLANE_Y && rec->subsampling_x;
-  const int suby = plane != AOM_PLANE_Y && rec->subsampling_y;
+  const int subx = plane != AOM_PLANE_Y && s->rec->subsampling_x;
+  const int suby = plane != AOM_PLANE_Y && s->rec->subsampling_y;
   int bslog = get_msb(block_size);
-  uint8_t *rec_buffer =
-      plane != AOM_PLANE_Y
-          ? (plane == AOM_PLANE_U ? rec->u_buffer : rec->v_buffer)
-          : rec->y_buffer;
-  uint8_t *org_buffer =
-      plane != AOM_PLANE_Y
-          ? (plane == AOM_PLANE_U ? org->u_buffer : org->v_buffer)
-          : org->y_buffer;
-  int rec_width = plane != AOM_PLANE_Y ? rec->uv_crop_width : rec->y_crop_width;
-  int rec_height =
-      plane != AOM_PLANE_Y ? rec->uv_crop_height : rec->y_crop_height;
-  int rec_stride = plane != AOM_PLANE_Y ? rec->uv_stride : rec->y_stride;
-  int org_stride = plane != AOM_PLANE_Y ? org->uv_stride : org->y_stride;
   sum[0] = sum[1] = sum[2] = sum[3] = sum[4] = sum[5] = sum[6] = sum[7] = 0;
   if (plane == AOM_PLANE_Y &&
       fb_size_log2 > (unsigned int)get_msb(MAX_FB_SIZE) - 3) {
@@ -213,17 +273,15 @@ static int clpf_rdo(int y, int x, const YV12_BUFFER_CONFIG *rec,
     oldfiltered = (int)res[i][0];
     res[i][0] = 0;
 
-    filtered |= clpf_rdo(y, x, rec, org, cm, block_size, fb_size_log2, w1, h1,
-                         res, plane);
+    filtered |= clpf_rdo(s, y, x, block_size, fb_size_log2, w1, h1, res);
     if (1 << (fb_size_log2 - bslog) < w)
-      filtered |= clpf_rdo(y, x + (1 << fb_size_log2), rec, org, cm, block_size,
-                           fb_size_log2, w2, h1, res, plane);
+      filtered |= clpf_rdo(s, y, x + (1 << fb_size_log2), block_size,
+                           fb_size_log2, w2, h1, res);
     if (1 << (fb_size_log2 - bslog) < h) {
-      filtered |= clpf_rdo(y + (1 << fb_size_log2), x, rec, org, cm, block_size,
-                           fb_size_log2, w1, h2, res, plane);
-      filtered |=
-          clpf_rdo(y + (1 << fb_size_log2), x + (1 << fb_size_log2), rec, org,
-                   cm, block_size, fb_size_log2, w2, h2, res, plane);
+      filtered |= clpf_rdo(s, y + (1 << fb_size_log2), x, block_size,
+                           fb_size_log2, w1, h2, res);
+      filtered |= clpf_rdo(s, y + (1 << fb_size_log2), x + (1 << fb_size_log2),
+                           block_size, fb_size_log2, w2, h2, res);
     }
 
     // Correct sums for unfiltered blocks
@@ -250,22 +308,11 @@ static int clpf_rdo(int y, int x, const YV12_BUFFER_CONFIG *rec,
           !!cm->mi_grid_visible[(ypos << suby) / MI_SIZE * cm->mi_stride +
                                 (xpos << subx) / MI_SIZE]
                 ->mbmi.skip;
-#if CONFIG_AOM_HIGHBITDEPTH
-      if (cm->use_highbitdepth) {
-        aom_clpf_detect_multi_hbd(CONVERT_TO_SHORTPTR(rec_buffer),
-                                  CONVERT_TO_SHORTPTR(org_buffer), rec_stride,
-                                  org_stride, xpos, ypos, rec_width, rec_height,
-                                  sum + skip, cm->bit_depth - 8, block_size);
-      } else {
-        aom_clpf_detect_multi(rec_buffer, org_buffer, rec_stride, org_stride,
-                              xpos, ypos, rec_width, rec_height, sum + skip,
-                              block_size);
-      }
-#else
-      aom_clpf_detect_multi(rec_buffer, org_buffer, rec_stride, org_stride,
-                            xpos, ypos, rec_width, rec_height, sum + skip,
-                            block_size);
-#endif
+      const int *const sse = s->sse[ypos / MI_SIZE * s->cols + xpos / MI_SIZE];
+      sum[skip] += sse[0];
+      sum[skip + 1] += sse[1];
+      sum[skip + 2] += sse[2];
+      sum[skip + 3] += sse[3];
       filtered |= !skip;
     }
   }
@@ -286,9 +333,11 @@ static int clpf_rdo(int y, int x, const YV12_BUFFER_CONFIG *rec,
 }
 
 void av1_clpf_test_frame(const YV12_BUFFER_CONFIG *rec,
-                         const YV12_BUFFER_CONFIG *org, const AV1_COMMON *cm,
+                         const YV12_BUFFER_CONFIG *org, AV1_COMP *cpi,
                          int *best_strength, int *best_bs, int plane) {
-  int c, j, k, l;
+  AV1_COMMON *const cm = &cpi->common;
+  ClpfSearch s;
+  int c, j, k, l, sb_rows;
   int64_t best, sums[4][8];
   int width = plane != AOM_PLANE_Y ? rec->uv_crop_width : rec->y_crop_width;
   int height = plane != AOM_PLANE_Y ? rec->uv_crop_height : rec->y_crop_height;
@@ -300,12 +349,30 @@ void av1_clpf_test_frame(const YV12_BUFFER_CONFIG *rec,
 
   memset(sums, 0, sizeof(sums));
 
+  // Every filter block size is decided from the same square errors, so they
+  // are found first, a row of superblocks at a time.
+  s.cpi = cpi;
+  s.rec = rec;
+  s.org = org;
+  s.plane = plane;
+  s.cols = width >> bslog;
+  s.rows = height >> bslog;
+  CHECK_MEM_ERROR(cm, s.sse,
+                  aom_malloc(AOMMAX(s.cols * s.rows, 1) * sizeof(*s.sse)));
+  sb_rows = (s.rows + MAX_MIB_SIZE - 1) / MAX_MIB_SIZE;
+  if (cpi->oxcf.max_threads > 1 && sb_rows > 1) {
+    av1_enc_run_jobs(cpi, (AVxWorkerHook)clpf_detect_worker_hook, &s,
+                     sb_rows);
+  } else {
+    for (k = 0; k < sb_rows; k++) clpf_detect_sb_row(&s, k);
+  }
+
   if (plane != AOM_PLANE_Y)
     // Use a block size of MI_SIZE regardless of the subsampling.  This
     // This is accurate enough to determine the best strength and
     // we don't need to add SIMD optimisations for 4x4 blocks.
-    clpf_rdo(0, 0, rec, org, cm, bs, fb_size_log2, width >> bslog,
-             height >> bslog, sums, plane);
+    clpf_rdo(&s, 0, 0, bs, fb_size_log2, width >> bslog, height >> bslog,
+             sums);
   else
     for (k = 0; k < num_fb_ver; k++) {
       for (l = 0; l < num_fb_hor; l++) {
@@ -316,10 +383,11 @@ void av1_clpf_test_frame(const YV12_BUFFER_CONFIG *rec,
             AOMMIN(width, (l + 1) << fb_size_log2) & ((1 << fb_size_log2) - 1);
         h += !h << fb_size_log2;
         w += !w << fb_size_log2;
-        clpf_rdo(k << fb_size_log2, l << fb_size_log2, rec, org, cm, MI_SIZE,
-                 fb_size_log2, w >> bslog, h >> bslog, sums, plane);
+        clpf_rdo(&s, k << fb_size_log2, l << fb_size_log2, MI_SIZE,
+                 fb_size_log2, w >> bslog, h >> bslog, sums);
       }
     }
+  aom_free(s.sse);
 
   // For fb_size == 128 skip blocks are included in the result.
   if (plane == AOM_PLANE_Y) {
@@ -19,8 +19,13 @@ int av1_clpf_decision(int k, int l, const YV12_BUFFER_CONFIG *rec,
                       int block_size, int w, int h, unsigned int strength,
                       unsigned int fb_size_log2, int8_t *res);
 
+struct AV1_COMP;
+
+// Finds the best strength, and for luma the best filter block size, of the
+// plane. The square errors of the blocks are found on the encoder workers
+// when there are several threads.
 void av1_clpf_test_frame(const YV12_BUFFER_CONFIG *rec,
-                         const YV12_BUFFER_CONFIG *org, const AV1_COMMON *cm,
+                         const YV12_BUFFER_CONFIG *org, struct AV1_COMP *cpi,
                          int *best_strength, int *best_bs, int plane);
 
 #endif
@@ -14,51 +14,59 @@
 #include <memory.h>
 #include <math.h>
 
+#include "./av1_rtcd.h"
+#include "aom/aom_integer.h"
+#include "aom_dsp/aom_dsp_common.h"
 #include "av1/encoder/corner_match.h"
 
-#define MATCH_SZ 15
-#define MATCH_SZ_BY2 ((MATCH_SZ - 1) / 2)
-#define MATCH_SZ_SQ (MATCH_SZ * MATCH_SZ)
 #define SEARCH_SZ 9
 #define SEARCH_SZ_BY2 ((SEARCH_SZ - 1) / 2)
 
 #define THRESHOLD_NCC 0.80
 
-static double compute_variance(unsigned char *im, int stride, int x, int y,
-                               double *mean) {
-  double sum = 0.0;
-  double sumsq = 0.0;
-  double var;
+int av1_compute_cross_correlation_c(const unsigned char *im1, int stride1,
+                                    const unsigned char *im2, int stride2) {
+  int cross = 0;
   int i, j;
-  for (i = 0; i < MATCH_SZ; ++i)
-    for (j = 0; j < MATCH_SZ; ++j) {
-      sum += im[(i + y - MATCH_SZ_BY2) * stride + (j + x - MATCH_SZ_BY2)];
-      sumsq += im[(i + y - MATCH_SZ_BY2) * stride + (j + x - MATCH_SZ_BY2)] *
-               im[(i + y - MATCH_SZ_BY2) * stride + (j + x - MATCH_SZ_BY2)];
-    }
-  var = (sumsq * MATCH_SZ_SQ - sum * sum) / (MATCH_SZ_SQ * MATCH_SZ_SQ);
-  if (mean) *mean = sum / MATCH_SZ_SQ;
-  return var;
+  for (i = 0; i < MATCH_SZ; ++i) {
+    for (j = 0; j < MATCH_SZ; ++j) cross += im1[j] * im2[j];
+    im1 += stride1;
+    im2 += stride2;
+  }
+  return cross;
+}
+
+// Returns a pointer to the top-left pixel of the match window centered on
+// (x, y).
+static const unsigned char *window_origin(const unsigned char *im, int stride,
+                                          int x, int y) {
+  return im + (y - MATCH_SZ_BY2) * stride + (x - MATCH_SZ_BY2);
 }
 
-static double compute_cross_correlation(unsigned char *im1, int stride1, int x1,
-                                        int y1, unsigned char *im2, int stride2,
-                                        int x2, int y2) {
-  double sum1 = 0;
-  double sum2 = 0;
-  double cross = 0;
-  double corr;
+static void compute_window_stats(const unsigned char *im, int stride, int x,
+                                 int y, int *sum, int *sumsq) {
+  const unsigned char *win = window_origin(im, stride, x, y);
+  int s = 0;
   int i, j;
   for (i = 0; i < MATCH_SZ; ++i)
-    for (j = 0; j < MATCH_SZ; ++j) {
-      sum1 += im1[(i + y1 - MATCH_SZ_BY2) * stride1 + (j + x1 - MATCH_SZ_BY2)];
-      sum2 += im2[(i + y2 - MATCH_SZ_BY2) * stride2 + (j + x2 - MATCH_SZ_BY2)];
-      cross +=
-          im1[(i + y1 - MATCH_SZ_BY2) * stride1 + (j + x1 - MATCH_SZ_BY2)] *
-          im2[(i + y2 - MATCH_SZ_BY2) * stride2 + (j + x2 - MATCH_SZ_BY2)];
-    }
-  corr = (cross * MATCH_SZ_SQ - sum1 * sum2) / (MATCH_SZ_SQ * MATCH_SZ_SQ);
-  return corr;
+    for (j = 0; j < MATCH_SZ; ++j) s += win[i * stride + j];
+  *sum = s;
+  *sumsq = av1_compute_cross_correlation(win, stride, win, stride);
+}
+
+// The window sums are exact integers, so these produce the same values as
+// accumulating the window in double precision.
+static double window_norm(int sum, int sumsq) {
+  return (double)((int64_t)sumsq * MATCH_SZ_SQ - (int64_t)sum * sum) /
+         (MATCH_SZ_SQ * MATCH_SZ_SQ);
+}
+
+static double window_ncc(int cross, int sum1, double norm1, int sum2,
+                         double norm2) {
+  const double corr =
+      (double)((int64_t)cross * MATCH_SZ_SQ - (int64_t)sum1 * sum2) /
+      (MATCH_SZ_SQ * MATCH_SZ_SQ);
+  return corr / sqrt(norm1 * norm2);
 }
 
 static int is_eligible_point(double pointx, double pointy, int width,
@@ -67,9 +75,13 @@ static int is_eligible_point(double pointx, double pointy, int width,
           pointx + MATCH_SZ_BY2 < width && pointy + MATCH_SZ_BY2 < height);
 }
 
+static int get_match_thresh(int width, int height) {
+  return (width < height ? height : width) >> 4;
+}
+
 static int is_eligible_distance(double point1x, double point1y, double point2x,
                                 double point2y, int width, int height) {
-  const int thresh = (width < height ? height : width) >> 4;
+  const int thresh = get_match_thresh(width, height);
   return ((point1x - point2x) * (point1x - point2x) +
           (point1y - point2y) * (point1y - point2y)) <= thresh * thresh;
 }
@@ -81,32 +93,29 @@ static void improve_correspondence(unsigned char *frm, unsigned char *ref,
                                    int num_correspondences) {
   int i;
   for (i = 0; i < num_correspondences; ++i) {
-    double template_norm =
-        compute_variance(frm, frm_stride, (int)correspondences[i].x,
-                         (int)correspondences[i].y, NULL);
+    const int tx = (int)correspondences[i].x, ty = (int)correspondences[i].y;
+    const unsigned char *tmpl = window_origin(frm, frm_stride, tx, ty);
+    int template_sum, template_sumsq;
+    double template_norm;
     int x, y, best_x = 0, best_y = 0;
     double best_match_ncc = 0.0;
+    compute_window_stats(frm, frm_stride, tx, ty, &template_sum,
+                         &template_sumsq);
+    template_norm = window_norm(template_sum, template_sumsq);
     for (y = -SEARCH_SZ_BY2; y <= SEARCH_SZ_BY2; ++y) {
       for (x = -SEARCH_SZ_BY2; x <= SEARCH_SZ_BY2; ++x) {
+        const int sx = (int)correspondences[i].rx + x;
+        const int sy = (int)correspondences[i].ry + y;
+        int sum, sumsq, cross;
         double match_ncc;
-        double subimage_norm;
-        if (!is_eligible_point((int)correspondences[i].rx + x,
-                               (int)correspondences[i].ry + y, width, height))
-          continue;
-        if (!is_eligible_distance(
-                (int)correspondences[i].x, (int)correspondences[i].y,
-                (int)correspondences[i].rx + x, (int)correspondences[i].ry + y,
-                width, height))
-          continue;
-        subimage_norm =
-            compute_variance(ref, ref_stride, (int)correspondences[i].rx + x,
-                             (int)correspondences[i].ry + y, NULL);
-        match_ncc = compute_cross_correlation(
-                        frm, frm_stride, (int)correspondences[i].x,
-                        (int)correspondences[i].y, ref, ref_stride,
-                        (int)correspondences[i].rx + x,
-                        (int)correspondences[i].ry + y) /
-                    sqrt(template_norm * subimage_norm);
+        if (!is_eligible_point(sx, sy, width, height)) continue;
+        if (!is_eligible_distance(tx, ty, sx, sy, width, height)) continue;
+        compute_window_stats(ref, ref_stride, sx, sy, &sum, &sumsq);
+        cross = av1_compute_cross_correlation(
+            tmpl, frm_stride, window_origin(ref, ref_stride, sx, sy),
+            ref_stride);
+        match_ncc = window_ncc(cross, template_sum, template_norm, sum,
+                               window_norm(sum, sumsq));
         if (match_ncc > best_match_ncc) {
           best_match_ncc = match_ncc;
           best_y = y;
@@ -118,32 +127,29 @@ static void improve_correspondence(unsigned char *frm, unsigned char *ref,
     correspondences[i].ry += (double)best_y;
   }
   for (i = 0; i < num_correspondences; ++i) {
-    double template_norm =
-        compute_variance(ref, ref_stride, (int)correspondences[i].rx,
-                         (int)correspondences[i].ry, NULL);
+    const int tx = (int)correspondences[i].rx, ty = (int)correspondences[i].ry;
+    const unsigned char *tmpl = window_origin(ref, ref_stride, tx, ty);
+    int template_sum, template_sumsq;
+    double template_norm;
     int x, y, best_x = 0, best_y = 0;
     double best_match_ncc = 0.0;
+    compute_window_stats(ref, ref_stride, tx, ty, &template_sum,
+                         &template_sumsq);
+    template_norm = window_norm(template_sum, template_sumsq);
     for (y = -SEARCH_SZ_BY2; y <= SEARCH_SZ_BY2; ++y)
       for (x = -SEARCH_SZ_BY2; x <= SEARCH_SZ_BY2; ++x) {
+        const int sx = (int)correspondences[i].x + x;
+        const int sy = (int)correspondences[i].y + y;
+        int sum, sumsq, cross;
         double match_ncc;
-        double subimage_norm;
-        if (!is_eligible_point((int)correspondences[i].x + x,
-                               (int)correspondences[i].y + y, width, height))
-          continue;
-        if (!is_eligible_distance((int)correspondences[i].x + x,
-                                  (int)correspondences[i].y + y,
-                                  (int)correspondences[i].rx,
-                                  (int)correspondences[i].ry, width, height))
-          continue;
-        subimage_norm =
-            compute_variance(frm, frm_stride, (int)correspondences[i].x + x,
-                             (int)correspondences[i].y + y, NULL);
-        match_ncc =
-            compute_cross_correlation(
-                frm, frm_stride, (int)correspondences[i].x + x,
-                (int)correspondences[i].y + y, ref, ref_stride,
-                (int)correspondences[i].rx, (int)correspondences[i].ry) /
-            sqrt(template_norm * subimage_norm);
+        if (!is_eligible_point(sx, sy, width, height)) continue;
+        if (!is_eligible_distance(sx, sy, tx, ty, width, height)) continue;
+        compute_window_stats(frm, frm_stride, sx, sy, &sum, &sumsq);
+        cross = av1_compute_cross_correlation(
+            window_origin(frm, frm_stride, sx, sy), frm_stride, tmpl,
+            ref_stride);
+        match_ncc = window_ncc(cross, sum, window_norm(sum, sumsq),
+                               template_sum, template_norm);
         if (match_ncc > best_match_ncc) {
           best_match_ncc = match_ncc;
           best_y = y;
@@ -155,49 +161,136 @@ static void improve_correspondence(unsigned char *frm, unsigned char *ref,
   }
 }
 
+void compute_corner_stats(unsigned char *im, int stride, int *corners,
+                          int num_corners, int width, int height, int *stats) {
+  int i;
+  for (i = 0; i < num_corners; ++i) {
+    const int x = corners[2 * i], y = corners[2 * i + 1];
+    if (is_eligible_point(x, y, width, height))
+      compute_window_stats(im, stride, x, y, &stats[2 * i], &stats[2 * i + 1]);
+    else
+      stats[2 * i] = stats[2 * i + 1] = 0;
+  }
+}
+
+// Buckets the reference corners that can be matched into square cells of the
+// match distance threshold, so that only the 3x3 cells around a frame corner
+// need to be visited to find every reference corner in range of it.
+typedef struct {
+  int cell_size;
+  int cols, rows;
+  int *cell_start;  // cols * rows + 1 offsets into corner_idx
+  int *corner_idx;
+} CornerGrid;
+
+static int build_corner_grid(CornerGrid *grid, const int *corners,
+                             int num_corners, int width, int height) {
+  const int cell_size = AOMMAX(get_match_thresh(width, height), 1);
+  const int cols = (width + cell_size - 1) / cell_size;
+  const int rows = (height + cell_size - 1) / cell_size;
+  int *cell_of;
+  int i;
+  grid->cell_size = cell_size;
+  grid->cols = cols;
+  grid->rows = rows;
+  grid->cell_start =
+      (int *)calloc(cols * rows + 1, sizeof(*grid->cell_start));
+  grid->corner_idx = (int *)malloc(AOMMAX(num_corners, 1) *
+                                   sizeof(*grid->corner_idx));
+  cell_of = (int *)malloc(AOMMAX(num_corners, 1) * sizeof(*cell_of));
+  if (!grid->cell_start || !grid->corner_idx || !cell_of) {
+    free(grid->cell_start);
+    free(grid->corner_idx);
+    free(cell_of);
+    return 0;
+  }
+  // Counting sort of the corners by cell; corners keep their original order
+  // within a cell.
+  for (i = 0; i < num_corners; ++i) {
+    const int x = corners[2 * i], y = corners[2 * i + 1];
+    if (!is_eligible_point(x, y, width, height)) {
+      cell_of[i] = -1;
+      continue;
+    }
+    cell_of[i] = (y / cell_size) * cols + x / cell_size;
+    grid->cell_start[cell_of[i] + 1]++;
+  }
+  for (i = 0; i < cols * rows; ++i)
+    grid->cell_start[i + 1] += grid->cell_start[i];
+  for (i = 0; i < num_corners; ++i) {
+    if (cell_of[i] < 0) continue;
+    grid->corner_idx[grid->cell_start[cell_of[i]]++] = i;
+  }
+  // The fill pass advanced each start to the end of its cell; shift back.
+  for (i = cols * rows; i > 0; --i)
+    grid->cell_start[i] = grid->cell_start[i - 1];
+  grid->cell_start[0] = 0;
+  free(cell_of);
+  return 1;
+}
+
+static void free_corner_grid(CornerGrid *grid) {
+  free(grid->cell_start);
+  free(grid->corner_idx);
+}
+
 int determine_correspondence(unsigned char *frm, int *frm_corners,
-                             int num_frm_corners, unsigned char *ref,
-                             int *ref_corners, int num_ref_corners, int width,
+                             int *frm_stats, int num_frm_corners,
+                             unsigned char *ref, int *ref_corners,
+                             int *ref_stats, int num_ref_corners, int width,
                              int height, int frm_stride, int ref_stride,
                              double *correspondence_pts) {
   // TODO(sarahparker) Improve this to include 2-way match
-  int i, j;
+  int i;
   Correspondence *correspondences = (Correspondence *)correspondence_pts;
   int num_correspondences = 0;
+  CornerGrid grid;
+  if (!build_corner_grid(&grid, ref_corners, num_ref_corners, width, height))
+    return 0;
   for (i = 0; i < num_frm_corners; ++i) {
+    const int fx = frm_corners[2 * i], fy = frm_corners[2 * i + 1];
+    const unsigned char *tmpl;
     double best_match_ncc = 0.0;
     double template_norm;
     int best_match_j = -1;
-    if (!is_eligible_point(frm_corners[2 * i], frm_corners[2 * i + 1], width,
-                           height))
-      continue;
-    template_norm = compute_variance(frm, frm_stride, frm_corners[2 * i],
-                                     frm_corners[2 * i + 1], NULL);
-    for (j = 0; j < num_ref_corners; ++j) {
-      double match_ncc;
-      double subimage_norm;
-      if (!is_eligible_point(ref_corners[2 * j], ref_corners[2 * j + 1], width,
-                             height))
-        continue;
-      if (!is_eligible_distance(frm_corners[2 * i], frm_corners[2 * i + 1],
-                                ref_corners[2 * j], ref_corners[2 * j + 1],
-                                width, height))
-        continue;
-      subimage_norm = compute_variance(ref, ref_stride, ref_corners[2 * j],
-                                       ref_corners[2 * j + 1], NULL);
-      match_ncc = compute_cross_correlation(frm, frm_stride, frm_corners[2 * i],
-                                            frm_corners[2 * i + 1], ref,
-                                            ref_stride, ref_corners[2 * j],
-                                            ref_corners[2 * j + 1]) /
-                  sqrt(template_norm * subimage_norm);
-      if (match_ncc > best_match_ncc) {
-        best_match_ncc = match_ncc;
-        best_match_j = j;
+    int cx, cy, row, col;
+    if (!is_eligible_point(fx, fy, width, height)) continue;
+    tmpl = window_origin(frm, frm_stride, fx, fy);
+    template_norm = window_norm(frm_stats[2 * i], frm_stats[2 * i + 1]);
+    cx = fx / grid.cell_size;
+    cy = fy / grid.cell_size;
+    for (row = AOMMAX(cy - 1, 0); row <= AOMMIN(cy + 1, grid.rows - 1);
+         ++row) {
+      for (col = AOMMAX(cx - 1, 0); col <= AOMMIN(cx + 1, grid.cols - 1);
+           ++col) {
+        const int cell = row * grid.cols + col;
+        int k;
+        for (k = grid.cell_start[cell]; k < grid.cell_start[cell + 1]; ++k) {
+          const int j = grid.corner_idx[k];
+          const int rx = ref_corners[2 * j], ry = ref_corners[2 * j + 1];
+          double match_ncc;
+          int cross;
+          if (!is_eligible_distance(fx, fy, rx, ry, width, height)) continue;
+          cross = av1_compute_cross_correlation(
+              tmpl, frm_stride, window_origin(ref, ref_stride, rx, ry),
+              ref_stride);
+          match_ncc =
+              window_ncc(cross, frm_stats[2 * i], template_norm,
+                         ref_stats[2 * j],
+                         window_norm(ref_stats[2 * j], ref_stats[2 * j + 1]));
+          // Cells are not visited in corner order, so break ties towards the
+          // lowest index to pick the same match as a linear scan.
+          if (match_ncc > best_match_ncc ||
+              (match_ncc == best_match_ncc && j < best_match_j)) {
+            best_match_ncc = match_ncc;
+            best_match_j = j;
+          }
+        }
       }
     }
     if (best_match_ncc > THRESHOLD_NCC) {
-      correspondences[num_correspondences].x = (double)frm_corners[2 * i];
-      correspondences[num_correspondences].y = (double)frm_corners[2 * i + 1];
+      correspondences[num_correspondences].x = (double)fx;
+      correspondences[num_correspondences].y = (double)fy;
       correspondences[num_correspondences].rx =
           (double)ref_corners[2 * best_match_j];
       correspondences[num_correspondences].ry =
@@ -205,6 +298,7 @@ int determine_correspondence(unsigned char *frm, int *frm_corners,
       num_correspondences++;
     }
   }
+  free_corner_grid(&grid);
   improve_correspondence(frm, ref, width, height, frm_stride, ref_stride,
                          correspondences, num_correspondences);
   return num_correspondences;
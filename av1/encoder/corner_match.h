@@ -15,14 +15,25 @@
 #include <stdlib.h>
 #include <memory.h>
 
+#define MATCH_SZ 15
+#define MATCH_SZ_BY2 ((MATCH_SZ - 1) / 2)
+#define MATCH_SZ_SQ (MATCH_SZ * MATCH_SZ)
+
 typedef struct {
   double x, y;
   double rx, ry;
 } Correspondence;
 
+// Computes the pixel sum and sum of squares of the match window around each
+// corner, stored as pairs in stats. Corners too close to the frame edge to be
+// matched get zero sums.
+void compute_corner_stats(unsigned char *im, int stride, int *corners,
+                          int num_corners, int width, int height, int *stats);
+
 int determine_correspondence(unsigned char *frm, int *frm_corners,
-                             int num_frm_corners, unsigned char *ref,
-                             int *ref_corners, int num_ref_corners, int width,
+                             int *frm_stats, int num_frm_corners,
+                             unsigned char *ref, int *ref_corners,
+                             int *ref_stats, int num_ref_corners, int width,
                              int height, int frm_stride, int ref_stride,
                              double *correspondence_pts);
 
@@ -1006,10 +1006,18 @@ static void update_filter_type_count(FRAME_COUNTS *counts,
 #endif
 #if CONFIG_GLOBAL_MOTION
 static void update_global_motion_used(PREDICTION_MODE mode,
-                                      const MB_MODE_INFO *mbmi, AV1_COMP *cpi) {
+                                      const MB_MODE_INFO *mbmi,
+                                      ThreadData *td) {
   if (mode == ZEROMV) {
-    ++cpi->global_motion_used[mbmi->ref_frame[0]];
-    if (has_second_ref(mbmi)) ++cpi->global_motion_used[mbmi->ref_frame[1]];
+    int *const used = td->rd_counts.global_motion_used;
+    int *const running = td->mb.global_motion_used;
+    int ref;
+    for (ref = 0; ref < 1 + has_second_ref(mbmi); ++ref) {
+      ++used[mbmi->ref_frame[ref]];
+      // Each tile, or superblock row with row based multi-threading, keeps
+      // its own running count on top of the frame totals.
+      ++running[mbmi->ref_frame[ref]];
+    }
   }
 }
 #endif  // CONFIG_GLOBAL_MOTION
@@ -1164,9 +1172,7 @@ static void update_state(const AV1_COMP *const cpi, ThreadData *td,
       av1_update_mv_count(td);
 #if CONFIG_GLOBAL_MOTION
       if (bsize >= BLOCK_8X8) {
-        // TODO(sarahparker): global motion stats need to be handled per-tile
-        // to be compatible with tile-based threading.
-        update_global_motion_used(mbmi->mode, mbmi, (AV1_COMP *)cpi);
+        update_global_motion_used(mbmi->mode, mbmi, td);
       } else {
         const int num_4x4_w = num_4x4_blocks_wide_lookup[bsize];
         const int num_4x4_h = num_4x4_blocks_high_lookup[bsize];
@@ -1174,8 +1180,7 @@ static void update_state(const AV1_COMP *const cpi, ThreadData *td,
         for (idy = 0; idy < 2; idy += num_4x4_h) {
           for (idx = 0; idx < 2; idx += num_4x4_w) {
             const int j = idy * 2 + idx;
-            update_global_motion_used(mi->bmi[j].as_mode, mbmi,
-                                      (AV1_COMP *)cpi);
+            update_global_motion_used(mi->bmi[j].as_mode, mbmi, td);
           }
         }
       }
@@ -1336,9 +1341,7 @@ static void update_state_supertx(const AV1_COMP *const cpi, ThreadData *td,
 #if CONFIG_GLOBAL_MOTION
     if (is_inter_block(mbmi)) {
       if (bsize >= BLOCK_8X8) {
-        // TODO(sarahparker): global motion stats need to be handled per-tile
-        // to be compatible with tile-based threading.
-        update_global_motion_used(mbmi->mode, mbmi, (AV1_COMP *)cpi);
+        update_global_motion_used(mbmi->mode, mbmi, td);
       } else {
         const int num_4x4_w = num_4x4_blocks_wide_lookup[bsize];
         const int num_4x4_h = num_4x4_blocks_high_lookup[bsize];
@@ -1346,8 +1349,7 @@ static void update_state_supertx(const AV1_COMP *const cpi, ThreadData *td,
         for (idy = 0; idy < 2; idy += num_4x4_h) {
           for (idx = 0; idx < 2; idx += num_4x4_w) {
             const int j = idy * 2 + idx;
-            update_global_motion_used(mi->bmi[j].as_mode, mbmi,
-                                      (AV1_COMP *)cpi);
+            update_global_motion_used(mi->bmi[j].as_mode, mbmi, td);
           }
         }
       }
@@ -4288,14 +4290,31 @@ static void rd_pick_partition(const AV1_COMP *const cpi, ThreadData *td,
   }
 }
 
+// Copies the state that adapts as the superblocks of a tile are encoded.
+static void copy_tile_state(TileDataEnc *dst, const TileDataEnc *src) {
+  memcpy(dst->thresh_freq_fact, src->thresh_freq_fact,
+         sizeof(dst->thresh_freq_fact));
+  memcpy(dst->mode_map, src->mode_map, sizeof(dst->mode_map));
+  dst->m_search_count = src->m_search_count;
+  dst->ex_search_count = src->ex_search_count;
+#if CONFIG_GLOBAL_MOTION
+  memcpy(dst->global_motion_used, src->global_motion_used,
+         sizeof(dst->global_motion_used));
+#endif  // CONFIG_GLOBAL_MOTION
+}
+
 static void encode_rd_sb_row(AV1_COMP *cpi, ThreadData *td,
                              TileDataEnc *tile_data, int mi_row,
-                             TOKENEXTRA **tp) {
+                             TOKENEXTRA **tp, AV1RowMTSync *row_mt_sync) {
   AV1_COMMON *const cm = &cpi->common;
   const TileInfo *const tile_info = &tile_data->tile_info;
   MACROBLOCK *const x = &td->mb;
   MACROBLOCKD *const xd = &x->e_mbd;
   SPEED_FEATURES *const sf = &cpi->sf;
+  const int sb_row = (mi_row - tile_info->mi_row_start) >> cm->mib_size_log2;
+  const int sb_cols =
+      (tile_info->mi_col_end - tile_info->mi_col_start + cm->mib_size - 1) >>
+      cm->mib_size_log2;
   int mi_col;
 #if CONFIG_EXT_PARTITION
   const int leaf_nodes = 256;
@@ -4328,6 +4347,9 @@ static void encode_rd_sb_row(AV1_COMP *cpi, ThreadData *td,
     const int idx_str = cm->mi_stride * mi_row + mi_col;
     MODE_INFO **mi = cm->mi_grid_visible + idx_str;
     PC_TREE *const pc_root = td->pc_root[cm->mib_size_log2 - MIN_MIB_SIZE_LOG2];
+    const int sb_col = (mi_col - tile_info->mi_col_start) >> cm->mib_size_log2;
+
+    if (row_mt_sync) av1_row_mt_sync_read(row_mt_sync, sb_row, sb_col);
 
     if (sf->adaptive_pred_interp_filter) {
       for (i = 0; i < leaf_nodes; ++i)
@@ -4421,6 +4443,14 @@ static void encode_rd_sb_row(AV1_COMP *cpi, ThreadData *td,
 #endif  // CONFIG_SUPERTX
                         INT64_MAX, pc_root);
     }
+
+    if (row_mt_sync) {
+      // The row below starts out from the state of this one after its second
+      // superblock, which is as far as it lags behind.
+      if (sb_row + 1 < row_mt_sync->rows && sb_col == AOMMIN(1, sb_cols - 1))
+        copy_tile_state(tile_data + 1, tile_data);
+      av1_row_mt_sync_write(row_mt_sync, sb_row, sb_col, sb_cols);
+    }
   }
 #if CONFIG_ENTROPY
   if (cm->do_subframe_update &&
@@ -4446,6 +4476,8 @@ static void encode_rd_sb_row(AV1_COMP *cpi, ThreadData *td,
       av1_copy(subframe_stats->eob_counts_buf[cm->coef_probs_update_idx],
                cm->counts.eob_branch);
       av1_fill_token_costs(x->token_costs, cm->fc->coef_probs);
+      // The cached rates were found with the old token costs.
+      if (x->txfm_rd_cache) av1_reset_txfm_rd_cache(x->txfm_rd_cache);
     }
   }
 #endif  // CONFIG_ENTROPY
@@ -4530,8 +4562,11 @@ void av1_init_tile_data(AV1_COMP *cpi) {
   unsigned int tile_tok = 0;
 
   if (cpi->tile_data == NULL || cpi->allocated_tiles < tile_cols * tile_rows) {
-    if (cpi->tile_data != NULL) aom_free(cpi->tile_data);
-    CHECK_MEM_ERROR(cm, cpi->tile_data, aom_malloc(tile_cols * tile_rows *
+    if (cpi->tile_data != NULL) {
+      av1_row_mt_mem_dealloc(cpi);
+      aom_free(cpi->tile_data);
+    }
+    CHECK_MEM_ERROR(cm, cpi->tile_data, aom_calloc(tile_cols * tile_rows,
                                                    sizeof(*cpi->tile_data)));
     cpi->allocated_tiles = tile_cols * tile_rows;
 
@@ -4573,6 +4608,17 @@ void av1_init_tile_data(AV1_COMP *cpi) {
   }
 }
 
+// Points the mode search of td at its transform RD cache, emptied, unless the
+// cache is disabled.
+static void init_txfm_rd_cache(const AV1_COMP *cpi, ThreadData *td) {
+  if (cpi->oxcf.txfm_rd_cache) {
+    td->mb.txfm_rd_cache = &td->txfm_rd_cache;
+    av1_reset_txfm_rd_cache(td->mb.txfm_rd_cache);
+  } else {
+    td->mb.txfm_rd_cache = NULL;
+  }
+}
+
 void av1_encode_tile(AV1_COMP *cpi, ThreadData *td, int tile_row,
                      int tile_col) {
   AV1_COMMON *const cm = &cpi->common;
@@ -4592,6 +4638,12 @@ void av1_encode_tile(AV1_COMP *cpi, ThreadData *td, int tile_row,
   this_tile->ex_search_count = 0;  // Exhaustive mesh search hits.
   td->mb.m_search_count_ptr = &this_tile->m_search_count;
   td->mb.ex_search_count_ptr = &this_tile->ex_search_count;
+#if CONFIG_GLOBAL_MOTION
+  // The count must not depend on the other tiles the worker has encoded.
+  av1_zero(this_tile->global_motion_used);
+  td->mb.global_motion_used = this_tile->global_motion_used;
+#endif  // CONFIG_GLOBAL_MOTION
+  init_txfm_rd_cache(cpi, td);
 
 #if CONFIG_PVQ
   td->mb.pvq_q = &this_tile->pvq_q;
@@ -4624,7 +4676,7 @@ void av1_encode_tile(AV1_COMP *cpi, ThreadData *td, int tile_row,
 
   for (mi_row = tile_info->mi_row_start; mi_row < tile_info->mi_row_end;
        mi_row += cm->mib_size) {
-    encode_rd_sb_row(cpi, td, this_tile, mi_row, &tok);
+    encode_rd_sb_row(cpi, td, this_tile, mi_row, &tok, NULL);
   }
 
   cpi->tok_count[tile_row][tile_col] =
@@ -4642,6 +4694,57 @@ void av1_encode_tile(AV1_COMP *cpi, ThreadData *td, int tile_row,
 #endif
 }
 
+void av1_encode_sb_row(AV1_COMP *cpi, ThreadData *td, int tile_row,
+                       int tile_col, int mi_row) {
+  AV1_COMMON *const cm = &cpi->common;
+  TileDataEnc *const this_tile =
+      &cpi->tile_data[tile_row * cm->tile_cols + tile_col];
+  const TileInfo *const tile_info = &this_tile->tile_info;
+  const int sb_row = (mi_row - tile_info->mi_row_start) >> cm->mib_size_log2;
+  TileDataEnc *const row_data = &this_tile->row_data[sb_row];
+  const int tile_mb_cols =
+      (tile_info->mi_col_end - tile_info->mi_col_start + 1) >> 1;
+  // Each row gets its own part of the tile's token buffer, in proportion to
+  // its size, and av1_encode_tiles_row_mt() packs them back together.
+  TOKENEXTRA *const tok_start =
+      cpi->tile_tok[tile_row][tile_col] +
+      get_token_alloc((mi_row - tile_info->mi_row_start) >> 1, tile_mb_cols);
+  TOKENEXTRA *tok = tok_start;
+
+  if (sb_row == 0) {
+    av1_zero_above_context(cm, tile_info->mi_col_start, tile_info->mi_col_end);
+    copy_tile_state(row_data, this_tile);
+    row_data->m_search_count = 0;
+    row_data->ex_search_count = 0;
+#if CONFIG_GLOBAL_MOTION
+    av1_zero(row_data->global_motion_used);
+#endif  // CONFIG_GLOBAL_MOTION
+  }
+  // Otherwise the row above has set up row_data before letting this row
+  // start.
+  row_data->tile_info = *tile_info;
+
+  td->mb.m_search_count_ptr = &row_data->m_search_count;
+  td->mb.ex_search_count_ptr = &row_data->ex_search_count;
+#if CONFIG_GLOBAL_MOTION
+  td->mb.global_motion_used = row_data->global_motion_used;
+#endif  // CONFIG_GLOBAL_MOTION
+  // The worker may come from a row of another tile or frame.
+  init_txfm_rd_cache(cpi, td);
+
+  encode_rd_sb_row(cpi, td, row_data, mi_row, &tok, &this_tile->row_mt_sync);
+
+  this_tile->row_tok_count[sb_row] = (unsigned int)(tok - tok_start);
+  assert(this_tile->row_tok_count[sb_row] <=
+         get_token_alloc((AOMMIN(mi_row + cm->mib_size, tile_info->mi_row_end) -
+                          mi_row + 1) >> 1,
+                         tile_mb_cols));
+
+  // The next frame carries on from the state of the last row.
+  if (sb_row == this_tile->row_mt_sync.rows - 1)
+    copy_tile_state(this_tile, row_data);
+}
+
 static void encode_tiles(AV1_COMP *cpi) {
   AV1_COMMON *const cm = &cpi->common;
   int tile_col, tile_row;
@@ -4764,35 +4867,219 @@ static void force_wmtype(WarpedMotionParams *wm, TransformationType wmtype) {
   wm->wmtype = wmtype;
 }
 
-static double refine_integerized_param(WarpedMotionParams *wm,
-                                       TransformationType wmtype,
+// Number of pixel rows in each of the blocks the warp error of a frame is
+// split into, to be measured in parallel.
+#define GM_BLOCK_ROWS 32
+
+// Most RANSAC trials drawn for a reference in each round of the search. A
+// few trials per thread keep the workers busy when the references are few.
+#define GM_RANSAC_MAX_BATCH 16
+
+// State of the global motion search of a frame, shared by the encoder
+// workers running its jobs.
+typedef struct GlobalMotionSearch {
+  AV1_COMP *cpi;
+  void (*run_job)(struct GlobalMotionSearch *s, int job);
 #if CONFIG_AOM_HIGHBITDEPTH
-                                       int use_hbd, int bd,
+  int use_hbd;
+  int bd;
 #endif  // CONFIG_AOM_HIGHBITDEPTH
-                                       uint8_t *ref, int r_width, int r_height,
-                                       int r_stride, uint8_t *dst, int d_width,
-                                       int d_height, int d_stride,
-                                       int n_refinements) {
+  // The frames whose features are matched: the source and each distinct
+  // reference buffer.
+  YV12_BUFFER_CONFIG *frames[TOTAL_REFS_PER_FRAME];
+  int num_frames;
+  // The references searched, and the model found for each of them.
+  int refs[TOTAL_REFS_PER_FRAME];
+  YV12_BUFFER_CONFIG *ref_bufs[TOTAL_REFS_PER_FRAME];
+  int num_refs;
+  int found[TOTAL_REFS_PER_FRAME];
+  double params[TOTAL_REFS_PER_FRAME][8];
+  // The RANSAC fit of each model, and the fit and index of each trial of
+  // the current round.
+  RansacFit *fits[TOTAL_REFS_PER_FRAME];
+  int ransac_batch;
+  int trial_ref[TOTAL_REFS_PER_FRAME * GM_RANSAC_MAX_BATCH];
+  int trial[TOTAL_REFS_PER_FRAME * GM_RANSAC_MAX_BATCH];
+  // The model whose warp error is being measured, and the error of each
+  // block of the frame.
+  WarpedMotionParams *wm;
+  const YV12_BUFFER_CONFIG *ref;
+  int num_blocks;
+  int64_t *block_err;
+  // The measure stops once the error of the frame reaches err_limit. Run
+  // serially, each block is given what is left after the blocks before it,
+  // and the blocks after the limit is reached are skipped. In parallel, the
+  // blocks are measured independently, each against the whole limit, so
+  // that the jobs share nothing they write.
+  int parallel;
+  int64_t err_limit;
+  int64_t err_used;
+} GlobalMotionSearch;
+
+static int gm_worker_hook(EncWorkerData *const thread_data,
+                          GlobalMotionSearch *s) {
+  int job;
+  while ((job = aom_job_queue_pop(&thread_data->cpi->enc_job_queue,
+                                  thread_data->thread_id)) >= 0) {
+    aom_clear_system_state();
+    s->run_job(s, job);
+  }
+  aom_clear_system_state();
+  return 1;
+}
+
+// Runs jobs 0 to |num_jobs| - 1 of a stage of the search, on the encoder
+// workers if there are several threads.
+static void gm_run_jobs(GlobalMotionSearch *s,
+                        void (*run_job)(GlobalMotionSearch *s, int job),
+                        int num_jobs) {
+  int job;
+  s->parallel = s->cpi->oxcf.max_threads > 1 && num_jobs > 1;
+  if (s->parallel) {
+    s->run_job = run_job;
+    av1_enc_run_jobs(s->cpi, (AVxWorkerHook)gm_worker_hook, s, num_jobs);
+  } else {
+    for (job = 0; job < num_jobs; ++job) run_job(s, job);
+  }
+}
+
+static void gm_frame_features_job(GlobalMotionSearch *s, int job) {
+  compute_frame_features(s->frames[job], s->cpi->common.bit_depth);
+}
+
+static void gm_ref_match_job(GlobalMotionSearch *s, int job) {
+  // The features of the frames were found in the previous stage, so none
+  // of the shared frames is written here.
+  s->fits[job] = global_motion_fit_alloc(
+      GLOBAL_TRANS_TYPES - 1, s->cpi->Source, s->ref_bufs[job],
+      s->cpi->common.bit_depth, s->ransac_batch);
+}
+
+static void gm_ransac_trial_job(GlobalMotionSearch *s, int job) {
+  ransac_fit_score(s->fits[s->trial_ref[job]], s->trial[job]);
+}
+
+// Fits the models of all the references with RANSAC. In each round, a
+// batch of trials is drawn for every fit still running, and the trials of
+// all the fits are scored together.
+static void gm_ransac(GlobalMotionSearch *s) {
+  int i, t, num_jobs;
+  do {
+    num_jobs = 0;
+    for (i = 0; i < s->num_refs; ++i) {
+      const int n = s->fits[i] ? ransac_fit_next_batch(s->fits[i]) : 0;
+      for (t = 0; t < n; ++t) {
+        s->trial_ref[num_jobs] = i;
+        s->trial[num_jobs++] = t;
+      }
+    }
+    gm_run_jobs(s, gm_ransac_trial_job, num_jobs);
+    for (i = 0; i < s->num_refs; ++i)
+      if (s->fits[i]) ransac_fit_update(s->fits[i]);
+  } while (num_jobs > 0);
+
+  for (i = 0; i < s->num_refs; ++i) {
+    double *const params = s->params[i];
+    for (t = 0; t < 8; ++t) params[t] = (t == 2 || t == 5) ? 1 : 0;
+    s->found[i] = s->fits[i] && global_motion_fit_finish(s->fits[i], params);
+    s->fits[i] = NULL;
+  }
+}
+
+static void gm_block_error_job(GlobalMotionSearch *s, int job) {
+  const YV12_BUFFER_CONFIG *const src = s->cpi->Source;
+  const YV12_BUFFER_CONFIG *const ref = s->ref;
   const int border = ERRORADV_BORDER;
+  const int row = border + job * GM_BLOCK_ROWS;
+  const int rows = AOMMIN(GM_BLOCK_ROWS, src->y_height - border - row);
+  uint8_t *const dst = src->y_buffer + row * src->y_stride + border;
+  int64_t limit = s->err_limit;
+  int64_t err;
+
+  if (!s->parallel) {
+    if (s->err_used >= s->err_limit) {
+      s->block_err[job] = 0;
+      return;
+    }
+    limit -= s->err_used;
+  }
+  err = av1_warp_error(s->wm,
+#if CONFIG_AOM_HIGHBITDEPTH
+                       s->use_hbd, s->bd,
+#endif  // CONFIG_AOM_HIGHBITDEPTH
+                       ref->y_buffer, ref->y_width, ref->y_height,
+                       ref->y_stride, dst, border, row,
+                       src->y_width - 2 * border, rows, src->y_stride, 0, 0,
+                       16, 16, limit);
+  s->block_err[job] = err;
+  if (!s->parallel) s->err_used += err;
+}
+
+static void gm_block_frame_error_job(GlobalMotionSearch *s, int job) {
+  const YV12_BUFFER_CONFIG *const src = s->cpi->Source;
+  const YV12_BUFFER_CONFIG *const ref = s->ref;
+  const int border = ERRORADV_BORDER;
+  const int row = border + job * GM_BLOCK_ROWS;
+  const int rows = AOMMIN(GM_BLOCK_ROWS, src->y_height - border - row);
+  uint8_t *const dst = src->y_buffer + row * src->y_stride + border;
+
+  s->block_err[job] = av1_frame_error(
+#if CONFIG_AOM_HIGHBITDEPTH
+      s->use_hbd, s->bd,
+#endif  // CONFIG_AOM_HIGHBITDEPTH
+      ref->y_buffer, ref->y_stride, dst, border, row,
+      src->y_width - 2 * border, rows, src->y_stride);
+}
+
+static int64_t gm_sum_block_errors(const GlobalMotionSearch *s) {
+  int64_t sum = 0;
+  int i;
+  for (i = 0; i < s->num_blocks; ++i) sum += s->block_err[i];
+  return sum;
+}
+
+// Returns the error of the source predicted from s->ref with |wm|. Once the
+// error reaches |best_err| the measure stops, and |best_err| is returned. The
+// frame is measured in blocks, which are summed exactly, so the result does
+// not depend on the threads.
+static int64_t gm_warp_error(GlobalMotionSearch *s, WarpedMotionParams *wm,
+                             int64_t best_err) {
+  int64_t err;
+  s->wm = wm;
+  s->err_limit = best_err;
+  s->err_used = 0;
+  gm_run_jobs(s, gm_block_error_job, s->num_blocks);
+  err = gm_sum_block_errors(s);
+  return err >= best_err ? best_err : err;
+}
+
+// Returns the error of the source predicted from s->ref without motion.
+static int64_t gm_frame_error(GlobalMotionSearch *s) {
+  gm_run_jobs(s, gm_block_frame_error_job, s->num_blocks);
+  return gm_sum_block_errors(s);
+}
+
+static double refine_integerized_param(GlobalMotionSearch *s,
+                                       WarpedMotionParams *wm,
+                                       TransformationType wmtype,
+                                       const YV12_BUFFER_CONFIG *ref,
+                                       int n_refinements) {
   int i = 0, p;
   int n_params = n_trans_model_params[wmtype];
   int32_t *param_mat = wm->wmmat;
-  double step_error;
+  int64_t step_error;
   int32_t step;
   int32_t *param;
   int32_t curr_param;
   int32_t best_param;
-  double best_error;
+  int64_t best_error;
+  double erroradvantage;
 
+  s->ref = ref;
   force_wmtype(wm, wmtype);
-  best_error = av1_warp_erroradv(wm,
-#if CONFIG_AOM_HIGHBITDEPTH
-                                 use_hbd, bd,
-#endif  // CONFIG_AOM_HIGHBITDEPTH
-                                 ref, r_width, r_height, r_stride,
-                                 dst + border * d_stride + border, border,
-                                 border, d_width - 2 * border,
-                                 d_height - 2 * border, d_stride, 0, 0, 16, 16);
+  // The steps are all compared to the same error without motion, so only
+  // the warp errors are needed until the end.
+  best_error = gm_warp_error(s, wm, INT64_MAX);
   step = 1 << (n_refinements + 1);
   for (i = 0; i < n_refinements; i++, step >>= 1) {
     for (p = 0; p < n_params; ++p) {
@@ -4802,14 +5089,7 @@ static double refine_integerized_param(WarpedMotionParams *wm,
       best_param = curr_param;
       // look to the left
       *param = add_param_offset(p, curr_param, -step);
-      step_error = av1_warp_erroradv(
-          wm,
-#if CONFIG_AOM_HIGHBITDEPTH
-          use_hbd, bd,
-#endif  // CONFIG_AOM_HIGHBITDEPTH
-          ref, r_width, r_height, r_stride, dst + border * d_stride + border,
-          border, border, d_width - 2 * border, d_height - 2 * border, d_stride,
-          0, 0, 16, 16);
+      step_error = gm_warp_error(s, wm, best_error);
       if (step_error < best_error) {
         best_error = step_error;
         best_param = *param;
@@ -4818,14 +5098,7 @@ static double refine_integerized_param(WarpedMotionParams *wm,
 
       // look to the right
       *param = add_param_offset(p, curr_param, step);
-      step_error = av1_warp_erroradv(
-          wm,
-#if CONFIG_AOM_HIGHBITDEPTH
-          use_hbd, bd,
-#endif  // CONFIG_AOM_HIGHBITDEPTH
-          ref, r_width, r_height, r_stride, dst + border * d_stride + border,
-          border, border, d_width - 2 * border, d_height - 2 * border, d_stride,
-          0, 0, 16, 16);
+      step_error = gm_warp_error(s, wm, best_error);
       if (step_error < best_error) {
         best_error = step_error;
         best_param = *param;
@@ -4837,14 +5110,7 @@ static double refine_integerized_param(WarpedMotionParams *wm,
       // for the biggest step size
       while (step_dir) {
         *param = add_param_offset(p, best_param, step * step_dir);
-        step_error = av1_warp_erroradv(
-            wm,
-#if CONFIG_AOM_HIGHBITDEPTH
-            use_hbd, bd,
-#endif  // CONFIG_AOM_HIGHBITDEPTH
-            ref, r_width, r_height, r_stride, dst + border * d_stride + border,
-            border, border, d_width - 2 * border, d_height - 2 * border,
-            d_stride, 0, 0, 16, 16);
+        step_error = gm_warp_error(s, wm, best_error);
         if (step_error < best_error) {
           best_error = step_error;
           best_param = *param;
@@ -4856,11 +5122,92 @@ static double refine_integerized_param(WarpedMotionParams *wm,
     }
   }
   force_wmtype(wm, wmtype);
+  erroradvantage =
+      (double)gm_warp_error(s, wm, INT64_MAX) / gm_frame_error(s);
   wm->wmtype = get_gmtype(wm);
-  return best_error;
+  return erroradvantage;
+}
+
+// Estimates the global motion of the source relative to each reference.
+// The features of the frames are found in parallel, then each reference is
+// matched in parallel, the RANSAC trials of all the references are scored
+// in parallel, and the models are refined one after another with the warp
+// error of each step measured over the blocks of the frame in parallel. The
+// models are the same as with a single thread.
+static void global_motion_search(AV1_COMP *cpi) {
+  AV1_COMMON *const cm = &cpi->common;
+  MACROBLOCKD *const xd = &cpi->td.mb.e_mbd;
+  GlobalMotionSearch s;
+  int frame, i, j;
+
+  memset(&s, 0, sizeof(s));
+  s.cpi = cpi;
+#if CONFIG_AOM_HIGHBITDEPTH
+  s.use_hbd = xd->cur_buf->flags & YV12_FLAG_HIGHBITDEPTH;
+  s.bd = xd->bd;
+#else
+  (void)xd;
+#endif  // CONFIG_AOM_HIGHBITDEPTH
+  s.frames[s.num_frames++] = cpi->Source;
+  for (frame = LAST_FRAME; frame <= ALTREF_FRAME; ++frame) {
+    YV12_BUFFER_CONFIG *const ref_buf = get_ref_frame_buffer(cpi, frame);
+    if (ref_buf == NULL) continue;
+    s.refs[s.num_refs] = frame;
+    s.ref_bufs[s.num_refs++] = ref_buf;
+    for (j = 0; j < s.num_frames; ++j)
+      if (s.frames[j] == ref_buf) break;
+    if (j == s.num_frames) s.frames[s.num_frames++] = ref_buf;
+  }
+  s.ransac_batch = cpi->oxcf.max_threads > 1
+                       ? AOMMIN(4 * cpi->oxcf.max_threads, GM_RANSAC_MAX_BATCH)
+                       : 1;
+  s.num_blocks =
+      (cpi->Source->y_height - 2 * ERRORADV_BORDER + GM_BLOCK_ROWS - 1) /
+      GM_BLOCK_ROWS;
+  CHECK_MEM_ERROR(cm, s.block_err,
+                  aom_malloc(s.num_blocks * sizeof(*s.block_err)));
+
+  gm_run_jobs(&s, gm_frame_features_job, s.num_frames);
+  gm_run_jobs(&s, gm_ref_match_job, s.num_refs);
+  gm_ransac(&s);
+
+  for (i = 0; i < s.num_refs; ++i) {
+    WarpedMotionParams *const gm = &cm->global_motion[s.refs[i]];
+    if (!s.found[i]) continue;
+    convert_model_to_params(s.params[i], gm);
+    if (gm->wmtype != IDENTITY) {
+      const double erroradvantage =
+          refine_integerized_param(&s, gm, gm->wmtype, s.ref_bufs[i], 3);
+      if (erroradvantage > gm_advantage_thresh[gm->wmtype]) {
+        set_default_gmparams(gm);
+      }
+    }
+  }
+  aom_clear_system_state();
+
+  aom_free(s.block_err);
 }
 #endif  // CONFIG_GLOBAL_MOTION
 
+// Makes the pyramids of the source and of the references for the motion
+// search before the tiles are encoded, so that the frames shared by the
+// tiles are not written during the search. If a pyramid cannot be made, the
+// frame is searched without them.
+static void build_motion_search_pyramids(AV1_COMP *cpi) {
+  const int levels = cpi->sf.mv.pyramid_search_levels;
+  const int bd = cpi->common.bit_depth;
+  int frame, ok;
+
+  ok = av1_build_frame_pyramid(cpi->Source, levels, bd);
+  for (frame = LAST_FRAME; ok && frame <= ALTREF_FRAME; ++frame) {
+    YV12_BUFFER_CONFIG *ref_buf = av1_get_scaled_ref_frame(cpi, frame);
+    if (ref_buf == NULL) ref_buf = get_ref_frame_buffer(cpi, frame);
+    if (ref_buf != NULL) ok = av1_build_frame_pyramid(ref_buf, levels, bd);
+  }
+  // The speed features are set again for each frame.
+  if (!ok) cpi->sf.mv.pyramid_search_levels = 0;
+}
+
 static void encode_frame_internal(AV1_COMP *cpi) {
   ThreadData *const td = &cpi->td;
   MACROBLOCK *const x = &td->mb;
@@ -4883,46 +5230,23 @@ static void encode_frame_internal(AV1_COMP *cpi) {
   av1_zero(rdc->comp_pred_diff);
 
 #if CONFIG_GLOBAL_MOTION
-  av1_zero(cpi->global_motion_used);
+  av1_zero(rdc->global_motion_used);
   if (cpi->common.frame_type == INTER_FRAME && cpi->Source &&
       !cpi->global_motion_search_done) {
-    YV12_BUFFER_CONFIG *ref_buf;
-    int frame;
-    double erroradvantage = 0;
-    double params[8] = { 0, 0, 1, 0, 0, 1, 0, 0 };
-    for (frame = LAST_FRAME; frame <= ALTREF_FRAME; ++frame) {
-      ref_buf = get_ref_frame_buffer(cpi, frame);
-      if (ref_buf) {
-        aom_clear_system_state();
-        if (compute_global_motion_feature_based(GLOBAL_TRANS_TYPES - 1,
-                                                cpi->Source, ref_buf,
-#if CONFIG_AOM_HIGHBITDEPTH
-                                                cpi->common.bit_depth,
-#endif  // CONFIG_AOM_HIGHBITDEPTH
-                                                params)) {
-          convert_model_to_params(params, &cm->global_motion[frame]);
-          if (cm->global_motion[frame].wmtype != IDENTITY) {
-            erroradvantage = refine_integerized_param(
-                &cm->global_motion[frame], cm->global_motion[frame].wmtype,
-#if CONFIG_AOM_HIGHBITDEPTH
-                xd->cur_buf->flags & YV12_FLAG_HIGHBITDEPTH, xd->bd,
-#endif  // CONFIG_AOM_HIGHBITDEPTH
-                ref_buf->y_buffer, ref_buf->y_width, ref_buf->y_height,
-                ref_buf->y_stride, cpi->Source->y_buffer, cpi->Source->y_width,
-                cpi->Source->y_height, cpi->Source->y_stride, 3);
-            if (erroradvantage >
-                gm_advantage_thresh[cm->global_motion[frame].wmtype]) {
-              set_default_gmparams(&cm->global_motion[frame]);
-            }
-          }
-        }
-        aom_clear_system_state();
-      }
-    }
+    struct aom_usec_timer gm_timer;
+    aom_usec_timer_start(&gm_timer);
+    aom_clear_system_state();
+    global_motion_search(cpi);
+    aom_usec_timer_mark(&gm_timer);
+    cpi->frame_time_global_motion = aom_usec_timer_elapsed(&gm_timer);
+    cpi->time_global_motion += cpi->frame_time_global_motion;
     cpi->global_motion_search_done = 1;
   }
 #endif  // CONFIG_GLOBAL_MOTION
 
+  if (cpi->sf.mv.pyramid_search_levels && !frame_is_intra_only(cm))
+    build_motion_search_pyramids(cpi);
+
   for (i = 0; i < MAX_SEGMENTS; ++i) {
     const int qindex = cm->seg.enabled
                            ? av1_get_qindex(&cm->seg, i, cm->base_qindex)
@@ -4994,11 +5318,12 @@ static void encode_frame_internal(AV1_COMP *cpi) {
     }
 #endif
 
-    // If allowed, encoding tiles in parallel with one thread handling one tile.
-    // TODO(geza.lore): The multi-threaded encoder is not safe with more than
-    // 1 tile rows, as it uses the single above_context et al arrays from
-    // cpi->common
-    if (AOMMIN(cpi->oxcf.max_threads, cm->tile_cols) > 1 && cm->tile_rows == 1)
+    // If allowed, encoding tiles in parallel with one thread handling one
+    // column of tiles, so that the tiles sharing an above context are still
+    // encoded in order.
+    if (cpi->oxcf.row_mt && av1_row_mt_supported(cpi))
+      av1_encode_tiles_row_mt(cpi);
+    else if (AOMMIN(cpi->oxcf.max_threads, cm->tile_cols) > 1)
       av1_encode_tiles_mt(cpi);
     else
       encode_tiles(cpi);
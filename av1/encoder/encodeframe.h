@@ -39,6 +39,10 @@ void av1_encode_frame(struct AV1_COMP *cpi);
 void av1_init_tile_data(struct AV1_COMP *cpi);
 void av1_encode_tile(struct AV1_COMP *cpi, struct ThreadData *td, int tile_row,
                      int tile_col);
+// Encodes one superblock row of a tile, synchronized with the rows above and
+// below it through the tile's row_mt_sync.
+void av1_encode_sb_row(struct AV1_COMP *cpi, struct ThreadData *td,
+                       int tile_row, int tile_col, int mi_row);
 
 void av1_set_variance_partition_thresholds(struct AV1_COMP *cpi, int q);
 
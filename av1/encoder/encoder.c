@@ -44,6 +44,9 @@
 #include "av1/encoder/ethread.h"
 #include "av1/encoder/firstpass.h"
 #include "av1/encoder/mbgraph.h"
+#if CONFIG_DERING
+#include "av1/encoder/pickdering.h"
+#endif  // CONFIG_DERING
 #include "av1/encoder/picklpf.h"
 #if CONFIG_LOOP_RESTORATION
 #include "av1/encoder/pickrst.h"
@@ -429,6 +432,7 @@ static void dealloc_compressor_data(AV1_COMP *cpi) {
       }
   }
 #endif
+  av1_row_mt_mem_dealloc(cpi);
   aom_free(cpi->tile_data);
   cpi->tile_data = NULL;
 
@@ -453,6 +457,7 @@ static void dealloc_compressor_data(AV1_COMP *cpi) {
 #if CONFIG_LOOP_RESTORATION
   aom_free_frame_buffer(&cpi->last_frame_db);
   av1_free_restoration_buffers(cm);
+  av1_free_rest_search_threads(cpi);
 #endif  // CONFIG_LOOP_RESTORATION
   aom_free_frame_buffer(&cpi->scaled_source);
   aom_free_frame_buffer(&cpi->scaled_last_source);
@@ -2469,6 +2474,16 @@ void av1_remove_compressor(AV1_COMP *cpi) {
                 rate_err, fabs(rate_err));
       }
 
+      // Time the encoder workers spent waiting for the others to finish.
+      for (t = 0; t < cpi->enc_job_queue.max_threads; ++t)
+        fprintf(f, "Thread %d idle: %8.0f ms\n", t,
+                cpi->enc_job_queue.idle_usec[t] / 1000.0);
+      fprintf(f, "Temporal filter: %8.0f ms\n",
+              cpi->time_temporal_filter / 1000.0);
+#if CONFIG_GLOBAL_MOTION
+      fprintf(f, "Global motion: %8.0f ms\n", cpi->time_global_motion / 1000.0);
+#endif  // CONFIG_GLOBAL_MOTION
+
       fclose(f);
     }
 
@@ -2507,8 +2522,14 @@ void av1_remove_compressor(AV1_COMP *cpi) {
   }
   aom_free(cpi->tile_thr_data);
   aom_free(cpi->workers);
+  aom_job_queue_dealloc(&cpi->enc_job_queue);
 
-  if (cpi->num_workers > 1) av1_loop_filter_dealloc(&cpi->lf_row_sync);
+  if (cpi->num_workers > 1) {
+    av1_loop_filter_dealloc(&cpi->lf_row_sync);
+#if CONFIG_LOOP_RESTORATION
+    av1_loop_restoration_dealloc(&cpi->lr_row_sync);
+#endif  // CONFIG_LOOP_RESTORATION
+  }
 
   dealloc_compressor_data(cpi);
 
@@ -2621,6 +2642,7 @@ int av1_set_reference_enc(AV1_COMP *cpi, AOM_REFFRAME ref_frame_flag,
   YV12_BUFFER_CONFIG *cfg = get_av1_ref_frame_buffer(cpi, ref_frame_flag);
   if (cfg) {
     aom_yv12_copy_frame(sd, cfg);
+    aom_invalidate_frame_buffer_cache(cfg);
     return 0;
   } else {
     return -1;
@@ -2887,12 +2909,12 @@ static int recode_loop_test_global_motion(AV1_COMP *cpi) {
   AV1_COMMON *const cm = &cpi->common;
   for (i = LAST_FRAME; i <= ALTREF_FRAME; ++i) {
     if (cm->global_motion[i].wmtype != IDENTITY &&
-        cpi->global_motion_used[i] < MIN_GLOBAL_MOTION_BLKS) {
+        cpi->td.rd_counts.global_motion_used[i] < MIN_GLOBAL_MOTION_BLKS) {
       set_default_gmparams(&cm->global_motion[i]);
 #if CONFIG_REF_MV
       recode = 1;
 #else
-      recode |= (cpi->global_motion_used[i] > 0);
+      recode |= (cpi->td.rd_counts.global_motion_used[i] > 0);
 #endif
     }
   }
@@ -3369,8 +3391,12 @@ static void loopfilter_frame(AV1_COMP *cpi, AV1_COMMON *cm) {
     cm->dering_level = 0;
   } else {
     cm->dering_level =
-        av1_dering_search(cm->frame_to_show, cpi->Source, cm, xd);
-    av1_dering_frame(cm->frame_to_show, cm, xd, cm->dering_level);
+        av1_dering_search(cm->frame_to_show, cpi->Source, cpi);
+    if (cpi->num_workers > 1)
+      av1_dering_frame_mt(cm->frame_to_show, cm, xd, cm->dering_level,
+                          cpi->workers, cpi->num_workers);
+    else
+      av1_dering_frame(cm->frame_to_show, cm, xd, cm->dering_level);
   }
 #endif  // CONFIG_DERING
 
@@ -3398,10 +3424,10 @@ static void loopfilter_frame(AV1_COMP *cpi, AV1_COMMON *cm) {
 
     // Find the best strength and block size for the entire frame
     int fb_size_log2, strength_y, strength_u, strength_v;
-    av1_clpf_test_frame(frame, cpi->Source, cm, &strength_y, &fb_size_log2,
+    av1_clpf_test_frame(frame, cpi->Source, cpi, &strength_y, &fb_size_log2,
                         AOM_PLANE_Y);
-    av1_clpf_test_frame(frame, cpi->Source, cm, &strength_u, 0, AOM_PLANE_U);
-    av1_clpf_test_frame(frame, cpi->Source, cm, &strength_v, 0, AOM_PLANE_V);
+    av1_clpf_test_frame(frame, cpi->Source, cpi, &strength_u, 0, AOM_PLANE_U);
+    av1_clpf_test_frame(frame, cpi->Source, cpi, &strength_v, 0, AOM_PLANE_V);
 
     if (strength_y) {
       // Apply the filter using the chosen strength
@@ -3424,10 +3450,16 @@ static void loopfilter_frame(AV1_COMP *cpi, AV1_COMMON *cm) {
 #endif
 #if CONFIG_LOOP_RESTORATION
   if (cm->rst_info.restoration_type != RESTORE_NONE) {
-    av1_loop_restoration_init(&cm->rst_internal, &cm->rst_info,
-                              cm->frame_type == KEY_FRAME, cm->width,
-                              cm->height);
-    av1_loop_restoration_rows(cm->frame_to_show, cm, 0, cm->mi_rows, 0);
+    if (cpi->num_workers > 1) {
+      av1_loop_restoration_frame_mt(cm->frame_to_show, cm, &cm->rst_info, 0,
+                                    0, cpi->workers, cpi->num_workers,
+                                    &cpi->lr_row_sync);
+    } else {
+      av1_loop_restoration_init(&cm->rst_internal, &cm->rst_info,
+                                cm->frame_type == KEY_FRAME, cm->width,
+                                cm->height);
+      av1_loop_restoration_rows(cm->frame_to_show, cm, 0, cm->mi_rows, 0);
+    }
   }
 #endif  // CONFIG_LOOP_RESTORATION
 
@@ -3727,6 +3759,7 @@ static void set_size_independent_vars(AV1_COMP *cpi) {
     set_default_gmparams(&cpi->common.global_motion[i]);
   }
   cpi->global_motion_search_done = 0;
+  cpi->frame_time_global_motion = 0;
 #endif  // CONFIG_GLOBAL_MOTION
   av1_set_speed_features_framesize_independent(cpi);
   av1_set_rd_speed_thresholds(cpi);
@@ -4345,6 +4378,7 @@ YV12_BUFFER_CONFIG *av1_scale_if_required_fast(AV1_COMMON *cm,
     // For 2x2 scaling down.
     aom_scale_frame(unscaled, scaled, unscaled->y_buffer, 9, 2, 1, 2, 1, 0);
     aom_extend_frame_borders(scaled);
+    aom_invalidate_frame_buffer_cache(scaled);
     return scaled;
   } else {
     return unscaled;
@@ -4361,6 +4395,7 @@ YV12_BUFFER_CONFIG *av1_scale_if_required(AV1_COMMON *cm,
 #else
     scale_and_extend_frame_nonnormative(unscaled, scaled);
 #endif  // CONFIG_AOM_HIGHBITDEPTH
+    aom_invalidate_frame_buffer_cache(scaled);
     return scaled;
   } else {
     return unscaled;
@@ -5313,6 +5348,7 @@ int av1_get_compressed_data(AV1_COMP *cpi, unsigned int *frame_flags,
         // Produce the filtered ARF frame.
         av1_temporal_filter(cpi, arf_src_index);
         aom_extend_frame_borders(&cpi->alt_ref_buffer);
+        aom_invalidate_frame_buffer_cache(&cpi->alt_ref_buffer);
         force_src_buffer = &cpi->alt_ref_buffer;
       }
 
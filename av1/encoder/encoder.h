@@ -27,6 +27,7 @@
 #endif
 #include "av1/encoder/context_tree.h"
 #include "av1/encoder/encodemb.h"
+#include "av1/encoder/ethread.h"
 #include "av1/encoder/firstpass.h"
 #include "av1/encoder/lookahead.h"
 #include "av1/encoder/mbgraph.h"
@@ -43,6 +44,7 @@
 #endif
 #include "aom_dsp/variance.h"
 #include "aom/internal/aom_codec_internal.h"
+#include "aom_util/aom_job_queue.h"
 #include "aom_util/aom_thread.h"
 
 #ifdef __cplusplus
@@ -240,6 +242,12 @@ typedef struct AV1EncoderConfig {
   int tile_rows;
 
   int max_threads;
+  // Encode the superblock rows of each tile as a wavefront.
+  int row_mt;
+  // The shared pool the worker threads run on, if any.
+  aom_thread_pool_t *thread_pool;
+  // Look the transform RD results of inter blocks up in a cache.
+  int txfm_rd_cache;
 
   aom_fixed_buf_t two_pass_stats_in;
   struct aom_codec_pkt_list *output_pkt_list;
@@ -277,11 +285,25 @@ typedef struct TileDataEnc {
 #if CONFIG_PVQ
   PVQ_QUEUE pvq_q;
 #endif
+#if CONFIG_GLOBAL_MOTION
+  // Running count of the blocks of the tile coded with each global motion
+  // model, kept by the superblock rows when row based multi-threading.
+  int global_motion_used[TOTAL_REFS_PER_FRAME];
+#endif  // CONFIG_GLOBAL_MOTION
+  // Row based multi-threading, see av1_encode_sb_row().
+  AV1RowMTSync row_mt_sync;
+  // The adaptive state above as seen by each superblock row of the tile.
+  struct TileDataEnc *row_data;
+  // The number of tokens produced by each superblock row of the tile.
+  unsigned int *row_tok_count;
 } TileDataEnc;
 
 typedef struct RD_COUNTS {
   av1_coeff_count coef_counts[TX_SIZES][PLANE_TYPES];
   int64_t comp_pred_diff[REFERENCE_MODES];
+#if CONFIG_GLOBAL_MOTION
+  int global_motion_used[TOTAL_REFS_PER_FRAME];
+#endif  // CONFIG_GLOBAL_MOTION
 } RD_COUNTS;
 
 typedef struct ThreadData {
@@ -295,6 +317,8 @@ typedef struct ThreadData {
 
   VAR_TREE *var_tree;
   VAR_TREE *var_root[MAX_MIB_SIZE_LOG2 - MIN_MIB_SIZE_LOG2 + 1];
+
+  TXFM_RD_CACHE txfm_rd_cache;
 } ThreadData;
 
 struct EncWorkerData;
@@ -400,6 +424,9 @@ typedef struct AV1_COMP {
   YV12_BUFFER_CONFIG last_frame_uf;
 #if CONFIG_LOOP_RESTORATION
   YV12_BUFFER_CONFIG last_frame_db;
+  // Scratch of the threads of av1_pick_filter_restoration().
+  struct RestSearchThread *rest_search_threads;
+  int num_rest_search_threads;
 #endif  // CONFIG_LOOP_RESTORATION
 
   // Ambient reconstruction err target for force key frames
@@ -458,6 +485,12 @@ typedef struct AV1_COMP {
   uint64_t time_compress_data;
   uint64_t time_pick_lpf;
   uint64_t time_encode_sb_row;
+  uint64_t time_temporal_filter;
+#if CONFIG_GLOBAL_MOTION
+  uint64_t time_global_motion;
+  // Time spent estimating the global motion of the last frame.
+  uint64_t frame_time_global_motion;
+#endif  // CONFIG_GLOBAL_MOTION
 
 #if CONFIG_FP_MB_STATS
   int use_fp_mb_stats;
@@ -609,7 +642,12 @@ typedef struct AV1_COMP {
   int num_workers;
   AVxWorker *workers;
   struct EncWorkerData *tile_thr_data;
+  // The tiles or superblock rows for the workers to encode.
+  AOMJobQueue enc_job_queue;
   AV1LfSync lf_row_sync;
+#if CONFIG_LOOP_RESTORATION
+  AV1LrSync lr_row_sync;
+#endif  // CONFIG_LOOP_RESTORATION
 #if CONFIG_ENTROPY
   SUBFRAME_STATS subframe_stats;
   // TODO(yaowu): minimize the size of count buffers
@@ -627,7 +665,6 @@ typedef struct AV1_COMP {
   int arf_map[MAX_EXT_ARFS + 1];
 #endif  // CONFIG_EXT_REFS
 #if CONFIG_GLOBAL_MOTION
-  int global_motion_used[TOTAL_REFS_PER_FRAME];
   int global_motion_search_done;
 #endif
 #if CONFIG_REFERENCE_BUFFER
@@ -28,37 +28,45 @@ static void accumulate_rd_opt(ThreadData *td, ThreadData *td_t) {
             for (n = 0; n < ENTROPY_TOKENS; n++)
               td->rd_counts.coef_counts[i][j][k][l][m][n] +=
                   td_t->rd_counts.coef_counts[i][j][k][l][m][n];
+
+#if CONFIG_GLOBAL_MOTION
+  for (i = 0; i < TOTAL_REFS_PER_FRAME; i++)
+    td->rd_counts.global_motion_used[i] +=
+        td_t->rd_counts.global_motion_used[i];
+#endif  // CONFIG_GLOBAL_MOTION
+#if CONFIG_VAR_TX
+  td->mb.txb_split_count += td_t->mb.txb_split_count;
+#endif  // CONFIG_VAR_TX
 }
 
 static int enc_worker_hook(EncWorkerData *const thread_data, void *unused) {
   AV1_COMP *const cpi = thread_data->cpi;
   const AV1_COMMON *const cm = &cpi->common;
-  const int tile_cols = cm->tile_cols;
   const int tile_rows = cm->tile_rows;
-  int t;
+  int tile_row, tile_col;
 
   (void)unused;
 
-  for (t = thread_data->start; t < tile_rows * tile_cols;
-       t += cpi->num_workers) {
-    int tile_row = t / tile_cols;
-    int tile_col = t % tile_cols;
-
-    av1_encode_tile(cpi, thread_data->td, tile_row, tile_col);
+  // The tiles of a column share their above context, so each job is a whole
+  // column of tiles, encoded from the top.
+  while ((tile_col = aom_job_queue_pop(&cpi->enc_job_queue,
+                                       thread_data->thread_id)) >= 0) {
+    for (tile_row = 0; tile_row < tile_rows; ++tile_row)
+      av1_encode_tile(cpi, thread_data->td, tile_row, tile_col);
   }
 
   return 0;
 }
 
-void av1_encode_tiles_mt(AV1_COMP *cpi) {
+// Creates one worker for each of the threads the encoder may use, whichever
+// stage runs first, so that the stages that split into more jobs than there
+// are tile columns still get all of them.
+static void create_enc_workers(AV1_COMP *cpi) {
   AV1_COMMON *const cm = &cpi->common;
-  const int tile_cols = cm->tile_cols;
   const AVxWorkerInterface *const winterface = aom_get_worker_interface();
-  const int num_workers = AOMMIN(cpi->oxcf.max_threads, tile_cols);
+  const int num_workers = AOMMAX(cpi->oxcf.max_threads, 1);
   int i;
 
-  av1_init_tile_data(cpi);
-
   // Only run once to create threads and allocate thread data.
   if (cpi->num_workers == 0) {
     CHECK_MEM_ERROR(cm, cpi->workers,
@@ -73,6 +81,8 @@ void av1_encode_tiles_mt(AV1_COMP *cpi) {
 
       ++cpi->num_workers;
       winterface->init(worker);
+      worker->pool = cpi->oxcf.thread_pool;
+      worker->pool_owner = cpi;
 
       thread_data->cpi = cpi;
 
@@ -89,7 +99,7 @@ void av1_encode_tiles_mt(AV1_COMP *cpi) {
 
         // Set up variance tree if needed.
         if (cpi->sf.partition_search_type == VAR_BASED_PARTITION)
-          av1_setup_var_tree(cm, &cpi->td);
+          av1_setup_var_tree(cm, thread_data->td);
 
         // Allocate frame counters in thread data.
         CHECK_MEM_ERROR(cm, thread_data->td->counts,
@@ -107,12 +117,19 @@ void av1_encode_tiles_mt(AV1_COMP *cpi) {
       winterface->sync(worker);
     }
   }
+}
 
-  for (i = 0; i < num_workers; i++) {
+// Sets up the last |num_workers| workers for a stage of the encoding. The last
+// worker is the main thread, so it is always among them.
+static void prepare_enc_workers(AV1_COMP *cpi, AVxWorkerHook hook,
+                                int num_workers) {
+  int i;
+
+  for (i = cpi->num_workers - num_workers; i < cpi->num_workers; i++) {
     AVxWorker *const worker = &cpi->workers[i];
     EncWorkerData *thread_data;
 
-    worker->hook = (AVxWorkerHook)enc_worker_hook;
+    worker->hook = hook;
     worker->data1 = &cpi->tile_thr_data[i];
     worker->data2 = NULL;
     thread_data = (EncWorkerData *)worker->data1;
@@ -129,21 +146,42 @@ void av1_encode_tiles_mt(AV1_COMP *cpi) {
 
 #if CONFIG_PALETTE
     // Allocate buffers used by palette coding mode.
-    if (cpi->common.allow_screen_content_tools && i < num_workers - 1) {
+    if (cpi->common.allow_screen_content_tools && i < cpi->num_workers - 1) {
       MACROBLOCK *x = &thread_data->td->mb;
-      CHECK_MEM_ERROR(cm, x->palette_buffer,
+      CHECK_MEM_ERROR(&cpi->common, x->palette_buffer,
                       aom_memalign(16, sizeof(*x->palette_buffer)));
     }
 #endif  // CONFIG_PALETTE
   }
+}
+
+// Deals jobs 0 to num_jobs - 1 out to |num_workers| workers. With |ordered|
+// set they are taken in increasing order too.
+static void queue_enc_jobs(AV1_COMP *cpi, int num_jobs, int ordered,
+                           int num_workers) {
+  AOMJobQueue *const q = &cpi->enc_job_queue;
+
+  if (q->max_threads < cpi->num_workers || q->max_jobs < num_jobs) {
+    aom_job_queue_dealloc(q);
+    if (!aom_job_queue_alloc(q, cpi->num_workers, num_jobs))
+      aom_internal_error(&cpi->common.error, AOM_CODEC_MEM_ERROR,
+                         "Failed to allocate cpi->enc_job_queue");
+  }
+  aom_job_queue_reset(q, num_workers, ordered);
+  aom_job_queue_push_range(q, num_jobs);
+}
+
+static void launch_enc_workers(AV1_COMP *cpi, int num_workers) {
+  const AVxWorkerInterface *const winterface = aom_get_worker_interface();
+  const int first = cpi->num_workers - num_workers;
+  int i;
 
   // Encode a frame
-  for (i = 0; i < num_workers; i++) {
+  for (i = first; i < cpi->num_workers; i++) {
     AVxWorker *const worker = &cpi->workers[i];
     EncWorkerData *const thread_data = (EncWorkerData *)worker->data1;
 
-    // Set the starting tile for each thread.
-    thread_data->start = i;
+    thread_data->thread_id = i - first;
 
     if (i == cpi->num_workers - 1)
       winterface->execute(worker);
@@ -152,19 +190,351 @@ void av1_encode_tiles_mt(AV1_COMP *cpi) {
   }
 
   // Encoding ends.
-  for (i = 0; i < num_workers; i++) {
+  for (i = first; i < cpi->num_workers; i++) {
     AVxWorker *const worker = &cpi->workers[i];
     winterface->sync(worker);
   }
+  aom_job_queue_finish(&cpi->enc_job_queue);
+}
 
-  for (i = 0; i < num_workers; i++) {
-    AVxWorker *const worker = &cpi->workers[i];
-    EncWorkerData *const thread_data = (EncWorkerData *)worker->data1;
+static void accumulate_enc_workers(AV1_COMP *cpi, int num_workers) {
+  int i;
+
+  for (i = cpi->num_workers - num_workers; i < cpi->num_workers - 1; i++) {
+    EncWorkerData *const thread_data = &cpi->tile_thr_data[i];
 
     // Accumulate counters.
-    if (i < cpi->num_workers - 1) {
-      av1_accumulate_frame_counts(cm, thread_data->td->counts);
-      accumulate_rd_opt(&cpi->td, thread_data->td);
+    av1_accumulate_frame_counts(&cpi->common, thread_data->td->counts);
+    accumulate_rd_opt(&cpi->td, thread_data->td);
+  }
+}
+
+void av1_encode_tiles_mt(AV1_COMP *cpi) {
+  AV1_COMMON *const cm = &cpi->common;
+  int num_workers;
+
+  av1_init_tile_data(cpi);
+  create_enc_workers(cpi);
+  // A job is a column of tiles, so more workers would have nothing to do.
+  num_workers = AOMMIN(cpi->num_workers, cm->tile_cols);
+  prepare_enc_workers(cpi, (AVxWorkerHook)enc_worker_hook, num_workers);
+  queue_enc_jobs(cpi, cm->tile_cols, 0, num_workers);
+  launch_enc_workers(cpi, num_workers);
+  accumulate_enc_workers(cpi, num_workers);
+}
+
+void av1_enc_run_jobs(AV1_COMP *cpi, AVxWorkerHook hook, void *data,
+                      int num_jobs) {
+  int i;
+
+  create_enc_workers(cpi);
+  for (i = 0; i < cpi->num_workers; i++) {
+    AVxWorker *const worker = &cpi->workers[i];
+    worker->hook = hook;
+    worker->data1 = &cpi->tile_thr_data[i];
+    worker->data2 = data;
+  }
+  queue_enc_jobs(cpi, num_jobs, 0, cpi->num_workers);
+  launch_enc_workers(cpi, cpi->num_workers);
+}
+
+void av1_get_txfm_rd_cache_stats(const AV1_COMP *cpi, int64_t *lookups,
+                                 int64_t *hits) {
+  int i;
+
+  *lookups = cpi->td.txfm_rd_cache.lookups;
+  *hits = cpi->td.txfm_rd_cache.hits;
+  for (i = 0; i < cpi->num_workers - 1; i++) {
+    const ThreadData *const td = cpi->tile_thr_data[i].td;
+    *lookups += td->txfm_rd_cache.lookups;
+    *hits += td->txfm_rd_cache.hits;
+  }
+}
+
+void av1_row_mt_sync_read(AV1RowMTSync *const row_mt_sync, int r, int c) {
+#if CONFIG_MULTITHREAD
+  const int nsync = row_mt_sync->sync_range;
+
+  if (r && !(c & (nsync - 1))) {
+    pthread_mutex_t *const mutex = &row_mt_sync->mutex_[r - 1];
+    pthread_mutex_lock(mutex);
+
+    while (c > row_mt_sync->cur_sb_col[r - 1] - nsync) {
+      pthread_cond_wait(&row_mt_sync->cond_[r - 1], mutex);
     }
+    pthread_mutex_unlock(mutex);
+  }
+#else
+  (void)row_mt_sync;
+  (void)r;
+  (void)c;
+#endif  // CONFIG_MULTITHREAD
+}
+
+void av1_row_mt_sync_write(AV1RowMTSync *const row_mt_sync, int r, int c,
+                           const int sb_cols) {
+#if CONFIG_MULTITHREAD
+  const int nsync = row_mt_sync->sync_range;
+  int cur;
+  // Only signal when there are enough encoded SBs for the next row to run.
+  int sig = 1;
+
+  if (c < sb_cols - 1) {
+    cur = c;
+    if (c % nsync) sig = 0;
+  } else {
+    cur = sb_cols + nsync;
+  }
+
+  if (sig) {
+    pthread_mutex_lock(&row_mt_sync->mutex_[r]);
+
+    row_mt_sync->cur_sb_col[r] = cur;
+
+    pthread_cond_broadcast(&row_mt_sync->cond_[r]);
+    pthread_mutex_unlock(&row_mt_sync->mutex_[r]);
   }
+#else
+  (void)row_mt_sync;
+  (void)r;
+  (void)c;
+  (void)sb_cols;
+#endif  // CONFIG_MULTITHREAD
+}
+
+// Waits until all the superblock rows of a tile have been encoded.
+static void row_mt_sync_wait_tile(AV1RowMTSync *const row_mt_sync,
+                                  int sb_cols) {
+#if CONFIG_MULTITHREAD
+  const int r = row_mt_sync->rows - 1;
+  pthread_mutex_t *const mutex = &row_mt_sync->mutex_[r];
+  pthread_mutex_lock(mutex);
+
+  while (row_mt_sync->cur_sb_col[r] < sb_cols + row_mt_sync->sync_range) {
+    pthread_cond_wait(&row_mt_sync->cond_[r], mutex);
+  }
+  pthread_mutex_unlock(mutex);
+#else
+  (void)row_mt_sync;
+  (void)sb_cols;
+#endif  // CONFIG_MULTITHREAD
+}
+
+// Set up nsync by width.
+static INLINE int get_sync_range(int width) {
+  // nsync numbers are picked by testing. For example, for 4k
+  // video, using 4 gives best performance.
+  if (width < 640)
+    return 1;
+  else if (width <= 1280)
+    return 2;
+  else if (width <= 4096)
+    return 4;
+  else
+    return 8;
+}
+
+// Allocate memory for row synchronization
+void av1_row_mt_sync_mem_alloc(AV1RowMTSync *row_mt_sync, AV1_COMMON *cm,
+                               int rows, int width) {
+  row_mt_sync->rows = rows;
+#if CONFIG_MULTITHREAD
+  {
+    int i;
+
+    CHECK_MEM_ERROR(cm, row_mt_sync->mutex_,
+                    aom_malloc(sizeof(*row_mt_sync->mutex_) * rows));
+    if (row_mt_sync->mutex_) {
+      for (i = 0; i < rows; ++i) {
+        pthread_mutex_init(&row_mt_sync->mutex_[i], NULL);
+      }
+    }
+
+    CHECK_MEM_ERROR(cm, row_mt_sync->cond_,
+                    aom_malloc(sizeof(*row_mt_sync->cond_) * rows));
+    if (row_mt_sync->cond_) {
+      for (i = 0; i < rows; ++i) {
+        pthread_cond_init(&row_mt_sync->cond_[i], NULL);
+      }
+    }
+  }
+#endif  // CONFIG_MULTITHREAD
+
+  CHECK_MEM_ERROR(cm, row_mt_sync->cur_sb_col,
+                  aom_malloc(sizeof(*row_mt_sync->cur_sb_col) * rows));
+
+  // Set up nsync.
+  row_mt_sync->sync_range = get_sync_range(width);
+}
+
+// Deallocate row based multi-threading synchronization related mutex and data
+void av1_row_mt_sync_mem_dealloc(AV1RowMTSync *row_mt_sync) {
+  if (row_mt_sync != NULL) {
+#if CONFIG_MULTITHREAD
+    int i;
+
+    if (row_mt_sync->mutex_ != NULL) {
+      for (i = 0; i < row_mt_sync->rows; ++i) {
+        pthread_mutex_destroy(&row_mt_sync->mutex_[i]);
+      }
+      aom_free(row_mt_sync->mutex_);
+    }
+    if (row_mt_sync->cond_ != NULL) {
+      for (i = 0; i < row_mt_sync->rows; ++i) {
+        pthread_cond_destroy(&row_mt_sync->cond_[i]);
+      }
+      aom_free(row_mt_sync->cond_);
+    }
+#endif  // CONFIG_MULTITHREAD
+    aom_free(row_mt_sync->cur_sb_col);
+    // clear the structure as the source of this call may be a resize in which
+    // case this call will be followed by an _alloc() which may fail.
+    av1_zero(*row_mt_sync);
+  }
+}
+
+static void row_mt_tile_dealloc(TileDataEnc *this_tile) {
+  av1_row_mt_sync_mem_dealloc(&this_tile->row_mt_sync);
+  aom_free(this_tile->row_data);
+  this_tile->row_data = NULL;
+  aom_free(this_tile->row_tok_count);
+  this_tile->row_tok_count = NULL;
+}
+
+void av1_row_mt_mem_dealloc(AV1_COMP *cpi) {
+  int i;
+
+  if (cpi->tile_data == NULL) return;
+  for (i = 0; i < cpi->allocated_tiles; ++i)
+    row_mt_tile_dealloc(&cpi->tile_data[i]);
+}
+
+int av1_row_mt_supported(const AV1_COMP *cpi) {
+  const AV1_COMMON *const cm = &cpi->common;
+#if CONFIG_PVQ
+  // The PVQ queue of a tile is filled in coding order.
+  (void)cm;
+  return 0;
+#else
+#if CONFIG_ENTROPY
+  // The sub-frame probability updates depend on the rows above.
+  if (cm->do_subframe_update &&
+      cm->refresh_frame_context == REFRESH_FRAME_CONTEXT_BACKWARD)
+    return 0;
+#endif  // CONFIG_ENTROPY
+#if CONFIG_DELTA_Q
+  // Quantizer deltas are coded relative to the previous superblock.
+  if (cm->delta_q_present_flag) return 0;
+#endif  // CONFIG_DELTA_Q
+  (void)cm;
+  return 1;
+#endif  // CONFIG_PVQ
+}
+
+static int enc_row_mt_worker_hook(EncWorkerData *const thread_data,
+                                  void *unused) {
+  AV1_COMP *const cpi = thread_data->cpi;
+  const AV1_COMMON *const cm = &cpi->common;
+  const int tile_cols = cm->tile_cols;
+  int job;
+
+  (void)unused;
+
+  // The superblock rows are numbered in the order the single-threaded
+  // encoder visits them, and taken in that order, so the rows any row waits
+  // for are always in progress.
+  while ((job = aom_job_queue_pop(&cpi->enc_job_queue,
+                                  thread_data->thread_id)) >= 0) {
+    const TileInfo *tile_info;
+    int tile, tile_row, tile_col, mi_row;
+
+    for (tile = 0; job >= cpi->tile_data[tile].row_mt_sync.rows; ++tile)
+      job -= cpi->tile_data[tile].row_mt_sync.rows;
+    tile_row = tile / tile_cols;
+    tile_col = tile % tile_cols;
+    tile_info = &cpi->tile_data[tile].tile_info;
+    mi_row = tile_info->mi_row_start + job * cm->mib_size;
+
+    // The tile shares its above context with the tile above it, so that
+    // has to be finished first.
+    if (tile_row > 0 && mi_row == tile_info->mi_row_start) {
+      const int sb_cols = (tile_info->mi_col_end - tile_info->mi_col_start +
+                           cm->mib_size - 1) >>
+                          cm->mib_size_log2;
+      row_mt_sync_wait_tile(
+          &cpi->tile_data[(tile_row - 1) * tile_cols + tile_col].row_mt_sync,
+          sb_cols);
+    }
+    av1_encode_sb_row(cpi, thread_data->td, tile_row, tile_col, mi_row);
+  }
+
+  return 1;
+}
+
+void av1_encode_tiles_row_mt(AV1_COMP *cpi) {
+  AV1_COMMON *const cm = &cpi->common;
+  const int tile_cols = cm->tile_cols;
+  const int tile_rows = cm->tile_rows;
+  int tile_row, tile_col, i;
+  int num_jobs = 0;
+
+  av1_init_tile_data(cpi);
+  create_enc_workers(cpi);
+
+  for (tile_row = 0; tile_row < tile_rows; ++tile_row) {
+    for (tile_col = 0; tile_col < tile_cols; ++tile_col) {
+      TileDataEnc *const this_tile =
+          &cpi->tile_data[tile_row * tile_cols + tile_col];
+      const TileInfo *const tile_info = &this_tile->tile_info;
+      const int sb_rows = (tile_info->mi_row_end - tile_info->mi_row_start +
+                           cm->mib_size - 1) >>
+                          cm->mib_size_log2;
+
+      if (this_tile->row_mt_sync.rows != sb_rows) {
+        row_mt_tile_dealloc(this_tile);
+        av1_row_mt_sync_mem_alloc(&this_tile->row_mt_sync, cm, sb_rows,
+                                  cm->width);
+        CHECK_MEM_ERROR(cm, this_tile->row_data,
+                        aom_calloc(sb_rows, sizeof(*this_tile->row_data)));
+        CHECK_MEM_ERROR(
+            cm, this_tile->row_tok_count,
+            aom_calloc(sb_rows, sizeof(*this_tile->row_tok_count)));
+      }
+
+      // Initialize cur_sb_col to -1 for all superblock rows.
+      memset(this_tile->row_mt_sync.cur_sb_col, -1,
+             sizeof(*this_tile->row_mt_sync.cur_sb_col) * sb_rows);
+      num_jobs += sb_rows;
+    }
+  }
+
+  prepare_enc_workers(cpi, (AVxWorkerHook)enc_row_mt_worker_hook,
+                      cpi->num_workers);
+  queue_enc_jobs(cpi, num_jobs, 1, cpi->num_workers);
+  launch_enc_workers(cpi, cpi->num_workers);
+
+  // Pack the tokens of the superblock rows of each tile together for the
+  // bitstream writer.
+  for (tile_row = 0; tile_row < tile_rows; ++tile_row) {
+    for (tile_col = 0; tile_col < tile_cols; ++tile_col) {
+      const TileDataEnc *const this_tile =
+          &cpi->tile_data[tile_row * tile_cols + tile_col];
+      const TileInfo *const tile_info = &this_tile->tile_info;
+      const int tile_mb_cols =
+          (tile_info->mi_col_end - tile_info->mi_col_start + 1) >> 1;
+      TOKENEXTRA *const tok_start = cpi->tile_tok[tile_row][tile_col];
+      TOKENEXTRA *tok = tok_start;
+
+      for (i = 0; i < this_tile->row_mt_sync.rows; ++i) {
+        const TOKENEXTRA *const row_tok =
+            tok_start +
+            get_token_alloc((i << cm->mib_size_log2) >> 1, tile_mb_cols);
+        memmove(tok, row_tok, this_tile->row_tok_count[i] * sizeof(*tok));
+        tok += this_tile->row_tok_count[i];
+      }
+      cpi->tok_count[tile_row][tile_col] = (unsigned int)(tok - tok_start);
+    }
+  }
+
+  accumulate_enc_workers(cpi, cpi->num_workers);
 }
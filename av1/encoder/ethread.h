@@ -12,21 +12,73 @@
 #ifndef AV1_ENCODER_ETHREAD_H_
 #define AV1_ENCODER_ETHREAD_H_
 
+#include "./aom_config.h"
+#include "aom_util/aom_thread.h"
+
 #ifdef __cplusplus
 extern "C" {
 #endif
 
+struct AV1Common;
 struct AV1_COMP;
 struct ThreadData;
 
 typedef struct EncWorkerData {
   struct AV1_COMP *cpi;
   struct ThreadData *td;
-  int start;
+  // Index of the worker in the job queue.
+  int thread_id;
 } EncWorkerData;
 
+// Superblock row synchronization for row based multi-threaded encoding
+typedef struct AV1RowMTSyncData {
+#if CONFIG_MULTITHREAD
+  pthread_mutex_t *mutex_;
+  pthread_cond_t *cond_;
+#endif
+  // Allocate memory to store the encoded superblock index in each row.
+  int *cur_sb_col;
+  // The optimal sync_range for different resolution and platform should be
+  // determined by testing. Currently, it is chosen to be a power-of-2 number.
+  int sync_range;
+  int rows;
+} AV1RowMTSync;
+
+void av1_row_mt_sync_mem_alloc(AV1RowMTSync *row_mt_sync,
+                               struct AV1Common *cm, int rows, int width);
+void av1_row_mt_sync_mem_dealloc(AV1RowMTSync *row_mt_sync);
+
+// Waits until superblock |c| of row |r| may be encoded, i.e. until the row
+// above has been encoded up to and including its superblock |c + 1|.
+void av1_row_mt_sync_read(AV1RowMTSync *const row_mt_sync, int r, int c);
+// Signals that superblock |c| of row |r| has been encoded.
+void av1_row_mt_sync_write(AV1RowMTSync *const row_mt_sync, int r, int c,
+                           const int sb_cols);
+
 void av1_encode_tiles_mt(struct AV1_COMP *cpi);
 
+// Runs |hook| on all the encoder workers, with their EncWorkerData and |data|
+// as arguments. The workers share jobs 0 to |num_jobs| - 1, which they take
+// from cpi->enc_job_queue.
+void av1_enc_run_jobs(struct AV1_COMP *cpi, AVxWorkerHook hook, void *data,
+                      int num_jobs);
+
+// Sums the lookups in the transform RD caches of all the threads, and their
+// hits, over all the frames encoded so far.
+void av1_get_txfm_rd_cache_stats(const struct AV1_COMP *cpi, int64_t *lookups,
+                                 int64_t *hits);
+
+// Encodes the superblock rows of all tiles as wavefronts, with all the
+// available threads working on each tile.
+void av1_encode_tiles_row_mt(struct AV1_COMP *cpi);
+
+// Returns whether the current frame can be encoded by
+// av1_encode_tiles_row_mt().
+int av1_row_mt_supported(const struct AV1_COMP *cpi);
+
+// Frees the per-tile row based multi-threading data.
+void av1_row_mt_mem_dealloc(struct AV1_COMP *cpi);
+
 #ifdef __cplusplus
 }  // extern "C"
 #endif
@@ -26,35 +26,6 @@
 #define MAX_CORNERS 4096
 #define MIN_INLIER_PROB 0.1
 
-static INLINE RansacFunc get_ransac_type(TransformationType type) {
-  switch (type) {
-    case HOMOGRAPHY: return ransac_homography;
-    case AFFINE: return ransac_affine;
-    case ROTZOOM: return ransac_rotzoom;
-    case TRANSLATION: return ransac_translation;
-    default: assert(0); return NULL;
-  }
-}
-
-// computes global motion parameters by fitting a model using RANSAC
-static int compute_global_motion_params(TransformationType type,
-                                        double *correspondences,
-                                        int num_correspondences, double *params,
-                                        int *inlier_map) {
-  int result;
-  int num_inliers = 0;
-  RansacFunc ransac = get_ransac_type(type);
-  if (ransac == NULL) return 0;
-
-  result = ransac(correspondences, num_correspondences, &num_inliers,
-                  inlier_map, params);
-  if (!result && num_inliers < MIN_INLIER_PROB * num_correspondences) {
-    result = 1;
-    num_inliers = 0;
-  }
-  return num_inliers;
-}
-
 #if CONFIG_AOM_HIGHBITDEPTH
 unsigned char *downconvert_frame(YV12_BUFFER_CONFIG *frm, int bit_depth) {
   int i, j;
@@ -70,57 +41,116 @@ unsigned char *downconvert_frame(YV12_BUFFER_CONFIG *frm, int bit_depth) {
 }
 #endif
 
-int compute_global_motion_feature_based(TransformationType type,
-                                        YV12_BUFFER_CONFIG *frm,
-                                        YV12_BUFFER_CONFIG *ref,
-#if CONFIG_AOM_HIGHBITDEPTH
-                                        int bit_depth,
-#endif
-                                        double *params) {
-  int num_frm_corners, num_ref_corners;
-  int num_correspondences;
-  double *correspondences;
-  int num_inliers;
-  int frm_corners[2 * MAX_CORNERS], ref_corners[2 * MAX_CORNERS];
-  int *inlier_map = NULL;
-  unsigned char *frm_buffer = frm->y_buffer;
-  unsigned char *ref_buffer = ref->y_buffer;
-
+// Returns the luma plane of the frame with 8 bits per sample.
+static unsigned char *get_frame_buffer_8bit(YV12_BUFFER_CONFIG *frm,
+                                            int bit_depth) {
 #if CONFIG_AOM_HIGHBITDEPTH
   if (frm->flags & YV12_FLAG_HIGHBITDEPTH) {
     // The frame buffer is 16-bit, so we need to convert to 8 bits for the
-    // following code. We cache the result until the frame is released.
-    if (frm->y_buffer_8bit)
-      frm_buffer = frm->y_buffer_8bit;
-    else
-      frm_buffer = frm->y_buffer_8bit = downconvert_frame(frm, bit_depth);
-  }
-  if (ref->flags & YV12_FLAG_HIGHBITDEPTH) {
-    if (ref->y_buffer_8bit)
-      ref_buffer = ref->y_buffer_8bit;
-    else
-      ref_buffer = ref->y_buffer_8bit = downconvert_frame(ref, bit_depth);
+    // following code. We cache the result until the frame is released or
+    // its contents change.
+    if (!frm->buf_8bit_valid) {
+      free(frm->y_buffer_8bit);
+      frm->y_buffer_8bit = downconvert_frame(frm, bit_depth);
+      frm->buf_8bit_valid = 1;
+    }
+    return frm->y_buffer_8bit;
   }
 #endif
+  (void)bit_depth;
+  return frm->y_buffer;
+}
 
+int compute_frame_features(YV12_BUFFER_CONFIG *frm, int bit_depth) {
+  unsigned char *buffer = get_frame_buffer_8bit(frm, bit_depth);
+  if (frm->corners_valid) return 1;
+  if (!frm->corners) {
+    frm->corners = (int *)malloc(2 * MAX_CORNERS * sizeof(*frm->corners));
+    frm->corner_stats =
+        (int *)malloc(2 * MAX_CORNERS * sizeof(*frm->corner_stats));
+    if (!frm->corners || !frm->corner_stats) {
+      free(frm->corners);
+      free(frm->corner_stats);
+      frm->corners = NULL;
+      frm->corner_stats = NULL;
+      return 0;
+    }
+  }
   // compute interest points in images using FAST features
-  num_frm_corners = fast_corner_detect(frm_buffer, frm->y_width, frm->y_height,
-                                       frm->y_stride, frm_corners, MAX_CORNERS);
-  num_ref_corners = fast_corner_detect(ref_buffer, ref->y_width, ref->y_height,
-                                       ref->y_stride, ref_corners, MAX_CORNERS);
+  frm->num_corners = fast_corner_detect(buffer, frm->y_width, frm->y_height,
+                                        frm->y_stride, frm->corners,
+                                        MAX_CORNERS);
+  compute_corner_stats(buffer, frm->y_stride, frm->corners, frm->num_corners,
+                       frm->y_width, frm->y_height, frm->corner_stats);
+  frm->corners_valid = 1;
+  return 1;
+}
+
+RansacFit *global_motion_fit_alloc(TransformationType type,
+                                   YV12_BUFFER_CONFIG *frm,
+                                   YV12_BUFFER_CONFIG *ref, int bit_depth,
+                                   int max_batch) {
+  int num_correspondences;
+  double *correspondences;
+  RansacFit *fit;
+  unsigned char *frm_buffer;
+  unsigned char *ref_buffer;
+
+  if (!frm->corners_valid || !ref->corners_valid) return NULL;
+  frm_buffer = get_frame_buffer_8bit(frm, bit_depth);
+  ref_buffer = get_frame_buffer_8bit(ref, bit_depth);
 
   // find correspondences between the two images
   correspondences =
-      (double *)malloc(num_frm_corners * 4 * sizeof(*correspondences));
+      (double *)malloc(frm->num_corners * 4 * sizeof(*correspondences));
+  if (!correspondences) return NULL;
   num_correspondences = determine_correspondence(
-      frm_buffer, (int *)frm_corners, num_frm_corners, ref_buffer,
-      (int *)ref_corners, num_ref_corners, frm->y_width, frm->y_height,
-      frm->y_stride, ref->y_stride, correspondences);
+      frm_buffer, frm->corners, frm->corner_stats, frm->num_corners,
+      ref_buffer, ref->corners, ref->corner_stats, ref->num_corners,
+      frm->y_width, frm->y_height, frm->y_stride, ref->y_stride,
+      correspondences);
 
-  inlier_map = (int *)malloc(num_correspondences * sizeof(*inlier_map));
-  num_inliers = compute_global_motion_params(
-      type, correspondences, num_correspondences, params, inlier_map);
+  fit = ransac_fit_alloc(type, correspondences, num_correspondences,
+                         max_batch);
   free(correspondences);
+  return fit;
+}
+
+int global_motion_fit_finish(RansacFit *fit, double *params) {
+  int num_inliers = 0;
+  int *inlier_map = (int *)malloc(fit->npoints * sizeof(*inlier_map));
+  const int result =
+      !inlier_map ||
+      ransac_fit_finish(fit, &num_inliers, inlier_map, params) ||
+      num_inliers < MIN_INLIER_PROB * fit->npoints;
   free(inlier_map);
-  return (num_inliers > 0);
+  ransac_fit_free(fit);
+  return !result;
+}
+
+int compute_global_motion_feature_based(TransformationType type,
+                                        YV12_BUFFER_CONFIG *frm,
+                                        YV12_BUFFER_CONFIG *ref,
+#if CONFIG_AOM_HIGHBITDEPTH
+                                        int bit_depth,
+#endif
+                                        double *params) {
+  RansacFit *fit;
+#if !CONFIG_AOM_HIGHBITDEPTH
+  const int bit_depth = 8;
+#endif
+
+  // The features are only found once per frame, and reused when the frame
+  // is searched again
+  if (!compute_frame_features(frm, bit_depth) ||
+      !compute_frame_features(ref, bit_depth))
+    return 0;
+
+  fit = global_motion_fit_alloc(type, frm, ref, bit_depth, 1);
+  if (fit == NULL) return 0;
+  while (ransac_fit_next_batch(fit)) {
+    ransac_fit_score(fit, 0);
+    ransac_fit_update(fit);
+  }
+  return global_motion_fit_finish(fit, params);
 }
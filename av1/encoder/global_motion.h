@@ -13,11 +13,30 @@
 #define AV1_ENCODER_GLOBAL_MOTION_H_
 
 #include "aom/aom_integer.h"
+#include "av1/encoder/ransac.h"
 
 #ifdef __cplusplus
 extern "C" {
 #endif
 
+// Finds the interest points of the luma plane of a frame, unless they are
+// cached with the frame already. The 8-bit copy of a high bitdepth frame is
+// made as well. Returns 0 if memory could not be allocated.
+int compute_frame_features(YV12_BUFFER_CONFIG *frm, int bit_depth);
+
+// Matches the features of two frames, found with compute_frame_features(),
+// and sets up a RANSAC fit of a model of the given type to the matches that
+// runs at most max_batch trials at a time. Returns NULL if there are too few
+// matches to fit a model to.
+RansacFit *global_motion_fit_alloc(TransformationType type,
+                                   YV12_BUFFER_CONFIG *frm,
+                                   YV12_BUFFER_CONFIG *ref, int bit_depth,
+                                   int max_batch);
+
+// Frees a fit once it is complete, and returns 1 with the parameters of its
+// model if enough of the matches are inliers of it.
+int global_motion_fit_finish(RansacFit *fit, double *params);
+
 /*
   Computes global motion parameters between two frames. The array
   "params" should be length 9, where the first 2 slots are translation
@@ -181,6 +181,7 @@ int av1_lookahead_push(struct lookahead_ctx *ctx, YV12_BUFFER_CONFIG *src,
 #if USE_PARTIAL_COPY
   }
 #endif
+  aom_invalidate_frame_buffer_cache(&buf->img);
 
   buf->ts_start = ts_start;
   buf->ts_end = ts_end;
@@ -2332,6 +2332,217 @@ int av1_full_pixel_search(const AV1_COMP *cpi, MACROBLOCK *x, BLOCK_SIZE bsize,
   return var;
 }
 
+// Range of the search at the coarsest level of the pyramid, and of the
+// refinement at each finer level, in pixels of the level.
+#define PYRAMID_SEARCH_RANGE 8
+#define PYRAMID_REFINE_RANGE 1
+// The full resolution search that follows the pyramid search starts with
+// steps of 4 pixels.
+#define PYRAMID_STEP_PARAM (MAX_MVSEARCH_STEPS - 3)
+
+// Fills the border of a pyramid level with the pixels at its edges.
+static void extend_pyramid_level(uint8_t *buf, int width, int height,
+                                 int stride) {
+  int i;
+  for (i = 0; i < height; ++i) {
+    uint8_t *const row = buf + i * stride;
+    memset(row - PYRAMID_BORDER, row[0], PYRAMID_BORDER);
+    memset(row + width, row[width - 1], PYRAMID_BORDER);
+  }
+  for (i = 1; i <= PYRAMID_BORDER; ++i) {
+    memcpy(buf - i * stride - PYRAMID_BORDER, buf - PYRAMID_BORDER,
+           width + 2 * PYRAMID_BORDER);
+    memcpy(buf + (height - 1 + i) * stride - PYRAMID_BORDER,
+           buf + (height - 1) * stride - PYRAMID_BORDER,
+           width + 2 * PYRAMID_BORDER);
+  }
+}
+
+int av1_build_frame_pyramid(YV12_BUFFER_CONFIG *frm, int levels, int bd) {
+  size_t size = 0;
+  int l, i, j;
+
+  levels = AOMMIN(levels, YV12_MAX_PYRAMID_LEVELS);
+  if (frm->pyramid_valid && frm->pyramid_levels >= levels) return 1;
+
+  // The levels are rebuilt, so nothing of the old pyramid may be used if
+  // this fails.
+  frm->pyramid_valid = 0;
+  frm->pyramid_levels = 0;
+  memset(frm->pyramid_buffer, 0, sizeof(frm->pyramid_buffer));
+  frm->pyramid_width[0] = frm->y_crop_width;
+  frm->pyramid_height[0] = frm->y_crop_height;
+  for (l = 1; l <= levels; ++l) {
+    frm->pyramid_width[l] = (frm->pyramid_width[l - 1] + 1) >> 1;
+    frm->pyramid_height[l] = (frm->pyramid_height[l - 1] + 1) >> 1;
+    frm->pyramid_stride[l] =
+        (frm->pyramid_width[l] + 2 * PYRAMID_BORDER + 15) & ~15;
+    size += (size_t)frm->pyramid_stride[l] *
+            (frm->pyramid_height[l] + 2 * PYRAMID_BORDER);
+  }
+  if (size > frm->pyramid_alloc_sz) {
+    aom_free(frm->pyramid_alloc);
+    frm->pyramid_alloc_sz = 0;
+    frm->pyramid_alloc = (uint8_t *)aom_memalign(16, size);
+    if (frm->pyramid_alloc == NULL) return 0;
+    frm->pyramid_alloc_sz = size;
+  }
+
+  size = 0;
+  for (l = 1; l <= levels; ++l) {
+    const int w = frm->pyramid_width[l], h = frm->pyramid_height[l];
+    const int stride = frm->pyramid_stride[l];
+    const int src_w = frm->pyramid_width[l - 1];
+    const int src_h = frm->pyramid_height[l - 1];
+    uint8_t *const buf =
+        frm->pyramid_alloc + size + PYRAMID_BORDER * stride + PYRAMID_BORDER;
+    size += (size_t)stride * (h + 2 * PYRAMID_BORDER);
+    frm->pyramid_buffer[l] = buf;
+
+    // Each pixel is the average of 2x2 pixels of the level above, with the
+    // last row and column of an odd-sized level repeated.
+    for (i = 0; i < h; ++i) {
+      const int r0 = 2 * i, r1 = AOMMIN(2 * i + 1, src_h - 1);
+      for (j = 0; j < w; ++j) {
+        const int c0 = 2 * j, c1 = AOMMIN(2 * j + 1, src_w - 1);
+        int sum;
+        if (l > 1) {
+          const uint8_t *const src = frm->pyramid_buffer[l - 1];
+          const int src_stride = frm->pyramid_stride[l - 1];
+          sum = src[r0 * src_stride + c0] + src[r0 * src_stride + c1] +
+                src[r1 * src_stride + c0] + src[r1 * src_stride + c1];
+          buf[i * stride + j] = ROUND_POWER_OF_TWO(sum, 2);
+#if CONFIG_AOM_HIGHBITDEPTH
+        } else if (frm->flags & YV12_FLAG_HIGHBITDEPTH) {
+          const uint16_t *const src = CONVERT_TO_SHORTPTR(frm->y_buffer);
+          const int src_stride = frm->y_stride;
+          sum = src[r0 * src_stride + c0] + src[r0 * src_stride + c1] +
+                src[r1 * src_stride + c0] + src[r1 * src_stride + c1];
+          buf[i * stride + j] = ROUND_POWER_OF_TWO(sum, 2 + bd - 8);
+#endif  // CONFIG_AOM_HIGHBITDEPTH
+        } else {
+          const uint8_t *const src = frm->y_buffer;
+          const int src_stride = frm->y_stride;
+          sum = src[r0 * src_stride + c0] + src[r0 * src_stride + c1] +
+                src[r1 * src_stride + c0] + src[r1 * src_stride + c1];
+          buf[i * stride + j] = ROUND_POWER_OF_TWO(sum, 2);
+        }
+      }
+    }
+    extend_pyramid_level(buf, w, h, stride);
+  }
+#if !CONFIG_AOM_HIGHBITDEPTH
+  (void)bd;
+#endif  // !CONFIG_AOM_HIGHBITDEPTH
+  frm->pyramid_levels = levels;
+  frm->pyramid_valid = 1;
+  return 1;
+}
+
+static aom_sad_fn_t get_pyramid_sad_fn(BLOCK_SIZE bsize) {
+  switch (bsize) {
+    case BLOCK_8X8: return aom_sad8x8;
+    case BLOCK_8X16: return aom_sad8x16;
+    case BLOCK_16X8: return aom_sad16x8;
+    case BLOCK_16X16: return aom_sad16x16;
+    case BLOCK_16X32: return aom_sad16x32;
+    case BLOCK_32X16: return aom_sad32x16;
+    case BLOCK_32X32: return aom_sad32x32;
+    case BLOCK_32X64: return aom_sad32x64;
+    case BLOCK_64X32: return aom_sad64x32;
+    case BLOCK_64X64: return aom_sad64x64;
+    default: assert(0 && "Invalid pyramid block size"); return NULL;
+  }
+}
+
+int av1_pyramid_motion_search(const AV1_COMP *cpi, MACROBLOCK *x,
+                              BLOCK_SIZE bsize, int mi_row, int mi_col,
+                              const YV12_BUFFER_CONFIG *src,
+                              const YV12_BUFFER_CONFIG *ref, MV *mvp_full,
+                              int sadpb, const MV *ref_mv, int step_param) {
+  const MV ref_mv_full = { ref_mv->row >> 3, ref_mv->col >> 3 };
+  BLOCK_SIZE bs[YV12_MAX_PYRAMID_LEVELS + 1];
+  MV best = { 0, 0 };
+  int levels = AOMMIN(cpi->sf.mv.pyramid_search_levels,
+                      AOMMIN(src->pyramid_levels, ref->pyramid_levels));
+  int l;
+
+  if (!src->pyramid_valid || !ref->pyramid_valid ||
+      src->y_crop_width != ref->y_crop_width ||
+      src->y_crop_height != ref->y_crop_height)
+    return step_param;
+  // The block is at least 8x8 pixels at the coarsest level searched.
+  bs[0] = bsize;
+  for (l = 1; l <= levels; ++l) {
+    if (block_size_wide[bs[l - 1]] < 16 || block_size_high[bs[l - 1]] < 16)
+      break;
+    bs[l] = ss_size_lookup[bs[l - 1]][1][1];
+  }
+  levels = l - 1;
+  if (levels == 0) return step_param;
+
+  for (l = levels; l >= 1; --l) {
+    const int bw = block_size_wide[bs[l]], bh = block_size_high[bs[l]];
+    const int row = (mi_row * MI_SIZE) >> l, col = (mi_col * MI_SIZE) >> l;
+    const int src_stride = src->pyramid_stride[l];
+    const int ref_stride = ref->pyramid_stride[l];
+    const uint8_t *const src_buf =
+        src->pyramid_buffer[l] + row * src_stride + col;
+    const uint8_t *const ref_buf =
+        ref->pyramid_buffer[l] + row * ref_stride + col;
+    const aom_sad_fn_t sdf = get_pyramid_sad_fn(bs[l]);
+    // The search stays within the motion vector limits of the block and
+    // within the border of the level.
+    const int row_min =
+        AOMMAX(-((-x->mv_row_min) >> l), -PYRAMID_BORDER - row);
+    const int row_max = AOMMIN(
+        x->mv_row_max >> l, ref->pyramid_height[l] + PYRAMID_BORDER - bh - row);
+    const int col_min =
+        AOMMAX(-((-x->mv_col_min) >> l), -PYRAMID_BORDER - col);
+    const int col_max = AOMMIN(
+        x->mv_col_max >> l, ref->pyramid_width[l] + PYRAMID_BORDER - bw - col);
+    const int range =
+        l == levels ? PYRAMID_SEARCH_RANGE : PYRAMID_REFINE_RANGE;
+    unsigned int best_cost = UINT_MAX;
+    MV center, mv;
+
+    if (row_min > row_max || col_min > col_max) return step_param;
+    if (l == levels) {
+      center.row = mvp_full->row >> l;
+      center.col = mvp_full->col >> l;
+    } else {
+      center.row = best.row * 2;
+      center.col = best.col * 2;
+    }
+    clamp_mv(&center, col_min, col_max, row_min, row_max);
+
+    for (mv.row = AOMMAX(center.row - range, row_min);
+         mv.row <= AOMMIN(center.row + range, row_max); ++mv.row) {
+      for (mv.col = AOMMAX(center.col - range, col_min);
+           mv.col <= AOMMIN(center.col + range, col_max); ++mv.col) {
+        // The sad is scaled to full resolution to be weighed against the
+        // cost of the vector.
+        const MV full_mv = { mv.row * (1 << l), mv.col * (1 << l) };
+        const unsigned int cost =
+            (sdf(src_buf, src_stride, ref_buf + mv.row * ref_stride + mv.col,
+                 ref_stride)
+             << (2 * l)) +
+            mvsad_err_cost(x, &full_mv, &ref_mv_full, sadpb);
+        if (cost < best_cost) {
+          best_cost = cost;
+          best = mv;
+        }
+      }
+    }
+  }
+
+  mvp_full->row = best.row * 2;
+  mvp_full->col = best.col * 2;
+  clamp_mv(mvp_full, x->mv_col_min, x->mv_col_max, x->mv_row_min,
+           x->mv_row_max);
+  return AOMMAX(step_param, PYRAMID_STEP_PARAM);
+}
+
 #if CONFIG_EXT_INTER
 /* returns subpixel variance error function */
 #define DIST(r, c)                                                         \
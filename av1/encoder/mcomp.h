@@ -119,6 +119,25 @@ int av1_full_pixel_search(const struct AV1_COMP *cpi, MACROBLOCK *x,
                           int error_per_bit, int *cost_list, const MV *ref_mv,
                           int var_max, int rd);
 
+// Border around each level of a frame pyramid, so that the blocks at the
+// edges of the frame can be searched.
+#define PYRAMID_BORDER 32
+
+// Makes the downsampled levels of the luma plane of a frame used by the
+// pyramid search, unless they are cached with the frame already. Returns 0
+// if memory could not be allocated.
+int av1_build_frame_pyramid(YV12_BUFFER_CONFIG *frm, int levels, int bd);
+
+// Searches for the motion of a block from the coarsest level of the frame
+// pyramids down to half resolution, and moves mvp_full to the vector found.
+// Returns the step parameter for the full resolution search that refines
+// it, which is step_param if the block cannot be searched this way.
+int av1_pyramid_motion_search(const struct AV1_COMP *cpi, MACROBLOCK *x,
+                              BLOCK_SIZE bsize, int mi_row, int mi_col,
+                              const YV12_BUFFER_CONFIG *src,
+                              const YV12_BUFFER_CONFIG *ref, MV *mvp_full,
+                              int sadpb, const MV *ref_mv, int step_param);
+
 #if CONFIG_EXT_INTER
 int av1_find_best_masked_sub_pixel_tree(
     const MACROBLOCK *x, const uint8_t *mask, int mask_stride, MV *bestmv,
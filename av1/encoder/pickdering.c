@@ -13,149 +13,180 @@
 #include <math.h>
 
 #include "./aom_scale_rtcd.h"
+#include "./av1_rtcd.h"
 #include "av1/common/dering.h"
 #include "av1/common/onyxc_int.h"
 #include "av1/common/reconinter.h"
 #include "av1/encoder/encoder.h"
+#include "av1/encoder/ethread.h"
+#include "av1/encoder/pickdering.h"
 #include "aom/aom_integer.h"
 
-static double compute_dist(int16_t *x, int xstride, int16_t *y, int ystride,
-                           int nhb, int nvb, int coeff_shift) {
+typedef struct {
+  AV1_COMP *cpi;
+  const YV12_BUFFER_CONFIG *frame;
+  const YV12_BUFFER_CONFIG *ref;
+  int nvsb;
+  int nhsb;
+  int best_level;
+} DeringSearch;
+
+uint32_t av1_dering_sse_8x8_c(const int16_t *a, int a_stride, const int16_t *b,
+                              int b_stride) {
+  uint32_t sse = 0;
   int i, j;
-  double sum;
-  sum = 0;
-  for (i = 0; i < nvb << 3; i++) {
-    for (j = 0; j < nhb << 3; j++) {
-      double tmp;
-      tmp = x[i * xstride + j] - y[i * ystride + j];
-      sum += tmp * tmp;
+  for (i = 0; i < 8; i++) {
+    for (j = 0; j < 8; j++) {
+      const int diff = a[i * a_stride + j] - b[i * b_stride + j];
+      sse += diff * diff;
     }
   }
-  return sum / (double)(1 << 2 * coeff_shift);
+  return sse;
 }
 
-int av1_dering_search(YV12_BUFFER_CONFIG *frame, const YV12_BUFFER_CONFIG *ref,
-                      AV1_COMMON *cm, MACROBLOCKD *xd) {
-  int r, c;
-  int sbr, sbc;
-  int nhsb, nvsb;
-  int16_t *src;
-  int16_t *ref_coeff;
-  dering_list dlist[MAX_MIB_SIZE * MAX_MIB_SIZE];
-  int dir[OD_DERING_NBLOCKS][OD_DERING_NBLOCKS] = { { 0 } };
-  int stride;
-  int bsize[3];
-  int dec[3];
-  int pli;
-  int level;
-  int best_level;
-  int dering_count;
-  int coeff_shift = AOMMAX(cm->bit_depth - 8, 0);
-  src = aom_malloc(sizeof(*src) * cm->mi_rows * cm->mi_cols * 64);
-  ref_coeff = aom_malloc(sizeof(*ref_coeff) * cm->mi_rows * cm->mi_cols * 64);
-  av1_setup_dst_planes(xd->plane, frame, 0, 0);
-  for (pli = 0; pli < 3; pli++) {
-    dec[pli] = xd->plane[pli].subsampling_x;
-    bsize[pli] = OD_DERING_SIZE_LOG2 - dec[pli];
-  }
-  stride = cm->mi_cols << bsize[0];
-  for (r = 0; r < cm->mi_rows << bsize[0]; ++r) {
-    for (c = 0; c < cm->mi_cols << bsize[0]; ++c) {
+/* Copies vsize rows of hsize luma pixels, from row r and column c of buf. */
+static void copy_luma_16bit(const AV1_COMMON *cm, int16_t *dst, int dstride,
+                            const YV12_BUFFER_CONFIG *buf, int r, int c,
+                            int vsize, int hsize) {
+  int i, j;
 #if CONFIG_AOM_HIGHBITDEPTH
-      if (cm->use_highbitdepth) {
-        src[r * stride + c] = CONVERT_TO_SHORTPTR(
-            xd->plane[0].dst.buf)[r * xd->plane[0].dst.stride + c];
-        ref_coeff[r * stride + c] =
-            CONVERT_TO_SHORTPTR(ref->y_buffer)[r * ref->y_stride + c];
-      } else {
+  if (cm->use_highbitdepth) {
+    const uint16_t *src =
+        CONVERT_TO_SHORTPTR(buf->y_buffer) + r * buf->y_stride + c;
+    for (i = 0; i < vsize; i++)
+      memcpy(dst + i * dstride, src + i * buf->y_stride, hsize * sizeof(*dst));
+    return;
+  }
+#else
+  (void)cm;
 #endif
-        src[r * stride + c] =
-            xd->plane[0].dst.buf[r * xd->plane[0].dst.stride + c];
-        ref_coeff[r * stride + c] = ref->y_buffer[r * ref->y_stride + c];
-#if CONFIG_AOM_HIGHBITDEPTH
+  {
+    const uint8_t *src = buf->y_buffer + r * buf->y_stride + c;
+    for (i = 0; i < vsize; i++) {
+      for (j = 0; j < hsize; j++) {
+        dst[i * dstride + j] = src[i * buf->y_stride + j];
       }
-#endif
     }
   }
-  nvsb = (cm->mi_rows + MAX_MIB_SIZE - 1) / MAX_MIB_SIZE;
-  nhsb = (cm->mi_cols + MAX_MIB_SIZE - 1) / MAX_MIB_SIZE;
+}
+
+static void dering_search_sb(const DeringSearch *s, int sbr, int sbc) {
+  AV1_COMMON *const cm = &s->cpi->common;
+  const int coeff_shift = AOMMAX(cm->bit_depth - 8, 0);
+  const int rstride = OD_BSIZE_MAX;
+  int16_t inbuf[OD_DERING_INBUF_SIZE];
+  int16_t filtbuf[OD_DERING_INBUF_SIZE];
+  int16_t ref_coeff[OD_BSIZE_MAX * OD_BSIZE_MAX];
+  int16_t dst[MAX_MIB_SIZE * MAX_MIB_SIZE * 8 * 8];
+  int16_t *const in =
+      inbuf + OD_FILT_VBORDER * OD_FILT_BSTRIDE + OD_FILT_HBORDER;
+  dering_list dlist[MAX_MIB_SIZE * MAX_MIB_SIZE];
+  int dir[OD_DERING_NBLOCKS][OD_DERING_NBLOCKS] = { { 0 } };
+  int32_t var[OD_DERING_NBLOCKS][OD_DERING_NBLOCKS];
+  uint32_t block_sse[MAX_MIB_SIZE][MAX_MIB_SIZE];
+  uint64_t skip_sse = 0;
+  int32_t best_mse = INT32_MAX;
+  int best_gi = 0;
+  int dering_count, nhb, nvb, rstart, rend, cstart, cend;
+  int r, c, i, gi;
+
+  nhb = AOMMIN(MAX_MIB_SIZE, cm->mi_cols - MAX_MIB_SIZE * sbc);
+  nvb = AOMMIN(MAX_MIB_SIZE, cm->mi_rows - MAX_MIB_SIZE * sbr);
+  dering_count =
+      sb_compute_dering_list(cm, sbr * MAX_MIB_SIZE, sbc * MAX_MIB_SIZE, dlist);
+  if (dering_count == 0) return;
+
+  /* We avoid filtering the pixels for which some of the pixels to average
+     are outside the frame. We could change the filter instead, but it would
+     add special cases for any future vectorization. */
+  for (i = 0; i < OD_DERING_INBUF_SIZE; i++) inbuf[i] = OD_DERING_VERY_LARGE;
+  rstart = -OD_FILT_VBORDER * (sbr != 0);
+  rend = (nvb << 3) + OD_FILT_VBORDER * (sbr != s->nvsb - 1);
+  cstart = -OD_FILT_HBORDER * (sbc != 0);
+  cend = (nhb << 3) + OD_FILT_HBORDER * (sbc != s->nhsb - 1);
+  copy_luma_16bit(cm, in + rstart * OD_FILT_BSTRIDE + cstart, OD_FILT_BSTRIDE,
+                  s->frame, (sbr * MAX_MIB_SIZE << 3) + rstart,
+                  (sbc * MAX_MIB_SIZE << 3) + cstart, rend - rstart,
+                  cend - cstart);
+  copy_luma_16bit(cm, ref_coeff, rstride, s->ref, sbr * MAX_MIB_SIZE << 3,
+                  sbc * MAX_MIB_SIZE << 3, nvb << 3, nhb << 3);
+
+  /* The blocks that are not deringed have the same error at every level,
+     and the directions of those that are do not depend on the level, so
+     both are found once for the superblock. */
+  for (r = 0; r < nvb; r++) {
+    for (c = 0; c < nhb; c++) {
+      block_sse[r][c] = av1_dering_sse_8x8(
+          &in[(r << 3) * OD_FILT_BSTRIDE + (c << 3)], OD_FILT_BSTRIDE,
+          &ref_coeff[(r << 3) * rstride + (c << 3)], rstride);
+      skip_sse += block_sse[r][c];
+    }
+  }
+  for (i = 0; i < dering_count; i++)
+    skip_sse -= block_sse[dlist[i].by][dlist[i].bx];
+  od_dering_find_dirs(in, dir, var, dlist, dering_count, coeff_shift);
+
+  for (gi = 0; gi < DERING_REFINEMENT_LEVELS; gi++) {
+    const int level = compute_level_from_index(s->best_level, gi);
+    uint64_t sse = skip_sse;
+    int cur_mse;
+    memcpy(filtbuf, inbuf, sizeof(inbuf));
+    od_dering_filter(dst, filtbuf + (in - inbuf), 0, dir, var, dlist,
+                     dering_count, level << coeff_shift);
+    for (i = 0; i < dering_count; i++) {
+      sse += av1_dering_sse_8x8(
+          &dst[i << 6], 8,
+          &ref_coeff[(dlist[i].by << 3) * rstride + (dlist[i].bx << 3)],
+          rstride);
+    }
+    cur_mse = (int)(sse / (double)(1 << 2 * coeff_shift));
+    if (cur_mse < best_mse) {
+      best_gi = gi;
+      best_mse = cur_mse;
+    }
+  }
+  cm->mi_grid_visible[MAX_MIB_SIZE * sbr * cm->mi_stride + MAX_MIB_SIZE * sbc]
+      ->mbmi.dering_gain = best_gi;
+}
+
+static int dering_search_worker_hook(EncWorkerData *const thread_data,
+                                     DeringSearch *s) {
+  int sbr, sbc;
+  while ((sbr = aom_job_queue_pop(&s->cpi->enc_job_queue,
+                                  thread_data->thread_id)) >= 0) {
+    for (sbc = 0; sbc < s->nhsb; sbc++) dering_search_sb(s, sbr, sbc);
+  }
+  return 1;
+}
+
+int av1_dering_search(YV12_BUFFER_CONFIG *frame, const YV12_BUFFER_CONFIG *ref,
+                      AV1_COMP *cpi) {
+  AV1_COMMON *const cm = &cpi->common;
+  DeringSearch s;
+  int sbr, sbc;
+  s.cpi = cpi;
+  s.frame = frame;
+  s.ref = ref;
+  s.nvsb = (cm->mi_rows + MAX_MIB_SIZE - 1) / MAX_MIB_SIZE;
+  s.nhsb = (cm->mi_cols + MAX_MIB_SIZE - 1) / MAX_MIB_SIZE;
   /* Pick a base threshold based on the quantizer. The threshold will then be
      adjusted on a 64x64 basis. We use a threshold of the form T = a*Q^b,
      where a and b are derived empirically trying to optimize rate-distortion
      at different quantizer settings. */
-  best_level = AOMMIN(
+  s.best_level = AOMMIN(
       MAX_DERING_LEVEL - 1,
       (int)floor(.5 +
                  .45 * pow(av1_ac_quant(cm->base_qindex, 0, cm->bit_depth) >>
                                (cm->bit_depth - 8),
                            0.6)));
-  for (sbr = 0; sbr < nvsb; sbr++) {
-    for (sbc = 0; sbc < nhsb; sbc++) {
-      int nvb, nhb;
-      int gi;
-      int best_gi;
-      int32_t best_mse = INT32_MAX;
-      int16_t dst[MAX_MIB_SIZE * MAX_MIB_SIZE * 8 * 8];
-      int16_t tmp_dst[MAX_MIB_SIZE * MAX_MIB_SIZE * 8 * 8];
-      nhb = AOMMIN(MAX_MIB_SIZE, cm->mi_cols - MAX_MIB_SIZE * sbc);
-      nvb = AOMMIN(MAX_MIB_SIZE, cm->mi_rows - MAX_MIB_SIZE * sbr);
-      dering_count = sb_compute_dering_list(cm, sbr * MAX_MIB_SIZE,
-                                            sbc * MAX_MIB_SIZE, dlist);
-      if (dering_count == 0) continue;
-      best_gi = 0;
-      for (gi = 0; gi < DERING_REFINEMENT_LEVELS; gi++) {
-        int cur_mse;
-        int threshold;
-        int16_t inbuf[OD_DERING_INBUF_SIZE];
-        int16_t *in;
-        int i, j;
-        level = compute_level_from_index(best_level, gi);
-        threshold = level << coeff_shift;
-        for (r = 0; r < nvb << bsize[0]; r++) {
-          for (c = 0; c < nhb << bsize[0]; c++) {
-            dst[(r * MAX_MIB_SIZE << bsize[0]) + c] =
-                src[((sbr * MAX_MIB_SIZE << bsize[0]) + r) * stride +
-                    (sbc * MAX_MIB_SIZE << bsize[0]) + c];
-          }
-        }
-        in = inbuf + OD_FILT_VBORDER * OD_FILT_BSTRIDE + OD_FILT_HBORDER;
-        /* We avoid filtering the pixels for which some of the pixels to average
-           are outside the frame. We could change the filter instead, but it
-           would
-           add special cases for any future vectorization. */
-        for (i = 0; i < OD_DERING_INBUF_SIZE; i++)
-          inbuf[i] = OD_DERING_VERY_LARGE;
-        for (i = -OD_FILT_VBORDER * (sbr != 0);
-             i < (nvb << bsize[0]) + OD_FILT_VBORDER * (sbr != nvsb - 1); i++) {
-          for (j = -OD_FILT_HBORDER * (sbc != 0);
-               j < (nhb << bsize[0]) + OD_FILT_HBORDER * (sbc != nhsb - 1);
-               j++) {
-            int16_t *x;
-            x = &src[(sbr * stride * MAX_MIB_SIZE << bsize[0]) +
-                     (sbc * MAX_MIB_SIZE << bsize[0])];
-            in[i * OD_FILT_BSTRIDE + j] = x[i * stride + j];
-          }
-        }
-        od_dering(tmp_dst, in, 0, dir, 0, dlist, dering_count, threshold,
-                  coeff_shift);
-        copy_dering_16bit_to_16bit(dst, MAX_MIB_SIZE << bsize[0], tmp_dst,
-                                   dlist, dering_count, bsize[0]);
-        cur_mse = (int)compute_dist(
-            dst, MAX_MIB_SIZE << bsize[0],
-            &ref_coeff[(sbr * stride * MAX_MIB_SIZE << bsize[0]) +
-                       (sbc * MAX_MIB_SIZE << bsize[0])],
-            stride, nhb, nvb, coeff_shift);
-        if (cur_mse < best_mse) {
-          best_gi = gi;
-          best_mse = cur_mse;
-        }
-      }
-      cm->mi_grid_visible[MAX_MIB_SIZE * sbr * cm->mi_stride +
-                          MAX_MIB_SIZE * sbc]
-          ->mbmi.dering_gain = best_gi;
-    }
+  /* The superblocks are searched independently, so the rows of superblocks
+     can be shared among the encoder workers. */
+  if (cpi->oxcf.max_threads > 1 && s.nvsb > 1) {
+    av1_enc_run_jobs(cpi, (AVxWorkerHook)dering_search_worker_hook, &s,
+                     s.nvsb);
+  } else {
+    for (sbr = 0; sbr < s.nvsb; sbr++)
+      for (sbc = 0; sbc < s.nhsb; sbc++) dering_search_sb(&s, sbr, sbc);
   }
-  aom_free(src);
-  aom_free(ref_coeff);
-  return best_level;
+  return s.best_level;
 }
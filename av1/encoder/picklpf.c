@@ -24,6 +24,7 @@
 #include "av1/common/quant_common.h"
 
 #include "av1/encoder/encoder.h"
+#include "av1/encoder/ethread.h"
 #include "av1/encoder/picklpf.h"
 #include "av1/encoder/quantize.h"
 
@@ -71,6 +72,343 @@ static int64_t try_filter_frame(const YV12_BUFFER_CONFIG *sd,
   return filt_err;
 }
 
+#if CONFIG_VAR_TX || CONFIG_EXT_PARTITION || CONFIG_EXT_PARTITION_TYPES
+typedef struct {
+  const YV12_BUFFER_CONFIG *sd;
+  AV1_COMP *cpi;
+  int partial_frame;
+} LpfSearch;
+
+static void lpf_search_init(LpfSearch *s, const YV12_BUFFER_CONFIG *sd,
+                            AV1_COMP *cpi, int partial_frame) {
+  s->sd = sd;
+  s->cpi = cpi;
+  s->partial_frame = partial_frame;
+  //  Make a copy of the unfiltered / processed recon buffer
+  aom_yv12_copy_y(cpi->common.frame_to_show, &cpi->last_frame_uf);
+}
+
+static void lpf_search_free(LpfSearch *s) { (void)s; }
+
+static void try_filter_levels(LpfSearch *s, const int *levels, int num_levels,
+                              int64_t *ss_err) {
+  int i;
+  for (i = 0; i < num_levels; ++i)
+    ss_err[levels[i]] =
+        try_filter_frame(s->sd, s->cpi, levels[i], s->partial_frame);
+}
+#else
+// The filter levels are tried on copies of the rows of superblocks, in
+// strips of LPF_MARGIN rows from the strip above followed by one row of
+// superblocks, and the frame itself is left unfiltered. Once a strip has been
+// filtered, only its last LPF_MARGIN rows can still be changed by the
+// superblocks below, so the rows above them are measured at once.
+#define LPF_MARGIN MI_SIZE
+#define LPF_BORDER 16
+#define LPF_STRIP_HEIGHT (LPF_MARGIN + MAX_MIB_SIZE * MI_SIZE)
+// The most levels tried together, the first step of the search.
+#define LPF_MAX_LEVELS 3
+
+typedef struct {
+  int level;
+  // The loop filter levels of the blocks, as set up by
+  // av1_loop_filter_frame_init() for this level.
+  uint8_t lvl[MAX_SEGMENTS * TOTAL_REFS_PER_FRAME * MAX_MODE_LF_DELTAS];
+  uint8_t *strip;
+  int64_t sse;
+} LpfSearchLevel;
+
+typedef struct {
+  const YV12_BUFFER_CONFIG *sd;
+  AV1_COMP *cpi;
+  int partial_frame;
+  // Rows of superblocks that the loop filter is run on.
+  int start_sb_row;
+  int end_sb_row;
+  int sb_cols;
+  int strip_stride;
+  // The masks of the filtered superblocks, built with every entry of the
+  // level table set to one more than its index. lfl_y thus holds which entry
+  // each block is filtered with, and the masks of a level are the bits of the
+  // blocks whose entries are not zero.
+  LOOP_FILTER_MASK *masks;
+  // The error of the rows the loop filter does not change, and of the whole
+  // frame without filtering.
+  int64_t unchanged_sse;
+  int64_t unfiltered_sse;
+  LpfSearchLevel levels[LPF_MAX_LEVELS];
+} LpfSearch;
+
+static uint8_t *strip_row(const LpfSearch *s, const LpfSearchLevel *lv,
+                          int row) {
+#if CONFIG_AOM_HIGHBITDEPTH
+  if (s->cpi->common.use_highbitdepth)
+    return CONVERT_TO_BYTEPTR((uint16_t *)lv->strip + row * s->strip_stride +
+                              LPF_BORDER);
+#endif  // CONFIG_AOM_HIGHBITDEPTH
+  return lv->strip + row * s->strip_stride + LPF_BORDER;
+}
+
+static void copy_rows(const LpfSearch *s, uint8_t *dst, int dst_stride,
+                      const uint8_t *src, int src_stride, int rows) {
+  const int width = s->cpi->common.mi_cols * MI_SIZE;
+  int i;
+#if CONFIG_AOM_HIGHBITDEPTH
+  if (s->cpi->common.use_highbitdepth) {
+    for (i = 0; i < rows; ++i)
+      memcpy(CONVERT_TO_SHORTPTR(dst + i * dst_stride),
+             CONVERT_TO_SHORTPTR(src + i * src_stride),
+             width * sizeof(uint16_t));
+    return;
+  }
+#endif  // CONFIG_AOM_HIGHBITDEPTH
+  for (i = 0; i < rows; ++i)
+    memcpy(dst + i * dst_stride, src + i * src_stride, width);
+}
+
+// Returns the error against the source of |rows| rows, from frame row |row|,
+// with the reconstruction read from |recon|.
+static int64_t get_rows_sse(const LpfSearch *s, int row, const uint8_t *recon,
+                            int recon_stride, int rows) {
+  const YV12_BUFFER_CONFIG *const sd = s->sd;
+  rows = AOMMIN(rows, sd->y_crop_height - row);
+  if (rows <= 0) return 0;
+#if CONFIG_AOM_HIGHBITDEPTH
+  if (s->cpi->common.use_highbitdepth)
+    return aom_highbd_get_sse(sd->y_buffer + row * sd->y_stride, sd->y_stride,
+                              recon, recon_stride, sd->y_crop_width, rows);
+#endif  // CONFIG_AOM_HIGHBITDEPTH
+  return aom_get_sse(sd->y_buffer + row * sd->y_stride, sd->y_stride, recon,
+                     recon_stride, sd->y_crop_width, rows);
+}
+
+// Sets up the masks of a superblock for the level table |lvl|.
+static void get_level_mask(const LOOP_FILTER_MASK *entries, const uint8_t *lvl,
+                           LOOP_FILTER_MASK *lfm) {
+  uint64_t filtered = 0;
+  int r, c, i;
+  for (r = 0; r < MAX_MIB_SIZE; ++r) {
+    for (c = 0; c < MAX_MIB_SIZE; ++c) {
+      const int entry = entries->lfl_y[r][c];
+      lfm->lfl_y[r][c] = entry ? lvl[entry - 1] : 0;
+      if (lfm->lfl_y[r][c])
+        filtered |= (uint64_t)1 << ((r << MAX_MIB_SIZE_LOG2) + c);
+    }
+  }
+  for (i = 0; i < TX_SIZES; ++i) {
+    lfm->left_y[i] = entries->left_y[i] & filtered;
+    lfm->above_y[i] = entries->above_y[i] & filtered;
+  }
+  lfm->int_4x4_y = entries->int_4x4_y & filtered;
+}
+
+static void filter_sb(LpfSearch *s, LpfSearchLevel *lv, int sb_row,
+                      int sb_col, int horizontal) {
+  AV1_COMMON *const cm = &s->cpi->common;
+  struct macroblockd_plane plane;
+  LOOP_FILTER_MASK lfm;
+  get_level_mask(&s->masks[(sb_row - s->start_sb_row) * s->sb_cols + sb_col],
+                 lv->lvl, &lfm);
+  memset(&plane, 0, sizeof(plane));
+  plane.dst.buf =
+      strip_row(s, lv, LPF_MARGIN) + sb_col * MAX_MIB_SIZE * MI_SIZE;
+  plane.dst.stride = s->strip_stride;
+  if (horizontal)
+    av1_filter_block_plane_ss00_hor(cm, &plane, sb_row << MAX_MIB_SIZE_LOG2,
+                                    &lfm);
+  else
+    av1_filter_block_plane_ss00_ver(cm, &plane, sb_row << MAX_MIB_SIZE_LOG2,
+                                    &lfm);
+}
+
+// Filters the frame with levels |first| to |first| + |num_levels| - 1 of the
+// search and measures their errors, one strip at a time.
+static void filter_levels(LpfSearch *s, int first, int num_levels) {
+  const AV1_COMMON *const cm = &s->cpi->common;
+  const YV12_BUFFER_CONFIG *const frame = cm->frame_to_show;
+  const int stride = s->strip_stride;
+  int sb_row, sb_col, i;
+
+  for (i = first; i < first + num_levels; ++i)
+    s->levels[i].sse = s->unchanged_sse;
+
+  for (sb_row = s->start_sb_row; sb_row < s->end_sb_row; ++sb_row) {
+    const int row = sb_row * MAX_MIB_SIZE * MI_SIZE;
+    const int rows =
+        AOMMIN(cm->mi_rows - (sb_row << MAX_MIB_SIZE_LOG2), MAX_MIB_SIZE) *
+        MI_SIZE;
+    const int margin = sb_row > 0 ? LPF_MARGIN : 0;
+    const int last = sb_row == s->end_sb_row - 1;
+
+    for (i = first; i < first + num_levels; ++i) {
+      LpfSearchLevel *const lv = &s->levels[i];
+      if (sb_row == s->start_sb_row)
+        copy_rows(s, strip_row(s, lv, LPF_MARGIN - margin), stride,
+                  frame->y_buffer + (row - margin) * frame->y_stride,
+                  frame->y_stride, margin);
+      else
+        copy_rows(s, strip_row(s, lv, 0), stride,
+                  strip_row(s, lv, LPF_STRIP_HEIGHT - LPF_MARGIN), stride,
+                  LPF_MARGIN);
+      copy_rows(s, strip_row(s, lv, LPF_MARGIN), stride,
+                frame->y_buffer + row * frame->y_stride, frame->y_stride, rows);
+    }
+
+#if CONFIG_PARALLEL_DEBLOCKING
+    for (sb_col = 0; sb_col < s->sb_cols; ++sb_col)
+      for (i = first; i < first + num_levels; ++i)
+        filter_sb(s, &s->levels[i], sb_row, sb_col, 0);
+    for (sb_col = 0; sb_col < s->sb_cols; ++sb_col)
+      for (i = first; i < first + num_levels; ++i)
+        filter_sb(s, &s->levels[i], sb_row, sb_col, 1);
+#else
+    for (sb_col = 0; sb_col < s->sb_cols; ++sb_col) {
+      for (i = first; i < first + num_levels; ++i) {
+        filter_sb(s, &s->levels[i], sb_row, sb_col, 0);
+        filter_sb(s, &s->levels[i], sb_row, sb_col, 1);
+      }
+    }
+#endif  // CONFIG_PARALLEL_DEBLOCKING
+
+    for (i = first; i < first + num_levels; ++i) {
+      LpfSearchLevel *const lv = &s->levels[i];
+      lv->sse +=
+          get_rows_sse(s, row - margin, strip_row(s, lv, LPF_MARGIN - margin),
+                       stride, margin + rows - (last ? 0 : LPF_MARGIN));
+    }
+  }
+}
+
+static int lpf_search_worker_hook(EncWorkerData *const thread_data,
+                                  LpfSearch *s) {
+  int job;
+  while ((job = aom_job_queue_pop(&s->cpi->enc_job_queue,
+                                  thread_data->thread_id)) >= 0)
+    filter_levels(s, job, 1);
+  return 1;
+}
+
+static void lpf_search_init(LpfSearch *s, const YV12_BUFFER_CONFIG *sd,
+                            AV1_COMP *cpi, int partial_frame) {
+  AV1_COMMON *const cm = &cpi->common;
+  loop_filter_info_n *const lfi = &cm->lf_info;
+  const YV12_BUFFER_CONFIG *const frame = cm->frame_to_show;
+#if CONFIG_AOM_HIGHBITDEPTH
+  const int pixel_size = cm->use_highbitdepth ? 2 : 1;
+#else
+  const int pixel_size = 1;
+#endif  // CONFIG_AOM_HIGHBITDEPTH
+  uint8_t saved_lvl[sizeof(lfi->lvl)];
+  int start_mi_row = 0, end_mi_row = cm->mi_rows;
+  int first_row, end_row, sb_row, sb_col, i;
+
+  av1_zero(*s);
+  s->sd = sd;
+  s->cpi = cpi;
+  s->partial_frame = partial_frame;
+
+  // The rows of superblocks are chosen as in av1_loop_filter_frame().
+  if (partial_frame && cm->mi_rows > 8) {
+    start_mi_row = (cm->mi_rows >> 1) & 0xfffffff8;
+    end_mi_row = start_mi_row + AOMMAX(cm->mi_rows / 8, 8);
+  }
+  s->start_sb_row = start_mi_row >> MAX_MIB_SIZE_LOG2;
+  s->end_sb_row = (end_mi_row + MAX_MIB_SIZE - 1) >> MAX_MIB_SIZE_LOG2;
+  s->sb_cols = (cm->mi_cols + MAX_MIB_SIZE - 1) >> MAX_MIB_SIZE_LOG2;
+  s->strip_stride = ALIGN_POWER_OF_TWO(cm->mi_cols * MI_SIZE, 4) +
+                    2 * LPF_BORDER;
+
+  first_row = s->start_sb_row > 0
+                  ? s->start_sb_row * MAX_MIB_SIZE * MI_SIZE - LPF_MARGIN
+                  : 0;
+  end_row = AOMMIN(s->end_sb_row * MAX_MIB_SIZE, cm->mi_rows) * MI_SIZE;
+  s->unchanged_sse =
+      get_rows_sse(s, 0, frame->y_buffer, frame->y_stride, first_row) +
+      get_rows_sse(s, end_row, frame->y_buffer + end_row * frame->y_stride,
+                   frame->y_stride, sd->y_crop_height - end_row);
+  s->unfiltered_sse =
+      s->unchanged_sse +
+      get_rows_sse(s, first_row, frame->y_buffer + first_row * frame->y_stride,
+                   frame->y_stride, end_row - first_row);
+
+  CHECK_MEM_ERROR(cm, s->masks,
+                  aom_malloc((s->end_sb_row - s->start_sb_row) * s->sb_cols *
+                             sizeof(*s->masks)));
+  for (i = 0; i < LPF_MAX_LEVELS; ++i)
+    CHECK_MEM_ERROR(
+        cm, s->levels[i].strip,
+        aom_calloc(LPF_STRIP_HEIGHT * s->strip_stride, pixel_size));
+
+  // The masks only depend on the levels through which blocks are filtered,
+  // so they are built once for all the levels.
+  assert(sizeof(lfi->lvl) < 256);
+  memcpy(saved_lvl, lfi->lvl, sizeof(lfi->lvl));
+  for (i = 0; i < (int)sizeof(lfi->lvl); ++i)
+    ((uint8_t *)lfi->lvl)[i] = i + 1;
+  for (sb_row = s->start_sb_row; sb_row < s->end_sb_row; ++sb_row) {
+    const int mi_row = sb_row << MAX_MIB_SIZE_LOG2;
+    MODE_INFO **mi = cm->mi_grid_visible + mi_row * cm->mi_stride;
+    for (sb_col = 0; sb_col < s->sb_cols; ++sb_col) {
+      const int mi_col = sb_col << MAX_MIB_SIZE_LOG2;
+      av1_setup_mask(cm, mi_row, mi_col, mi + mi_col, cm->mi_stride,
+                     &s->masks[(sb_row - s->start_sb_row) * s->sb_cols +
+                               sb_col]);
+    }
+  }
+  memcpy(lfi->lvl, saved_lvl, sizeof(lfi->lvl));
+}
+
+static void lpf_search_free(LpfSearch *s) {
+  int i;
+  for (i = 0; i < LPF_MAX_LEVELS; ++i) aom_free(s->levels[i].strip);
+  aom_free(s->masks);
+}
+
+// Sets ss_err[] of each of |levels|. They are filtered together, on the
+// encoder workers when there are several threads.
+static void try_filter_levels(LpfSearch *s, const int *levels, int num_levels,
+                              int64_t *ss_err) {
+  AV1_COMP *const cpi = s->cpi;
+  AV1_COMMON *const cm = &cpi->common;
+  int i, n = 0;
+
+  assert(num_levels <= LPF_MAX_LEVELS);
+  for (i = 0; i < num_levels; ++i) {
+    if (levels[i] == 0) {
+      ss_err[0] = s->unfiltered_sse;
+      continue;
+    }
+    av1_loop_filter_frame_init(cm, levels[i]);
+    s->levels[n].level = levels[i];
+    memcpy(s->levels[n].lvl, cm->lf_info.lvl, sizeof(s->levels[n].lvl));
+    ++n;
+  }
+  if (n == 0) return;
+
+  if (cpi->oxcf.max_threads > 1 && n > 1)
+    av1_enc_run_jobs(cpi, (AVxWorkerHook)lpf_search_worker_hook, s, n);
+  else
+    filter_levels(s, 0, n);
+
+  for (i = 0; i < n; ++i) ss_err[s->levels[i].level] = s->levels[i].sse;
+}
+#endif  // CONFIG_VAR_TX || CONFIG_EXT_PARTITION || CONFIG_EXT_PARTITION_TYPES
+
+void av1_try_filter_levels(const YV12_BUFFER_CONFIG *sd, AV1_COMP *cpi,
+                           int partial_frame, const int *levels,
+                           int num_levels, int64_t *ss_err) {
+  LpfSearch search;
+  lpf_search_init(&search, sd, cpi, partial_frame);
+  try_filter_levels(&search, levels, num_levels, ss_err);
+  lpf_search_free(&search);
+}
+
+int64_t av1_try_filter_frame(const YV12_BUFFER_CONFIG *sd, AV1_COMP *cpi,
+                             int filt_level, int partial_frame) {
+  aom_yv12_copy_y(cpi->common.frame_to_show, &cpi->last_frame_uf);
+  return try_filter_frame(sd, cpi, filt_level, partial_frame);
+}
+
 int av1_search_filter_level(const YV12_BUFFER_CONFIG *sd, AV1_COMP *cpi,
                             int partial_frame, double *best_cost_ret) {
   const AV1_COMMON *const cm = &cpi->common;
@@ -88,16 +426,26 @@ int av1_search_filter_level(const YV12_BUFFER_CONFIG *sd, AV1_COMP *cpi,
   int filter_step = filt_mid < 16 ? 4 : filt_mid / 4;
   // Sum squared error at each filter level
   int64_t ss_err[MAX_LOOP_FILTER + 1];
+  LpfSearch search;
 
   // Set each entry to -1
   memset(ss_err, 0xFF, sizeof(ss_err));
 
-  //  Make a copy of the unfiltered / processed recon buffer
-  aom_yv12_copy_y(cm->frame_to_show, &cpi->last_frame_uf);
+  lpf_search_init(&search, sd, cpi, partial_frame);
 
-  best_err = try_filter_frame(sd, cpi, filt_mid, partial_frame);
+  // The first step needs both of its neighbours, so they are filtered with
+  // the starting level.
+  {
+    int levels[3], num_levels = 0;
+    const int filt_high = AOMMIN(filt_mid + filter_step, max_filter_level);
+    const int filt_low = AOMMAX(filt_mid - filter_step, min_filter_level);
+    levels[num_levels++] = filt_mid;
+    if (filt_low != filt_mid) levels[num_levels++] = filt_low;
+    if (filt_high != filt_mid) levels[num_levels++] = filt_high;
+    try_filter_levels(&search, levels, num_levels, ss_err);
+  }
+  best_err = ss_err[filt_mid];
   filt_best = filt_mid;
-  ss_err[filt_mid] = best_err;
 
   while (filter_step > 0) {
     const int filt_high = AOMMIN(filt_mid + filter_step, max_filter_level);
@@ -112,11 +460,17 @@ int av1_search_filter_level(const YV12_BUFFER_CONFIG *sd, AV1_COMP *cpi,
     // yx, bias less for large block size
     if (cm->tx_mode != ONLY_4X4) bias >>= 1;
 
+    // The levels this step looks at are filtered together.
+    {
+      int levels[2], num_levels = 0;
+      if (filt_direction <= 0 && filt_low != filt_mid && ss_err[filt_low] < 0)
+        levels[num_levels++] = filt_low;
+      if (filt_direction >= 0 && filt_high != filt_mid && ss_err[filt_high] < 0)
+        levels[num_levels++] = filt_high;
+      try_filter_levels(&search, levels, num_levels, ss_err);
+    }
+
     if (filt_direction <= 0 && filt_low != filt_mid) {
-      // Get Low filter error score
-      if (ss_err[filt_low] < 0) {
-        ss_err[filt_low] = try_filter_frame(sd, cpi, filt_low, partial_frame);
-      }
       // If value is close to the best so far then bias towards a lower loop
       // filter value.
       if (ss_err[filt_low] < (best_err + bias)) {
@@ -130,9 +484,6 @@ int av1_search_filter_level(const YV12_BUFFER_CONFIG *sd, AV1_COMP *cpi,
 
     // Now look at filt_high
     if (filt_direction >= 0 && filt_high != filt_mid) {
-      if (ss_err[filt_high] < 0) {
-        ss_err[filt_high] = try_filter_frame(sd, cpi, filt_high, partial_frame);
-      }
       // If value is significantly better than previous best, bias added against
       // raising filter value
       if (ss_err[filt_high] < (best_err - bias)) {
@@ -151,6 +502,8 @@ int av1_search_filter_level(const YV12_BUFFER_CONFIG *sd, AV1_COMP *cpi,
     }
   }
 
+  lpf_search_free(&search);
+
   // Update best error
   best_err = ss_err[filt_best];
 
@@ -23,6 +23,17 @@ struct AV1_COMP;
 int av1_get_max_filter_level(const AV1_COMP *cpi);
 int av1_search_filter_level(const YV12_BUFFER_CONFIG *sd, AV1_COMP *cpi,
                             int partial_frame, double *err);
+
+// Sets ss_err[] of each of |levels|, at most 3 of them, to the error of the
+// frame filtered with that level, as measured by av1_search_filter_level().
+void av1_try_filter_levels(const YV12_BUFFER_CONFIG *sd, AV1_COMP *cpi,
+                           int partial_frame, const int *levels,
+                           int num_levels, int64_t *ss_err);
+// Returns the error of the frame filtered with |filt_level| by filtering the
+// whole frame, which the errors of av1_try_filter_levels() must match.
+int64_t av1_try_filter_frame(const YV12_BUFFER_CONFIG *sd, AV1_COMP *cpi,
+                             int filt_level, int partial_frame);
+
 void av1_pick_filter_level(const struct yv12_buffer_config *sd,
                            struct AV1_COMP *cpi, LPF_PICK_METHOD method);
 #ifdef __cplusplus
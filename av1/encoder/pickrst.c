@@ -15,6 +15,7 @@
 #include <math.h>
 
 #include "./aom_scale_rtcd.h"
+#include "./av1_rtcd.h"
 
 #include "aom_dsp/psnr.h"
 #include "aom_dsp/aom_dsp_common.h"
@@ -25,60 +26,155 @@
 #include "av1/common/quant_common.h"
 
 #include "av1/encoder/encoder.h"
+#include "av1/encoder/ethread.h"
 #include "av1/encoder/picklpf.h"
 #include "av1/encoder/pickrst.h"
 #include "av1/encoder/quantize.h"
 
-typedef double (*search_restore_type)(const YV12_BUFFER_CONFIG *src,
-                                      AV1_COMP *cpi, int filter_level,
-                                      int partial_frame, RestorationInfo *info,
+// Scratch of one thread of the search, kept in AV1_COMP from frame to frame.
+// The tiles are tried on copies of the deblocked frame, so that the frame
+// itself is left as it is.
+typedef struct RestSearchThread {
+  YV12_BUFFER_CONFIG frame;
+  YV12_BUFFER_CONFIG tmp_frame;
+  // Scratch of the self-guided filter and of its search, and of the
+  // statistics of the Wiener search.
+  uint8_t *tmpbuf;
+} RestSearchThread;
+
+// The size of RestSearchThread::tmpbuf.
+#define REST_SEARCH_TMPBUF_SIZE \
+  AOMMAX(SGRPROJ_TMPBUF_SIZE, WIENER_STATS_TMPBUF_SIZE * sizeof(int16_t))
+
+typedef struct RestSearch RestSearch;
+
+typedef void (*search_tile_type)(RestSearch *s, RestSearchThread *t,
+                                 int tile_idx);
+
+struct RestSearch {
+  AV1_COMP *cpi;
+  const YV12_BUFFER_CONFIG *src;
+  int partial_frame;
+  int ntiles;
+  int tile_width, tile_height;
+  int nhtiles, nvtiles;
+  // Square error of each tile of the deblocked frame, which all the types
+  // compare their filters against.
+  int64_t *tile_sse;
+  // Square error of each tile with the filter chosen for it by the type being
+  // searched.
+  int64_t *tile_err;
+  RestSearchThread *threads;
+  int num_threads;
+  // The type being searched: the filters tried on each tile, the best ones
+  // and their cost.
+  RestorationInfo *rsi;
+  RestorationInfo *info;
+  double *best_tile_cost;
+  search_tile_type search_tile;
+  // The frame the tiles are tried on: the deblocked frame, or with the tiles
+  // searched so far filtered when the filters read their neighbours' output.
+  YV12_BUFFER_CONFIG *dgd;
+  // The tiles searched together, as set by search_tiles(), or -1 when the
+  // jobs are all the tiles.
+  int wave;
+};
+
+typedef double (*search_restore_type)(RestSearch *s, RestorationInfo *info,
                                       double *best_tile_cost);
 
 // const int frame_level_restore_bits[RESTORE_TYPES] = { 2, 2, 3, 3, 2 };
 const int frame_level_restore_bits[RESTORE_TYPES] = { 2, 3, 3, 3, 3, 2 };
 
 static int64_t sse_restoration_tile(const YV12_BUFFER_CONFIG *src,
-                                    AV1_COMMON *const cm, int h_start,
+                                    const YV12_BUFFER_CONFIG *frame,
+                                    const AV1_COMMON *const cm, int h_start,
                                     int width, int v_start, int height) {
   int64_t filt_err;
 #if CONFIG_AOM_HIGHBITDEPTH
   if (cm->use_highbitdepth) {
-    filt_err = aom_highbd_get_y_sse_part(src, cm->frame_to_show, h_start, width,
-                                         v_start, height);
+    filt_err =
+        aom_highbd_get_y_sse_part(src, frame, h_start, width, v_start, height);
   } else {
-    filt_err = aom_get_y_sse_part(src, cm->frame_to_show, h_start, width,
-                                  v_start, height);
+    filt_err = aom_get_y_sse_part(src, frame, h_start, width, v_start, height);
   }
 #else
-  filt_err = aom_get_y_sse_part(src, cm->frame_to_show, h_start, width, v_start,
-                                height);
+  (void)cm;
+  filt_err = aom_get_y_sse_part(src, frame, h_start, width, v_start, height);
 #endif  // CONFIG_AOM_HIGHBITDEPTH
   return filt_err;
 }
 
-static int64_t try_restoration_tile(const YV12_BUFFER_CONFIG *src,
-                                    AV1_COMP *const cpi, RestorationInfo *rsi,
-                                    int partial_frame, int tile_idx,
-                                    int subtile_idx, int subtile_bits) {
+static void copy_tile_region(const YV12_BUFFER_CONFIG *src,
+                             YV12_BUFFER_CONFIG *dst, const AV1_COMMON *cm,
+                             int h_start, int h_end, int v_start, int v_end) {
+  int i;
+#if CONFIG_AOM_HIGHBITDEPTH
+  if (cm->use_highbitdepth) {
+    for (i = v_start; i < v_end; ++i)
+      memcpy(CONVERT_TO_SHORTPTR(dst->y_buffer) + i * dst->y_stride + h_start,
+             CONVERT_TO_SHORTPTR(src->y_buffer) + i * src->y_stride + h_start,
+             (h_end - h_start) * sizeof(uint16_t));
+    return;
+  }
+#else
+  (void)cm;
+#endif  // CONFIG_AOM_HIGHBITDEPTH
+  for (i = v_start; i < v_end; ++i)
+    memcpy(dst->y_buffer + i * dst->y_stride + h_start,
+           src->y_buffer + i * src->y_stride + h_start, h_end - h_start);
+}
+
+// Returns the square error of a (sub)tile restored with the filters of
+// s->rsi. Only that tile may be filtered by them.
+static int64_t try_restoration_tile(RestSearch *s, RestSearchThread *t,
+                                    int tile_idx, int subtile_idx,
+                                    int subtile_bits) {
+  AV1_COMP *const cpi = s->cpi;
   AV1_COMMON *const cm = &cpi->common;
+  RestorationPlane rp;
   int64_t filt_err;
-  int tile_width, tile_height, nhtiles, nvtiles;
   int h_start, h_end, v_start, v_end;
-  const int ntiles = av1_get_rest_ntiles(cm->width, cm->height, &tile_width,
-                                         &tile_height, &nhtiles, &nvtiles);
-  (void)ntiles;
 
-  av1_loop_restoration_frame(cm->frame_to_show, cm, rsi, 1, partial_frame);
-  av1_get_rest_tile_limits(tile_idx, subtile_idx, subtile_bits, nhtiles,
-                           nvtiles, tile_width, tile_height, cm->width,
+  if (s->partial_frame) {
+    // Only the middle of the frame is restored, on a grid of its own, so the
+    // frame is filtered as a whole.
+    av1_loop_restoration_frame(cm->frame_to_show, cm, s->rsi, 1, 1);
+    av1_get_rest_tile_limits(tile_idx, subtile_idx, subtile_bits, s->nhtiles,
+                             s->nvtiles, s->tile_width, s->tile_height,
+                             cm->width, cm->height, 0, 0, &h_start, &h_end,
+                             &v_start, &v_end);
+    filt_err = sse_restoration_tile(s->src, cm->frame_to_show, cm, h_start,
+                                    h_end - h_start, v_start, v_end - v_start);
+    // Re-instate the unfiltered frame
+    aom_yv12_copy_y(&cpi->last_frame_db, cm->frame_to_show);
+    return filt_err;
+  }
+
+  // The filters read up to RESTORATION_HALFWIN pixels around the tile, and
+  // nothing else changes, so only that much of the frame is copied.
+  av1_get_rest_tile_limits(tile_idx, 0, 0, s->nhtiles, s->nvtiles,
+                           s->tile_width, s->tile_height, cm->width,
                            cm->height, 0, 0, &h_start, &h_end, &v_start,
                            &v_end);
-  filt_err = sse_restoration_tile(src, cm, h_start, h_end - h_start, v_start,
-                                  v_end - v_start);
-
-  // Re-instate the unfiltered frame
-  aom_yv12_copy_y(&cpi->last_frame_db, cm->frame_to_show);
-  return filt_err;
+  h_start = AOMMAX(h_start - RESTORATION_HALFWIN, 0);
+  h_end = AOMMIN(h_end + RESTORATION_HALFWIN, cm->width);
+  v_start = AOMMAX(v_start - RESTORATION_HALFWIN, 0);
+  v_end = AOMMIN(v_end + RESTORATION_HALFWIN, cm->height);
+  copy_tile_region(s->dgd, &t->frame, cm, h_start, h_end, v_start, v_end);
+  if (s->rsi->frame_restoration_type == RESTORE_WIENER)
+    copy_tile_region(s->dgd, &t->tmp_frame, cm, h_start, h_end, v_start,
+                     v_end);
+  av1_loop_restoration_plane_init(&rp, &t->frame, &t->tmp_frame, cm, 0, 0,
+                                  cm->mi_rows);
+  av1_loop_restoration_tile(&rp, cm, tile_idx, t->tmpbuf);
+
+  av1_get_rest_tile_limits(tile_idx, subtile_idx, subtile_bits, s->nhtiles,
+                           s->nvtiles, s->tile_width, s->tile_height, cm->width,
+                           cm->height, 0, 0, &h_start, &h_end, &v_start,
+                           &v_end);
+  return sse_restoration_tile(s->src, &t->frame, cm, h_start, h_end - h_start,
+                              v_start, v_end - v_start);
 }
 
 static int64_t try_restoration_frame(const YV12_BUFFER_CONFIG *src,
@@ -102,10 +198,93 @@ static int64_t try_restoration_frame(const YV12_BUFFER_CONFIG *src,
   return filt_err;
 }
 
-static int64_t get_pixel_proj_error(int64_t *src, int width, int height,
-                                    int src_stride, int64_t *dgd,
-                                    int dgd_stride, int64_t *flt1,
-                                    int flt1_stride, int64_t *flt2,
+// Returns the square error of the frame restored with the filters chosen for
+// its tiles. The filters of independent types only read the pixels of their
+// own tile, so then it is the sum of the errors found in the search.
+static int64_t get_frame_error(RestSearch *s, RestorationInfo *rsi,
+                               int independent) {
+  AV1_COMMON *const cm = &s->cpi->common;
+  int64_t err = 0;
+  int tile_idx;
+  if (s->partial_frame || (!independent && s->dgd != cm->frame_to_show))
+    return try_restoration_frame(s->src, s->cpi, rsi, s->partial_frame);
+  if (!independent) {
+    // The tiles have been filtered into the frame as they were searched.
+    err = sse_restoration_tile(s->src, cm->frame_to_show, cm, 0, cm->width, 0,
+                               cm->height);
+    aom_yv12_copy_y(&s->cpi->last_frame_db, cm->frame_to_show);
+    return err;
+  }
+  for (tile_idx = 0; tile_idx < s->ntiles; ++tile_idx)
+    err += s->tile_err[tile_idx];
+  return err;
+}
+
+// Returns the first tile row of s->wave.
+static int get_wave_start_row(const RestSearch *s) {
+  return AOMMAX(s->wave - s->nhtiles + 2, 0) / 2;
+}
+
+static int rest_search_worker_hook(EncWorkerData *const thread_data,
+                                   RestSearch *s) {
+  RestSearchThread *const t = &s->threads[thread_data->thread_id];
+  int job;
+  while ((job = aom_job_queue_pop(&s->cpi->enc_job_queue,
+                                  thread_data->thread_id)) >= 0) {
+    if (s->wave < 0) {
+      s->search_tile(s, t, job);
+    } else {
+      const int row = get_wave_start_row(s) + job;
+      s->search_tile(s, t, row * s->nhtiles + s->wave - 2 * row);
+    }
+  }
+  return 1;
+}
+
+// Finds the best filters of each tile for the type of rsi with search_tile,
+// on the encoder workers when there are several threads.
+//
+// With |dependent| set, each tile is tried on the frame with the tiles before
+// it in raster order filtered, and search_tile() leaves it filtered in
+// s->dgd. The filters of a tile read the pixels of the tiles to its left and
+// above, so tile (r, c) is searched after (r, c - 1) and (r - 1, c + 1), in
+// wave c + 2 * r.
+static void search_tiles(RestSearch *s, RestorationInfo *rsi,
+                         RestorationInfo *info, double *best_tile_cost,
+                         search_tile_type search_tile, int dependent) {
+  AV1_COMP *const cpi = s->cpi;
+  AV1_COMMON *const cm = &cpi->common;
+  int tile_idx;
+
+  s->rsi = rsi;
+  s->info = info;
+  s->best_tile_cost = best_tile_cost;
+  s->search_tile = search_tile;
+  s->dgd = dependent ? cm->frame_to_show : &cpi->last_frame_db;
+  s->wave = -1;
+  av1_loop_restoration_init(&cm->rst_internal, rsi,
+                            cm->frame_type == KEY_FRAME, cm->width,
+                            cm->height);
+  if (s->partial_frame || s->num_threads == 1 || s->ntiles == 1) {
+    for (tile_idx = 0; tile_idx < s->ntiles; ++tile_idx)
+      search_tile(s, &s->threads[0], tile_idx);
+  } else if (!dependent) {
+    av1_enc_run_jobs(cpi, (AVxWorkerHook)rest_search_worker_hook, s,
+                     s->ntiles);
+  } else {
+    const int waves = s->nhtiles + 2 * (s->nvtiles - 1);
+    for (s->wave = 0; s->wave < waves; ++s->wave) {
+      const int end_row = AOMMIN(s->wave / 2 + 1, s->nvtiles);
+      av1_enc_run_jobs(cpi, (AVxWorkerHook)rest_search_worker_hook, s,
+                       end_row - get_wave_start_row(s));
+    }
+  }
+}
+
+static int64_t get_pixel_proj_error(int32_t *src, int width, int height,
+                                    int src_stride, int32_t *dgd,
+                                    int dgd_stride, int32_t *flt1,
+                                    int flt1_stride, int32_t *flt2,
                                     int flt2_stride, int *xqd) {
   int i, j;
   int64_t err = 0;
@@ -113,23 +292,22 @@ static int64_t get_pixel_proj_error(int64_t *src, int width, int height,
   decode_xq(xqd, xq);
   for (i = 0; i < height; ++i) {
     for (j = 0; j < width; ++j) {
-      const int64_t s = (int64_t)src[i * src_stride + j];
-      const int64_t u = (int64_t)dgd[i * dgd_stride + j];
+      const int32_t s = src[i * src_stride + j];
+      const int64_t u = (int64_t)dgd[i * dgd_stride + j] << SGRPROJ_RST_BITS;
       const int64_t f1 = (int64_t)flt1[i * flt1_stride + j] - u;
       const int64_t f2 = (int64_t)flt2[i * flt2_stride + j] - u;
       const int64_t v = xq[0] * f1 + xq[1] * f2 + (u << SGRPROJ_PRJ_BITS);
       const int64_t e =
-          ROUND_POWER_OF_TWO(v, SGRPROJ_RST_BITS + SGRPROJ_PRJ_BITS) -
-          ROUND_POWER_OF_TWO(s, SGRPROJ_RST_BITS);
+          ROUND_POWER_OF_TWO(v, SGRPROJ_RST_BITS + SGRPROJ_PRJ_BITS) - s;
       err += e * e;
     }
   }
   return err;
 }
 
-static void get_proj_subspace(int64_t *src, int width, int height,
-                              int src_stride, int64_t *dgd, int dgd_stride,
-                              int64_t *flt1, int flt1_stride, int64_t *flt2,
+static void get_proj_subspace(int32_t *src, int width, int height,
+                              int src_stride, int32_t *dgd, int dgd_stride,
+                              int32_t *flt1, int flt1_stride, int32_t *flt2,
                               int flt2_stride, int *xq) {
   int i, j;
   double H[2][2] = { { 0, 0 }, { 0, 0 } };
@@ -142,8 +320,9 @@ static void get_proj_subspace(int64_t *src, int width, int height,
   xq[1] = (1 << SGRPROJ_PRJ_BITS) - xq[0];
   for (i = 0; i < height; ++i) {
     for (j = 0; j < width; ++j) {
-      const double u = (double)dgd[i * dgd_stride + j];
-      const double s = (double)src[i * src_stride + j] - u;
+      const double u = (double)(dgd[i * dgd_stride + j] << SGRPROJ_RST_BITS);
+      const double s =
+          (double)(src[i * src_stride + j] << SGRPROJ_RST_BITS) - u;
       const double f1 = (double)flt1[i * flt1_stride + j] - u;
       const double f2 = (double)flt2[i * flt2_stride + j] - u;
       H[0][0] += f1 * f1;
@@ -178,51 +357,52 @@ static void search_selfguided_restoration(uint8_t *dat8, int width, int height,
                                           int dat_stride, uint8_t *src8,
                                           int src_stride, int bit_depth,
                                           int *eps, int *xqd, void *tmpbuf) {
-  int64_t *flt1 = (int64_t *)tmpbuf;
-  int64_t *flt2 = flt1 + RESTORATION_TILEPELS_MAX;
-  uint8_t *tmpbuf2 = (uint8_t *)(flt2 + RESTORATION_TILEPELS_MAX);
-  int64_t srd[RESTORATION_TILEPELS_MAX];
-  int64_t dgd[RESTORATION_TILEPELS_MAX];
+  int32_t *dat = (int32_t *)tmpbuf;
+  int32_t *src = dat + RESTORATION_TILEPELS_MAX;
+  int32_t *flt1 = src + RESTORATION_TILEPELS_MAX;
+  int32_t *flt2 = flt1 + RESTORATION_TILEPELS_MAX;
+  uint32_t *sum = (uint32_t *)(flt2 + RESTORATION_TILEPELS_MAX);
+  uint32_t *sumsq = sum + SGRPROJ_INTIMG_SIZE;
+  int32_t *sgrbuf = (int32_t *)(sumsq + SGRPROJ_INTIMG_SIZE);
+  const int sum_stride = width + 2 * SGRPROJ_BORDER + 1;
   int i, j, ep, bestep = 0;
   int64_t err, besterr = -1;
   int exqd[2], bestxqd[2] = { 0, 0 };
-  for (ep = 0; ep < SGRPROJ_PARAMS; ep++) {
-    int exq[2];
-    if (bit_depth > 8) {
-      uint16_t *src = CONVERT_TO_SHORTPTR(src8);
-      uint16_t *dat = CONVERT_TO_SHORTPTR(dat8);
-      for (i = 0; i < height; ++i) {
-        for (j = 0; j < width; ++j) {
-          flt1[i * width + j] = (int64_t)dat[i * dat_stride + j];
-          flt2[i * width + j] = (int64_t)dat[i * dat_stride + j];
-          dgd[i * width + j] = (int64_t)dat[i * dat_stride + j]
-                               << SGRPROJ_RST_BITS;
-          srd[i * width + j] = (int64_t)src[i * src_stride + j]
-                               << SGRPROJ_RST_BITS;
-        }
+
+  assert(width * height <= RESTORATION_TILEPELS_MAX);
+  if (bit_depth > 8) {
+    const uint16_t *src16 = CONVERT_TO_SHORTPTR(src8);
+    const uint16_t *dat16 = CONVERT_TO_SHORTPTR(dat8);
+    for (i = 0; i < height; ++i) {
+      for (j = 0; j < width; ++j) {
+        dat[i * width + j] = dat16[i * dat_stride + j];
+        src[i * width + j] = src16[i * src_stride + j];
       }
-    } else {
-      uint8_t *src = src8;
-      uint8_t *dat = dat8;
-      for (i = 0; i < height; ++i) {
-        for (j = 0; j < width; ++j) {
-          const int k = i * width + j;
-          const int l = i * dat_stride + j;
-          flt1[k] = (int64_t)dat[l];
-          flt2[k] = (int64_t)dat[l];
-          dgd[k] = (int64_t)dat[l] << SGRPROJ_RST_BITS;
-          srd[k] = (int64_t)src[i * src_stride + j] << SGRPROJ_RST_BITS;
-        }
+    }
+  } else {
+    for (i = 0; i < height; ++i) {
+      for (j = 0; j < width; ++j) {
+        dat[i * width + j] = dat8[i * dat_stride + j];
+        src[i * width + j] = src8[i * src_stride + j];
       }
     }
-    av1_selfguided_restoration(flt1, width, height, width, bit_depth,
-                               sgr_params[ep].r1, sgr_params[ep].e1, tmpbuf2);
-    av1_selfguided_restoration(flt2, width, height, width, bit_depth,
-                               sgr_params[ep].r2, sgr_params[ep].e2, tmpbuf2);
-    get_proj_subspace(srd, width, height, width, dgd, width, flt1, width, flt2,
+  }
+  // The integral images of dat and its square are independent of the radius
+  // and eps, so they are computed once here. Each parameter set only differs
+  // in the box sums it looks up in them, for its own radii.
+  av1_integral_images(dat, width, height, width, sum, sumsq, sum_stride);
+  for (ep = 0; ep < SGRPROJ_PARAMS; ep++) {
+    int exq[2];
+    av1_selfguided_restoration(dat, width, height, width, bit_depth,
+                               sgr_params[ep].r1, sgr_params[ep].e1, sum, sumsq,
+                               sum_stride, flt1, width, sgrbuf);
+    av1_selfguided_restoration(dat, width, height, width, bit_depth,
+                               sgr_params[ep].r2, sgr_params[ep].e2, sum, sumsq,
+                               sum_stride, flt2, width, sgrbuf);
+    get_proj_subspace(src, width, height, width, dat, width, flt1, width, flt2,
                       width, exq);
     encode_xq(exq, exqd);
-    err = get_pixel_proj_error(srd, width, height, width, dgd, width, flt1,
+    err = get_pixel_proj_error(src, width, height, width, dat, width, flt1,
                                width, flt2, width, exqd);
     if (besterr == -1 || err < besterr) {
       bestep = ep;
@@ -236,26 +416,65 @@ static void search_selfguided_restoration(uint8_t *dat8, int width, int height,
   xqd[1] = bestxqd[1];
 }
 
-static double search_sgrproj(const YV12_BUFFER_CONFIG *src, AV1_COMP *cpi,
-                             int filter_level, int partial_frame,
-                             RestorationInfo *info, double *best_tile_cost) {
-  SgrprojInfo *sgrproj_info = info->sgrproj_info;
+static void search_sgrproj_tile(RestSearch *s, RestSearchThread *t,
+                                int tile_idx) {
+  SgrprojInfo *sgrproj_info = s->info->sgrproj_info;
+  SgrprojInfo *const rsi_info = &s->rsi->sgrproj_info[tile_idx];
+  const YV12_BUFFER_CONFIG *src = s->src;
   double err, cost_norestore, cost_sgrproj;
   int bits;
-  MACROBLOCK *x = &cpi->td.mb;
-  AV1_COMMON *const cm = &cpi->common;
+  MACROBLOCK *x = &s->cpi->td.mb;
+  AV1_COMMON *const cm = &s->cpi->common;
   const YV12_BUFFER_CONFIG *dgd = cm->frame_to_show;
-  RestorationInfo rsi;
-  int tile_idx, tile_width, tile_height, nhtiles, nvtiles;
   int h_start, h_end, v_start, v_end;
-  uint8_t *tmpbuf = aom_malloc(SGRPROJ_TMPBUF_SIZE);
-  const int ntiles = av1_get_rest_ntiles(cm->width, cm->height, &tile_width,
-                                         &tile_height, &nhtiles, &nvtiles);
-  //  Make a copy of the unfiltered / processed recon buffer
-  aom_yv12_copy_y(cm->frame_to_show, &cpi->last_frame_uf);
-  av1_loop_filter_frame(cm->frame_to_show, cm, &cpi->td.mb.e_mbd, filter_level,
-                        1, partial_frame);
-  aom_yv12_copy_y(cm->frame_to_show, &cpi->last_frame_db);
+
+  av1_get_rest_tile_limits(tile_idx, 0, 0, s->nhtiles, s->nvtiles,
+                           s->tile_width, s->tile_height, cm->width,
+                           cm->height, 0, 0, &h_start, &h_end, &v_start,
+                           &v_end);
+  err = (double)s->tile_sse[tile_idx];
+  s->tile_err[tile_idx] = s->tile_sse[tile_idx];
+  // #bits when a tile is not restored
+  bits = av1_cost_bit(RESTORE_NONE_SGRPROJ_PROB, 0);
+  cost_norestore = RDCOST_DBL(x->rdmult, x->rddiv, (bits >> 4), err);
+  s->best_tile_cost[tile_idx] = DBL_MAX;
+  search_selfguided_restoration(
+      dgd->y_buffer + v_start * dgd->y_stride + h_start, h_end - h_start,
+      v_end - v_start, dgd->y_stride,
+      src->y_buffer + v_start * src->y_stride + h_start, src->y_stride,
+#if CONFIG_AOM_HIGHBITDEPTH
+      cm->bit_depth,
+#else
+      8,
+#endif  // CONFIG_AOM_HIGHBITDEPTH
+      &rsi_info->ep, rsi_info->xqd, t->tmpbuf);
+  rsi_info->level = 1;
+  err = (double)try_restoration_tile(s, t, tile_idx, 0, 0);
+  bits = SGRPROJ_BITS << AV1_PROB_COST_SHIFT;
+  bits += av1_cost_bit(RESTORE_NONE_SGRPROJ_PROB, 1);
+  cost_sgrproj = RDCOST_DBL(x->rdmult, x->rddiv, (bits >> 4), err);
+  if (cost_sgrproj >= cost_norestore) {
+    sgrproj_info[tile_idx].level = 0;
+  } else {
+    memcpy(&sgrproj_info[tile_idx], rsi_info, sizeof(sgrproj_info[tile_idx]));
+    bits = SGRPROJ_BITS << AV1_PROB_COST_SHIFT;
+    s->best_tile_cost[tile_idx] = RDCOST_DBL(
+        x->rdmult, x->rddiv,
+        (bits + s->cpi->switchable_restore_cost[RESTORE_SGRPROJ]) >> 4, err);
+    s->tile_err[tile_idx] = (int64_t)err;
+  }
+  rsi_info->level = 0;
+}
+
+static double search_sgrproj(RestSearch *s, RestorationInfo *info,
+                             double *best_tile_cost) {
+  SgrprojInfo *sgrproj_info = info->sgrproj_info;
+  double err, cost_sgrproj;
+  int bits;
+  MACROBLOCK *x = &s->cpi->td.mb;
+  RestorationInfo rsi;
+  int tile_idx;
+  const int ntiles = s->ntiles;
 
   rsi.frame_restoration_type = RESTORE_SGRPROJ;
   rsi.sgrproj_info =
@@ -265,43 +484,7 @@ static double search_sgrproj(const YV12_BUFFER_CONFIG *src, AV1_COMP *cpi,
   for (tile_idx = 0; tile_idx < ntiles; ++tile_idx)
     rsi.sgrproj_info[tile_idx].level = 0;
   // Compute best Sgrproj filters for each tile
-  for (tile_idx = 0; tile_idx < ntiles; ++tile_idx) {
-    av1_get_rest_tile_limits(tile_idx, 0, 0, nhtiles, nvtiles, tile_width,
-                             tile_height, cm->width, cm->height, 0, 0, &h_start,
-                             &h_end, &v_start, &v_end);
-    err = sse_restoration_tile(src, cm, h_start, h_end - h_start, v_start,
-                               v_end - v_start);
-    // #bits when a tile is not restored
-    bits = av1_cost_bit(RESTORE_NONE_SGRPROJ_PROB, 0);
-    cost_norestore = RDCOST_DBL(x->rdmult, x->rddiv, (bits >> 4), err);
-    best_tile_cost[tile_idx] = DBL_MAX;
-    search_selfguided_restoration(
-        dgd->y_buffer + v_start * dgd->y_stride + h_start, h_end - h_start,
-        v_end - v_start, dgd->y_stride,
-        src->y_buffer + v_start * src->y_stride + h_start, src->y_stride,
-#if CONFIG_AOM_HIGHBITDEPTH
-        cm->bit_depth,
-#else
-        8,
-#endif  // CONFIG_AOM_HIGHBITDEPTH
-        &rsi.sgrproj_info[tile_idx].ep, rsi.sgrproj_info[tile_idx].xqd, tmpbuf);
-    rsi.sgrproj_info[tile_idx].level = 1;
-    err = try_restoration_tile(src, cpi, &rsi, partial_frame, tile_idx, 0, 0);
-    bits = SGRPROJ_BITS << AV1_PROB_COST_SHIFT;
-    bits += av1_cost_bit(RESTORE_NONE_SGRPROJ_PROB, 1);
-    cost_sgrproj = RDCOST_DBL(x->rdmult, x->rddiv, (bits >> 4), err);
-    if (cost_sgrproj >= cost_norestore) {
-      sgrproj_info[tile_idx].level = 0;
-    } else {
-      memcpy(&sgrproj_info[tile_idx], &rsi.sgrproj_info[tile_idx],
-             sizeof(sgrproj_info[tile_idx]));
-      bits = SGRPROJ_BITS << AV1_PROB_COST_SHIFT;
-      best_tile_cost[tile_idx] = RDCOST_DBL(
-          x->rdmult, x->rddiv,
-          (bits + cpi->switchable_restore_cost[RESTORE_SGRPROJ]) >> 4, err);
-    }
-    rsi.sgrproj_info[tile_idx].level = 0;
-  }
+  search_tiles(s, &rsi, info, best_tile_cost, search_sgrproj_tile, 0);
   // Cost for Sgrproj filtering
   bits = frame_level_restore_bits[rsi.frame_restoration_type]
          << AV1_PROB_COST_SHIFT;
@@ -314,13 +497,10 @@ static double search_sgrproj(const YV12_BUFFER_CONFIG *src, AV1_COMP *cpi,
       bits += (SGRPROJ_BITS << AV1_PROB_COST_SHIFT);
     }
   }
-  err = try_restoration_frame(src, cpi, &rsi, partial_frame);
+  err = (double)get_frame_error(s, &rsi, 1);
   cost_sgrproj = RDCOST_DBL(x->rdmult, x->rddiv, (bits >> 4), err);
 
   aom_free(rsi.sgrproj_info);
-  aom_free(tmpbuf);
-
-  aom_yv12_copy_y(&cpi->last_frame_uf, cm->frame_to_show);
   return cost_sgrproj;
 }
 
@@ -471,26 +651,69 @@ static void search_domaintxfmrf_restoration(uint8_t *dgd8, int width,
   *sigma_r = best_p;
 }
 
-static double search_domaintxfmrf(const YV12_BUFFER_CONFIG *src, AV1_COMP *cpi,
-                                  int filter_level, int partial_frame,
-                                  RestorationInfo *info,
-                                  double *best_tile_cost) {
-  DomaintxfmrfInfo *domaintxfmrf_info = info->domaintxfmrf_info;
+static void search_domaintxfmrf_tile(RestSearch *s, RestSearchThread *t,
+                                     int tile_idx) {
+  DomaintxfmrfInfo *domaintxfmrf_info = s->info->domaintxfmrf_info;
+  DomaintxfmrfInfo *const rsi_info = &s->rsi->domaintxfmrf_info[tile_idx];
+  const YV12_BUFFER_CONFIG *src = s->src;
   double err, cost_norestore, cost_domaintxfmrf;
   int bits;
-  MACROBLOCK *x = &cpi->td.mb;
-  AV1_COMMON *const cm = &cpi->common;
+  MACROBLOCK *x = &s->cpi->td.mb;
+  AV1_COMMON *const cm = &s->cpi->common;
   const YV12_BUFFER_CONFIG *dgd = cm->frame_to_show;
-  RestorationInfo rsi;
-  int tile_idx, tile_width, tile_height, nhtiles, nvtiles;
   int h_start, h_end, v_start, v_end;
-  const int ntiles = av1_get_rest_ntiles(cm->width, cm->height, &tile_width,
-                                         &tile_height, &nhtiles, &nvtiles);
-  //  Make a copy of the unfiltered / processed recon buffer
-  aom_yv12_copy_y(cm->frame_to_show, &cpi->last_frame_uf);
-  av1_loop_filter_frame(cm->frame_to_show, cm, &cpi->td.mb.e_mbd, filter_level,
-                        1, partial_frame);
-  aom_yv12_copy_y(cm->frame_to_show, &cpi->last_frame_db);
+
+  av1_get_rest_tile_limits(tile_idx, 0, 0, s->nhtiles, s->nvtiles,
+                           s->tile_width, s->tile_height, cm->width,
+                           cm->height, 0, 0, &h_start, &h_end, &v_start,
+                           &v_end);
+  err = (double)s->tile_sse[tile_idx];
+  s->tile_err[tile_idx] = s->tile_sse[tile_idx];
+  // #bits when a tile is not restored
+  bits = av1_cost_bit(RESTORE_NONE_DOMAINTXFMRF_PROB, 0);
+  cost_norestore = RDCOST_DBL(x->rdmult, x->rddiv, (bits >> 4), err);
+  s->best_tile_cost[tile_idx] = DBL_MAX;
+
+  search_domaintxfmrf_restoration(
+      dgd->y_buffer + v_start * dgd->y_stride + h_start, h_end - h_start,
+      v_end - v_start, dgd->y_stride,
+      src->y_buffer + v_start * src->y_stride + h_start, src->y_stride,
+#if CONFIG_AOM_HIGHBITDEPTH
+      cm->bit_depth,
+#else
+      8,
+#endif  // CONFIG_AOM_HIGHBITDEPTH
+      &rsi_info->sigma_r);
+
+  rsi_info->level = 1;
+  err = (double)try_restoration_tile(s, t, tile_idx, 0, 0);
+  bits = DOMAINTXFMRF_PARAMS_BITS << AV1_PROB_COST_SHIFT;
+  bits += av1_cost_bit(RESTORE_NONE_DOMAINTXFMRF_PROB, 1);
+  cost_domaintxfmrf = RDCOST_DBL(x->rdmult, x->rddiv, (bits >> 4), err);
+  if (cost_domaintxfmrf >= cost_norestore) {
+    domaintxfmrf_info[tile_idx].level = 0;
+  } else {
+    memcpy(&domaintxfmrf_info[tile_idx], rsi_info,
+           sizeof(domaintxfmrf_info[tile_idx]));
+    bits = DOMAINTXFMRF_PARAMS_BITS << AV1_PROB_COST_SHIFT;
+    s->best_tile_cost[tile_idx] = RDCOST_DBL(
+        x->rdmult, x->rddiv,
+        (bits + s->cpi->switchable_restore_cost[RESTORE_DOMAINTXFMRF]) >> 4,
+        err);
+    s->tile_err[tile_idx] = (int64_t)err;
+  }
+  rsi_info->level = 0;
+}
+
+static double search_domaintxfmrf(RestSearch *s, RestorationInfo *info,
+                                  double *best_tile_cost) {
+  DomaintxfmrfInfo *domaintxfmrf_info = info->domaintxfmrf_info;
+  double err, cost_domaintxfmrf;
+  int bits;
+  MACROBLOCK *x = &s->cpi->td.mb;
+  RestorationInfo rsi;
+  int tile_idx;
+  const int ntiles = s->ntiles;
 
   rsi.frame_restoration_type = RESTORE_DOMAINTXFMRF;
   rsi.domaintxfmrf_info =
@@ -500,46 +723,7 @@ static double search_domaintxfmrf(const YV12_BUFFER_CONFIG *src, AV1_COMP *cpi,
   for (tile_idx = 0; tile_idx < ntiles; ++tile_idx)
     rsi.domaintxfmrf_info[tile_idx].level = 0;
   // Compute best Domaintxfm filters for each tile
-  for (tile_idx = 0; tile_idx < ntiles; ++tile_idx) {
-    av1_get_rest_tile_limits(tile_idx, 0, 0, nhtiles, nvtiles, tile_width,
-                             tile_height, cm->width, cm->height, 0, 0, &h_start,
-                             &h_end, &v_start, &v_end);
-    err = sse_restoration_tile(src, cm, h_start, h_end - h_start, v_start,
-                               v_end - v_start);
-    // #bits when a tile is not restored
-    bits = av1_cost_bit(RESTORE_NONE_DOMAINTXFMRF_PROB, 0);
-    cost_norestore = RDCOST_DBL(x->rdmult, x->rddiv, (bits >> 4), err);
-    best_tile_cost[tile_idx] = DBL_MAX;
-
-    search_domaintxfmrf_restoration(
-        dgd->y_buffer + v_start * dgd->y_stride + h_start, h_end - h_start,
-        v_end - v_start, dgd->y_stride,
-        src->y_buffer + v_start * src->y_stride + h_start, src->y_stride,
-#if CONFIG_AOM_HIGHBITDEPTH
-        cm->bit_depth,
-#else
-        8,
-#endif  // CONFIG_AOM_HIGHBITDEPTH
-        &rsi.domaintxfmrf_info[tile_idx].sigma_r);
-
-    rsi.domaintxfmrf_info[tile_idx].level = 1;
-    err = try_restoration_tile(src, cpi, &rsi, partial_frame, tile_idx, 0, 0);
-    bits = DOMAINTXFMRF_PARAMS_BITS << AV1_PROB_COST_SHIFT;
-    bits += av1_cost_bit(RESTORE_NONE_DOMAINTXFMRF_PROB, 1);
-    cost_domaintxfmrf = RDCOST_DBL(x->rdmult, x->rddiv, (bits >> 4), err);
-    if (cost_domaintxfmrf >= cost_norestore) {
-      domaintxfmrf_info[tile_idx].level = 0;
-    } else {
-      memcpy(&domaintxfmrf_info[tile_idx], &rsi.domaintxfmrf_info[tile_idx],
-             sizeof(domaintxfmrf_info[tile_idx]));
-      bits = DOMAINTXFMRF_PARAMS_BITS << AV1_PROB_COST_SHIFT;
-      best_tile_cost[tile_idx] = RDCOST_DBL(
-          x->rdmult, x->rddiv,
-          (bits + cpi->switchable_restore_cost[RESTORE_DOMAINTXFMRF]) >> 4,
-          err);
-    }
-    rsi.domaintxfmrf_info[tile_idx].level = 0;
-  }
+  search_tiles(s, &rsi, info, best_tile_cost, search_domaintxfmrf_tile, 0);
   // Cost for Domaintxfmrf filtering
   bits = frame_level_restore_bits[rsi.frame_restoration_type]
          << AV1_PROB_COST_SHIFT;
@@ -552,38 +736,93 @@ static double search_domaintxfmrf(const YV12_BUFFER_CONFIG *src, AV1_COMP *cpi,
       bits += (DOMAINTXFMRF_PARAMS_BITS << AV1_PROB_COST_SHIFT);
     }
   }
-  err = try_restoration_frame(src, cpi, &rsi, partial_frame);
+  err = (double)get_frame_error(s, &rsi, 1);
   cost_domaintxfmrf = RDCOST_DBL(x->rdmult, x->rddiv, (bits >> 4), err);
 
   aom_free(rsi.domaintxfmrf_info);
-
-  aom_yv12_copy_y(&cpi->last_frame_uf, cm->frame_to_show);
   return cost_domaintxfmrf;
 }
 
-static double search_bilateral(const YV12_BUFFER_CONFIG *src, AV1_COMP *cpi,
-                               int filter_level, int partial_frame,
-                               RestorationInfo *info, double *best_tile_cost) {
-  BilateralInfo *bilateral_info = info->bilateral_info;
-  AV1_COMMON *const cm = &cpi->common;
-  int i, tile_idx, subtile_idx;
+static void search_bilateral_tile(RestSearch *s, RestSearchThread *t,
+                                  int tile_idx) {
+  BilateralInfo *bilateral_info = s->info->bilateral_info;
+  BilateralInfo *const rsi_info = &s->rsi->bilateral_info[tile_idx];
+  AV1_COMMON *const cm = &s->cpi->common;
+  int i, subtile_idx;
   int64_t err;
   int bits;
-  double cost, best_cost, cost_bilateral, cost_norestore_subtile;
-  const int bilateral_level_bits = av1_bilateral_level_bits(&cpi->common);
+  double cost, best_cost, cost_norestore_subtile;
+  const int bilateral_level_bits = av1_bilateral_level_bits(cm);
   const int bilateral_levels = 1 << bilateral_level_bits;
-  MACROBLOCK *x = &cpi->td.mb;
-  RestorationInfo rsi;
-  int tile_width, tile_height, nhtiles, nvtiles;
+  MACROBLOCK *x = &s->cpi->td.mb;
   int h_start, h_end, v_start, v_end;
-  const int ntiles = av1_get_rest_ntiles(cm->width, cm->height, &tile_width,
-                                         &tile_height, &nhtiles, &nvtiles);
 
-  //  Make a copy of the unfiltered / processed recon buffer
-  aom_yv12_copy_y(cm->frame_to_show, &cpi->last_frame_uf);
-  av1_loop_filter_frame(cm->frame_to_show, cm, &cpi->td.mb.e_mbd, filter_level,
-                        1, partial_frame);
-  aom_yv12_copy_y(cm->frame_to_show, &cpi->last_frame_db);
+  for (subtile_idx = 0; subtile_idx < BILATERAL_SUBTILES; ++subtile_idx) {
+    av1_get_rest_tile_limits(tile_idx, subtile_idx, BILATERAL_SUBTILE_BITS,
+                             s->nhtiles, s->nvtiles, s->tile_width,
+                             s->tile_height, cm->width, cm->height, 0, 0,
+                             &h_start, &h_end, &v_start, &v_end);
+    err = sse_restoration_tile(s->src, cm->frame_to_show, cm, h_start,
+                               h_end - h_start, v_start, v_end - v_start);
+#if BILATERAL_SUBTILES
+    // #bits when a subtile is not restored
+    bits = av1_cost_bit(RESTORE_NONE_BILATERAL_PROB, 0);
+#else
+    bits = 0;
+#endif
+    cost_norestore_subtile = RDCOST_DBL(x->rdmult, x->rddiv, (bits >> 4), err);
+    best_cost = cost_norestore_subtile;
+
+    for (i = 0; i < bilateral_levels; ++i) {
+      rsi_info->level[subtile_idx] = i;
+      err = try_restoration_tile(s, t, tile_idx, subtile_idx,
+                                 BILATERAL_SUBTILE_BITS);
+      bits = bilateral_level_bits << AV1_PROB_COST_SHIFT;
+      bits += av1_cost_bit(RESTORE_NONE_BILATERAL_PROB, 1);
+      cost = RDCOST_DBL(x->rdmult, x->rddiv, (bits >> 4), err);
+      if (cost < best_cost) {
+        bilateral_info[tile_idx].level[subtile_idx] = i;
+        best_cost = cost;
+      }
+      rsi_info->level[subtile_idx] = -1;
+    }
+  }
+  bits = 0;
+  for (subtile_idx = 0; subtile_idx < BILATERAL_SUBTILES; ++subtile_idx) {
+    rsi_info->level[subtile_idx] = bilateral_info[tile_idx].level[subtile_idx];
+    if (rsi_info->level[subtile_idx] >= 0)
+      bits += bilateral_level_bits << AV1_PROB_COST_SHIFT;
+#if BILATERAL_SUBTILES
+    bits += av1_cost_bit(RESTORE_NONE_BILATERAL_PROB,
+                         rsi_info->level[subtile_idx] >= 0);
+#endif
+  }
+  err = try_restoration_tile(s, t, tile_idx, 0, 0);
+  s->best_tile_cost[tile_idx] = RDCOST_DBL(
+      x->rdmult, x->rddiv,
+      (bits + s->cpi->switchable_restore_cost[RESTORE_BILATERAL]) >> 4, err);
+  // The next tiles are tried with this one filtered. Its levels are kept in
+  // s->rsi for the search on part of the frame, which filters it as a whole.
+  if (!s->partial_frame) {
+    av1_get_rest_tile_limits(tile_idx, 0, 0, s->nhtiles, s->nvtiles,
+                             s->tile_width, s->tile_height, cm->width,
+                             cm->height, 0, 0, &h_start, &h_end, &v_start,
+                             &v_end);
+    copy_tile_region(&t->frame, s->dgd, cm, h_start, h_end, v_start, v_end);
+  }
+}
+
+static double search_bilateral(RestSearch *s, RestorationInfo *info,
+                               double *best_tile_cost) {
+  BilateralInfo *bilateral_info = info->bilateral_info;
+  int tile_idx, subtile_idx;
+  int64_t err;
+  int bits;
+  double cost_bilateral;
+  const int bilateral_level_bits = av1_bilateral_level_bits(&s->cpi->common);
+  MACROBLOCK *x = &s->cpi->td.mb;
+  RestorationInfo rsi;
+  const int ntiles = s->ntiles;
 
   rsi.frame_restoration_type = RESTORE_BILATERAL;
   rsi.bilateral_info =
@@ -596,55 +835,7 @@ static double search_bilateral(const YV12_BUFFER_CONFIG *src, AV1_COMP *cpi,
           rsi.bilateral_info[tile_idx].level[subtile_idx] = -1;
 
   // Find best filter for each tile
-  for (tile_idx = 0; tile_idx < ntiles; ++tile_idx) {
-    for (subtile_idx = 0; subtile_idx < BILATERAL_SUBTILES; ++subtile_idx) {
-      av1_get_rest_tile_limits(tile_idx, subtile_idx, BILATERAL_SUBTILE_BITS,
-                               nhtiles, nvtiles, tile_width, tile_height,
-                               cm->width, cm->height, 0, 0, &h_start, &h_end,
-                               &v_start, &v_end);
-      err = sse_restoration_tile(src, cm, h_start, h_end - h_start, v_start,
-                                 v_end - v_start);
-#if BILATERAL_SUBTILES
-      // #bits when a subtile is not restored
-      bits = av1_cost_bit(RESTORE_NONE_BILATERAL_PROB, 0);
-#else
-      bits = 0;
-#endif
-      cost_norestore_subtile =
-          RDCOST_DBL(x->rdmult, x->rddiv, (bits >> 4), err);
-      best_cost = cost_norestore_subtile;
-
-      for (i = 0; i < bilateral_levels; ++i) {
-        rsi.bilateral_info[tile_idx].level[subtile_idx] = i;
-        err = try_restoration_tile(src, cpi, &rsi, partial_frame, tile_idx,
-                                   subtile_idx, BILATERAL_SUBTILE_BITS);
-        bits = bilateral_level_bits << AV1_PROB_COST_SHIFT;
-        bits += av1_cost_bit(RESTORE_NONE_BILATERAL_PROB, 1);
-        cost = RDCOST_DBL(x->rdmult, x->rddiv, (bits >> 4), err);
-        if (cost < best_cost) {
-          bilateral_info[tile_idx].level[subtile_idx] = i;
-          best_cost = cost;
-        }
-        rsi.bilateral_info[tile_idx].level[subtile_idx] = -1;
-      }
-    }
-    bits = 0;
-    for (subtile_idx = 0; subtile_idx < BILATERAL_SUBTILES; ++subtile_idx) {
-      rsi.bilateral_info[tile_idx].level[subtile_idx] =
-          bilateral_info[tile_idx].level[subtile_idx];
-      if (rsi.bilateral_info[tile_idx].level[subtile_idx] >= 0)
-        bits += bilateral_level_bits << AV1_PROB_COST_SHIFT;
-#if BILATERAL_SUBTILES
-      bits +=
-          av1_cost_bit(RESTORE_NONE_BILATERAL_PROB,
-                       rsi.bilateral_info[tile_idx].level[subtile_idx] >= 0);
-#endif
-    }
-    err = try_restoration_tile(src, cpi, &rsi, partial_frame, tile_idx, 0, 0);
-    best_tile_cost[tile_idx] = RDCOST_DBL(
-        x->rdmult, x->rddiv,
-        (bits + cpi->switchable_restore_cost[RESTORE_BILATERAL]) >> 4, err);
-  }
+  search_tiles(s, &rsi, info, best_tile_cost, search_bilateral_tile, 1);
   // Find cost for combined configuration
   bits = frame_level_restore_bits[rsi.frame_restoration_type]
          << AV1_PROB_COST_SHIFT;
@@ -662,108 +853,136 @@ static double search_bilateral(const YV12_BUFFER_CONFIG *src, AV1_COMP *cpi,
 #endif
     }
   }
-  err = try_restoration_frame(src, cpi, &rsi, partial_frame);
+  err = get_frame_error(s, &rsi, 0);
   cost_bilateral = RDCOST_DBL(x->rdmult, x->rddiv, (bits >> 4), err);
 
   aom_free(rsi.bilateral_info);
-
-  aom_yv12_copy_y(&cpi->last_frame_uf, cm->frame_to_show);
   return cost_bilateral;
 }
 
-static double find_average(uint8_t *src, int h_start, int h_end, int v_start,
-                           int v_end, int stride) {
-  uint64_t sum = 0;
-  double avg = 0;
-  int i, j;
-  for (i = v_start; i < v_end; i++)
-    for (j = h_start; j < h_end; j++) sum += src[i * stride + j];
-  avg = (double)sum / ((v_end - v_start) * (h_end - h_start));
-  return avg;
-}
-
-static void compute_stats(uint8_t *dgd, uint8_t *src, int h_start, int h_end,
-                          int v_start, int v_end, int dgd_stride,
-                          int src_stride, double *M, double *H) {
+void av1_compute_stats_c(const uint8_t *dgd, int dgd_stride,
+                         const uint8_t *src, int src_stride, int width,
+                         int height, int64_t *sum_d, int64_t *sum_s,
+                         int64_t *M, int64_t *H, int16_t *tmpbuf) {
   int i, j, k, l;
-  double Y[RESTORATION_WIN2];
-  const double avg =
-      find_average(dgd, h_start, h_end, v_start, v_end, dgd_stride);
+  int Y[RESTORATION_WIN2];
+  (void)tmpbuf;
 
+  memset(sum_d, 0, sizeof(*sum_d) * RESTORATION_WIN2);
   memset(M, 0, sizeof(*M) * RESTORATION_WIN2);
   memset(H, 0, sizeof(*H) * RESTORATION_WIN2 * RESTORATION_WIN2);
-  for (i = v_start; i < v_end; i++) {
-    for (j = h_start; j < h_end; j++) {
-      const double X = (double)src[i * src_stride + j] - avg;
+  *sum_s = 0;
+  for (i = 0; i < height; i++) {
+    for (j = 0; j < width; j++) {
+      const int X = src[i * src_stride + j];
       int idx = 0;
       for (k = -RESTORATION_HALFWIN; k <= RESTORATION_HALFWIN; k++) {
         for (l = -RESTORATION_HALFWIN; l <= RESTORATION_HALFWIN; l++) {
-          Y[idx] = (double)dgd[(i + l) * dgd_stride + (j + k)] - avg;
+          Y[idx] = dgd[(i + l) * dgd_stride + (j + k)];
           idx++;
         }
       }
+      *sum_s += X;
       for (k = 0; k < RESTORATION_WIN2; ++k) {
+        sum_d[k] += Y[k];
         M[k] += Y[k] * X;
-        H[k * RESTORATION_WIN2 + k] += Y[k] * Y[k];
-        for (l = k + 1; l < RESTORATION_WIN2; ++l) {
-          double value = Y[k] * Y[l];
-          H[k * RESTORATION_WIN2 + l] += value;
-          H[l * RESTORATION_WIN2 + k] += value;
-        }
+        for (l = k; l < RESTORATION_WIN2; ++l)
+          H[k * RESTORATION_WIN2 + l] += Y[k] * Y[l];
       }
     }
   }
+  for (k = 0; k < RESTORATION_WIN2; ++k)
+    for (l = 0; l < k; ++l)
+      H[k * RESTORATION_WIN2 + l] = H[l * RESTORATION_WIN2 + k];
 }
 
 #if CONFIG_AOM_HIGHBITDEPTH
-static double find_average_highbd(uint16_t *src, int h_start, int h_end,
-                                  int v_start, int v_end, int stride) {
-  uint64_t sum = 0;
-  double avg = 0;
-  int i, j;
-  for (i = v_start; i < v_end; i++)
-    for (j = h_start; j < h_end; j++) sum += src[i * stride + j];
-  avg = (double)sum / ((v_end - v_start) * (h_end - h_start));
-  return avg;
-}
-
-static void compute_stats_highbd(uint8_t *dgd8, uint8_t *src8, int h_start,
-                                 int h_end, int v_start, int v_end,
-                                 int dgd_stride, int src_stride, double *M,
-                                 double *H) {
+void av1_highbd_compute_stats_c(const uint16_t *dgd, int dgd_stride,
+                                const uint16_t *src, int src_stride, int width,
+                                int height, int bd, int64_t *sum_d,
+                                int64_t *sum_s, int64_t *M, int64_t *H,
+                                int16_t *tmpbuf) {
   int i, j, k, l;
-  double Y[RESTORATION_WIN2];
-  uint16_t *src = CONVERT_TO_SHORTPTR(src8);
-  uint16_t *dgd = CONVERT_TO_SHORTPTR(dgd8);
-  const double avg =
-      find_average_highbd(dgd, h_start, h_end, v_start, v_end, dgd_stride);
+  int64_t Y[RESTORATION_WIN2];
+  (void)bd;
+  (void)tmpbuf;
 
+  memset(sum_d, 0, sizeof(*sum_d) * RESTORATION_WIN2);
   memset(M, 0, sizeof(*M) * RESTORATION_WIN2);
   memset(H, 0, sizeof(*H) * RESTORATION_WIN2 * RESTORATION_WIN2);
-  for (i = v_start; i < v_end; i++) {
-    for (j = h_start; j < h_end; j++) {
-      const double X = (double)src[i * src_stride + j] - avg;
+  *sum_s = 0;
+  for (i = 0; i < height; i++) {
+    for (j = 0; j < width; j++) {
+      const int64_t X = src[i * src_stride + j];
       int idx = 0;
       for (k = -RESTORATION_HALFWIN; k <= RESTORATION_HALFWIN; k++) {
         for (l = -RESTORATION_HALFWIN; l <= RESTORATION_HALFWIN; l++) {
-          Y[idx] = (double)dgd[(i + l) * dgd_stride + (j + k)] - avg;
+          Y[idx] = dgd[(i + l) * dgd_stride + (j + k)];
           idx++;
         }
       }
+      *sum_s += X;
       for (k = 0; k < RESTORATION_WIN2; ++k) {
+        sum_d[k] += Y[k];
         M[k] += Y[k] * X;
-        H[k * RESTORATION_WIN2 + k] += Y[k] * Y[k];
-        for (l = k + 1; l < RESTORATION_WIN2; ++l) {
-          double value = Y[k] * Y[l];
-          H[k * RESTORATION_WIN2 + l] += value;
-          H[l * RESTORATION_WIN2 + k] += value;
-        }
+        for (l = k; l < RESTORATION_WIN2; ++l)
+          H[k * RESTORATION_WIN2 + l] += Y[k] * Y[l];
       }
     }
   }
+  for (k = 0; k < RESTORATION_WIN2; ++k)
+    for (l = 0; l < k; ++l)
+      H[k * RESTORATION_WIN2 + l] = H[l * RESTORATION_WIN2 + k];
 }
 #endif  // CONFIG_AOM_HIGHBITDEPTH
 
+// Finds the correlations of the deblocked pixels of the window around each
+// pixel of the tile with each other (H) and with the source pixel (M), all
+// taken about the mean of the deblocked tile. They are summed up exactly, as
+// integers, and only centred at the end.
+static void compute_stats(const YV12_BUFFER_CONFIG *dgd,
+                          const YV12_BUFFER_CONFIG *src,
+                          const AV1_COMMON *cm, int h_start, int h_end,
+                          int v_start, int v_end, double *M, double *H,
+                          int16_t *tmpbuf) {
+  const int width = h_end - h_start;
+  const int height = v_end - v_start;
+  const int n = width * height;
+  int64_t sum_d[RESTORATION_WIN2], sum_s;
+  int64_t Mi[RESTORATION_WIN2], Hi[RESTORATION_WIN2 * RESTORATION_WIN2];
+  double avg, avg2;
+  int k, l;
+
+#if CONFIG_AOM_HIGHBITDEPTH
+  if (cm->use_highbitdepth)
+    av1_highbd_compute_stats(
+        CONVERT_TO_SHORTPTR(dgd->y_buffer) + v_start * dgd->y_stride + h_start,
+        dgd->y_stride,
+        CONVERT_TO_SHORTPTR(src->y_buffer) + v_start * src->y_stride + h_start,
+        src->y_stride, width, height, cm->bit_depth, sum_d, &sum_s, Mi, Hi,
+        tmpbuf);
+  else
+#else
+  (void)cm;
+#endif  // CONFIG_AOM_HIGHBITDEPTH
+    av1_compute_stats(dgd->y_buffer + v_start * dgd->y_stride + h_start,
+                      dgd->y_stride,
+                      src->y_buffer + v_start * src->y_stride + h_start,
+                      src->y_stride, width, height, sum_d, &sum_s, Mi, Hi,
+                      tmpbuf);
+
+  // The centre of the window is the tile itself.
+  avg = (double)sum_d[RESTORATION_WIN2 >> 1] / n;
+  avg2 = avg * avg * n;
+  for (k = 0; k < RESTORATION_WIN2; ++k) {
+    M[k] = (double)Mi[k] - avg * (double)(sum_d[k] + sum_s) + avg2;
+    for (l = 0; l < RESTORATION_WIN2; ++l) {
+      H[k * RESTORATION_WIN2 + l] = (double)Hi[k * RESTORATION_WIN2 + l] -
+                                    avg * (double)(sum_d[k] + sum_d[l]) + avg2;
+    }
+  }
+}
+
 // Solves Ax = b, where x and b are column vectors
 static int linsolve(int n, double *A, int stride, double *b, double *x) {
   int i, j, k;
@@ -970,41 +1189,92 @@ static void quantize_sym_filter(double *f, int *fi) {
   fi[2] = CLIP(fi[2], WIENER_FILT_TAP2_MINV, WIENER_FILT_TAP2_MAXV);
 }
 
-static double search_wiener(const YV12_BUFFER_CONFIG *src, AV1_COMP *cpi,
-                            int filter_level, int partial_frame,
-                            RestorationInfo *info, double *best_tile_cost) {
-  WienerInfo *wiener_info = info->wiener_info;
-  AV1_COMMON *const cm = &cpi->common;
-  RestorationInfo rsi;
+static void search_wiener_tile(RestSearch *s, RestSearchThread *t,
+                               int tile_idx) {
+  WienerInfo *wiener_info = s->info->wiener_info;
+  WienerInfo *const rsi_info = &s->rsi->wiener_info[tile_idx];
+  AV1_COMMON *const cm = &s->cpi->common;
+  const YV12_BUFFER_CONFIG *src = s->src;
   int64_t err;
   int bits;
   double cost_wiener, cost_norestore;
-  MACROBLOCK *x = &cpi->td.mb;
+  MACROBLOCK *x = &s->cpi->td.mb;
   double M[RESTORATION_WIN2];
   double H[RESTORATION_WIN2 * RESTORATION_WIN2];
   double vfilterd[RESTORATION_WIN], hfilterd[RESTORATION_WIN];
   const YV12_BUFFER_CONFIG *dgd = cm->frame_to_show;
-  const int width = cm->width;
-  const int height = cm->height;
-  const int src_stride = src->y_stride;
-  const int dgd_stride = dgd->y_stride;
   double score;
-  int tile_idx, tile_width, tile_height, nhtiles, nvtiles;
   int h_start, h_end, v_start, v_end;
   int i;
 
-  const int ntiles = av1_get_rest_ntiles(width, height, &tile_width,
-                                         &tile_height, &nhtiles, &nvtiles);
-  assert(width == dgd->y_crop_width);
-  assert(height == dgd->y_crop_height);
-  assert(width == src->y_crop_width);
-  assert(height == src->y_crop_height);
+  err = s->tile_sse[tile_idx];
+  s->tile_err[tile_idx] = err;
+  // #bits when a tile is not restored
+  bits = av1_cost_bit(RESTORE_NONE_WIENER_PROB, 0);
+  cost_norestore = RDCOST_DBL(x->rdmult, x->rddiv, (bits >> 4), err);
+  s->best_tile_cost[tile_idx] = DBL_MAX;
 
-  //  Make a copy of the unfiltered / processed recon buffer
-  aom_yv12_copy_y(cm->frame_to_show, &cpi->last_frame_uf);
-  av1_loop_filter_frame(cm->frame_to_show, cm, &cpi->td.mb.e_mbd, filter_level,
-                        1, partial_frame);
-  aom_yv12_copy_y(cm->frame_to_show, &cpi->last_frame_db);
+  av1_get_rest_tile_limits(tile_idx, 0, 0, s->nhtiles, s->nvtiles,
+                           s->tile_width, s->tile_height, cm->width,
+                           cm->height, 1, 1, &h_start, &h_end, &v_start,
+                           &v_end);
+  compute_stats(dgd, src, cm, h_start, h_end, v_start, v_end, M, H,
+                (int16_t *)t->tmpbuf);
+
+  wiener_info[tile_idx].level = 1;
+  if (!wiener_decompose_sep_sym(M, H, vfilterd, hfilterd)) {
+    wiener_info[tile_idx].level = 0;
+    return;
+  }
+  quantize_sym_filter(vfilterd, rsi_info->vfilter);
+  quantize_sym_filter(hfilterd, rsi_info->hfilter);
+
+  // Filter score computes the value of the function x'*A*x - x'*b for the
+  // learned filter and compares it against identity filer. If there is no
+  // reduction in the function, the filter is reverted back to identity
+  score = compute_score(M, H, rsi_info->vfilter, rsi_info->hfilter);
+  if (score > 0.0) {
+    wiener_info[tile_idx].level = 0;
+    return;
+  }
+
+  rsi_info->level = 1;
+  av1_wiener_set_taps(rsi_info);
+  err = try_restoration_tile(s, t, tile_idx, 0, 0);
+  bits = WIENER_FILT_BITS << AV1_PROB_COST_SHIFT;
+  bits += av1_cost_bit(RESTORE_NONE_WIENER_PROB, 1);
+  cost_wiener = RDCOST_DBL(x->rdmult, x->rddiv, (bits >> 4), err);
+  if (cost_wiener >= cost_norestore) {
+    wiener_info[tile_idx].level = 0;
+  } else {
+    wiener_info[tile_idx].level = 1;
+    for (i = 0; i < RESTORATION_HALFWIN; ++i) {
+      wiener_info[tile_idx].vfilter[i] = rsi_info->vfilter[i];
+      wiener_info[tile_idx].hfilter[i] = rsi_info->hfilter[i];
+    }
+    bits = WIENER_FILT_BITS << AV1_PROB_COST_SHIFT;
+    s->best_tile_cost[tile_idx] = RDCOST_DBL(
+        x->rdmult, x->rddiv,
+        (bits + s->cpi->switchable_restore_cost[RESTORE_WIENER]) >> 4, err);
+    s->tile_err[tile_idx] = err;
+  }
+  rsi_info->level = 0;
+}
+
+static double search_wiener(RestSearch *s, RestorationInfo *info,
+                            double *best_tile_cost) {
+  WienerInfo *wiener_info = info->wiener_info;
+  RestorationInfo rsi;
+  int64_t err;
+  int bits;
+  double cost_wiener;
+  MACROBLOCK *x = &s->cpi->td.mb;
+  int tile_idx;
+  int i;
+  const int ntiles = s->ntiles;
+
+  assert(s->cpi->common.width == s->src->y_crop_width);
+  assert(s->cpi->common.height == s->src->y_crop_height);
 
   rsi.frame_restoration_type = RESTORE_WIENER;
   rsi.wiener_info = (WienerInfo *)aom_malloc(sizeof(*rsi.wiener_info) * ntiles);
@@ -1014,67 +1284,7 @@ static double search_wiener(const YV12_BUFFER_CONFIG *src, AV1_COMP *cpi,
     rsi.wiener_info[tile_idx].level = 0;
 
   // Compute best Wiener filters for each tile
-  for (tile_idx = 0; tile_idx < ntiles; ++tile_idx) {
-    av1_get_rest_tile_limits(tile_idx, 0, 0, nhtiles, nvtiles, tile_width,
-                             tile_height, width, height, 0, 0, &h_start, &h_end,
-                             &v_start, &v_end);
-    err = sse_restoration_tile(src, cm, h_start, h_end - h_start, v_start,
-                               v_end - v_start);
-    // #bits when a tile is not restored
-    bits = av1_cost_bit(RESTORE_NONE_WIENER_PROB, 0);
-    cost_norestore = RDCOST_DBL(x->rdmult, x->rddiv, (bits >> 4), err);
-    best_tile_cost[tile_idx] = DBL_MAX;
-
-    av1_get_rest_tile_limits(tile_idx, 0, 0, nhtiles, nvtiles, tile_width,
-                             tile_height, width, height, 1, 1, &h_start, &h_end,
-                             &v_start, &v_end);
-#if CONFIG_AOM_HIGHBITDEPTH
-    if (cm->use_highbitdepth)
-      compute_stats_highbd(dgd->y_buffer, src->y_buffer, h_start, h_end,
-                           v_start, v_end, dgd_stride, src_stride, M, H);
-    else
-#endif  // CONFIG_AOM_HIGHBITDEPTH
-      compute_stats(dgd->y_buffer, src->y_buffer, h_start, h_end, v_start,
-                    v_end, dgd_stride, src_stride, M, H);
-
-    wiener_info[tile_idx].level = 1;
-    if (!wiener_decompose_sep_sym(M, H, vfilterd, hfilterd)) {
-      wiener_info[tile_idx].level = 0;
-      continue;
-    }
-    quantize_sym_filter(vfilterd, rsi.wiener_info[tile_idx].vfilter);
-    quantize_sym_filter(hfilterd, rsi.wiener_info[tile_idx].hfilter);
-
-    // Filter score computes the value of the function x'*A*x - x'*b for the
-    // learned filter and compares it against identity filer. If there is no
-    // reduction in the function, the filter is reverted back to identity
-    score = compute_score(M, H, rsi.wiener_info[tile_idx].vfilter,
-                          rsi.wiener_info[tile_idx].hfilter);
-    if (score > 0.0) {
-      wiener_info[tile_idx].level = 0;
-      continue;
-    }
-
-    rsi.wiener_info[tile_idx].level = 1;
-    err = try_restoration_tile(src, cpi, &rsi, partial_frame, tile_idx, 0, 0);
-    bits = WIENER_FILT_BITS << AV1_PROB_COST_SHIFT;
-    bits += av1_cost_bit(RESTORE_NONE_WIENER_PROB, 1);
-    cost_wiener = RDCOST_DBL(x->rdmult, x->rddiv, (bits >> 4), err);
-    if (cost_wiener >= cost_norestore) {
-      wiener_info[tile_idx].level = 0;
-    } else {
-      wiener_info[tile_idx].level = 1;
-      for (i = 0; i < RESTORATION_HALFWIN; ++i) {
-        wiener_info[tile_idx].vfilter[i] = rsi.wiener_info[tile_idx].vfilter[i];
-        wiener_info[tile_idx].hfilter[i] = rsi.wiener_info[tile_idx].hfilter[i];
-      }
-      bits = WIENER_FILT_BITS << AV1_PROB_COST_SHIFT;
-      best_tile_cost[tile_idx] = RDCOST_DBL(
-          x->rdmult, x->rddiv,
-          (bits + cpi->switchable_restore_cost[RESTORE_WIENER]) >> 4, err);
-    }
-    rsi.wiener_info[tile_idx].level = 0;
-  }
+  search_tiles(s, &rsi, info, best_tile_cost, search_wiener_tile, 0);
   // Cost for Wiener filtering
   bits = frame_level_restore_bits[rsi.frame_restoration_type]
          << AV1_PROB_COST_SHIFT;
@@ -1089,73 +1299,48 @@ static double search_wiener(const YV12_BUFFER_CONFIG *src, AV1_COMP *cpi,
       }
     }
   }
-  err = try_restoration_frame(src, cpi, &rsi, partial_frame);
+  err = get_frame_error(s, &rsi, 0);
   cost_wiener = RDCOST_DBL(x->rdmult, x->rddiv, (bits >> 4), err);
 
   aom_free(rsi.wiener_info);
-
-  aom_yv12_copy_y(&cpi->last_frame_uf, cm->frame_to_show);
   return cost_wiener;
 }
 
-static double search_norestore(const YV12_BUFFER_CONFIG *src, AV1_COMP *cpi,
-                               int filter_level, int partial_frame,
-                               RestorationInfo *info, double *best_tile_cost) {
+static double search_norestore(RestSearch *s, RestorationInfo *info,
+                               double *best_tile_cost) {
   double err, cost_norestore;
   int bits;
-  MACROBLOCK *x = &cpi->td.mb;
-  AV1_COMMON *const cm = &cpi->common;
-  int tile_idx, tile_width, tile_height, nhtiles, nvtiles;
-  int h_start, h_end, v_start, v_end;
-  const int ntiles = av1_get_rest_ntiles(cm->width, cm->height, &tile_width,
-                                         &tile_height, &nhtiles, &nvtiles);
+  MACROBLOCK *x = &s->cpi->td.mb;
+  int tile_idx;
+  int64_t frame_sse = 0;
   (void)info;
 
-  //  Make a copy of the unfiltered / processed recon buffer
-  aom_yv12_copy_y(cm->frame_to_show, &cpi->last_frame_uf);
-  av1_loop_filter_frame(cm->frame_to_show, cm, &cpi->td.mb.e_mbd, filter_level,
-                        1, partial_frame);
-  aom_yv12_copy_y(cm->frame_to_show, &cpi->last_frame_db);
-
-  for (tile_idx = 0; tile_idx < ntiles; ++tile_idx) {
-    av1_get_rest_tile_limits(tile_idx, 0, 0, nhtiles, nvtiles, tile_width,
-                             tile_height, cm->width, cm->height, 0, 0, &h_start,
-                             &h_end, &v_start, &v_end);
-    err = sse_restoration_tile(src, cm, h_start, h_end - h_start, v_start,
-                               v_end - v_start);
+  for (tile_idx = 0; tile_idx < s->ntiles; ++tile_idx) {
+    err = (double)s->tile_sse[tile_idx];
     best_tile_cost[tile_idx] =
         RDCOST_DBL(x->rdmult, x->rddiv,
-                   (cpi->switchable_restore_cost[RESTORE_NONE] >> 4), err);
+                   (s->cpi->switchable_restore_cost[RESTORE_NONE] >> 4), err);
+    frame_sse += s->tile_sse[tile_idx];
   }
   // RD cost associated with no restoration
-  err = sse_restoration_tile(src, cm, 0, cm->width, 0, cm->height);
+  err = (double)frame_sse;
   bits = frame_level_restore_bits[RESTORE_NONE] << AV1_PROB_COST_SHIFT;
   cost_norestore = RDCOST_DBL(x->rdmult, x->rddiv, (bits >> 4), err);
-  aom_yv12_copy_y(&cpi->last_frame_uf, cm->frame_to_show);
   return cost_norestore;
 }
 
 static double search_switchable_restoration(
-    AV1_COMP *cpi, int filter_level, int partial_frame, RestorationInfo *rsi,
+    RestSearch *s, RestorationInfo *rsi,
     double *tile_cost[RESTORE_SWITCHABLE_TYPES]) {
-  AV1_COMMON *const cm = &cpi->common;
-  MACROBLOCK *x = &cpi->td.mb;
+  MACROBLOCK *x = &s->cpi->td.mb;
   double cost_switchable = 0;
   int r, bits, tile_idx;
-  const int ntiles =
-      av1_get_rest_ntiles(cm->width, cm->height, NULL, NULL, NULL, NULL);
-
-  //  Make a copy of the unfiltered / processed recon buffer
-  aom_yv12_copy_y(cm->frame_to_show, &cpi->last_frame_uf);
-  av1_loop_filter_frame(cm->frame_to_show, cm, &cpi->td.mb.e_mbd, filter_level,
-                        1, partial_frame);
-  aom_yv12_copy_y(cm->frame_to_show, &cpi->last_frame_db);
 
   rsi->frame_restoration_type = RESTORE_SWITCHABLE;
   bits = frame_level_restore_bits[rsi->frame_restoration_type]
          << AV1_PROB_COST_SHIFT;
   cost_switchable = RDCOST_DBL(x->rdmult, x->rddiv, bits >> 4, 0);
-  for (tile_idx = 0; tile_idx < ntiles; ++tile_idx) {
+  for (tile_idx = 0; tile_idx < s->ntiles; ++tile_idx) {
     double best_cost = tile_cost[RESTORE_NONE][tile_idx];
     rsi->restoration_type[tile_idx] = RESTORE_NONE;
     for (r = 1; r < RESTORE_SWITCHABLE_TYPES; r++) {
@@ -1166,10 +1351,78 @@ static double search_switchable_restoration(
     }
     cost_switchable += best_cost;
   }
-  aom_yv12_copy_y(&cpi->last_frame_uf, cm->frame_to_show);
   return cost_switchable;
 }
 
+static void rest_search_init(RestSearch *s, const YV12_BUFFER_CONFIG *src,
+                             AV1_COMP *cpi, int partial_frame) {
+  AV1_COMMON *const cm = &cpi->common;
+  int i, tile_idx, h_start, h_end, v_start, v_end;
+
+  memset(s, 0, sizeof(*s));
+  s->cpi = cpi;
+  s->src = src;
+  s->partial_frame = partial_frame;
+  s->ntiles = av1_get_rest_ntiles(cm->width, cm->height, &s->tile_width,
+                                  &s->tile_height, &s->nhtiles, &s->nvtiles);
+  s->num_threads = cpi->oxcf.max_threads > 1 && !partial_frame
+                       ? AOMMAX(cpi->num_workers, cpi->oxcf.max_threads)
+                       : 1;
+  CHECK_MEM_ERROR(cm, s->tile_sse,
+                  aom_malloc(s->ntiles * sizeof(*s->tile_sse)));
+  CHECK_MEM_ERROR(cm, s->tile_err,
+                  aom_malloc(s->ntiles * sizeof(*s->tile_err)));
+  if (s->num_threads > cpi->num_rest_search_threads) {
+    RestSearchThread *threads;
+    CHECK_MEM_ERROR(cm, threads,
+                    aom_calloc(s->num_threads, sizeof(*threads)));
+    if (cpi->num_rest_search_threads > 0)
+      memcpy(threads, cpi->rest_search_threads,
+             cpi->num_rest_search_threads * sizeof(*threads));
+    aom_free(cpi->rest_search_threads);
+    cpi->rest_search_threads = threads;
+    cpi->num_rest_search_threads = s->num_threads;
+  }
+  s->threads = cpi->rest_search_threads;
+  for (i = 0; i < s->num_threads; ++i) {
+    RestSearchThread *const t = &s->threads[i];
+    // The frames are only reallocated when the frame size grows.
+    if (!partial_frame) {
+      av1_alloc_restoration_tmp_frame(&t->frame, cm);
+      av1_alloc_restoration_tmp_frame(&t->tmp_frame, cm);
+    }
+    if (t->tmpbuf == NULL)
+      CHECK_MEM_ERROR(cm, t->tmpbuf, aom_malloc(REST_SEARCH_TMPBUF_SIZE));
+  }
+  for (tile_idx = 0; tile_idx < s->ntiles; ++tile_idx) {
+    av1_get_rest_tile_limits(tile_idx, 0, 0, s->nhtiles, s->nvtiles,
+                             s->tile_width, s->tile_height, cm->width,
+                             cm->height, 0, 0, &h_start, &h_end, &v_start,
+                             &v_end);
+    s->tile_sse[tile_idx] =
+        sse_restoration_tile(src, cm->frame_to_show, cm, h_start,
+                             h_end - h_start, v_start, v_end - v_start);
+  }
+}
+
+static void rest_search_free(RestSearch *s) {
+  aom_free(s->tile_sse);
+  aom_free(s->tile_err);
+}
+
+void av1_free_rest_search_threads(AV1_COMP *cpi) {
+  int i;
+  for (i = 0; i < cpi->num_rest_search_threads; ++i) {
+    RestSearchThread *const t = &cpi->rest_search_threads[i];
+    aom_free_frame_buffer(&t->frame);
+    aom_free_frame_buffer(&t->tmp_frame);
+    aom_free(t->tmpbuf);
+  }
+  aom_free(cpi->rest_search_threads);
+  cpi->rest_search_threads = NULL;
+  cpi->num_rest_search_threads = 0;
+}
+
 void av1_pick_filter_restoration(const YV12_BUFFER_CONFIG *src, AV1_COMP *cpi,
                                  LPF_PICK_METHOD method) {
   static search_restore_type search_restore_fun[RESTORE_SWITCHABLE_TYPES] = {
@@ -1178,6 +1431,7 @@ void av1_pick_filter_restoration(const YV12_BUFFER_CONFIG *src, AV1_COMP *cpi,
   };
   AV1_COMMON *const cm = &cpi->common;
   struct loopfilter *const lf = &cm->lf;
+  RestSearch s;
   double cost_restore[RESTORE_TYPES];
   double *tile_cost[RESTORE_SWITCHABLE_TYPES];
   double best_cost_restore;
@@ -1245,14 +1499,23 @@ void av1_pick_filter_restoration(const YV12_BUFFER_CONFIG *src, AV1_COMP *cpi,
         av1_search_filter_level(src, cpi, method == LPF_PICK_FROM_SUBIMAGE,
                                 &cost_restore[RESTORE_NONE]);
   }
+
+  // Every type is searched on the same deblocked frame, which is made once.
+  aom_yv12_copy_y(cm->frame_to_show, &cpi->last_frame_uf);
+  av1_loop_filter_frame(cm->frame_to_show, cm, &cpi->td.mb.e_mbd,
+                        lf->filter_level, 1, method == LPF_PICK_FROM_SUBIMAGE);
+  aom_yv12_copy_y(cm->frame_to_show, &cpi->last_frame_db);
+  rest_search_init(&s, src, cpi, method == LPF_PICK_FROM_SUBIMAGE);
+
   for (r = 0; r < RESTORE_SWITCHABLE_TYPES; ++r) {
-    cost_restore[r] = search_restore_fun[r](src, cpi, lf->filter_level,
-                                            method == LPF_PICK_FROM_SUBIMAGE,
-                                            &cm->rst_info, tile_cost[r]);
+    cost_restore[r] =
+        search_restore_fun[r](&s, &cm->rst_info, tile_cost[r]);
   }
-  cost_restore[RESTORE_SWITCHABLE] = search_switchable_restoration(
-      cpi, lf->filter_level, method == LPF_PICK_FROM_SUBIMAGE, &cm->rst_info,
-      tile_cost);
+  cost_restore[RESTORE_SWITCHABLE] =
+      search_switchable_restoration(&s, &cm->rst_info, tile_cost);
+
+  rest_search_free(&s);
+  aom_yv12_copy_y(&cpi->last_frame_uf, cm->frame_to_show);
 
   best_cost_restore = DBL_MAX;
   best_restore = 0;
@@ -23,6 +23,9 @@ struct AV1_COMP;
 void av1_pick_filter_restoration(const YV12_BUFFER_CONFIG *sd, AV1_COMP *cpi,
                                  LPF_PICK_METHOD method);
 
+// Frees the scratch that av1_pick_filter_restoration() keeps for its threads.
+void av1_free_rest_search_threads(AV1_COMP *cpi);
+
 #ifdef __cplusplus
 }  // extern "C"
 #endif
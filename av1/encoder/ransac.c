@@ -15,9 +15,9 @@
 #include <stdlib.h>
 #include <assert.h>
 
+#include "aom_mem/aom_mem.h"
 #include "av1/encoder/ransac.h"
 
-#define MAX_MINPTS 4
 #define MAX_DEGENERATE_ITER 10
 #define MINPTS_MULTIPLIER 5
 
@@ -93,244 +93,373 @@ static void project_points_double_homography(double *mat, double *points,
   }
 }
 
+// Draws minpts of the points. Each point after the first is found by
+// stepping a random number of times from the one before (the point after the
+// first one for the second), over the points not drawn yet. The steps are
+// taken all at once: a whole cycle over the points not drawn yet ends where
+// it started, and the drawn points within reach add one step each, in the
+// order they are met.
 static int get_rand_indices(int npoints, int minpts, int *indices,
                             unsigned int *seed) {
-  int i, j;
+  int i, j, k;
   int ptr = rand_r(seed) % npoints;
   if (minpts > npoints) return 0;
   indices[0] = ptr;
   ptr = (ptr == npoints - 1 ? 0 : ptr + 1);
-  i = 1;
-  while (i < minpts) {
-    int index = rand_r(seed) % npoints;
-    while (index) {
-      ptr = (ptr == npoints - 1 ? 0 : ptr + 1);
+  for (i = 1; i < minpts; ++i) {
+    const int index = rand_r(seed) % npoints;
+    if (index) {
+      // Distances ahead of ptr of the points drawn, in increasing order. A
+      // point is drawn again right after itself when no step is taken.
+      int dist[RANSAC_MAX_MINPTS];
+      int n = 0, drawn = 0, steps;
       for (j = 0; j < i; ++j) {
-        if (indices[j] == ptr) break;
+        const int d = (indices[j] - ptr + npoints) % npoints;
+        if (j > 0 && indices[j] == indices[j - 1]) continue;
+        drawn++;
+        if (d == 0) continue;
+        for (k = n++; k > 0 && dist[k - 1] > d; --k) dist[k] = dist[k - 1];
+        dist[k] = d;
       }
-      if (j == i) index--;
+      steps = (index - 1) % (npoints - drawn) + 1;
+      for (j = 0; j < n && dist[j] <= steps; ++j) steps++;
+      ptr = (ptr + steps) % npoints;
     }
-    indices[i++] = ptr;
+    indices[i] = ptr;
   }
   return 1;
 }
 
-static int ransac(double *matched_points, int npoints, int *number_of_inliers,
-                  int *best_inlier_mask, double *best_params, const int minpts,
-                  IsDegenerateFunc is_degenerate,
-                  FindTransformationFunc find_transformation,
-                  ProjectPointsDoubleFunc projectpoints) {
-  static const double inlier_threshold = 1.0;
-  static const double PROBABILITY_REQUIRED = 0.9;
-  static const double EPS = 1e-12;
-  static const int MIN_TRIALS = 20;
-
-  int N = 10000, trial_count = 0;
+static int is_collinear3(double *p1, double *p2, double *p3) {
+  static const double collinear_eps = 1e-3;
+  const double v =
+      (p2[0] - p1[0]) * (p3[1] - p1[1]) - (p2[1] - p1[1]) * (p3[0] - p1[0]);
+  return fabs(v) < collinear_eps;
+}
+
+static int is_degenerate_translation(double *p) {
+  return (p[0] - p[2]) * (p[0] - p[2]) + (p[1] - p[3]) * (p[1] - p[3]) <= 2;
+}
+
+static int is_degenerate_affine(double *p) {
+  return is_collinear3(p, p + 2, p + 4);
+}
+
+static int is_degenerate_homography(double *p) {
+  return is_collinear3(p, p + 2, p + 4) || is_collinear3(p, p + 2, p + 6) ||
+         is_collinear3(p, p + 4, p + 6) || is_collinear3(p + 2, p + 4, p + 6);
+}
+
+// Number of points projected at a time when scoring a trial.
+#define SCORE_CHUNK 64
+
+static const double inlier_threshold = 1.0;
+static const double PROBABILITY_REQUIRED = 0.9;
+static const double EPS = 1e-12;
+static const int MIN_TRIALS = 20;
+static const int MAX_TRIALS = 10000;
+
+typedef struct {
+  int minpts;
+  IsDegenerateFunc is_degenerate;
+  FindTransformationFunc find_transformation;
+  ProjectPointsDoubleFunc project_points;
+} RansacModel;
+
+static const RansacModel *get_ransac_model(TransformationType type) {
+  static const RansacModel models[TRANS_TYPES] = {
+    { 0, NULL, NULL, NULL },
+    { 3, is_degenerate_translation, find_translation,
+      project_points_double_translation },
+    { 3, is_degenerate_affine, find_rotzoom, project_points_double_rotzoom },
+    { 3, is_degenerate_affine, find_affine, project_points_double_affine },
+    { 4, is_degenerate_homography, find_homography,
+      project_points_double_homography },
+  };
+  assert(type > IDENTITY && type < TRANS_TYPES);
+  return &models[type];
+}
+
+void ransac_fit_free(RansacFit *fit) {
+  int i;
+  if (fit == NULL) return;
+  if (fit->trials) {
+    for (i = 0; i < fit->max_batch; ++i) aom_free(fit->trials[i].inlier_mask);
+  }
+  aom_free(fit->trials);
+  aom_free(fit->corners1);
+  aom_free(fit->corners2);
+  aom_free(fit->best_inlier_mask);
+  aom_free(fit);
+}
+
+RansacFit *ransac_fit_alloc(TransformationType type, double *matched_points,
+                            int npoints, int max_batch) {
+  const int minpts = get_ransac_model(type)->minpts;
+  RansacFit *fit;
   int i;
-  int ret_val = 0;
-  unsigned int seed = (unsigned int)npoints;
-
-  int max_inliers = 0;
-  double best_variance = 0.0;
-  double params[MAX_PARAMDIM];
-  WarpedMotionParams wm;
-  double points1[2 * MAX_MINPTS];
-  double points2[2 * MAX_MINPTS];
-  int indices[MAX_MINPTS] = { 0 };
-
-  double *best_inlier_set1;
-  double *best_inlier_set2;
-  double *inlier_set1;
-  double *inlier_set2;
-  double *corners1;
-  double *corners2;
-  double *image1_coord;
-  int *inlier_mask;
-
-  double *cnp1, *cnp2;
 
-  *number_of_inliers = 0;
   if (npoints < minpts * MINPTS_MULTIPLIER || npoints == 0) {
     printf("Cannot find motion with %d matches\n", npoints);
-    return 1;
+    return NULL;
   }
 
-  memset(&wm, 0, sizeof(wm));
-  best_inlier_set1 =
-      (double *)aom_malloc(sizeof(*best_inlier_set1) * npoints * 2);
-  best_inlier_set2 =
-      (double *)aom_malloc(sizeof(*best_inlier_set2) * npoints * 2);
-  inlier_set1 = (double *)aom_malloc(sizeof(*inlier_set1) * npoints * 2);
-  inlier_set2 = (double *)aom_malloc(sizeof(*inlier_set2) * npoints * 2);
-  corners1 = (double *)aom_malloc(sizeof(*corners1) * npoints * 2);
-  corners2 = (double *)aom_malloc(sizeof(*corners2) * npoints * 2);
-  image1_coord = (double *)aom_malloc(sizeof(*image1_coord) * npoints * 2);
-  inlier_mask = (int *)aom_malloc(sizeof(*inlier_mask) * npoints);
-
-  if (!(best_inlier_set1 && best_inlier_set2 && inlier_set1 && inlier_set2 &&
-        corners1 && corners2 && image1_coord && inlier_mask)) {
-    ret_val = 1;
-    goto finish_ransac;
+  fit = (RansacFit *)aom_calloc(1, sizeof(*fit));
+  if (fit == NULL) return NULL;
+  fit->type = type;
+  fit->npoints = npoints;
+  fit->minpts = minpts;
+  fit->seed = (unsigned int)npoints;
+  fit->max_trials = MAX_TRIALS;
+  fit->max_batch = AOMMAX(max_batch, 1);
+  fit->corners1 = (double *)aom_malloc(sizeof(*fit->corners1) * npoints * 2);
+  fit->corners2 = (double *)aom_malloc(sizeof(*fit->corners2) * npoints * 2);
+  fit->best_inlier_mask =
+      (int *)aom_calloc(npoints, sizeof(*fit->best_inlier_mask));
+  fit->trials =
+      (RansacTrial *)aom_calloc(fit->max_batch, sizeof(*fit->trials));
+  if (!(fit->corners1 && fit->corners2 && fit->best_inlier_mask &&
+        fit->trials)) {
+    ransac_fit_free(fit);
+    return NULL;
+  }
+  for (i = 0; i < fit->max_batch; ++i) {
+    fit->trials[i].inlier_mask =
+        (int *)aom_malloc(sizeof(*fit->trials[i].inlier_mask) * npoints);
+    if (fit->trials[i].inlier_mask == NULL) {
+      ransac_fit_free(fit);
+      return NULL;
+    }
   }
 
-  for (cnp1 = corners1, cnp2 = corners2, i = 0; i < npoints; ++i) {
-    *(cnp1++) = *(matched_points++);
-    *(cnp1++) = *(matched_points++);
-    *(cnp2++) = *(matched_points++);
-    *(cnp2++) = *(matched_points++);
+  for (i = 0; i < npoints; ++i) {
+    fit->corners1[i * 2] = *(matched_points++);
+    fit->corners1[i * 2 + 1] = *(matched_points++);
+    fit->corners2[i * 2] = *(matched_points++);
+    fit->corners2[i * 2 + 1] = *(matched_points++);
   }
-  matched_points -= 4 * npoints;
-
-  while (N > trial_count) {
-    int num_inliers = 0;
-    double sum_distance = 0.0;
-    double sum_distance_squared = 0.0;
-
-    int degenerate = 1;
-    int num_degenerate_iter = 0;
-    while (degenerate) {
-      num_degenerate_iter++;
-      if (!get_rand_indices(npoints, minpts, indices, &seed)) {
-        ret_val = 1;
-        goto finish_ransac;
-      }
-      i = 0;
-      while (i < minpts) {
-        int index = indices[i];
-        // add to list
-        points1[i * 2] = corners1[index * 2];
-        points1[i * 2 + 1] = corners1[index * 2 + 1];
-        points2[i * 2] = corners2[index * 2];
-        points2[i * 2 + 1] = corners2[index * 2 + 1];
-        i++;
-      }
-      degenerate = is_degenerate(points1);
-      if (num_degenerate_iter > MAX_DEGENERATE_ITER) {
-        ret_val = 1;
-        goto finish_ransac;
-      }
-    }
+  return fit;
+}
 
-    if (find_transformation(minpts, points1, points2, params)) {
-      trial_count++;
-      continue;
-    }
+// Draws the points of a trial, drawing again while they are degenerate.
+// Returns 0 if no usable points were found.
+static int draw_trial(RansacFit *fit, RansacTrial *trial) {
+  const RansacModel *const model = get_ransac_model(fit->type);
+  int indices[RANSAC_MAX_MINPTS] = { 0 };
+  int degenerate = 1;
+  int num_degenerate_iter = 0;
+  int i;
 
-    projectpoints(params, corners1, image1_coord, npoints, 2, 2);
+  while (degenerate) {
+    num_degenerate_iter++;
+    if (!get_rand_indices(fit->npoints, fit->minpts, indices, &fit->seed))
+      return 0;
+    for (i = 0; i < fit->minpts; ++i) {
+      const int index = indices[i];
+      trial->points1[i * 2] = fit->corners1[index * 2];
+      trial->points1[i * 2 + 1] = fit->corners1[index * 2 + 1];
+      trial->points2[i * 2] = fit->corners2[index * 2];
+      trial->points2[i * 2 + 1] = fit->corners2[index * 2 + 1];
+    }
+    degenerate = model->is_degenerate(trial->points1);
+    if (num_degenerate_iter > MAX_DEGENERATE_ITER) return 0;
+  }
+  return 1;
+}
 
-    for (i = 0; i < npoints; ++i) {
-      double dx = image1_coord[i * 2] - corners2[i * 2];
-      double dy = image1_coord[i * 2 + 1] - corners2[i * 2 + 1];
-      double distance = sqrt(dx * dx + dy * dy);
+int ransac_fit_next_batch(RansacFit *fit) {
+  // The number of trials needed only goes down as better models are found,
+  // so no more than this many will be used.
+  const int max_batch =
+      AOMMIN(fit->max_batch, fit->max_trials - fit->trial_count);
+  int t;
+
+  fit->num_trials = 0;
+  fit->draw_failed = 0;
+  if (fit->failed) return 0;
+  for (t = 0; t < max_batch; ++t) {
+    if (!draw_trial(fit, &fit->trials[t])) {
+      fit->draw_failed = 1;
+      break;
+    }
+  }
+  fit->num_trials = t;
+  // The first trial of a batch is always run, so the fit fails here if it
+  // could not be drawn.
+  if (t == 0 && fit->draw_failed) fit->failed = 1;
+  return t;
+}
 
-      inlier_mask[i] = distance < inlier_threshold;
-      if (inlier_mask[i]) {
-        inlier_set1[num_inliers * 2] = corners1[i * 2];
-        inlier_set1[num_inliers * 2 + 1] = corners1[i * 2 + 1];
-        inlier_set2[num_inliers * 2] = corners2[i * 2];
-        inlier_set2[num_inliers * 2 + 1] = corners2[i * 2 + 1];
+void ransac_fit_score(RansacFit *fit, int t) {
+  const RansacModel *const model = get_ransac_model(fit->type);
+  RansacTrial *const trial = &fit->trials[t];
+  // The best model is only replaced between batches, so a trial with fewer
+  // inliers than it has now cannot be chosen.
+  const int min_inliers = fit->max_inliers;
+  double proj[2 * SCORE_CHUNK];
+  int num_inliers = 0;
+  double sum_distance = 0.0;
+  double sum_distance_squared = 0.0;
+  int i, j, n;
+
+  trial->rejected = 1;
+  if (model->find_transformation(fit->minpts, trial->points1, trial->points2,
+                                 trial->params))
+    return;
+
+  for (i = 0; i < fit->npoints; i += n) {
+    n = AOMMIN(SCORE_CHUNK, fit->npoints - i);
+    model->project_points(trial->params, fit->corners1 + i * 2, proj, n, 2, 2);
+    for (j = 0; j < n; ++j) {
+      const double dx = proj[j * 2] - fit->corners2[(i + j) * 2];
+      const double dy = proj[j * 2 + 1] - fit->corners2[(i + j) * 2 + 1];
+      const double distance = sqrt(dx * dx + dy * dy);
+      const int inlier = distance < inlier_threshold;
+
+      trial->inlier_mask[i + j] = inlier;
+      if (inlier) {
         num_inliers++;
         sum_distance += distance;
         sum_distance_squared += distance * distance;
       }
     }
+    // Stop as soon as the remaining points cannot make up the difference.
+    if (num_inliers + fit->npoints - i - n < min_inliers) return;
+  }
+  trial->rejected = 0;
+  trial->num_inliers = num_inliers;
+  trial->sum_distance = sum_distance;
+  trial->sum_distance_squared = sum_distance_squared;
+}
+
+void ransac_fit_update(RansacFit *fit) {
+  int t;
+  for (t = 0; t < fit->num_trials && fit->max_trials > fit->trial_count;
+       ++t) {
+    const RansacTrial *const trial = &fit->trials[t];
+    const int num_inliers = trial->num_inliers;
+    fit->trial_count++;
 
-    if (num_inliers >= max_inliers && num_inliers > 1) {
+    if (!trial->rejected && num_inliers >= fit->max_inliers &&
+        num_inliers > 1) {
       int temp;
       double fracinliers, pNoOutliers, mean_distance, variance;
 
-      mean_distance = sum_distance / ((double)num_inliers);
-      variance = sum_distance_squared / ((double)num_inliers - 1.0) -
+      mean_distance = trial->sum_distance / ((double)num_inliers);
+      variance = trial->sum_distance_squared / ((double)num_inliers - 1.0) -
                  mean_distance * mean_distance * ((double)num_inliers) /
                      ((double)num_inliers - 1.0);
-      if ((num_inliers > max_inliers) ||
-          (num_inliers == max_inliers && variance < best_variance)) {
-        best_variance = variance;
-        max_inliers = num_inliers;
+      if ((num_inliers > fit->max_inliers) ||
+          (num_inliers == fit->max_inliers && variance < fit->best_variance)) {
+        fit->best_variance = variance;
+        fit->max_inliers = num_inliers;
         // Save parameters, excluding the implicit '1' in the bottom-right
         // entry of the parameter matrix
-        memcpy(best_params, params, (MAX_PARAMDIM - 1) * sizeof(*best_params));
-        memcpy(best_inlier_set1, inlier_set1,
-               num_inliers * 2 * sizeof(*best_inlier_set1));
-        memcpy(best_inlier_set2, inlier_set2,
-               num_inliers * 2 * sizeof(*best_inlier_set2));
-        memcpy(best_inlier_mask, inlier_mask,
-               npoints * sizeof(*best_inlier_mask));
-
-        assert(npoints > 0);
-        fracinliers = (double)num_inliers / (double)npoints;
-        pNoOutliers = 1 - pow(fracinliers, minpts);
+        memcpy(fit->best_params, trial->params,
+               (MAX_PARAMDIM - 1) * sizeof(*fit->best_params));
+        memcpy(fit->best_inlier_mask, trial->inlier_mask,
+               fit->npoints * sizeof(*fit->best_inlier_mask));
+
+        assert(fit->npoints > 0);
+        fracinliers = (double)num_inliers / (double)fit->npoints;
+        pNoOutliers = 1 - pow(fracinliers, fit->minpts);
         pNoOutliers = fmax(EPS, pNoOutliers);
         pNoOutliers = fmin(1 - EPS, pNoOutliers);
         temp = (int)(log(1.0 - PROBABILITY_REQUIRED) / log(pNoOutliers));
-        if (temp > 0 && temp < N) {
-          N = AOMMAX(temp, MIN_TRIALS);
+        if (temp > 0 && temp < fit->max_trials) {
+          fit->max_trials = AOMMAX(temp, MIN_TRIALS);
         }
       }
     }
-    trial_count++;
   }
-  find_transformation(max_inliers, best_inlier_set1, best_inlier_set2,
-                      best_params);
-  *number_of_inliers = max_inliers;
-finish_ransac:
-  aom_free(best_inlier_set1);
-  aom_free(best_inlier_set2);
-  aom_free(inlier_set1);
-  aom_free(inlier_set2);
-  aom_free(corners1);
-  aom_free(corners2);
-  aom_free(image1_coord);
-  aom_free(inlier_mask);
-  return ret_val;
+  // The trial that could not be drawn is only reached if the fit has not
+  // finished before it.
+  if (t == fit->num_trials && fit->draw_failed &&
+      fit->max_trials > fit->trial_count)
+    fit->failed = 1;
+  fit->num_trials = 0;
+  fit->draw_failed = 0;
 }
 
-static int is_collinear3(double *p1, double *p2, double *p3) {
-  static const double collinear_eps = 1e-3;
-  const double v =
-      (p2[0] - p1[0]) * (p3[1] - p1[1]) - (p2[1] - p1[1]) * (p3[0] - p1[0]);
-  return fabs(v) < collinear_eps;
-}
+int ransac_fit_finish(RansacFit *fit, int *number_of_inliers,
+                      int *best_inlier_mask, double *best_params) {
+  const RansacModel *const model = get_ransac_model(fit->type);
+  double *inlier_set1, *inlier_set2;
+  int i, n = 0;
 
-static int is_degenerate_translation(double *p) {
-  return (p[0] - p[2]) * (p[0] - p[2]) + (p[1] - p[3]) * (p[1] - p[3]) <= 2;
-}
+  *number_of_inliers = 0;
+  if (fit->failed || fit->max_inliers == 0) return 1;
+  inlier_set1 =
+      (double *)aom_malloc(sizeof(*inlier_set1) * fit->max_inliers * 2);
+  inlier_set2 =
+      (double *)aom_malloc(sizeof(*inlier_set2) * fit->max_inliers * 2);
+  if (!(inlier_set1 && inlier_set2)) {
+    aom_free(inlier_set1);
+    aom_free(inlier_set2);
+    return 1;
+  }
+  for (i = 0; i < fit->npoints; ++i) {
+    if (!fit->best_inlier_mask[i]) continue;
+    inlier_set1[n * 2] = fit->corners1[i * 2];
+    inlier_set1[n * 2 + 1] = fit->corners1[i * 2 + 1];
+    inlier_set2[n * 2] = fit->corners2[i * 2];
+    inlier_set2[n * 2 + 1] = fit->corners2[i * 2 + 1];
+    n++;
+  }
+  assert(n == fit->max_inliers);
+  model->find_transformation(n, inlier_set1, inlier_set2, fit->best_params);
+  aom_free(inlier_set1);
+  aom_free(inlier_set2);
 
-static int is_degenerate_affine(double *p) {
-  return is_collinear3(p, p + 2, p + 4);
+  memcpy(best_params, fit->best_params,
+         (MAX_PARAMDIM - 1) * sizeof(*best_params));
+  memcpy(best_inlier_mask, fit->best_inlier_mask,
+         fit->npoints * sizeof(*best_inlier_mask));
+  *number_of_inliers = fit->max_inliers;
+  return 0;
 }
 
-static int is_degenerate_homography(double *p) {
-  return is_collinear3(p, p + 2, p + 4) || is_collinear3(p, p + 2, p + 6) ||
-         is_collinear3(p, p + 4, p + 6) || is_collinear3(p + 2, p + 4, p + 6);
+// Runs a fit one trial at a time.
+static int ransac(TransformationType type, double *matched_points,
+                  int npoints, int *number_of_inliers, int *best_inlier_mask,
+                  double *best_params) {
+  RansacFit *const fit = ransac_fit_alloc(type, matched_points, npoints, 1);
+  int ret_val;
+
+  *number_of_inliers = 0;
+  if (fit == NULL) return 1;
+  while (ransac_fit_next_batch(fit)) {
+    ransac_fit_score(fit, 0);
+    ransac_fit_update(fit);
+  }
+  ret_val =
+      ransac_fit_finish(fit, number_of_inliers, best_inlier_mask, best_params);
+  ransac_fit_free(fit);
+  return ret_val;
 }
 
 int ransac_translation(double *matched_points, int npoints,
                        int *number_of_inliers, int *best_inlier_mask,
                        double *best_params) {
-  return ransac(matched_points, npoints, number_of_inliers, best_inlier_mask,
-                best_params, 3, is_degenerate_translation, find_translation,
-                project_points_double_translation);
+  return ransac(TRANSLATION, matched_points, npoints, number_of_inliers,
+                best_inlier_mask, best_params);
 }
 
 int ransac_rotzoom(double *matched_points, int npoints, int *number_of_inliers,
                    int *best_inlier_mask, double *best_params) {
-  return ransac(matched_points, npoints, number_of_inliers, best_inlier_mask,
-                best_params, 3, is_degenerate_affine, find_rotzoom,
-                project_points_double_rotzoom);
+  return ransac(ROTZOOM, matched_points, npoints, number_of_inliers,
+                best_inlier_mask, best_params);
 }
 
 int ransac_affine(double *matched_points, int npoints, int *number_of_inliers,
                   int *best_inlier_mask, double *best_params) {
-  return ransac(matched_points, npoints, number_of_inliers, best_inlier_mask,
-                best_params, 3, is_degenerate_affine, find_affine,
-                project_points_double_affine);
+  return ransac(AFFINE, matched_points, npoints, number_of_inliers,
+                best_inlier_mask, best_params);
 }
 
 int ransac_homography(double *matched_points, int npoints,
                       int *number_of_inliers, int *best_inlier_mask,
                       double *best_params) {
-  return ransac(matched_points, npoints, number_of_inliers, best_inlier_mask,
-                best_params, 4, is_degenerate_homography, find_homography,
-                project_points_double_homography);
+  return ransac(HOMOGRAPHY, matched_points, npoints, number_of_inliers,
+                best_inlier_mask, best_params);
 }
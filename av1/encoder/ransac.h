@@ -19,6 +19,12 @@
 
 #include "av1/common/warped_motion.h"
 
+#define RANSAC_MAX_MINPTS 4
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
 typedef int (*RansacFunc)(double *matched_points, int npoints,
                           int *number_of_inliers, int *best_inlier_mask,
                           double *best_params);
@@ -35,4 +41,71 @@ int ransac_rotzoom(double *matched_points, int npoints, int *number_of_inliers,
 int ransac_translation(double *matched_points, int npoints,
                        int *number_of_inliers, int *best_inlier_indices,
                        double *best_params);
+
+typedef struct RansacTrial {
+  double points1[2 * RANSAC_MAX_MINPTS];
+  double points2[2 * RANSAC_MAX_MINPTS];
+  double params[MAX_PARAMDIM];
+  // Set if no model could be fit to the points, or if the model was found
+  // to have too few inliers to be the best one before all the points were
+  // scored.
+  int rejected;
+  int num_inliers;
+  double sum_distance;
+  double sum_distance_squared;
+  int *inlier_mask;
+} RansacTrial;
+
+/* A RANSAC fit that runs its trials in batches, so that the trials of a
+batch can be scored on different threads. The trials are drawn and folded
+into the best model in the same order as when they are run one at a time,
+and the number of trials adapts to the inlier ratio of the best model, so
+the model found does not depend on the batch size. */
+typedef struct RansacFit {
+  TransformationType type;
+  int npoints;
+  int minpts;
+  double *corners1;
+  double *corners2;
+  unsigned int seed;
+  int max_trials;
+  int trial_count;
+  int failed;
+  int max_inliers;
+  double best_variance;
+  double best_params[MAX_PARAMDIM];
+  int *best_inlier_mask;
+  // The trials of the current batch. If draw_failed is set, the trial after
+  // the last one could not be drawn.
+  RansacTrial *trials;
+  int max_batch;
+  int num_trials;
+  int draw_failed;
+} RansacFit;
+
+// Sets up a fit of a model of the given type to the matched points, given
+// as (x1, y1, x2, y2). Returns NULL if there are too few points or memory
+// could not be allocated.
+RansacFit *ransac_fit_alloc(TransformationType type, double *matched_points,
+                            int npoints, int max_batch);
+void ransac_fit_free(RansacFit *fit);
+
+// Draws the next batch of at most max_batch trials. Returns the number of
+// trials drawn, or 0 once the fit is complete.
+int ransac_fit_next_batch(RansacFit *fit);
+
+// Fits and scores a trial of the current batch. The trials of a batch may
+// be scored at the same time.
+void ransac_fit_score(RansacFit *fit, int trial);
+
+// Folds the scored trials of the current batch into the best model.
+void ransac_fit_update(RansacFit *fit);
+
+// Refits the best model to all of its inliers. Returns 0 on success.
+int ransac_fit_finish(RansacFit *fit, int *number_of_inliers,
+                      int *best_inlier_mask, double *best_params);
+
+#ifdef __cplusplus
+}  // extern "C"
+#endif
 #endif  // AV1_ENCODER_RANSAC_H_
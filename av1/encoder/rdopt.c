@@ -1170,6 +1170,120 @@ static uint64_t sum_squares_2d(const int16_t *diff, int diff_stride,
   return sse;
 }
 
+void av1_reset_txfm_rd_cache(TXFM_RD_CACHE *cache) {
+  if (++cache->generation == 0) {
+    memset(cache->results, 0, sizeof(cache->results));
+    cache->generation = 1;
+  }
+}
+
+#if !CONFIG_PVQ
+#define TXFM_RD_HASH_MULT (((uint64_t)0x9E3779B9 << 32) | 0x7F4A7C15)
+
+// Mixes the first w bytes of each of the h rows of buf into hash.
+static uint64_t hash_rows(uint64_t hash, const uint8_t *buf, int stride, int w,
+                          int h) {
+  int i, j;
+  for (i = 0; i < h; ++i, buf += stride) {
+    for (j = 0; j + 8 <= w; j += 8) {
+      uint64_t v;
+      memcpy(&v, buf + j, sizeof(v));
+      hash = (hash ^ v) * TXFM_RD_HASH_MULT;
+      hash ^= hash >> 32;
+    }
+    for (; j < w; ++j) {
+      hash = (hash ^ buf[j]) * TXFM_RD_HASH_MULT;
+      hash ^= hash >> 32;
+    }
+  }
+  return hash;
+}
+
+// Finds the slot of a transform block in the transform RD cache of x, and
+// sets *hit when it holds the results of the block. The results depend on
+// the residual, on the coding parameters of the block and on |params|, which
+// the caller fills in with whatever else its results depend on. When the
+// distortion is measured on the reconstruction, which is clipped, they
+// depend on the prediction as well, and |hash_pred| is set. Returns NULL when
+// there is no cache.
+static TXFM_RD_RESULT *find_txfm_rd_result(MACROBLOCK *x, int plane, int block,
+                                           int blk_row, int blk_col,
+                                           BLOCK_SIZE plane_bsize,
+                                           TX_SIZE tx_size, int coeff_ctx,
+                                           int hash_pred, uint64_t params,
+                                           int *hit) {
+  TXFM_RD_CACHE *const cache = x->txfm_rd_cache;
+  const MACROBLOCKD *const xd = &x->e_mbd;
+  const struct macroblockd_plane *const pd = &xd->plane[plane];
+  const PLANE_TYPE plane_type = plane == 0 ? PLANE_TYPE_Y : PLANE_TYPE_UV;
+  const int diff_stride = block_size_wide[plane_bsize];
+  const int16_t *const diff =
+      &x->plane[plane].src_diff[(blk_row * diff_stride + blk_col)
+                                << tx_size_wide_log2[0]];
+  const int w = tx_size_wide[tx_size];
+  const int h = tx_size_high[tx_size];
+  uint64_t hash;
+  TXFM_RD_RESULT *result;
+
+  *hit = 0;
+  if (cache == NULL) return NULL;
+
+  hash = hash_rows(0, (const uint8_t *)diff, diff_stride * (int)sizeof(*diff),
+                   w * (int)sizeof(*diff), h);
+  if (hash_pred) {
+    const int dst_stride = pd->dst.stride;
+    const uint8_t *const dst =
+        &pd->dst.buf[(blk_row * dst_stride + blk_col) << tx_size_wide_log2[0]];
+#if CONFIG_AOM_HIGHBITDEPTH
+    if (xd->cur_buf->flags & YV12_FLAG_HIGHBITDEPTH)
+      hash = hash_rows(hash, (const uint8_t *)CONVERT_TO_SHORTPTR(dst),
+                       dst_stride * (int)sizeof(uint16_t),
+                       w * (int)sizeof(uint16_t), h);
+    else
+#endif  // CONFIG_AOM_HIGHBITDEPTH
+      hash = hash_rows(hash, dst, dst_stride, w, h);
+  }
+
+  // The low 32 bits are the parameters shared by the callers.
+  assert(tx_size < 32 && coeff_ctx < 16 && x->qindex < 256);
+  params |= (uint64_t)tx_size;
+  params |= (uint64_t)get_tx_type(plane_type, xd, block, tx_size) << 5;
+  params |= (uint64_t)plane << 10;
+  params |= (uint64_t)coeff_ctx << 12;
+  params |= (uint64_t)x->qindex << 16;
+  params |= (uint64_t)xd->mi[0]->mbmi.segment_id << 24;
+  params |= (uint64_t)x->skip_block << 27;
+  params |= (uint64_t)x->use_lp32x32fdct << 28;
+  params |= (uint64_t)is_inter_block(&xd->mi[0]->mbmi) << 29;
+  // The different transform types and sizes tried on the same residual get
+  // different slots.
+  result = &cache->results[(hash ^ params * TXFM_RD_HASH_MULT) >>
+                           (64 - TXFM_RD_CACHE_BITS)];
+
+  ++cache->lookups;
+  if (result->generation == cache->generation && result->hash == hash &&
+      result->params == params && result->rdmult == x->rdmult) {
+    ++cache->hits;
+    *hit = 1;
+  } else {
+    result->generation = 0;
+    result->hash = hash;
+    result->params = params;
+    result->rdmult = x->rdmult;
+  }
+  return result;
+}
+
+static void set_txfm_rd_result(const MACROBLOCK *x, TXFM_RD_RESULT *result,
+                               int rate, int eob, int64_t dist, int64_t sse) {
+  result->rate = rate;
+  result->eob = (uint16_t)eob;
+  result->dist = dist;
+  result->sse = sse;
+  result->generation = x->txfm_rd_cache->generation;
+}
+#endif  // !CONFIG_PVQ
+
 static void block_rd_txfm(int plane, int block, int blk_row, int blk_col,
                           BLOCK_SIZE plane_bsize, TX_SIZE tx_size, void *arg) {
   struct rdcost_block_args *args = arg;
@@ -1181,10 +1295,23 @@ static void block_rd_txfm(int plane, int block, int blk_row, int blk_col,
   int coeff_ctx = combine_entropy_contexts(*(args->t_above + blk_col),
                                            *(args->t_left + blk_row));
   RD_STATS this_rd_stats;
+  TXFM_RD_RESULT *cached = NULL;
+  int hit = 0;
   av1_init_rd_stats(&this_rd_stats);
 
   if (args->exit_early) return;
 
+#if !CONFIG_PVQ
+  // The intra blocks are left out, as their reconstruction is needed for the
+  // prediction of the next ones.
+  if (is_inter_block(mbmi)) {
+    cached = find_txfm_rd_result(
+        x, plane, block, blk_row, blk_col, plane_bsize, tx_size, coeff_ctx,
+        !args->cpi->sf.use_transform_domain_distortion,
+        (uint64_t)args->use_fast_coef_costing << 32, &hit);
+  }
+#endif  // !CONFIG_PVQ
+
   if (!is_inter_block(mbmi)) {
     struct encode_b_args b_args = {
       (AV1_COMMON *)cm, x, NULL, &mbmi->skip, args->t_above, args->t_left, 1
@@ -1229,6 +1356,10 @@ static void block_rd_txfm(int plane, int block, int blk_row, int blk_col,
       variance(src, src_stride, dst, dst_stride, &tmp);
       this_rd_stats.dist = (int64_t)tmp * 16;
     }
+  } else if (hit) {
+    x->plane[plane].eobs[block] = cached->eob;
+    this_rd_stats.dist = cached->dist;
+    this_rd_stats.sse = cached->sse;
   } else {
 // full forward transform and quantization
 #if CONFIG_NEW_QUANT
@@ -1252,7 +1383,15 @@ static void block_rd_txfm(int plane, int block, int blk_row, int blk_col,
     return;
   }
 #if !CONFIG_PVQ
-  this_rd_stats.rate = rate_block(plane, block, coeff_ctx, tx_size, args);
+  if (hit) {
+    this_rd_stats.rate = cached->rate;
+  } else {
+    this_rd_stats.rate = rate_block(plane, block, coeff_ctx, tx_size, args);
+    if (cached)
+      set_txfm_rd_result(x, cached, this_rd_stats.rate,
+                         x->plane[plane].eobs[block], this_rd_stats.dist,
+                         this_rd_stats.sse);
+  }
 #if CONFIG_RD_DEBUG
   av1_update_txb_coeff_cost(&this_rd_stats, plane, tx_size, blk_row, blk_col,
                             this_rd_stats.rate);
@@ -3142,6 +3281,10 @@ void av1_tx_block_rd_b(const AV1_COMP *cpi, MACROBLOCK *x, TX_SIZE tx_size,
   const int diff_stride = max_blocks_wide;
   const int16_t *diff = &p->src_diff[4 * (blk_row * diff_stride + blk_col)];
   int txb_coeff_cost;
+  int64_t sse;
+#if !CONFIG_PVQ
+  TXFM_RD_RESULT *cached = NULL;
+#endif  // !CONFIG_PVQ
 
   assert(tx_size < TX_SIZES_ALL);
 
@@ -3153,6 +3296,31 @@ void av1_tx_block_rd_b(const AV1_COMP *cpi, MACROBLOCK *x, TX_SIZE tx_size,
   max_blocks_high >>= tx_size_wide_log2[0];
   max_blocks_wide >>= tx_size_wide_log2[0];
 
+#if !CONFIG_PVQ
+  // As in block_rd_txfm(), the intra blocks are left out.
+  if (is_inter_block(&xd->mi[0]->mbmi)) {
+    // The part of the block inside the frame is measured.
+    const uint64_t visible_w = AOMMIN(txb_w, max_blocks_wide - blk_col);
+    const uint64_t visible_h = AOMMIN(txb_h, max_blocks_high - blk_row);
+    int hit;
+    cached = find_txfm_rd_result(
+        x, plane, block, blk_row, blk_col, plane_bsize, tx_size, coeff_ctx, 1,
+        (uint64_t)1 << 33 | visible_w << 34 | visible_h << 40, &hit);
+    if (hit) {
+      p->eobs[block] = cached->eob;
+      rd_stats->sse += cached->sse;
+      rd_stats->dist += cached->dist;
+      rd_stats->rate += cached->rate;
+      rd_stats->skip &= (cached->eob == 0);
+#if CONFIG_RD_DEBUG
+      av1_update_txb_coeff_cost(rd_stats, plane, tx_size, blk_row, blk_col,
+                                cached->rate);
+#endif
+      return;
+    }
+  }
+#endif  // !CONFIG_PVQ
+
 #if CONFIG_NEW_QUANT
   av1_xform_quant(cm, x, plane, block, blk_row, blk_col, plane_bsize, tx_size,
                   coeff_ctx, AV1_XFORM_QUANT_FP_NUQ);
@@ -3199,7 +3367,8 @@ void av1_tx_block_rd_b(const AV1_COMP *cpi, MACROBLOCK *x, TX_SIZE tx_size,
   if (xd->cur_buf->flags & YV12_FLAG_HIGHBITDEPTH)
     tmp = ROUND_POWER_OF_TWO(tmp, (xd->bd - 8) * 2);
 #endif  // CONFIG_AOM_HIGHBITDEPTH
-  rd_stats->sse += tmp * 16;
+  sse = tmp * 16;
+  rd_stats->sse += sse;
 
   if (p->eobs[block] > 0) {
     INV_TXFM_PARAM inv_txfm_param;
@@ -3246,6 +3415,11 @@ void av1_tx_block_rd_b(const AV1_COMP *cpi, MACROBLOCK *x, TX_SIZE tx_size,
                                    scan_order->scan, scan_order->neighbors, 0);
   rd_stats->rate += txb_coeff_cost;
   rd_stats->skip &= (p->eobs[block] == 0);
+#if !CONFIG_PVQ
+  if (cached)
+    set_txfm_rd_result(x, cached, txb_coeff_cost, p->eobs[block], tmp * 16,
+                       sse);
+#endif  // !CONFIG_PVQ
 
 #if CONFIG_RD_DEBUG
   av1_update_txb_coeff_cost(rd_stats, plane, tx_size, blk_row, blk_col,
@@ -4339,11 +4513,11 @@ static int get_gmbitcost(const WarpedMotionParams *gm, const aom_prob *probs) {
   return bits ? (bits << AV1_PROB_COST_SHIFT) + gmtype_cost[type] : 0;
 }
 
-#define GLOBAL_MOTION_RATE(ref)                                         \
-  (cpi->global_motion_used[ref] >= GLOBAL_MOTION_COST_AMORTIZATION_BLKS \
-       ? 0                                                              \
-       : get_gmbitcost(&cm->global_motion[(ref)],                       \
-                       cm->fc->global_motion_types_prob) /              \
+#define GLOBAL_MOTION_RATE(ref)                                       \
+  (x->global_motion_used[ref] >= GLOBAL_MOTION_COST_AMORTIZATION_BLKS \
+       ? 0                                                            \
+       : get_gmbitcost(&cm->global_motion[(ref)],                     \
+                       cm->fc->global_motion_types_prob) /            \
              GLOBAL_MOTION_COST_AMORTIZATION_BLKS)
 #else
 #define GLOBAL_MOTION_RATE(ref) 0
@@ -6255,6 +6429,13 @@ static void single_motion_search(const AV1_COMP *const cpi, MACROBLOCK *x,
   switch (mbmi->motion_mode) {
     case SIMPLE_TRANSLATION:
 #endif  // CONFIG_MOTION_VAR
+      if (cpi->sf.mv.pyramid_search_levels) {
+        step_param = av1_pyramid_motion_search(
+            cpi, x, bsize, mi_row, mi_col, cpi->Source,
+            scaled_ref_frame ? scaled_ref_frame
+                             : get_ref_frame_buffer(cpi, ref),
+            &mvp_full, sadpb, &ref_mv, step_param);
+      }
       bestsme = av1_full_pixel_search(cpi, x, bsize, &mvp_full, step_param,
                                       sadpb, cond_cost_list(cpi, cost_list),
                                       &ref_mv, INT_MAX, 1);
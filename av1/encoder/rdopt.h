@@ -133,6 +133,12 @@ int av1_cost_coeffs(const AV1_COMMON *const cm, MACROBLOCK *x, int plane,
                     int block, int coeff_ctx, TX_SIZE tx_size,
                     const int16_t *scan, const int16_t *nb,
                     int use_fast_coef_costing);
+
+// Starts a new generation of the transform RD cache, for a new tile. The
+// results of the old one are dropped, as the token costs they were found
+// with change from frame to frame.
+void av1_reset_txfm_rd_cache(TXFM_RD_CACHE *cache);
+
 void av1_rd_pick_intra_mode_sb(const struct AV1_COMP *cpi, struct macroblock *x,
                                struct RD_COST *rd_cost, BLOCK_SIZE bsize,
                                PICK_MODE_CONTEXT *ctx, int64_t best_rd);
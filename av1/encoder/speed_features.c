@@ -92,10 +92,13 @@ static void set_good_speed_feature_framesize_dependent(AV1_COMP *cpi,
       sf->adaptive_pred_interp_filter = 0;
       sf->partition_search_breakout_dist_thr = (1 << 24);
       sf->partition_search_breakout_rate_thr = 120;
+      sf->mv.pyramid_search_levels =
+          AOMMIN(cm->width, cm->height) >= 1440 ? 3 : 2;
     } else {
       sf->disable_split_mask = LAST_AND_INTRA_SPLIT_ONLY;
       sf->partition_search_breakout_dist_thr = (1 << 22);
       sf->partition_search_breakout_rate_thr = 100;
+      sf->mv.pyramid_search_levels = 0;
     }
     sf->rd_auto_partition_min_limit = set_partition_min_limit(cm);
   }
@@ -496,6 +499,7 @@ void av1_set_speed_features_framesize_independent(AV1_COMP *cpi) {
   sf->coeff_prob_appx_step = 1;
   sf->mv.auto_mv_step_size = 0;
   sf->mv.fullpel_search_step_param = 6;
+  sf->mv.pyramid_search_levels = 0;
   sf->comp_inter_joint_search_thresh = BLOCK_4X4;
   sf->adaptive_rd_thresh = 0;
   sf->tx_size_search_method = USE_FULL_RD;
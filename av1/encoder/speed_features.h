@@ -244,6 +244,11 @@ typedef struct MV_SPEED_FEATURES {
 
   // This variable sets the step_param used in full pel motion search.
   int fullpel_search_step_param;
+
+  // Number of downsampled levels of the frames the full pel motion search
+  // starts from, coarse to fine, before a short search at full resolution.
+  // 0 searches at full resolution only.
+  int pyramid_search_levels;
 } MV_SPEED_FEATURES;
 
 #define MAX_MESH_STEP 4
@@ -0,0 +1,55 @@
+/*
+ * Copyright (c) 2016, Alliance for Open Media. All rights reserved
+ *
+ * This source code is subject to the terms of the BSD 2 Clause License and
+ * the Alliance for Open Media Patent License 1.0. If the BSD 2 Clause License
+ * was not distributed with this source code in the LICENSE file, you can
+ * obtain it at www.aomedia.org/license/software. If the Alliance for Open
+ * Media Patent License 1.0 was not distributed with this source code in the
+ * PATENTS file, you can obtain it at www.aomedia.org/license/patent.
+ */
+
+#include <emmintrin.h>
+
+#include "./av1_rtcd.h"
+#include "av1/encoder/corner_match.h"
+
+#if MATCH_SZ != 15
+#error "Need to change the row loads in av1_compute_cross_correlation_sse2"
+#endif
+
+// Loads the 15 pixels of a window row as bytes 0-7 and 7-14, so that no
+// pixel outside of the window is read.
+static INLINE __m128i load_row(const unsigned char *p) {
+  return _mm_unpacklo_epi64(_mm_loadl_epi64((const __m128i *)p),
+                            _mm_loadl_epi64((const __m128i *)(p + 7)));
+}
+
+/**
+ * See av1_compute_cross_correlation_c
+ */
+int av1_compute_cross_correlation_sse2(const unsigned char *im1, int stride1,
+                                       const unsigned char *im2, int stride2) {
+  // Pixel 7 is loaded twice per row; clearing it in one half of the im1 row
+  // makes it count once in the products.
+  const __m128i mask = _mm_set_epi8(-1, -1, -1, -1, -1, -1, -1, 0, -1, -1, -1,
+                                    -1, -1, -1, -1, -1);
+  const __m128i zero = _mm_setzero_si128();
+  __m128i acc = _mm_setzero_si128();
+  int i;
+
+  for (i = 0; i < MATCH_SZ; ++i) {
+    const __m128i v1 = _mm_and_si128(load_row(im1), mask);
+    const __m128i v2 = load_row(im2);
+    acc = _mm_add_epi32(acc, _mm_madd_epi16(_mm_unpacklo_epi8(v1, zero),
+                                            _mm_unpacklo_epi8(v2, zero)));
+    acc = _mm_add_epi32(acc, _mm_madd_epi16(_mm_unpackhi_epi8(v1, zero),
+                                            _mm_unpackhi_epi8(v2, zero)));
+    im1 += stride1;
+    im2 += stride2;
+  }
+
+  acc = _mm_add_epi32(acc, _mm_srli_si128(acc, 8));
+  acc = _mm_add_epi32(acc, _mm_srli_si128(acc, 4));
+  return _mm_cvtsi128_si32(acc);
+}
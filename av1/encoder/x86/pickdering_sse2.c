@@ -0,0 +1,29 @@
+/*
+ * Copyright (c) 2016, Alliance for Open Media. All rights reserved
+ *
+ * This source code is subject to the terms of the BSD 2 Clause License and
+ * the Alliance for Open Media Patent License 1.0. If the BSD 2 Clause License
+ * was not distributed with this source code in the LICENSE file, you can
+ * obtain it at www.aomedia.org/license/software. If the Alliance for Open
+ * Media Patent License 1.0 was not distributed with this source code in the
+ * PATENTS file, you can obtain it at www.aomedia.org/license/patent.
+ */
+
+#include <emmintrin.h>
+
+#include "./av1_rtcd.h"
+
+uint32_t av1_dering_sse_8x8_sse2(const int16_t *a, int a_stride,
+                                 const int16_t *b, int b_stride) {
+  __m128i sum = _mm_setzero_si128();
+  int i;
+  for (i = 0; i < 8; i++) {
+    const __m128i diff =
+        _mm_sub_epi16(_mm_loadu_si128((const __m128i *)(a + i * a_stride)),
+                      _mm_loadu_si128((const __m128i *)(b + i * b_stride)));
+    sum = _mm_add_epi32(sum, _mm_madd_epi16(diff, diff));
+  }
+  sum = _mm_add_epi32(sum, _mm_srli_si128(sum, 8));
+  sum = _mm_add_epi32(sum, _mm_srli_si128(sum, 4));
+  return (uint32_t)_mm_cvtsi128_si32(sum);
+}
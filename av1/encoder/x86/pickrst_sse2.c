@@ -0,0 +1,180 @@
+/*
+ * Copyright (c) 2016, Alliance for Open Media. All rights reserved
+ *
+ * This source code is subject to the terms of the BSD 2 Clause License and
+ * the Alliance for Open Media Patent License 1.0. If the BSD 2 Clause License
+ * was not distributed with this source code in the LICENSE file, you can
+ * obtain it at www.aomedia.org/license/software. If the Alliance for Open
+ * Media Patent License 1.0 was not distributed with this source code in the
+ * PATENTS file, you can obtain it at www.aomedia.org/license/patent.
+ */
+
+#include <assert.h>
+#include <emmintrin.h>
+#include <limits.h>
+#include <string.h>
+
+#include "./aom_config.h"
+#include "./av1_rtcd.h"
+#include "av1/common/restoration.h"
+
+// The pixels are widened to 16 bits into tmpbuf, whose rows are padded with
+// zeros to a multiple of 8, and the products of 8 pixels at a time are summed
+// in pairs by _mm_madd_epi16(). The sums are all of products of pixels, so
+// they are never negative, and are moved into 64 bits before they can reach
+// INT_MAX.
+
+#define WIN RESTORATION_WIN
+#define WIN2 RESTORATION_WIN2
+#define HALFWIN RESTORATION_HALFWIN
+#define NUM_PAIRS (WIN2 * (WIN2 + 1) / 2)
+
+typedef struct {
+  __m128i d[WIN2];
+  __m128i m[WIN2];
+  __m128i h[NUM_PAIRS];
+  __m128i s;
+} StatsAcc;
+
+static INLINE int64_t hsum_epi32(__m128i v) {
+  v = _mm_add_epi64(_mm_unpacklo_epi32(v, _mm_setzero_si128()),
+                    _mm_unpackhi_epi32(v, _mm_setzero_si128()));
+  v = _mm_add_epi64(v, _mm_srli_si128(v, 8));
+#if ARCH_X86_64
+  return _mm_cvtsi128_si64(v);
+#else
+  {
+    int64_t r;
+    _mm_storel_epi64((__m128i *)&r, v);
+    return r;
+  }
+#endif
+}
+
+static void flush_stats(StatsAcc *acc, int64_t *sum_d, int64_t *sum_s,
+                        int64_t *M, int64_t *H) {
+  int k, l, p = 0;
+  *sum_s += hsum_epi32(acc->s);
+  for (k = 0; k < WIN2; ++k) {
+    sum_d[k] += hsum_epi32(acc->d[k]);
+    M[k] += hsum_epi32(acc->m[k]);
+    for (l = k; l < WIN2; ++l) H[k * WIN2 + l] += hsum_epi32(acc->h[p++]);
+  }
+  memset(acc, 0, sizeof(*acc));
+}
+
+// d has HALFWIN rows and columns around the tile, and s is the tile. Both are
+// padded to whole vectors on the right.
+static void compute_stats_16(const int16_t *d, int d_stride, const int16_t *s,
+                             int s_stride, int width, int height, int max_value,
+                             int64_t *sum_d, int64_t *sum_s, int64_t *M,
+                             int64_t *H) {
+  const __m128i ones = _mm_set1_epi16(1);
+  const __m128i ramp = _mm_setr_epi16(0, 1, 2, 3, 4, 5, 6, 7);
+  // The number of vectors that can be summed before a lane could overflow.
+  const int max_count = INT_MAX / (2 * max_value * max_value);
+  __m128i v[WIN2];
+  StatsAcc acc_buf;
+  StatsAcc *const acc = &acc_buf;
+  int i, j, k, l, p, count = 0;
+
+  memset(acc, 0, sizeof(*acc));
+  for (i = 0; i < height; ++i) {
+    for (j = 0; j < width; j += 8) {
+      const __m128i mask = _mm_cmpgt_epi16(_mm_set1_epi16(width - j), ramp);
+      const __m128i sv =
+          _mm_loadu_si128((const __m128i *)(s + i * s_stride + j));
+      acc->s = _mm_add_epi32(acc->s, _mm_madd_epi16(sv, ones));
+      p = 0;
+      for (k = 0; k < WIN; ++k) {
+        for (l = 0; l < WIN; ++l) {
+          v[p++] = _mm_loadu_si128(
+              (const __m128i *)(d + (i + l) * d_stride + j + k));
+        }
+      }
+      p = 0;
+      for (k = 0; k < WIN2; ++k) {
+        // Only the pixels of the tile count, so the lanes past its right edge
+        // are cleared in one side of the products.
+        const __m128i vk = _mm_and_si128(v[k], mask);
+        acc->d[k] = _mm_add_epi32(acc->d[k], _mm_madd_epi16(vk, ones));
+        acc->m[k] = _mm_add_epi32(acc->m[k], _mm_madd_epi16(vk, sv));
+        for (l = k; l < WIN2; ++l, ++p)
+          acc->h[p] = _mm_add_epi32(acc->h[p], _mm_madd_epi16(vk, v[l]));
+      }
+      if (++count == max_count) {
+        flush_stats(acc, sum_d, sum_s, M, H);
+        count = 0;
+      }
+    }
+  }
+  flush_stats(acc, sum_d, sum_s, M, H);
+
+  for (k = 0; k < WIN2; ++k)
+    for (l = 0; l < k; ++l) H[k * WIN2 + l] = H[l * WIN2 + k];
+}
+
+static void clear_stats(int64_t *sum_d, int64_t *sum_s, int64_t *M,
+                        int64_t *H) {
+  memset(sum_d, 0, sizeof(*sum_d) * WIN2);
+  memset(M, 0, sizeof(*M) * WIN2);
+  memset(H, 0, sizeof(*H) * WIN2 * WIN2);
+  *sum_s = 0;
+}
+
+void av1_compute_stats_sse2(const uint8_t *dgd, int dgd_stride,
+                            const uint8_t *src, int src_stride, int width,
+                            int height, int64_t *sum_d, int64_t *sum_s,
+                            int64_t *M, int64_t *H, int16_t *tmpbuf) {
+  const int s_stride = (width + 7) & ~7;
+  const int d_stride = s_stride + 2 * HALFWIN;
+  const int d_height = height + 2 * HALFWIN;
+  int16_t *const d = tmpbuf;
+  int16_t *const s = d + d_stride * d_height;
+  int i, j;
+
+  assert(d_stride * d_height + s_stride * height <= WIENER_STATS_TMPBUF_SIZE);
+  clear_stats(sum_d, sum_s, M, H);
+  dgd -= HALFWIN * dgd_stride + HALFWIN;
+  for (i = 0; i < d_height; ++i) {
+    for (j = 0; j < width + 2 * HALFWIN; ++j)
+      d[i * d_stride + j] = dgd[i * dgd_stride + j];
+    for (; j < d_stride; ++j) d[i * d_stride + j] = 0;
+  }
+  for (i = 0; i < height; ++i) {
+    for (j = 0; j < width; ++j) s[i * s_stride + j] = src[i * src_stride + j];
+    for (; j < s_stride; ++j) s[i * s_stride + j] = 0;
+  }
+  compute_stats_16(d, d_stride, s, s_stride, width, height, 255, sum_d, sum_s,
+                   M, H);
+}
+
+#if CONFIG_AOM_HIGHBITDEPTH
+void av1_highbd_compute_stats_sse2(const uint16_t *dgd, int dgd_stride,
+                                   const uint16_t *src, int src_stride,
+                                   int width, int height, int bd,
+                                   int64_t *sum_d, int64_t *sum_s, int64_t *M,
+                                   int64_t *H, int16_t *tmpbuf) {
+  const int s_stride = (width + 7) & ~7;
+  const int d_stride = s_stride + 2 * HALFWIN;
+  const int d_height = height + 2 * HALFWIN;
+  const int d_width = width + 2 * HALFWIN;
+  int16_t *const d = tmpbuf;
+  int16_t *const s = d + d_stride * d_height;
+  int i;
+
+  assert(d_stride * d_height + s_stride * height <= WIENER_STATS_TMPBUF_SIZE);
+  clear_stats(sum_d, sum_s, M, H);
+  dgd -= HALFWIN * dgd_stride + HALFWIN;
+  for (i = 0; i < d_height; ++i) {
+    memcpy(d + i * d_stride, dgd + i * dgd_stride, d_width * sizeof(*d));
+    memset(d + i * d_stride + d_width, 0, (d_stride - d_width) * sizeof(*d));
+  }
+  for (i = 0; i < height; ++i) {
+    memcpy(s + i * s_stride, src + i * src_stride, width * sizeof(*s));
+    memset(s + i * s_stride + width, 0, (s_stride - width) * sizeof(*s));
+  }
+  compute_stats_16(d, d_stride, s, s_stride, width, height, (1 << bd) - 1,
+                   sum_d, sum_s, M, H);
+}
+#endif  // CONFIG_AOM_HIGHBITDEPTH
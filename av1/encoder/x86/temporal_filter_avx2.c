@@ -0,0 +1,187 @@
+/*
+ * Copyright (c) 2016, Alliance for Open Media. All rights reserved
+ *
+ * This source code is subject to the terms of the BSD 2 Clause License and
+ * the Alliance for Open Media Patent License 1.0. If the BSD 2 Clause License
+ * was not distributed with this source code in the LICENSE file, you can
+ * obtain it at www.aomedia.org/license/software. If the Alliance for Open
+ * Media Patent License 1.0 was not distributed with this source code in the
+ * PATENTS file, you can obtain it at www.aomedia.org/license/patent.
+ */
+
+#include <immintrin.h>  // avx2
+
+#include "./aom_config.h"
+#include "./av1_rtcd.h"
+#include "aom_ports/mem.h"
+
+// See temporal_filter_sse4.c for how the modifiers are computed. The AVX2
+// versions work on 8 pixels at a time.
+
+#define MAX_BLOCK_SIZE 16
+#define SQ_STRIDE 24
+
+static INLINE int simd_block_size(unsigned int block_width,
+                                  unsigned int block_height) {
+  return (block_width == 8 || block_width == 16) && block_height >= 2 &&
+         block_height <= MAX_BLOCK_SIZE;
+}
+
+static INLINE void clear_sq_border(uint32_t *sq, int width, int height) {
+  int i;
+  for (i = 0; i < width + 2; ++i) {
+    sq[i] = 0;
+    sq[(height + 1) * SQ_STRIDE + i] = 0;
+  }
+  for (i = 1; i <= height; ++i) {
+    sq[i * SQ_STRIDE] = 0;
+    sq[i * SQ_STRIDE + width + 1] = 0;
+  }
+}
+
+static INLINE __m256i div3_epu32(__m256i x) {
+  const __m256i m = _mm256_set1_epi32((int)0xAAAAAAAB);
+  const __m256i even = _mm256_srli_epi64(_mm256_mul_epu32(x, m), 33);
+  const __m256i odd =
+      _mm256_srli_epi64(_mm256_mul_epu32(_mm256_srli_epi64(x, 32), m), 33);
+  return _mm256_or_si256(even, _mm256_slli_epi64(odd, 32));
+}
+
+// Filters the block from the squared differences in sq. The predictor is
+// read from pred8, or from pred16 when pred8 is NULL.
+static INLINE void apply_modifiers(const uint32_t *sq, const uint8_t *pred8,
+                                   const uint16_t *pred16, int width,
+                                   int height, int strength,
+                                   int filter_weight, unsigned int *accumulator,
+                                   uint16_t *count) {
+  const __m256i rounding =
+      _mm256_set1_epi32(strength > 0 ? 1 << (strength - 1) : 0);
+  const __m128i shift = _mm_cvtsi32_si128(strength);
+  const __m256i weight = _mm256_set1_epi32(filter_weight);
+  const __m256i sixteen = _mm256_set1_epi32(16);
+  const __m256i last_col = _mm256_set1_epi32(width - 1);
+  const __m256i ramp = _mm256_setr_epi32(0, 1, 2, 3, 4, 5, 6, 7);
+  int i, j, k;
+
+  for (i = 0; i < height; ++i) {
+    const int row_edge = i == 0 || i == height - 1;
+    for (j = 0; j < width; j += 8) {
+      const uint32_t *s = sq + i * SQ_STRIDE + j;
+      const int k_off = i * width + j;
+      const __m256i cols = _mm256_add_epi32(_mm256_set1_epi32(j), ramp);
+      const __m256i col_edge =
+          _mm256_or_si256(_mm256_cmpeq_epi32(cols, _mm256_setzero_si256()),
+                          _mm256_cmpeq_epi32(cols, last_col));
+      __m256i sum = _mm256_setzero_si256();
+      __m256i inner, edge, mod, pixels;
+      __m128i cnt;
+      for (k = 0; k < 3; ++k) {
+        sum = _mm256_add_epi32(
+            sum, _mm256_loadu_si256((const __m256i *)(s + k * SQ_STRIDE)));
+        sum = _mm256_add_epi32(
+            sum, _mm256_loadu_si256((const __m256i *)(s + k * SQ_STRIDE + 1)));
+        sum = _mm256_add_epi32(
+            sum, _mm256_loadu_si256((const __m256i *)(s + k * SQ_STRIDE + 2)));
+      }
+      if (row_edge) {
+        inner = _mm256_srli_epi32(sum, 1);
+        edge = _mm256_srli_epi32(
+            _mm256_add_epi32(sum, _mm256_slli_epi32(sum, 1)), 2);
+      } else {
+        inner = div3_epu32(sum);
+        edge = _mm256_srli_epi32(sum, 1);
+      }
+      mod = _mm256_blendv_epi8(inner, edge, col_edge);
+      mod = _mm256_srl_epi32(_mm256_add_epi32(mod, rounding), shift);
+      mod = _mm256_min_epu32(mod, sixteen);
+      mod = _mm256_mullo_epi32(_mm256_sub_epi32(sixteen, mod), weight);
+
+      if (pred8) {
+        pixels = _mm256_cvtepu8_epi32(
+            _mm_loadl_epi64((const __m128i *)(pred8 + k_off)));
+      } else {
+        pixels = _mm256_cvtepu16_epi32(
+            _mm_loadu_si128((const __m128i *)(pred16 + k_off)));
+      }
+      cnt = _mm_loadu_si128((const __m128i *)(count + k_off));
+      cnt = _mm_add_epi16(
+          cnt, _mm_packus_epi32(_mm256_castsi256_si128(mod),
+                                _mm256_extracti128_si256(mod, 1)));
+      _mm_storeu_si128((__m128i *)(count + k_off), cnt);
+      _mm256_storeu_si256(
+          (__m256i *)(accumulator + k_off),
+          _mm256_add_epi32(
+              _mm256_loadu_si256((const __m256i *)(accumulator + k_off)),
+              _mm256_mullo_epi32(mod, pixels)));
+    }
+  }
+}
+
+static INLINE void store_sq(uint32_t *sq, int i, int j, __m256i diff) {
+  _mm256_storeu_si256((__m256i *)(sq + (i + 1) * SQ_STRIDE + j + 1),
+                      _mm256_mullo_epi32(diff, diff));
+}
+
+void av1_temporal_filter_apply_avx2(uint8_t *frame1, unsigned int stride,
+                                    uint8_t *frame2, unsigned int block_width,
+                                    unsigned int block_height, int strength,
+                                    int filter_weight,
+                                    unsigned int *accumulator,
+                                    uint16_t *count) {
+  uint32_t sq[(MAX_BLOCK_SIZE + 2) * SQ_STRIDE];
+  const int width = block_width, height = block_height;
+  int i, j;
+
+  if (!simd_block_size(block_width, block_height)) {
+    av1_temporal_filter_apply_c(frame1, stride, frame2, block_width,
+                                block_height, strength, filter_weight,
+                                accumulator, count);
+    return;
+  }
+
+  clear_sq_border(sq, width, height);
+  for (i = 0; i < height; ++i) {
+    for (j = 0; j < width; j += 8) {
+      const __m256i a = _mm256_cvtepu8_epi32(
+          _mm_loadl_epi64((const __m128i *)(frame1 + i * stride + j)));
+      const __m256i b = _mm256_cvtepu8_epi32(
+          _mm_loadl_epi64((const __m128i *)(frame2 + i * width + j)));
+      store_sq(sq, i, j, _mm256_sub_epi32(a, b));
+    }
+  }
+  apply_modifiers(sq, frame2, NULL, width, height, strength, filter_weight,
+                  accumulator, count);
+}
+
+#if CONFIG_AOM_HIGHBITDEPTH
+void av1_highbd_temporal_filter_apply_avx2(
+    uint8_t *frame1_8, unsigned int stride, uint8_t *frame2_8,
+    unsigned int block_width, unsigned int block_height, int strength,
+    int filter_weight, unsigned int *accumulator, uint16_t *count) {
+  const uint16_t *frame1 = CONVERT_TO_SHORTPTR(frame1_8);
+  const uint16_t *frame2 = CONVERT_TO_SHORTPTR(frame2_8);
+  uint32_t sq[(MAX_BLOCK_SIZE + 2) * SQ_STRIDE];
+  const int width = block_width, height = block_height;
+  int i, j;
+
+  if (!simd_block_size(block_width, block_height)) {
+    av1_highbd_temporal_filter_apply_c(frame1_8, stride, frame2_8,
+                                       block_width, block_height, strength,
+                                       filter_weight, accumulator, count);
+    return;
+  }
+
+  clear_sq_border(sq, width, height);
+  for (i = 0; i < height; ++i) {
+    for (j = 0; j < width; j += 8) {
+      const __m256i a = _mm256_cvtepu16_epi32(
+          _mm_loadu_si128((const __m128i *)(frame1 + i * stride + j)));
+      const __m256i b = _mm256_cvtepu16_epi32(
+          _mm_loadu_si128((const __m128i *)(frame2 + i * width + j)));
+      store_sq(sq, i, j, _mm256_sub_epi32(a, b));
+    }
+  }
+  apply_modifiers(sq, NULL, frame2, width, height, strength, filter_weight,
+                  accumulator, count);
+}
+#endif  // CONFIG_AOM_HIGHBITDEPTH
@@ -0,0 +1,123 @@
+/*
+ * Copyright (c) 2016, Alliance for Open Media. All rights reserved
+ *
+ * This source code is subject to the terms of the BSD 2 Clause License and
+ * the Alliance for Open Media Patent License 1.0. If the BSD 2 Clause License
+ * was not distributed with this source code in the LICENSE file, you can
+ * obtain it at www.aomedia.org/license/software. If the Alliance for Open
+ * Media Patent License 1.0 was not distributed with this source code in the
+ * PATENTS file, you can obtain it at www.aomedia.org/license/patent.
+ */
+
+#include <smmintrin.h>
+
+#include "./aom_config.h"
+#include "./av1_rtcd.h"
+#include "aom_ports/mem.h"
+
+// The modifier of each pixel is 3 * sum / n, where sum is the sum of the
+// squared differences over the n pixels of its 3x3 neighbourhood that lie
+// inside the block. The squares are first stored with a border of zeros, so
+// the sums need no edge cases. n is 9 inside the block, 6 along its edges
+// and 4 in its corners, which turns the division into sum / 3, sum / 2 and
+// (3 * sum) / 4. The results are the same as those of
+// av1_highbd_temporal_filter_apply_c() for the block sizes the temporal
+// filter uses; other sizes are passed on to it.
+
+#define MAX_BLOCK_SIZE 16
+#define SQ_STRIDE 24
+
+static INLINE __m128i div3_epu32(__m128i x) {
+  const __m128i m = _mm_set1_epi32((int)0xAAAAAAAB);
+  const __m128i even = _mm_srli_epi64(_mm_mul_epu32(x, m), 33);
+  const __m128i odd =
+      _mm_srli_epi64(_mm_mul_epu32(_mm_srli_epi64(x, 32), m), 33);
+  return _mm_or_si128(even, _mm_slli_epi64(odd, 32));
+}
+
+void av1_highbd_temporal_filter_apply_sse4_1(
+    uint8_t *frame1_8, unsigned int stride, uint8_t *frame2_8,
+    unsigned int block_width, unsigned int block_height, int strength,
+    int filter_weight, unsigned int *accumulator, uint16_t *count) {
+  const uint16_t *frame1 = CONVERT_TO_SHORTPTR(frame1_8);
+  const uint16_t *frame2 = CONVERT_TO_SHORTPTR(frame2_8);
+  const int width = block_width, height = block_height;
+  const __m128i rounding =
+      _mm_set1_epi32(strength > 0 ? 1 << (strength - 1) : 0);
+  const __m128i shift = _mm_cvtsi32_si128(strength);
+  const __m128i weight = _mm_set1_epi32(filter_weight);
+  const __m128i sixteen = _mm_set1_epi32(16);
+  const __m128i last_col = _mm_set1_epi32(width - 1);
+  const __m128i ramp = _mm_setr_epi32(0, 1, 2, 3);
+  uint32_t sq[(MAX_BLOCK_SIZE + 2) * SQ_STRIDE];
+  int i, j, k;
+
+  if ((block_width != 8 && block_width != 16) || block_height < 2 ||
+      block_height > MAX_BLOCK_SIZE) {
+    av1_highbd_temporal_filter_apply_c(frame1_8, stride, frame2_8,
+                                       block_width, block_height, strength,
+                                       filter_weight, accumulator, count);
+    return;
+  }
+
+  for (i = 0; i < width + 2; ++i) {
+    sq[i] = 0;
+    sq[(height + 1) * SQ_STRIDE + i] = 0;
+  }
+  for (i = 0; i < height; ++i) {
+    uint32_t *const sq_row = sq + (i + 1) * SQ_STRIDE + 1;
+    sq_row[-1] = 0;
+    sq_row[width] = 0;
+    for (j = 0; j < width; j += 4) {
+      const __m128i a = _mm_cvtepu16_epi32(
+          _mm_loadl_epi64((const __m128i *)(frame1 + i * stride + j)));
+      const __m128i b = _mm_cvtepu16_epi32(
+          _mm_loadl_epi64((const __m128i *)(frame2 + i * width + j)));
+      const __m128i diff = _mm_sub_epi32(a, b);
+      _mm_storeu_si128((__m128i *)(sq_row + j), _mm_mullo_epi32(diff, diff));
+    }
+  }
+
+  for (i = 0; i < height; ++i) {
+    const int row_edge = i == 0 || i == height - 1;
+    for (j = 0; j < width; j += 4) {
+      const uint32_t *s = sq + i * SQ_STRIDE + j;
+      const __m128i cols = _mm_add_epi32(_mm_set1_epi32(j), ramp);
+      const __m128i col_edge =
+          _mm_or_si128(_mm_cmpeq_epi32(cols, _mm_setzero_si128()),
+                       _mm_cmpeq_epi32(cols, last_col));
+      const int k_off = i * width + j;
+      __m128i sum = _mm_setzero_si128();
+      __m128i inner, edge, mod, pixels, cnt;
+      for (k = 0; k < 3; ++k) {
+        sum = _mm_add_epi32(
+            sum, _mm_loadu_si128((const __m128i *)(s + k * SQ_STRIDE)));
+        sum = _mm_add_epi32(
+            sum, _mm_loadu_si128((const __m128i *)(s + k * SQ_STRIDE + 1)));
+        sum = _mm_add_epi32(
+            sum, _mm_loadu_si128((const __m128i *)(s + k * SQ_STRIDE + 2)));
+      }
+      if (row_edge) {
+        inner = _mm_srli_epi32(sum, 1);
+        edge = _mm_srli_epi32(_mm_add_epi32(sum, _mm_slli_epi32(sum, 1)), 2);
+      } else {
+        inner = div3_epu32(sum);
+        edge = _mm_srli_epi32(sum, 1);
+      }
+      mod = _mm_blendv_epi8(inner, edge, col_edge);
+      mod = _mm_srl_epi32(_mm_add_epi32(mod, rounding), shift);
+      mod = _mm_min_epu32(mod, sixteen);
+      mod = _mm_mullo_epi32(_mm_sub_epi32(sixteen, mod), weight);
+
+      pixels = _mm_cvtepu16_epi32(
+          _mm_loadl_epi64((const __m128i *)(frame2 + k_off)));
+      cnt = _mm_loadl_epi64((const __m128i *)(count + k_off));
+      cnt = _mm_add_epi16(cnt, _mm_packus_epi32(mod, mod));
+      _mm_storel_epi64((__m128i *)(count + k_off), cnt);
+      _mm_storeu_si128(
+          (__m128i *)(accumulator + k_off),
+          _mm_add_epi32(_mm_loadu_si128((const __m128i *)(accumulator + k_off)),
+                        _mm_mullo_epi32(mod, pixels)));
+    }
+  }
+}
@@ -0,0 +1,172 @@
+/*
+ * Copyright (c) 2016, Alliance for Open Media. All rights reserved
+ *
+ * This source code is subject to the terms of the BSD 2 Clause License and
+ * the Alliance for Open Media Patent License 1.0. If the BSD 2 Clause License
+ * was not distributed with this source code in the LICENSE file, you can
+ * obtain it at www.aomedia.org/license/software. If the Alliance for Open
+ * Media Patent License 1.0 was not distributed with this source code in the
+ * PATENTS file, you can obtain it at www.aomedia.org/license/patent.
+ */
+
+#include <string.h>
+
+#include "third_party/googletest/src/include/gtest/gtest.h"
+
+#include "./aom_config.h"
+#include "./av1_rtcd.h"
+#include "av1/common/restoration.h"
+#include "test/acm_random.h"
+#include "test/function_equivalence_test.h"
+#include "test/register_state_check.h"
+
+using libaom_test::FunctionEquivalenceTest;
+
+namespace {
+
+// The tiles are read from frame-like buffers that leave room for the
+// Wiener window around them. The widest tiles make the kernels move their
+// sums into 64 bits part way through at the higher bit depths.
+const int kMaxWidth = 256;
+const int kMaxHeight = 64;
+const int kBorder = RESTORATION_HALFWIN;
+const int kStride = kMaxWidth + 2 * kBorder + 5;
+const int kRows = kMaxHeight + 2 * kBorder;
+const int kWin2 = RESTORATION_WIN2;
+
+typedef void (*ComputeStatsFunc)(const uint8_t *dgd, int dgd_stride,
+                                 const uint8_t *src, int src_stride, int width,
+                                 int height, int64_t *sum_d, int64_t *sum_s,
+                                 int64_t *M, int64_t *H, int16_t *tmpbuf);
+#if CONFIG_AOM_HIGHBITDEPTH
+typedef void (*HighbdComputeStatsFunc)(const uint16_t *dgd, int dgd_stride,
+                                       const uint16_t *src, int src_stride,
+                                       int width, int height, int bd,
+                                       int64_t *sum_d, int64_t *sum_s,
+                                       int64_t *M, int64_t *H,
+                                       int16_t *tmpbuf);
+#endif  // CONFIG_AOM_HIGHBITDEPTH
+
+template <typename F, typename T>
+class ComputeStatsTest : public FunctionEquivalenceTest<F> {
+ public:
+  static const int kIterations = 200;
+
+  virtual ~ComputeStatsTest() {}
+
+  virtual void Execute(F func, const T *dgd, const T *src, int width,
+                       int height, int64_t *sum_d, int64_t *sum_s, int64_t *M,
+                       int64_t *H) = 0;
+
+  void Common(bool extreme) {
+    const int max_value = (1 << this->params_.bit_depth) - 1;
+    const int width = 1 + this->rng_(kMaxWidth);
+    const int height = 1 + this->rng_(kMaxHeight);
+    for (int i = 0; i < kRows * kStride; ++i) {
+      dgd_[i] = extreme ? (this->rng_(2) ? max_value : 0)
+                        : this->rng_(max_value + 1);
+      src_[i] = extreme ? (this->rng_(2) ? max_value : 0)
+                        : this->rng_(max_value + 1);
+    }
+    const T *const dgd = dgd_ + kBorder * kStride + kBorder;
+    const T *const src = src_ + kBorder * kStride + kBorder;
+    // The kernels must not depend on what the scratch holds.
+    memset(tmpbuf_, 0x5a, sizeof(tmpbuf_));
+
+    Execute(this->params_.ref_func, dgd, src, width, height, sum_d_ref_,
+            &sum_s_ref_, m_ref_, h_ref_);
+    ASM_REGISTER_STATE_CHECK(Execute(this->params_.tst_func, dgd, src, width,
+                                     height, sum_d_tst_, &sum_s_tst_, m_tst_,
+                                     h_tst_));
+
+    ASSERT_EQ(sum_s_ref_, sum_s_tst_) << width << "x" << height;
+    for (int k = 0; k < kWin2; ++k) {
+      ASSERT_EQ(sum_d_ref_[k], sum_d_tst_[k]) << width << "x" << height;
+      ASSERT_EQ(m_ref_[k], m_tst_[k]) << width << "x" << height;
+    }
+    for (int k = 0; k < kWin2 * kWin2; ++k)
+      ASSERT_EQ(h_ref_[k], h_tst_[k]) << width << "x" << height << " at " << k;
+  }
+
+  T dgd_[kRows * kStride];
+  T src_[kRows * kStride];
+  int16_t tmpbuf_[WIENER_STATS_TMPBUF_SIZE];
+  int64_t sum_d_ref_[kWin2], sum_d_tst_[kWin2];
+  int64_t sum_s_ref_, sum_s_tst_;
+  int64_t m_ref_[kWin2], m_tst_[kWin2];
+  int64_t h_ref_[kWin2 * kWin2], h_tst_[kWin2 * kWin2];
+};
+
+//////////////////////////////////////////////////////////////////////////////
+// 8 bit version
+//////////////////////////////////////////////////////////////////////////////
+
+typedef libaom_test::FuncParam<ComputeStatsFunc> TestFuncs;
+
+class ComputeStatsTest8B : public ComputeStatsTest<ComputeStatsFunc, uint8_t> {
+ protected:
+  void Execute(ComputeStatsFunc func, const uint8_t *dgd, const uint8_t *src,
+               int width, int height, int64_t *sum_d, int64_t *sum_s,
+               int64_t *M, int64_t *H) {
+    func(dgd, kStride, src, kStride, width, height, sum_d, sum_s, M, H,
+         tmpbuf_);
+  }
+};
+
+TEST_P(ComputeStatsTest8B, RandomValues) {
+  for (int iter = 0; iter < kIterations && !HasFatalFailure(); ++iter)
+    Common(false);
+}
+
+TEST_P(ComputeStatsTest8B, ExtremeValues) {
+  for (int iter = 0; iter < kIterations && !HasFatalFailure(); ++iter)
+    Common(true);
+}
+
+#if HAVE_SSE2
+INSTANTIATE_TEST_CASE_P(SSE2, ComputeStatsTest8B,
+                        ::testing::Values(TestFuncs(av1_compute_stats_c,
+                                                    av1_compute_stats_sse2,
+                                                    8)));
+#endif  // HAVE_SSE2
+
+#if CONFIG_AOM_HIGHBITDEPTH
+//////////////////////////////////////////////////////////////////////////////
+// High bit-depth version
+//////////////////////////////////////////////////////////////////////////////
+
+typedef libaom_test::FuncParam<HighbdComputeStatsFunc> HighbdTestFuncs;
+
+class ComputeStatsTestHBD
+    : public ComputeStatsTest<HighbdComputeStatsFunc, uint16_t> {
+ protected:
+  void Execute(HighbdComputeStatsFunc func, const uint16_t *dgd,
+               const uint16_t *src, int width, int height, int64_t *sum_d,
+               int64_t *sum_s, int64_t *M, int64_t *H) {
+    func(dgd, kStride, src, kStride, width, height, params_.bit_depth, sum_d,
+         sum_s, M, H, tmpbuf_);
+  }
+};
+
+TEST_P(ComputeStatsTestHBD, RandomValues) {
+  for (int iter = 0; iter < kIterations && !HasFatalFailure(); ++iter)
+    Common(false);
+}
+
+TEST_P(ComputeStatsTestHBD, ExtremeValues) {
+  for (int iter = 0; iter < kIterations && !HasFatalFailure(); ++iter)
+    Common(true);
+}
+
+#if HAVE_SSE2
+INSTANTIATE_TEST_CASE_P(
+    SSE2, ComputeStatsTestHBD,
+    ::testing::Values(HighbdTestFuncs(av1_highbd_compute_stats_c,
+                                      av1_highbd_compute_stats_sse2, 8),
+                      HighbdTestFuncs(av1_highbd_compute_stats_c,
+                                      av1_highbd_compute_stats_sse2, 10),
+                      HighbdTestFuncs(av1_highbd_compute_stats_c,
+                                      av1_highbd_compute_stats_sse2, 12)));
+#endif  // HAVE_SSE2
+#endif  // CONFIG_AOM_HIGHBITDEPTH
+}  // namespace
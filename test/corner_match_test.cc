@@ -0,0 +1,106 @@
+/*
+ * Copyright (c) 2016, Alliance for Open Media. All rights reserved
+ *
+ * This source code is subject to the terms of the BSD 2 Clause License and
+ * the Alliance for Open Media Patent License 1.0. If the BSD 2 Clause License
+ * was not distributed with this source code in the LICENSE file, you can
+ * obtain it at www.aomedia.org/license/software. If the Alliance for Open
+ * Media Patent License 1.0 was not distributed with this source code in the
+ * PATENTS file, you can obtain it at www.aomedia.org/license/patent.
+ */
+
+#include <string.h>
+
+#include "third_party/googletest/src/include/gtest/gtest.h"
+
+#include "./av1_rtcd.h"
+#include "aom/aom_integer.h"
+
+#include "test/acm_random.h"
+#include "test/register_state_check.h"
+
+#include "av1/encoder/corner_match.h"
+
+namespace {
+
+using ::libaom_test::ACMRandom;
+
+typedef int (*CrossCorrFunc)(const unsigned char *im1, int stride1,
+                             const unsigned char *im2, int stride2);
+
+// The windows are placed at the end of their buffers so that reads past the
+// last pixel of the window are caught by memory checkers.
+static const int kMaxStride = 64;
+static const int kBufSize = (MATCH_SZ - 1) * kMaxStride + MATCH_SZ;
+
+class CornerMatchTest : public ::testing::TestWithParam<CrossCorrFunc> {
+ public:
+  virtual void SetUp() {
+    cross_corr_func_ = GetParam();
+    rnd_.Reset(ACMRandom::DeterministicSeed());
+  }
+
+ protected:
+  void CheckWindows(const uint8_t *a, int a_stride, const uint8_t *b,
+                    int b_stride) {
+    const int ref = av1_compute_cross_correlation_c(a, a_stride, b, b_stride);
+    int res;
+    ASM_REGISTER_STATE_CHECK(res = cross_corr_func_(a, a_stride, b, b_stride));
+    EXPECT_EQ(ref, res) << "when a_stride = " << a_stride
+                        << " and b_stride = " << b_stride;
+  }
+
+  CrossCorrFunc cross_corr_func_;
+  ACMRandom rnd_;
+};
+
+TEST_P(CornerMatchTest, ExtremeValues) {
+  uint8_t a[kBufSize], b[kBufSize];
+  const int stride = MATCH_SZ;
+  const uint8_t *const a_win = a + kBufSize - MATCH_SZ * stride;
+  const uint8_t *const b_win = b + kBufSize - MATCH_SZ * stride;
+  memset(a, 255, sizeof(a));
+  memset(b, 255, sizeof(b));
+  CheckWindows(a_win, stride, b_win, stride);
+  EXPECT_EQ(MATCH_SZ_SQ * 255 * 255,
+            cross_corr_func_(a_win, stride, b_win, stride));
+  memset(b, 0, sizeof(b));
+  CheckWindows(a_win, stride, b_win, stride);
+  EXPECT_EQ(0, cross_corr_func_(a_win, stride, b_win, stride));
+}
+
+TEST_P(CornerMatchTest, CompareReference) {
+  uint8_t a[kBufSize], b[kBufSize];
+  for (int i = 0; i < 100; ++i) {
+    for (int j = 0; j < kBufSize; j++) {
+      a[j] = rnd_.Rand8();
+      b[j] = rnd_.Rand8();
+    }
+    CheckWindows(a, MATCH_SZ, b, MATCH_SZ);
+  }
+}
+
+TEST_P(CornerMatchTest, CompareReferenceAndVaryStride) {
+  uint8_t a[kBufSize], b[kBufSize];
+  for (int j = 0; j < kBufSize; j++) {
+    a[j] = rnd_.Rand8();
+    b[j] = rnd_.Rand8();
+  }
+  for (int a_stride = MATCH_SZ; a_stride <= kMaxStride; ++a_stride) {
+    for (int b_stride = MATCH_SZ; b_stride <= kMaxStride; ++b_stride) {
+      const int a_off = (kMaxStride - a_stride) * (MATCH_SZ - 1);
+      const int b_off = (kMaxStride - b_stride) * (MATCH_SZ - 1);
+      CheckWindows(a + a_off, a_stride, b + b_off, b_stride);
+    }
+  }
+}
+
+INSTANTIATE_TEST_CASE_P(C, CornerMatchTest,
+                        ::testing::Values(&av1_compute_cross_correlation_c));
+
+#if HAVE_SSE2
+INSTANTIATE_TEST_CASE_P(SSE2, CornerMatchTest,
+                        ::testing::Values(&av1_compute_cross_correlation_sse2));
+#endif
+
+}  // namespace
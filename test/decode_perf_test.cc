@@ -10,6 +10,7 @@
 */
 
 #include <string>
+#include <vector>
 #include "test/codec_factory.h"
 #include "test/decode_test_driver.h"
 #include "test/encode_test_driver.h"
@@ -240,4 +241,86 @@ TEST_P(AV1NewEncodeDecodePerfTest, PerfTest) {
 
 AV1_INSTANTIATE_TEST_CASE(AV1NewEncodeDecodePerfTest,
                           ::testing::Values(::libaom_test::kTwoPassGood));
+
+// Encodes a clip with the in-loop filters on, then times single-threaded
+// decoding of it with the in-loop filters run as a pipeline over superblock
+// rows and as one pass over the frame per filter.
+class AV1FilterPipelinePerfTest
+    : public ::libaom_test::EncoderTest,
+      public ::libaom_test::CodecTestWithParam<libaom_test::TestMode> {
+ protected:
+  AV1FilterPipelinePerfTest()
+      : EncoderTest(GET_PARAM(0)), encoding_mode_(GET_PARAM(1)) {}
+
+  virtual ~AV1FilterPipelinePerfTest() {}
+
+  virtual void SetUp() {
+    InitializeConfig();
+    SetMode(encoding_mode_);
+
+    cfg_.g_lag_in_frames = 25;
+    cfg_.rc_end_usage = AOM_VBR;
+  }
+
+  virtual void PreEncodeFrameHook(::libaom_test::VideoSource *video,
+                                  ::libaom_test::Encoder *encoder) {
+    if (video->frame() == 1) encoder->Control(AOME_SET_CPUUSED, 2);
+  }
+
+  virtual void FramePktHook(const aom_codec_cx_pkt_t *pkt) {
+    const char *const buf = static_cast<const char *>(pkt->data.frame.buf);
+    frames_.push_back(std::string(buf, pkt->data.frame.sz));
+  }
+
+  virtual bool DoDecode() const { return false; }
+
+  double DecodeSecs(int pipelined_filters) {
+    aom_codec_dec_cfg_t cfg = aom_codec_dec_cfg_t();
+    cfg.threads = 1;
+    libaom_test::AV1Decoder decoder(cfg, 0);
+    decoder.Control(AV1_SET_PIPELINED_FILTERS, pipelined_filters);
+
+    aom_usec_timer t;
+    aom_usec_timer_start(&t);
+    for (size_t i = 0; i < frames_.size(); ++i) {
+      decoder.DecodeFrame(reinterpret_cast<const uint8_t *>(frames_[i].data()),
+                          frames_[i].size());
+    }
+    aom_usec_timer_mark(&t);
+    return static_cast<double>(aom_usec_timer_elapsed(&t)) / kUsecsInSec;
+  }
+
+  std::vector<std::string> frames_;
+
+ private:
+  libaom_test::TestMode encoding_mode_;
+};
+
+TEST_P(AV1FilterPipelinePerfTest, PerfTest) {
+  const int i = 0;
+  const aom_rational timebase = { 33333333, 1000000000 };
+  cfg_.g_timebase = timebase;
+  cfg_.rc_target_bitrate = kAV1EncodePerfTestVectors[i].bitrate;
+
+  libaom_test::I420VideoSource video(
+      kAV1EncodePerfTestVectors[i].name, kAV1EncodePerfTestVectors[i].width,
+      kAV1EncodePerfTestVectors[i].height, timebase.den, timebase.num, 0, 60);
+  ASSERT_NO_FATAL_FAILURE(RunLoop(&video));
+
+  const double frame_secs = DecodeSecs(0);
+  const double row_secs = DecodeSecs(1);
+  const unsigned frames = static_cast<unsigned>(frames_.size());
+
+  printf("{\n");
+  printf("\t\"type\" : \"filter_pipeline_perf_test\",\n");
+  printf("\t\"version\" : \"%s\",\n", VERSION_STRING_NOSP);
+  printf("\t\"videoName\" : \"%s\",\n", kAV1EncodePerfTestVectors[i].name);
+  printf("\t\"totalFrames\" : %u,\n", frames);
+  printf("\t\"framePassesFramesPerSecond\" : %f,\n", frames / frame_secs);
+  printf("\t\"pipelinedFramesPerSecond\" : %f\n", frames / row_secs);
+  printf("}\n");
+}
+
+AV1_INSTANTIATE_TEST_CASE(AV1FilterPipelinePerfTest,
+                          ::testing::Values(::libaom_test::kTwoPassGood));
 }  // namespace
@@ -0,0 +1,182 @@
+/*
+ * Copyright (c) 2016, Alliance for Open Media. All rights reserved
+ *
+ * This source code is subject to the terms of the BSD 2 Clause License and
+ * the Alliance for Open Media Patent License 1.0. If the BSD 2 Clause License
+ * was not distributed with this source code in the LICENSE file, you can
+ * obtain it at www.aomedia.org/license/software. If the Alliance for Open
+ * Media Patent License 1.0 was not distributed with this source code in the
+ * PATENTS file, you can obtain it at www.aomedia.org/license/patent.
+*/
+
+#include "third_party/googletest/src/include/gtest/gtest.h"
+#include "test/codec_factory.h"
+#include "test/encode_test_driver.h"
+#include "test/i420_video_source.h"
+#include "test/md5_helper.h"
+#include "test/util.h"
+
+namespace {
+// Decodes every frame of an encode with a single thread and with several, and
+// checks that the multi-threaded tile decoding and in-loop filtering produce
+// the same output, with and without row multi-threading. The single-threaded
+// decode is also repeated with the in-loop filters run one whole-frame pass at
+// a time instead of pipelined, and the multi-threaded decode with its threads
+// taken from a pool of two shared with the single-threaded decoders. Frame
+// parallel decoding, which outputs the frames later, is checked over the whole
+// stream.
+class DecodeThreadTest
+    : public ::libaom_test::EncoderTest,
+      public ::libaom_test::CodecTestWith3Params<int, int, int> {
+ protected:
+  DecodeThreadTest()
+      : EncoderTest(GET_PARAM(0)), n_tile_cols_(GET_PARAM(1)),
+        n_tile_rows_(GET_PARAM(2)), n_threads_(GET_PARAM(3)) {
+    aom_codec_dec_cfg_t cfg = aom_codec_dec_cfg_t();
+    cfg.w = 352;
+    cfg.h = 288;
+    cfg.threads = 1;
+    single_dec_ = codec_->CreateDecoder(cfg, 0);
+    unpipelined_dec_ = codec_->CreateDecoder(cfg, 0);
+    cfg.threads = n_threads_;
+    multi_dec_ = codec_->CreateDecoder(cfg, 0);
+    no_row_mt_dec_ = codec_->CreateDecoder(cfg, 0);
+    pooled_dec_ = codec_->CreateDecoder(cfg, 0);
+    // More threads than there can be frame workers, so that some of them run
+    // the in-loop filters of the frames.
+    cfg.threads = 3 * n_threads_;
+    frame_parallel_dec_ =
+        codec_->CreateDecoder(cfg, AOM_CODEC_USE_FRAME_THREADING);
+    pool_ = aom_thread_pool_create(2);
+#if CONFIG_AV1 && CONFIG_EXT_TILE
+    if (single_dec_->IsAV1() && multi_dec_->IsAV1()) {
+      single_dec_->Control(AV1_SET_DECODE_TILE_ROW, -1);
+      single_dec_->Control(AV1_SET_DECODE_TILE_COL, -1);
+      multi_dec_->Control(AV1_SET_DECODE_TILE_ROW, -1);
+      multi_dec_->Control(AV1_SET_DECODE_TILE_COL, -1);
+      no_row_mt_dec_->Control(AV1_SET_DECODE_TILE_ROW, -1);
+      no_row_mt_dec_->Control(AV1_SET_DECODE_TILE_COL, -1);
+      frame_parallel_dec_->Control(AV1_SET_DECODE_TILE_ROW, -1);
+      frame_parallel_dec_->Control(AV1_SET_DECODE_TILE_COL, -1);
+    }
+#endif
+#if CONFIG_AV1_DECODER
+    if (unpipelined_dec_->IsAV1())
+      unpipelined_dec_->Control(AV1_SET_PIPELINED_FILTERS, 0);
+    if (no_row_mt_dec_->IsAV1()) no_row_mt_dec_->Control(AV1_SET_ROW_MT, 0);
+    if (pooled_dec_->IsAV1()) {
+      pooled_dec_->Control(AV1_SET_THREAD_POOL, pool_);
+      single_dec_->Control(AV1_SET_THREAD_POOL, pool_);
+    }
+#endif
+  }
+
+  virtual ~DecodeThreadTest() {
+    delete single_dec_;
+    delete unpipelined_dec_;
+    delete multi_dec_;
+    delete no_row_mt_dec_;
+    delete pooled_dec_;
+    delete frame_parallel_dec_;
+    aom_thread_pool_destroy(pool_);
+  }
+
+  virtual void SetUp() {
+    InitializeConfig();
+    SetMode(libaom_test::kTwoPassGood);
+  }
+
+  virtual void PreEncodeFrameHook(libaom_test::VideoSource *video,
+                                  libaom_test::Encoder *encoder) {
+    if (video->frame() == 1) {
+      encoder->Control(AV1E_SET_TILE_COLUMNS, n_tile_cols_);
+      encoder->Control(AV1E_SET_TILE_ROWS, n_tile_rows_);
+      encoder->Control(AOME_SET_CPUUSED, 3);
+    }
+  }
+
+  void DecodeFrame(::libaom_test::Decoder *dec, const aom_codec_cx_pkt_t *pkt,
+                   ::libaom_test::MD5 *md5) {
+    const aom_codec_err_t res = dec->DecodeFrame(
+        reinterpret_cast<uint8_t *>(pkt->data.frame.buf), pkt->data.frame.sz);
+    if (res != AOM_CODEC_OK) {
+      abort_ = true;
+      ASSERT_EQ(AOM_CODEC_OK, res);
+    }
+    const aom_image_t *img = dec->GetDxData().Next();
+    if (img) {
+      md5->Add(img);
+      if (dec == single_dec_) md5_stream_single_.Add(img);
+    }
+  }
+
+  // Decodes pkt, or flushes the decoder if it is NULL, and adds the frames
+  // that are output to the frame parallel md5.
+  void DecodeFrameParallel(const aom_codec_cx_pkt_t *pkt) {
+    const aom_codec_err_t res =
+        pkt ? frame_parallel_dec_->DecodeFrame(
+                  reinterpret_cast<uint8_t *>(pkt->data.frame.buf),
+                  pkt->data.frame.sz)
+            : frame_parallel_dec_->DecodeFrame(NULL, 0);
+    if (res != AOM_CODEC_OK) {
+      abort_ = true;
+      ASSERT_EQ(AOM_CODEC_OK, res);
+    }
+    ::libaom_test::DxDataIterator dec_iter = frame_parallel_dec_->GetDxData();
+    const aom_image_t *img;
+    while ((img = dec_iter.Next()) != NULL) md5_stream_frame_parallel_.Add(img);
+  }
+
+  virtual void FramePktHook(const aom_codec_cx_pkt_t *pkt) {
+    ::libaom_test::MD5 md5_single, md5_multi, md5_unpipelined, md5_no_row_mt;
+    ::libaom_test::MD5 md5_pooled;
+    DecodeFrame(single_dec_, pkt, &md5_single);
+    DecodeFrame(multi_dec_, pkt, &md5_multi);
+    DecodeFrame(unpipelined_dec_, pkt, &md5_unpipelined);
+    DecodeFrame(no_row_mt_dec_, pkt, &md5_no_row_mt);
+    DecodeFrame(pooled_dec_, pkt, &md5_pooled);
+    DecodeFrameParallel(pkt);
+    EXPECT_STREQ(md5_single.Get(), md5_multi.Get())
+        << "Mismatch at frame " << frame_;
+    EXPECT_STREQ(md5_single.Get(), md5_no_row_mt.Get())
+        << "Mismatch without row multi-threading at frame " << frame_;
+    EXPECT_STREQ(md5_single.Get(), md5_unpipelined.Get())
+        << "Pipelined filter mismatch at frame " << frame_;
+    EXPECT_STREQ(md5_single.Get(), md5_pooled.Get())
+        << "Thread pool mismatch at frame " << frame_;
+    ++frame_;
+  }
+
+  void DoTest() {
+    const aom_rational timebase = { 33333333, 1000000000 };
+    cfg_.g_timebase = timebase;
+    cfg_.rc_target_bitrate = 500;
+    cfg_.g_lag_in_frames = 12;
+    cfg_.rc_end_usage = AOM_VBR;
+    frame_ = 0;
+
+    libaom_test::I420VideoSource video("hantro_collage_w352h288.yuv", 352, 288,
+                                       timebase.den, timebase.num, 0, 5);
+    ASSERT_NO_FATAL_FAILURE(RunLoop(&video));
+    ASSERT_NO_FATAL_FAILURE(DecodeFrameParallel(NULL));
+    EXPECT_STREQ(md5_stream_single_.Get(), md5_stream_frame_parallel_.Get())
+        << "Frame parallel mismatch";
+  }
+
+  ::libaom_test::Decoder *single_dec_, *multi_dec_, *unpipelined_dec_;
+  ::libaom_test::Decoder *no_row_mt_dec_, *pooled_dec_, *frame_parallel_dec_;
+  ::libaom_test::MD5 md5_stream_single_, md5_stream_frame_parallel_;
+  aom_thread_pool_t *pool_;
+  int frame_;
+
+ private:
+  int n_tile_cols_;
+  int n_tile_rows_;
+  int n_threads_;
+};
+
+TEST_P(DecodeThreadTest, MD5Match) { DoTest(); }
+
+AV1_INSTANTIATE_TEST_CASE(DecodeThreadTest, ::testing::Values(0, 1),
+                          ::testing::Values(0, 1), ::testing::Values(2, 4));
+}  // namespace
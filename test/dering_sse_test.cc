@@ -0,0 +1,75 @@
+/*
+ * Copyright (c) 2016, Alliance for Open Media. All rights reserved
+ *
+ * This source code is subject to the terms of the BSD 2 Clause License and
+ * the Alliance for Open Media Patent License 1.0. If the BSD 2 Clause License
+ * was not distributed with this source code in the LICENSE file, you can
+ * obtain it at www.aomedia.org/license/software. If the Alliance for Open
+ * Media Patent License 1.0 was not distributed with this source code in the
+ * PATENTS file, you can obtain it at www.aomedia.org/license/patent.
+ */
+
+#include "third_party/googletest/src/include/gtest/gtest.h"
+
+#include "./aom_config.h"
+#include "./av1_rtcd.h"
+#include "test/acm_random.h"
+#include "test/function_equivalence_test.h"
+#include "test/register_state_check.h"
+
+using libaom_test::FunctionEquivalenceTest;
+
+namespace {
+
+// The blocks are read with the strides the dering search uses, for the
+// deringed output and for the source.
+const int kStrideA = 8;
+const int kStrideB = 64;
+
+typedef uint32_t (*DeringSseFunc)(const int16_t *a, int a_stride,
+                                  const int16_t *b, int b_stride);
+typedef libaom_test::FuncParam<DeringSseFunc> TestFuncs;
+
+class DeringSseTest : public FunctionEquivalenceTest<DeringSseFunc> {
+ protected:
+  static const int kIterations = 10000;
+
+  void Common(bool extreme) {
+    const int max_value = (1 << params_.bit_depth) - 1;
+    for (int i = 0; i < 8 * kStrideA; ++i)
+      a_[i] = extreme ? (rng_(2) ? max_value : 0) : rng_(max_value + 1);
+    for (int i = 0; i < 8 * kStrideB; ++i)
+      b_[i] = extreme ? (rng_(2) ? max_value : 0) : rng_(max_value + 1);
+
+    const uint32_t ref = params_.ref_func(a_, kStrideA, b_, kStrideB);
+    uint32_t tst;
+    ASM_REGISTER_STATE_CHECK(tst =
+                                 params_.tst_func(a_, kStrideA, b_, kStrideB));
+    ASSERT_EQ(ref, tst);
+  }
+
+  int16_t a_[8 * kStrideA];
+  int16_t b_[8 * kStrideB];
+};
+
+TEST_P(DeringSseTest, RandomValues) {
+  for (int iter = 0; iter < kIterations && !HasFatalFailure(); ++iter)
+    Common(false);
+}
+
+TEST_P(DeringSseTest, ExtremeValues) {
+  for (int iter = 0; iter < kIterations && !HasFatalFailure(); ++iter)
+    Common(true);
+}
+
+#if HAVE_SSE2
+INSTANTIATE_TEST_CASE_P(
+    SSE2, DeringSseTest,
+    ::testing::Values(TestFuncs(av1_dering_sse_8x8_c, av1_dering_sse_8x8_sse2,
+                                8),
+                      TestFuncs(av1_dering_sse_8x8_c, av1_dering_sse_8x8_sse2,
+                                10),
+                      TestFuncs(av1_dering_sse_8x8_c, av1_dering_sse_8x8_sse2,
+                                12)));
+#endif  // HAVE_SSE2
+}  // namespace
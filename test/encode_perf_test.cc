@@ -52,6 +52,7 @@ const EncodePerfTestVideo kAV1EncodePerfTestVectors[] = {
 
 const int kEncodePerfTestSpeeds[] = { 5, 6, 7, 8 };
 const int kEncodePerfTestThreads[] = { 1, 2, 4 };
+const int kEncodePerfTestRowMT[] = { 0, 1 };
 
 #define NELEMENTS(x) (sizeof((x)) / sizeof((x)[0]))
 
@@ -61,7 +62,8 @@ class AV1EncodePerfTest
  protected:
   AV1EncodePerfTest()
       : EncoderTest(GET_PARAM(0)), min_psnr_(kMaxPsnr), nframes_(0),
-        encoding_mode_(GET_PARAM(1)), speed_(0), threads_(1) {}
+        encoding_mode_(GET_PARAM(1)), speed_(0), threads_(1),
+        row_mt_(0) {}
 
   virtual ~AV1EncodePerfTest() {}
 
@@ -92,6 +94,7 @@ class AV1EncodePerfTest
       encoder->Control(AV1E_SET_TILE_COLUMNS, log2_tile_columns);
       encoder->Control(AV1E_SET_FRAME_PARALLEL_DECODING, 1);
       encoder->Control(AOME_SET_ENABLEAUTOALTREF, 0);
+      encoder->Control(AV1E_SET_ROW_MT, row_mt_);
     }
   }
 
@@ -115,12 +118,15 @@ class AV1EncodePerfTest
 
   void set_threads(unsigned int threads) { threads_ = threads; }
 
+  void set_row_mt(unsigned int row_mt) { row_mt_ = row_mt; }
+
  private:
   double min_psnr_;
   unsigned int nframes_;
   libaom_test::TestMode encoding_mode_;
   unsigned speed_;
   unsigned int threads_;
+  unsigned int row_mt_;
 };
 
 TEST_P(AV1EncodePerfTest, PerfTest) {
@@ -134,51 +140,61 @@ TEST_P(AV1EncodePerfTest, PerfTest) {
                  kEncodePerfTestThreads[k] > 2)
           continue;
 
-        set_threads(kEncodePerfTestThreads[k]);
-        SetUp();
-
-        const aom_rational timebase = { 33333333, 1000000000 };
-        cfg_.g_timebase = timebase;
-        cfg_.rc_target_bitrate = kAV1EncodePerfTestVectors[i].bitrate;
-
-        init_flags_ = AOM_CODEC_USE_PSNR;
-
-        const unsigned frames = kAV1EncodePerfTestVectors[i].frames;
-        const char *video_name = kAV1EncodePerfTestVectors[i].name;
-        libaom_test::I420VideoSource video(
-            video_name, kAV1EncodePerfTestVectors[i].width,
-            kAV1EncodePerfTestVectors[i].height, timebase.den, timebase.num, 0,
-            kAV1EncodePerfTestVectors[i].frames);
-        set_speed(kEncodePerfTestSpeeds[j]);
-
-        aom_usec_timer t;
-        aom_usec_timer_start(&t);
-
-        ASSERT_NO_FATAL_FAILURE(RunLoop(&video));
-
-        aom_usec_timer_mark(&t);
-        const double elapsed_secs = aom_usec_timer_elapsed(&t) / kUsecsInSec;
-        const double fps = frames / elapsed_secs;
-        const double minimum_psnr = min_psnr();
-        std::string display_name(video_name);
-        if (kEncodePerfTestThreads[k] > 1) {
-          char thread_count[32];
-          snprintf(thread_count, sizeof(thread_count), "_t-%d",
-                   kEncodePerfTestThreads[k]);
-          display_name += thread_count;
+        for (size_t m = 0; m < NELEMENTS(kEncodePerfTestRowMT); ++m) {
+          // Row-based threading only matters with more than one thread.
+          if (kEncodePerfTestThreads[k] == 1 && kEncodePerfTestRowMT[m])
+            continue;
+
+          set_threads(kEncodePerfTestThreads[k]);
+          set_row_mt(kEncodePerfTestRowMT[m]);
+          SetUp();
+
+          const aom_rational timebase = { 33333333, 1000000000 };
+          cfg_.g_timebase = timebase;
+          cfg_.rc_target_bitrate = kAV1EncodePerfTestVectors[i].bitrate;
+
+          init_flags_ = AOM_CODEC_USE_PSNR;
+
+          const unsigned frames = kAV1EncodePerfTestVectors[i].frames;
+          const char *video_name = kAV1EncodePerfTestVectors[i].name;
+          libaom_test::I420VideoSource video(
+              video_name, kAV1EncodePerfTestVectors[i].width,
+              kAV1EncodePerfTestVectors[i].height, timebase.den, timebase.num,
+              0, kAV1EncodePerfTestVectors[i].frames);
+          set_speed(kEncodePerfTestSpeeds[j]);
+
+          aom_usec_timer t;
+          aom_usec_timer_start(&t);
+
+          ASSERT_NO_FATAL_FAILURE(RunLoop(&video));
+
+          aom_usec_timer_mark(&t);
+          const double elapsed_secs =
+              aom_usec_timer_elapsed(&t) / kUsecsInSec;
+          const double fps = frames / elapsed_secs;
+          const double minimum_psnr = min_psnr();
+          std::string display_name(video_name);
+          if (kEncodePerfTestThreads[k] > 1) {
+            char thread_count[32];
+            snprintf(thread_count, sizeof(thread_count), "_t-%d",
+                     kEncodePerfTestThreads[k]);
+            display_name += thread_count;
+          }
+          if (kEncodePerfTestRowMT[m]) display_name += "_row-mt";
+
+          printf("{\n");
+          printf("\t\"type\" : \"encode_perf_test\",\n");
+          printf("\t\"version\" : \"%s\",\n", VERSION_STRING_NOSP);
+          printf("\t\"videoName\" : \"%s\",\n", display_name.c_str());
+          printf("\t\"encodeTimeSecs\" : %f,\n", elapsed_secs);
+          printf("\t\"totalFrames\" : %u,\n", frames);
+          printf("\t\"framesPerSecond\" : %f,\n", fps);
+          printf("\t\"minPsnr\" : %f,\n", minimum_psnr);
+          printf("\t\"speed\" : %d,\n", kEncodePerfTestSpeeds[j]);
+          printf("\t\"threads\" : %d,\n", kEncodePerfTestThreads[k]);
+          printf("\t\"rowMt\" : %d\n", kEncodePerfTestRowMT[m]);
+          printf("}\n");
         }
-
-        printf("{\n");
-        printf("\t\"type\" : \"encode_perf_test\",\n");
-        printf("\t\"version\" : \"%s\",\n", VERSION_STRING_NOSP);
-        printf("\t\"videoName\" : \"%s\",\n", display_name.c_str());
-        printf("\t\"encodeTimeSecs\" : %f,\n", elapsed_secs);
-        printf("\t\"totalFrames\" : %u,\n", frames);
-        printf("\t\"framesPerSecond\" : %f,\n", fps);
-        printf("\t\"minPsnr\" : %f,\n", minimum_psnr);
-        printf("\t\"speed\" : %d,\n", kEncodePerfTestSpeeds[j]);
-        printf("\t\"threads\" : %d\n", kEncodePerfTestThreads[k]);
-        printf("}\n");
       }
     }
   }
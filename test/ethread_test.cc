@@ -9,6 +9,7 @@
  * PATENTS file, you can obtain it at www.aomedia.org/license/patent.
 */
 
+#include <stdio.h>
 #include <string>
 #include <vector>
 #include "third_party/googletest/src/include/gtest/gtest.h"
@@ -17,6 +18,7 @@
 #include "test/md5_helper.h"
 #include "test/util.h"
 #include "test/y4m_video_source.h"
+#include "aom_dsp/aom_dsp_common.h"
 
 namespace {
 class AVxEncoderThreadTest
@@ -25,7 +27,9 @@ class AVxEncoderThreadTest
  protected:
   AVxEncoderThreadTest()
       : EncoderTest(GET_PARAM(0)), encoder_initialized_(false),
-        encoding_mode_(GET_PARAM(1)), set_cpu_used_(GET_PARAM(2)) {
+        encoding_mode_(GET_PARAM(1)), set_cpu_used_(GET_PARAM(2)),
+        row_mt_(0), tile_cols_(2), tile_rows_(0), cq_level_(-1),
+        video_start_(15), video_limit_(18) {
     init_flags_ = AOM_CODEC_USE_PSNR;
     aom_codec_dec_cfg_t cfg = aom_codec_dec_cfg_t();
     cfg.w = 1280;
@@ -79,11 +83,14 @@ class AVxEncoderThreadTest
         encoder->Control(AV1E_SET_TILE_ROWS, 0);
       }
 #else
-      // Encode 4 tile columns.
-      encoder->Control(AV1E_SET_TILE_COLUMNS, 2);
-      encoder->Control(AV1E_SET_TILE_ROWS, 0);
+      // Encode 1 << tile_cols_ tile columns, 4 by default, and 1 << tile_rows_
+      // tile rows, 1 by default.
+      encoder->Control(AV1E_SET_TILE_COLUMNS, tile_cols_);
+      encoder->Control(AV1E_SET_TILE_ROWS, tile_rows_);
 #endif  // CONFIG_AV1 && CONFIG_EXT_TILE
       encoder->Control(AOME_SET_CPUUSED, set_cpu_used_);
+      encoder->Control(AV1E_SET_ROW_MT, row_mt_);
+      if (cq_level_ >= 0) encoder->Control(AOME_SET_CQ_LEVEL, cq_level_);
       if (encoding_mode_ != ::libaom_test::kRealTime) {
         encoder->Control(AOME_SET_ENABLEAUTOALTREF, 1);
         encoder->Control(AOME_SET_ARNR_MAXFRAMES, 7);
@@ -121,36 +128,38 @@ class AVxEncoderThreadTest
     }
   }
 
-  void DoTest() {
-    ::libaom_test::Y4mVideoSource video("niklas_1280_720_30.y4m", 15, 18);
+  // Encodes the clip with the given number of threads, keeping the size and
+  // the checksums of each frame.
+  void Encode(int threads) {
+    ::libaom_test::Y4mVideoSource video("niklas_1280_720_30.y4m",
+                                        video_start_, video_limit_);
     cfg_.rc_target_bitrate = 1000;
-
-    // Encode using single thread.
-    cfg_.g_threads = 1;
+    cfg_.g_threads = threads;
     init_flags_ = AOM_CODEC_USE_PSNR;
+    size_enc_.clear();
+    md5_enc_.clear();
+    md5_dec_.clear();
     ASSERT_NO_FATAL_FAILURE(RunLoop(&video));
+  }
+
+  void DoTest() {
+    // Encode using single thread.
+    ASSERT_NO_FATAL_FAILURE(Encode(1));
     std::vector<size_t> single_thr_size_enc;
     std::vector<std::string> single_thr_md5_enc;
     std::vector<std::string> single_thr_md5_dec;
     single_thr_size_enc = size_enc_;
     single_thr_md5_enc = md5_enc_;
     single_thr_md5_dec = md5_dec_;
-    size_enc_.clear();
-    md5_enc_.clear();
-    md5_dec_.clear();
 
     // Encode using multiple threads.
-    cfg_.g_threads = 4;
-    ASSERT_NO_FATAL_FAILURE(RunLoop(&video));
+    ASSERT_NO_FATAL_FAILURE(Encode(4));
     std::vector<size_t> multi_thr_size_enc;
     std::vector<std::string> multi_thr_md5_enc;
     std::vector<std::string> multi_thr_md5_dec;
     multi_thr_size_enc = size_enc_;
     multi_thr_md5_enc = md5_enc_;
     multi_thr_md5_dec = md5_dec_;
-    size_enc_.clear();
-    md5_enc_.clear();
-    md5_dec_.clear();
 
     // Check that the vectors are equal.
     ASSERT_EQ(single_thr_size_enc, multi_thr_size_enc);
@@ -161,6 +170,12 @@ class AVxEncoderThreadTest
   bool encoder_initialized_;
   ::libaom_test::TestMode encoding_mode_;
   int set_cpu_used_;
+  unsigned int row_mt_;
+  int tile_cols_;
+  int tile_rows_;
+  int cq_level_;
+  unsigned int video_start_;
+  int video_limit_;
   ::libaom_test::Decoder *decoder_;
   std::vector<size_t> size_enc_;
   std::vector<std::string> md5_enc_;
@@ -173,6 +188,184 @@ class AVxEncoderThreadTestLarge : public AVxEncoderThreadTest {};
 
 TEST_P(AVxEncoderThreadTestLarge, EncoderResultTest) { DoTest(); }
 
+// Row-based multi-threading must also produce the same output for any number
+// of threads.
+class AVxEncoderRowMTTest : public AVxEncoderThreadTest {
+ protected:
+  AVxEncoderRowMTTest() { row_mt_ = 1; }
+};
+
+TEST_P(AVxEncoderRowMTTest, EncoderResultTest) { DoTest(); }
+
+// At a constant quality and the slower speeds, the loop filter level is
+// searched on strips of superblock rows, with the levels of each step tried
+// on the encoder workers.
+class AVxEncoderThreadCQTestLarge : public AVxEncoderThreadTest {
+ protected:
+  virtual void SetUp() {
+    AVxEncoderThreadTest::SetUp();
+    cfg_.rc_end_usage = AOM_Q;
+  }
+};
+
+TEST_P(AVxEncoderThreadCQTestLarge, EncoderResultTest) {
+  const int kCqLevels[] = { 8, 32, 56 };
+  for (size_t i = 0; i < sizeof(kCqLevels) / sizeof(kCqLevels[0]); ++i) {
+    cq_level_ = kCqLevels[i];
+    ASSERT_NO_FATAL_FAILURE(DoTest());
+  }
+}
+
+// At a constant quality with a long lag, the alt-ref frames are filtered over
+// the whole ARNR window, on the encoder workers when there are several threads.
+class AVxEncoderThreadARNRTest : public AVxEncoderThreadTest {
+ protected:
+  AVxEncoderThreadARNRTest() : filter_time_(0) {
+    cq_level_ = 32;
+    video_start_ = 0;
+    video_limit_ = 12;
+  }
+
+  virtual void SetUp() {
+    AVxEncoderThreadTest::SetUp();
+    cfg_.g_lag_in_frames = 16;
+    cfg_.rc_end_usage = AOM_Q;
+  }
+
+  virtual void PreEncodeFrameHook(::libaom_test::VideoSource *video,
+                                  ::libaom_test::Encoder *encoder) {
+    AVxEncoderThreadTest::PreEncodeFrameHook(video, encoder);
+    encoder->Control(AV1E_GET_TEMPORAL_FILTER_TIME, &filter_time_);
+  }
+
+  int64_t filter_time_;
+};
+
+TEST_P(AVxEncoderThreadARNRTest, EncoderResultTest) {
+  ASSERT_NO_FATAL_FAILURE(DoTest());
+  EXPECT_GT(filter_time_, 0);
+}
+
+TEST_P(AVxEncoderThreadARNRTest, DISABLED_Speed) {
+  const int kThreads = 4;
+  video_limit_ = 30;
+  ASSERT_NO_FATAL_FAILURE(Encode(1));
+  const int64_t single_time = filter_time_;
+  ASSERT_NO_FATAL_FAILURE(Encode(kThreads));
+  const int64_t multi_time = filter_time_;
+  printf("Temporal filter over %d frames: %d ms with 1 thread, %d ms with %d "
+         "threads, %.2fx\n",
+         video_limit_ - video_start_, static_cast<int>(single_time / 1000),
+         static_cast<int>(multi_time / 1000), kThreads,
+         static_cast<double>(single_time) / AOMMAX(multi_time, 1));
+}
+
+// With 2 tile columns and 4 threads, the tiles are encoded on 2 workers, but
+// the stages that run on the workers after them must still get all 4.
+class AVxEncoderThreadTileColsTest : public AVxEncoderThreadTest {
+ protected:
+  AVxEncoderThreadTileColsTest() : num_workers_(0) { tile_cols_ = 1; }
+
+  virtual void PreEncodeFrameHook(::libaom_test::VideoSource *video,
+                                  ::libaom_test::Encoder *encoder) {
+    AVxEncoderThreadTest::PreEncodeFrameHook(video, encoder);
+    // The workers created for the frames before this one.
+    encoder->Control(AV1E_GET_NUM_WORKERS, &num_workers_);
+  }
+
+  int num_workers_;
+};
+
+TEST_P(AVxEncoderThreadTileColsTest, EncoderResultTest) {
+  ASSERT_NO_FATAL_FAILURE(DoTest());
+  EXPECT_EQ(4, num_workers_);
+}
+
+// With 4 tile rows, each worker encodes the tiles of its column from the top,
+// since they share their above context.
+class AVxEncoderThreadTileRowsTest : public AVxEncoderThreadTest {
+ protected:
+  AVxEncoderThreadTileRowsTest() { tile_rows_ = 2; }
+};
+
+TEST_P(AVxEncoderThreadTileRowsTest, EncoderResultTest) { DoTest(); }
+
+#if CONFIG_LOOP_RESTORATION
+// At this constant quality the bilateral filters chosen for the restoration
+// tiles change the pixels that the tiles after them read, while the tiles are
+// searched on the encoder workers when there are several threads.
+class AVxEncoderThreadLRTest : public AVxEncoderThreadTest {
+ protected:
+  AVxEncoderThreadLRTest() { cq_level_ = 40; }
+
+  virtual void SetUp() {
+    AVxEncoderThreadTest::SetUp();
+    cfg_.g_lag_in_frames = 0;
+    cfg_.rc_end_usage = AOM_Q;
+  }
+};
+
+TEST_P(AVxEncoderThreadLRTest, EncoderResultTest) { DoTest(); }
+#endif  // CONFIG_LOOP_RESTORATION
+
+#if CONFIG_CLPF
+// At this constant quality CLPF is turned on, for whole frames or per filter
+// block. The errors of the blocks are measured on the encoder workers when
+// there are several threads, and the strengths and the block decisions taken
+// from them are coded in the bitstream.
+class AVxEncoderThreadCLPFTest : public AVxEncoderThreadTest {
+ protected:
+  AVxEncoderThreadCLPFTest() { cq_level_ = 40; }
+
+  virtual void SetUp() {
+    AVxEncoderThreadTest::SetUp();
+    cfg_.g_lag_in_frames = 0;
+    cfg_.rc_end_usage = AOM_Q;
+  }
+};
+
+TEST_P(AVxEncoderThreadCLPFTest, EncoderResultTest) { DoTest(); }
+#endif  // CONFIG_CLPF
+
+// The transform RD results of the inter blocks are cached, which must give
+// the same stream as without the cache for any number of threads.
+class AVxEncoderTxfmRdCacheTest : public AVxEncoderThreadTest {
+ protected:
+  AVxEncoderTxfmRdCacheTest() : cache_(1), lookups_(0), hits_(0) {}
+
+  virtual void PreEncodeFrameHook(::libaom_test::VideoSource *video,
+                                  ::libaom_test::Encoder *encoder) {
+    if (!encoder_initialized_)
+      encoder->Control(AV1E_SET_TXFM_RD_CACHE, cache_);
+    AVxEncoderThreadTest::PreEncodeFrameHook(video, encoder);
+    // The statistics of the frames before this one.
+    int64_t stats[2];
+    encoder->Control(AV1E_GET_TXFM_RD_CACHE_STATS, stats);
+    lookups_ = stats[0];
+    hits_ = stats[1];
+  }
+
+  int cache_;
+  int64_t lookups_;
+  int64_t hits_;
+};
+
+TEST_P(AVxEncoderTxfmRdCacheTest, EncoderResultTest) {
+  cache_ = 0;
+  ASSERT_NO_FATAL_FAILURE(Encode(1));
+  EXPECT_EQ(0, lookups_);
+  const std::vector<std::string> uncached_md5_enc = md5_enc_;
+
+  cache_ = 1;
+  ASSERT_NO_FATAL_FAILURE(DoTest());
+  ASSERT_EQ(uncached_md5_enc, md5_enc_);
+#if !CONFIG_PVQ
+  // The results are only cached without PVQ.
+  EXPECT_GT(hits_, 0);
+  EXPECT_LE(hits_, lookups_);
+#endif  // !CONFIG_PVQ
+}
+
 #if CONFIG_EC_ADAPT
 // TODO(thdavies): EC_ADAPT does not support tiles
 
@@ -186,5 +379,43 @@ AV1_INSTANTIATE_TEST_CASE(AVxEncoderThreadTestLarge,
                           ::testing::Values(::libaom_test::kTwoPassGood,
                                             ::libaom_test::kOnePassGood),
                           ::testing::Range(0, 3));
+
+AV1_INSTANTIATE_TEST_CASE(AVxEncoderRowMTTest,
+                          ::testing::Values(::libaom_test::kTwoPassGood,
+                                            ::libaom_test::kOnePassGood),
+                          ::testing::Values(1, 4));
+
+AV1_INSTANTIATE_TEST_CASE(AVxEncoderThreadCQTestLarge,
+                          ::testing::Values(::libaom_test::kOnePassGood),
+                          ::testing::Values(2));
+
+AV1_INSTANTIATE_TEST_CASE(AVxEncoderThreadARNRTest,
+                          ::testing::Values(::libaom_test::kOnePassGood),
+                          ::testing::Values(8));
+
+AV1_INSTANTIATE_TEST_CASE(AVxEncoderThreadTileColsTest,
+                          ::testing::Values(::libaom_test::kOnePassGood),
+                          ::testing::Values(2));
+
+AV1_INSTANTIATE_TEST_CASE(AVxEncoderThreadTileRowsTest,
+                          ::testing::Values(::libaom_test::kTwoPassGood,
+                                            ::libaom_test::kOnePassGood),
+                          ::testing::Values(4));
+
+#if CONFIG_LOOP_RESTORATION
+AV1_INSTANTIATE_TEST_CASE(AVxEncoderThreadLRTest,
+                          ::testing::Values(::libaom_test::kOnePassGood),
+                          ::testing::Values(6));
+#endif  // CONFIG_LOOP_RESTORATION
+
+#if CONFIG_CLPF
+AV1_INSTANTIATE_TEST_CASE(AVxEncoderThreadCLPFTest,
+                          ::testing::Values(::libaom_test::kOnePassGood),
+                          ::testing::Values(4));
+#endif  // CONFIG_CLPF
+
+AV1_INSTANTIATE_TEST_CASE(AVxEncoderTxfmRdCacheTest,
+                          ::testing::Values(::libaom_test::kOnePassGood),
+                          ::testing::Values(3, 4));
 #endif
 }  // namespace
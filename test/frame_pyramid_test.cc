@@ -0,0 +1,166 @@
+/*
+ * Copyright (c) 2016, Alliance for Open Media. All rights reserved
+ *
+ * This source code is subject to the terms of the BSD 2 Clause License and
+ * the Alliance for Open Media Patent License 1.0. If the BSD 2 Clause License
+ * was not distributed with this source code in the LICENSE file, you can
+ * obtain it at www.aomedia.org/license/software. If the Alliance for Open
+ * Media Patent License 1.0 was not distributed with this source code in the
+ * PATENTS file, you can obtain it at www.aomedia.org/license/patent.
+ */
+
+#include <string.h>
+
+#include <vector>
+
+#include "third_party/googletest/src/include/gtest/gtest.h"
+
+#include "./aom_config.h"
+#include "aom_scale/yv12config.h"
+#include "av1/encoder/mcomp.h"
+#include "test/acm_random.h"
+
+namespace {
+
+using ::libaom_test::ACMRandom;
+
+// The pyramids are built from the luma plane of frames of odd sizes, so that
+// the last row and column of some of the levels are repeated.
+class FramePyramidTest : public ::testing::TestWithParam<int> {
+ protected:
+  virtual void SetUp() {
+    bit_depth_ = GetParam();
+    rnd_.Reset(ACMRandom::DeterministicSeed());
+    memset(&frame_, 0, sizeof(frame_));
+    ASSERT_EQ(0, aom_alloc_frame_buffer(&frame_, kWidth, kHeight, 1, 1,
+#if CONFIG_AOM_HIGHBITDEPTH
+                                        bit_depth_ > 8,
+#endif
+                                        32, 0));
+  }
+
+  virtual void TearDown() { aom_free_frame_buffer(&frame_); }
+
+  void FillFrame() {
+    const int max_value = (1 << bit_depth_) - 1;
+    for (int i = 0; i < kHeight; ++i) {
+      for (int j = 0; j < kWidth; ++j) {
+        const int v = rnd_(max_value + 1);
+#if CONFIG_AOM_HIGHBITDEPTH
+        if (bit_depth_ > 8) {
+          CONVERT_TO_SHORTPTR(frame_.y_buffer)[i * frame_.y_stride + j] = v;
+          continue;
+        }
+#endif
+        frame_.y_buffer[i * frame_.y_stride + j] = v;
+      }
+    }
+  }
+
+  // Checks each of |levels| levels of the pyramid, and their borders,
+  // against levels made from the frame here.
+  void CheckPyramid(int levels) {
+    std::vector<int> above(kWidth * kHeight);
+    int above_w = kWidth, above_h = kHeight;
+    int shift = 2 + bit_depth_ - 8;
+
+    for (int i = 0; i < kHeight; ++i) {
+      for (int j = 0; j < kWidth; ++j) {
+#if CONFIG_AOM_HIGHBITDEPTH
+        if (bit_depth_ > 8) {
+          above[i * kWidth + j] =
+              CONVERT_TO_SHORTPTR(frame_.y_buffer)[i * frame_.y_stride + j];
+          continue;
+        }
+#endif
+        above[i * kWidth + j] = frame_.y_buffer[i * frame_.y_stride + j];
+      }
+    }
+
+    ASSERT_TRUE(frame_.pyramid_valid);
+    ASSERT_EQ(levels, frame_.pyramid_levels);
+    for (int l = 1; l <= levels; ++l) {
+      const int w = (above_w + 1) >> 1, h = (above_h + 1) >> 1;
+      const int stride = frame_.pyramid_stride[l];
+      const uint8_t *const buf = frame_.pyramid_buffer[l];
+      std::vector<int> level(w * h);
+
+      ASSERT_EQ(w, frame_.pyramid_width[l]);
+      ASSERT_EQ(h, frame_.pyramid_height[l]);
+      for (int i = 0; i < h; ++i) {
+        const int r0 = 2 * i, r1 = AOMMIN(2 * i + 1, above_h - 1);
+        for (int j = 0; j < w; ++j) {
+          const int c0 = 2 * j, c1 = AOMMIN(2 * j + 1, above_w - 1);
+          const int sum = above[r0 * kWidth + c0] + above[r0 * kWidth + c1] +
+                          above[r1 * kWidth + c0] + above[r1 * kWidth + c1];
+          level[i * w + j] = ROUND_POWER_OF_TWO(sum, shift);
+          ASSERT_EQ(level[i * w + j], buf[i * stride + j])
+              << "level " << l << " at " << i << "," << j;
+        }
+      }
+
+      // The border repeats the nearest pixel of the level.
+      for (int i = -PYRAMID_BORDER; i < h + PYRAMID_BORDER; ++i) {
+        const int r = clamp(i, 0, h - 1);
+        for (int j = -PYRAMID_BORDER; j < w + PYRAMID_BORDER; ++j) {
+          const int c = clamp(j, 0, w - 1);
+          ASSERT_EQ(level[r * w + c], buf[i * stride + j])
+              << "level " << l << " border at " << i << "," << j;
+        }
+      }
+
+      for (int i = 0; i < h; ++i)
+        for (int j = 0; j < w; ++j) above[i * kWidth + j] = level[i * w + j];
+      above_w = w;
+      above_h = h;
+      shift = 2;
+    }
+  }
+
+  static const int kWidth = 157;
+  static const int kHeight = 93;
+
+  int bit_depth_;
+  ACMRandom rnd_;
+  YV12_BUFFER_CONFIG frame_;
+};
+
+TEST_P(FramePyramidTest, Levels) {
+  for (int levels = 1; levels <= YV12_MAX_PYRAMID_LEVELS; ++levels) {
+    FillFrame();
+    aom_invalidate_frame_buffer_cache(&frame_);
+    ASSERT_EQ(1, av1_build_frame_pyramid(&frame_, levels, bit_depth_));
+    CheckPyramid(levels);
+  }
+}
+
+TEST_P(FramePyramidTest, Cached) {
+  FillFrame();
+  ASSERT_EQ(1, av1_build_frame_pyramid(&frame_, 2, bit_depth_));
+  CheckPyramid(2);
+
+  // A pyramid with enough levels is kept, even if the frame has changed.
+  const uint8_t first = frame_.pyramid_buffer[1][0];
+  frame_.pyramid_buffer[1][0] = first ^ 1;
+  ASSERT_EQ(1, av1_build_frame_pyramid(&frame_, 1, bit_depth_));
+  ASSERT_EQ(first ^ 1, frame_.pyramid_buffer[1][0]);
+  ASSERT_EQ(2, frame_.pyramid_levels);
+
+  // More levels make the whole pyramid again.
+  ASSERT_EQ(1, av1_build_frame_pyramid(&frame_, 3, bit_depth_));
+  CheckPyramid(3);
+
+  // So does new content in the frame.
+  FillFrame();
+  aom_invalidate_frame_buffer_cache(&frame_);
+  ASSERT_FALSE(frame_.pyramid_valid);
+  ASSERT_EQ(1, av1_build_frame_pyramid(&frame_, 2, bit_depth_));
+  CheckPyramid(2);
+}
+
+#if CONFIG_AOM_HIGHBITDEPTH
+INSTANTIATE_TEST_CASE_P(C, FramePyramidTest, ::testing::Values(8, 10, 12));
+#else
+INSTANTIATE_TEST_CASE_P(C, FramePyramidTest, ::testing::Values(8));
+#endif  // CONFIG_AOM_HIGHBITDEPTH
+}  // namespace
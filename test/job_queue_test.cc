@@ -0,0 +1,117 @@
+/*
+ * Copyright (c) 2016, Alliance for Open Media. All rights reserved
+ *
+ * This source code is subject to the terms of the BSD 2 Clause License and
+ * the Alliance for Open Media Patent License 1.0. If the BSD 2 Clause License
+ * was not distributed with this source code in the LICENSE file, you can
+ * obtain it at www.aomedia.org/license/software. If the Alliance for Open
+ * Media Patent License 1.0 was not distributed with this source code in the
+ * PATENTS file, you can obtain it at www.aomedia.org/license/patent.
+ */
+
+#include "third_party/googletest/src/include/gtest/gtest.h"
+
+#include "aom_util/aom_job_queue.h"
+#include "aom_util/aom_thread.h"
+
+namespace {
+
+const int kMaxThreads = 8;
+const int kNumJobs = 37;
+
+struct JobWorkerData {
+  AOMJobQueue *queue;
+  int thread;
+  int *run_count;
+};
+
+int JobWorkerHook(void *arg1, void *arg2) {
+  JobWorkerData *const data = reinterpret_cast<JobWorkerData *>(arg1);
+  int job;
+  (void)arg2;
+  while ((job = aom_job_queue_pop(data->queue, data->thread)) >= 0)
+    ++data->run_count[job];
+  return 1;
+}
+
+class JobQueueTest : public ::testing::TestWithParam<int> {
+ protected:
+  virtual void SetUp() {
+    ASSERT_TRUE(aom_job_queue_alloc(&queue_, kMaxThreads, kNumJobs));
+  }
+
+  virtual void TearDown() { aom_job_queue_dealloc(&queue_); }
+
+  AOMJobQueue queue_;
+};
+
+TEST_P(JobQueueTest, RunsEveryJobOnce) {
+  const AVxWorkerInterface *const winterface = aom_get_worker_interface();
+  const int num_threads = GetParam();
+  AVxWorker workers[kMaxThreads];
+  JobWorkerData data[kMaxThreads];
+  int run_count[kNumJobs] = { 0 };
+
+  for (int run = 0; run < 2; ++run) {
+    aom_job_queue_reset(&queue_, num_threads, 0);
+    if (run == 0) {
+      aom_job_queue_push_range(&queue_, kNumJobs);
+    } else {
+      // The first thread is handed every job, so the others have to steal.
+      for (int job = 0; job < kNumJobs; ++job)
+        aom_job_queue_push(&queue_, 0, job);
+    }
+
+    for (int i = 0; i < num_threads; ++i) {
+      AVxWorker *const worker = &workers[i];
+      winterface->init(worker);
+      ASSERT_NE(winterface->reset(worker), 0);
+      data[i].queue = &queue_;
+      data[i].thread = i;
+      data[i].run_count = run_count;
+      worker->hook = JobWorkerHook;
+      worker->data1 = &data[i];
+      worker->data2 = NULL;
+      if (i == num_threads - 1)
+        winterface->execute(worker);
+      else
+        winterface->launch(worker);
+    }
+    for (int i = 0; i < num_threads; ++i) {
+      EXPECT_NE(winterface->sync(&workers[i]), 0);
+      winterface->end(&workers[i]);
+    }
+    aom_job_queue_finish(&queue_);
+
+    for (int job = 0; job < kNumJobs; ++job)
+      ASSERT_EQ(run + 1, run_count[job]) << "job " << job << " run " << run;
+  }
+
+  for (int i = 0; i < num_threads; ++i) EXPECT_GE(queue_.idle_usec[i], 0);
+}
+
+TEST_P(JobQueueTest, StealsFromTheBack) {
+  const int num_threads = GetParam();
+
+  aom_job_queue_reset(&queue_, num_threads, 0);
+  for (int job = 0; job < kNumJobs; ++job)
+    aom_job_queue_push(&queue_, 0, job);
+
+  // The owner takes the jobs in order, and the other threads from the end.
+  int expected_front = 0;
+  int expected_back = kNumJobs - 1;
+  for (int i = 0; i < kNumJobs; ++i) {
+    const int thread = i % num_threads;
+    if (thread == 0) {
+      EXPECT_EQ(expected_front++, aom_job_queue_pop(&queue_, thread));
+    } else {
+      EXPECT_EQ(expected_back--, aom_job_queue_pop(&queue_, thread));
+    }
+  }
+  for (int i = 0; i < num_threads; ++i)
+    EXPECT_EQ(-1, aom_job_queue_pop(&queue_, i));
+}
+
+INSTANTIATE_TEST_CASE_P(AOM, JobQueueTest, ::testing::Values(1, 2, 3, 8));
+
+}  // namespace
@@ -0,0 +1,206 @@
+/*
+ * Copyright (c) 2016, Alliance for Open Media. All rights reserved
+ *
+ * This source code is subject to the terms of the BSD 2 Clause License and
+ * the Alliance for Open Media Patent License 1.0. If the BSD 2 Clause License
+ * was not distributed with this source code in the LICENSE file, you can
+ * obtain it at www.aomedia.org/license/software. If the Alliance for Open
+ * Media Patent License 1.0 was not distributed with this source code in the
+ * PATENTS file, you can obtain it at www.aomedia.org/license/patent.
+ */
+
+#include <string.h>
+
+#include "third_party/googletest/src/include/gtest/gtest.h"
+
+#include "./aom_config.h"
+#include "./aom_scale_rtcd.h"
+#include "aom_scale/yv12config.h"
+#include "av1/common/loopfilter.h"
+#include "av1/common/onyxc_int.h"
+#include "av1/encoder/encoder.h"
+#include "av1/encoder/picklpf.h"
+#include "av1/encoder/rd.h"
+#include "test/acm_random.h"
+
+namespace {
+
+using ::libaom_test::ACMRandom;
+
+// The frame is 5 superblocks high, so that the partial frame search only
+// filters a middle strip of it, and its width and height are not multiples of
+// 8, so that the last blocks are cropped.
+const int kWidth = 197;
+const int kHeight = 291;
+
+// Checks the errors of the loop filter levels measured on strips of
+// superblock rows against those of filtering the whole frame, on a frame of
+// 8x8 blocks of random modes, transform sizes and skip flags.
+class PickLpfTest : public ::testing::TestWithParam<int> {
+ protected:
+  PickLpfTest() : cpi_(NULL) {}
+
+  virtual void SetUp() {
+    bit_depth_ = GetParam();
+    rnd_.Reset(ACMRandom::DeterministicSeed());
+
+    memset(&source_, 0, sizeof(source_));
+    memset(&recon_, 0, sizeof(recon_));
+
+    AV1EncoderConfig oxcf;
+    memset(&oxcf, 0, sizeof(oxcf));
+    oxcf.profile = bit_depth_ > 8 ? PROFILE_2 : PROFILE_0;
+    oxcf.bit_depth = static_cast<aom_bit_depth_t>(bit_depth_);
+    oxcf.input_bit_depth = bit_depth_;
+#if CONFIG_AOM_HIGHBITDEPTH
+    oxcf.use_highbitdepth = bit_depth_ > 8;
+#endif
+    oxcf.width = kWidth;
+    oxcf.height = kHeight;
+    oxcf.init_framerate = 30;
+    oxcf.max_threads = 1;
+    oxcf.mode = GOOD;
+    oxcf.rc_mode = AOM_Q;
+    oxcf.worst_allowed_q = 255;
+    memset(&pool_, 0, sizeof(pool_));
+    cpi_ = av1_create_compressor(&oxcf, &pool_);
+    ASSERT_TRUE(cpi_ != NULL);
+    cm_ = &cpi_->common;
+    // The superblock size is otherwise set up when a frame is encoded.
+    set_sb_size(cm_, BLOCK_LARGEST);
+
+    ASSERT_EQ(0, AllocFrame(&source_));
+    ASSERT_EQ(0, AllocFrame(&recon_));
+    ASSERT_EQ(0, AllocFrame(&cpi_->last_frame_uf));
+    cm_->frame_to_show = &recon_;
+    cpi_->td.mb.rdmult = 1000;
+    cpi_->td.mb.rddiv = RDDIV_BITS;
+  }
+
+  virtual void TearDown() {
+    aom_free_frame_buffer(&source_);
+    aom_free_frame_buffer(&recon_);
+    if (cpi_ != NULL) av1_remove_compressor(cpi_);
+  }
+
+  int AllocFrame(YV12_BUFFER_CONFIG *frame) {
+    return aom_alloc_frame_buffer(frame, kWidth, kHeight, 1, 1,
+#if CONFIG_AOM_HIGHBITDEPTH
+                                  bit_depth_ > 8,
+#endif
+                                  AOM_BORDER_IN_PIXELS, 0);
+  }
+
+  void SetPixel(YV12_BUFFER_CONFIG *frame, int row, int col, int v) {
+#if CONFIG_AOM_HIGHBITDEPTH
+    if (bit_depth_ > 8) {
+      CONVERT_TO_SHORTPTR(frame->y_buffer)[row * frame->y_stride + col] = v;
+      return;
+    }
+#endif
+    frame->y_buffer[row * frame->y_stride + col] = v;
+  }
+
+  // Gives each 8x8 block its own mode info, with a size that lets it be
+  // filtered inside and on its edges. The source is a ramp with some detail on
+  // it, and the reconstruction keeps the detail but flattens the ramp in each
+  // block, so that filtering lowers the error up to some level and the
+  // search moves away from where it starts.
+  void MakeFrame() {
+    const int scale = 1 << (bit_depth_ - 8);
+
+    for (int mi_row = 0; mi_row < cm_->mi_rows; ++mi_row) {
+      for (int mi_col = 0; mi_col < cm_->mi_cols; ++mi_col) {
+        const int offset = mi_row * cm_->mi_stride + mi_col;
+        MB_MODE_INFO *const mbmi = &cm_->mi[offset].mbmi;
+        memset(mbmi, 0, sizeof(*mbmi));
+        mbmi->sb_type = BLOCK_8X8;
+        mbmi->tx_size = rnd_(2) ? TX_8X8 : TX_4X4;
+        mbmi->skip = rnd_(2);
+        if (rnd_(2)) {
+          mbmi->ref_frame[0] = LAST_FRAME;
+          mbmi->mode = rnd_(2) ? ZEROMV : NEWMV;
+        } else {
+          mbmi->ref_frame[0] = INTRA_FRAME;
+          mbmi->mode = DC_PRED;
+        }
+        mbmi->ref_frame[1] = NONE;
+#if CONFIG_SUPERTX
+        mbmi->segment_id_supertx = MAX_SEGMENTS;
+#endif
+        cm_->mi_grid_visible[offset] = &cm_->mi[offset];
+      }
+    }
+
+    for (int r = 0; r < kHeight; r += 8) {
+      for (int c = 0; c < kWidth; c += 8) {
+        const int base = Ramp(r + 4, c + 4);
+        for (int i = r; i < AOMMIN(r + 8, kHeight); ++i) {
+          for (int j = c; j < AOMMIN(c + 8, kWidth); ++j) {
+            const int detail = rnd_(8) - 4;
+            SetPixel(&recon_, i, j, (base + detail) * scale);
+            SetPixel(&source_, i, j, (Ramp(i, j) + detail) * scale);
+          }
+        }
+      }
+    }
+    aom_extend_frame_borders(&recon_);
+    aom_extend_frame_borders(&source_);
+  }
+
+  // Returns a value that rises by 1 every pixel to the right and every other
+  // pixel down, and falls back every 64.
+  static int Ramp(int row, int col) { return 96 + (row / 2 + col) % 64; }
+
+  // Checks the errors of the strips of every level, tried in the groups the
+  // search uses, and then the level and cost the search returns.
+  void CheckSearch(int partial_frame) {
+    int64_t strip_err[MAX_LOOP_FILTER + 1];
+    int64_t frame_err[MAX_LOOP_FILTER + 1];
+
+    MakeFrame();
+    for (int level = 0; level <= MAX_LOOP_FILTER; level += 3) {
+      const int levels[3] = { level, level + 1, level + 2 };
+      const int num_levels = AOMMIN(3, MAX_LOOP_FILTER + 1 - level);
+      av1_try_filter_levels(&source_, cpi_, partial_frame, levels, num_levels,
+                            strip_err);
+    }
+    for (int level = 0; level <= MAX_LOOP_FILTER; ++level) {
+      frame_err[level] =
+          av1_try_filter_frame(&source_, cpi_, level, partial_frame);
+      ASSERT_EQ(frame_err[level], strip_err[level]) << "level " << level;
+    }
+
+    for (int start = 0; start <= MAX_LOOP_FILTER; start += 16) {
+      double cost;
+      cm_->lf.filter_level = start;
+      const int level =
+          av1_search_filter_level(&source_, cpi_, partial_frame, &cost);
+      ASSERT_GE(level, 0);
+      ASSERT_LE(level, MAX_LOOP_FILTER);
+      EXPECT_EQ(RDCOST_DBL(cpi_->td.mb.rdmult, cpi_->td.mb.rddiv, 0,
+                           frame_err[level]),
+                cost)
+          << "start " << start;
+    }
+  }
+
+  int bit_depth_;
+  ACMRandom rnd_;
+  BufferPool pool_;
+  AV1_COMP *cpi_;
+  AV1_COMMON *cm_;
+  YV12_BUFFER_CONFIG source_;
+  YV12_BUFFER_CONFIG recon_;
+};
+
+TEST_P(PickLpfTest, FullFrame) { CheckSearch(0); }
+
+TEST_P(PickLpfTest, PartialFrame) { CheckSearch(1); }
+
+#if CONFIG_AOM_HIGHBITDEPTH
+INSTANTIATE_TEST_CASE_P(C, PickLpfTest, ::testing::Values(8, 10));
+#else
+INSTANTIATE_TEST_CASE_P(C, PickLpfTest, ::testing::Values(8));
+#endif  // CONFIG_AOM_HIGHBITDEPTH
+}  // namespace
@@ -0,0 +1,180 @@
+/*
+ * Copyright (c) 2016, Alliance for Open Media. All rights reserved
+ *
+ * This source code is subject to the terms of the BSD 2 Clause License and
+ * the Alliance for Open Media Patent License 1.0. If the BSD 2 Clause License
+ * was not distributed with this source code in the LICENSE file, you can
+ * obtain it at www.aomedia.org/license/software. If the Alliance for Open
+ * Media Patent License 1.0 was not distributed with this source code in the
+ * PATENTS file, you can obtain it at www.aomedia.org/license/patent.
+ */
+
+#include <stdio.h>
+#include <string.h>
+
+#include "third_party/googletest/src/include/gtest/gtest.h"
+
+#include "test/acm_random.h"
+#include "aom_ports/aom_timer.h"
+#include "av1/encoder/ransac.h"
+
+namespace {
+
+using ::libaom_test::ACMRandom;
+
+static const int kNumPoints = 400;
+static const int kNumInliers = 300;
+static const int kWidth = 352;
+static const int kHeight = 288;
+
+struct RansacParam {
+  TransformationType type;
+  RansacFunc ransac;
+  const char *name;
+  // The motion of the inliers.
+  double params[8];
+};
+
+// Projects the point (x, y) with the model, as arranged by the fits.
+static void Project(const double *m, double x, double y, double *px,
+                    double *py) {
+  const double z = m[6] * x + m[7] * y + 1;
+  *px = (m[2] * x + m[3] * y + m[0]) / z;
+  *py = (m[4] * x + m[5] * y + m[1]) / z;
+}
+
+class RansacTest : public ::testing::TestWithParam<RansacParam> {
+ public:
+  virtual void SetUp() {
+    param_ = GetParam();
+    rnd_.Reset(ACMRandom::DeterministicSeed());
+    GeneratePoints();
+  }
+
+ protected:
+  // The inliers are moved by the model plus a little noise, and the
+  // outliers are matched to random points, with the two mixed together.
+  void GeneratePoints() {
+    for (int i = 0; i < kNumPoints; ++i) {
+      double *const p = &points_[i * 4];
+      p[0] = rnd_(kWidth);
+      p[1] = rnd_(kHeight);
+      if (i % 4 != 3) {
+        Project(param_.params, p[0], p[1], &p[2], &p[3]);
+        p[2] += (rnd_(41) - 20) / 100.0;
+        p[3] += (rnd_(41) - 20) / 100.0;
+      } else {
+        p[2] = rnd_(kWidth);
+        p[3] = rnd_(kHeight);
+      }
+    }
+  }
+
+  // Runs a fit with the given batch size, the way the encoder does.
+  int RunFit(int max_batch, int *num_inliers, int *inlier_mask,
+             double *params) {
+    RansacFit *const fit =
+        ransac_fit_alloc(param_.type, points_, kNumPoints, max_batch);
+    EXPECT_TRUE(fit != NULL);
+    if (fit == NULL) return 1;
+    int n;
+    while ((n = ransac_fit_next_batch(fit)) > 0) {
+      for (int t = n - 1; t >= 0; --t) ransac_fit_score(fit, t);
+      ransac_fit_update(fit);
+    }
+    const int result =
+        ransac_fit_finish(fit, num_inliers, inlier_mask, params);
+    ransac_fit_free(fit);
+    return result;
+  }
+
+  RansacParam param_;
+  ACMRandom rnd_;
+  double points_[4 * kNumPoints];
+};
+
+TEST_P(RansacTest, FindsModel) {
+  int num_inliers;
+  int inlier_mask[kNumPoints];
+  double params[8];
+  ASSERT_EQ(0, param_.ransac(points_, kNumPoints, &num_inliers, inlier_mask,
+                             params));
+  EXPECT_GE(num_inliers, kNumInliers * 9 / 10);
+  EXPECT_LE(num_inliers, kNumInliers + 5);
+  // The model is checked where it is used, at the corners of the frame.
+  for (int i = 0; i < 4; ++i) {
+    const double x = (i & 1) * kWidth, y = (i >> 1) * kHeight;
+    double ref_x, ref_y, x1, y1;
+    Project(param_.params, x, y, &ref_x, &ref_y);
+    Project(params, x, y, &x1, &y1);
+    EXPECT_NEAR(ref_x, x1, 0.5) << "at corner " << i;
+    EXPECT_NEAR(ref_y, y1, 0.5) << "at corner " << i;
+  }
+}
+
+TEST_P(RansacTest, BatchSizeDoesNotChangeModel) {
+  int ref_num_inliers;
+  int ref_mask[kNumPoints];
+  double ref_params[8];
+  ASSERT_EQ(0, param_.ransac(points_, kNumPoints, &ref_num_inliers, ref_mask,
+                             ref_params));
+  for (int max_batch = 1; max_batch <= 17; max_batch += 4) {
+    int num_inliers;
+    int mask[kNumPoints];
+    double params[8];
+    ASSERT_EQ(0, RunFit(max_batch, &num_inliers, mask, params));
+    EXPECT_EQ(ref_num_inliers, num_inliers) << "with batch " << max_batch;
+    EXPECT_EQ(0, memcmp(ref_mask, mask, sizeof(mask)))
+        << "with batch " << max_batch;
+    EXPECT_EQ(0, memcmp(ref_params, params, sizeof(params)))
+        << "with batch " << max_batch;
+  }
+}
+
+TEST_P(RansacTest, TooFewPoints) {
+  int num_inliers = -1;
+  int inlier_mask[kNumPoints];
+  double params[8];
+  EXPECT_EQ(1, param_.ransac(points_, 4, &num_inliers, inlier_mask, params));
+  EXPECT_EQ(0, num_inliers);
+}
+
+TEST_P(RansacTest, DISABLED_Speed) {
+  const int kNumFits = 200;
+  int num_inliers;
+  int inlier_mask[kNumPoints];
+  double params[8];
+  aom_usec_timer timer;
+  aom_usec_timer_start(&timer);
+  for (int i = 0; i < kNumFits; ++i) {
+    param_.ransac(points_, kNumPoints, &num_inliers, inlier_mask, params);
+  }
+  aom_usec_timer_mark(&timer);
+  const int elapsed_time = static_cast<int>(aom_usec_timer_elapsed(&timer));
+  printf("%s: %d fits of %d points in %d us, %.1f fits/s\n", param_.name,
+         kNumFits, kNumPoints, elapsed_time,
+         kNumFits * 1e6 / AOMMAX(elapsed_time, 1));
+}
+
+const RansacParam kRansacParams[] = {
+  { TRANSLATION,
+    ransac_translation,
+    "translation",
+    { 5.3, -2.7, 1, 0, 0, 1, 0, 0 } },
+  { ROTZOOM,
+    ransac_rotzoom,
+    "rotzoom",
+    { 3.1, -1.2, 1.02, 0.03, -0.03, 1.02, 0, 0 } },
+  { AFFINE,
+    ransac_affine,
+    "affine",
+    { 3.1, -1.2, 1.02, 0.03, -0.01, 0.98, 0, 0 } },
+  { HOMOGRAPHY,
+    ransac_homography,
+    "homography",
+    { 3.1, -1.2, 1.02, 0.03, -0.01, 0.98, 1e-5, -2e-5 } },
+};
+
+INSTANTIATE_TEST_CASE_P(C, RansacTest, ::testing::ValuesIn(kRansacParams));
+
+}  // namespace
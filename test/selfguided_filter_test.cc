@@ -0,0 +1,175 @@
+/*
+ * Copyright (c) 2016, Alliance for Open Media. All rights reserved
+ *
+ * This source code is subject to the terms of the BSD 2 Clause License and
+ * the Alliance for Open Media Patent License 1.0. If the BSD 2 Clause License
+ * was not distributed with this source code in the LICENSE file, you can
+ * obtain it at www.aomedia.org/license/software. If the Alliance for Open
+ * Media Patent License 1.0 was not distributed with this source code in the
+ * PATENTS file, you can obtain it at www.aomedia.org/license/patent.
+ */
+
+#include <stdio.h>
+#include <string.h>
+
+#include "third_party/googletest/src/include/gtest/gtest.h"
+
+#include "./aom_config.h"
+#include "./av1_rtcd.h"
+#include "aom_ports/aom_timer.h"
+#include "av1/common/restoration.h"
+#include "test/acm_random.h"
+#include "test/clear_system_state.h"
+#include "test/function_equivalence_test.h"
+#include "test/register_state_check.h"
+#include "test/util.h"
+
+using libaom_test::FunctionEquivalenceTest;
+
+namespace {
+
+typedef void (*SgrFunc)(const int32_t *dgd, int width, int height, int stride,
+                        int bit_depth, int r, int eps, const uint32_t *sum,
+                        const uint32_t *sumsq, int sum_stride, int32_t *dst,
+                        int dst_stride, int32_t *tmpbuf);
+typedef libaom_test::FuncParam<SgrFunc> TestFuncs;
+
+// Largest tile the self-guided filter is applied to
+const int kMaxSize = RESTORATION_TILESIZE_BIG * 3 / 2 - 1;
+const int kStride = kMaxSize + 16;
+const int kBufSize = kMaxSize * kStride;
+
+class SelfguidedFilterTest : public FunctionEquivalenceTest<SgrFunc> {
+ public:
+  static const int kIterations = 100;
+
+  virtual void SetUp() {
+    FunctionEquivalenceTest<SgrFunc>::SetUp();
+    dgd_ = new int32_t[kBufSize];
+    dst_ref_ = new int32_t[kBufSize];
+    dst_tst_ = new int32_t[kBufSize];
+    sum_ = new uint32_t[SGRPROJ_INTIMG_SIZE];
+    sumsq_ = new uint32_t[SGRPROJ_INTIMG_SIZE];
+    tmpbuf_ = new int32_t[SGRPROJ_SGRBUF_SIZE / sizeof(int32_t)];
+  }
+
+  virtual void TearDown() {
+    delete[] dgd_;
+    delete[] dst_ref_;
+    delete[] dst_tst_;
+    delete[] sum_;
+    delete[] sumsq_;
+    delete[] tmpbuf_;
+    FunctionEquivalenceTest<SgrFunc>::TearDown();
+  }
+
+  void Execute(SgrFunc func, int32_t *dst) {
+    func(dgd_, w_, h_, kStride, params_.bit_depth, r_, eps_, sum_, sumsq_,
+         w_ + 2 * SGRPROJ_BORDER + 1, dst, kStride, tmpbuf_);
+  }
+
+  void Prepare(int max_value, bool extreme) {
+    const sgr_params_type *p = &sgr_params[rng_(SGRPROJ_PARAMS)];
+    const bool first = rng_(2) != 0;
+    r_ = first ? p->r1 : p->r2;
+    eps_ = first ? p->e1 : p->e2;
+    for (int i = 0; i < kBufSize; ++i) {
+      if (extreme)
+        dgd_[i] = rng_(2) ? max_value : 0;
+      else
+        dgd_[i] = rng_(max_value + 1);
+      dst_ref_[i] = dst_tst_[i] = 0;
+    }
+    av1_integral_images(dgd_, w_, h_, kStride, sum_, sumsq_,
+                        w_ + 2 * SGRPROJ_BORDER + 1);
+  }
+
+  void Common(int max_value, bool extreme) {
+    w_ = rng_(2) ? rng_(kMaxSize - 1) + 2 : rng_(32) + 2;
+    h_ = rng_(2) ? rng_(kMaxSize - 1) + 2 : rng_(32) + 2;
+    Prepare(max_value, extreme);
+
+    Execute(params_.ref_func, dst_ref_);
+    ASM_REGISTER_STATE_CHECK(Execute(params_.tst_func, dst_tst_));
+
+    for (int i = 0; i < kBufSize; ++i) {
+      ASSERT_EQ(dst_ref_[i], dst_tst_[i]) << "w: " << w_ << " h: " << h_
+                                          << " r: " << r_ << " at "
+                                          << (i % kStride) << ","
+                                          << (i / kStride);
+    }
+  }
+
+  void Speed(int max_value) {
+    const int kSpeedIterations = 50;
+    w_ = h_ = kMaxSize;
+    Prepare(max_value, false);
+
+    aom_usec_timer ref_timer, tst_timer;
+    aom_usec_timer_start(&ref_timer);
+    for (int i = 0; i < kSpeedIterations; ++i)
+      Execute(params_.ref_func, dst_ref_);
+    aom_usec_timer_mark(&ref_timer);
+    const int ref_time = static_cast<int>(aom_usec_timer_elapsed(&ref_timer));
+
+    aom_usec_timer_start(&tst_timer);
+    for (int i = 0; i < kSpeedIterations; ++i)
+      Execute(params_.tst_func, dst_tst_);
+    aom_usec_timer_mark(&tst_timer);
+    const int tst_time = static_cast<int>(aom_usec_timer_elapsed(&tst_timer));
+
+    libaom_test::ClearSystemState();
+    printf("%dx%d bd %d r %d: ref %5d ms, tst %5d ms (%4.2fx)\n", w_, h_,
+           params_.bit_depth, r_, ref_time / 1000, tst_time / 1000,
+           static_cast<double>(ref_time) / tst_time);
+    EXPECT_EQ(0, memcmp(dst_ref_, dst_tst_, sizeof(*dst_ref_) * kBufSize));
+  }
+
+  int32_t *dgd_;
+  int32_t *dst_ref_;
+  int32_t *dst_tst_;
+  uint32_t *sum_;
+  uint32_t *sumsq_;
+  int32_t *tmpbuf_;
+  int w_;
+  int h_;
+  int r_;
+  int eps_;
+};
+
+TEST_P(SelfguidedFilterTest, RandomValues) {
+  for (int iter = 0; iter < kIterations && !HasFatalFailure(); ++iter)
+    Common((1 << params_.bit_depth) - 1, false);
+}
+
+TEST_P(SelfguidedFilterTest, ExtremeValues) {
+  for (int iter = 0; iter < kIterations && !HasFatalFailure(); ++iter)
+    Common((1 << params_.bit_depth) - 1, true);
+}
+
+TEST_P(SelfguidedFilterTest, DISABLED_Speed) {
+  Speed((1 << params_.bit_depth) - 1);
+}
+
+#if HAVE_SSE4_1
+INSTANTIATE_TEST_CASE_P(
+    SSE4_1, SelfguidedFilterTest,
+    ::testing::Values(TestFuncs(av1_selfguided_restoration_c,
+                                av1_selfguided_restoration_sse4_1, 8),
+                      TestFuncs(av1_selfguided_restoration_c,
+                                av1_selfguided_restoration_sse4_1, 10),
+                      TestFuncs(av1_selfguided_restoration_c,
+                                av1_selfguided_restoration_sse4_1, 12)));
+#endif  // HAVE_SSE4_1
+
+#if HAVE_AVX2
+INSTANTIATE_TEST_CASE_P(
+    AVX2, SelfguidedFilterTest,
+    ::testing::Values(TestFuncs(av1_selfguided_restoration_c,
+                                av1_selfguided_restoration_avx2, 8),
+                      TestFuncs(av1_selfguided_restoration_c,
+                                av1_selfguided_restoration_avx2, 10),
+                      TestFuncs(av1_selfguided_restoration_c,
+                                av1_selfguided_restoration_avx2, 12)));
+#endif  // HAVE_AVX2
+}  // namespace
@@ -0,0 +1,223 @@
+/*
+ * Copyright (c) 2016, Alliance for Open Media. All rights reserved
+ *
+ * This source code is subject to the terms of the BSD 2 Clause License and
+ * the Alliance for Open Media Patent License 1.0. If the BSD 2 Clause License
+ * was not distributed with this source code in the LICENSE file, you can
+ * obtain it at www.aomedia.org/license/software. If the Alliance for Open
+ * Media Patent License 1.0 was not distributed with this source code in the
+ * PATENTS file, you can obtain it at www.aomedia.org/license/patent.
+ */
+
+#include <stdio.h>
+#include <string.h>
+
+#include "third_party/googletest/src/include/gtest/gtest.h"
+
+#include "./aom_config.h"
+#include "./av1_rtcd.h"
+#include "aom_dsp/aom_dsp_common.h"
+#include "aom_ports/aom_timer.h"
+#include "aom_ports/mem.h"
+#include "test/acm_random.h"
+#include "test/clear_system_state.h"
+#include "test/function_equivalence_test.h"
+#include "test/register_state_check.h"
+
+using libaom_test::FunctionEquivalenceTest;
+
+namespace {
+
+// The source block is read with a stride, as from a frame buffer, and the
+// predictor is packed. The sizes cover the luma and chroma blocks of the
+// temporal filter, along with sizes the kernels hand back to C.
+const int kMaxSize = 16;
+const int kStride = 48;
+const int kMaxStrength = 6;
+const int kSizes[][2] = { { 16, 16 }, { 8, 8 }, { 8, 16 }, { 16, 8 },
+                          { 16, 2 },  { 4, 4 }, { 16, 1 } };
+
+typedef void (*TemporalFilterFunc)(uint8_t *frame1, unsigned int stride,
+                                   uint8_t *frame2, unsigned int block_width,
+                                   unsigned int block_height, int strength,
+                                   int filter_weight, unsigned int *accumulator,
+                                   uint16_t *count);
+typedef libaom_test::FuncParam<TemporalFilterFunc> TestFuncs;
+
+template <typename T>
+class TemporalFilterTest : public FunctionEquivalenceTest<TemporalFilterFunc> {
+ public:
+  static const int kIterations = 1000;
+
+  virtual ~TemporalFilterTest() {}
+
+  virtual uint8_t *Buffer(T *buf) = 0;
+
+  int MaxValue() const { return (1 << params_.bit_depth) - 1; }
+
+  int Strength() {
+    return rng_(kMaxStrength + 1) + 2 * (params_.bit_depth - 8);
+  }
+
+  void Execute(TemporalFilterFunc func, int width, int height, int strength,
+               int weight, unsigned int *accumulator, uint16_t *count) {
+    func(Buffer(src_), kStride, Buffer(pred_), width, height, strength, weight,
+         accumulator, count);
+  }
+
+  void Common(bool extreme) {
+    const int max_value = MaxValue();
+    const int size = rng_(sizeof(kSizes) / sizeof(kSizes[0]));
+    const int width = kSizes[size][0], height = kSizes[size][1];
+    const int strength = Strength();
+    const int weight = rng_(3);
+    for (int i = 0; i < kMaxSize * kStride; ++i) {
+      src_[i] = extreme ? (rng_(2) ? max_value : 0) : rng_(max_value + 1);
+    }
+    for (int i = 0; i < kMaxSize * kMaxSize; ++i) {
+      const int row = i / width, col = i % width;
+      if (extreme) {
+        pred_[i] = rng_(2) ? max_value : 0;
+      } else if (row < height && rng_(2)) {
+        // Close to the source, so that not all of the weights are zero.
+        pred_[i] = clamp(src_[row * kStride + col] + rng_(9) - 4, 0, max_value);
+      } else {
+        pred_[i] = rng_(max_value + 1);
+      }
+      acc_ref_[i] = acc_tst_[i] = rng_.Rand16();
+      count_ref_[i] = count_tst_[i] = rng_.Rand8();
+    }
+
+    Execute(params_.ref_func, width, height, strength, weight, acc_ref_,
+            count_ref_);
+    ASM_REGISTER_STATE_CHECK(Execute(params_.tst_func, width, height,
+                                     strength, weight, acc_tst_, count_tst_));
+
+    for (int i = 0; i < kMaxSize * kMaxSize; ++i) {
+      ASSERT_EQ(count_ref_[i], count_tst_[i])
+          << width << "x" << height << " strength " << strength << " weight "
+          << weight << " at " << i;
+      ASSERT_EQ(acc_ref_[i], acc_tst_[i])
+          << width << "x" << height << " strength " << strength << " weight "
+          << weight << " at " << i;
+    }
+  }
+
+  void Speed() {
+    const int kSpeedIterations = 1000000;
+    const int max_value = MaxValue();
+    const int strength = kMaxStrength + 2 * (params_.bit_depth - 8);
+    for (int i = 0; i < kMaxSize * kStride; ++i) src_[i] = rng_(max_value + 1);
+    for (int i = 0; i < kMaxSize * kMaxSize; ++i) {
+      pred_[i] = rng_(max_value + 1);
+      acc_ref_[i] = acc_tst_[i] = 0;
+      count_ref_[i] = count_tst_[i] = 0;
+    }
+
+    aom_usec_timer ref_timer, tst_timer;
+    aom_usec_timer_start(&ref_timer);
+    for (int i = 0; i < kSpeedIterations; ++i) {
+      Execute(params_.ref_func, kMaxSize, kMaxSize, strength, 1, acc_ref_,
+              count_ref_);
+    }
+    aom_usec_timer_mark(&ref_timer);
+    const int ref_time = static_cast<int>(aom_usec_timer_elapsed(&ref_timer));
+
+    aom_usec_timer_start(&tst_timer);
+    for (int i = 0; i < kSpeedIterations; ++i) {
+      Execute(params_.tst_func, kMaxSize, kMaxSize, strength, 1, acc_tst_,
+              count_tst_);
+    }
+    aom_usec_timer_mark(&tst_timer);
+    const int tst_time = static_cast<int>(aom_usec_timer_elapsed(&tst_timer));
+
+    libaom_test::ClearSystemState();
+    printf("16x16 bd %d: ref %5d ms, tst %5d ms (%4.2fx)\n", params_.bit_depth,
+           ref_time / 1000, tst_time / 1000,
+           static_cast<double>(ref_time) / tst_time);
+    EXPECT_EQ(0, memcmp(acc_ref_, acc_tst_, sizeof(acc_ref_)));
+    EXPECT_EQ(0, memcmp(count_ref_, count_tst_, sizeof(count_ref_)));
+  }
+
+  T src_[kMaxSize * kStride];
+  T pred_[kMaxSize * kMaxSize];
+  unsigned int acc_ref_[kMaxSize * kMaxSize];
+  unsigned int acc_tst_[kMaxSize * kMaxSize];
+  uint16_t count_ref_[kMaxSize * kMaxSize];
+  uint16_t count_tst_[kMaxSize * kMaxSize];
+};
+
+//////////////////////////////////////////////////////////////////////////////
+// 8 bit version
+//////////////////////////////////////////////////////////////////////////////
+
+class TemporalFilterTest8B : public TemporalFilterTest<uint8_t> {
+ protected:
+  uint8_t *Buffer(uint8_t *buf) { return buf; }
+};
+
+TEST_P(TemporalFilterTest8B, RandomValues) {
+  for (int iter = 0; iter < kIterations && !HasFatalFailure(); ++iter)
+    Common(false);
+}
+
+TEST_P(TemporalFilterTest8B, ExtremeValues) {
+  for (int iter = 0; iter < kIterations && !HasFatalFailure(); ++iter)
+    Common(true);
+}
+
+TEST_P(TemporalFilterTest8B, DISABLED_Speed) { Speed(); }
+
+#if HAVE_AVX2
+INSTANTIATE_TEST_CASE_P(
+    AVX2, TemporalFilterTest8B,
+    ::testing::Values(TestFuncs(av1_temporal_filter_apply_c,
+                                av1_temporal_filter_apply_avx2, 8)));
+#endif  // HAVE_AVX2
+
+#if CONFIG_AOM_HIGHBITDEPTH
+//////////////////////////////////////////////////////////////////////////////
+// High bit-depth version
+//////////////////////////////////////////////////////////////////////////////
+
+class TemporalFilterTestHBD : public TemporalFilterTest<uint16_t> {
+ protected:
+  uint8_t *Buffer(uint16_t *buf) { return CONVERT_TO_BYTEPTR(buf); }
+};
+
+TEST_P(TemporalFilterTestHBD, RandomValues) {
+  for (int iter = 0; iter < kIterations && !HasFatalFailure(); ++iter)
+    Common(false);
+}
+
+TEST_P(TemporalFilterTestHBD, ExtremeValues) {
+  for (int iter = 0; iter < kIterations && !HasFatalFailure(); ++iter)
+    Common(true);
+}
+
+TEST_P(TemporalFilterTestHBD, DISABLED_Speed) { Speed(); }
+
+#if HAVE_SSE4_1
+INSTANTIATE_TEST_CASE_P(
+    SSE4_1, TemporalFilterTestHBD,
+    ::testing::Values(
+        TestFuncs(av1_highbd_temporal_filter_apply_c,
+                  av1_highbd_temporal_filter_apply_sse4_1, 8),
+        TestFuncs(av1_highbd_temporal_filter_apply_c,
+                  av1_highbd_temporal_filter_apply_sse4_1, 10),
+        TestFuncs(av1_highbd_temporal_filter_apply_c,
+                  av1_highbd_temporal_filter_apply_sse4_1, 12)));
+#endif  // HAVE_SSE4_1
+
+#if HAVE_AVX2
+INSTANTIATE_TEST_CASE_P(
+    AVX2, TemporalFilterTestHBD,
+    ::testing::Values(TestFuncs(av1_highbd_temporal_filter_apply_c,
+                                av1_highbd_temporal_filter_apply_avx2, 8),
+                      TestFuncs(av1_highbd_temporal_filter_apply_c,
+                                av1_highbd_temporal_filter_apply_avx2, 10),
+                      TestFuncs(av1_highbd_temporal_filter_apply_c,
+                                av1_highbd_temporal_filter_apply_avx2, 12)));
+#endif  // HAVE_AVX2
+#endif  // CONFIG_AOM_HIGHBITDEPTH
+}  // namespace
@@ -37,6 +37,8 @@ LIBAOM_TEST_SRCS-$(CONFIG_AV1_ENCODER) += cpu_speed_test.cc
 LIBAOM_TEST_SRCS-$(CONFIG_AV1_ENCODER) += frame_size_tests.cc
 LIBAOM_TEST_SRCS-$(CONFIG_AV1_ENCODER) += lossless_test.cc
 LIBAOM_TEST_SRCS-$(CONFIG_AV1_ENCODER) += ethread_test.cc
+ifeq ($(CONFIG_LOOP_RESTORATION),yes)
+endif
 
 LIBAOM_TEST_SRCS-yes                   += decode_test_driver.cc
 LIBAOM_TEST_SRCS-yes                   += decode_test_driver.h
@@ -101,6 +103,7 @@ LIBAOM_TEST_SRCS-yes                   += idct8x8_test.cc
 LIBAOM_TEST_SRCS-yes                   += partial_idct_test.cc
 LIBAOM_TEST_SRCS-yes                   += superframe_test.cc
 LIBAOM_TEST_SRCS-yes                   += tile_independence_test.cc
+LIBAOM_TEST_SRCS-yes                   += decode_thread_test.cc
 ifeq ($(CONFIG_ANS),yes)
 LIBAOM_TEST_SRCS-yes                   += ans_test.cc
 else
@@ -117,8 +120,17 @@ LIBAOM_TEST_SRCS-$(CONFIG_ADAPT_SCAN)  += scan_test.cc
 LIBAOM_TEST_SRCS-yes                   += convolve_test.cc
 LIBAOM_TEST_SRCS-yes                   += lpf_8_test.cc
 LIBAOM_TEST_SRCS-$(CONFIG_CLPF)        += clpf_test.cc
+ifeq ($(CONFIG_LOOP_RESTORATION),yes)
+LIBAOM_TEST_SRCS-$(HAVE_SSE4_1)        += selfguided_filter_test.cc
+LIBAOM_TEST_SRCS-$(HAVE_SSE4_1)        += wiener_filter_test.cc
+endif
+ifeq (yes,$(filter $(CONFIG_GLOBAL_MOTION) $(CONFIG_WARPED_MOTION),yes))
+LIBAOM_TEST_SRCS-$(HAVE_SSE4_1)        += warp_filter_test.cc
+endif
 LIBAOM_TEST_SRCS-yes                   += intrapred_test.cc
 #LIBAOM_TEST_SRCS-$(CONFIG_AV1_DECODER) += av1_thread_test.cc
+LIBAOM_TEST_SRCS-yes                   += job_queue_test.cc
+LIBAOM_TEST_SRCS-yes                   += thread_pool_test.cc
 LIBAOM_TEST_SRCS-$(CONFIG_AV1_ENCODER) += dct16x16_test.cc
 LIBAOM_TEST_SRCS-$(CONFIG_AV1_ENCODER) += dct32x32_test.cc
 LIBAOM_TEST_SRCS-$(CONFIG_AV1_ENCODER) += fdct4x4_test.cc
@@ -133,6 +145,8 @@ LIBAOM_TEST_SRCS-$(CONFIG_AV1_ENCODER) += subtract_test.cc
 ifeq ($(CONFIG_AV1_ENCODER)$(CONFIG_AV1_TEMPORAL_DENOISING),yesyes)
 #LIBAOM_TEST_SRCS-$(HAVE_SSE2) += denoiser_sse2_test.cc
 endif
+LIBAOM_TEST_SRCS-$(CONFIG_AV1_ENCODER) += frame_pyramid_test.cc
+LIBAOM_TEST_SRCS-$(CONFIG_AV1_ENCODER) += picklpf_test.cc
 LIBAOM_TEST_SRCS-$(CONFIG_AV1_ENCODER) += arf_freq_test.cc
 
 
@@ -156,6 +170,13 @@ LIBAOM_TEST_SRCS-$(CONFIG_AV1_ENCODER) += sum_squares_test.cc
 LIBAOM_TEST_SRCS-$(CONFIG_AV1_ENCODER) += subtract_test.cc
 LIBAOM_TEST_SRCS-$(CONFIG_AV1_ENCODER) += blend_a64_mask_test.cc
 LIBAOM_TEST_SRCS-$(CONFIG_AV1_ENCODER) += blend_a64_mask_1d_test.cc
+LIBAOM_TEST_SRCS-$(CONFIG_AV1_ENCODER) += temporal_filter_test.cc
+ifeq ($(CONFIG_DERING),yes)
+LIBAOM_TEST_SRCS-$(CONFIG_AV1_ENCODER) += dering_sse_test.cc
+endif
+ifeq ($(CONFIG_LOOP_RESTORATION),yes)
+LIBAOM_TEST_SRCS-$(CONFIG_AV1_ENCODER) += compute_stats_test.cc
+endif
 
 ifeq ($(CONFIG_EXT_INTER),yes)
 LIBAOM_TEST_SRCS-$(HAVE_SSSE3) += masked_variance_test.cc
@@ -163,6 +184,11 @@ LIBAOM_TEST_SRCS-$(HAVE_SSSE3) += masked_sad_test.cc
 LIBAOM_TEST_SRCS-$(CONFIG_AV1_ENCODER) += av1_wedge_utils_test.cc
 endif
 
+ifeq ($(CONFIG_GLOBAL_MOTION),yes)
+LIBAOM_TEST_SRCS-$(CONFIG_AV1_ENCODER) += corner_match_test.cc
+LIBAOM_TEST_SRCS-$(CONFIG_AV1_ENCODER) += ransac_test.cc
+endif
+
 ifeq ($(CONFIG_FILTER_INTRA),yes)
 LIBAOM_TEST_SRCS-$(HAVE_SSE4_1) += filterintra_predictors_test.cc
 endif
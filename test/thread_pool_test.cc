@@ -0,0 +1,147 @@
+/*
+ * Copyright (c) 2016, Alliance for Open Media. All rights reserved
+ *
+ * This source code is subject to the terms of the BSD 2 Clause License and
+ * the Alliance for Open Media Patent License 1.0. If the BSD 2 Clause License
+ * was not distributed with this source code in the LICENSE file, you can
+ * obtain it at www.aomedia.org/license/software. If the Alliance for Open
+ * Media Patent License 1.0 was not distributed with this source code in the
+ * PATENTS file, you can obtain it at www.aomedia.org/license/patent.
+ */
+
+#include "third_party/googletest/src/include/gtest/gtest.h"
+
+#include "./aom_config.h"
+#include "aom_util/aom_job_queue.h"
+#include "aom_util/aom_thread_pool.h"
+
+namespace {
+
+const int kNumOwners = 3;
+const int kWorkersPerOwner = 4;
+const int kNumRows = 40;
+
+// A wavefront over kNumRows rows: a row can only be done once the row above
+// it has been, like the loop filter rows.
+struct Wavefront {
+  AOMJobQueue queue;
+  volatile int rows_done;
+#if CONFIG_MULTITHREAD
+  pthread_mutex_t mutex;
+  pthread_cond_t cond;
+#endif
+};
+
+struct RowWorkerData {
+  Wavefront *wavefront;
+  int thread;
+  int rows_run;
+};
+
+int RowWorkerHook(void *arg1, void *arg2) {
+  RowWorkerData *const data = reinterpret_cast<RowWorkerData *>(arg1);
+  Wavefront *const wf = data->wavefront;
+  int row;
+  (void)arg2;
+  while ((row = aom_job_queue_pop(&wf->queue, data->thread)) >= 0) {
+#if CONFIG_MULTITHREAD
+    pthread_mutex_lock(&wf->mutex);
+    while (wf->rows_done < row) pthread_cond_wait(&wf->cond, &wf->mutex);
+    wf->rows_done = row + 1;
+    pthread_cond_broadcast(&wf->cond);
+    pthread_mutex_unlock(&wf->mutex);
+#else
+    if (wf->rows_done != row) return 0;
+    wf->rows_done = row + 1;
+#endif
+    ++data->rows_run;
+  }
+  return 1;
+}
+
+class ThreadPoolTest : public ::testing::TestWithParam<int> {
+ protected:
+  virtual void SetUp() {
+    pool_ = aom_thread_pool_create(GetParam());
+    ASSERT_TRUE(pool_ != NULL);
+    for (int i = 0; i < kNumOwners; ++i) {
+      Wavefront *const wf = &wavefronts_[i];
+      ASSERT_TRUE(aom_job_queue_alloc(&wf->queue, kWorkersPerOwner, kNumRows));
+#if CONFIG_MULTITHREAD
+      ASSERT_EQ(0, pthread_mutex_init(&wf->mutex, NULL));
+      ASSERT_EQ(0, pthread_cond_init(&wf->cond, NULL));
+#endif
+    }
+  }
+
+  virtual void TearDown() {
+    aom_thread_pool_destroy(pool_);
+    for (int i = 0; i < kNumOwners; ++i) {
+      Wavefront *const wf = &wavefronts_[i];
+      aom_job_queue_dealloc(&wf->queue);
+#if CONFIG_MULTITHREAD
+      pthread_cond_destroy(&wf->cond);
+      pthread_mutex_destroy(&wf->mutex);
+#endif
+    }
+  }
+
+  // Launches the workers of every owner on the pool, each owner with its
+  // rows in an ordered queue, and checks that every row is run once.
+  void RunWavefronts() {
+    const AVxWorkerInterface *const winterface = aom_get_worker_interface();
+    AVxWorker workers[kNumOwners][kWorkersPerOwner];
+    RowWorkerData data[kNumOwners][kWorkersPerOwner];
+
+    for (int owner = 0; owner < kNumOwners; ++owner) {
+      Wavefront *const wf = &wavefronts_[owner];
+      wf->rows_done = 0;
+      aom_job_queue_reset(&wf->queue, kWorkersPerOwner, 1);
+      aom_job_queue_push_range(&wf->queue, kNumRows);
+      for (int i = 0; i < kWorkersPerOwner; ++i) {
+        AVxWorker *const worker = &workers[owner][i];
+        winterface->init(worker);
+        worker->pool = pool_;
+        worker->pool_owner = wf;
+        ASSERT_NE(winterface->reset(worker), 0);
+        data[owner][i].wavefront = wf;
+        data[owner][i].thread = i;
+        data[owner][i].rows_run = 0;
+        worker->hook = RowWorkerHook;
+        worker->data1 = &data[owner][i];
+        worker->data2 = NULL;
+        winterface->launch(worker);
+      }
+    }
+
+    for (int owner = 0; owner < kNumOwners; ++owner) {
+      int rows_run = 0;
+      for (int i = 0; i < kWorkersPerOwner; ++i) {
+        EXPECT_NE(winterface->sync(&workers[owner][i]), 0);
+        winterface->end(&workers[owner][i]);
+        rows_run += data[owner][i].rows_run;
+      }
+      aom_job_queue_finish(&wavefronts_[owner].queue);
+      EXPECT_EQ(kNumRows, wavefronts_[owner].rows_done) << "owner " << owner;
+      EXPECT_EQ(kNumRows, rows_run) << "owner " << owner;
+    }
+  }
+
+  aom_thread_pool_t *pool_;
+  Wavefront wavefronts_[kNumOwners];
+};
+
+// There are more workers than pool threads, so the rows of each wavefront
+// have to make progress with only some of its workers running.
+TEST_P(ThreadPoolTest, RunsWavefronts) {
+  for (int run = 0; run < 3; ++run) RunWavefronts();
+}
+
+TEST(ThreadPoolCreateTest, NeedsAThread) {
+  EXPECT_TRUE(aom_thread_pool_create(0) == NULL);
+  aom_thread_pool_destroy(NULL);
+}
+
+INSTANTIATE_TEST_CASE_P(AOM, ThreadPoolTest, ::testing::Values(1, 2, 5));
+
+}  // namespace
@@ -0,0 +1,209 @@
+/*
+ * Copyright (c) 2016, Alliance for Open Media. All rights reserved
+ *
+ * This source code is subject to the terms of the BSD 2 Clause License and
+ * the Alliance for Open Media Patent License 1.0. If the BSD 2 Clause License
+ * was not distributed with this source code in the LICENSE file, you can
+ * obtain it at www.aomedia.org/license/software. If the Alliance for Open
+ * Media Patent License 1.0 was not distributed with this source code in the
+ * PATENTS file, you can obtain it at www.aomedia.org/license/patent.
+ */
+
+#include <stdio.h>
+#include <string.h>
+
+#include "third_party/googletest/src/include/gtest/gtest.h"
+
+#include "./aom_config.h"
+#include "./av1_rtcd.h"
+#include "aom_ports/aom_timer.h"
+#include "aom_ports/mem.h"
+#include "av1/common/warped_motion.h"
+#include "test/acm_random.h"
+#include "test/clear_system_state.h"
+#include "test/function_equivalence_test.h"
+#include "test/register_state_check.h"
+
+using libaom_test::FunctionEquivalenceTest;
+
+namespace {
+
+// Source positions are drawn so that the whole filter window lies inside the
+// plane, as the callers guarantee. The kernels may load a few pixels past the
+// right of the window, which land in the border as they would in a frame
+// buffer.
+const int kBorder = 16;
+const int kWidth = 64;
+const int kHeight = 64;
+const int kStride = kWidth + 2 * kBorder;
+const int kBufSize = (kHeight + 2 * kBorder) * kStride;
+const int kOffset = kBorder * kStride + kBorder;
+const int kMaxPixels = 64;
+
+template <typename F, typename T>
+class WarpFilterTest : public FunctionEquivalenceTest<F> {
+ public:
+  static const int kIterations = 1000;
+
+  virtual ~WarpFilterTest() {}
+
+  virtual void Execute(F func, T *pred) = 0;
+
+  int RandomPos(int size) {
+    const int lo = (WARPEDPIXEL_FILTER_TAPS / 2 - 1) << WARPEDPIXEL_PREC_BITS;
+    const int hi = (size - WARPEDPIXEL_FILTER_TAPS / 2)
+                   << WARPEDPIXEL_PREC_BITS;
+    return lo + this->rng_(hi - lo);
+  }
+
+  void Common(int max_value, bool extreme) {
+    n_ = this->rng_(kMaxPixels) + 1;
+    for (int i = 0; i < n_; ++i) {
+      pts_[2 * i] = RandomPos(kWidth);
+      pts_[2 * i + 1] = RandomPos(kHeight);
+    }
+    for (int i = 0; i < kBufSize; ++i) {
+      if (extreme)
+        ref_[i] = this->rng_(2) ? max_value : 0;
+      else
+        ref_[i] = this->rng_(max_value + 1);
+    }
+    memset(pred_ref_, 0, sizeof(pred_ref_));
+    memset(pred_tst_, 0, sizeof(pred_tst_));
+
+    Execute(this->params_.ref_func, pred_ref_);
+    ASM_REGISTER_STATE_CHECK(Execute(this->params_.tst_func, pred_tst_));
+
+    for (int i = 0; i < kMaxPixels; ++i) {
+      ASSERT_EQ(pred_ref_[i], pred_tst_[i])
+          << "n: " << n_ << " at " << i << " pos " << pts_[2 * i] << ","
+          << pts_[2 * i + 1];
+    }
+  }
+
+  void Speed(int max_value) {
+    const int kSpeedIterations = 200000;
+    n_ = kMaxPixels;
+    for (int i = 0; i < n_; ++i) {
+      pts_[2 * i] = RandomPos(kWidth);
+      pts_[2 * i + 1] = RandomPos(kHeight);
+    }
+    for (int i = 0; i < kBufSize; ++i) ref_[i] = this->rng_(max_value + 1);
+
+    aom_usec_timer ref_timer, tst_timer;
+    aom_usec_timer_start(&ref_timer);
+    for (int i = 0; i < kSpeedIterations; ++i)
+      Execute(this->params_.ref_func, pred_ref_);
+    aom_usec_timer_mark(&ref_timer);
+    const int ref_time = static_cast<int>(aom_usec_timer_elapsed(&ref_timer));
+
+    aom_usec_timer_start(&tst_timer);
+    for (int i = 0; i < kSpeedIterations; ++i)
+      Execute(this->params_.tst_func, pred_tst_);
+    aom_usec_timer_mark(&tst_timer);
+    const int tst_time = static_cast<int>(aom_usec_timer_elapsed(&tst_timer));
+
+    libaom_test::ClearSystemState();
+    printf("%d pixels bd %d: ref %5d ms, tst %5d ms (%4.2fx)\n", n_,
+           this->params_.bit_depth, ref_time / 1000, tst_time / 1000,
+           static_cast<double>(ref_time) / tst_time);
+    EXPECT_EQ(0, memcmp(pred_ref_, pred_tst_, sizeof(pred_ref_)));
+  }
+
+  T ref_[kBufSize];
+  T pred_ref_[kMaxPixels];
+  T pred_tst_[kMaxPixels];
+  int pts_[2 * kMaxPixels];
+  int n_;
+};
+
+//////////////////////////////////////////////////////////////////////////////
+// 8 bit version
+//////////////////////////////////////////////////////////////////////////////
+
+typedef void (*F8B)(const uint8_t *ref, int stride, const int *pts, int n,
+                    uint8_t *pred);
+typedef libaom_test::FuncParam<F8B> TestFuncs;
+
+class WarpFilterTest8B : public WarpFilterTest<F8B, uint8_t> {
+ protected:
+  void Execute(F8B func, uint8_t *pred) {
+    func(ref_ + kOffset, kStride, pts_, n_, pred);
+  }
+};
+
+TEST_P(WarpFilterTest8B, RandomValues) {
+  for (int iter = 0; iter < kIterations && !HasFatalFailure(); ++iter)
+    Common(255, false);
+}
+
+TEST_P(WarpFilterTest8B, ExtremeValues) {
+  for (int iter = 0; iter < kIterations && !HasFatalFailure(); ++iter)
+    Common(255, true);
+}
+
+TEST_P(WarpFilterTest8B, DISABLED_Speed) { Speed(255); }
+
+#if HAVE_SSE4_1
+INSTANTIATE_TEST_CASE_P(SSE4_1, WarpFilterTest8B,
+                        ::testing::Values(TestFuncs(
+                            av1_warp_filter_block_c,
+                            av1_warp_filter_block_sse4_1, 8)));
+#endif  // HAVE_SSE4_1
+
+#if HAVE_AVX2
+INSTANTIATE_TEST_CASE_P(AVX2, WarpFilterTest8B,
+                        ::testing::Values(TestFuncs(av1_warp_filter_block_c,
+                                                    av1_warp_filter_block_avx2,
+                                                    8)));
+#endif  // HAVE_AVX2
+
+#if CONFIG_AOM_HIGHBITDEPTH
+//////////////////////////////////////////////////////////////////////////////
+// High bit-depth version
+//////////////////////////////////////////////////////////////////////////////
+
+typedef void (*FHBD)(const uint16_t *ref, int stride, const int *pts, int n,
+                     uint16_t *pred, int bd);
+typedef libaom_test::FuncParam<FHBD> TestFuncsHBD;
+
+class WarpFilterTestHBD : public WarpFilterTest<FHBD, uint16_t> {
+ protected:
+  void Execute(FHBD func, uint16_t *pred) {
+    func(ref_ + kOffset, kStride, pts_, n_, pred, params_.bit_depth);
+  }
+};
+
+TEST_P(WarpFilterTestHBD, RandomValues) {
+  for (int iter = 0; iter < kIterations && !HasFatalFailure(); ++iter)
+    Common((1 << params_.bit_depth) - 1, false);
+}
+
+TEST_P(WarpFilterTestHBD, ExtremeValues) {
+  for (int iter = 0; iter < kIterations && !HasFatalFailure(); ++iter)
+    Common((1 << params_.bit_depth) - 1, true);
+}
+
+TEST_P(WarpFilterTestHBD, DISABLED_Speed) {
+  Speed((1 << params_.bit_depth) - 1);
+}
+
+#if HAVE_SSE4_1
+INSTANTIATE_TEST_CASE_P(
+    SSE4_1, WarpFilterTestHBD,
+    ::testing::Values(TestFuncsHBD(av1_highbd_warp_filter_block_c,
+                                   av1_highbd_warp_filter_block_sse4_1, 10),
+                      TestFuncsHBD(av1_highbd_warp_filter_block_c,
+                                   av1_highbd_warp_filter_block_sse4_1, 12)));
+#endif  // HAVE_SSE4_1
+
+#if HAVE_AVX2
+INSTANTIATE_TEST_CASE_P(
+    AVX2, WarpFilterTestHBD,
+    ::testing::Values(TestFuncsHBD(av1_highbd_warp_filter_block_c,
+                                   av1_highbd_warp_filter_block_avx2, 10),
+                      TestFuncsHBD(av1_highbd_warp_filter_block_c,
+                                   av1_highbd_warp_filter_block_avx2, 12)));
+#endif  // HAVE_AVX2
+#endif  // CONFIG_AOM_HIGHBITDEPTH
+}  // namespace
@@ -0,0 +1,246 @@
+/*
+ * Copyright (c) 2016, Alliance for Open Media. All rights reserved
+ *
+ * This source code is subject to the terms of the BSD 2 Clause License and
+ * the Alliance for Open Media Patent License 1.0. If the BSD 2 Clause License
+ * was not distributed with this source code in the LICENSE file, you can
+ * obtain it at www.aomedia.org/license/software. If the Alliance for Open
+ * Media Patent License 1.0 was not distributed with this source code in the
+ * PATENTS file, you can obtain it at www.aomedia.org/license/patent.
+ */
+
+#include <stdio.h>
+#include <string.h>
+
+#include <vector>
+
+#include "third_party/googletest/src/include/gtest/gtest.h"
+
+#include "./aom_config.h"
+#include "./av1_rtcd.h"
+#include "aom_ports/aom_timer.h"
+#include "aom_ports/mem.h"
+#include "av1/common/restoration.h"
+#include "test/acm_random.h"
+#include "test/clear_system_state.h"
+#include "test/function_equivalence_test.h"
+#include "test/register_state_check.h"
+#include "test/util.h"
+
+using libaom_test::FunctionEquivalenceTest;
+
+namespace {
+
+// The kernels read the RESTORATION_HALFWIN pixels around the block and
+// nothing further. The source is allocated with exactly that border, so that
+// a read past it runs off the allocation, where ASan reports it. The
+// destination keeps a wider border, which is checked to be left untouched.
+const int kBorder = 32;
+const int kMaxWidth = RESTORATION_TILESIZE_BIG;
+const int kMaxHeight = 64;
+const int kStride = kMaxWidth + 2 * kBorder;
+const int kBufSize = (kMaxHeight + 2 * kBorder) * kStride;
+const int kOffset = kBorder * kStride + kBorder;
+
+template <typename F, typename T>
+class WienerFilterTest : public FunctionEquivalenceTest<F> {
+ public:
+  static const int kIterations = 1000;
+
+  virtual ~WienerFilterTest() {}
+
+  virtual void Execute(F func, const T *src, int src_stride, T *dst) = 0;
+
+  // Builds a symmetric filter in the same way as av1_loop_restoration_init()
+  // from taps drawn over the full range allowed by the bitstream.
+  void RandomFilter(int *filter, bool extreme) {
+    const int minv[3] = { WIENER_FILT_TAP0_MINV, WIENER_FILT_TAP1_MINV,
+                          WIENER_FILT_TAP2_MINV };
+    const int maxv[3] = { WIENER_FILT_TAP0_MAXV, WIENER_FILT_TAP1_MAXV,
+                          WIENER_FILT_TAP2_MAXV };
+    filter[RESTORATION_HALFWIN] = RESTORATION_FILT_STEP;
+    for (int i = 0; i < RESTORATION_HALFWIN; ++i) {
+      if (extreme)
+        filter[i] = this->rng_(2) ? maxv[i] : minv[i];
+      else
+        filter[i] = minv[i] + this->rng_(maxv[i] - minv[i] + 1);
+      filter[RESTORATION_WIN - 1 - i] = filter[i];
+      filter[RESTORATION_HALFWIN] -= 2 * filter[i];
+    }
+  }
+
+  // Returns the pixel of the block at (0, 0) in a source of exactly
+  // (w_ + 2 * RESTORATION_HALFWIN) x (h_ + 2 * RESTORATION_HALFWIN) pixels.
+  const T *SourceBlock(std::vector<T> *src, int *src_stride) {
+    *src_stride = w_ + 2 * RESTORATION_HALFWIN;
+    src->resize((h_ + 2 * RESTORATION_HALFWIN) * *src_stride);
+    return &(*src)[RESTORATION_HALFWIN * *src_stride + RESTORATION_HALFWIN];
+  }
+
+  void Common(int max_value, bool extreme) {
+    w_ = this->rng_(2) ? this->rng_(kMaxWidth) + 1 : this->rng_(40) + 1;
+    h_ = this->rng_(kMaxHeight) + 1;
+    RandomFilter(filter_, extreme);
+
+    int src_stride;
+    std::vector<T> src;
+    const T *const block = SourceBlock(&src, &src_stride);
+    for (size_t i = 0; i < src.size(); ++i) {
+      if (extreme)
+        src[i] = this->rng_(2) ? max_value : 0;
+      else
+        src[i] = this->rng_(max_value + 1);
+    }
+    for (int i = 0; i < kBufSize; ++i) dst_ref_[i] = dst_tst_[i] = 0;
+
+    Execute(this->params_.ref_func, block, src_stride, dst_ref_ + kOffset);
+    ASM_REGISTER_STATE_CHECK(Execute(this->params_.tst_func, block, src_stride,
+                                     dst_tst_ + kOffset));
+
+    for (int i = 0; i < kBufSize; ++i) {
+      ASSERT_EQ(dst_ref_[i], dst_tst_[i]) << "w: " << w_ << " h: " << h_
+                                          << " at " << (i % kStride - kBorder)
+                                          << "," << (i / kStride - kBorder);
+    }
+  }
+
+  void Speed(int max_value) {
+    const int kSpeedIterations = 2000;
+    w_ = kMaxWidth;
+    h_ = kMaxHeight;
+    RandomFilter(filter_, false);
+    int src_stride;
+    std::vector<T> src;
+    const T *const block = SourceBlock(&src, &src_stride);
+    for (size_t i = 0; i < src.size(); ++i) src[i] = this->rng_(max_value + 1);
+
+    aom_usec_timer ref_timer, tst_timer;
+    aom_usec_timer_start(&ref_timer);
+    for (int i = 0; i < kSpeedIterations; ++i)
+      Execute(this->params_.ref_func, block, src_stride, dst_ref_ + kOffset);
+    aom_usec_timer_mark(&ref_timer);
+    const int ref_time = static_cast<int>(aom_usec_timer_elapsed(&ref_timer));
+
+    aom_usec_timer_start(&tst_timer);
+    for (int i = 0; i < kSpeedIterations; ++i)
+      Execute(this->params_.tst_func, block, src_stride, dst_tst_ + kOffset);
+    aom_usec_timer_mark(&tst_timer);
+    const int tst_time = static_cast<int>(aom_usec_timer_elapsed(&tst_timer));
+
+    libaom_test::ClearSystemState();
+    printf("%dx%d bd %d: ref %5d ms, tst %5d ms (%4.2fx)\n", w_, h_,
+           this->params_.bit_depth, ref_time / 1000, tst_time / 1000,
+           static_cast<double>(ref_time) / tst_time);
+    EXPECT_EQ(0, memcmp(dst_ref_, dst_tst_, sizeof(dst_ref_)));
+  }
+
+  T dst_ref_[kBufSize];
+  T dst_tst_[kBufSize];
+  int filter_[RESTORATION_WIN];
+  int w_;
+  int h_;
+};
+
+//////////////////////////////////////////////////////////////////////////////
+// 8 bit version
+//////////////////////////////////////////////////////////////////////////////
+
+typedef void (*F8B)(const uint8_t *src, int src_stride, uint8_t *dst,
+                    int dst_stride, int w, int h, const int *filter);
+typedef libaom_test::FuncParam<F8B> TestFuncs;
+
+class WienerFilterTest8B : public WienerFilterTest<F8B, uint8_t> {
+ protected:
+  void Execute(F8B func, const uint8_t *src, int src_stride, uint8_t *dst) {
+    func(src, src_stride, dst, kStride, w_, h_, filter_);
+  }
+};
+
+TEST_P(WienerFilterTest8B, RandomValues) {
+  for (int iter = 0; iter < kIterations && !HasFatalFailure(); ++iter)
+    Common(255, false);
+}
+
+TEST_P(WienerFilterTest8B, ExtremeValues) {
+  for (int iter = 0; iter < kIterations && !HasFatalFailure(); ++iter)
+    Common(255, true);
+}
+
+TEST_P(WienerFilterTest8B, DISABLED_Speed) { Speed(255); }
+
+#if HAVE_SSE4_1
+INSTANTIATE_TEST_CASE_P(
+    SSE4_1, WienerFilterTest8B,
+    ::testing::Values(TestFuncs(av1_wiener_filter_hor_c,
+                                av1_wiener_filter_hor_sse4_1, 8),
+                      TestFuncs(av1_wiener_filter_ver_c,
+                                av1_wiener_filter_ver_sse4_1, 8)));
+#endif  // HAVE_SSE4_1
+
+#if HAVE_AVX2
+INSTANTIATE_TEST_CASE_P(
+    AVX2, WienerFilterTest8B,
+    ::testing::Values(TestFuncs(av1_wiener_filter_hor_c,
+                                av1_wiener_filter_hor_avx2, 8),
+                      TestFuncs(av1_wiener_filter_ver_c,
+                                av1_wiener_filter_ver_avx2, 8)));
+#endif  // HAVE_AVX2
+
+#if CONFIG_AOM_HIGHBITDEPTH
+//////////////////////////////////////////////////////////////////////////////
+// High bit-depth version
+//////////////////////////////////////////////////////////////////////////////
+
+typedef void (*FHBD)(const uint16_t *src, int src_stride, uint16_t *dst,
+                     int dst_stride, int w, int h, const int *filter, int bd);
+typedef libaom_test::FuncParam<FHBD> TestFuncsHBD;
+
+class WienerFilterTestHBD : public WienerFilterTest<FHBD, uint16_t> {
+ protected:
+  void Execute(FHBD func, const uint16_t *src, int src_stride,
+               uint16_t *dst) {
+    func(src, src_stride, dst, kStride, w_, h_, filter_, params_.bit_depth);
+  }
+};
+
+TEST_P(WienerFilterTestHBD, RandomValues) {
+  for (int iter = 0; iter < kIterations && !HasFatalFailure(); ++iter)
+    Common((1 << params_.bit_depth) - 1, false);
+}
+
+TEST_P(WienerFilterTestHBD, ExtremeValues) {
+  for (int iter = 0; iter < kIterations && !HasFatalFailure(); ++iter)
+    Common((1 << params_.bit_depth) - 1, true);
+}
+
+TEST_P(WienerFilterTestHBD, DISABLED_Speed) {
+  Speed((1 << params_.bit_depth) - 1);
+}
+
+#if HAVE_SSE4_1
+INSTANTIATE_TEST_CASE_P(
+    SSE4_1, WienerFilterTestHBD,
+    ::testing::Values(TestFuncsHBD(av1_highbd_wiener_filter_hor_c,
+                                   av1_highbd_wiener_filter_hor_sse4_1, 10),
+                      TestFuncsHBD(av1_highbd_wiener_filter_hor_c,
+                                   av1_highbd_wiener_filter_hor_sse4_1, 12),
+                      TestFuncsHBD(av1_highbd_wiener_filter_ver_c,
+                                   av1_highbd_wiener_filter_ver_sse4_1, 10),
+                      TestFuncsHBD(av1_highbd_wiener_filter_ver_c,
+                                   av1_highbd_wiener_filter_ver_sse4_1, 12)));
+#endif  // HAVE_SSE4_1
+
+#if HAVE_AVX2
+INSTANTIATE_TEST_CASE_P(
+    AVX2, WienerFilterTestHBD,
+    ::testing::Values(TestFuncsHBD(av1_highbd_wiener_filter_hor_c,
+                                   av1_highbd_wiener_filter_hor_avx2, 10),
+                      TestFuncsHBD(av1_highbd_wiener_filter_hor_c,
+                                   av1_highbd_wiener_filter_hor_avx2, 12),
+                      TestFuncsHBD(av1_highbd_wiener_filter_ver_c,
+                                   av1_highbd_wiener_filter_ver_avx2, 10),
+                      TestFuncsHBD(av1_highbd_wiener_filter_ver_c,
+                                   av1_highbd_wiener_filter_ver_avx2, 12)));
+#endif  // HAVE_AVX2
+#endif  // CONFIG_AOM_HIGHBITDEPTH
+}  // namespace